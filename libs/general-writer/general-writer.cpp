@@ -43,7 +43,7 @@
 namespace ncbi
 {
 
-#if GW_CURRENT_VERSION <= 2
+#if GW_CURRENT_VERSION <= 3
     typedef :: gwp_1string_evt_v1 gwp_1string_evt;
     typedef :: gwp_2string_evt_v1 gwp_2string_evt;
     typedef :: gwp_column_evt_v1 gwp_column_evt;
@@ -714,6 +714,23 @@ namespace ncbi
         return rslt;
     }
 
+    typedef encode_result ( * encode_fn ) ( uint8_t * buffer, const void * data, uint32_t first, uint32_t elem_count );
+
+    static
+    encode_fn select_encoder ( uint32_t elem_bits )
+    {
+        switch ( elem_bits )
+        {
+        case 16:
+            return encode_buffer < uint16_t >;
+        case 32:
+            return encode_buffer < uint32_t >;
+        case 64:
+            return encode_buffer < uint64_t >;
+        }
+        throw "INTERNAL ERROR: corrupt element bits";
+    }
+
     void GeneralWriter :: write ( int stream_id, uint32_t elem_bits, const void *data, uint32_t elem_count )
     {
         switch ( state )
@@ -748,22 +765,7 @@ namespace ncbi
         {
             uint32_t elem;
             encode_result rslt;
-            encode_result ( * encode ) ( uint8_t * buffer, const void * data, uint32_t first, uint32_t elem_count );
-
-            switch ( elem_bits )
-            {
-            case 16:
-                encode = encode_buffer < uint16_t >;
-                break;
-            case 32:
-                encode = encode_buffer < uint32_t >;
-                break;
-            case 64:
-                encode = encode_buffer < uint64_t >;
-                break;
-            default:
-                throw "INTERNAL ERROR: corrupt element bits";
-            }
+            encode_fn encode = select_encoder ( elem_bits );
 
             for ( elem = 0; elem < elem_count; elem = rslt . num_elems )
             {
@@ -858,6 +860,104 @@ namespace ncbi
         write_event ( & hdr . dad, sizeof hdr );
     }
 
+    void GeneralWriter :: writeRows ( int stream_id, uint32_t elem_bits, const void *data,
+                                      const uint32_t *row_lengths, uint32_t row_count )
+    {
+        switch ( state )
+        {
+        case opened:
+            break;
+        default:
+            throw "state violation writing column rows";
+        }
+
+        if ( protocol_version < 3 )
+            throw "column rows require protocol version 3";
+
+        if ( stream_id < 0 )
+            throw "Stream_id is not valid";
+        if ( stream_id > ( int ) streams.size () )
+            throw "Stream_id is out of bounds";
+
+        if ( row_count == 0 )
+            return;
+
+        if ( row_lengths == 0 )
+            throw "Invalid row_lengths ptr";
+
+        const int_stream & s = streams [ stream_id - 1 ];
+
+        if ( elem_bits != s . elem_bits )
+            throw "Invalid elem_bits";
+
+        uint64_t elem_count = 0;
+        for ( uint32_t i = 0; i < row_count; ++ i )
+            elem_count += row_lengths [ i ];
+
+        if ( elem_count > 0xFFFFFFFF )
+            throw "row data exceeds maximum";
+        if ( data == 0 && elem_count != 0 )
+            throw "Invalid data ptr";
+
+        const void * payload = data;
+        uint64_t num_bytes = ( ( uint64_t ) elem_bits * elem_count + 7 ) / 8;
+
+        if ( ( s . flag_bits & 1 ) != 0 && elem_count != 0 )
+        {
+            // the rows are packed as a whole, the loader splits them up again by row_lengths
+            encode_fn encode = select_encoder ( elem_bits );
+            encode_result rslt;
+
+            rows_buffer . clear ();
+            for ( uint32_t elem = 0; elem < elem_count; elem = rslt . num_elems )
+            {
+                rslt = ( * encode ) ( packing_buffer, data, elem, ( uint32_t ) elem_count );
+                rows_buffer . insert ( rows_buffer . end (), packing_buffer, packing_buffer + rslt . num_bytes );
+            }
+
+            payload = rows_buffer . data ();
+            num_bytes = rows_buffer . size ();
+        }
+
+        if ( num_bytes > 0xFFFFFFFF )
+            throw "row data exceeds maximum";
+
+        gwp_rows_evt_v1 hdr;
+        init ( hdr, stream_id, evt_cell_rows );
+        set_row_count ( hdr, row_count );
+        set_size ( hdr, ( size_t ) num_bytes );
+        write_event ( & hdr . dad, sizeof hdr );
+
+        internal_write ( row_lengths, sizeof row_lengths [ 0 ] * row_count );
+        if ( num_bytes != 0 )
+            internal_write ( payload, ( size_t ) num_bytes );
+    }
+
+    void GeneralWriter :: nextRows ( int table_id, uint32_t nrows )
+    {
+        switch ( state )
+        {
+        case opened:
+            break;
+        default:
+            throw "state violation advancing to next rows";
+        }
+
+        if ( protocol_version < 3 )
+            throw "next rows require protocol version 3";
+
+        if ( table_id < 0 || ( size_t ) table_id > tables.size () )
+            throw "Invalid table id";
+
+        if ( nrows == 0 )
+            return;
+
+        gwp_move_ahead_evt_v1 hdr;
+        init ( hdr, table_id, evt_next_rows );
+        set_nrows ( hdr, nrows );
+        write_event ( & hdr . dad, sizeof hdr );
+    }
+
     void GeneralWriter :: logError ( const std :: string & msg )
     {
         switch ( state )
@@ -1006,7 +1106,7 @@ namespace ncbi
 
 
     // Constructors
-    GeneralWriter :: GeneralWriter ( const std :: string &out_path )
+    GeneralWriter :: GeneralWriter ( const std :: string &out_path, uint32_t _protocol_version )
         : out ( out_path.c_str(), std::ofstream::binary )
         , evt_count ( 0 )
         , byte_count ( 0 )
@@ -1016,15 +1116,19 @@ namespace ncbi
         , output_bsize ( 0 )
         , output_marker ( 0 )
         , out_fd ( -1 )
+        , protocol_version ( _protocol_version )
         , state ( uninitialized )
     {
+        if ( protocol_version < GW_DEFAULT_VERSION || protocol_version > GW_CURRENT_VERSION )
+            throw "unsupported protocol version";
+
         packing_buffer = new uint8_t [ bsize ];
         writeHeader ();
     }
 
 
     // Constructors
-    GeneralWriter :: GeneralWriter ( int _out_fd, size_t buffer_size )
+    GeneralWriter :: GeneralWriter ( int _out_fd, size_t buffer_size, uint32_t _protocol_version )
         : evt_count ( 0 )
         , byte_count ( 0 )
         , pid ( getpid () )
@@ -1033,8 +1137,12 @@ namespace ncbi
         , output_bsize ( buffer_size )
         , output_marker ( 0 )
         , out_fd ( _out_fd )
+        , protocol_version ( _protocol_version )
         , state ( uninitialized )
     {
+        if ( protocol_version < GW_DEFAULT_VERSION || protocol_version > GW_CURRENT_VERSION )
+            throw "unsupported protocol version";
+
         packing_buffer = new uint8_t [ bsize ];
         output_buffer = new uint8_t [ buffer_size ];
         writeHeader ();
@@ -1096,6 +1204,7 @@ namespace ncbi
     {
         :: gw_header_v1 hdr;
         init ( hdr );
+        set_version ( hdr . dad, protocol_version );
         internal_write ( & hdr, sizeof hdr );
         state = header_written;
 
@@ -540,6 +540,134 @@ namespace gw_dump
         }
     }
 
+    /* check_cell_rows
+     *  all:
+     *    0 < id <= count ( columns )
+     *    row_count != 0
+     */
+    template < class T > static
+    void check_cell_rows ( const T & eh )
+    {
+        if ( id ( eh . dad ) == 0 )
+            throw "bad column id within cell-rows event (null)";
+        if ( id ( eh . dad ) > col_entries . size () )
+            throw "bad column id within cell-rows event";
+        if ( row_count ( eh ) == 0 )
+            throw "empty cell-rows event";
+    }
+
+    /* cell_rows_data_size
+     *  bytes of cell data following the row lengths, including alignment
+     */
+    static
+    size_t cell_rows_data_size ( const gw_rows_evt_v1 & eh, uint32_t elem_bits )
+    {
+        size_t const bytes = ( ( size_t ) elem_bits * elem_count ( eh ) + 7 ) / 8;
+        return ( bytes + 3 ) & ~ ( size_t ) 3;
+    }
+
+    static
+    size_t cell_rows_data_size ( const gwp_rows_evt_v1 & eh, uint32_t /* elem_bits */ )
+    {
+        return size ( eh );
+    }
+
+    /* dump_cell_rows
+     */
+    template < class D, class T > static
+    void dump_cell_rows ( FILE * in, const D & e )
+    {
+        T eh;
+        init ( eh, e );
+
+        size_t num_read = readFILE ( & eh . row_count, sizeof eh - sizeof ( D ), 1, in );
+        if ( num_read != 1 )
+            throw "failed to read cell-rows event";
+
+        check_cell_rows ( eh );
+
+        auto const columnId = id(eh.dad);
+        col_entry const &entry = col_entries[columnId - 1];
+        auto const rows = row_count(eh);
+
+        auto row_lengths = std::vector<uint32_t>(rows);
+        if (rows != readFILE(row_lengths.data(), sizeof(uint32_t), rows, in))
+            throw "failed to read cell-rows lengths";
+
+        auto const data_size = cell_rows_data_size(eh, entry.elem_bits);
+        auto data_buffer = std::vector<uint8_t>(data_size);
+        if (data_size != readFILE(data_buffer.data(), 1, data_size, in))
+            throw "failed to read cell-rows data";
+
+        uint64_t elements = 0;
+        for (auto const len : row_lengths)
+            elements += len;
+
+        switch (display) {
+        case 1:
+            std :: cout
+                << event_num << ": cell-rows\n"
+                   "  stream_id = " << columnId << " ( " << tbl_entries[entry.table_id - 1].tbl_name << " . " << entry . spec << " )\n"
+                   "  elem_bits = " << entry . elem_bits << "\n"
+                   "  row_count = " << rows << "\n"
+                   "  elem_count = " << elements << "\n"
+                   "  data_size = " << data_size << '\n'
+                ;
+            break;
+        case 2:
+            std::cout
+                << "{ \"event\": \"rows\""
+                   ", \"column-id\": " << columnId
+                << ", \"row-lengths\": [";
+            for (uint32_t i = 0; i < rows; ++i)
+                std::cout << (i == 0 ? " " : ", ") << row_lengths[i];
+            std::cout
+                << " ], \"size\": " << data_size
+                << " }\n";
+            break;
+        }
+    }
+
+    /* dump_next_rows
+     */
+    template < class D, class T > static
+    void dump_next_rows ( FILE * in, const D & e )
+    {
+        T eh;
+        init ( eh, e );
+
+        size_t num_read = readFILE ( eh . nrows, sizeof eh - sizeof ( D ), 1, in );
+        if ( num_read != 1 )
+            throw "failed to read next-rows event";
+
+        check_next_row ( eh . dad );
+
+        // advance row-id
+        auto const tableId = id(eh.dad);
+        auto const nrows = get_nrows(eh);
+        tbl_entry & te = tbl_entries [ tableId - 1 ];
+
+        te . row_id += nrows;
+
+        switch (display) {
+        case 1:
+            std :: cout
+                << event_num << ": next-rows\n"
+                << "  table_id = " << tableId << " ( \"" << te . tbl_name << "\" )\n"
+                << "  nrows = " << nrows << '\n'
+                << "  row_id = " << te . row_id << '\n'
+                ;
+            break;
+        case 2:
+            std::cout
+                << "{ \"event\": \"next-rows\""
+                   ", \"table-id\": " << tableId
+                << ", \"rows\": " << nrows
+                << " }\n";
+            break;
+        }
+    }
+
     /* check_empty_default
      */
     template < class T > static
@@ -1880,6 +2008,14 @@ namespace gw_dump
             dump_progmsg < gw_evt_hdr_v1, gw_status_evt_v1 > ( in, e );
             break;
 
+            // add in new message handlers for version 3
+        case evt_cell_rows:
+            dump_cell_rows < gw_evt_hdr_v1, gw_rows_evt_v1 > ( in, e );
+            break;
+        case evt_next_rows:
+            dump_next_rows < gw_evt_hdr_v1, gw_move_ahead_evt_v1 > ( in, e );
+            break;
+
         default:
             throw "unrecognized event id";
         }
@@ -2002,6 +2138,14 @@ namespace gw_dump
             dump_progmsg < gwp_evt_hdr_v1, gwp_status_evt_v1 > ( in, e );
             break;
 
+            // add in new message handlers for version 3
+        case evt_cell_rows:
+            dump_cell_rows < gwp_evt_hdr_v1, gwp_rows_evt_v1 > ( in, e );
+            break;
+        case evt_next_rows:
+            dump_next_rows < gwp_evt_hdr_v1, gwp_move_ahead_evt_v1 > ( in, e );
+            break;
+
         default:
             throw "unrecognized packed event id";
         }
@@ -80,13 +80,22 @@ enum gw_evt_id
     evt_logmsg,
     evt_progmsg,
 
+    /* BEGIN VERSION 3 MESSAGES */
+    evt_cell_rows,                        /* cells of one column, N rows */
+    evt_next_rows,                        /* commit N rows of cell_rows  */
+
     evt_max_id                            /* must be last                */
 };
 
 #define GW_SIGNATURE "NCBIgnld"
 #define GW_GOOD_ENDIAN 1
 #define GW_REVERSE_ENDIAN ( 1 << 24 )
-#define GW_CURRENT_VERSION 2
+#define GW_CURRENT_VERSION 3
+
+/* the version stamped on a stream unless the writer asks for version 3,
+   which it has to do to send evt_cell_rows or evt_next_rows;
+   general-loaders older than version 3 reject any stream above 2 */
+#define GW_DEFAULT_VERSION 2
 
 //These are not to change
 #define STRING_LIMIT_8 0x100
@@ -138,7 +147,8 @@ enum gw_evt_id
 
     The value presented for version must be >= 1 and <= GW_CURRENT_VERSION.
     A value of 0 must be rejected as not conforming to protocol while a
-    value > GW_CURRENT_VERSION cannot be processed.
+    value > GW_CURRENT_VERSION cannot be processed. Writers present
+    GW_DEFAULT_VERSION unless the stream carries version 3 events.
 
     The v1 value for "packing" currently allows for two values: 0 and 1,
     where 0 means that no packing will be used and 1 indicates packed
@@ -271,6 +281,9 @@ struct gw_data_evt_v1
 };
 
 /* gw_move_ahead_evt_v1
+ *
+ *  used for events:
+ *    { evt_move_ahead, evt_next_rows }
  */
 struct gw_move_ahead_evt_v1
 {
@@ -278,6 +291,26 @@ struct gw_move_ahead_evt_v1
     uint32_t nrows [ 2 ]; /* the number of rows to move ahead                 */
 };
 
+/* gw_rows_evt
+ *  event used to transfer the cells of one column for several
+ *  consecutive rows. the rows are committed by an evt_next_rows
+ *  on the column's table, after each of the table's columns
+ *  that has data in these rows sent its evt_cell_rows.
+ *
+ *  used for events:
+ *    { evt_cell_rows }
+ */
+struct gw_rows_evt_v1
+{
+    gw_evt_hdr_v1 dad;    /* common header : id = column id                   */
+    uint32_t row_count;   /* the number of rows in the event                  */
+    uint32_t elem_count;  /* the number of elements in all rows               */
+ /* uint32_t row_len [ row_count ]; * the number of elements in each row      *
+    uint8_t data [ x ];    * the cells back to back. actual size is:          *
+                           * ( ( elem_count * col . elem_bits ) + 7 ) / 8     *
+    char align [ 0..3 ];   * ( ( 4 - sizeof data % 4 ) % 4 ) zeros            */
+};
+
 struct gw_add_mbr_evt_v1
 {
     gw_evt_hdr_v1 dad;
@@ -374,6 +407,9 @@ struct gwp_data_evt_v1
 };
 
 /* gwp_move_ahead_evt_v1
+ *
+ *  used for events:
+ *    { evt_move_ahead, evt_next_rows }
  */
 struct gwp_move_ahead_evt_v1
 {
@@ -381,6 +417,23 @@ struct gwp_move_ahead_evt_v1
     uint16_t nrows [ 4 ]; /* the number of rows to move ahead                 */
 };
 
+/* gwp_rows_evt
+ *  event used to transfer the cells of one column for several
+ *  consecutive rows, see gw_rows_evt_v1
+ *
+ *  used for events:
+ *    { evt_cell_rows }
+ */
+struct gwp_rows_evt_v1
+{
+    gwp_evt_hdr_v1 dad;   /* common header : id = column id                   */
+    uint16_t row_count [ 2 ]; /* the number of rows in the event              */
+    uint16_t sz [ 2 ];    /* the size of data in bytes                        */
+ /* uint32_t row_len [ row_count ]; * the number of elements in each row      *
+    uint8_t data [ sz ];   * the cells back to back, integer-packed as a      *
+                           * whole when the column uses integer packing       */
+};
+
 
 /* SPECIAL VERSIONS WITH 16-BIT SIZE FIELDS */
 
@@ -463,10 +516,16 @@ namespace ncbi
     {
         memmove ( hdr . signature, GW_SIGNATURE, sizeof hdr . signature );
         hdr . endian = GW_GOOD_ENDIAN;
-        hdr . version = GW_CURRENT_VERSION;
+        hdr . version = GW_DEFAULT_VERSION;
         hdr . hdr_size = sizeof ( :: gw_header );
     }
 
+    inline void set_version ( :: gw_header & hdr, uint32_t version )
+    {
+        assert ( version > 0 && version <= GW_CURRENT_VERSION );
+        hdr . version = version;
+    }
+
     inline void init ( :: gw_header & hdr, size_t hdr_size )
     {
         init ( hdr );
@@ -628,6 +687,28 @@ namespace ncbi
         memmove ( & self . nrows, & nrows, sizeof self . nrows );
     }
 
+    // gw_rows_evt
+    inline void init ( :: gw_rows_evt_v1 & hdr, uint32_t id, gw_evt_id evt )
+    { init ( hdr . dad, id, evt ); hdr . row_count = hdr . elem_count = 0; }
+
+    inline void init ( :: gw_rows_evt_v1 & hdr, const :: gw_evt_hdr_v1 & dad )
+    { hdr . dad = dad; hdr . row_count = hdr . elem_count = 0; }
+
+    inline uint32_t row_count ( const :: gw_rows_evt_v1 & self )
+    { return self . row_count; }
+
+    inline void set_row_count ( :: gw_rows_evt_v1 & self, uint32_t row_count )
+    {
+        assert ( row_count != 0 );
+        self . row_count = row_count;
+    }
+
+    inline uint32_t elem_count ( const :: gw_rows_evt_v1 & self )
+    { return self . elem_count; }
+
+    inline void set_elem_count ( :: gw_rows_evt_v1 & self, uint32_t elem_count )
+    { self . elem_count = elem_count; }
+
     // gw_add_mbr_evt
     inline void init ( :: gw_add_mbr_evt_v1 & hdr, uint32_t id, gw_evt_id evt )
     {
@@ -893,6 +974,48 @@ namespace ncbi
         memmove ( & self . nrows, & nrows, sizeof self . nrows );
     }
 
+    // gwp_rows_evt
+    inline void init ( :: gwp_rows_evt_v1 & hdr, uint32_t id, gw_evt_id evt )
+    {
+        init ( hdr . dad, id, evt );
+        memset ( & hdr . row_count, 0, sizeof hdr . row_count );
+        memset ( & hdr . sz, 0, sizeof hdr . sz );
+    }
+
+    inline void init ( :: gwp_rows_evt_v1 & hdr, const :: gwp_evt_hdr_v1 & dad )
+    {
+        hdr . dad = dad;
+        memset ( & hdr . row_count, 0, sizeof hdr . row_count );
+        memset ( & hdr . sz, 0, sizeof hdr . sz );
+    }
+
+    inline uint32_t row_count ( const :: gwp_rows_evt_v1 & self )
+    {
+        uint32_t row_count;
+        memmove ( & row_count, & self . row_count, sizeof row_count );
+        return row_count;
+    }
+
+    inline void set_row_count ( :: gwp_rows_evt_v1 & self, uint32_t row_count )
+    {
+        assert ( row_count != 0 );
+        memmove ( & self . row_count, & row_count, sizeof self . row_count );
+    }
+
+    inline uint32_t size ( const :: gwp_rows_evt_v1 & self )
+    {
+        uint32_t sz;
+        memmove ( & sz, & self . sz, sizeof sz );
+        return sz;
+    }
+
+    inline void set_size ( :: gwp_rows_evt_v1 & self, size_t bytes )
+    {
+        assert ( sizeof bytes == 4 || ( bytes >> 32 ) == 0 );
+        uint32_t sz = ( uint32_t ) bytes;
+        memmove ( & self . sz, & sz, sizeof self . sz );
+    }
+
 
     // recording string size
     inline void set_string_size ( uint16_t & sz, size_t bytes )
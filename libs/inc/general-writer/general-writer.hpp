@@ -42,7 +42,7 @@
 
 namespace ncbi
 {
-#if GW_CURRENT_VERSION <= 2
+#if GW_CURRENT_VERSION <= 3
     typedef :: gwp_evt_hdr_v1 gwp_evt_hdr;
 #else
 #error "unrecognized GW version"
@@ -113,6 +113,17 @@ namespace ncbi
         // commit and close current row, move ahead by nrows
         void moveAhead ( int table_id, uint64_t nrows );
 
+        // generate the cells of one column for row_count consecutive rows in a single event
+        // row_lengths gives the number of elements in each row, data holds the rows back to back
+        // every column of the table written this way must send the same number of rows
+        // before they are committed by nextRows
+        // needs a writer constructed for protocol version 3
+        void writeRows ( int stream_id, uint32_t elem_bits, const void *data,
+                         const uint32_t *row_lengths, uint32_t row_count );
+
+        // commit the nrows rows sent by writeRows, move to the row after them
+        void nextRows ( int table_id, uint32_t nrows );
+
         // indicate some sort of exception
         void logError ( const std :: string & msg );
 
@@ -129,8 +140,12 @@ namespace ncbi
 
         // out_fd writes to an open file descriptor ( generally stdout )
         // out_path initializes output stream for writing to a file
-        GeneralWriter ( int out_fd, size_t buffer_size = 32 * 1024 );
-        GeneralWriter ( const std :: string & out_path );
+        // protocol_version is stamped on the stream header; pass GW_CURRENT_VERSION
+        // to use writeRows and nextRows, which older general-loaders cannot read
+        GeneralWriter ( int out_fd, size_t buffer_size = 32 * 1024,
+                        uint32_t protocol_version = GW_DEFAULT_VERSION );
+        GeneralWriter ( const std :: string & out_path,
+                        uint32_t protocol_version = GW_DEFAULT_VERSION );
 
         // output stream is flushed and closed
         ~ GeneralWriter ();
@@ -179,6 +194,7 @@ namespace ncbi
         int pid;
 
         uint8_t * packing_buffer;
+        std :: vector < uint8_t > rows_buffer;
 
         uint8_t * output_buffer;
         size_t output_bsize;
@@ -186,6 +202,8 @@ namespace ncbi
 
         int out_fd;
 
+        uint32_t protocol_version;
+
         enum stream_state
         {
             uninitialized,
@@ -0,0 +1,280 @@
+/* =============================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ */
+
+#ifndef __KPROC_HPP_INCLUDED__
+#define __KPROC_HPP_INCLUDED__ 1
+
+/*
+ * Reference counted C++ wrappers of KThread, KLock and KCondition,
+ * shared by the tools whose helpers wrap the rest of the VDB API
+ * ( ref-variation, align-cache )
+ */
+
+#include <assert.h>
+#include <stddef.h>
+
+#include <exception>
+
+#include <klib/rc.h>
+#include <kproc/thread.h>
+#include <kproc/lock.h>
+#include <kproc/cond.h>
+
+namespace KProc
+{
+    // what() is the name of the failed call, getRC() is its rc
+    class CKProcError : public std::exception
+    {
+    public:
+        CKProcError ( rc_t rc, char const* func ) : m_func ( func ), m_rc ( rc ) {}
+
+        rc_t getRC () const { return m_rc; }
+        virtual char const* what () const throw() { return m_func; }
+
+    private:
+        char const* m_func;
+        rc_t m_rc;
+    };
+
+    class CKThread
+    {
+    public:
+
+        typedef rc_t (*THREAD_FUNC) ( void* data );
+
+        CKThread () : m_pSelf ( NULL ), m_ThreadFunc ( NULL ), m_pData ( NULL ) {}
+        ~CKThread () { Release (); }
+        CKThread ( CKThread const& x ) { Clone ( x ); }
+        CKThread& operator= ( CKThread const& x )
+        {
+            if ( m_pSelf )
+                Release ();
+
+            Clone ( x );
+            return *this;
+        }
+
+        // "this" is handed to the thread, the object must not move until Wait()
+        void Make ( THREAD_FUNC thread_func, void* data )
+        {
+            assert ( m_pSelf == NULL );
+            assert ( m_ThreadFunc == NULL );
+            assert ( m_pData == NULL );
+
+            m_ThreadFunc = thread_func;
+            m_pData = data;
+
+            rc_t rc = ::KThreadMakeStackSize ( & m_pSelf, Run, this, 0 );
+            if ( rc )
+                throw CKProcError ( rc, "KThreadMake" );
+        }
+
+        void Release ()
+        {
+            if ( m_pSelf )
+            {
+                ::KThreadRelease ( m_pSelf );
+                m_pSelf = NULL;
+                m_ThreadFunc = NULL;
+                m_pData = NULL;
+            }
+        }
+
+        // returns the rc of the thread function
+        rc_t Wait ()
+        {
+            rc_t status;
+            rc_t rc = ::KThreadWait ( m_pSelf, & status );
+            if ( rc )
+                throw CKProcError ( rc, "KThreadWait" );
+
+            return status;
+        }
+
+    private:
+        static rc_t CC Run ( ::KThread const*, void* data )
+        {
+            CKThread* obj = static_cast < CKThread* > ( data );
+
+            return ( * obj -> m_ThreadFunc ) ( obj -> m_pData );
+        }
+
+        void Clone ( CKThread const& x )
+        {
+            m_pSelf = x.m_pSelf;
+            m_ThreadFunc = x.m_ThreadFunc;
+            m_pData = x.m_pData;
+
+            if ( m_pSelf != NULL )
+                ::KThreadAddRef ( m_pSelf );
+        }
+
+        ::KThread* m_pSelf;
+
+        THREAD_FUNC m_ThreadFunc;
+        void* m_pData;
+    };
+
+    class CKCondition;
+
+    class CKLock
+    {
+    public:
+        friend class CKCondition;
+
+        CKLock ()
+        {
+            rc_t rc = ::KLockMake ( & m_pSelf );
+            if ( rc )
+                throw CKProcError ( rc, "KLockMake" );
+        }
+        ~CKLock () { Release (); }
+        CKLock ( CKLock const& x ) { Clone ( x ); }
+        CKLock& operator= ( CKLock const& x )
+        {
+            if ( m_pSelf )
+                Release ();
+
+            Clone ( x );
+            return *this;
+        }
+
+        void Release ()
+        {
+            if ( m_pSelf )
+            {
+                ::KLockRelease ( m_pSelf );
+                m_pSelf = NULL;
+            }
+        }
+
+        void Acquire ()
+        {
+            rc_t rc = ::KLockAcquire ( m_pSelf );
+            if ( rc )
+                throw CKProcError ( rc, "KLockAcquire" );
+        }
+        void Lock () { Acquire (); }
+        void Unlock ()
+        {
+            rc_t rc = ::KLockUnlock ( m_pSelf );
+            if ( rc )
+                throw CKProcError ( rc, "KLockUnlock" );
+        }
+
+        // for compatibility with standard library
+        void lock () { Lock (); }
+        void unlock () { Unlock (); }
+
+    private:
+        void Clone ( CKLock const& x )
+        {
+            m_pSelf = x.m_pSelf;
+            ::KLockAddRef ( m_pSelf );
+        }
+
+        ::KLock* m_pSelf;
+    };
+
+    class CKCondition
+    {
+    public:
+        CKCondition ()
+        {
+            rc_t rc = ::KConditionMake ( & m_pSelf );
+            if ( rc )
+                throw CKProcError ( rc, "KConditionMake" );
+        }
+        ~CKCondition () { Release (); }
+        CKCondition ( CKCondition const& x ) { Clone ( x ); }
+        CKCondition& operator= ( CKCondition const& x )
+        {
+            if ( m_pSelf )
+                Release ();
+
+            Clone ( x );
+            return *this;
+        }
+
+        void Release ()
+        {
+            if ( m_pSelf )
+            {
+                ::KConditionRelease ( m_pSelf );
+                m_pSelf = NULL;
+            }
+        }
+
+        // the lock must be held by the caller
+        void Wait ( CKLock& lock )
+        {
+            rc_t rc = ::KConditionWait ( m_pSelf, lock.m_pSelf );
+            if ( rc )
+                throw CKProcError ( rc, "KConditionWait" );
+        }
+        void Signal ()
+        {
+            rc_t rc = ::KConditionSignal ( m_pSelf );
+            if ( rc )
+                throw CKProcError ( rc, "KConditionSignal" );
+        }
+        void Broadcast ()
+        {
+            rc_t rc = ::KConditionBroadcast ( m_pSelf );
+            if ( rc )
+                throw CKProcError ( rc, "KConditionBroadcast" );
+        }
+
+    private:
+        void Clone ( CKCondition const& x )
+        {
+            m_pSelf = x.m_pSelf;
+            ::KConditionAddRef ( m_pSelf );
+        }
+
+        ::KCondition* m_pSelf;
+    };
+
+    template <class TLockable> class CLockGuard
+    {
+    public:
+        CLockGuard ( TLockable & lock ) : m_lock (lock)
+        {
+            m_lock.lock();
+        }
+        ~CLockGuard ( )
+        {
+            m_lock.unlock();
+        }
+
+    private:
+        CLockGuard( CLockGuard<TLockable> const& x );
+        CLockGuard<TLockable>& operator=( CLockGuard<TLockable> const& x );
+
+        TLockable & m_lock;
+    };
+}
+
+#endif //__KPROC_HPP_INCLUDED__
@@ -26,12 +26,14 @@
 #ifndef __VDB_HPP_INCLUDED__
 #define __VDB_HPP_INCLUDED__ 1
 
+#include <exception>
 #include <iostream>
 #include <fstream>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <klib/printf.h>
@@ -40,6 +42,7 @@
 #include <klib/vector.h> /* VectorForEach */
 
 #include <kdb/manager.h>
+#include <vdb/blob.h>
 #include <vdb/cursor.h>
 #include <vdb/database.h>
 #include <vdb/manager.h>
@@ -273,18 +276,64 @@ namespace VDB {
         }
     };
 
+    /* non-owning view of the elements of a cell
+       valid as long as the cell it came from: until the next read on the same cursor,
+       or until the callback of foreachBlob()/parallel_foreach() returns */
+    template <typename T> class Span {
+        T const *first;
+        size_t count;
+    public:
+        Span() : first(nullptr), count(0) {}
+        Span(T const *data, size_t size) : first(data), count(size) {}
+
+        T const *data() const { return first; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        T const *begin() const { return first; }
+        T const *end() const { return first + count; }
+        T const &operator [](size_t i) const { return first[i]; }
+    };
+
     class Cursor {
         friend class Table;
         VCursor *const o;
     protected:
         unsigned const N;
         std::vector<unsigned int> cid;
+        std::vector<std::string> names; /* empty if the cursor can not be cloned */
 
-        Cursor(VCursor *const o_, std::vector<unsigned int> columns)
-        : o(o_), N((unsigned)columns.size()), cid(columns)
+        Cursor(VCursor *const o_, std::vector<unsigned int> columns, std::vector<std::string> names_ = std::vector<std::string>())
+        : o(o_), N((unsigned)columns.size()), cid(columns), names(names_)
         {
         }
 
+        static Cursor open(VTable const *tbl, std::vector<std::string> const &fields)
+        {
+            VCursor const *curs = 0;
+            auto rc = VTableCreateCursorRead(tbl, &curs);
+            if (rc) throw Error(rc, __FILE__, __LINE__);
+
+            std::vector<unsigned int> columns;
+            for (auto && field : fields) {
+                uint32_t cid = 0;
+
+                rc = VCursorAddColumn(curs, &cid, "%s", field.c_str());
+                if (rc)
+                {
+                    VCursorRelease( curs );
+                    throw Error(rc, __FILE__, __LINE__);
+                }
+                columns.push_back( cid );
+            }
+            rc = VCursorOpen(curs);
+            if (rc)
+            {
+                VCursorRelease( curs );
+                throw Error(rc, __FILE__, __LINE__);
+            }
+            return Cursor(const_cast<VCursor *>(curs), columns, fields);
+        }
+
     public:
         using RowID = int64_t;
 
@@ -308,6 +357,12 @@ namespace VDB {
                 else
                     throw std::logic_error("bad cast");
             }
+            template <typename T> Span<T> span() const {
+                if (elem_bits == sizeof(T) * 8)
+                    return Span<T>((T const *)data, elements);
+                else
+                    throw std::logic_error("bad cast");
+            }
             template <typename T> T value() const {
                 if (elem_bits == sizeof(T) * 8 && elements == 1)
                     return *(T *)data;
@@ -315,7 +370,7 @@ namespace VDB {
                     throw std::logic_error("bad cast");
             }
         };
-        Cursor(Cursor const &other) :o(other.o), N(other.N), cid(other.cid) { VCursorAddRef(o); }
+        Cursor(Cursor const &other) :o(other.o), N(other.N), cid(other.cid), names(other.names) { VCursorAddRef(o); }
         ~Cursor() { VCursorRelease(o); }
         unsigned columns() const { return N; }
 
@@ -395,6 +450,138 @@ namespace VDB {
             }
             return rows;
         }
+
+        /* a new cursor on the same table and columns, e.g. for another thread */
+        Cursor clone() const
+        {
+            if (names.size() != N)
+                throw Error("cursor was not made by Table::read(), can not clone", __FILE__, __LINE__);
+
+            VTable const *tbl = 0;
+            rc_t rc = VCursorOpenParentRead(o, &tbl);
+            if (rc) throw Error(rc, __FILE__, __LINE__);
+            try {
+                Cursor curs = open(tbl, names);
+                VTableRelease(tbl);
+                return curs;
+            }
+            catch (...) {
+                VTableRelease(tbl);
+                throw;
+            }
+        }
+
+        /* rows [first, last) a blob at a time: each column's blob is looked up once
+           and the cells are taken out of it instead of going through the cursor per row.
+           the values handed to f point into the blobs and are valid until f returns.
+           unlike foreach() a failed read throws */
+        template <typename F>
+        uint64_t foreachBlob(RowID const first, RowID const last, F f) const {
+            struct Blobs {
+                std::vector<VBlob const *> blob;
+                std::vector<RowID> end;
+
+                Blobs(unsigned n) : blob(n, nullptr), end(n, 0) {}
+                ~Blobs() { for (auto && b : blob) VBlobRelease(b); }
+            } blobs(N);
+            auto data = std::vector<RawData>(N);
+            uint64_t rows = 0;
+
+            for (auto i = first; i < last; ++i) {
+                for (unsigned j = 0; j < N; ++j) {
+                    if (blobs.blob[j] == nullptr || i >= blobs.end[j]) {
+                        VBlobRelease(blobs.blob[j]);
+                        blobs.blob[j] = nullptr;
+
+                        int64_t blobFirst = 0;
+                        uint64_t blobCount = 0;
+                        rc_t rc = VCursorGetBlobDirect(o, &blobs.blob[j], i, cid[j]);
+                        if (rc == 0)
+                            rc = VBlobIdRange(blobs.blob[j], &blobFirst, &blobCount);
+                        if (rc) throw Error(rc, __FILE__, __LINE__);
+                        blobs.end[j] = blobFirst + (RowID)blobCount;
+                    }
+
+                    void const *base = 0;
+                    uint32_t count = 0;
+                    uint32_t boff = 0;
+                    uint32_t elem_bits = 0;
+                    rc_t rc = VBlobCellData(blobs.blob[j], i, &elem_bits, &base, &boff, &count);
+                    if (rc) throw Error(rc, __FILE__, __LINE__);
+
+                    data[j].data = base;
+                    data[j].elem_bits = elem_bits;
+                    data[j].elements = count;
+                }
+                f(i, data);
+                ++rows;
+            }
+            return rows;
+        }
+        template <typename F>
+        uint64_t foreachBlob(F f) const {
+            auto const range = rowRange();
+            return foreachBlob(range.first, range.second, f);
+        }
+
+        /* splits the row range into 'threads' consecutive parts (0 = one per core)
+           and reads each part on its own thread with its own cursor, a blob at a time.
+           f(ACC &, RowID, std::vector<RawData> const &) accumulates into the part's ACC,
+           reduce(ACC &total, ACC const &part) merges the parts in row order.
+           the first exception thrown on any of the threads is rethrown here */
+        template <typename ACC, typename F, typename R>
+        ACC parallel_foreach(unsigned threads, F f, R reduce) const {
+            auto const range = rowRange();
+            uint64_t const count = range.second - range.first;
+
+            if (threads == 0)
+                threads = std::thread::hardware_concurrency();
+            if (threads == 0)
+                threads = 1;
+            if (count < threads)
+                threads = count == 0 ? 1 : (unsigned)count;
+
+            std::vector<ACC> parts(threads);
+            std::vector<std::exception_ptr> errors(threads);
+            auto run = [&](unsigned part, Cursor const *curs) {
+                try {
+                    auto const first = range.first + (RowID)(count * part / threads);
+                    auto const last = range.first + (RowID)(count * (part + 1) / threads);
+                    ACC &acc = parts[part];
+                    curs->foreachBlob(first, last, [&](RowID row, std::vector<RawData> const &values) {
+                        f(acc, row, values);
+                    });
+                }
+                catch (...) {
+                    errors[part] = std::current_exception();
+                }
+            };
+
+            if (threads == 1) {
+                run(0, this);
+            }
+            else {
+                std::vector<Cursor> cursors;
+                cursors.reserve(threads - 1);
+                for (unsigned i = 1; i < threads; ++i)
+                    cursors.push_back(clone());
+
+                std::vector<std::thread> workers;
+                for (unsigned i = 1; i < threads; ++i)
+                    workers.emplace_back(run, i, &cursors[i - 1]);
+                run(0, this);
+                for (auto && w : workers)
+                    w.join();
+            }
+            for (auto && e : errors) {
+                if (e) std::rethrow_exception(e);
+            }
+
+            ACC total = std::move(parts[0]);
+            for (unsigned i = 1; i < threads; ++i)
+                reduce(total, parts[i]);
+            return total;
+        }
     };
 
     class Table {
@@ -421,64 +608,12 @@ namespace VDB {
 
         Cursor read(unsigned const N, char const *const fields[]) const
         {
-            unsigned n = 0;
-            VCursor const *curs = 0;
-            auto rc = VTableCreateCursorRead(o, &curs);
-            if (rc) throw Error(rc, __FILE__, __LINE__);
-
-            std::vector<unsigned int> columns;
-            for (unsigned i = 0; i < N; ++i) {
-                uint32_t cid = 0;
-
-                rc = VCursorAddColumn(curs, &cid, "%s", fields[i]);
-                if (rc)
-                {
-                    VCursorRelease( curs );
-                    throw Error(rc, __FILE__, __LINE__);
-                }
-                columns.push_back( cid );
-                ++n;
-            }
-            rc = VCursorOpen(curs);
-            if (rc)
-            {
-                VCursorRelease( curs );
-                throw Error(rc, __FILE__, __LINE__);
-            }
-            return Cursor(const_cast<VCursor *>(curs), columns);
+            return Cursor::open(o, std::vector<std::string>(fields, fields + N));
         }
 
         Cursor read(std::initializer_list<char const *> const &fields) const
         {
-            unsigned n = 0;
-            VCursor const *curs = 0;
-            auto rc = VTableCreateCursorRead(o, &curs);
-            if (rc)
-            {
-                VCursorRelease( curs );
-                throw Error(rc, __FILE__, __LINE__);
-            }
-
-            std::vector<unsigned int> columns;
-            for (auto && field : fields) {
-                uint32_t cid = 0;
-
-                rc = VCursorAddColumn(curs, &cid, "%s", field);
-                if (rc)
-                {
-                    VCursorRelease( curs );
-                    throw Error(rc, __FILE__, __LINE__);
-                }
-                columns.push_back( cid );
-                ++n;
-            }
-            rc = VCursorOpen(curs);
-            if (rc)
-            {
-                VCursorRelease( curs );
-                throw Error(rc, __FILE__, __LINE__);
-            }
-            return Cursor(const_cast<VCursor *>(curs), columns);
+            return Cursor::open(o, std::vector<std::string>(fields.begin(), fields.end()));
         }
 
         Schema openSchema( void ) const
@@ -0,0 +1,53 @@
+#!/bin/sh
+
+DIRTOTEST=$1
+tool_binary=$2
+
+echo "testing ${tool_binary}"
+
+if ! test -f ${DIRTOTEST}/${tool_binary}; then
+    echo "${DIRTOTEST}/${tool_binary} does not exist. Skipping the test."
+    exit 0
+fi
+
+CACHE=actual/cache
+TOOL="env NCBI_SETTINGS=/ ${DIRTOTEST}/${tool_binary}"
+
+rm -rf actual
+mkdir -p ${CACHE}/sra || exit 1
+
+# a.sra older than b.sra, the directory well before the scan,
+# so that the index keeps its modification-time
+head -c 1000 /dev/zero > ${CACHE}/sra/a.sra
+head -c 1000 /dev/zero > ${CACHE}/sra/b.sra
+touch -d '3 hours ago' ${CACHE}/sra/a.sra
+touch -d '2 hours ago' ${CACHE}/sra/b.sra
+touch -d '1 hour ago' ${CACHE}/sra
+
+${TOOL} ${CACHE} --report --index > actual/report1 2>&1 \
+|| { echo "${tool_binary} --report --index FAILED" && cat actual/report1 && exit 1; }
+grep -q "^2,000 bytes in cached files" actual/report1 \
+|| { echo "${tool_binary}: unexpected first report" && cat actual/report1 && exit 1; }
+
+# a.sra grows in place: now the largest and the most recently written file,
+# the directory keeps its modification-time
+head -c 5000 /dev/zero >> ${CACHE}/sra/a.sra
+touch -d '1 hour ago' ${CACHE}/sra
+
+${TOOL} ${CACHE} --report --index > actual/report2 2>&1 \
+|| { echo "${tool_binary} --report --index FAILED" && cat actual/report2 && exit 1; }
+grep -q "^7,000 bytes in cached files" actual/report2 \
+|| { echo "${tool_binary}: the index kept the old size of a grown file" && cat actual/report2 && exit 1; }
+
+# 7,000 bytes do not fit: the least recently written file goes, that is b.sra now
+touch -d '1 hour ago' ${CACHE}/sra
+${TOOL} ${CACHE} --quota 6000 > actual/quota 2>&1 \
+|| { echo "${tool_binary} --quota FAILED" && cat actual/quota && exit 1; }
+grep -q "^7,000 bytes in cache, quota is 6,000 bytes" actual/quota \
+|| { echo "${tool_binary}: --quota saw the wrong cache size" && cat actual/quota && exit 1; }
+if [ -f ${CACHE}/sra/b.sra ] || [ ! -f ${CACHE}/sra/a.sra ]; then
+    echo "${tool_binary}: --quota removed the wrong file" && cat actual/quota && exit 1
+fi
+
+rm -rf actual
+echo "${tool_binary} index tests passed"
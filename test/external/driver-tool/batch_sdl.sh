@@ -0,0 +1,96 @@
+#!/bin/sh
+
+# resolves accessions against a local mock SDL server (mock-sdl.py)
+# in batches of 2, then again from the SDL cache without asking SDL,
+# then from the cache with 3 accessions running at a time where the tool
+# writes files, and last from another SDL URL, which does not use the cache
+
+bin_dir=$1
+sratools=$2
+
+echo "testing batched SDL resolution and the SDL cache via ${sratools}"
+
+mkdir -p actual
+rm -f actual/batch_sdl.*
+
+python3 mock-sdl.py actual/batch_sdl.port actual/batch_sdl.log &
+mock=$!
+trap "kill ${mock} 2>/dev/null" EXIT
+
+i=0
+while [ ! -s actual/batch_sdl.port ] && [ $i -lt 50 ]; do sleep 0.1; i=$((i+1)); done
+if [ ! -s actual/batch_sdl.port ];
+	then echo "Driver tool test batch_sdl via ${sratools} FAILED, mock SDL did not start" && exit 1;
+fi
+port=$(cat actual/batch_sdl.port)
+
+cat tmp.mkfg > actual/batch_sdl.mkfg
+cat >> actual/batch_sdl.mkfg <<EOC
+/repository/remote/main/SDL.2/resolver-cgi = "http://127.0.0.1:${port}/sdl"
+/repository/remote/main/SDL.2/batch-size = "2"
+/repository/remote/main/SDL.2/threads = "3"
+/repository/remote/main/SDL.2/cache-file = "actual/batch_sdl.cache"
+EOC
+
+run() {
+	env -u http_proxy -u https_proxy -u HTTP_PROXY -u HTTPS_PROXY \
+	NCBI_SETTINGS=actual/batch_sdl.mkfg \
+	PATH="${bin_dir}:$PATH" \
+	SRATOOLS_DRY_RUN=1 \
+	SRATOOLS_IMPERSONATE=vdb-dump \
+	"$@" \
+	${bin_dir}/${sratools} SRR000001 SRR000002 SRR000003 SRR000004 SRR000005 >actual/batch_sdl.stdout 2>actual/batch_sdl.stderr
+}
+
+# 5 accessions in batches of 2 are 3 requests
+run
+res=$?
+requests=$(wc -l < actual/batch_sdl.log)
+if [ "$res" != "0" ] || [ "$requests" != "3" ];
+	then echo "Driver tool test batch_sdl via ${sratools} FAILED, res=$res requests=$requests" && cat actual/batch_sdl.stderr && exit 1;
+fi
+for acc in SRR000001 SRR000002 SRR000003 SRR000004 SRR000005; do
+	if ! grep -q "sra-pub-run-1/${acc}/" actual/batch_sdl.stderr;
+		then echo "Driver tool test batch_sdl via ${sratools} FAILED, ${acc} was not resolved" && exit 1;
+	fi
+done
+
+# all 5 come from the cache
+run
+res=$?
+requests=$(wc -l < actual/batch_sdl.log)
+if [ "$res" != "0" ] || [ "$requests" != "3" ];
+	then echo "Driver tool test batch_sdl via ${sratools} FAILED with cache, res=$res requests=$requests" && cat actual/batch_sdl.stderr && exit 1;
+fi
+
+# vdb-dump writes to stdout, its accessions still run one at a time
+grep -o 'sra-pub-run-1/SRR00000./' actual/batch_sdl.stderr > actual/batch_sdl.order
+run SRATOOLS_JOBS=3
+res=$?
+grep -o 'sra-pub-run-1/SRR00000./' actual/batch_sdl.stderr > actual/batch_sdl.jobs.order
+if [ "$res" != "0" ] || ! cmp -s actual/batch_sdl.order actual/batch_sdl.jobs.order;
+	then echo "Driver tool test batch_sdl via ${sratools} FAILED with SRATOOLS_JOBS for vdb-dump, res=$res" && cat actual/batch_sdl.stderr && exit 1;
+fi
+
+# fastq-dump writes files, the output of its concurrent runs is in the order of the accessions
+run SRATOOLS_IMPERSONATE=fastq-dump
+grep -o 'sra-pub-run-1/SRR00000./' actual/batch_sdl.stderr > actual/batch_sdl.order
+run SRATOOLS_IMPERSONATE=fastq-dump SRATOOLS_JOBS=3
+res=$?
+grep -o 'sra-pub-run-1/SRR00000./' actual/batch_sdl.stderr > actual/batch_sdl.jobs.order
+if [ "$res" != "0" ] || ! cmp -s actual/batch_sdl.order actual/batch_sdl.jobs.order;
+	then echo "Driver tool test batch_sdl via ${sratools} FAILED with SRATOOLS_JOBS for fastq-dump, res=$res" && cat actual/batch_sdl.stderr && exit 1;
+fi
+
+# results cached from another SDL URL are not used
+sed -i "s|/sdl\"|/sdl-other\"|" actual/batch_sdl.mkfg
+run
+res=$?
+requests=$(wc -l < actual/batch_sdl.log)
+if [ "$res" != "0" ] || [ "$requests" != "6" ];
+	then echo "Driver tool test batch_sdl via ${sratools} FAILED with another SDL URL, res=$res requests=$requests" && cat actual/batch_sdl.stderr && exit 1;
+fi
+
+rm -f actual/batch_sdl.*
+
+echo Driver tool test batch_sdl via ${sratools} is finished
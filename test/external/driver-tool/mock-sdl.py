@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+"""
+A stand-in for the SDL resolver, for testing batched resolution without network access.
+
+Answers every POSTed "acc" with an SDL version 2 result that points at ncbi,
+and appends one line per request, with the number of accessions, to the log file.
+
+usage: mock-sdl.py <port file> <log file>
+    the port the server is listening on is written to <port file>
+"""
+
+import json
+import sys
+from http.server import HTTPServer, BaseHTTPRequestHandler
+from urllib.parse import parse_qs
+
+
+def result_for(acc):
+    if not acc.startswith('SRR'):
+        return {'bundle': acc, 'status': 404, 'msg': 'No data at given location.'}
+    return {
+        'bundle': acc, 'status': 200, 'msg': 'ok',
+        'files': [{
+            'object': 'srapub|' + acc, 'type': 'sra', 'name': acc, 'size': 1000,
+            'locations': [{
+                'link': 'https://sra-downloadb.be-md.ncbi.nlm.nih.gov/sos5/sra-pub-run-1/' + acc + '/' + acc + '.1',
+                'service': 'ncbi', 'region': 'be-md'
+            }]
+        }]
+    }
+
+
+class Handler(BaseHTTPRequestHandler):
+    def do_POST(self):
+        length = int(self.headers.get('Content-Length', 0))
+        form = parse_qs(self.rfile.read(length).decode('utf-8'))
+        accs = form.get('acc', [])
+        with open(sys.argv[2], 'a') as log:
+            log.write('{}\n'.format(len(accs)))
+        body = json.dumps({'version': '2', 'result': [result_for(acc) for acc in accs]}).encode('utf-8')
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, format, *args):
+        pass
+
+
+if __name__ == '__main__':
+    server = HTTPServer(('127.0.0.1', 0), Handler)
+    with open(sys.argv[1], 'w') as port:
+        port.write('{}\n'.format(server.server_address[1]))
+    server.serve_forever()
@@ -0,0 +1,222 @@
+/* ===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+* Project:
+*  sratools command line tool
+*
+* Purpose:
+ *  Tests for the SDL result cache
+*
+*/
+
+#if WINDOWS
+#pragma warning(disable: 4100)
+#pragma warning(disable: 4101)
+#endif
+
+#include "json-parse.cpp"
+#include "SDL-response.cpp"
+#include "SDL-cache.cpp"
+
+#include <iostream>
+
+struct test_failure: public std::exception
+{
+    char const *test_name;
+    test_failure(char const *test) : test_name(test) {}
+    char const *what() const throw() { return test_name; }
+};
+
+#define ASSERT(X) do { if (X) break; std::cerr << __FILE__ << ":" << __LINE__ << " assertion failed: " << #X << std::endl; throw test_failure(__FUNCTION__); } while (0)
+
+static char const cacheFile[] = "test-sdl-cache.tmp";
+
+static Response2::Results makeResults(char const *const json)
+{
+    return Response2::makeFrom(json).results;
+}
+
+static Response2::Results const &testResults()
+{
+    static auto const results = makeResults(R"###(
+{
+    "version": "2",
+    "result": [
+        {
+            "bundle": "SRR000001",
+            "status": 200,
+            "msg": "ok",
+            "files": [
+                {
+                    "object": "srapub|SRR000001",
+                    "type": "sra",
+                    "name": "SRR000001",
+                    "size": 312527083,
+                    "locations": [
+                        {
+                            "link": "https://sra-downloadb.be-md.ncbi.nlm.nih.gov/sos5/sra-pub-zq-11/SRR000/000/SRR000001/SRR000001.lite.1",
+                            "service": "ncbi",
+                            "region": "be-md"
+                        }
+                    ]
+                }
+            ]
+        },
+        {
+            "bundle": "SRR000002",
+            "status": 200,
+            "msg": "ok",
+            "files": [
+                {
+                    "object": "srapub|SRR000002",
+                    "type": "sra",
+                    "name": "SRR000002",
+                    "locations": [
+                        {
+                            "link": "https://sra-pub-run-odp.s3.amazonaws.com/sra/SRR000002/SRR000002?X-Amz-Signature=0",
+                            "service": "s3",
+                            "region": "us-east-1",
+                            "expirationDate": "2020-01-01T00:00:00Z"
+                        }
+                    ]
+                }
+            ]
+        },
+        {
+            "bundle": "SRR000003",
+            "status": 404,
+            "msg": "not found"
+        }
+    ]
+}
+)###");
+    return results;
+}
+
+static void test_store_and_find() {
+    std::remove(cacheFile);
+    {
+        auto cache = SDLCache(cacheFile, "\tunknown", 60);
+        auto found = Response2::Results();
+
+        ASSERT(!cache.find("SRR000001", found));
+        ASSERT(cache.store(testResults()[0]));
+        ASSERT(!cache.store(testResults()[1])); // signed URL
+        ASSERT(!cache.store(testResults()[2])); // not 200
+        ASSERT(cache.modified());
+        ASSERT(cache.save());
+    }
+    {
+        auto const cache = SDLCache(cacheFile, "\tunknown", 60);
+        auto found = Response2::Results();
+
+        ASSERT(cache.find("SRR000001", found));
+        ASSERT(!cache.find("SRR000002", found));
+        ASSERT(!cache.find("SRR000003", found));
+        ASSERT(found.size() == 1);
+        ASSERT(found[0].toJSON() == testResults()[0].toJSON());
+        ASSERT(found[0].getByType("sra").size() == 1);
+    }
+    {
+        // different location or quality preference
+        auto const cache = SDLCache(cacheFile, "s3.us-east-1\tunknown", 60);
+        auto found = Response2::Results();
+
+        ASSERT(!cache.find("SRR000001", found));
+    }
+    std::remove(cacheFile);
+}
+
+static void test_merge() {
+    std::remove(cacheFile);
+    {
+        auto first = SDLCache(cacheFile, "\tfull", 60);
+        auto second = SDLCache(cacheFile, "\tnone", 60);
+
+        ASSERT(first.store(testResults()[0]));
+        ASSERT(second.store(testResults()[0]));
+        ASSERT(first.save());
+        ASSERT(second.save());
+    }
+    for (auto const context : { "\tfull", "\tnone" }) {
+        auto const cache = SDLCache(cacheFile, context, 60);
+        auto found = Response2::Results();
+
+        ASSERT(cache.find("SRR000001", found));
+    }
+    std::remove(cacheFile);
+}
+
+static void test_expired() {
+    std::remove(cacheFile);
+    {
+        std::ofstream file(cacheFile);
+        file << "#SDL-cache\t1\n"
+             << "1\t\tunknown\tSRR000001\t" << testResults()[0].toJSON() << '\n'
+             << std::time(nullptr) + 60 << "\t\tunknown\tSRR000002\t{\"bundle\":\n"
+             << "garbage\n";
+    }
+    auto const cache = SDLCache(cacheFile, "\tunknown", 60);
+    auto found = Response2::Results();
+
+    ASSERT(!cache.find("SRR000001", found)); // expired
+    ASSERT(!cache.find("SRR000002", found)); // damaged
+    ASSERT(found.empty());
+    std::remove(cacheFile);
+}
+
+static void test_wrong_header() {
+    {
+        std::ofstream file(cacheFile);
+        file << "#SDL-cache\t0\n"
+             << std::time(nullptr) + 60 << "\t\tunknown\tSRR000001\t" << testResults()[0].toJSON() << '\n';
+    }
+    auto const cache = SDLCache(cacheFile, "\tunknown", 60);
+    auto found = Response2::Results();
+
+    ASSERT(!cache.find("SRR000001", found));
+    std::remove(cacheFile);
+}
+
+#if WINDOWS
+int wmain ( int argc, wchar_t *argv[], wchar_t *envp[])
+#else
+int main ( int argc, char *argv[], char *envp[])
+#endif
+{
+    try {
+        test_store_and_find();
+        test_merge();
+        test_expired();
+        test_wrong_header();
+        return 0;
+    }
+    catch (test_failure const &e) {
+        std::cerr << "test " << e.what() << " failed." << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+    return 3;
+}
@@ -1074,6 +1074,82 @@ static void test_multiple_locations() {
     }
 }
 
+static void test_round_trip() {
+    auto const testJSON = R"###(
+{
+    "version": "2",
+    "result": [
+        {
+            "bundle": "SRR000001",
+            "status": 200,
+            "msg": "ok \"quoted\"\tand\\escaped",
+            "files": [
+                {
+                    "object": "srapub|SRR000001",
+                    "type": "sra",
+                    "name": "SRR000001",
+                    "size": 312527083,
+                    "md5": "9bde35fefa9d955f457e22d9be52bcd9",
+                    "noqual": true,
+                    "locations": [
+                        {
+                            "link": "https://sra-downloadb.be-md.ncbi.nlm.nih.gov/sos5/sra-pub-zq-11/SRR000/000/SRR000001/SRR000001.lite.1",
+                            "service": "ncbi",
+                            "region": "be-md"
+                        },
+                        {
+                            "link": "https://sra-pub-run-odp.s3.amazonaws.com/sra/SRR000001/SRR000001",
+                            "service": "s3",
+                            "region": "us-east-1",
+                            "encryptedForProjectId": "phs000001",
+                            "ceRequired": true,
+                            "payRequired": true
+                        }
+                    ]
+                }
+            ]
+        }
+    ]
+}
+)###";
+    try {
+        auto const &raw = Response2::makeFrom(testJSON);
+        ASSERT(raw.results.size() == 1);
+
+        auto const &before = raw.results[0];
+        auto const &json = std::string("{\"version\":\"2\",\"result\":[") + before.toJSON() + "]}";
+        auto const &again = Response2::makeFrom(json);
+        ASSERT(again.results.size() == 1);
+
+        auto const &after = again.results[0];
+        ASSERT(after.query == before.query);
+        ASSERT(after.status == before.status);
+        ASSERT(after.message == before.message);
+        ASSERT(after.files.size() == 1);
+
+        auto const &file = after.files[0];
+        ASSERT(file.name == "SRR000001");
+        ASSERT(file.type == "sra");
+        ASSERT(file.object && file.object.value() == "srapub|SRR000001");
+        ASSERT(file.size && file.size.value() == "312527083");
+        ASSERT(!file.modificationDate);
+        ASSERT(file.noqual);
+        ASSERT(file.locations.size() == 2);
+        ASSERT(!file.locations[0].projectId);
+        ASSERT(!file.locations[0].ceRequired);
+        ASSERT(file.locations[1].projectId && file.locations[1].projectId.value() == "phs000001");
+        ASSERT(file.locations[1].ceRequired);
+        ASSERT(file.locations[1].payRequired);
+        ASSERT(after.toJSON() == before.toJSON());
+
+        LOG(8) << "round trip passed." << std::endl;
+    }
+    catch (Response2::DecodingError const &e) {
+        std::cerr << e << std::endl;
+        throw test_failure(__FUNCTION__);
+    }
+}
+
 #if WINDOWS
 int wmain ( int argc, wchar_t *argv[], wchar_t *envp[])
 #else
@@ -1085,6 +1161,7 @@ int main ( int argc, char *argv[], char *envp[])
             test_multiple_locations();
             test_matching_vdbcache();
             test_nonmatching_vdbcache();
+            test_round_trip();
             return 0;
         }
     }
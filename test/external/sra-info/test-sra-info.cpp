@@ -135,6 +135,33 @@ FIXTURE_TEST_CASE(MultiplePlatforms, SraInfoFixture)
     REQUIRE( p.end() != p.find("SRA_PLATFORM_454") );
 }
 
+FIXTURE_TEST_CASE(MultiplePlatforms_SingleThread, SraInfoFixture)
+{
+    info.SetAccession(Run_Multiplatform);
+    info.SetThreads( 1 );
+    SraInfo::Platforms p = info.GetPlatforms();
+    REQUIRE_EQ( size_t(3), p.size() );
+}
+
+FIXTURE_TEST_CASE(MultiplePlatforms_SummaryCache, SraInfoFixture)
+{
+    const string path = "./._input_MultiPlatform.sra.platforms"; // the accession is a path
+    remove( path.c_str() );
+    info.SetAccession(Run_Multiplatform);
+    info.SetSummaryCache( "." );
+
+    SraInfo::Platforms p = info.GetPlatforms();
+    REQUIRE_EQ( size_t(3), p.size() );
+    ifstream in( path );
+    REQUIRE( in.good() );
+    in.close();
+
+    // answered from the cache
+    SraInfo::Platforms cached = info.GetPlatforms();
+    REQUIRE( p == cached );
+    remove( path.c_str() );
+}
+
 // Formatting
 FIXTURE_TEST_CASE(Format_values, SraInfoFixture)
 {   // case insensitive
@@ -467,6 +494,95 @@ FIXTURE_TEST_CASE(SpotLayout_TopRows_MoreThanPresent, SraInfoFixture)
     REQUIRE_EQ( size_t( TOTAL_ROWS ), total );
 }
 
+// SpotLayout, scanning
+FIXTURE_TEST_CASE(SpotLayout_Threads, SraInfoFixture)
+{
+    info.SetAccession(Accession_Table);
+    info.SetThreads( 1 );
+    const SraInfo::SpotLayouts sl1 = info.GetSpotLayouts( SraInfo::Full );
+    info.SetThreads( 7 );
+    const SraInfo::SpotLayouts sl7 = info.GetSpotLayouts( SraInfo::Full );
+
+    REQUIRE_EQ( size_t(267), sl7.size() );
+    REQUIRE_EQ( sl1.size(), sl7.size() );
+    for ( size_t i = 0; i < sl1.size(); ++i )
+    {
+        REQUIRE_EQ( sl1[i].count, sl7[i].count );
+        REQUIRE_EQ( sl1[i].reads.size(), sl7[i].reads.size() );
+        REQUIRE( ! ( sl1[i].reads < sl7[i].reads ) && ! ( sl7[i].reads < sl1[i].reads ) );
+    }
+}
+
+// SpotLayout, summary cache
+class SummaryCacheFixture : public SraInfoFixture
+{
+public:
+    SummaryCacheFixture()
+    {
+        remove( Path.c_str() );
+        info.SetAccession(Accession_Table);
+        info.SetSummaryCache( "." );
+    }
+    ~SummaryCacheFixture()
+    {
+        remove( Path.c_str() );
+    }
+
+    void WriteCache( const string & rows )
+    {
+        ofstream out( Path );
+        out << "sra-info-summary 1\n" << Accession_Table << "\n" << "SEQUENCE " << rows << "\n" << "7 1 1 100\n";
+    }
+
+    const string Path = "./" + Accession_Table + ".layouts";
+};
+
+FIXTURE_TEST_CASE(SpotLayout_SummaryCache_Written, SummaryCacheFixture)
+{
+    SraInfo::SpotLayouts sl = info.GetSpotLayouts( SraInfo::Full );
+    REQUIRE_EQ( size_t(267), sl.size() );
+    ifstream in( Path );
+    REQUIRE( in.good() );
+    in.close();
+
+    // the cache holds full detail
+    SraInfo::SpotLayouts cached = info.GetSpotLayouts( SraInfo::Short );
+    SraInfo noCache;
+    noCache.SetAccession(Accession_Table);
+    SraInfo::SpotLayouts scanned = noCache.GetSpotLayouts( SraInfo::Short );
+    REQUIRE_EQ( scanned.size(), cached.size() );
+    for ( size_t i = 0; i < scanned.size(); ++i )
+    {
+        REQUIRE_EQ( scanned[i].count, cached[i].count );
+        REQUIRE_EQ( scanned[i].reads.size(), cached[i].reads.size() );
+    }
+}
+
+FIXTURE_TEST_CASE(SpotLayout_SummaryCache_Used, SummaryCacheFixture)
+{
+    WriteCache( "1 4584" );
+    SraInfo::SpotLayouts sl = info.GetSpotLayouts( SraInfo::Full );
+    REQUIRE_EQ( size_t(1), sl.size() );
+    REQUIRE_EQ( uint64_t(7), sl[0].count );
+    REQUIRE_EQ( size_t(1), sl[0].reads.size() );
+    REQUIRE_EQ( string("BIOLOGICAL"), sl[0].reads[0].TypeAsString() );
+    REQUIRE_EQ( uint32_t(100), sl[0].reads[0].length );
+}
+
+FIXTURE_TEST_CASE(SpotLayout_SummaryCache_Stale, SummaryCacheFixture)
+{   // a different row range, the table is scanned again
+    WriteCache( "1 100" );
+    SraInfo::SpotLayouts sl = info.GetSpotLayouts( SraInfo::Full );
+    REQUIRE_EQ( size_t(267), sl.size() );
+}
+
+FIXTURE_TEST_CASE(SpotLayout_SummaryCache_NotForTopRows, SummaryCacheFixture)
+{
+    WriteCache( "1 4584" );
+    SraInfo::SpotLayouts sl = info.GetSpotLayouts( SraInfo::Full, true, 5 );
+    REQUIRE_EQ( size_t(5), sl.size() );
+}
+
 // IsAligned
 FIXTURE_TEST_CASE(IsAligned_No, SraInfoFixture)
 {
@@ -114,6 +114,22 @@ run_test "6.1" "data/ViewDatabase -T VIEW3"
 # 7.0 symbolic names for various platforms
 run_test "7.0" "input/platforms -C PLATFORM"
 
+# 8.0 blob statistics: the timing varies, check that it runs and produces valid json with an entry for the column
+${bin_dir}/${vdb_dump_binary} input/platforms -C PLATFORM --inspect-perf --inspect-samples 4 -f json > actual/8.0.stdout 2>actual/8.0.stderr
+res=$?
+if [ "$res" != "0" ] || ! python3 -m json.tool actual/8.0.stdout > actual/8.0.json || ! grep -q '"PLATFORM": {' actual/8.0.json;
+	then echo "${vdb_dump_binary} --inspect-perf (8.0) FAILED, res=$res output=$(cat actual/8.0.stdout)" && exit 1;
+fi
+echo run_test 8.0 done
+
+# 8.1 blob statistics of all columns: one json-array, whatever the outcome for the single columns
+${bin_dir}/${vdb_dump_binary} input/platforms --inspect-perf --inspect-samples 4 -f json > actual/8.1.stdout 2>actual/8.1.stderr
+res=$?
+if ! python3 -m json.tool actual/8.1.stdout > /dev/null;
+	then echo "${vdb_dump_binary} --inspect-perf (8.1) FAILED, res=$res output=$(cat actual/8.1.stdout)" && exit 1;
+fi
+echo run_test 8.1 done
+
 rm -rf actual
 # keep the test database for the other tests that might follow (e.g. Test_Vdb_dump_view-alias - see CMakeLists.txt)
 #rm -rf data
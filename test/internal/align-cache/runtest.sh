@@ -21,5 +21,32 @@ if [ "$res" != "0" ];
 fi
 ${DIRTOTEST}/vdb-validate CSRA_file.cache/ 2>&1 \
 | grep --quiet "is consistent" || exit 1
+
+# every row of SEQUENCE is scanned, the last one included:
+# the cache spans exactly from the smallest to the largest selected id
+expected=$(${DIRTOTEST}/vdb-dump CSRA_file -T SEQUENCE -C PRIMARY_ALIGNMENT_ID -f tab \
+| awk '{ gsub(/[^0-9]+/, " "); n = split($0, id, " ");
+         if (n == 2 && id[1] > 0 && id[2] > 0 && (id[1] > id[2] ? id[1] - id[2] : id[2] - id[1]) > 10)
+             print id[1] "\n" id[2] }' \
+| sort -n | sed -n '1p;$p' | tr '\n' ' ')
+actual=$(${DIRTOTEST}/vdb-dump CSRA_file.cache -T PRIMARY_ALIGNMENT --id_range \
+| tr -d ',' | sed -n 's/.*first-row = \([0-9]*\) row-count = \([0-9]*\).*/\1 \2/p' \
+| awk '{ print $1 " " $1 + $2 - 1 " " }')
+if [ "$expected" != "$actual" ];
+	then echo "${tool_binary}: cached rows '$actual', expected '$expected'" && exit 1;
+fi
+
+# the result does not depend on the number of threads
+${DIRTOTEST}/vdb-dump CSRA_file.cache -T PRIMARY_ALIGNMENT > cache.threads-default
+rm -rf CSRA_file.cache
+output=$(VDB_CONFIG=`pwd` ${DIRTOTEST}/${tool_binary} \
+                           -t 10 --min-cache-count 1 --threads 1 CSRA_file CSRA_file.cache)
+res=$?
+if [ "$res" != "0" ];
+	then echo "${tool_binary} --threads 1 FAILED, res=$res output=$output" && exit 1;
+fi
+${DIRTOTEST}/vdb-dump CSRA_file.cache -T PRIMARY_ALIGNMENT | cmp -s - cache.threads-default \
+|| { echo "${tool_binary}: --threads 1 produced a different cache" && exit 1; }
+rm cache.threads-default
 rm tmp.kfg
 rm -rf CSRA_file.cache
@@ -0,0 +1,52 @@
+#!/bin/bash
+
+bin_dir=$1
+tool_binary=$2
+
+echo "testing ${tool_binary} catalog with and without threads"
+
+if ! test -f ${bin_dir}/${tool_binary}; then
+    echo "${bin_dir}/${tool_binary} does not exist. Skipping the test."
+    exit 0
+fi
+
+# a file above the size where the pipe threads are used, its gzip
+# and a small file handled on the main thread
+SRC=actual/threads-src
+rm -rf actual/threads* && mkdir -p ${SRC} actual/threads-dst actual/threads-dst-no
+cp input/1.fq ${SRC}/small.fq
+awk 'BEGIN { for ( i = 1; i <= 200000; ++i ) printf "@read_%d\nACGTACGTAC\n+\nIIIIIIIIII\n", i }' > ${SRC}/large.fq
+gzip -c ${SRC}/large.fq > ${SRC}/large.fq.gz
+
+checksums()
+{
+    grep -oE ' (path|md5|crc32)="[^"]*"'
+}
+
+${bin_dir}/${tool_binary} ${SRC} actual/threads-dst > actual/threads.xml
+res=$?
+if [ "$res" != "0" ];
+    then echo "${tool_binary} with threads failed, res=${res}" && exit 1;
+fi
+
+${bin_dir}/${tool_binary} --no-threads ${SRC} actual/threads-dst-no > actual/no-threads.xml
+res=$?
+if [ "$res" != "0" ];
+    then echo "${tool_binary} --no-threads failed, res=${res}" && exit 1;
+fi
+
+checksums < actual/threads.xml > actual/threads.out
+checksums < actual/no-threads.xml > actual/no-threads.out
+
+MD5=$(md5sum ${SRC}/large.fq | cut -d ' ' -f 1)
+if ! grep -q "md5=\"${MD5}\"" actual/threads.out;
+    then echo "${tool_binary} md5 of large.fq is not ${MD5}" && exit 1;
+fi
+
+output=$(diff actual/threads.out actual/no-threads.out)
+res=$?
+if [ "$res" != "0" ];
+    then echo "${tool_binary} catalogs differ with and without threads: ${output}" && exit 1;
+fi
+
+echo "${tool_binary} catalog with and without threads succeeded"
@@ -40,6 +40,23 @@ $VDB_COPY $ACC $ACC_COPY -p
 
 $VDB_DIFF $ACC $ACC_COPY -pc
 
+# the threaded row-loop and the blob-copy have to produce the same table as the single-threaded copy
+for MODE in "--threads 4" "--blob_copy"; do
+    MODE_COPY="${ACC_COPY}_mode"
+    rm -rf $MODE_COPY
+    $VDB_COPY $ACC $MODE_COPY -p $MODE
+    $VDB_DIFF $ACC_COPY $MODE_COPY -pc
+    rm -rf $MODE_COPY
+done
+
+# an invalid thread-count is an error
+if $VDB_COPY $ACC "${ACC_COPY}_mode" --threads 0 2>/dev/null; then
+    echo "vdb-copy accepted --threads 0"
+    rm -rf "${ACC_COPY}_mode" $ACC_COPY
+    exit 1
+fi
+rm -rf "${ACC_COPY}_mode"
+
 if [ -d $ACC_COPY ]; then
     rm -rf $ACC_COPY
 fi
@@ -59,7 +59,17 @@ SCRATCH=$(mktemp -d) || exit 1
 
     # Verify that redaction worked. awk will exit 3 if any redacted spot's sequence has anything but N
     "${VDB_DUMP}" -f tab 'test-data-redacted' -C"READ_FILTER,(INSDC:dna:text)READ" | \
-        awk 'BEGIN{ FS="\t" } $1~/REDACTED/ && $2~/[^N]/ {exit 3}'
+        awk 'BEGIN{ FS="\t" } $1~/REDACTED/ && $2~/[^N]/ {exit 3}' || exit $?
+    "${VDB_DUMP}" 'test-data-redacted' > 'redacted.txt' || exit $?
+
+    # The threaded row-loop has to redact the same way, the blob-copy must not be taken
+    # for a table with redacted rows: both have to match the single-threaded copy
+    for MODE in "--threads 4" "--blob_copy"; do
+        rm -rf 'test-data-mode'
+        "${VDB_COPY}" -k "${CONFIG_PATH}" ${MODE} 'test-data' 'test-data-mode' || exit $?
+        "${VDB_DUMP}" 'test-data-mode' > 'mode.txt' || exit $?
+        cmp -s 'redacted.txt' 'mode.txt' || { echo "vdb-copy ${MODE} differs from the single-threaded copy"; exit 3; }
+    done
 )
 ec=$?
 rm -rf "${SCRATCH}"
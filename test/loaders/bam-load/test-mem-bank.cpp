@@ -0,0 +1,228 @@
+/*===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+*/
+
+/**
+* Unit tests for the fragment store of bam-load
+*/
+
+#include <ktst/unit_test.hpp>
+
+#include "../../../tools/loaders/bam-loader/mem-bank.cpp"
+
+#include <kfs/directory.h>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+TEST_SUITE(MemBankSuite);
+
+class MemBank_Fixture
+{
+public:
+    static size_t const Budget = 64 * 1024;
+
+    MemBank_Fixture()
+    : m_dir(nullptr)
+    , m_bank(nullptr)
+    {
+        size_t const climits[2] = { Budget / 2, Budget / 2 };
+
+        if (KDirectoryNativeDir(&m_dir) != 0)
+            throw logic_error("KDirectoryNativeDir failed");
+        if (MemBankMake(&m_bank, m_dir, 1, climits) != 0)
+            throw logic_error("MemBankMake failed");
+    }
+    ~MemBank_Fixture()
+    {
+        MemBankRelease(m_bank);
+        KDirectoryRelease(m_dir);
+    }
+
+    static string Pattern(uint32_t const n, size_t const size)
+    {
+        string rslt(size, '\0');
+        for (size_t i = 0; i < size; ++i)
+            rslt[i] = (char)('A' + (n + i) % 26);
+        return rslt;
+    }
+    uint32_t Alloc(uint32_t const n, size_t const size)
+    {
+        string const data = Pattern(n, size);
+        uint32_t id = 0;
+        size_t num_writ = 0;
+
+        if (MemBankAlloc(m_bank, &id, size, false, false) != 0)
+            throw logic_error("MemBankAlloc failed");
+        if (MemBankWrite(m_bank, id, 0, data.data(), size, &num_writ) != 0 || num_writ != size)
+            throw logic_error("MemBankWrite failed");
+        return id;
+    }
+    string Read(uint32_t const id)
+    {
+        size_t size = 0;
+        size_t num_read = 0;
+
+        if (MemBankSize(m_bank, id, &size) != 0)
+            throw logic_error("MemBankSize failed");
+        string rslt(size, '\0');
+        if (MemBankRead(m_bank, id, 0, &rslt[0], size, &num_read) != 0 || num_read != size)
+            throw logic_error("MemBankRead failed");
+        return rslt;
+    }
+    MemBankStats Stats() const
+    {
+        MemBankStats rslt;
+        MemBankGetStats(m_bank, &rslt);
+        return rslt;
+    }
+
+    KDirectory *m_dir;
+    MemBank *m_bank;
+};
+
+FIXTURE_TEST_CASE(MemBank_Resident, MemBank_Fixture)
+{
+    uint32_t const id = Alloc(1, 1000);
+
+    REQUIRE_EQ(Pattern(1, 1000), Read(id));
+    REQUIRE_EQ((uint64_t)0, Stats().evictions);
+    REQUIRE_RC(MemBankFree(m_bank, id));
+    REQUIRE_EQ((uint64_t)0, Stats().resident_bytes);
+}
+
+FIXTURE_TEST_CASE(MemBank_SpillReadBack, MemBank_Fixture)
+{
+    vector<uint32_t> ids;
+    for (uint32_t n = 0; n < 200; ++n)
+        ids.push_back(Alloc(n, 1000));
+
+    MemBankStats const st = Stats();
+    REQUIRE_GT(st.evictions, (uint64_t)0);
+    REQUIRE_GT(st.spill_bytes, (uint64_t)0);
+    REQUIRE_LE(st.resident_bytes, (uint64_t)Budget);
+
+    for (uint32_t n = 0; n < 200; ++n)
+        REQUIRE_EQ(Pattern(n, 1000), Read(ids[n]));
+    REQUIRE_GT(Stats().spill_reads, (uint64_t)0);
+
+    // the oldest fragment is spilled, writes go to the spill file
+    string const data = Pattern(99, 10);
+    size_t num_writ = 0;
+    REQUIRE_RC(MemBankWrite(m_bank, ids[0], 100, data.data(), data.size(), &num_writ));
+    REQUIRE_EQ(data.size(), num_writ);
+    REQUIRE_EQ(Pattern(0, 100) + data + Pattern(0, 1000).substr(110), Read(ids[0]));
+}
+
+FIXTURE_TEST_CASE(MemBank_FreeSpilled, MemBank_Fixture)
+{
+    vector<uint32_t> ids;
+    for (uint32_t n = 0; n < 200; ++n)
+        ids.push_back(Alloc(n, 1000));
+    for (auto id : ids)
+        REQUIRE_RC(MemBankFree(m_bank, id));
+
+    MemBankStats const st = Stats();
+    REQUIRE_EQ((uint64_t)0, st.spill_bytes);
+    REQUIRE_EQ((uint64_t)0, st.resident_bytes);
+    REQUIRE_GT(st.spill_file_bytes, (uint64_t)0);
+}
+
+FIXTURE_TEST_CASE(MemBank_SpillSpaceReused, MemBank_Fixture)
+{
+    vector<uint32_t> ids;
+    for (uint32_t n = 0; n < 200; ++n)
+        ids.push_back(Alloc(n, 1000));
+    for (auto id : ids)
+        REQUIRE_RC(MemBankFree(m_bank, id));
+
+    uint64_t const file_size = Stats().spill_file_bytes;
+
+    // the same load again fits in the ranges of the freed fragments
+    ids.clear();
+    for (uint32_t n = 0; n < 200; ++n)
+        ids.push_back(Alloc(n + 1000, 1000));
+    REQUIRE_EQ(file_size, Stats().spill_file_bytes);
+    for (uint32_t n = 0; n < 200; ++n)
+        REQUIRE_EQ(Pattern(n + 1000, 1000), Read(ids[n]));
+}
+
+FIXTURE_TEST_CASE(MemBank_LargeSpillSpaceReused, MemBank_Fixture)
+{
+    // larger than the biggest size class
+    size_t const large = 60 * 1024;
+    vector<uint32_t> ids;
+    for (uint32_t n = 0; n < 4; ++n)
+        ids.push_back(Alloc(n, large));
+    for (uint32_t n = 0; n < 4; ++n)
+        REQUIRE_EQ(Pattern(n, large), Read(ids[n]));
+    for (auto id : ids)
+        REQUIRE_RC(MemBankFree(m_bank, id));
+
+    uint64_t const file_size = Stats().spill_file_bytes;
+    REQUIRE_GT(file_size, (uint64_t)0);
+
+    // smaller fragments fit in what is left of the freed large ranges
+    ids.clear();
+    for (uint32_t n = 0; n < 4; ++n)
+        ids.push_back(Alloc(n + 10, large - 1000));
+    REQUIRE_EQ(file_size, Stats().spill_file_bytes);
+    for (uint32_t n = 0; n < 4; ++n)
+        REQUIRE_EQ(Pattern(n + 10, large - 1000), Read(ids[n]));
+}
+
+//////////////////////////////////////////// Main
+extern "C"
+{
+
+#include <kapp/args.h>
+#include <kfg/config.h>
+
+ver_t CC KAppVersion ( void )
+{
+    return 0x1000000;
+}
+rc_t CC UsageSummary (const char * progname)
+{
+    return 0;
+}
+
+rc_t CC Usage ( const Args * args )
+{
+    return 0;
+}
+
+const char UsageDefaultName[] = "test-mem-bank";
+
+rc_t CC KMain ( int argc, char *argv [] )
+{
+    KConfigDisableUserSettings();
+    rc_t rc=MemBankSuite(argc, argv);
+    return rc;
+}
+
+}
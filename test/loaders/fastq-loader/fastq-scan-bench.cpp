@@ -0,0 +1,325 @@
+/*===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+*/
+
+/**
+* Record parsing benchmark for latf-load
+*
+* Reads FASTQ/FASTA files through FastqReaderFile twice, with the direct record scanner (fastq-scan.c)
+* and with the flex/bison parser only, times both and fails if they disagree on any record.
+* Without file arguments runs on generated Illumina (CASAVA 1.8 and older), SRA, 454, SOLiD inputs
+* and on a mix of records the scanner accepts and records it leaves to the parser.
+*
+* Usage: fastq-scan-bench [-n records] [-q PHRED_33|PHRED_64|LOGODDS] [-g] [file...]
+*   -g  ignore spot groups ( latf-load --ignore-illumina-tags )
+*/
+
+#include <kfs/directory.h>
+#include <loader/common-reader.h>
+
+#include "../../tools/loaders/fastq-loader/fastq-parse.h"
+#include "../../tools/loaders/fastq-loader/fastq-reader.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct ParsedRecord
+{
+    bool rejected = false;
+    string message;
+    uint64_t line = 0;
+    uint64_t column = 0;
+    bool fatal = false;
+
+    string spotName;
+    string spotGroup;
+    string read;
+    string quality;
+    uint8_t qualityOffset = 0;
+    uint8_t readNumber = 0;
+    bool colorspace = false;
+    bool lowQuality = false;
+
+    bool operator == ( const ParsedRecord& that ) const
+    {
+        return rejected == that.rejected && message == that.message &&
+               line == that.line && column == that.column && fatal == that.fatal &&
+               spotName == that.spotName && spotGroup == that.spotGroup &&
+               read == that.read && quality == that.quality && qualityOffset == that.qualityOffset &&
+               readNumber == that.readNumber && colorspace == that.colorspace && lowQuality == that.lowQuality;
+    }
+};
+
+static ostream& operator << ( ostream& out, const ParsedRecord& r )
+{
+    if ( r.rejected )
+        return out << "rejected(" << r.line << ":" << r.column << ( r.fatal ? ", fatal" : "" ) << ") " << r.message;
+    return out << "name='" << r.spotName << "' group='" << r.spotGroup << "' readno=" << (int)r.readNumber
+               << ( r.colorspace ? " cs" : "" ) << ( r.lowQuality ? " lowq" : "" )
+               << " read='" << r.read << "' qual='" << r.quality << "'/" << (int)r.qualityOffset;
+}
+
+static
+string s_str( const String& s )
+{
+    return s.addr == nullptr ? string() : string( s.addr, s.size );
+}
+
+static
+double s_parse( KDirectory* wd, const string& path, FASTQQualityFormat format, bool ignoreSpotGroups, bool grammarOnly,
+                vector<ParsedRecord>& records )
+{
+    const ReaderFile* rf = nullptr;
+    if ( FastqReaderFileMake( & rf, wd, path.c_str(), format, 0, ignoreSpotGroups, false ) != 0 )
+        throw runtime_error( "Failed to open '" + path + "'" );
+    FastqReaderFileUseGrammarOnly( rf, grammarOnly );
+
+    records.clear();
+    auto start = chrono::steady_clock::now();
+    for (;;)
+    {
+        const Record* record = nullptr;
+        if ( ReaderFileGetRecord( rf, & record ) != 0 )
+            throw runtime_error( "ReaderFileGetRecord failed on '" + path + "'" );
+        if ( record == nullptr )
+            break;
+
+        ParsedRecord r;
+        const Rejected* rej = nullptr;
+        if ( RecordGetRejected( record, & rej ) == 0 && rej != nullptr )
+        {
+            const char* text = nullptr;
+            r.rejected = true;
+            RejectedGetError( rej, & text, & r.line, & r.column, & r.fatal );
+            r.message = text == nullptr ? string() : text;
+            RejectedRelease( rej );
+        }
+        else
+        {   /* white box: look at the fields as the writer will see them */
+            const FastqSequence& seq = ( ( const FastqRecord* ) record ) -> seq;
+            r.spotName = s_str( seq.spotname );
+            r.spotGroup = s_str( seq.spotgroup );
+            r.read = s_str( seq.read );
+            r.quality = s_str( seq.quality );
+            r.qualityOffset = seq.qualityAsciiOffset;
+            r.readNumber = seq.readnumber;
+            r.colorspace = seq.is_colorspace;
+            r.lowQuality = seq.lowQuality;
+        }
+        records.push_back( r );
+        RecordRelease( record );
+        if ( r.fatal )
+            break;
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    ReaderFileRelease( rf );
+    return elapsed.count();
+}
+
+/*--------------------------------------------------------------------------
+ * generated inputs
+ */
+
+static mt19937 s_rand( 20240607 );
+
+static
+string s_bases( size_t len, const char* alphabet = "ACGT" )
+{
+    size_t n = strlen( alphabet );
+    string s( len, 'N' );
+    for ( auto& ch : s )
+        ch = alphabet[ s_rand() % n ];
+    return s;
+}
+
+static
+string s_qualities( size_t len )
+{
+    string s( len, '!' );
+    for ( auto& ch : s )
+        ch = (char)( '#' + s_rand() % 40 );
+    return s;
+}
+
+static
+void s_record( ofstream& out, const string& defline, const string& read, const char* eol = "\n" )
+{
+    out << '@' << defline << eol << read << eol << '+' << eol << s_qualities( read.size() ) << eol;
+}
+
+static
+string s_generate( const string& kind, size_t records )
+{
+    string path = "fastq-scan-bench." + kind + ".fastq";
+    ofstream out( path, ios::binary );
+    for ( size_t i = 0; i < records; ++i )
+    {
+        unsigned x = s_rand() % 20000;
+        unsigned y = s_rand() % 200000;
+        unsigned tile = 1101 + ( i / 5000 ) % 16;
+        if ( kind == "illumina-casava" )
+        {
+            string defline = "HWI-ST1234:8:FC706VJ:2:" + to_string( tile ) + ":" + to_string( x ) + ":" + to_string( y ) +
+                             " " + to_string( 1 + i % 2 ) + ( i % 50 == 0 ? ":Y:" : ":N:" ) + "0:ATCACG";
+            s_record( out, defline, s_bases( 101, "ACGTACGTACGTN" ) );
+        }
+        else if ( kind == "illumina-old" )
+        {
+            string defline = "HWUSI-EAS100R:6:" + to_string( tile % 100 ) + ":" + to_string( x ) + ":" + to_string( y ) +
+                             "#" + ( i % 3 == 0 ? "0" : "ACGT" ) + "/" + to_string( 1 + i % 2 );
+            s_record( out, defline, s_bases( 76 ) );
+        }
+        else if ( kind == "sra" )
+        {
+            string defline = "SRR1234567." + to_string( i + 1 ) + " " + to_string( i + 1 ) + " length=150";
+            s_record( out, defline, s_bases( 150 ) );
+        }
+        else if ( kind == "454" )
+        {
+            string name = "GA8K3BT01" + s_bases( 5, "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789" );
+            size_t len = 200 + s_rand() % 300;
+            s_record( out, name + " length=" + to_string( len ) + " xy=" + to_string( x ) + "_" + to_string( y ), s_bases( len ) );
+        }
+        else if ( kind == "solid" )
+        {
+            string name = to_string( 1 + i / 1000 ) + "_" + to_string( x ) + "_" + to_string( y ) + "_F3";
+            s_record( out, name, s_bases( 1 ) + s_bases( 50, "0123" ) );
+        }
+        else if ( kind == "mixed" )
+        {   /* every third record has a shape that has to go through the grammar */
+            string defline = "read_" + to_string( i );
+            switch ( i % 6 )
+            {
+            case 0: s_record( out, defline, s_bases( 60 ), "\r\n" ); break;
+            case 3: s_record( out, defline + ":1:2:3:4#0/1 1:N:0:ACGT", s_bases( 60 ) ); break;
+            case 5: out << '>' << defline << "\n" << s_bases( 40 ) << "\n" << s_bases( 40 ) << "\n"; break;
+            default: s_record( out, defline + "/" + to_string( 1 + i % 2 ), s_bases( 60 ) ); break;
+            }
+        }
+        else
+            throw runtime_error( "unknown input kind " + kind );
+    }
+    return path;
+}
+
+static
+FASTQQualityFormat s_format( const string& name )
+{
+    if ( name == "PHRED_33" ) return FASTQphred33;
+    if ( name == "PHRED_64" ) return FASTQphred64;
+    if ( name == "LOGODDS" ) return FASTQlogodds;
+    throw runtime_error( "invalid quality format " + name );
+}
+
+int main( int argc, char* argv[] )
+{
+    size_t records = 200000;
+    FASTQQualityFormat format = FASTQphred33;
+    bool ignoreSpotGroups = false;
+    vector<string> files;
+    vector<string> generated;
+
+    try
+    {
+        for ( int i = 1; i < argc; ++i )
+        {
+            string arg = argv[i];
+            if ( arg == "-n" && i + 1 < argc )
+                records = strtoul( argv[++i], nullptr, 10 );
+            else if ( arg == "-q" && i + 1 < argc )
+                format = s_format( argv[++i] );
+            else if ( arg == "-g" )
+                ignoreSpotGroups = true;
+            else
+                files.push_back( arg );
+        }
+        if ( files.empty() )
+        {
+            for ( auto kind : { "illumina-casava", "illumina-old", "sra", "454", "solid", "mixed" } )
+                generated.push_back( s_generate( kind, records ) );
+            files = generated;
+        }
+
+        KDirectory* wd = nullptr;
+        if ( KDirectoryNativeDir( & wd ) != 0 )
+            throw runtime_error( "KDirectoryNativeDir failed" );
+
+        bool ok = true;
+        for ( auto& path : files )
+        {
+            vector<ParsedRecord> scanned;
+            vector<ParsedRecord> parsed;
+            double tScan = s_parse( wd, path, format, ignoreSpotGroups, false, scanned );
+            double tParse = s_parse( wd, path, format, ignoreSpotGroups, true, parsed );
+
+            ifstream in( path, ios::binary | ios::ate );
+            double mb = in.tellg() / 1048576.0;
+
+            size_t mismatches = 0;
+            if ( scanned.size() != parsed.size() )
+            {
+                cerr << path << ": " << scanned.size() << " records scanned, " << parsed.size() << " parsed" << endl;
+                ++mismatches;
+            }
+            for ( size_t i = 0; i < scanned.size() && i < parsed.size(); ++i )
+            {
+                if ( ! ( scanned[i] == parsed[i] ) && ++mismatches <= 5 )
+                {
+                    cerr << path << ": record " << i + 1 << " differs" << endl
+                         << "  scanner: " << scanned[i] << endl
+                         << "  grammar: " << parsed[i] << endl;
+                }
+            }
+            ok = ok && mismatches == 0;
+
+            cout << path << ": " << parsed.size() << " records, " << mb << " MB" << endl;
+            cout << "  scanner: " << tScan << " s, " << parsed.size() / tScan << " records/s, " << mb / tScan << " MB/s" << endl;
+            cout << "  grammar: " << tParse << " s, " << parsed.size() / tParse << " records/s, " << mb / tParse << " MB/s" << endl;
+            cout << "  speedup: " << tParse / tScan << ( mismatches == 0 ? "" : ", MISMATCH" ) << endl;
+        }
+
+        KDirectoryRelease( wd );
+        for ( auto& path : generated )
+            remove( path.c_str() );
+        return ok ? 0 : 1;
+    }
+    catch ( const exception& e )
+    {
+        cerr << e.what() << endl;
+        for ( auto& path : generated )
+            remove( path.c_str() );
+        return 2;
+    }
+}
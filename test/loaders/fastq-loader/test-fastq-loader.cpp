@@ -195,6 +195,43 @@ public:
         return ret;
     }
 
+    rc_t LoadPrefetched( const string & p_filename1, const string & p_contents1,
+                         const string & p_filename2, const string & p_contents2,
+                         bool archiveSecond = true )
+    {   // the second file is parsed while the first one is being archived
+        filename1 = p_filename1;
+        const ReaderFile* rf1 = CreateFile( p_filename1, p_contents1 );
+        filename2 = p_filename2;
+        const ReaderFile* rf2 = CreateFile( p_filename2, p_contents2 );
+
+        dbName = p_filename1+".db";
+        KDirectoryRemove(wd, true, dbName.c_str());
+
+        VDatabase* db;
+        THROW_ON_RC( VDBManagerCreateDB(mgr, &db, schema, DbType.c_str(), kcmInit + kcmMD5, dbName.c_str()) );
+
+        CommonWriter cw;
+        THROW_ON_RC( CommonWriterInit( &cw, mgr, db, &settings ) );
+
+        rc_t ret = CommonWriterPrefetch( &cw, rf2 );
+        if ( ret == 0 )
+            ret = CommonWriterArchive( &cw, rf1, nullptr );
+        if ( ret == 0 && archiveSecond )
+            ret = CommonWriterArchive( &cw, rf2, nullptr );
+
+        THROW_ON_RC( CommonWriterComplete( &cw, false, 0 ) );
+
+        THROW_ON_RC( CommonWriterWhack( &cw ) );
+
+        // close database so that it can be reopened for inspection
+        THROW_ON_RC( VDatabaseRelease(db) );
+
+        THROW_ON_RC( ReaderFileRelease( rf1 ) );
+        THROW_ON_RC( ReaderFileRelease( rf2 ) );
+
+        return ret;
+    }
+
     void OpenReadCursor()
     {   // read cursor with 1 column, READ
         const VDatabase * db;
@@ -381,6 +418,45 @@ FIXTURE_TEST_CASE(Interleaved_2_longer, TempFileFixture)
     REQUIRE_EQ( string( "G" ), GetRead( 2 ) );
 }
 
+// parsing ahead of the spot assembler
+
+FIXTURE_TEST_CASE(Prefetched_KeepsFileOrder, TempFileFixture)
+{
+    settings.numfiles = 2;
+    REQUIRE_RC( LoadPrefetched(
+                string( GetName() ) + ".1",
+                "@READ1/1\nA\n+\nF\n"
+                "@READ2/1\nC\n+\nF\n"
+                "@READ4\nG\n+\nF\n"
+                ,
+                string( GetName() ) + ".2",
+                "@READ2/2\nG\n+\nF\n"
+                "@READ3\nC\n+\nF\n"
+                "@READ1/2\nT\n+\nF\n"
+    ) );
+    OpenReadCursor();
+    REQUIRE_EQ( string( "G" ), GetRead( 1 ) );  // READ4, the only complete spot in the first file
+    REQUIRE_EQ( string( "CG" ), GetRead( 2 ) ); // READ2 pairs first in the second file
+    REQUIRE_EQ( string( "C" ), GetRead( 3 ) );  // READ3
+    REQUIRE_EQ( string( "AT" ), GetRead( 4 ) ); // READ1
+}
+
+FIXTURE_TEST_CASE(Prefetched_NotArchived, TempFileFixture)
+{   // the parser of a file that is never archived is stopped by CommonWriterComplete
+    string contents;
+    for ( int i = 0; i < 10000; ++i )
+    {
+        contents += "@READ" + to_string( i ) + "\nACGT\n+\nFFFF\n";
+    }
+    REQUIRE_RC( LoadPrefetched(
+                string( GetName() ) + ".1", "@READ1\nC\n+\nF\n",
+                string( GetName() ) + ".2", contents,
+                false
+    ) );
+    OpenReadCursor();
+    REQUIRE_EQ( string( "C" ), GetRead( 1 ) );
+}
+
 //////////////////////////////////////////// Main
 #include <kapp/args.h>
 #include <kfg/config.h>
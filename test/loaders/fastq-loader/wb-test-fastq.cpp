@@ -281,6 +281,37 @@ FIXTURE_TEST_CASE(SyntaxError2, LoaderFixture)
     #undef input
 }
 
+FIXTURE_TEST_CASE(SyntaxError_BetweenGoodRecords, LoaderFixture)
+{   // the lexer has to pick up where the direct scanner left off, and the other way around
+    CreateFileGetRecord(GetName(),
+        "@SEQ_ID1\n" "GATT\n" "+\n" "!''*\n"
+        "qqq abcd\n"
+        "@SEQ_ID2\n" "ACGT\n" "+\n" "!''*\n"
+        "qqq abcd\n"
+        "@SEQ_ID3\n" "TTTT\n" "+\n" "!''*\n" );
+    REQUIRE(! GetRejected());
+
+    REQUIRE(GetRecord());
+    REQUIRE(GetRejected());
+    REQUIRE_EQ(errorLine, (uint64_t)5);
+
+    REQUIRE(GetRecord());
+    REQUIRE(! GetRejected());
+    REQUIRE_RC(RecordGetSequence(record, &seq));
+    REQUIRE_RC(SequenceGetSpotName(seq, &name, &length));
+    REQUIRE_EQ(string("SEQ_ID2"), string(name, length));
+
+    REQUIRE(GetRecord());
+    REQUIRE(GetRejected());
+    REQUIRE_EQ(errorLine, (uint64_t)10);
+
+    REQUIRE(GetRecord());
+    REQUIRE(! GetRejected());
+    REQUIRE_RC(RecordGetSequence(record, &seq));
+    REQUIRE_RC(SequenceGetSpotName(seq, &name, &length));
+    REQUIRE_EQ(string("SEQ_ID3"), string(name, length));
+}
+
 FIXTURE_TEST_CASE(RecoveryFromErrorAtTopLevel, LoaderFixture)
 {
     CreateFileGetRecord(GetName(), "qqq abcd\n" "@SEQ_ID1\n" "GATT\n" "+\n" "!''*\n");
@@ -0,0 +1,153 @@
+/*===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+
+/**
+* Defline classification benchmark for SHARQ
+*
+* Reads deflines from FASTQ files and times, per defline type, the classification
+* by probing the matchers one by one against the compiled classifier of CDefLineParser.
+* Fails if the two ever disagree.
+*
+* Usage: defline-bench [-r repeat] file...
+*/
+#include <cassert>
+#include "../../../tools/loaders/sharq/fastq_utils.hpp"
+#include "../../../tools/loaders/sharq/fastq_defline_parser.hpp"
+#include "../../../tools/loaders/sharq/bxzstr/bxzstr.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const string Unrecognized = "<unrecognized>";
+
+static
+void s_load_deflines(const string& path, vector<string>& deflines)
+{
+    bxz::ifstream in(path);
+    if (!in)
+        throw runtime_error("Failed to open '" + path + "'");
+    string line;
+    for (size_t n = 0; getline(in, line); ++n) {
+        // assume 4-line FASTQ records
+        if (n % 4 == 0 && !line.empty())
+            deflines.push_back(line);
+    }
+}
+
+/// The old way: probe registered matchers in order until one matches
+static
+const string& s_classify_sequential(CDefLineParser& parser, const string& defline)
+{
+    const auto& matchers = parser.GetDeflineMatchers();
+    for (size_t i = 1; i < matchers.size(); ++i) {
+        if (matchers[i]->Matches(defline))
+            return matchers[i]->Defline();
+    }
+    return Unrecognized;
+}
+
+/// Compiled classifier, Reset() drops the last match so that every defline is classified from scratch
+static
+const string& s_classify_compiled(CDefLineParser& parser, const string& defline)
+{
+    parser.Reset();
+    if (parser.Match(defline))
+        return parser.GetDeflineType();
+    return Unrecognized;
+}
+
+template<typename F>
+static
+double s_time_ns(const vector<const string*>& deflines, size_t repeat, F&& classify)
+{
+    auto start = chrono::steady_clock::now();
+    for (size_t r = 0; r < repeat; ++r) {
+        for (auto d : deflines)
+            classify(*d);
+    }
+    chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+    return deflines.empty() ? 0 : elapsed.count() / (deflines.size() * repeat);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t repeat = 10;
+    vector<string> deflines;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            string arg = argv[i];
+            if (arg == "-r" && i + 1 < argc)
+                repeat = max(1, atoi(argv[++i]));
+            else
+                s_load_deflines(arg, deflines);
+        }
+    } catch (exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    if (deflines.empty()) {
+        cerr << "Usage: " << argv[0] << " [-r repeat] file..." << endl;
+        return 1;
+    }
+
+    CDefLineParser sequential;
+    CDefLineParser compiled;
+
+    // group deflines by type, checking that both classifications agree
+    map<string, vector<const string*>> by_type;
+    size_t mismatches = 0;
+    for (const auto& d : deflines) {
+        const string& expected = s_classify_sequential(sequential, d);
+        const string& actual = s_classify_compiled(compiled, d);
+        if (expected != actual) {
+            cerr << "Mismatch: '" << d << "' " << expected << " vs " << actual << endl;
+            ++mismatches;
+        }
+        by_type[expected].push_back(&d);
+    }
+
+    vector<const string*> all;
+    for (const auto& d : deflines)
+        all.push_back(&d);
+    by_type["<all>"] = all;
+
+    cout << fmt::format("{:<30}{:>10}{:>16}{:>16}{:>10}", "Defline type", "Count", "Sequential ns", "Compiled ns", "Speedup") << "\n";
+    for (const auto& it : by_type) {
+        double seq_ns = s_time_ns(it.second, repeat, [&](const string& d) { s_classify_sequential(sequential, d); });
+        double cmp_ns = s_time_ns(it.second, repeat, [&](const string& d) { s_classify_compiled(compiled, d); });
+        cout << fmt::format("{:<30}{:>10}{:>16.0f}{:>16.0f}{:>9.1f}x", it.first, it.second.size(), seq_ns, cmp_ns, cmp_ns > 0 ? seq_ns / cmp_ns : 0) << "\n";
+    }
+
+    if (mismatches != 0) {
+        cerr << mismatches << " deflines classified differently" << endl;
+        return 2;
+    }
+    return 0;
+}
@@ -31,6 +31,8 @@
 
 #include <ktst/unit_test.hpp>
 
+#include <algorithm>
+
 using namespace std;
 
 TEST_SUITE(RegexprTestSuite);
@@ -73,6 +75,38 @@ TEST_CASE(YesMatch)
     REQUIRE_EQ( string(""), m.GetMatch()[10].as_string() );
 }
 
+TEST_CASE(SetNoMatch)
+{
+    CRegExprSet s;
+    s.Add( "^qq" );
+    s.Add( "zz$" );
+    s.Compile();
+    vector<int> matches;
+    REQUIRE( s.Match( "aqqzza", matches ) );
+    REQUIRE( matches.empty() );
+}
+
+TEST_CASE(SetYesMatch)
+{
+    CRegExprSet s;
+    REQUIRE_EQ( 0, s.Add( "^qq" ) );
+    REQUIRE_EQ( 1, s.Add( "zz$" ) );
+    REQUIRE_EQ( 2, s.Add( "a" ) );
+    s.Compile();
+    vector<int> matches;
+    REQUIRE( s.Match( "qqzz", matches ) );
+    sort( matches.begin(), matches.end() );
+    REQUIRE_EQ( size_t( 2 ), matches.size() );
+    REQUIRE_EQ( 0, matches[0] );
+    REQUIRE_EQ( 1, matches[1] );
+}
+
+TEST_CASE(SetInvalidPattern)
+{
+    CRegExprSet s;
+    REQUIRE_THROW( s.Add( "(qq" ) );
+}
+
 int main (int argc, char *argv [])
 {
     return RegexprTestSuite(argc, argv);
@@ -0,0 +1,198 @@
+/*===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+*/
+
+/**
+* Unit tests for SHARQ loader's in-process VDB writer
+*/
+
+#include "../../../tools/loaders/sharq/fastq_writer_direct.hpp"
+
+#include <ktst/unit_test.hpp>
+
+#include <kfs/directory.h>
+#include <kdb/meta.h>
+#include <vdb/manager.h>
+#include <vdb/database.h>
+#include <vdb/table.h>
+#include <vdb/cursor.h>
+
+using namespace std;
+
+TEST_SUITE(SharQDirectWriterTestSuite);
+
+class DirectWriterFixture
+{
+public:
+    const string Dest = "test-sharq-direct-writer.sra";
+
+    DirectWriterFixture()
+    {
+        KDirectoryNativeDir(&m_wd);
+        KDirectoryRemove(m_wd, true, "%s", Dest.c_str());
+        m_w.set_attr("destination", Dest);
+        m_w.set_attr("include_paths", VDB_SCHEMA_DIR);
+        m_w.set_attr("version", "1.2.3");
+    }
+    ~DirectWriterFixture()
+    {
+        VCursorRelease(m_cursor);
+        VTableRelease(m_table);
+        VDatabaseRelease(m_db);
+        VDBManagerRelease(m_mgr);
+        KDirectoryRemove(m_wd, true, "%s", Dest.c_str());
+        KDirectoryRelease(m_wd);
+    }
+
+    static void Check(rc_t rc)
+    {
+        if (rc != 0)
+            throw logic_error("VDB call failed");
+    }
+    static CFastqRead Read(const string& spot, const string& sequence, const string& quality)
+    {
+        CFastqRead read;
+        read.SetSpot(spot);
+        read.SetSequence(sequence);
+        read.SetQualScores(vector<uint8_t>(quality.begin(), quality.end()));
+        read.SetType(CFastqRead::SRA_READ_TYPE_BIOLOGICAL);
+        return read;
+    }
+
+    void OpenRead(const vector<string>& columns)
+    {
+        Check(VDBManagerMakeRead(&m_mgr, nullptr));
+        Check(VDBManagerOpenDBRead(m_mgr, &m_db, nullptr, "%s", Dest.c_str()));
+        Check(VDatabaseOpenTableRead(m_db, &m_table, "SEQUENCE"));
+        Check(VTableCreateCursorRead(m_table, &m_cursor));
+        m_idx.resize(columns.size());
+        for (size_t i = 0; i < columns.size(); ++i)
+            Check(VCursorAddColumn(m_cursor, &m_idx[i], "%s", columns[i].c_str()));
+        Check(VCursorOpen(m_cursor));
+    }
+
+    template<typename T>
+    vector<T> Cell(int64_t row, size_t column)
+    {
+        const void* base = nullptr;
+        uint32_t elem_bits = 0;
+        uint32_t boff = 0;
+        uint32_t row_len = 0;
+        Check(VCursorCellDataDirect(m_cursor, row, m_idx[column], &elem_bits, &base, &boff, &row_len));
+        if (elem_bits != sizeof(T) * 8 || boff != 0)
+            throw logic_error("unexpected cell layout");
+        auto data = static_cast<const T*>(base);
+        return vector<T>(data, data + row_len);
+    }
+    string Text(int64_t row, size_t column)
+    {
+        auto cell = Cell<char>(row, column);
+        return string(cell.begin(), cell.end());
+    }
+
+    fastq_writer_vdb_direct m_w;
+    KDirectory* m_wd = nullptr;
+    const VDBManager* m_mgr = nullptr;
+    const VDatabase* m_db = nullptr;
+    const VTable* m_table = nullptr;
+    const VCursor* m_cursor = nullptr;
+    vector<uint32_t> m_idx;
+};
+
+FIXTURE_TEST_CASE(DirectWriter_ReadBack, DirectWriterFixture)
+{
+    m_w.open();
+    m_w.write_spot("spot1", { Read("spot1", "ACGT", "5555") });
+    m_w.write_spot("spot2", { Read("spot2", "GGCCA", "?????"), Read("spot2", "TTA", "+++") });
+    m_w.write_spot("spot3", { Read("spot3", "N", "!") });
+    m_w.close();
+
+    OpenRead({ "READ", "(INSDC:quality:text:phred_33)QUALITY", "READ_LEN", "READ_START", "PLATFORM" });
+
+    int64_t first = 0;
+    uint64_t count = 0;
+    REQUIRE_RC(VCursorIdRange(m_cursor, m_idx[0], &first, &count));
+    REQUIRE_EQ((int64_t)1, first);
+    REQUIRE_EQ((uint64_t)3, count);
+
+    REQUIRE_EQ(string("ACGT"), Text(1, 0));
+    REQUIRE_EQ(string("GGCCATTA"), Text(2, 0));
+    REQUIRE_EQ(string("N"), Text(3, 0));
+
+    REQUIRE_EQ(string("5555"), Text(1, 1));
+    REQUIRE_EQ(string("?????+++"), Text(2, 1));
+
+    auto read_len = Cell<uint32_t>(1, 2);
+    REQUIRE_EQ((size_t)1, read_len.size());
+    REQUIRE_EQ((uint32_t)4, read_len[0]);
+    read_len = Cell<uint32_t>(2, 2);
+    REQUIRE_EQ((size_t)2, read_len.size());
+    REQUIRE_EQ((uint32_t)5, read_len[0]);
+    REQUIRE_EQ((uint32_t)3, read_len[1]);
+    auto read_start = Cell<int32_t>(2, 3);
+    REQUIRE_EQ((size_t)2, read_start.size());
+    REQUIRE_EQ((int32_t)0, read_start[0]);
+    REQUIRE_EQ((int32_t)5, read_start[1]);
+
+    // PLATFORM is written once as the column default
+    for (int64_t row = 1; row <= 3; ++row) {
+        auto platform = Cell<uint8_t>(row, 4);
+        REQUIRE_EQ((size_t)1, platform.size());
+        REQUIRE_EQ((int)SRA_PLATFORM_UNDEFINED, (int)platform[0]);
+    }
+}
+
+FIXTURE_TEST_CASE(DirectWriter_LoaderVersion, DirectWriterFixture)
+{
+    m_w.open();
+    m_w.write_spot("spot1", { Read("spot1", "ACGT", "5555") });
+    m_w.close();
+
+    OpenRead({ "READ" });
+
+    const KMetadata* meta = nullptr;
+    REQUIRE_RC(VDatabaseOpenMetadataRead(m_db, &meta));
+    const KMDataNode* node = nullptr;
+    REQUIRE_RC(KMetadataOpenNodeRead(meta, &node, "SOFTWARE/formatter"));
+    char buf[64];
+    size_t size = 0;
+    REQUIRE_RC(KMDataNodeReadAttr(node, "vers", buf, sizeof(buf), &size));
+    REQUIRE_EQ(string("1.2.3"), string(buf, size));
+    REQUIRE_RC(KMDataNodeReadAttr(node, "name", buf, sizeof(buf), &size));
+    REQUIRE_EQ(string("sharq"), string(buf, size));
+    KMDataNodeRelease(node);
+    KMetadataRelease(meta);
+}
+
+FIXTURE_TEST_CASE(DirectWriter_BadLoaderVersion, DirectWriterFixture)
+{
+    m_w.set_attr("version", "1.x");
+    REQUIRE_THROW(m_w.open());
+}
+
+int main (int argc, char *argv [])
+{
+    return SharQDirectWriterTestSuite(argc, argv);
+}
@@ -1222,6 +1222,135 @@ FIXTURE_TEST_CASE(illuminaOldBcOnly, LoaderFixture)
     REQUIRE(read.ReadNum().empty());
 }
 
+static string s_ReadAll(istream& is)
+{
+    is.exceptions(std::ifstream::badbit);
+    string out;
+    char buf[4096];
+    while (is.read(buf, sizeof(buf)) || is.gcount() > 0)
+        out.append(buf, is.gcount());
+    return out;
+}
+
+FIXTURE_TEST_CASE(ParallelInflateGzip, LoaderFixture)
+{
+    const string fn("input/003.t2_R1.fastq.gz");
+    REQUIRE(sharq::parallel_inflate_streambuf::detect(fn) == sharq::parallel_inflate_streambuf::eGzip);
+    bxz::ifstream expected(fn);
+    sharq::parallel_ifstream actual(fn, 4);
+    REQUIRE_EQ(s_ReadAll(actual), s_ReadAll(expected));
+    REQUIRE(actual.compression() == bxz::z);
+}
+
+FIXTURE_TEST_CASE(ParallelInflateBzip2, LoaderFixture)
+{
+    const string fn("input/003.t3_R1.fastq.bz2");
+    REQUIRE(sharq::parallel_inflate_streambuf::detect(fn) == sharq::parallel_inflate_streambuf::eBzip2);
+    bxz::ifstream expected(fn);
+    sharq::parallel_ifstream actual(fn, 4);
+    REQUIRE_EQ(s_ReadAll(actual), s_ReadAll(expected));
+    REQUIRE(actual.compression() == bxz::bz2);
+}
+
+static string s_ReadFile(const string& fn)
+{
+    ifstream in(fn, ios::binary);
+    return s_ReadAll(in);
+}
+
+// the 016 inputs hold 015.R1.fq; small jobs make several of them out of these small files
+static const size_t s_SmallJob = 1024;
+
+FIXTURE_TEST_CASE(ParallelInflateBgzf, LoaderFixture)
+{   // BGZF blocks of 1000 bytes each, ending with the empty EOF block
+    const string fn("input/016.bgzf_R1.fq.gz");
+    REQUIRE(sharq::parallel_inflate_streambuf::detect(fn) == sharq::parallel_inflate_streambuf::eGzip);
+    sharq::parallel_ifstream actual(fn, 4, 64 * 1024, s_SmallJob);
+    REQUIRE_EQ(s_ReadAll(actual), s_ReadFile("input/015.R1.fq"));
+}
+
+FIXTURE_TEST_CASE(ParallelInflateBzip2MultiStream, LoaderFixture)
+{   // pbzip2-like: a bzip2 stream for every 2000 bytes, split into jobs at the stream headers
+    const string fn("input/016.multistream_R1.fq.bz2");
+    REQUIRE(sharq::parallel_inflate_streambuf::detect(fn) == sharq::parallel_inflate_streambuf::eBzip2);
+    sharq::parallel_ifstream actual(fn, 4, 64 * 1024, s_SmallJob);
+    REQUIRE_EQ(s_ReadAll(actual), s_ReadFile("input/015.R1.fq"));
+}
+
+FIXTURE_TEST_CASE(ParallelInflateFalseSplit, LoaderFixture)
+{   // block 7 claims the size of blocks 7 and 8 together: its job fails,
+    // and the rest of the file is inflated sequentially from the start of that job
+    const string fn("input/016.bad_bsize_R1.fq.gz");
+    sharq::parallel_ifstream actual(fn, 4, 64 * 1024, s_SmallJob);
+    REQUIRE_EQ(s_ReadAll(actual), s_ReadFile("input/015.R1.fq"));
+}
+
+FIXTURE_TEST_CASE(ParallelInflateTruncated, LoaderFixture)
+{
+    sharq::parallel_ifstream actual("input/004.truncated_1.fq.gz", 4);
+    REQUIRE_THROW(s_ReadAll(actual));
+}
+
+FIXTURE_TEST_CASE(ParallelInflatePlainText, LoaderFixture)
+{
+    REQUIRE(sharq::parallel_inflate_streambuf::detect("input/001.R1.fastq") == sharq::parallel_inflate_streambuf::eUnknown);
+    REQUIRE(dynamic_cast<bxz::ifstream*>(s_OpenStream("input/001.R1.fastq", 1024, 4).get()) != nullptr);
+    REQUIRE(dynamic_cast<sharq::parallel_ifstream*>(s_OpenStream("input/003.t2_R1.fastq.gz", 1024, 4).get()) != nullptr);
+}
+
+FIXTURE_TEST_CASE(ColdStoreSpillReload, LoaderFixture)
+{
+    cold_store_t<svector_u32> store;
+    store.set_spill_prefix("cold_store.tmp");
+    const size_t num_values = COLD_PAGE_SIZE * 2 + 100;
+    vector<unsigned> buf(1000);
+    for (size_t offset = 0; offset < num_values; offset += buf.size()) {
+        for (size_t i = 0; i < buf.size(); ++i) 
+            buf[i] = (offset + i) % 5;
+        store.import(buf.data(), buf.size(), offset);
+    }
+    store.optimize();
+    REQUIRE(store.spill(numeric_limits<size_t>::max()) > 0);
+    REQUIRE_EQ(store.spilled_pages(), (size_t)2);
+
+    // clear values of the spilled page, they are applied on reload
+    uint64_t range = (uint64_t(10) << 48) | (COLD_PAGE_SIZE + 5);
+    store.clear_ranges(&range, 1);
+    vector<unsigned> out(20);
+    store.decode(out.data(), COLD_PAGE_SIZE - 10, out.size());
+    for (size_t i = 0; i < out.size(); ++i) {
+        size_t offset = COLD_PAGE_SIZE - 10 + i;
+        bool cleared = offset >= COLD_PAGE_SIZE + 5 && offset < COLD_PAGE_SIZE + 15;
+        REQUIRE_EQ(out[i], cleared ? 0u : unsigned(offset % 5));
+    }
+    REQUIRE_EQ(store.spilled_pages(), (size_t)0);
+}
+
+FIXTURE_TEST_CASE(NameHashSorterRuns, LoaderFixture)
+{
+    vector<string> names;
+    for (int i = 0; i < 10000; ++i) 
+        names.push_back("spot" + to_string((i * 7919) % 4000));
+    name_hash_sorter_t sorter;
+    sorter.init("name_hashes.tmp", 1000); // 10 sorted runs 
+    for (const auto& name : names)
+        sorter.add(name);
+    sorter.flush();
+    REQUIRE_EQ(sorter.size(), names.size());
+    size_t num_spots = 0, num_rows = 0;
+    bool same_names = true;
+    sorter.for_each_spot([&](const vector<uint64_t>& rows) {
+        ++num_spots;
+        num_rows += rows.size();
+        same_names = same_names && is_sorted(rows.begin(), rows.end());
+        for (auto row : rows) 
+            same_names = same_names && names[row] == names[rows.front()];
+    });
+    REQUIRE(same_names);
+    REQUIRE_EQ(num_spots, (size_t)4000);
+    REQUIRE_EQ(num_rows, names.size());
+}
+
 ////////////////////////////////////////////
 
 int main (int argc, char *argv [])
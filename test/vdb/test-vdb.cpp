@@ -315,6 +315,100 @@ FIXTURE_TEST_CASE(Cursor_IsStaticColumn_False, SequenceTableFixture)
     REQUIRE( ! c.isStaticColumn( 1 ) );
 }
 
+FIXTURE_TEST_CASE(Cursor_Clone, SequenceTableFixture)
+{
+    Cursor c = t.read( {"READ", "NAME"} );
+    Cursor cc = c.clone();
+    REQUIRE_EQ( 2u, cc.columns() );
+    REQUIRE( c.rowRange() == cc.rowRange() );
+    REQUIRE_EQ( string("2"), cc.read( 2, 1 ).asString() );
+}
+
+FIXTURE_TEST_CASE(Cursor_ForEachBlob, SequenceTableFixture)
+{
+    Cursor c = t.read( {"READ", "NAME"} );
+    Cursor::RowID expected = 1;
+    auto check = [&](Cursor::RowID row, const vector<Cursor::RawData>& values )
+    {
+        REQUIRE_EQ( expected, row );
+        ++expected;
+        REQUIRE_LT( (size_t)0, values[0].asString().size() );
+        ostringstream rowId;
+        rowId << row;
+        REQUIRE_EQ( rowId.str(), values[1].asString() );
+    };
+    uint64_t n = c.foreachBlob( check );
+    REQUIRE_EQ( (uint64_t)2607, n );
+}
+
+FIXTURE_TEST_CASE(Cursor_ForEachBlob_Range, SequenceTableFixture)
+{
+    Cursor c = t.read( {"READ", "NAME"} );
+    auto check = [&](Cursor::RowID row, const vector<Cursor::RawData>& values )
+    {
+        REQUIRE_EQ( c.read( row, 0 ).asString(), values[0].asString() );
+    };
+    uint64_t n = c.foreachBlob( 1000, 1100, check );
+    REQUIRE_EQ( (uint64_t)100, n );
+}
+
+FIXTURE_TEST_CASE(Cursor_ParallelForEach, SequenceTableFixture)
+{
+    Cursor c = t.read( {"SPOT_LEN", "NAME"} );
+
+    uint64_t expectedBases = 0;
+    c.foreach( [&](Cursor::RowID, const vector<Cursor::RawData>& values )
+    {
+        expectedBases += values[0].value<uint32_t>();
+    } );
+
+    typedef pair< uint64_t, uint64_t > Acc; // rows, bases
+    auto count = [](Acc & acc, Cursor::RowID row, const vector<Cursor::RawData>& values )
+    {
+        ostringstream rowId;
+        rowId << row;
+        if ( rowId.str() != values[1].asString() )
+            throw logic_error( "wrong row" );
+        acc.first += 1;
+        acc.second += values[0].value<uint32_t>();
+    };
+    auto merge = [](Acc & total, const Acc & part )
+    {
+        total.first += part.first;
+        total.second += part.second;
+    };
+
+    Acc acc = c.parallel_foreach<Acc>( 4, count, merge );
+    REQUIRE_EQ( (uint64_t)2607, acc.first );
+    REQUIRE_EQ( expectedBases, acc.second );
+
+    acc = c.parallel_foreach<Acc>( 1, count, merge );
+    REQUIRE_EQ( (uint64_t)2607, acc.first );
+    REQUIRE_EQ( expectedBases, acc.second );
+}
+
+FIXTURE_TEST_CASE(Cursor_ParallelForEach_Ordered, SequenceTableFixture)
+{   // the parts are merged in row order
+    Cursor c = t.read( {"NAME"} );
+    typedef vector< Cursor::RowID > Acc;
+    Acc rows = c.parallel_foreach<Acc>( 0,
+        [](Acc & acc, Cursor::RowID row, const vector<Cursor::RawData>& ) { acc.push_back( row ); },
+        [](Acc & total, const Acc & part ) { total.insert( total.end(), part.begin(), part.end() ); } );
+    REQUIRE_EQ( size_t(2607), rows.size() );
+    for ( size_t i = 0; i < rows.size(); ++i )
+    {
+        REQUIRE_EQ( Cursor::RowID( i + 1 ), rows[i] );
+    }
+}
+
+FIXTURE_TEST_CASE(Cursor_ParallelForEach_Throws, SequenceTableFixture)
+{
+    Cursor c = t.read( {"NAME"} );
+    REQUIRE_THROW( c.parallel_foreach<int>( 4,
+        [](int &, Cursor::RowID row, const vector<Cursor::RawData>& ) { if ( row == 2000 ) throw logic_error( "stop" ); },
+        [](int &, const int & ) {} ) );
+}
+
 // VDB::Cursor::RawData
 
 FIXTURE_TEST_CASE( RawData_asVector_badCast, SequenceTableFixture )
@@ -334,6 +428,24 @@ FIXTURE_TEST_CASE( RawData_asVector, SequenceTableFixture )
     REQUIRE_EQ( uint32_t(301), cv[1] );
 }
 
+FIXTURE_TEST_CASE( RawData_span_badCast, SequenceTableFixture )
+{
+    Cursor c = t.read( {"READ_START", "NAME"} );
+    Cursor::RawData rd = c.read( 1, 0 );
+    REQUIRE_THROW( rd.span<uint16_t>() );
+}
+
+FIXTURE_TEST_CASE( RawData_span, SequenceTableFixture )
+{
+    Cursor c = t.read( {"READ_START", "NAME"} );
+    Cursor::RawData rd = c.read( 1, 0 );
+    Span<uint32_t> cv = rd.span<uint32_t>();
+    REQUIRE_EQ( size_t(2), cv.size() );
+    REQUIRE( (const void*)cv.data() == rd.data );
+    REQUIRE_EQ( uint32_t(0), cv[0] );
+    REQUIRE_EQ( uint32_t(301), *( cv.begin() + 1 ) );
+}
+
 FIXTURE_TEST_CASE( RawData_value_badCast, SequenceTableFixture )
 {
     Cursor c = t.read( {"SPOT_LEN", "NAME"} );
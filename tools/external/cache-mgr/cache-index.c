@@ -0,0 +1,986 @@
+/*===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+*/
+
+#include "cache-index.h"
+
+#include <klib/log.h>
+#include <klib/text.h>
+#include <klib/printf.h>
+#include <klib/namelist.h>
+#include <klib/rc.h>
+
+#include <kfs/directory.h>
+#include <kfs/file.h>
+#include <kfs/cacheteefile.h>
+
+#include <kproc/thread.h>
+#include <kproc/lock.h>
+#include <kproc/cond.h>
+
+#include <sysalloc.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    the index-file ( all numbers little-endian ):
+
+    header : magic[ 8 ], u32 version, u32 dir-count
+    dir    : u16 path-len, path, u64 mtime, u32 entry-count
+    entry  : u16 name-len, name, u8 flags
+             for *.cache and *.sra followed by u64 size, u64 used, u64 mtime, u16 completeness
+
+    a directory is listed again if its modification-time differs from the one in the index,
+    the cache-tee-file creates/removes a *.lock next to a file it is downloading,
+    that is why a directory with a growing *.cache in it does not keep its old time
+*/
+
+static const char index_magic[ 8 ] = { 'N', 'C', 'B', 'I', 'c', 'm', 'g', 'r' };
+#define INDEX_VERSION 1
+
+#define MAX_PATH_LEN 4096
+
+
+static rc_t out_of_memory( void )
+{
+    return RC( rcExe, rcStorage, rcAllocating, rcMemory, rcExhausted );
+}
+
+
+static rc_t join_path( char * buffer, size_t bsize, const char * root, const char * path, const char * name )
+{
+    rc_t rc;
+    size_t num_writ;
+    if ( path[ 0 ] == 0 )
+    {
+        if ( name == NULL )
+            rc = string_printf( buffer, bsize, &num_writ, "%s", root );
+        else
+            rc = string_printf( buffer, bsize, &num_writ, "%s/%s", root, name );
+    }
+    else
+    {
+        if ( name == NULL )
+            rc = string_printf( buffer, bsize, &num_writ, "%s/%s", root, path );
+        else
+            rc = string_printf( buffer, bsize, &num_writ, "%s/%s/%s", root, path, name );
+    }
+    return rc;
+}
+
+
+static bool ends_in( const char * str, const char * end )
+{
+    size_t l_str = strlen( str );
+    size_t l_end = strlen( end );
+    return ( l_str >= l_end && memcmp( str + l_str - l_end, end, l_end ) == 0 );
+}
+
+
+static int cmp_entry( const void * a, const void * b )
+{
+    const cache_entry * ea = a;
+    const cache_entry * eb = b;
+    return strcmp( ea->name, eb->name );
+}
+
+
+static int cmp_dir( const void * a, const void * b )
+{
+    const cache_dir * const * da = a;
+    const cache_dir * const * db = b;
+    return strcmp( ( *da )->path, ( *db )->path );
+}
+
+
+static const cache_entry * find_entry( const cache_dir * self, const char * name )
+{
+    cache_entry key;
+    if ( self == NULL || self->count == 0 )
+        return NULL;
+    key.name = ( char * )name;
+    return bsearch( &key, self->entries, self->count, sizeof self->entries[ 0 ], cmp_entry );
+}
+
+
+static int64_t find_dir( const cache_index * self, const char * path )
+{
+    cache_dir key, * kp = &key, ** found;
+    if ( self->dir_count == 0 )
+        return -1;
+    key.path = ( char * )path;
+    found = bsearch( &kp, self->dirs, self->dir_count, sizeof self->dirs[ 0 ], cmp_dir );
+    return ( found == NULL ) ? -1 : ( found - self->dirs );
+}
+
+
+static void cache_dir_release( cache_dir * self )
+{
+    if ( self != NULL )
+    {
+        uint32_t idx;
+        for ( idx = 0; idx < self->count; ++idx )
+            free( self->entries[ idx ].name );
+        free( self->entries );
+        free( self->path );
+        free( self );
+    }
+}
+
+
+static void release_dirs( cache_index * self )
+{
+    uint32_t idx;
+    for ( idx = 0; idx < self->dir_count; ++idx )
+        cache_dir_release( self->dirs[ idx ] );
+    free( self->dirs );
+    self->dirs = NULL;
+    self->dir_count = 0;
+}
+
+
+void cache_index_release( cache_index * self )
+{
+    release_dirs( self );
+    free( self->root );
+    self->root = NULL;
+}
+
+
+bool cache_dir_entry_locked( const cache_dir * self, const cache_entry * entry )
+{
+    char lock_name[ MAX_PATH_LEN ];
+    size_t num_writ;
+    const cache_entry * lock;
+    if ( string_printf( lock_name, sizeof lock_name, &num_writ, "%s.lock", entry->name ) != 0 )
+        return false;
+    lock = find_entry( self, lock_name );
+    return ( lock != NULL && ( lock->flags & CIE_LOCK ) != 0 );
+}
+
+
+rc_t cache_dir_entry_remove( const cache_index * self, KDirectory * dir,
+                             cache_dir * cdir, cache_entry * entry )
+{
+    char path[ MAX_PATH_LEN ];
+    rc_t rc = join_path( path, sizeof path, self->root, cdir->path, entry->name );
+    if ( rc == 0 )
+        rc = KDirectoryRemove ( dir, false, "%s", path );
+    if ( rc != 0 )
+    {
+        PLOGERR( klogErr, ( klogErr, rc,
+                 "KDirectoryRemove( $(path) ) failed in $(func)", "path=%s/%s,func=%s", cdir->path, entry->name, __func__ ) );
+    }
+    else
+    {
+        entry->flags = 0;
+        cdir->mtime = 0;  /* changed by us just now: list it again next time */
+    }
+    return rc;
+}
+
+
+/***************************************************************************************************************/
+
+typedef struct index_reader
+{
+    const uint8_t * p;
+    const uint8_t * end;
+    bool ok;
+} index_reader;
+
+
+static uint64_t get_num( index_reader * r, uint32_t bytes )
+{
+    uint64_t res = 0;
+    uint32_t idx;
+    if ( !r->ok || ( size_t )( r->end - r->p ) < bytes )
+    {
+        r->ok = false;
+        return 0;
+    }
+    for ( idx = 0; idx < bytes; ++idx )
+        res |= ( ( uint64_t )r->p[ idx ] ) << ( idx * 8 );
+    r->p += bytes;
+    return res;
+}
+
+
+static char * get_str( index_reader * r )
+{
+    char * res = NULL;
+    uint32_t len = ( uint32_t )get_num( r, 2 );
+    if ( r->ok && ( size_t )( r->end - r->p ) < len )
+        r->ok = false;
+    if ( r->ok )
+    {
+        res = malloc( len + 1 );
+        if ( res == NULL )
+            r->ok = false;
+        else
+        {
+            memmove( res, r->p, len );
+            res[ len ] = 0;
+            r->p += len;
+        }
+    }
+    return res;
+}
+
+
+static bool parse_index( cache_index * self, const uint8_t * buf, size_t size )
+{
+    index_reader r;
+    uint32_t idx, count;
+
+    if ( size < sizeof index_magic || memcmp( buf, index_magic, sizeof index_magic ) != 0 )
+        return false;
+    r.p = buf + sizeof index_magic;
+    r.end = buf + size;
+    r.ok = true;
+    if ( get_num( &r, 4 ) != INDEX_VERSION )
+        return false;
+    count = ( uint32_t )get_num( &r, 4 );
+    /* every dir takes at least 14 bytes, do not trust a count the file cannot hold */
+    if ( !r.ok || count > ( size_t )( r.end - r.p ) / 14 )
+        return false;
+
+    self->dirs = calloc( count + 1, sizeof self->dirs[ 0 ] );
+    if ( self->dirs == NULL )
+        return false;
+
+    for ( idx = 0; idx < count && r.ok; ++idx )
+    {
+        cache_dir * cdir = calloc( 1, sizeof * cdir );
+        if ( cdir == NULL )
+            r.ok = false;
+        else
+        {
+            uint32_t e_idx, e_count;
+
+            self->dirs[ self->dir_count++ ] = cdir;
+            cdir->path = get_str( &r );
+            cdir->mtime = ( KTime_t )get_num( &r, 8 );
+            e_count = ( uint32_t )get_num( &r, 4 );
+            if ( r.ok && e_count > ( size_t )( r.end - r.p ) / 3 )
+                r.ok = false;
+            if ( r.ok )
+            {
+                cdir->entries = calloc( e_count + 1, sizeof cdir->entries[ 0 ] );
+                if ( cdir->entries == NULL )
+                    r.ok = false;
+            }
+            for ( e_idx = 0; e_idx < e_count && r.ok; ++e_idx )
+            {
+                cache_entry * e = &cdir->entries[ cdir->count++ ];
+                e->name = get_str( &r );
+                e->flags = ( uint32_t )get_num( &r, 1 );
+                if ( ( e->flags & ( CIE_CACHE | CIE_FULL ) ) != 0 )
+                {
+                    e->size = get_num( &r, 8 );
+                    e->used = get_num( &r, 8 );
+                    e->mtime = ( KTime_t )get_num( &r, 8 );
+                    e->completeness = ( uint32_t )get_num( &r, 2 );
+                }
+            }
+        }
+    }
+    /* it was written sorted, but a hand-edited or damaged file must not break the binary search */
+    if ( r.ok )
+    {
+        for ( idx = 1; idx < self->dir_count && r.ok; ++idx )
+            r.ok = ( cmp_dir( &self->dirs[ idx - 1 ], &self->dirs[ idx ] ) < 0 );
+    }
+    return r.ok;
+}
+
+
+rc_t cache_index_load( cache_index * self, const KDirectory * dir, const char * root )
+{
+    rc_t rc = 0;
+    uint32_t pt;
+
+    memset( self, 0, sizeof * self );
+    self->root = string_dup_measure( root, NULL );
+    if ( self->root == NULL )
+        return out_of_memory();
+
+    pt = ( KDirectoryPathType ( dir, "%s/%s", root, CACHE_INDEX_NAME ) & ~ kptAlias );
+    if ( pt == kptFile )
+    {
+        const KFile * f;
+        rc = KDirectoryOpenFileRead ( dir, &f, "%s/%s", root, CACHE_INDEX_NAME );
+        if ( rc != 0 )
+        {
+            PLOGERR( klogErr, ( klogErr, rc,
+                     "KDirectoryOpenFileRead( $(path) ) failed in $(func)", "path=%s/%s,func=%s", root, CACHE_INDEX_NAME, __func__ ) );
+        }
+        else
+        {
+            uint64_t size;
+            rc = KFileSize ( f, &size );
+            if ( rc != 0 )
+            {
+                PLOGERR( klogErr, ( klogErr, rc,
+                         "KFileSize( $(path) ) failed in $(func)", "path=%s/%s,func=%s", root, CACHE_INDEX_NAME, __func__ ) );
+            }
+            else if ( size > 0 )
+            {
+                uint8_t * buf = malloc( size );
+                if ( buf == NULL )
+                    rc = out_of_memory();
+                else
+                {
+                    size_t num_read;
+                    rc = KFileReadAll ( f, 0, buf, size, &num_read );
+                    if ( rc != 0 )
+                    {
+                        PLOGERR( klogErr, ( klogErr, rc,
+                                 "KFileReadAll( $(path) ) failed in $(func)", "path=%s/%s,func=%s", root, CACHE_INDEX_NAME, __func__ ) );
+                    }
+                    else if ( !parse_index( self, buf, num_read ) )
+                    {
+                        /* not fatal: we just have to list every directory again */
+                        PLOGMSG( klogWarn, ( klogWarn,
+                                 "damaged index $(path) ignored", "path=%s/%s", root, CACHE_INDEX_NAME ) );
+                        release_dirs( self );
+                    }
+                    free( buf );
+                }
+            }
+            KFileRelease( f );
+        }
+    }
+    return rc;
+}
+
+
+/***************************************************************************************************************/
+
+typedef struct index_writer
+{
+    KFile * f;
+    uint64_t pos;
+    size_t len;
+    rc_t rc;
+    uint8_t buf[ 64 * 1024 ];
+} index_writer;
+
+
+static void flush_writer( index_writer * w )
+{
+    if ( w->rc == 0 && w->len > 0 )
+    {
+        size_t num_writ;
+        w->rc = KFileWriteAll ( w->f, w->pos, w->buf, w->len, &num_writ );
+        w->pos += num_writ;
+    }
+    w->len = 0;
+}
+
+
+static void put_bytes( index_writer * w, const void * src, size_t len )
+{
+    if ( w->len + len > sizeof w->buf )
+        flush_writer( w );
+    if ( w->rc == 0 )
+    {
+        memmove( w->buf + w->len, src, len );
+        w->len += len;
+    }
+}
+
+
+static void put_num( index_writer * w, uint64_t value, uint32_t bytes )
+{
+    uint8_t b[ 8 ];
+    uint32_t idx;
+    for ( idx = 0; idx < bytes; ++idx )
+        b[ idx ] = ( uint8_t )( value >> ( idx * 8 ) );
+    put_bytes( w, b, bytes );
+}
+
+
+static void put_str( index_writer * w, const char * s )
+{
+    size_t len = strlen( s );
+    if ( len > 0xFFFF )
+        len = 0xFFFF;
+    put_num( w, len, 2 );
+    put_bytes( w, s, len );
+}
+
+
+static void write_index( index_writer * w, const cache_index * self )
+{
+    uint32_t idx;
+    put_bytes( w, index_magic, sizeof index_magic );
+    put_num( w, INDEX_VERSION, 4 );
+    put_num( w, self->dir_count, 4 );
+    for ( idx = 0; idx < self->dir_count && w->rc == 0; ++idx )
+    {
+        const cache_dir * cdir = self->dirs[ idx ];
+        uint32_t e_idx, e_count = 0;
+
+        for ( e_idx = 0; e_idx < cdir->count; ++e_idx )
+        {
+            if ( cdir->entries[ e_idx ].flags != 0 )
+                e_count++;
+        }
+        put_str( w, cdir->path );
+        put_num( w, ( uint64_t )cdir->mtime, 8 );
+        put_num( w, e_count, 4 );
+        for ( e_idx = 0; e_idx < cdir->count; ++e_idx )
+        {
+            const cache_entry * e = &cdir->entries[ e_idx ];
+            if ( e->flags != 0 )
+            {
+                put_str( w, e->name );
+                put_num( w, e->flags, 1 );
+                if ( ( e->flags & ( CIE_CACHE | CIE_FULL ) ) != 0 )
+                {
+                    put_num( w, e->size, 8 );
+                    put_num( w, e->used, 8 );
+                    put_num( w, ( uint64_t )e->mtime, 8 );
+                    put_num( w, e->completeness, 2 );
+                }
+            }
+        }
+    }
+    flush_writer( w );
+}
+
+
+rc_t cache_index_save( const cache_index * self, KDirectory * dir )
+{
+    char tmp_path[ MAX_PATH_LEN ];
+    char path[ MAX_PATH_LEN ];
+    size_t num_writ;
+    rc_t rc = string_printf( path, sizeof path, &num_writ, "%s/%s", self->root, CACHE_INDEX_NAME );
+    if ( rc == 0 )
+        rc = string_printf( tmp_path, sizeof tmp_path, &num_writ, "%s.tmp", path );
+    if ( rc == 0 )
+    {
+        index_writer * w = malloc( sizeof * w );
+        if ( w == NULL )
+            rc = out_of_memory();
+        else
+        {
+            w->pos = 0;
+            w->len = 0;
+            w->rc = KDirectoryCreateFile ( dir, &w->f, false, 0664, kcmInit, "%s", tmp_path );
+            if ( w->rc != 0 )
+            {
+                PLOGERR( klogErr, ( klogErr, w->rc,
+                         "KDirectoryCreateFile( $(path) ) failed in $(func)", "path=%s,func=%s", tmp_path, __func__ ) );
+            }
+            else
+            {
+                write_index( w, self );
+                if ( w->rc != 0 )
+                {
+                    PLOGERR( klogErr, ( klogErr, w->rc,
+                             "KFileWriteAll( $(path) ) failed in $(func)", "path=%s,func=%s", tmp_path, __func__ ) );
+                }
+                KFileRelease( w->f );
+
+                /* the index is replaced in one step, a concurrent cache-mgr sees the old or the new one */
+                if ( w->rc == 0 )
+                {
+                    w->rc = KDirectoryRename ( dir, true, tmp_path, path );
+                    if ( w->rc != 0 )
+                    {
+                        PLOGERR( klogErr, ( klogErr, w->rc,
+                                 "KDirectoryRename( $(path) ) failed in $(func)", "path=%s,func=%s", path, __func__ ) );
+                    }
+                }
+                if ( w->rc != 0 )
+                    KDirectoryRemove ( dir, false, "%s", tmp_path );
+            }
+            rc = w->rc;
+            free( w );
+        }
+    }
+    return rc;
+}
+
+
+/***************************************************************************************************************/
+
+typedef struct scan_ctx
+{
+    const KDirectory * dir;
+    const cache_index * old;
+    bool * taken;           /* this dir of the old index is part of the new one */
+
+    KLock * lock;
+    KCondition * wake;
+
+    char ** queue;          /* relative paths of directories not yet listed */
+    uint32_t q_count;
+    uint32_t q_alloc;
+
+    cache_dir ** found;
+    uint32_t f_count;
+    uint32_t f_alloc;
+
+    uint32_t busy;          /* directories queued or being listed */
+    KTime_t started;
+    rc_t rc;
+} scan_ctx;
+
+
+/* old is what the index had for this file, NULL if it was not in there */
+static rc_t scan_file( const scan_ctx * ctx, const char * dir_path, const cache_entry * old, cache_entry * e )
+{
+    rc_t rc = KDirectoryFileSize ( ctx->dir, &e->size, "%s/%s", dir_path, e->name );
+    if ( rc == 0 )
+        rc = KDirectoryDate ( ctx->dir, &e->mtime, "%s/%s", dir_path, e->name );
+    if ( rc == 0 )
+    {
+        if ( old != NULL && old->flags == e->flags && old->size == e->size && old->mtime == e->mtime )
+        {
+            /* not written to since the last scan: no need to open it */
+            e->used = old->used;
+            e->completeness = old->completeness;
+        }
+        else if ( ( e->flags & CIE_FULL ) != 0 )
+        {
+            e->used = e->size;
+            e->completeness = 10000;
+        }
+        else
+        {
+            const KFile * f;
+            rc = KDirectoryOpenFileRead ( ctx->dir, &f, "%s/%s", dir_path, e->name );
+            if ( rc == 0 )
+            {
+                float completeness = 0.0;
+                rc = GetCacheCompleteness( f, &completeness, &e->used ); /* libs/kfs/cacheteefile.c */
+                if ( rc != 0 )
+                {
+                    /* a damaged or foreign *.cache: count it as empty, it is the first one to go */
+                    PLOGERR( klogWarn, ( klogWarn, rc,
+                             "GetCacheCompleteness( $(path) ) failed in $(func)", "path=%s/%s,func=%s", dir_path, e->name, __func__ ) );
+                    e->used = 0;
+                    rc = 0;
+                }
+                e->completeness = ( uint32_t )( completeness * 100 );
+                KFileRelease( f );
+            }
+        }
+    }
+    return rc;
+}
+
+
+static rc_t scan_list_dir( const scan_ctx * ctx, const char * dir_path, const cache_dir * old_dir, cache_dir * cdir )
+{
+    KNamelist * names;
+    rc_t rc = KDirectoryList ( ctx->dir, &names, NULL, NULL, "%s", dir_path );
+    if ( rc != 0 )
+    {
+        PLOGERR( klogErr, ( klogErr, rc,
+                 "KDirectoryList( $(path) ) failed in $(func)", "path=%s,func=%s", dir_path, __func__ ) );
+    }
+    else
+    {
+        uint32_t idx, count;
+        rc = KNamelistCount ( names, &count );
+        if ( rc == 0 )
+        {
+            cdir->entries = calloc( count + 1, sizeof cdir->entries[ 0 ] );
+            if ( cdir->entries == NULL )
+                rc = out_of_memory();
+        }
+        for ( idx = 0; idx < count && rc == 0; ++idx )
+        {
+            const char * name = NULL;
+            rc = KNamelistGet ( names, idx, &name );
+            if ( rc == 0 && name != NULL )
+            {
+                uint32_t flags = 0;
+                uint32_t pt = ( KDirectoryPathType ( ctx->dir, "%s/%s", dir_path, name ) & ~ kptAlias );
+                if ( pt == kptDir )
+                    flags = CIE_DIR;
+                else if ( pt == kptFile )
+                {
+                    if ( ends_in( name, ".cache" ) )
+                        flags = CIE_CACHE;
+                    else if ( ends_in( name, ".sra" ) )
+                        flags = CIE_FULL;
+                    else if ( ends_in( name, ".lock" ) )
+                        flags = CIE_LOCK;
+                }
+
+                if ( flags != 0 )
+                {
+                    cache_entry * e = &cdir->entries[ cdir->count ];
+                    e->flags = flags;
+                    e->name = string_dup_measure( name, NULL );
+                    if ( e->name == NULL )
+                        rc = out_of_memory();
+                    else
+                    {
+                        cdir->count++;
+                        if ( ( flags & ( CIE_CACHE | CIE_FULL ) ) != 0 )
+                        {
+                            rc = scan_file( ctx, dir_path, find_entry( old_dir, e->name ), e );
+                            if ( rc != 0 &&
+                                 ( KDirectoryPathType ( ctx->dir, "%s/%s", dir_path, name ) & ~ kptAlias ) == kptNotFound )
+                            {
+                                /* removed by somebody else while we were looking at it */
+                                free( e->name );
+                                cdir->count--;
+                                rc = 0;
+                            }
+                            else if ( rc != 0 )
+                            {
+                                PLOGERR( klogErr, ( klogErr, rc,
+                                         "scanning $(path) failed in $(func)", "path=%s/%s,func=%s", dir_path, name, __func__ ) );
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        KNamelistRelease ( names );
+        if ( rc == 0 && cdir->count > 1 )
+            qsort( cdir->entries, cdir->count, sizeof cdir->entries[ 0 ], cmp_entry );
+    }
+    return rc;
+}
+
+
+/* the listing of a directory does not change when a file in it grows in place,
+   the files of a directory taken from the index are looked at again */
+static rc_t scan_restat_dir( const scan_ctx * ctx, const char * dir_path, cache_dir * cdir )
+{
+    rc_t rc = 0;
+    uint32_t idx;
+
+    for ( idx = 0; idx < cdir->count && rc == 0; ++idx )
+    {
+        cache_entry * e = &cdir->entries[ idx ];
+        if ( ( e->flags & ( CIE_CACHE | CIE_FULL ) ) != 0 )
+        {
+            cache_entry old = *e;
+            rc = scan_file( ctx, dir_path, &old, e );
+            if ( rc != 0 &&
+                 ( KDirectoryPathType ( ctx->dir, "%s/%s", dir_path, e->name ) & ~ kptAlias ) == kptNotFound )
+            {
+                /* removed by somebody else: same as removed by us, dropped when the index is saved */
+                e->flags = 0;
+                e->size = e->used = 0;
+                rc = 0;
+            }
+            else if ( rc != 0 )
+            {
+                PLOGERR( klogErr, ( klogErr, rc,
+                         "scanning $(path) failed in $(func)", "path=%s/%s,func=%s", dir_path, e->name, __func__ ) );
+            }
+        }
+    }
+    return rc;
+}
+
+
+/* takes ownership of path */
+static rc_t scan_dir( scan_ctx * ctx, char * path, cache_dir ** res )
+{
+    char dir_path[ MAX_PATH_LEN ];
+    KTime_t mtime = 0;
+    int64_t old_idx = find_dir( ctx->old, path );
+    const cache_dir * old_dir = ( old_idx < 0 ) ? NULL : ctx->old->dirs[ old_idx ];
+
+    rc_t rc = join_path( dir_path, sizeof dir_path, ctx->old->root, path, NULL );
+    if ( rc == 0 )
+    {
+        rc = KDirectoryDate ( ctx->dir, &mtime, "%s", dir_path );
+        if ( rc != 0 && ( KDirectoryPathType ( ctx->dir, "%s", dir_path ) & ~ kptAlias ) == kptNotFound )
+        {
+            /* removed by somebody else since its parent was listed */
+            *res = NULL;
+            free( path );
+            return 0;
+        }
+        else if ( rc != 0 )
+        {
+            PLOGERR( klogErr, ( klogErr, rc,
+                     "KDirectoryDate( $(path) ) failed in $(func)", "path=%s,func=%s", dir_path, __func__ ) );
+        }
+    }
+    if ( rc == 0 && old_dir != NULL && old_dir->mtime != 0 && old_dir->mtime == mtime )
+    {
+        /* only this thread looks at this slot, everybody else is listing other paths */
+        ctx->old->dirs[ old_idx ]->rescanned = false;
+        rc = scan_restat_dir( ctx, dir_path, ctx->old->dirs[ old_idx ] );
+        if ( rc == 0 )
+        {
+            ctx->taken[ old_idx ] = true;
+            *res = ctx->old->dirs[ old_idx ];
+        }
+        free( path );
+        return rc;
+    }
+
+    if ( rc == 0 )
+    {
+        cache_dir * cdir = calloc( 1, sizeof * cdir );
+        if ( cdir == NULL )
+            rc = out_of_memory();
+        else
+        {
+            cdir->path = path;
+            path = NULL;
+            /* changed within the second we started: a change after the listing would have the same time */
+            cdir->mtime = ( mtime + 1 < ctx->started ) ? mtime : 0;
+            cdir->rescanned = true;
+            rc = scan_list_dir( ctx, dir_path, old_dir, cdir );
+            if ( rc == 0 )
+                *res = cdir;
+            else
+                cache_dir_release( cdir );
+        }
+    }
+    free( path );
+    return rc;
+}
+
+
+/* with the lock held */
+static rc_t scan_add_dir( scan_ctx * ctx, cache_dir * cdir )
+{
+    uint32_t idx;
+    rc_t rc = 0;
+
+    if ( ctx->f_count == ctx->f_alloc )
+    {
+        uint32_t n = ( ctx->f_alloc == 0 ) ? 64 : ctx->f_alloc * 2;
+        cache_dir ** tmp = realloc( ctx->found, n * sizeof tmp[ 0 ] );
+        if ( tmp == NULL )
+            return out_of_memory();
+        ctx->found = tmp;
+        ctx->f_alloc = n;
+    }
+    ctx->found[ ctx->f_count++ ] = cdir;
+
+    for ( idx = 0; idx < cdir->count && rc == 0; ++idx )
+    {
+        const cache_entry * e = &cdir->entries[ idx ];
+        if ( ( e->flags & CIE_DIR ) != 0 )
+        {
+            char sub[ MAX_PATH_LEN ];
+            size_t num_writ;
+            if ( cdir->path[ 0 ] == 0 )
+                rc = string_printf( sub, sizeof sub, &num_writ, "%s", e->name );
+            else
+                rc = string_printf( sub, sizeof sub, &num_writ, "%s/%s", cdir->path, e->name );
+            if ( rc == 0 && ctx->q_count == ctx->q_alloc )
+            {
+                uint32_t n = ( ctx->q_alloc == 0 ) ? 64 : ctx->q_alloc * 2;
+                char ** tmp = realloc( ctx->queue, n * sizeof tmp[ 0 ] );
+                if ( tmp == NULL )
+                    rc = out_of_memory();
+                else
+                {
+                    ctx->queue = tmp;
+                    ctx->q_alloc = n;
+                }
+            }
+            if ( rc == 0 )
+            {
+                char * s = string_dup_measure( sub, NULL );
+                if ( s == NULL )
+                    rc = out_of_memory();
+                else
+                {
+                    ctx->queue[ ctx->q_count++ ] = s;
+                    ctx->busy++;
+                }
+            }
+        }
+    }
+    return rc;
+}
+
+
+static void scan_worker( scan_ctx * ctx )
+{
+    KLockAcquire ( ctx->lock );
+    for ( ; ; )
+    {
+        char * path;
+        cache_dir * cdir = NULL;
+        rc_t rc;
+
+        while ( ctx->q_count == 0 && ctx->busy > 0 && ctx->rc == 0 )
+            KConditionWait ( ctx->wake, ctx->lock );
+        if ( ctx->q_count == 0 || ctx->rc != 0 )
+            break;
+        path = ctx->queue[ --ctx->q_count ];
+        KLockUnlock ( ctx->lock );
+
+        rc = scan_dir( ctx, path, &cdir );
+
+        KLockAcquire ( ctx->lock );
+        if ( rc == 0 && cdir != NULL )
+            rc = scan_add_dir( ctx, cdir );
+        if ( rc != 0 && ctx->rc == 0 )
+            ctx->rc = rc;
+        ctx->busy--;
+        KConditionBroadcast ( ctx->wake );
+    }
+    KConditionBroadcast ( ctx->wake );
+    KLockUnlock ( ctx->lock );
+}
+
+
+static rc_t CC scan_thread( const KThread * self, void * data )
+{
+    scan_worker( data );
+    return 0;
+}
+
+
+static rc_t scan_run( scan_ctx * ctx, uint32_t threads )
+{
+    KThread ** t = NULL;
+    uint32_t idx, started = 0;
+
+    if ( threads > 1 )
+        t = calloc( threads - 1, sizeof t[ 0 ] );
+    if ( t != NULL )
+    {
+        for ( idx = 0; idx < threads - 1; ++idx )
+        {
+            if ( KThreadMake ( &t[ started ], scan_thread, ctx ) == 0 )
+                started++;
+        }
+    }
+
+    /* the main thread is one of the workers, without threads it is the only one */
+    scan_worker( ctx );
+
+    for ( idx = 0; idx < started; ++idx )
+    {
+        rc_t status;
+        KThreadWait ( t[ idx ], &status );
+        KThreadRelease ( t[ idx ] );
+    }
+    free( t );
+    return ctx->rc;
+}
+
+
+rc_t cache_index_scan( cache_index * self, const KDirectory * dir, uint32_t threads )
+{
+    rc_t rc;
+    scan_ctx ctx;
+    uint32_t idx;
+
+    memset( &ctx, 0, sizeof ctx );
+    ctx.dir = dir;
+    ctx.old = self;
+    ctx.started = KTimeStamp();
+    ctx.taken = calloc( self->dir_count + 1, sizeof ctx.taken[ 0 ] );
+    if ( ctx.taken == NULL )
+        return out_of_memory();
+
+    rc = KLockMake ( &ctx.lock );
+    if ( rc != 0 )
+    {
+        PLOGERR( klogErr, ( klogErr, rc,
+                 "KLockMake() failed in $(func)", "func=%s", __func__ ) );
+    }
+    else
+    {
+        rc = KConditionMake ( &ctx.wake );
+        if ( rc != 0 )
+        {
+            PLOGERR( klogErr, ( klogErr, rc,
+                     "KConditionMake() failed in $(func)", "func=%s", __func__ ) );
+        }
+        else
+        {
+            ctx.queue = malloc( sizeof ctx.queue[ 0 ] );
+            if ( ctx.queue == NULL )
+                rc = out_of_memory();
+            else
+            {
+                ctx.q_alloc = 1;
+                ctx.queue[ 0 ] = string_dup_measure( "", NULL );
+                if ( ctx.queue[ 0 ] == NULL )
+                    rc = out_of_memory();
+                else
+                {
+                    ctx.q_count = 1;
+                    ctx.busy = 1;
+                    rc = scan_run( &ctx, threads );
+                }
+            }
+
+            if ( rc == 0 )
+            {
+                /* the old index gives up what was not taken over, e.g. directories removed since */
+                for ( idx = 0; idx < self->dir_count; ++idx )
+                {
+                    if ( !ctx.taken[ idx ] )
+                        cache_dir_release( self->dirs[ idx ] );
+                }
+                free( self->dirs );
+                if ( ctx.f_count > 1 )
+                    qsort( ctx.found, ctx.f_count, sizeof ctx.found[ 0 ], cmp_dir );
+                self->dirs = ctx.found;
+                self->dir_count = ctx.f_count;
+                self->rescanned = 0;
+                for ( idx = 0; idx < self->dir_count; ++idx )
+                {
+                    if ( self->dirs[ idx ]->rescanned )
+                        self->rescanned++;
+                }
+                ctx.found = NULL;
+            }
+            else
+            {
+                /* the old index still owns the directories taken over from it */
+                for ( idx = 0; idx < ctx.f_count; ++idx )
+                {
+                    if ( ctx.found[ idx ]->rescanned )
+                        cache_dir_release( ctx.found[ idx ] );
+                }
+            }
+            free( ctx.found );
+            for ( idx = 0; idx < ctx.q_count; ++idx )
+                free( ctx.queue[ idx ] );
+            free( ctx.queue );
+            KConditionRelease ( ctx.wake );
+        }
+        KLockRelease ( ctx.lock );
+    }
+    free( ctx.taken );
+    return rc;
+}
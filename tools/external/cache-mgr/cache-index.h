@@ -0,0 +1,100 @@
+/*===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+*/
+
+#ifndef _h_cache_index_
+#define _h_cache_index_
+
+#include <klib/defs.h>
+#include <klib/time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct KDirectory;
+
+/* name of the index-file, written into the root of every scanned cache-path */
+#define CACHE_INDEX_NAME ".cache-mgr.idx"
+
+/* what an entry of a directory is */
+#define CIE_DIR     0x01    /* a sub-directory */
+#define CIE_CACHE   0x02    /* a partial file: *.cache */
+#define CIE_FULL    0x04    /* a complete file: *.sra */
+#define CIE_LOCK    0x08    /* a lock-file: *.lock */
+
+typedef struct cache_entry
+{
+    char * name;            /* relative to the directory it is in */
+    uint64_t size;          /* bytes on disk */
+    uint64_t used;          /* bytes present according to the bitmap of a .cache-file */
+    KTime_t mtime;          /* last time the file was written to, used for LRU */
+    uint32_t completeness;  /* percent * 100 */
+    uint32_t flags;
+} cache_entry;
+
+
+typedef struct cache_dir
+{
+    char * path;            /* relative to the root, "" for the root itself */
+    KTime_t mtime;          /* 0 ... has to be rescanned next time */
+    cache_entry * entries;  /* sorted by name */
+    uint32_t count;
+    bool rescanned;         /* listed this time, not taken from the index */
+} cache_dir;
+
+
+typedef struct cache_index
+{
+    char * root;
+    cache_dir ** dirs;      /* sorted by path */
+    uint32_t dir_count;
+    uint32_t rescanned;
+} cache_index;
+
+
+/* reads the index of this root, a missing or damaged index leaves it empty */
+rc_t cache_index_load( cache_index * self, const struct KDirectory * dir, const char * root );
+
+/* walks the directory-tree with multiple threads,
+   directories with unchanged modification-time are taken from the loaded index */
+rc_t cache_index_scan( cache_index * self, const struct KDirectory * dir, uint32_t threads );
+
+rc_t cache_index_save( const cache_index * self, struct KDirectory * dir );
+
+void cache_index_release( cache_index * self );
+
+/* is the file of this entry in use by a running tool ( has a *.lock next to it ) */
+bool cache_dir_entry_locked( const cache_dir * self, const cache_entry * entry );
+
+/* removes the file of this entry from the disk, the entry stays with flags == 0 until the index is saved */
+rc_t cache_dir_entry_remove( const cache_index * self, struct KDirectory * dir,
+                             cache_dir * cdir, cache_entry * entry );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _h_cache_index_ */
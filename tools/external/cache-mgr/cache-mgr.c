@@ -46,6 +46,8 @@
 #include <kfs/cacheteefile.h>
 #include <kfs/defs.h>
 
+#include "cache-index.h"
+
 #include <os-native.h>
 #include <sysalloc.h>
 #include <strtol.h>
@@ -65,6 +67,10 @@ static const char * tstzero_usage[] = { "test for zero blocks (for report functi
 static const char * urname_usage[]  = { "restrict to this user-repository", NULL };
 static const char * max_rem_usage[] = { "remove until reached that many bytes", NULL };
 static const char * rem_dir_usage[] = { "remove directories, not only files", NULL };
+static const char * quota_usage[]   = { "remove least recently used files until the cache fits into that many bytes",
+                                        "( suffix k, m, g or t allowed ), locked files stay", NULL };
+static const char * index_usage[]   = { "report from the index ( "CACHE_INDEX_NAME" ), list only directories changed since", NULL };
+static const char * threads_usage[] = { "number of threads scanning the cache ( default 4 )", NULL };
 
 #define OPTION_CREPORT  "report"
 #define ALIAS_CREPORT   "r"
@@ -99,6 +105,17 @@ static const char * rem_dir_usage[] = { "remove directories, not only files", NU
 #define OPTION_TSTZERO  "test-zero"
 #define ALIAS_TSTZERO   "z"
 
+#define OPTION_QUOTA    "quota"
+#define ALIAS_QUOTA     "Q"
+
+#define OPTION_INDEX    "index"
+#define ALIAS_INDEX     "x"
+
+#define OPTION_THREADS  "threads"
+#define ALIAS_THREADS   "j"
+
+#define DEFAULT_THREADS 4
+
 OptDef ToolOptions[] =
 {
     { OPTION_CREPORT,   ALIAS_CREPORT,  NULL,   report_usage,   1,  false,  false },
@@ -109,6 +126,9 @@ OptDef ToolOptions[] =
     { OPTION_CLEAR,     ALIAS_CLEAR,    NULL,   clear_usage,    1,  false,  false },
     { OPTION_MAXREM,    ALIAS_MAXREM,   NULL,   max_rem_usage,  1,  true,   false },
     { OPTION_REMDIR,    ALIAS_REMDIR,   NULL,   rem_dir_usage,  1,  false,  false },
+    { OPTION_QUOTA,     ALIAS_QUOTA,    NULL,   quota_usage,    1,  true,   false },
+    { OPTION_INDEX,     ALIAS_INDEX,    NULL,   index_usage,    1,  false,  false },
+    { OPTION_THREADS,   ALIAS_THREADS,  NULL,   threads_usage,  1,  true,   false },
     { OPTION_ENABLE,    ALIAS_ENABLE,   NULL,   enable_usage,   1,  true,   false },
     { OPTION_DISABLE,   ALIAS_DISABLE,  NULL,   disable_usage,  1,  true,   false },
     { OPTION_URNAME,    ALIAS_URNAME,   NULL,   urname_usage,   1,  true,   false }
@@ -179,6 +199,7 @@ typedef enum tool_main_function
     tf_rreport,
     tf_unlock,
     tf_clear,
+    tf_evict,
     tf_enable,
     tf_disable,
     tf_unknown
@@ -188,17 +209,20 @@ typedef enum tool_main_function
 typedef struct tool_options
 {
     uint64_t max_remove;
+    uint64_t quota;
 
     VNamelist * paths;
     const char * user_repo_name;
 
     uint32_t path_count;
+    uint32_t threads;
     tool_main_function main_function;
     KRepCategory category;
 
     bool detailed;
     bool tstzero;
     bool remove_dirs;
+    bool use_index;
 } tool_options;
 
 
@@ -216,6 +240,8 @@ static rc_t init_tool_options( tool_options * options )
         options->main_function = tf_unknown;
         options->user_repo_name = NULL;
         options->max_remove = 0;
+        options->quota = 0;
+        options->threads = DEFAULT_THREADS;
     }
     return rc;
 }
@@ -341,6 +367,48 @@ static rc_t get_max_remove( const Args * args, uint64_t * max_rem )
 }
 
 
+/* a number of bytes, with an optional unit: 100g */
+static rc_t get_size_option( const Args * args, const char * name, uint64_t * value )
+{
+    uint32_t count;
+    rc_t rc = ArgsOptionCount( args, name, &count );
+    if ( rc != 0 )
+    {
+        PLOGERR( klogErr, ( klogErr, rc,
+                 "ArgsOptionCount( $(option) ) failed in $(func)", "option=%s,func=%s", name, __func__ ) );
+    }
+    else if ( count > 0 )
+    {
+        const char * s = NULL;
+        rc = ArgsOptionValue( args, name, 0, (const void **)&s );
+        if ( rc != 0 )
+        {
+            PLOGERR( klogErr, ( klogErr, rc,
+                     "ArgsOptionValue( $(option), 0 ) failed in $(func)", "option=%s,func=%s", name, __func__ ) );
+        }
+        else if ( s != NULL )
+        {
+            char *endp;
+            *value = strtou64( s, &endp, 10 );
+            switch ( *endp )
+            {
+                case 't' : case 'T' : *value <<= 10;   /* fall through */
+                case 'g' : case 'G' : *value <<= 10;   /* fall through */
+                case 'm' : case 'M' : *value <<= 10;   /* fall through */
+                case 'k' : case 'K' : *value <<= 10; endp++; break;
+            }
+            if ( endp == s || *endp != 0 )
+            {
+                rc = RC ( rcApp, rcArgv, rcParsing, rcParam, rcInvalid );
+                PLOGERR( klogErr, ( klogErr, rc,
+                         "invalid value '$(value)' for --$(option)", "value=%s,option=%s", s, name ) );
+            }
+        }
+    }
+    return rc;
+}
+
+
 static rc_t add_tool_options_path( tool_options * options, const char * path )
 {
     rc_t rc = VNamelistAppend ( options->paths, path );
@@ -385,6 +453,7 @@ static rc_t get_tool_options( Args * args, tool_options * options )
     options->detailed = get_bool_option( args, OPTION_DETAIL );
     options->tstzero = get_bool_option( args, OPTION_TSTZERO );
     options->remove_dirs = get_bool_option( args, OPTION_REMDIR );
+    options->use_index = get_bool_option( args, OPTION_INDEX );
 
     if ( get_bool_option( args, OPTION_CREPORT ) )
         options->main_function = tf_report;
@@ -394,6 +463,8 @@ static rc_t get_tool_options( Args * args, tool_options * options )
         options->main_function = tf_unlock;
     else if ( get_bool_option( args, OPTION_CLEAR ) )
         options->main_function = tf_clear;
+    else if ( get_bool_option( args, OPTION_QUOTA ) )
+        options->main_function = tf_evict;
     else
     {
         options->category = get_repo_select( args, OPTION_ENABLE );
@@ -412,6 +483,15 @@ static rc_t get_tool_options( Args * args, tool_options * options )
         rc = get_user_repo_name( args, &options->user_repo_name );
     if ( rc == 0 )
         rc = get_max_remove( args, &options->max_remove );
+    if ( rc == 0 )
+        rc = get_size_option( args, OPTION_QUOTA, &options->quota );
+    if ( rc == 0 )
+    {
+        uint64_t threads = options->threads;
+        rc = get_size_option( args, OPTION_THREADS, &threads );
+        if ( rc == 0 )
+            options->threads = ( threads == 0 ) ? 1 : ( threads > 64 ? 64 : ( uint32_t )threads );
+    }
     return rc;
 }
 
@@ -552,6 +632,82 @@ static bool string_ends_in( const char * str, const char * end )
 }
 
 
+/***************************************************************************************************************/
+
+/* loads the index of every cache-path and brings it up to date, paths that do not exist stay empty */
+static rc_t scan_cache_paths( visit_ctx * octx, cache_index * indexes )
+{
+    rc_t rc = 0;
+    uint32_t idx;
+
+    for ( idx = 0; idx < octx->options->path_count && rc == 0; ++idx )
+    {
+        const char * path = NULL;
+        rc = VNameListGet ( octx->options->paths, idx, &path );
+        if ( rc != 0 )
+        {
+            PLOGERR( klogErr, ( klogErr, rc,
+                     "VNameListGet( $(idx) ) failed in $(func)", "idx=%u,func=%s", idx, __func__ ) );
+        }
+        else if ( path != NULL )
+        {
+            rc = cache_index_load( &indexes[ idx ], octx->dir, path );
+            if ( rc == 0 && ( KDirectoryPathType ( octx->dir, "%s", path ) & ~ kptAlias ) == kptDir )
+            {
+                rc = cache_index_scan( &indexes[ idx ], octx->dir, octx->options->threads );
+                if ( rc != 0 )
+                {
+                    PLOGERR( klogErr, ( klogErr, rc,
+                             "cache_index_scan( $(path) ) failed in $(func)", "path=%s,func=%s", path, __func__ ) );
+                }
+                else if ( octx->options->detailed )
+                {
+                    rc = KOutMsg( "%s : %,u directories, %,u of them listed\n",
+                                  path, indexes[ idx ].dir_count, indexes[ idx ].rescanned );
+                }
+            }
+        }
+    }
+    return rc;
+}
+
+
+static void save_cache_indexes( visit_ctx * octx, cache_index * indexes )
+{
+    uint32_t idx;
+    for ( idx = 0; idx < octx->options->path_count; ++idx )
+    {
+        if ( indexes[ idx ].dir_count > 0 )
+        {
+            /* a read-only cache can still be reported on, it is scanned completely every time */
+            rc_t rc = cache_index_save( &indexes[ idx ], octx->dir );
+            if ( rc != 0 )
+            {
+                PLOGERR( klogWarn, ( klogWarn, rc,
+                         "cannot write index for $(path)", "path=%s", indexes[ idx ].root ) );
+            }
+        }
+    }
+}
+
+
+static void release_cache_indexes( visit_ctx * octx, cache_index * indexes )
+{
+    uint32_t idx;
+    for ( idx = 0; idx < octx->options->path_count; ++idx )
+        cache_index_release( &indexes[ idx ] );
+    free( indexes );
+}
+
+
+static rc_t print_entry_path( const cache_index * index, const cache_dir * cdir, const cache_entry * e )
+{
+    if ( cdir->path[ 0 ] == 0 )
+        return KOutMsg( "%s/%s", index->root, e->name );
+    return KOutMsg( "%s/%s/%s", index->root, cdir->path, e->name );
+}
+
+
 /***************************************************************************************************************/
 
 typedef struct report_data
@@ -693,6 +849,66 @@ static rc_t on_report_path( visit_ctx * obj )
 }
 
 
+static rc_t report_index_entry( visit_ctx * octx, const cache_index * index,
+                                const cache_dir * cdir, const cache_entry * e )
+{
+    rc_t rc = 0;
+    report_data * data = octx->data;
+
+    if ( ( e->flags & CIE_LOCK ) != 0 )
+        data->lock_count++;
+    else if ( ( e->flags & ( CIE_CACHE | CIE_FULL ) ) != 0 )
+    {
+        if ( ( e->flags & CIE_CACHE ) != 0 )
+            data->partial_count++;
+        else
+            data->full_count++;
+        data->file_size += e->size;
+        data->used_file_size += e->used;
+
+        if ( octx->options->detailed )
+        {
+            rc = print_entry_path( index, cdir, e );
+            if ( rc == 0 && ( e->flags & CIE_FULL ) != 0 )
+                rc = KOutMsg( " complete file of %,lu bytes\n", e->size );
+            else if ( rc == 0 )
+                rc = KOutMsg( " complete by %.02f %% [%,lu of %,lu]bytes%s\n",
+                              e->completeness / 100.0, e->used, e->size,
+                              cache_dir_entry_locked( cdir, e ) ? " locked" : "" );
+        }
+    }
+    return rc;
+}
+
+
+static rc_t report_from_index( visit_ctx * octx )
+{
+    cache_index * indexes = calloc( octx->options->path_count + 1, sizeof indexes[ 0 ] );
+    rc_t rc = ( indexes == NULL ) ? RC ( rcExe, rcStorage, rcAllocating, rcMemory, rcExhausted ) : 0;
+
+    if ( rc == 0 )
+    {
+        uint32_t idx, d_idx, e_idx;
+
+        rc = scan_cache_paths( octx, indexes );
+        if ( rc == 0 )
+            save_cache_indexes( octx, indexes );
+        for ( idx = 0; idx < octx->options->path_count && rc == 0; ++idx )
+        {
+            const cache_index * index = &indexes[ idx ];
+            for ( d_idx = 0; d_idx < index->dir_count && rc == 0; ++d_idx )
+            {
+                const cache_dir * cdir = index->dirs[ d_idx ];
+                for ( e_idx = 0; e_idx < cdir->count && rc == 0; ++e_idx )
+                    rc = report_index_entry( octx, index, cdir, &cdir->entries[ e_idx ] );
+            }
+        }
+        release_cache_indexes( octx, indexes );
+    }
+    return rc;
+}
+
+
 static rc_t perform_report( visit_ctx * octx )
 {
     rc_t rc = 0;
@@ -704,7 +920,13 @@ static rc_t perform_report( visit_ctx * octx )
     if ( octx->options->detailed )
         rc = KOutMsg( "\n-----------------------------------\n" );
     if ( rc == 0 )
-        rc = foreach_path( octx, on_report_path );
+    {
+        /* the zero-block test has to read every file, the index does not help with that */
+        if ( octx->options->use_index && !octx->options->tstzero )
+            rc = report_from_index( octx );
+        else
+            rc = foreach_path( octx, on_report_path );
+    }
 
     if ( rc == 0 )
         rc = KOutMsg( "-----------------------------------\n" );
@@ -1007,6 +1229,145 @@ static rc_t perform_clear( visit_ctx * octx )
 }
 
 
+/***************************************************************************************************************/
+
+
+typedef struct evict_candidate
+{
+    const cache_index * index;
+    cache_dir * cdir;
+    cache_entry * entry;
+} evict_candidate;
+
+
+static int cmp_evict_candidate( const void * a, const void * b )
+{
+    const evict_candidate * ca = a;
+    const evict_candidate * cb = b;
+    if ( ca->entry->mtime != cb->entry->mtime )
+        return ( ca->entry->mtime < cb->entry->mtime ) ? -1 : 1;
+    return strcmp( ca->entry->name, cb->entry->name );
+}
+
+
+static rc_t evict_lru( visit_ctx * octx, cache_index * indexes, clear_data * data )
+{
+    rc_t rc = 0;
+    uint64_t total = 0;
+    uint32_t count = 0, idx, d_idx, e_idx;
+    evict_candidate * candidates;
+
+    /* first pass: the size of the cache, and how many files may go */
+    for ( idx = 0; idx < octx->options->path_count; ++idx )
+    {
+        for ( d_idx = 0; d_idx < indexes[ idx ].dir_count; ++d_idx )
+        {
+            const cache_dir * cdir = indexes[ idx ].dirs[ d_idx ];
+            for ( e_idx = 0; e_idx < cdir->count; ++e_idx )
+            {
+                const cache_entry * e = &cdir->entries[ e_idx ];
+                if ( ( e->flags & ( CIE_CACHE | CIE_FULL ) ) != 0 )
+                {
+                    total += e->size;
+                    if ( !cache_dir_entry_locked( cdir, e ) )
+                        count++;
+                }
+            }
+        }
+    }
+
+    rc = KOutMsg( "%,lu bytes in cache, quota is %,lu bytes\n", total, octx->options->quota );
+    if ( rc != 0 || total <= octx->options->quota || count == 0 )
+        return rc;
+
+    candidates = malloc( count * sizeof candidates[ 0 ] );
+    if ( candidates == NULL )
+        return RC ( rcExe, rcStorage, rcAllocating, rcMemory, rcExhausted );
+
+    count = 0;
+    for ( idx = 0; idx < octx->options->path_count; ++idx )
+    {
+        for ( d_idx = 0; d_idx < indexes[ idx ].dir_count; ++d_idx )
+        {
+            cache_dir * cdir = indexes[ idx ].dirs[ d_idx ];
+            for ( e_idx = 0; e_idx < cdir->count; ++e_idx )
+            {
+                cache_entry * e = &cdir->entries[ e_idx ];
+                if ( ( e->flags & ( CIE_CACHE | CIE_FULL ) ) != 0 && !cache_dir_entry_locked( cdir, e ) )
+                {
+                    candidates[ count ].index = &indexes[ idx ];
+                    candidates[ count ].cdir = cdir;
+                    candidates[ count ].entry = e;
+                    count++;
+                }
+            }
+        }
+    }
+
+    /* the modification-time tells when a file was last downloaded into: oldest first */
+    qsort( candidates, count, sizeof candidates[ 0 ], cmp_evict_candidate );
+
+    for ( idx = 0; idx < count && rc == 0 && total > octx->options->quota; ++idx )
+    {
+        evict_candidate * c = &candidates[ idx ];
+        uint64_t size = c->entry->size;
+
+        if ( octx->options->detailed )
+        {
+            /* before the removal, that clears the entry */
+            rc = KOutMsg( "FILE: '" );
+            if ( rc == 0 )
+                rc = print_entry_path( c->index, c->cdir, c->entry );
+            if ( rc == 0 )
+                rc = KOutMsg( "' removed (%,lu bytes)\n", size );
+        }
+        if ( rc == 0 )
+            rc = cache_dir_entry_remove( c->index, octx->dir, c->cdir, c->entry );
+        if ( rc == 0 )
+        {
+            total -= size;
+            data->removed_files++;
+            data->removed_size += size;
+        }
+    }
+
+    if ( rc == 0 && total > octx->options->quota )
+        rc = KOutMsg( "the quota cannot be reached, the rest of the files are locked\n" );
+
+    free( candidates );
+    return rc;
+}
+
+
+static rc_t perform_evict( visit_ctx * octx )
+{
+    clear_data data;
+    cache_index * indexes = calloc( octx->options->path_count + 1, sizeof indexes[ 0 ] );
+    rc_t rc = ( indexes == NULL ) ? RC ( rcExe, rcStorage, rcAllocating, rcMemory, rcExhausted ) : 0;
+
+    memset( &data, 0, sizeof data );
+    if ( rc == 0 )
+    {
+        rc = scan_cache_paths( octx, indexes );
+        if ( rc == 0 )
+            rc = evict_lru( octx, indexes, &data );
+
+        /* even after a failed removal: what is gone is gone */
+        save_cache_indexes( octx, indexes );
+        release_cache_indexes( octx, indexes );
+    }
+
+    if ( rc == 0 )
+        rc = KOutMsg( "-----------------------------------\n" );
+    if ( rc == 0 )
+        rc = KOutMsg( "%,u files removed\n", data.removed_files );
+    if ( rc == 0 )
+        rc = KOutMsg( "%,lu bytes removed\n", data.removed_size );
+
+    return rc;
+}
+
+
 /***************************************************************************************************************/
 
 /*
@@ -1175,6 +1536,7 @@ static rc_t perform( tool_options * options, Args * args )
                     case tf_rreport : rc = perform_rreport( &octx ); break;
                     case tf_unlock  : rc = perform_unlock( &octx ); break;
                     case tf_clear   : rc = perform_clear( &octx ); break;
+                    case tf_evict   : rc = perform_evict( &octx ); break;
                     case tf_enable  : rc = perform_set_disable( &octx, false ); break;
                     case tf_disable : rc = perform_set_disable( &octx, true ); break;
                     case tf_unknown : rc = Usage( args ); break;
@@ -1377,7 +1739,8 @@ rc_t CC KMain ( int argc, char *argv [] )
                     {
                         case tf_report  : ;
                         case tf_unlock  : ;
-                        case tf_clear   : cache_paths_needed = true; break;
+                        case tf_clear   : ;
+                        case tf_evict   : cache_paths_needed = true; break;
                         case tf_rreport : ;
                         case tf_enable  : ;
                         case tf_disable : ;
@@ -0,0 +1,155 @@
+/* ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ *
+ * Project:
+ *  sratools command line tool
+ *
+ * Purpose:
+ *  Persistent cache of SDL results
+ *
+ */
+
+#include <string>
+#include <fstream>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+
+#include "SDL-cache.hpp"
+
+static char const header[] = "#SDL-cache\t1";
+
+void SDLCache::load(std::string const &path, std::time_t now, Entries &into)
+{
+    std::ifstream file(path);
+    auto line = std::string();
+
+    if (!std::getline(file, line) || line != header)
+        return;
+
+    while (std::getline(file, line)) {
+        // the context may contain tabs, the JSON can not
+        auto const first = line.find('\t');
+        auto const last = line.rfind('\t');
+        if (first == std::string::npos || last == first) continue;
+
+        char *endp = nullptr;
+        auto const expires = (std::time_t)std::strtoll(line.c_str(), &endp, 10);
+        if (endp != line.c_str() + first || expires <= now)
+            continue;
+
+        auto &entry = into[line.substr(first + 1, last - first - 1)];
+        if (entry.expires < expires) {
+            entry.expires = expires;
+            entry.json = line.substr(last + 1);
+        }
+    }
+}
+
+SDLCache::SDLCache(std::string const &path, std::string const &context, unsigned ttl)
+: path(path)
+, context(context)
+, ttl((std::time_t)ttl)
+, now(std::time(nullptr))
+{
+    load(path, now, entries);
+}
+
+bool SDLCache::find(std::string const &accession, Response2::Results &results) const
+{
+    auto const fnd = entries.find(key(accession));
+    if (fnd == entries.end())
+        return false;
+
+    try {
+        auto const &parsed = Response2::makeFrom("{\"version\":\"2\",\"result\":[" + fnd->second.json + "]}");
+        if (parsed.results.size() == 1 && parsed.results[0].query == accession) {
+            results.push_back(parsed.results[0]);
+            return true;
+        }
+    }
+    catch (...) {}
+    return false; // a damaged entry is a miss; it will be replaced
+}
+
+bool SDLCache::cacheable(Response2::ResultEntry const &result)
+{
+    if (result.status != "200")
+        return false;
+    for (auto const &file : result.files) {
+        for (auto const &location : file.locations) {
+            if (location.expirationDate)
+                return false;
+        }
+    }
+    return true;
+}
+
+bool SDLCache::store(Response2::ResultEntry const &result)
+{
+    if (ttl <= 0 || !cacheable(result))
+        return false;
+
+    auto &entry = added[key(result.query)];
+    entry.expires = now + ttl;
+    entry.json = result.toJSON();
+    return true;
+}
+
+bool SDLCache::save() const
+{
+    if (added.empty())
+        return true;
+
+    // another process may have saved since this one loaded
+    auto merged = Entries();
+    load(path, std::time(nullptr), merged);
+    for (auto const &i : added)
+        merged[i.first] = i.second;
+
+    auto const temp = path + ".tmp" + std::to_string(std::random_device()());
+    {
+        std::ofstream file(temp, std::ios::out | std::ios::trunc);
+
+        file << header << '\n';
+        for (auto const &i : merged)
+            file << i.second.expires << '\t' << i.first << '\t' << i.second.json << '\n';
+        file.flush();
+        if (!file) {
+            file.close();
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        // can't rename over an existing file on Windows
+        std::remove(path.c_str());
+        if (std::rename(temp.c_str(), path.c_str()) != 0) {
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+/* ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ *
+ * Project:
+ *  sratools command line tool
+ *
+ * Purpose:
+ *  Persistent cache of SDL results
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <map>
+#include <ctime>
+
+#include "SDL-response.hpp"
+
+/// @brief A file of SDL results that can be reused for a limited time.
+///
+/// @Note Results are keyed by accession and by the context of the request,
+/// i.e. the SDL URL and version, the location and the quality preference.
+/// Each line of the file is `<expires> TAB <context> TAB <accession> TAB <result JSON>`.
+class SDLCache {
+public:
+    struct Entry {
+        std::time_t expires;
+        std::string json;
+    };
+    using Entries = std::map<std::string, Entry>; ///< key is `<context> TAB <accession>`
+
+private:
+    std::string path;
+    std::string context;
+    std::time_t ttl;
+    std::time_t now;
+    Entries entries;
+    Entries added;
+
+    std::string key(std::string const &accession) const {
+        return context + '\t' + accession;
+    }
+    static void load(std::string const &path, std::time_t now, Entries &into);
+
+public:
+    /// @brief load the cache file, dropping expired entries.
+    /// @param path the cache file, it need not exist.
+    /// @param context the request parameters, other than the accession, that affect the result.
+    /// @param ttl how long, in seconds, a new result can be used.
+    SDLCache(std::string const &path, std::string const &context, unsigned ttl);
+
+    /// @brief look up an accession.
+    /// @returns true and appends the result if the accession was found and is not expired.
+    bool find(std::string const &accession, Response2::Results &results) const;
+
+    /// @brief remember a result, if it can be cached.
+    /// @returns true if it was remembered.
+    bool store(Response2::ResultEntry const &result);
+
+    /// @brief true if there are new results to be saved.
+    bool modified() const { return !added.empty(); }
+
+    /// @brief merge the new results into the cache file, as it is now.
+    /// @returns false if the file could not be written.
+    bool save() const;
+
+    /// @brief only successful results without expiring (signed) links are cached.
+    static bool cacheable(Response2::ResultEntry const &result);
+};
@@ -149,6 +149,104 @@ int Response2::ResultEntry::getCacheFor(Flattened const &match) const
     return result;
 }
 
+static void appendJSONString(std::string &out, std::string const &value)
+{
+    static char const hex[] = "0123456789abcdef";
+
+    out += '"';
+    for (auto const ch : value) {
+        switch (ch) {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if ((unsigned char)ch < 0x20) {
+                out += "\\u00";
+                out += hex[(ch >> 4) & 0x0F];
+                out += hex[ch & 0x0F];
+            }
+            else
+                out += ch;
+            break;
+        }
+    }
+    out += '"';
+}
+
+static void appendMember(std::string &out, char const *name, std::string const &value)
+{
+    out += ",\"";
+    out += name;
+    out += "\":";
+    appendJSONString(out, value);
+}
+
+static void appendMember(std::string &out, char const *name, opt_string const &value)
+{
+    if (value)
+        appendMember(out, name, value.value());
+}
+
+static void appendMember(std::string &out, char const *name, bool value)
+{
+    out += ",\"";
+    out += name;
+    out += value ? "\":true" : "\":false";
+}
+
+std::string Response2::ResultEntry::toJSON() const
+{
+    auto result = std::string("{\"bundle\":");
+
+    appendJSONString(result, query);
+    result += ",\"status\":" + status; // status is a number and is kept as it was received
+    appendMember(result, "msg", message);
+    result += ",\"files\":[";
+    for (auto const &file : files) {
+        if (&file != &files.front())
+            result += ',';
+        result += "{\"name\":";
+        appendJSONString(result, file.name);
+        appendMember(result, "type", file.type);
+        appendMember(result, "object", file.object);
+        if (file.size)
+            result += ",\"size\":" + file.size.value(); // raw JSON value
+        appendMember(result, "md5", file.md5);
+        appendMember(result, "format", file.format);
+        appendMember(result, "modificationDate", file.modificationDate);
+        appendMember(result, "noqual", file.noqual);
+        result += ",\"locations\":[";
+        for (auto const &location : file.locations) {
+            if (&location != &file.locations.front())
+                result += ',';
+            result += "{\"link\":";
+            appendJSONString(result, location.link);
+            appendMember(result, "service", location.service);
+            appendMember(result, "region", location.region);
+            appendMember(result, "expirationDate", location.expirationDate);
+            appendMember(result, "encryptedForProjectId", location.projectId);
+            appendMember(result, "ceRequired", location.ceRequired);
+            appendMember(result, "payRequired", location.payRequired);
+            result += '}';
+        }
+        result += "]}";
+    }
+    result += "]}";
+    return result;
+}
+
 using Response2Data = Response2;
 namespace impl {
 /// @brief parses SDL version 2 response
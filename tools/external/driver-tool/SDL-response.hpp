@@ -142,6 +142,10 @@ struct Response2 {
         /// \returns -1 if none found, else index in flattened.
         int getCacheFor(Flattened const &match) const;
 
+        /// @brief re-encode as an element of a SDL version 2 result array.
+        /// @Note round-trips through `Response2::makeFrom`.
+        std::string toJSON() const;
+
         ResultEntry(std::string const &query, std::string const &status, std::string const &message, Files const &files)
         : query(query)
         , status(status)
@@ -53,6 +53,15 @@ struct resolver {
     static constexpr char const *url() { return "https://trace.ncbi.nlm.nih.gov/Traces/sdl/2/retrieve"; }
 #endif
 
+    /// @brief the number of terms sent in one request to SDL
+    static constexpr unsigned batch_size() { return 200; }
+
+    /// @brief the number of requests to SDL that can be in flight at one time
+    static constexpr unsigned threads() { return 4; }
+
+    /// @brief how long, in seconds, a cached SDL result can be used
+    static constexpr unsigned cache_ttl() { return 24 * 60 * 60; }
+
     /// @brief the current unstable version of SDL response JSON
     ///
     /// @Note THIS NEEDS TO TRACK ACTUAL SDL VALUE
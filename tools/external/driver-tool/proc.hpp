@@ -33,6 +33,8 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <utility>
 #include "util.hpp"
 #include "file-path.hpp"
 #include "command-line.hpp"
@@ -148,9 +150,7 @@ private:
         return toolName == "fastq-dump" ? "-V" : "--version";
     }
 #endif
-public:
-    
-    static ExitStatus runTool(CommandLine const &cmd, UniqueOrderedList<int> const &skip, Dictionary const &env)
+    static std::vector<API_Char const *> toolArgs(CommandLine const &cmd, UniqueOrderedList<int> const &skip)
     {
         auto j = skip.begin();
         auto const srcArgs = args(cmd);
@@ -166,9 +166,50 @@ public:
                 ++j;
         }
         args.push_back(nullptr);
-        
+        return args;
+    }
+    Process_(IMPL const &impl) : IMPL(impl) {}
+public:
+    
+    static ExitStatus runTool(CommandLine const &cmd, UniqueOrderedList<int> const &skip, Dictionary const &env)
+    {
+        auto const args = toolArgs(cmd, skip);
         return runChildAndWait(cmd.toolPath, cmd.toolName, args.data(), env);
     }
+#if !WINDOWS
+    /// @brief Start the tool without waiting for it.
+    ///
+    /// @param out the file descriptor for the child's stdout
+    /// @param err the file descriptor for the child's stderr
+    static Process_ runToolInBackground(CommandLine const &cmd, UniqueOrderedList<int> const &skip, Dictionary const &env, int out, int err)
+    {
+        auto const args = toolArgs(cmd, skip);
+        return Process_(IMPL::runChildInBackground(cmd.toolPath, cmd.toolName, args.data(), env, out, err));
+    }
+    /// @brief Wait for whichever of the children finishes first.
+    static std::pair<Process_, ExitStatus> waitAny(std::vector<Process_> const &children)
+    {
+        auto impls = std::vector<IMPL>();
+        impls.reserve(children.size());
+        for (auto && child : children)
+            impls.push_back(static_cast<IMPL const &>(child));
+
+        auto const result = IMPL::waitAny(impls);
+        return {Process_(result.first), ExitStatus(result.second)};
+    }
+    static int temporaryFile() {
+        return IMPL::temporaryFile();
+    }
+    static void copyFile(int from, int to) {
+        IMPL::copyFile(from, to);
+    }
+    void terminate() const {
+        IMPL::terminate();
+    }
+    bool operator ==(Process_ const &other) const {
+        return IMPL::id() == other.IMPL::id();
+    }
+#endif
     static void execVersion [[noreturn]] (CommandLine const &cmd)
     {
         API_Char const *args[] = {
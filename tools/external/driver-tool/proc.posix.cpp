@@ -48,6 +48,7 @@
 #include <cstdio>
 
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <sysexits.h>
 #include <signal.h>
@@ -182,6 +183,51 @@ static int waitpid_with_signal_forwarding(pid_t const pid, int *const status)
     return rc;
 }
 
+static pid_t const *forward_targets;
+static size_t forward_targets_count;
+static void sig_handler_for_waiting_any(int sig)
+{
+    for (size_t i = 0; i < forward_targets_count; ++i)
+        kill(forward_targets[i], sig);
+}
+
+/// @brief wait for any child, SIGINT is forwarded to all of the children
+///
+/// @note like waitpid_with_signal_forwarding, not reentrant
+static pid_t waitany_with_signal_forwarding(std::vector<pid_t> const &pids, int *const status)
+{
+    struct sigaction act, old;
+
+    static std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    auto const was_locked = lock.test_and_set();
+    assert(was_locked == false);
+    if (was_locked)
+        throw std::logic_error("NOT REENTRANT!!!");
+
+    forward_targets = pids.data();
+    forward_targets_count = pids.size();
+
+    act.sa_handler = sig_handler_for_waiting_any;
+    sigemptyset(&act.sa_mask);
+    act.sa_flags = 0;
+
+    if (sigaction(SIGINT, &act, &old) < 0)
+        throw_system_error("sigaction failed");
+
+    auto const rc = waitpid(-1, status, 0);
+    auto const save_errno = errno;
+
+    if (sigaction(SIGINT, &old, nullptr))
+        throw_system_error("sigaction failed");
+
+    forward_targets_count = 0;
+    forward_targets = nullptr;
+    lock.clear();
+
+    errno = save_errno;
+    return rc;
+}
+
 namespace POSIX {
 
 #define CASE_SIGNAL(SIG) case SIG: return "" # SIG
@@ -270,6 +316,92 @@ Process::ExitStatus Process::runChildAndWait(::FilePath const &toolpath, std::st
     return Process(pid).wait();
 }
 
+Process Process::runChildInBackground(::FilePath const &toolpath, std::string const &toolname, char const *const *argv, Dictionary const &env, int out, int err)
+{
+    // anything still buffered would be written by both processes
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(stdout);
+    fflush(stderr);
+
+    auto const pid = ::fork();
+    if (pid < 0)
+        throw_system_error("fork failed");
+    if (pid == 0) {
+        if (dup2(out, 1) < 0 || dup2(err, 2) < 0)
+            _exit(EX_OSERR);
+        close(out);
+        close(err);
+        runChild(toolpath, toolname, argv, env);
+    }
+    return Process(pid);
+}
+
+std::pair<Process, Process::ExitStatus> Process::waitAny(std::vector<Process> const &children)
+{
+    assert(!children.empty());
+    if (children.empty())
+        throw std::logic_error("no children to wait on!");
+
+    auto pids = std::vector<pid_t>();
+    pids.reserve(children.size());
+    for (auto && child : children)
+        pids.push_back(child.pid);
+
+    do { // loop if wait is interrupted
+        auto status = int(0);
+        auto const rc = waitany_with_signal_forwarding(pids, &status);
+
+        if (rc > 0)
+            return {Process(rc), ExitStatus(status)};
+
+        assert(rc != 0); // only happens if WNOHANG is given
+    } while (errno == EINTR);
+
+    throw_system_error("waitpid failed");
+}
+
+int Process::temporaryFile()
+{
+    auto const tmpdir = getenv("TMPDIR");
+    auto name = std::string((tmpdir && *tmpdir) ? tmpdir : "/tmp") + "/sratools.XXXXXX";
+    auto const fd = mkstemp(&name[0]);
+    if (fd < 0)
+        throw_system_error("failed to create temporary file");
+
+    unlink(name.c_str());
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return fd;
+}
+
+void Process::copyFile(int from, int to)
+{
+    char buffer[64 * 1024];
+
+    if (lseek(from, 0, SEEK_SET) < 0)
+        throw_system_error("lseek failed");
+
+    for ( ; ; ) {
+        auto const nread = ::read(from, buffer, sizeof(buffer));
+        if (nread == 0)
+            return;
+        if (nread < 0) {
+            if (errno == EINTR)
+                continue;
+            throw_system_error("read failed");
+        }
+        for (auto offset = ssize_t(0); offset < nread; ) {
+            auto const nwrit = ::write(to, buffer + offset, nread - offset);
+            if (nwrit < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw_system_error("write failed");
+            }
+            offset += nwrit;
+        }
+    }
+}
+
 #if 0
 process::exit_status process::run_child_and_get_stdout(std::string *out, FilePath const &toolpath, char const *toolname, char const **argv, bool const for_real, Dictionary const &env)
 {
@@ -38,6 +38,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <utility>
 
 #include <signal.h>
 #include <sys/wait.h>
@@ -122,6 +123,38 @@ struct Process {
     static void runChild [[noreturn]] (::FilePath const &toolpath, std::string const &toolname, char const *const *argv, Dictionary const &env);
     static ExitStatus runChildAndWait(::FilePath const &toolpath, std::string const &toolname, char const *const *argv, Dictionary const &env);
 
+    /// @brief fork and exec, does not wait
+    ///
+    /// @param out file descriptor to become the child's stdout
+    /// @param err file descriptor to become the child's stderr
+    ///
+    /// @return the child process
+    static Process runChildInBackground(::FilePath const &toolpath, std::string const &toolname, char const *const *argv, Dictionary const &env, int out, int err);
+
+    /// @brief wait for any of the children, forwarding SIGINT to all of them
+    ///
+    /// @param children the running children
+    ///
+    /// @return the child that finished and its exit status
+    /// @throw system_error if wait fails
+    static std::pair<Process, ExitStatus> waitAny(std::vector<Process> const &children);
+
+    /// @brief an anonymous temporary file, it is closed on exec
+    ///
+    /// @return the file descriptor
+    /// @throw system_error if the file can not be created
+    static int temporaryFile();
+
+    /// @brief copy the whole file to another file descriptor, e.g. stdout
+    ///
+    /// @throw system_error if read or write fails
+    static void copyFile(int from, int to);
+
+    /// @brief ask the process to terminate
+    void terminate() const { kill(pid, SIGTERM); }
+
+    pid_t id() const { return pid; }
+
     Process(Process const &) = default;
     Process &operator =(Process const &) = default;
     Process(Process &&) = default;
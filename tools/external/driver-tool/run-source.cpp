@@ -39,6 +39,10 @@
 #include <utility>
 #include <algorithm>
 #include <functional>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <exception>
 #include <cstdint>
 
 #include "globals.hpp"
@@ -50,6 +54,7 @@
 #include "opt_string.hpp"
 #include "run-source.hpp"
 #include "SDL-response.hpp"
+#include "SDL-cache.hpp"
 #include "sratools.hpp"
 
 #include "service.hpp"
@@ -67,15 +72,37 @@ static std::string config_or_default(char const *const config_node, char const *
     return from_config ? from_config.value() : default_value;
 }
 
+static unsigned config_or_default(char const *const config_node, unsigned const default_value)
+{
+    auto const &from_config = config->get(config_node);
+    if (from_config) {
+        try {
+            return (unsigned)std::stoul(from_config.value());
+        }
+        catch (...) {
+            LOG(1) << "ignoring invalid value for " << config_node << std::endl;
+        }
+    }
+    return default_value;
+}
+
+/// @brief The SDL service to ask and the version of its protocol.
+static std::string SDL_url()
+{
+    return config_or_default("/repository/remote/main/SDL.2/resolver-cgi", resolver::url());
+}
+
+static std::string SDL_version()
+{
+    return config_or_default("/repository/remote/version", resolver::version());
+}
+
 // convert to a virtual method on Service, pass Service to preload and ctors
-static Service::Response get_SDL_response(std::vector<std::string> const &runs, bool const haveCE)
+static Service::Response get_SDL_response(std::vector<std::string> const &runs, bool const haveCE, std::string const &url_string, std::string const &version_string)
 {
     if (runs.empty())
         throw std::domain_error("No query");
 
-    auto const &version_string = config_or_default("/repository/remote/version", resolver::version());
-    auto const &url_string = config_or_default("/repository/remote/main/SDL.2/resolver-cgi", resolver::url());
-
     assert(!runs.empty());
 
     auto const query = Service::make();
@@ -93,6 +120,99 @@ static Service::Response get_SDL_response(std::vector<std::string> const &runs,
     return query.response(url_string, version_string);
 }
 
+/// @brief Sends the terms to SDL in batches, several batches at a time.
+/// @returns the results from all the batches.
+/// @Note The first error, in batch order, is rethrown on the calling thread.
+static Response2::Results get_SDL_results(std::vector<std::string> const &runs, bool const haveCE)
+{
+    if (runs.empty())
+        throw std::domain_error("No query");
+
+    auto const &version_string = SDL_version();
+    auto const &url_string = SDL_url();
+    auto const batchSize = std::max(1u, config_or_default("/repository/remote/main/SDL.2/batch-size", resolver::batch_size()));
+    auto const batches = (runs.size() + batchSize - 1) / batchSize;
+    auto const threads = std::min<size_t>(batches, std::min(64u, std::max(1u, config_or_default("/repository/remote/main/SDL.2/threads", resolver::threads()))));
+    auto responses = std::vector<std::string>(batches);
+    auto errors = std::vector<std::exception_ptr>(batches);
+    auto const resolve = [&](size_t const batch) {
+        try {
+            auto const first = runs.begin() + batch * batchSize;
+            auto const last = runs.size() - batch * batchSize > batchSize ? first + batchSize : runs.end();
+            auto const response = get_SDL_response(std::vector<std::string>(first, last), haveCE, url_string, version_string);
+
+            responses[batch] = response.responseText();
+        }
+        catch (...) {
+            errors[batch] = std::current_exception();
+        }
+    };
+
+    LOG(2) << "sending " << runs.size() << " terms to SDL in " << batches << " requests, " << threads << " at a time" << std::endl;
+    if (threads < 2) {
+        for (size_t batch = 0; batch < batches; ++batch)
+            resolve(batch);
+    }
+    else {
+        std::atomic<size_t> next(0);
+        auto workers = std::vector<std::thread>();
+
+        for (size_t i = 0; i < threads; ++i) {
+            workers.emplace_back([&]() {
+                for (auto batch = next++; batch < batches; batch = next++)
+                    resolve(batch);
+            });
+        }
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    auto results = Response2::Results();
+    for (size_t batch = 0; batch < batches; ++batch) {
+        if (errors[batch])
+            std::rethrow_exception(errors[batch]);
+
+        LOG(8) << "SDL response:\n" << responses[batch] << std::endl;
+
+        auto const parsed = Response2::makeFrom(responses[batch]);
+        results.insert(results.end(), parsed.results.begin(), parsed.results.end());
+    }
+    LOG(7) << "Parsed SDL Response" << std::endl;
+    return results;
+}
+
+/// @brief The persistent SDL result cache, if one is configured and the results are shareable.
+/// @Note Results that depend on the user's credentials (CE token, cart, ngc) are never cached.
+static std::unique_ptr<SDLCache> get_SDL_cache(bool const haveCE)
+{
+    auto const &path = config->get("/repository/remote/main/SDL.2/cache-file");
+    if (!path || path.value().empty())
+        return std::unique_ptr<SDLCache>();
+
+    if (haveCE || perm || ngc) {
+        LOG(3) << "not using the SDL cache, the results depend on the user's credentials" << std::endl;
+        return std::unique_ptr<SDLCache>();
+    }
+
+    // a result is only good for the service and the protocol version that gave it
+    auto context = SDL_url() + '\t' + SDL_version() + '\t';
+    if (location)
+        context += *location;
+    switch (Service::preferredQualityType()) {
+    case vdb::Service::full:
+        context += "\tfull";
+        break;
+    case vdb::Service::none:
+        context += "\tnone";
+        break;
+    default:
+        context += "\tunknown";
+        break;
+    }
+    auto const ttl = config_or_default("/repository/remote/main/SDL.2/cache-ttl", resolver::cache_ttl());
+    return std::unique_ptr<SDLCache>(new SDLCache(path.value(), context, ttl));
+}
+
 struct RemoteKey {
     std::string prefix;
     std::string filePath;
@@ -497,12 +617,30 @@ data_sources::data_sources(CommandLine const &cmdline, Arguments const &args, bo
             LOG(2) << "will send " << terms.size() << " terms to SDL" << std::endl;
         }
         try {
-            auto const response = get_SDL_response(terms, have_ce_token);
-            LOG(8) << "SDL response:\n" << response << std::endl;
+            auto results = Response2::Results();
+            auto const cache = get_SDL_cache(have_ce_token);
 
-            auto const parsed = Response2::makeFrom(response.responseText());
-            LOG(7) << "Parsed SDL Response" << std::endl;
-            for (auto const &sdl_result : parsed.results) {
+            if (cache) {
+                auto const before = terms.size();
+
+                terms.erase(std::remove_if(terms.begin(), terms.end(), [&](std::string const &term) {
+                    return cache->find(term, results);
+                }), terms.end());
+                LOG(2) << before - terms.size() << " terms were found in the SDL cache" << std::endl;
+            }
+            if (!terms.empty()) {
+                auto const fetched = get_SDL_results(terms, have_ce_token);
+
+                if (cache) {
+                    for (auto const &sdl_result : fetched)
+                        cache->store(sdl_result);
+                    if (cache->modified() && !cache->save()) {
+                        LOG(1) << "Failed to save the SDL cache" << std::endl;
+                    }
+                }
+                results.insert(results.end(), fetched.begin(), fetched.end());
+            }
+            for (auto const &sdl_result : results) {
                 auto const &query = sdl_result.query;
                 auto &info = queryInfo[query];
 
@@ -412,6 +412,190 @@ static auto constexpr zeroQualityName = "Lite";
 static auto constexpr fullQualityDesc = "full base quality scores";
 static auto constexpr zeroQualityDesc = "simplified base quality scores";
 
+static void printQualityType(char const *const acc, data_sources::accession::info const &src)
+{
+    auto const name = src.haveFullQuality() ? fullQualityName : zeroQualityName;
+    auto const desc = src.haveFullQuality() ? fullQualityDesc : zeroQualityDesc;
+    std::cerr << acc << " is an SRA " << name << " file with " << desc << ".\n";
+}
+
+template <typename SOURCES>
+static void printNoData(char const *const acc, SOURCES const &sources)
+{
+    std::cerr << "Could not get any data for " << acc << ", tried to get data from:" << std::endl;
+    for (auto i : sources) {
+        std::cerr << '\t' << i.service << std::endl;
+    }
+    std::cerr << "This may be temporary, retry later." << std::endl;
+}
+
+#if !WINDOWS
+/// @brief The number of accessions to run at the same time.
+///
+/// From `SRATOOLS_JOBS` or else `/tools/sratools/jobs`; the default, 1, runs them one at a time.
+static unsigned jobCount()
+{
+    auto value = EnvironmentVariables::get("SRATOOLS_JOBS");
+    if (!value)
+        value = config->get("/tools/sratools/jobs");
+    if (value) {
+        try {
+            return (unsigned)std::min(64ul, std::max(1ul, std::stoul(value.value())));
+        }
+        catch (...) {
+            LOG(1) << "ignoring invalid value for jobs: " << value.value() << std::endl;
+        }
+    }
+    return 1;
+}
+
+/// @brief Do the tools write to a place that all the accessions would share.
+static bool writesSharedOutput(Arguments const &args)
+{
+    return args.any("output-file") || args.any("outfile") || args.any("output-path");
+}
+
+/// @brief Do the tools write their data to stdout.
+///
+/// fastq-dump and fasterq-dump write files, unless they are told otherwise;
+/// the other driven tools write everything to stdout.
+static bool writesDataToStdout(std::string const &toolName, Arguments const &args)
+{
+    if (toolName == "fastq-dump" || toolName == "fasterq-dump")
+        return args.any("stdout");
+    return true;
+}
+
+/// @brief Run the driven tool for several accessions at the same time.
+///
+/// Each child writes to temporary files, which are copied to stdout and stderr
+/// in the order of the accessions on the command line, once the accession is done.
+/// The retrying of sources and the exit codes are the same as when the accessions
+/// are run one after another.
+static int runConcurrently(CommandLine const &argv, Arguments const &parsed, data_sources const &all_sources, unsigned const jobs, unsigned const verbosity)
+{
+    struct Job {
+        struct Attempt {
+            int out, err;
+        };
+        Argument const *arg;
+        std::vector<data_sources::accession::info> sources;
+        std::vector<Attempt> attempts;
+        std::vector<Process::ExitStatus> results; ///< of the attempts, as they finish
+        bool finished;
+    };
+    auto queue = std::vector<Job>();
+    auto running = std::vector<Process>();
+    auto runningJob = std::vector<size_t>();
+
+    parsed.eachArgument([&](Argument const &arg) {
+        auto job = Job{ &arg, {}, {}, {}, false };
+        for (auto src : all_sources[arg.argument])
+            job.sources.push_back(src);
+        job.finished = job.sources.empty();
+        queue.emplace_back(std::move(job));
+    });
+
+    auto const start = [&](size_t const index) {
+        auto &job = queue[index];
+        auto const &src = job.sources[job.attempts.size()];
+        auto const attempt = Job::Attempt{ Process::temporaryFile(), Process::temporaryFile() };
+
+        job.attempts.push_back(attempt);
+        running.push_back(Process::runToolInBackground(argv, parsed.keep(*job.arg), src.environment, attempt.out, attempt.err));
+        runningJob.push_back(index);
+    };
+    auto const stop = [&]() {
+        for (auto && child : running)
+            child.terminate();
+        for (auto && child : running)
+            child.wait();
+        running.clear();
+        runningJob.clear();
+    };
+    /// @return -1 to keep going, else the exit code
+    auto const report = [&](Job &job) -> int {
+        auto const acc = job.arg->argument;
+        auto rc = EX_TEMPFAIL;
+
+        for (auto i = size_t(0); i < job.attempts.size(); ++i) {
+            auto const &src = job.sources[i];
+            auto const &attempt = job.attempts[i];
+            auto const &result = job.results[i];
+
+            if (verbosity > 0 && src.haveQualityType())
+                printQualityType(acc, src);
+
+            std::cout.flush();
+            std::cerr.flush();
+            Process::copyFile(attempt.out, 1);
+            Process::copyFile(attempt.err, 2);
+            close(attempt.out);
+            close(attempt.err);
+
+            if (rc != EX_TEMPFAIL)
+                continue; // the remaining attempts only need closing
+            if (result.didExitNormally()) {
+                LOG(2) << "Processed " << acc << " with data from " << src.service << std::endl;
+                rc = -1;
+                continue;
+            }
+            if (result.didExit()) {
+                auto const exit_code = result.exitCode();
+                if (exit_code == EX_TEMPFAIL) {
+                    LOG(1) << "Failed to get data for " << acc << " from " << src.service << std::endl;
+                    continue;
+                }
+                std::cerr << argv.toolName << " quit with error code " << exit_code << std::endl;
+                rc = exit_code;
+                continue;
+            }
+            // was killed or something
+            rc = result.exitCode();
+        }
+        if (rc == EX_TEMPFAIL)
+            printNoData(acc, job.sources);
+        return rc;
+    };
+
+    auto nextToStart = size_t(0);
+    auto nextToReport = size_t(0);
+    while (nextToReport < queue.size()) {
+        // don't let finished but unreported accessions pile up behind a slow one
+        while (running.size() < jobs && nextToStart < queue.size() && nextToStart < nextToReport + 4 * jobs) {
+            if (!queue[nextToStart].finished)
+                start(nextToStart);
+            ++nextToStart;
+        }
+        if (queue[nextToReport].finished) {
+            auto const rc = report(queue[nextToReport++]);
+            if (rc >= 0) {
+                stop();
+                return rc;
+            }
+            continue;
+        }
+        auto const done = Process::waitAny(running);
+        auto const fnd = std::find(running.begin(), running.end(), done.first);
+        if (fnd == running.end())
+            continue; // not one of ours
+
+        auto const index = runningJob[fnd - running.begin()];
+        auto &job = queue[index];
+
+        runningJob.erase(runningJob.begin() + (fnd - running.begin()));
+        running.erase(fnd);
+
+        job.results.push_back(done.second);
+        if (done.second.didExit() && done.second.exitCode() == EX_TEMPFAIL && job.attempts.size() < job.sources.size())
+            start(index);
+        else
+            job.finished = true;
+    }
+    return 0;
+}
+#endif
+
 static int main(CommandLine const &argv)
 {
 #if DEBUG || _DEBUGGING
@@ -519,6 +703,16 @@ static int main(CommandLine const &argv)
 
         all_sources.set_ce_token_env_var();
 
+#if !WINDOWS
+        // MARK: Run several accessions at a time if asked to.
+        // The output of each child is spooled to $TMPDIR until its turn comes,
+        // that is only cheap when the data goes to files and not to stdout.
+        if (parsed.countOfCommandArguments() > 1 && !writesSharedOutput(parsed) && !writesDataToStdout(argv.toolName, parsed)) {
+            auto const jobs = jobCount();
+            if (jobs > 1)
+                return runConcurrently(argv, parsed, all_sources, jobs, verbosity);
+        }
+#endif
         for (auto const &arg : parsed) {
             if (!arg.isArgument()) continue;
 
@@ -527,11 +721,8 @@ static int main(CommandLine const &argv)
             auto success = false;
 
             for (auto src : sources) {
-                if (verbosity > 0 && src.haveQualityType()) {
-                    auto const name = src.haveFullQuality() ? fullQualityName : zeroQualityName;
-                    auto const desc = src.haveFullQuality() ? fullQualityDesc : zeroQualityDesc;
-                    std::cerr << acc << " is an SRA " << name << " file with " << desc << ".\n";
-                }
+                if (verbosity > 0 && src.haveQualityType())
+                    printQualityType(acc, src);
                 // MARK: Run the driven tool
                 auto const result = Process::runTool(argv, parsed.keep(arg), src.environment);
                 if (result.didExitNormally()) {
@@ -552,11 +743,7 @@ static int main(CommandLine const &argv)
                 exit(result.exitCode());
             }
             if (!success) {
-                std::cerr << "Could not get any data for " << acc << ", tried to get data from:" << std::endl;
-                for (auto i : sources) {
-                    std::cerr << '\t' << i.service << std::endl;
-                }
-                std::cerr << "This may be temporary, retry later." << std::endl;
+                printNoData(acc, sources);
                 return EX_TEMPFAIL;
             }
         }
@@ -37,8 +37,6 @@
 #include <klib/rc.h>
 
 #include <kdb/table.h>
-#include <kproc/thread.h>
-#include <kproc/lock.h>
 
 #ifdef _WIN32
 #pragma warning (disable:4503)
@@ -1041,6 +1039,19 @@ namespace Utils
     }
 
 
+    static void LogErrorRC ( char const* what, rc_t rc )
+    {
+        char szBufErr[512] = "";
+        rc_t res;
+        if (rc != 0)
+            res = string_printf(szBufErr, countof(szBufErr), NULL, "ERROR: %s failed with error 0x%08x (%u) [%R]", what, rc, rc, rc);
+        else
+            res = string_printf(szBufErr, countof(szBufErr), NULL, "ERROR: %s", what);
+        if (res == rcBuffer || res == rcInsufficient)
+            szBufErr[countof(szBufErr) - 1] = '\0';
+        LOGMSG ( klogErr, szBufErr );
+    }
+
     void HandleException ()
     {
         try
@@ -1049,16 +1060,11 @@ namespace Utils
         }
         catch (Utils::CErrorMsg const& e)
         {
-            char szBufErr[512] = "";
-            size_t rc = e.getRC();
-            rc_t res;
-            if (rc != 0)
-                res = string_printf(szBufErr, countof(szBufErr), NULL, "ERROR: %s failed with error 0x%08x (%u) [%R]", e.what(), rc, rc, rc);
-            else
-                res = string_printf(szBufErr, countof(szBufErr), NULL, "ERROR: %s", e.what());
-            if (res == rcBuffer || res == rcInsufficient)
-                szBufErr[countof(szBufErr) - 1] = '\0';
-            LOGMSG ( klogErr, szBufErr );
+            LogErrorRC ( e.what(), e.getRC() );
+        }
+        catch (KProc::CKProcError const& e)
+        {
+            LogErrorRC ( e.what(), e.getRC() );
         }
         catch (std::exception const& e)
         {
@@ -1297,162 +1303,3 @@ namespace KSearch
         return obj;
     }
 }
-
-namespace KProc
-{
-    rc_t KThreadFunc ( KThread const* , void* data )
-    {
-        CKThread* obj = static_cast<CKThread*>(data);
-
-        return ( * obj -> m_ThreadFunc ) ( obj -> m_pData );
-    }
-
-    CKThread::CKThread ()
-        : m_pSelf(NULL), m_ThreadFunc(NULL), m_pData(NULL)
-    {
-    }
-
-    CKThread::~CKThread()
-    {
-        Release();
-    }
-    CKThread::CKThread(CKThread const& x)
-    {
-        Clone(x);
-    }
-    CKThread& CKThread::operator=(CKThread const& x)
-    {
-        if (m_pSelf)
-            Release();
-
-        Clone(x);
-        return *this;
-    }
-
-    void CKThread::Release()
-    {
-        if (m_pSelf)
-        {
-#if DEBUG_PRINT != 0
-            printf("Releasing KThread %p\n", m_pSelf);
-#endif
-            ::KThreadRelease(m_pSelf);
-            m_pSelf = NULL;
-            m_ThreadFunc = NULL;
-            m_pData = NULL;
-        }
-    }
-    void CKThread::Clone(CKThread const& x)
-    {
-        m_pSelf = x.m_pSelf;
-        m_ThreadFunc = x.m_ThreadFunc;
-        m_pData = x.m_pData;
-
-        if ( m_pSelf != NULL )
-        {
-            ::KThreadAddRef ( m_pSelf );
-#if DEBUG_PRINT != 0
-            printf ("CLONING KThread %p\n", m_pSelf);
-#endif
-        }
-    }
-
-    void CKThread::Make ( THREAD_FUNC thread_func, void* data )
-    {
-        assert (m_pSelf == NULL);
-        assert (m_ThreadFunc == NULL);
-        assert (m_pData == NULL);
-
-        m_ThreadFunc = thread_func;
-        m_pData = data;
-
-        rc_t rc = ::KThreadMakeStackSize ( & m_pSelf, KThreadFunc, this, 0 );
-        if (rc)
-            throw Utils::CErrorMsg(rc, "KThreadMake");
-    }
-
-    rc_t CKThread::Wait ()
-    {
-        rc_t status;
-        rc_t rc = ::KThreadWait ( m_pSelf, & status );
-        if (rc)
-            throw Utils::CErrorMsg(rc, "KThreadWait");
-
-        return status;
-    }
-
-///////////////////////////////////////////////////////
-
-    CKLock::CKLock ( )
-    {
-        rc_t rc = ::KLockMake ( & m_pSelf );
-        if (rc)
-            throw Utils::CErrorMsg(rc, "KLockMake");
-    }
-
-    CKLock::~CKLock()
-    {
-        Release();
-    }
-
-    CKLock::CKLock(CKLock const& x)
-    {
-        Clone(x);
-    }
-    CKLock& CKLock::operator=(CKLock const& x)
-    {
-        if (m_pSelf)
-            Release();
-
-        Clone(x);
-        return *this;
-    }
-
-    void CKLock::Release()
-    {
-        if (m_pSelf)
-        {
-#if DEBUG_PRINT != 0
-            printf("Releasing KLock %p\n", m_pSelf);
-#endif
-            ::KLockRelease(m_pSelf);
-            m_pSelf = NULL;
-        }
-    }
-    void CKLock::Clone(CKLock const& x)
-    {
-        m_pSelf = x.m_pSelf;
-        ::KLockAddRef ( m_pSelf );
-#if DEBUG_PRINT != 0
-        printf ("CLONING KLock %p\n", m_pSelf);
-#endif
-    }
-
-    void CKLock::Acquire ()
-    {
-        rc_t rc = ::KLockAcquire ( m_pSelf );
-        if (rc)
-            throw Utils::CErrorMsg(rc, "KLockAcquire");
-    }
-
-    void CKLock::Lock ()
-    {
-        Acquire ();
-    }
-
-    void CKLock::Unlock ()
-    {
-        rc_t rc = ::KLockUnlock ( m_pSelf );
-        if (rc)
-            throw Utils::CErrorMsg(rc, "KLockUnlock");
-    }
-
-    void CKLock::lock ()
-    {
-        Lock();
-    }
-    void CKLock::unlock ()
-    {
-        Unlock();
-    }
-}
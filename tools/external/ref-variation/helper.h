@@ -49,6 +49,7 @@
 #include <search/ref-variation.h>
 
 #include <loader/progressbar.h>
+#include <kproc.hpp>
 
 #ifndef countof
 #define countof(arr) (sizeof(arr)/sizeof(arr[0]))
@@ -528,77 +529,4 @@ namespace KSearch
 
 }
 
-struct KThread;
-struct KLock;
-
-namespace KProc
-{
-    class CKThread
-    {
-    public:
-
-        friend rc_t KThreadFunc ( ::KThread const* self, void* data );
-
-        typedef rc_t (*THREAD_FUNC) ( void* data );
-
-        CKThread ();
-        ~CKThread ();
-        CKThread (CKThread const& x);
-        CKThread& operator= (CKThread const& x);
-
-        void Make ( THREAD_FUNC thread_func, void* data );
-        void Release();
-
-        rc_t Wait ();
-
-    private:
-        void Clone(CKThread const& x);
-        ::KThread* m_pSelf;
-
-        THREAD_FUNC m_ThreadFunc;
-        void* m_pData;
-    };
-
-    class CKLock
-    {
-    public:
-        CKLock ();
-        ~CKLock ();
-        CKLock (CKLock const& x);
-        CKLock& operator= (CKLock const& x);
-
-        void Release();
-
-        void Acquire ();
-        void Lock ();
-        void Unlock ();
-
-        // for compatibility with standard library
-        void lock();
-        void unlock();
-
-    private:
-        void Clone(CKLock const& x);
-        ::KLock* m_pSelf;
-    };
-
-    template <class TLockable> class CLockGuard
-    {
-    public:
-        CLockGuard ( TLockable & lock ) : m_lock (lock)
-        {
-            m_lock.lock();
-        }
-        ~CLockGuard ( )
-        {
-            m_lock.unlock();
-        }
-
-        CLockGuard( CLockGuard<TLockable> const& x );
-        CLockGuard<TLockable>& operator=( CLockGuard<TLockable> const& x );
-
-    private:
-        TLockable & m_lock;
-    };
-}
 #endif
\ No newline at end of file
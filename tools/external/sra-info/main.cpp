@@ -54,6 +54,8 @@ using namespace std;
 #define OPTION_DETAIL       "detail"
 #define OPTION_SEQUENCE     "sequence"
 #define OPTION_ROWS         "rows"
+#define OPTION_THREADS      "threads"
+#define OPTION_CACHE        "summary-cache"
 
 #define ALIAS_PLATFORM      "P"
 #define ALIAS_FORMAT        "f"
@@ -65,6 +67,8 @@ using namespace std;
 #define ALIAS_DETAIL        "D"
 #define ALIAS_SEQUENCE      "s"
 #define ALIAS_ROWS          "R"
+#define ALIAS_THREADS       "t"
+#define ALIAS_CACHE         "c"
 
 static const char * platform_usage[]    = { "print platform(s)", nullptr };
 static const char * format_usage[]      = { "output format:", nullptr };
@@ -77,6 +81,8 @@ static const char * limit_usage[]       = { "limit output to <N> elements, e.g.
 static const char * detail_usage[]      = { "detail level, <0> the least detailed output; <N> must be 0 or greater", nullptr };
 static const char * sequence_usage[]    = { "use SEQUENCE table for spot layouts, even if CONSENSUS table is present", nullptr };
 static const char * rows_usage[]        = { "report spot layouts for the first <N> rows of the table", nullptr };
+static const char * threads_usage[]     = { "scan tables with <N> threads, default: one per core", nullptr };
+static const char * cache_usage[]       = { "keep the results of full table scans in directory <path>", "and reuse them on the next run", nullptr };
 
 OptDef InfoOptions[] =
 {
@@ -90,6 +96,8 @@ OptDef InfoOptions[] =
     { OPTION_DETAIL,        ALIAS_DETAIL,       nullptr, detail_usage,      1, true,    false, nullptr },
     { OPTION_SEQUENCE,      ALIAS_SEQUENCE,     nullptr, sequence_usage,    1, false,   false, nullptr },
     { OPTION_ROWS,          ALIAS_ROWS,         nullptr, rows_usage,        1, true,    false, nullptr },
+    { OPTION_THREADS,       ALIAS_THREADS,      nullptr, threads_usage,     1, true,    false, nullptr },
+    { OPTION_CACHE,         ALIAS_CACHE,        nullptr, cache_usage,       1, true,    false, nullptr },
 };
 
 const char UsageDefaultName[] = "sra-info";
@@ -143,6 +151,8 @@ rc_t CC Usage ( const Args * args )
     HelpOptionLine ( ALIAS_LIMIT,  OPTION_LIMIT, "N", limit_usage );
     HelpOptionLine ( ALIAS_DETAIL, OPTION_DETAIL, "N", detail_usage );
     HelpOptionLine ( ALIAS_ROWS,   OPTION_ROWS,  "N", rows_usage );
+    HelpOptionLine ( ALIAS_THREADS, OPTION_THREADS, "N", threads_usage );
+    HelpOptionLine ( ALIAS_CACHE,  OPTION_CACHE, "path", cache_usage );
 
     HelpOptionsStandard ();
 
@@ -281,6 +291,26 @@ rc_t CC KMain ( int argc, char *argv [] )
                 }
                 Formatter formatter( fmt, limit );
 
+                rc = ArgsOptionCount( args, OPTION_THREADS, &opt_count );
+                DISP_RC( rc, "ArgsOptionCount() failed" );
+                if ( opt_count > 0 )
+                {
+                    info.SetThreads( GetPositiveNumber( args, OPTION_THREADS ) );
+                }
+
+                rc = ArgsOptionCount( args, OPTION_CACHE, &opt_count );
+                DISP_RC( rc, "ArgsOptionCount() failed" );
+                if ( opt_count > 0 )
+                {
+                    const char* res = nullptr;
+                    rc = ArgsOptionValue( args, OPTION_CACHE, 0, ( const void** )&res );
+                    DISP_RC( rc, "ArgsOptionValue() failed" );
+                    if ( rc == 0 )
+                    {
+                        info.SetSummaryCache( res );
+                    }
+                }
+
                 Query q{};
 
                 {
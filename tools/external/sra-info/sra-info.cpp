@@ -28,6 +28,9 @@
 
 #include <algorithm>
 #include <map>
+#include <fstream>
+#include <cctype>
+#include <cstdio>
 
 using namespace std;
 
@@ -99,6 +102,29 @@ PlatformToString( const uint32_t id )
     return "unknown platform";
 }
 
+namespace
+{
+    // platform ids seen in a range of rows; runs of the same platform only cost a compare
+    struct PlatformIds
+    {
+        set<uint8_t> ids;
+        int last = -1;
+
+        void add( uint8_t id )
+        {
+            if ( id != last )
+            {
+                ids.insert( id );
+                last = id;
+            }
+        }
+        void merge( const PlatformIds & other )
+        {
+            ids.insert( other.ids.begin(), other.ids.end() );
+        }
+    };
+}
+
 SraInfo::Platforms
 SraInfo::GetPlatforms() const
 {
@@ -115,11 +141,22 @@ SraInfo::GetPlatforms() const
         }
         else
         {
-            auto get_platform = [&](VDB::Cursor::RowID row, const vector<VDB::Cursor::RawData>& values )
+            const RowRange rows = cursor.rowRange();
+            set<uint8_t> ids;
+            if ( ! loadPlatforms( rows, ids ) )
             {
-                ret.insert( PlatformToString( values[0].value<uint8_t>() ) );
-            };
-            cursor.foreach( get_platform );
+                auto get_platform = []( PlatformIds & acc, VDB::Cursor::RowID, const vector<VDB::Cursor::RawData>& values )
+                {
+                    acc.add( values[0].value<uint8_t>() );
+                };
+                auto merge = []( PlatformIds & total, const PlatformIds & part ) { total.merge( part ); };
+                ids = cursor.parallel_foreach< PlatformIds >( m_threads, get_platform, merge ).ids;
+                savePlatforms( rows, ids );
+            }
+            for ( auto id : ids )
+            {
+                ret.insert( PlatformToString( id ) );
+            }
         }
     }
     catch(const VDB::Error & e)
@@ -245,6 +282,152 @@ SraInfo::ReadStructure::Encode( Detail detail ) const
     }
 }
 
+namespace
+{
+    // counts spot layouts at Verbose detail. consecutive rows with the same layout are
+    // counted as one run, which makes a row that repeats the previous one (the common case
+    // and always the case within a blob of repeated cells) a compare without allocations
+    class LayoutCounter
+    {
+    public:
+        typedef map< SraInfo::ReadStructures, uint64_t > Counts;
+
+        void add( const VDB::Cursor::RawData & p_types, const VDB::Cursor::RawData & p_lengths, uint64_t p_rows = 1 )
+        {
+            VDB::Span<INSDC_read_type> types = p_types.span<INSDC_read_type>();
+            VDB::Span<uint32_t> lengths = p_lengths.span<uint32_t>();
+            assert(types.size() == lengths.size());
+            if ( m_run > 0 && same( types, lengths ) )
+            {
+                m_run += p_rows;
+                return;
+            }
+
+            flush();
+            m_current.clear(); // keeps the capacity
+            for ( size_t i = 0; i < types.size(); ++i )
+            {
+                m_current.push_back( SraInfo::ReadStructure( types[i], lengths[i] ) );
+            }
+            m_run = p_rows;
+        }
+
+        void flush()
+        {
+            if ( m_run > 0 )
+            {
+                m_counts[ m_current ] += m_run;
+                m_run = 0;
+            }
+        }
+
+        void merge( const LayoutCounter & other )
+        {
+            for ( auto & c : other.m_counts )
+            {
+                m_counts[ c.first ] += c.second;
+            }
+            if ( other.m_run > 0 )
+            {
+                m_counts[ other.m_current ] += other.m_run;
+            }
+        }
+
+        Counts & counts() { flush(); return m_counts; }
+
+    private:
+        bool same( const VDB::Span<INSDC_read_type> & types, const VDB::Span<uint32_t> & lengths ) const
+        {
+            if ( types.size() != m_current.size() )
+            {
+                return false;
+            }
+            for ( size_t i = 0; i < types.size(); ++i )
+            {
+                if ( m_current[i].type != types[i] || m_current[i].length != lengths[i] )
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        Counts m_counts;
+        SraInfo::ReadStructures m_current;
+        uint64_t m_run = 0;
+    };
+
+    SraInfo::ReadStructures
+    ApplyDetail( const SraInfo::ReadStructures & reads, SraInfo::Detail detail )
+    {
+        SraInfo::ReadStructures ret;
+        ret.reserve( reads.size() );
+        for ( auto & r : reads )
+        {
+            SraInfo::ReadStructure rs;
+            switch (detail)
+            {
+            case SraInfo::Verbose:
+            case SraInfo::Full:
+                rs = r;
+                break;
+            case SraInfo::Abbreviated: // ignore read lengths
+                rs.type = r.type;
+                break;
+            case SraInfo::Short: // ignore read types and lengths
+                break;
+            default:
+                throw VDB::Error( "SraInfo::GetSpotLayouts(): unexpected detail level", __FILE__, __LINE__);
+            }
+            ret.push_back( rs );
+        }
+        return ret;
+    }
+}
+
+SraInfo::LayoutCounts
+SraInfo::countSpotLayouts( const VDB::Cursor & cursor, uint64_t topRows ) const
+{
+    const RowRange range = cursor.rowRange();
+    uint64_t rows = range.second - range.first;
+    if ( topRows != 0 && topRows < rows )
+    {
+        rows = topRows;
+    }
+
+    LayoutCounter total;
+    if ( rows == 0 )
+    {
+        return total.counts();
+    }
+
+    if ( cursor.isStaticColumn( 0 ) && cursor.isStaticColumn( 1 ) )
+    {   // the layout is stored once for the whole table
+        total.add( cursor.read( range.first, 0 ), cursor.read( range.first, 1 ), rows );
+    }
+    else if ( rows < uint64_t( range.second - range.first ) )
+    {   // just the top rows
+        cursor.foreachBlob( range.first, range.first + rows,
+            [&]( VDB::Cursor::RowID, const vector<VDB::Cursor::RawData>& values )
+            {
+                total.add( values[0], values[1] );
+            } );
+    }
+    else
+    {
+        auto handle_row = []( LayoutCounter & acc, VDB::Cursor::RowID, const vector<VDB::Cursor::RawData>& values )
+        {
+            acc.add( values[0], values[1] );
+        };
+        auto merge = []( LayoutCounter & acc, const LayoutCounter & part ) { acc.merge( part ); };
+        total = cursor.parallel_foreach< LayoutCounter >( m_threads, handle_row, merge );
+    }
+
+    LayoutCounts ret;
+    ret.swap( total.counts() );
+    return ret;
+}
+
 SraInfo::SpotLayouts // sorted by descending count
 SraInfo::GetSpotLayouts(
     Detail detail,
@@ -255,18 +438,16 @@ SraInfo::GetSpotLayouts(
     SpotLayouts ret;
 
     VDB::Table table;
+    string tableName = "SEQUENCE";
     if ( m_mgr.pathType( m_accession ) == VDB::Manager::ptDatabase && useConsensus )
     {
         const char * CONSENSUS_TABLE = "CONSENSUS";
         VDB::Database db = m_mgr.openDatabase( m_accession );
         if ( db.hasTable( CONSENSUS_TABLE ) )
         {
-            table = m_mgr.openDatabase( m_accession )[CONSENSUS_TABLE];
-        }
-        else
-        {
-            table = m_mgr.openDatabase( m_accession )["SEQUENCE"];
+            tableName = CONSENSUS_TABLE;
         }
+        table = db[tableName];
     }
     else
     {
@@ -274,74 +455,24 @@ SraInfo::GetSpotLayouts(
     }
 
     VDB::Cursor cursor = table.read( { "READ_TYPE", "READ_LEN" } );
-    auto handle_row = [&](VDB::Cursor::RowID row, const vector<VDB::Cursor::RawData>& values )
-    {
-        vector<INSDC_read_type> types = values[0].asVector<INSDC_read_type>();
-        vector<uint32_t> lengths = values[1].asVector<uint32_t>();
-        assert(types.size() == lengths.size());
-        ReadStructures r;
-        r.reserve(types.size());
-        auto i_types = types.begin();
-        auto i_lengths = lengths.begin();
-        while ( i_types != types.end() )
-        {
-            ReadStructure rs;
-            switch (detail)
-            {
-            case Verbose:
-            case Full:
-                rs.type = *i_types;
-                rs.length = *i_lengths;
-                break;
-            case Abbreviated: // ignore read lengths
-                rs.type = *i_types;
-                break;
-            case Short: // ignore read types and lengths
-                break;
-            default:
-                throw VDB::Error( "SraInfo::GetSpotLayouts(): unexpected detail level", __FILE__, __LINE__);
-            }
-
-            r.push_back( rs );
-            ++i_types;
-            ++i_lengths;
-        }
-
-        auto elem = rs_map.find( r );
-        if ( elem != rs_map.end() )
-        {
-            (*elem).second++;
-        }
-        else
+    LayoutCounts counts;
+    if ( topRows == 0 )
+    {   // all rows, the result can be cached
+        const RowRange rows = cursor.rowRange();
+        if ( ! loadSpotLayouts( tableName, rows, counts ) )
         {
-            rs_map[r] = 1;
+            counts = countSpotLayouts( cursor, 0 );
+            saveSpotLayouts( tableName, rows, counts );
         }
-    };
-    if ( topRows == 0 )
-    {   // all rows
-        cursor.foreach( handle_row );
     }
     else
     {   // read at most topRows
-        auto const range = cursor.rowRange();
-        size_t count = range.second - range.first;
-        if ( count > topRows )
-        {
-            count = topRows;
-        }
-
-        std::vector< VDB :: Cursor :: RawData > data;
-        data.resize( cursor.columns() );
+        counts = countSpotLayouts( cursor, topRows );
+    }
 
-        for (size_t i = 0; i < count; ++i)
-        {
-            auto rowId = range.first + i;
-            for ( unsigned int j = 0; j < cursor.columns(); ++j)
-            {
-                data[ j ] = cursor.read( rowId, j );
-            }
-            handle_row( rowId, data );
-        }
+    for( auto & c : counts )
+    {
+        rs_map[ ApplyDetail( c.first, detail ) ] += c.second;
     }
 
     for( auto it = rs_map.begin(); it != rs_map.end(); ++it )
@@ -361,6 +492,178 @@ SraInfo::GetSpotLayouts(
     return ret;
 }
 
+/*
+* summary cache: results of full table scans, one file per accession and kind:
+*   sra-info-summary 1
+*   <accession>
+*   <table> <first row> <end row>
+*   <data lines>
+* a file that does not match the accession, table or row range is ignored
+*/
+
+static const char * SummaryCacheSignature = "sra-info-summary 1";
+
+string
+SraInfo::summaryCachePath( const char * kind ) const
+{
+    string name;
+    for ( char c : m_accession )
+    {
+        name += ( isalnum( (unsigned char)c ) || c == '.' || c == '-' ) ? c : '_';
+    }
+    return m_cacheDir + "/" + name + "." + kind;
+}
+
+static
+bool
+ReadSummaryHeader( istream & in, const string & accession, const string & table, const pair<int64_t, int64_t> & rows )
+{
+    string line;
+    if ( ! getline( in, line ) || line != SummaryCacheSignature )
+    {
+        return false;
+    }
+    if ( ! getline( in, line ) || line != accession )
+    {
+        return false;
+    }
+    string t;
+    int64_t first, end;
+    if ( ! ( in >> t >> first >> end ) )
+    {
+        return false;
+    }
+    return t == table && first == rows.first && end == rows.second;
+}
+
+static
+void
+WriteSummaryHeader( ostream & out, const string & accession, const string & table, const pair<int64_t, int64_t> & rows )
+{
+    out << SummaryCacheSignature << '\n'
+        << accession << '\n'
+        << table << ' ' << rows.first << ' ' << rows.second << '\n';
+}
+
+// the cache is an optimization: a file that can not be written is not an error
+static
+void
+CommitSummary( ofstream & out, const string & tmp, const string & path )
+{
+    out.close();
+    if ( ! out || rename( tmp.c_str(), path.c_str() ) != 0 )
+    {
+        remove( tmp.c_str() );
+    }
+}
+
+bool
+SraInfo::loadSpotLayouts( const string & table, const RowRange & rows, LayoutCounts & counts ) const
+{
+    if ( m_cacheDir.empty() )
+    {
+        return false;
+    }
+    ifstream in( summaryCachePath( "layouts" ) );
+    if ( ! ReadSummaryHeader( in, m_accession, table, rows ) )
+    {
+        return false;
+    }
+
+    LayoutCounts ret;
+    uint64_t count;
+    size_t reads;
+    while ( in >> count >> reads )
+    {
+        ReadStructures r;
+        for ( size_t i = 0; i < reads; ++i )
+        {
+            unsigned type;
+            uint32_t length;
+            if ( ! ( in >> type >> length ) )
+            {
+                return false;
+            }
+            r.push_back( ReadStructure( (INSDC_read_type)type, length ) );
+        }
+        ret[ r ] += count;
+    }
+    if ( ! in.eof() )
+    {
+        return false;
+    }
+    counts.swap( ret );
+    return true;
+}
+
+void
+SraInfo::saveSpotLayouts( const string & table, const RowRange & rows, const LayoutCounts & counts ) const
+{
+    if ( m_cacheDir.empty() )
+    {
+        return;
+    }
+    const string path = summaryCachePath( "layouts" );
+    const string tmp = path + ".tmp";
+    ofstream out( tmp );
+    WriteSummaryHeader( out, m_accession, table, rows );
+    for ( auto & c : counts )
+    {
+        out << c.second << ' ' << c.first.size();
+        for ( auto & r : c.first )
+        {
+            out << ' ' << (unsigned)r.type << ' ' << r.length;
+        }
+        out << '\n';
+    }
+    CommitSummary( out, tmp, path );
+}
+
+bool
+SraInfo::loadPlatforms( const RowRange & rows, set<uint8_t> & platforms ) const
+{
+    if ( m_cacheDir.empty() )
+    {
+        return false;
+    }
+    ifstream in( summaryCachePath( "platforms" ) );
+    if ( ! ReadSummaryHeader( in, m_accession, "SEQUENCE", rows ) )
+    {
+        return false;
+    }
+
+    set<uint8_t> ret;
+    unsigned id;
+    while ( in >> id )
+    {
+        ret.insert( (uint8_t)id );
+    }
+    if ( ! in.eof() )
+    {
+        return false;
+    }
+    platforms.swap( ret );
+    return true;
+}
+
+void
+SraInfo::savePlatforms( const RowRange & rows, const set<uint8_t> & platforms ) const
+{
+    if ( m_cacheDir.empty() )
+    {
+        return;
+    }
+    const string path = summaryCachePath( "platforms" );
+    const string tmp = path + ".tmp";
+    ofstream out( tmp );
+    WriteSummaryHeader( out, m_accession, "SEQUENCE", rows );
+    for ( auto id : platforms )
+    {
+        out << (unsigned)id << '\n';
+    }
+    CommitSummary( out, tmp, path );
+}
+
 bool
 SraInfo::IsAligned() const
 {
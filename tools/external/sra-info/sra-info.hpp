@@ -28,6 +28,7 @@
 
 #include <string>
 #include <set>
+#include <map>
 #include <exception>
 
 #include <vdb.hpp>
@@ -41,6 +42,11 @@ public:
     void SetAccession( const std::string& accession );
     const std::string& GetAccession() const { return m_accession; }
 
+    // number of threads scanning a table, 0 (default) for one per core
+    void SetThreads( unsigned threads ) { m_threads = threads; }
+    // directory to keep the results of full table scans in, empty (default) for none
+    void SetSummaryCache( const std::string& dir ) { m_cacheDir = dir; }
+
     // Platform
     typedef std::set<std::string> Platforms;
     Platforms GetPlatforms() const; // may be empty or more than 1 value
@@ -84,10 +90,23 @@ public:
     const VDB::SchemaInfo GetSchemaInfo() const;
 
 private:
+    typedef std::map<ReadStructures, uint64_t> LayoutCounts; // at Verbose detail
+    typedef std::pair<VDB::Cursor::RowID, VDB::Cursor::RowID> RowRange;
+
     VDB::Table openSequenceTable( const std::string & accession ) const;
     VDB::Schema openSchema( const std::string & accession ) const;
 
+    LayoutCounts countSpotLayouts( const VDB::Cursor & cursor, uint64_t topRows ) const;
+
+    std::string summaryCachePath( const char * kind ) const;
+    bool loadSpotLayouts( const std::string & table, const RowRange & rows, LayoutCounts & counts ) const;
+    void saveSpotLayouts( const std::string & table, const RowRange & rows, const LayoutCounts & counts ) const;
+    bool loadPlatforms( const RowRange & rows, std::set<uint8_t> & platforms ) const;
+    void savePlatforms( const RowRange & rows, const std::set<uint8_t> & platforms ) const;
+
 private:
     VDB::Manager m_mgr;
     std::string m_accession;
+    unsigned m_threads = 0;
+    std::string m_cacheDir;
 };
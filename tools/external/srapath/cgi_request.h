@@ -57,6 +57,8 @@ typedef struct request_params
     const char ** terms;        /* mandatory... NULL-terminated list of terms */
     size_t buffer_size;
     uint32_t timeout_ms;
+    uint32_t batch_size;        /* 0 ... all terms in one request */
+    uint32_t threads;           /* requests in flight, 0 ... 1 */
 } request_params;
 
 
@@ -31,6 +31,7 @@
 #include <klib/log.h> /* LOGERR */
 #include <klib/out.h> /* OUTMSG */
 #include <klib/time.h> /* KTimeIso8601 */
+#include <kproc/thread.h> /* KThreadMake */
 #include <vfs/path.h> /* VPath */
 #include <vfs/services-priv.h> /* KServiceNamesExecuteExt */
 #include <cloud/manager.h> /* CloudMgrMake */
@@ -129,22 +130,21 @@ static bool printCommon ( const VPath * path, const KSrvError * error ) {
 }
 
 
+/* first: number of the first object of the response in the whole output */
 static
-rc_t KSrvResponse_Print ( const KSrvResponse * self, bool cache, bool pPath )
+rc_t KSrvResponse_Print ( const KSrvResponse * self, bool cache, bool pPath,
+                          uint32_t first )
 {
     rc_t rc = 0;
     rc_t re = 0;
     uint32_t i = 0;
     uint32_t l = KSrvResponseLength  ( self );
 
-    if ( ! pPath )
-        OUTMSG ( ( "%u #\n\n", l ) );
-
     for ( i = 0; i < l; ++ i ) {
         bool printed = false;
         int j = 0;
         if ( ! pPath )
-            OUTMSG ( ( "#%u {", i ) );
+            OUTMSG ( ( "#%u {", first + i ) );
         for ( j = 0; j < sizeof PROTOCOLS / sizeof PROTOCOLS [ 0 ];
               ++ j )
         {
@@ -235,45 +235,41 @@ rc_t KSrvResponse_Print ( const KSrvResponse * self, bool cache, bool pPath )
 }
 
 
-static rc_t names_remote ( KService * service,
-    VRemoteProtocols protocols, const request_params * request, bool path )
+static rc_t names_print ( const KSrvResponse * const * responses,
+    uint32_t count, bool cache, bool path )
 {
     rc_t rc = 0;
+    uint32_t i = 0;
+    uint32_t total = 0;
 
-    const KSrvResponse * response = NULL;
+    for ( i = 0; i < count; ++ i )
+        total += KSrvResponseLength ( responses [ i ] );
 
-    rc = KServiceNamesExecuteExt ( service, protocols,
-        request -> names_url, request -> names_ver, & response );
-    if ( rc != 0 )
-        OUTMSG ( ( "Error: %R\n", rc ) );
-    else
-        rc = KSrvResponse_Print ( response, false, path );
+    if ( ! path )
+        OUTMSG ( ( "%u #\n\n", total ) );
 
-    RELEASE ( KSrvResponse, response );
+    for ( i = 0, total = 0; i < count; ++ i ) {
+        rc_t r2 = KSrvResponse_Print ( responses [ i ], cache, path, total );
+        if ( r2 != 0 && rc == 0 )
+            rc = r2;
+        total += KSrvResponseLength ( responses [ i ] );
+    }
 
     return rc;
 }
 
 
-static rc_t names_remote_cache ( KService * service,
-    VRemoteProtocols protocols, const request_params * request, bool path )
+static rc_t names_remote ( const KSrvResponse * const * responses,
+    uint32_t count, bool path )
 {
-    rc_t rc = 0;
-
-    const KSrvResponse * response = NULL;
-
-    assert ( request );
-
-    rc = KServiceNamesQueryExt ( service, protocols, request -> names_url,
-                                 request -> names_ver, NULL, NULL, & response );
-    if ( rc != 0 )
-        OUTMSG ( ( "Error: %R\n", rc ) );
-    else
-        rc = KSrvResponse_Print ( response, true, path );
+    return names_print ( responses, count, false, path );
+}
 
-    RELEASE ( KSrvResponse, response );
 
-    return rc;
+static rc_t names_remote_cache ( const KSrvResponse * const * responses,
+    uint32_t count, bool path )
+{
+    return names_print ( responses, count, true, path );
 }
 
 static void json_print_nvp(  char const *const name
@@ -443,69 +439,71 @@ static unsigned json_print_response_file(KSrvRespFile const *const file, char co
 
 static void get_compute_environment(void);
 
-static rc_t names_remote_json ( KService * const service
-                               , VRemoteProtocols const protocols
-                               , request_params const * const request
-                               , bool const path )
+static unsigned json_print_response ( KSrvResponse const * const response
+                                     , unsigned output_count )
 {
-    rc_t rc = 0;
-    KSrvResponse const * response = NULL;
-
+    unsigned const count = KSrvResponseLength(response);
+    unsigned i;
 
-    rc = KServiceNamesQueryExt( service, protocols, request -> names_url,
-        request -> names_ver, NULL, NULL, & response );
-    if ( rc != 0 )
-        OUTMSG ( ( "Error: %R\n", rc ) );
-    else {
-        unsigned const count = KSrvResponseLength(response);
-        unsigned i;
-        unsigned output_count = 0;
-
-        OUTMSG(("{\n"));
-        OUTMSG(("\"count\": %u,\n", count));
-        get_compute_environment();
-        OUTMSG(("\"responses\": [\n"));
-        for (i = 0; i < count; ++i) {
-            KSrvRespObjIterator *iter = NULL;
-            char const *acc = NULL;
-            KSrvRespObj const *obj = NULL;
-            uint32_t id = 0;
-            uint32_t fileCount = 0;
-
-            INFALLIBLE(KSrvResponseGetObjByIdx(response, i, &obj));
-            INFALLIBLE(KSrvRespObjGetAccOrId(obj, &acc, &id));
-            rc = KSrvRespObjGetFileCount(obj, &fileCount);
-            if (rc == 0) {
-                INFALLIBLE(KSrvRespObjMakeIterator(obj, &iter));
-
-                for ( ; ; ) { /* iterate files */
-                    KSrvRespFile *file = NULL;
-
-                    INFALLIBLE(KSrvRespObjIteratorNextFile(iter, &file));
-                    if (file == NULL) /* done iterating */
-                        break;
-                    output_count = json_print_response_file(file, acc, id, output_count);
-                    RELEASE(KSrvRespFile, file);
-                }
-                RELEASE(KSrvRespObjIterator, iter);
-            }
-            else {
-                char const *err_msg = NULL;
-                int64_t err_code = 0;
-                rc_t err_rc = 0;
-                INFALLIBLE(KSrvRespObjGetError(obj, &err_rc, &err_code, &err_msg));
-                OUTMSG(("%.*s{\"accession\": \"%s\", \"error\": \"%03u\", \"message\": \"%s\"}", output_count == 0 ? 0 : 2, ",\n", acc, (unsigned)err_code, err_msg));
-                output_count += 1;
-                rc = 0;
+    for (i = 0; i < count; ++i) {
+        rc_t rc = 0;
+        KSrvRespObjIterator *iter = NULL;
+        char const *acc = NULL;
+        KSrvRespObj const *obj = NULL;
+        uint32_t id = 0;
+        uint32_t fileCount = 0;
+
+        INFALLIBLE(KSrvResponseGetObjByIdx(response, i, &obj));
+        INFALLIBLE(KSrvRespObjGetAccOrId(obj, &acc, &id));
+        rc = KSrvRespObjGetFileCount(obj, &fileCount);
+        if (rc == 0) {
+            INFALLIBLE(KSrvRespObjMakeIterator(obj, &iter));
+
+            for ( ; ; ) { /* iterate files */
+                KSrvRespFile *file = NULL;
+
+                INFALLIBLE(KSrvRespObjIteratorNextFile(iter, &file));
+                if (file == NULL) /* done iterating */
+                    break;
+                output_count = json_print_response_file(file, acc, id, output_count);
+                RELEASE(KSrvRespFile, file);
             }
-            RELEASE(KSrvRespObj, obj);
+            RELEASE(KSrvRespObjIterator, iter);
+        }
+        else {
+            char const *err_msg = NULL;
+            int64_t err_code = 0;
+            rc_t err_rc = 0;
+            INFALLIBLE(KSrvRespObjGetError(obj, &err_rc, &err_code, &err_msg));
+            OUTMSG(("%.*s{\"accession\": \"%s\", \"error\": \"%03u\", \"message\": \"%s\"}", output_count == 0 ? 0 : 2, ",\n", acc, (unsigned)err_code, err_msg));
+            output_count += 1;
         }
-        output_count = json_print_response_file(NULL, NULL, 0, output_count);
-        OUTMSG(("]}\n"));
+        RELEASE(KSrvRespObj, obj);
     }
-    RELEASE ( KSrvResponse, response );
+    return output_count;
+}
 
-    return rc;
+static rc_t names_remote_json ( KSrvResponse const * const * const responses
+                               , uint32_t const count
+                               , bool const path )
+{
+    uint32_t i;
+    unsigned total = 0;
+    unsigned output_count = 0;
+
+    for (i = 0; i < count; ++i)
+        total += KSrvResponseLength(responses[i]);
+
+    OUTMSG(("{\n"));
+    OUTMSG(("\"count\": %u,\n", total));
+    get_compute_environment();
+    OUTMSG(("\"responses\": [\n"));
+    for (i = 0; i < count; ++i)
+        output_count = json_print_response(responses[i], output_count);
+    output_count = json_print_response_file(NULL, NULL, 0, output_count);
+    OUTMSG(("]}\n"));
+
+    return 0;
 }
 
 static void get_compute_environment(void)
@@ -528,10 +526,12 @@ static void get_compute_environment(void)
     free((void *)token);
 }
 
-static rc_t KService_Make ( KService ** self, const request_params * request ) {
+static rc_t KService_Make ( KService ** self, const request_params * request,
+                            const char ** terms )
+{
     rc_t rc = 0;
 
-    assert ( request && request -> terms );
+    assert ( request && terms );
 
     rc = KServiceMake ( self );
 
@@ -540,7 +540,7 @@ static rc_t KService_Make ( KService ** self, const request_params * request ) {
 
         assert ( * self );
 
-        for ( id = request -> terms; * id != NULL && rc == 0; ++ id)
+        for ( id = terms; * id != NULL && rc == 0; ++ id)
             rc = KServiceAddId ( * self, * id );
 
         if (rc == 0 && request->cart != NULL) {
@@ -614,35 +614,12 @@ VRemoteProtocols parseProtocol ( const char * protocol, rc_t * prc )
     return protocols;
 }
 
-static rc_t names_request_1 (  const request_params * request
-                             , bool path
-                             , rc_t (*func)(  KService * service
-                                            , VRemoteProtocols protocols
-                                            , const request_params * request
-                                            , bool path )
-                             )
+static rc_t names_service_make ( KService ** self,
+    const request_params * request, const char ** terms )
 {
-    rc_t rc = 0;
-
     KService * service = NULL;
 
-    VRemoteProtocols protocols = 0;
-
-    assert ( request && request -> terms );
-
-    if ( sizeof PROTOCOLS / sizeof PROTOCOLS [ 0 ] != eProtocolMax ) {
-        rc = RC ( rcExe, rcTable, rcValidating, rcTable, rcIncomplete );
-        LOGERR ( klogFatal, rc, "Incomplete PROTOCOLS array" );
-        assert ( sizeof PROTOCOLS / sizeof PROTOCOLS [ 0 ] == eProtocolMax );
-        return rc;
-    }
-
-    if ( request -> params != NULL && * request -> params != NULL )
-        LOGMSG ( klogWarn, "'--" OPTION_PARAM "' is ignored: "
-                "it used just with '--" OPTION_RAW "' '" FUNCTION_NAMES "' and '"
-                FUNCTION_SEARCH "' funtions") ;
-
-    rc = KService_Make ( & service, request );
+    rc_t rc = KService_Make ( & service, request, terms );
 
     if ( rc == 0 ) {
         if ( rc == 0 && request -> projects != NULL &&
@@ -681,29 +658,226 @@ static rc_t names_request_1 (  const request_params * request
                 "Cannot set ngc file '$(l)'", "l=%s", request->ngc));
     }
 
-    if ( rc == 0 && request -> proto != NULL )
-        protocols = parseProtocol ( request -> proto, & rc );
+    if ( rc == 0 )
+        * self = service;
+    else
+        RELEASE ( KService, service );
+
+    return rc;
+}
+
+
+/* one request to the names service, for a slice of the terms */
+typedef struct names_batch
+{
+    const request_params * request;
+    const char ** terms;            /* NULL-terminated */
+    VRemoteProtocols protocols;
+    bool query;                     /* KServiceNamesQueryExt:
+                                       resolve cache locations as well */
+    const KSrvResponse * response;
+    rc_t rc;
+} names_batch;
+
+
+static void names_batch_run ( names_batch * self ) {
+    rc_t rc = 0;
+
+    KService * service = NULL;
+
+    assert ( self );
 
+    rc = names_service_make ( & service, self -> request, self -> terms );
     if ( rc == 0 ) {
-        rc = func( service, protocols, request, path );
+        if ( self -> query )
+            rc = KServiceNamesQueryExt ( service, self -> protocols,
+                self -> request -> names_url, self -> request -> names_ver,
+                NULL, NULL, & self -> response );
+        else
+            rc = KServiceNamesExecuteExt ( service, self -> protocols,
+                self -> request -> names_url, self -> request -> names_ver,
+                & self -> response );
     }
 
     RELEASE ( KService, service );
 
+    self -> rc = rc;
+}
+
+
+/* a thread runs every step-th batch, starting with the first */
+typedef struct names_worker
+{
+    KThread * thread;
+    names_batch * batches;
+    uint32_t first;
+    uint32_t step;
+    uint32_t count;
+} names_worker;
+
+
+static rc_t CC names_worker_run ( const KThread * self, void * data ) {
+    names_worker * w = data;
+    uint32_t i = 0;
+
+    for ( i = w -> first; i < w -> count; i += w -> step )
+        names_batch_run ( & w -> batches [ i ] );
+
+    return 0;
+}
+
+
+static void names_batches_run ( names_batch * batches, uint32_t count,
+                                uint32_t threads )
+{
+    names_worker * workers = NULL;
+    uint32_t i = 0;
+
+    if ( threads > count )
+        threads = count;
+    if ( threads > 1 )
+        workers = calloc ( threads, sizeof * workers );
+
+    if ( workers == NULL ) {
+        for ( i = 0; i < count; ++ i )
+            names_batch_run ( & batches [ i ] );
+        return;
+    }
+
+    for ( i = 0; i < threads; ++ i ) {
+        names_worker * w = & workers [ i ];
+        w -> batches = batches;
+        w -> first = i;
+        w -> step = threads;
+        w -> count = count;
+        if ( i > 0 && KThreadMake ( & w -> thread, names_worker_run, w ) != 0 )
+            w -> thread = NULL;
+    }
+
+    /* the calling thread is the first worker; it also does the work
+       of the workers that could not be started */
+    names_worker_run ( NULL, & workers [ 0 ] );
+    for ( i = 1; i < threads; ++ i ) {
+        names_worker * w = & workers [ i ];
+        if ( w -> thread != NULL ) {
+            rc_t status = 0;
+            KThreadWait ( w -> thread, & status );
+            KThreadRelease ( w -> thread );
+        }
+        else
+            names_worker_run ( NULL, w );
+    }
+
+    free ( workers );
+}
+
+
+/* Sends the terms to the names service in batches of request -> batch_size,
+   request -> threads batches at a time, then prints the responses in the
+   order of the terms */
+static rc_t names_request_1 (  const request_params * request
+                             , bool path
+                             , bool query
+                             , rc_t (*func)(  const KSrvResponse * const * responses
+                                            , uint32_t count
+                                            , bool path )
+                             )
+{
+    rc_t rc = 0;
+
+    VRemoteProtocols protocols = 0;
+
+    uint32_t terms = 0;
+    uint32_t count = 0;
+    uint32_t i = 0;
+    uint32_t batch_size = 0;
+    names_batch * batches = NULL;
+    const KSrvResponse ** responses = NULL;
+    const char ** slices = NULL;
+
+    assert ( request && request -> terms );
+
+    if ( sizeof PROTOCOLS / sizeof PROTOCOLS [ 0 ] != eProtocolMax ) {
+        rc = RC ( rcExe, rcTable, rcValidating, rcTable, rcIncomplete );
+        LOGERR ( klogFatal, rc, "Incomplete PROTOCOLS array" );
+        assert ( sizeof PROTOCOLS / sizeof PROTOCOLS [ 0 ] == eProtocolMax );
+        return rc;
+    }
+
+    if ( request -> params != NULL && * request -> params != NULL )
+        LOGMSG ( klogWarn, "'--" OPTION_PARAM "' is ignored: "
+                "it used just with '--" OPTION_RAW "' '" FUNCTION_NAMES "' and '"
+                FUNCTION_SEARCH "' funtions") ;
+
+    if ( request -> proto != NULL )
+        protocols = parseProtocol ( request -> proto, & rc );
+    if ( rc != 0 )
+        return rc;
+
+    while ( request -> terms [ terms ] != NULL )
+        ++ terms;
+
+    batch_size = request -> batch_size;
+    if ( batch_size == 0 || batch_size > terms )
+        batch_size = terms;
+    count = batch_size == 0 ? 1 : ( terms + batch_size - 1 ) / batch_size;
+
+    batches = calloc ( count, sizeof * batches );
+    responses = calloc ( count, sizeof * responses );
+    slices = calloc ( terms + count, sizeof * slices );
+    if ( batches == NULL || responses == NULL || slices == NULL ) {
+        rc = RC ( rcExe, rcStorage, rcAllocating, rcMemory, rcExhausted );
+        LOGERR ( klogErr, rc, "cannot allocate requests" );
+    }
+    else {
+        /* each batch gets its own NULL-terminated slice of the terms */
+        const char ** slice = slices;
+        for ( i = 0; i < count; ++ i ) {
+            uint32_t j = 0;
+            names_batch * b = & batches [ i ];
+            b -> request = request;
+            b -> terms = slice;
+            b -> protocols = protocols;
+            b -> query = query;
+            for ( j = i * batch_size; j < terms && j < ( i + 1 ) * batch_size; ++ j )
+                * slice ++ = request -> terms [ j ];
+            * slice ++ = NULL;
+        }
+
+        names_batches_run ( batches, count, request -> threads );
+
+        for ( i = 0; i < count && rc == 0; ++ i ) {
+            rc = batches [ i ] . rc;
+            responses [ i ] = batches [ i ] . response;
+        }
+        if ( rc != 0 )
+            OUTMSG ( ( "Error: %R\n", rc ) );
+        else
+            rc = func ( responses, count, path );
+    }
+
+    if ( batches != NULL ) {
+        for ( i = 0; i < count; ++ i )
+            RELEASE ( KSrvResponse, batches [ i ] . response );
+    }
+    free ( ( void * ) slices );
+    free ( ( void * ) responses );
+    free ( batches );
+
     return rc;
 }
 
 rc_t names_request ( const request_params * request, bool cache, bool path )
 {
     if (cache)
-        return names_request_1(request, path, names_remote_cache);
+        return names_request_1(request, path, true , names_remote_cache);
     else
-        return names_request_1(request, path, names_remote      );
+        return names_request_1(request, path, false, names_remote      );
 }
 
 rc_t names_request_json ( const request_params * request, bool cache, bool path )
 {
-    return names_request_1(request, path, names_remote_json);
+    return names_request_1(request, path, true, names_remote_json);
 }
 
 static void KartItem_Print ( const KartItem * self ) {
@@ -781,7 +955,7 @@ rc_t search_request ( const request_params * request ) {
     KService * service = NULL;
     const struct Kart * response = NULL;
 
-    rc_t rc = KService_Make ( & service, request );
+    rc_t rc = KService_Make ( & service, request, request -> terms );
 
     assert ( request );
 
@@ -120,6 +120,16 @@ static const char * url_usage[] = { "url to be used for cgi-calls", NULL };
 #define OPTION_URL    "url"
 #define ALIAS_URL     "u"
 
+static const char * batch_usage[] = { "number of accessions in one request to "
+    "the " FUNCTION_NAMES " service (default: 200, 0 = all)", NULL };
+#define OPTION_BATCH  "batch"
+#define ALIAS_BATCH   NULL
+
+static const char * threads_usage[] = { "number of requests to the "
+    FUNCTION_NAMES " service sent at one time (default: 4)", NULL };
+#define OPTION_THREADS "threads"
+#define ALIAS_THREADS NULL
+
 OptDef ToolOptions[] =
 {                                                    /* needs_value, required */
     { OPTION_FUNC   , ALIAS_FUNC   , NULL, func_usage   ,   1,  true,   false },
@@ -136,6 +146,8 @@ OptDef ToolOptions[] =
     { OPTION_PATH   , ALIAS_PATH   , NULL, path_usage   ,   1,  false,  false },
     { OPTION_CART   , ALIAS_CART   , NULL, cart_usage   ,   1,  true ,  false },
     { OPTION_NGC    , ALIAS_NGC    , NULL, ngc_usage    ,   1,  true ,  false },
+    { OPTION_BATCH  , ALIAS_BATCH  , NULL, batch_usage  ,   1,  true ,  false },
+    { OPTION_THREADS, ALIAS_THREADS, NULL, threads_usage,   1,  true ,  false },
 };
 
 const char UsageDefaultName[] = "srapath";
@@ -195,6 +207,11 @@ rc_t CC Usage( const Args *args )
             {
                 param = "PATH";
             }
+            else if (strcmp(ToolOptions[idx].name, OPTION_BATCH) == 0 ||
+                strcmp(ToolOptions[idx].name, OPTION_THREADS) == 0)
+            {
+                param = "NUMBER";
+            }
         }
 
         HelpOptionLine( ToolOptions[ idx ].aliases, ToolOptions[ idx ].name,
@@ -535,6 +552,10 @@ static rc_t resolve_arguments( Args * args )
                     rc = ArgsOptionCount ( args, OPTION_PRJ, & idx );
                 if ( rc == 0 && idx == 0 )
                     rc = ArgsOptionCount ( args, OPTION_CACHE, & idx );
+                if ( rc == 0 && idx == 0 )
+                    rc = ArgsOptionCount ( args, OPTION_BATCH, & idx );
+                if ( rc == 0 && idx == 0 )
+                    rc = ArgsOptionCount ( args, OPTION_THREADS, & idx );
                 if ( rc == 0 && idx > 0 )
                     LOGMSG ( klogWarn, "all the options are ignored "
                         "when running '" FUNCTION_RESOLVE "' function" );
@@ -610,6 +631,8 @@ static rc_t prepare_request( const Args * args, request_params * r, out_fmt * fm
             r->location   = get_str_option( args, OPTION_LOCN, NULL );
             r->search_url = NULL;
             r->search_ver = NULL;
+            r->batch_size = get_uint32_t_option( args, OPTION_BATCH, 200 );
+            r->threads    = get_uint32_t_option( args, OPTION_THREADS, 4 );
             
         }
         else
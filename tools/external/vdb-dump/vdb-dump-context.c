@@ -115,6 +115,7 @@ static void vdco_init_values( p_dump_context ctx ) {
     ctx -> max_line_len = 0;
     ctx -> indented_line_len = 0;
     ctx -> slice_depth = 0;
+    ctx -> inspect_samples = DEF_OPTION_INSPECT_SAMPLES;
 
     ctx -> help_requested = false;
     ctx -> usage_requested = false;
@@ -142,6 +143,7 @@ static void vdco_init_values( p_dump_context ctx ) {
     ctx -> cell_debug = false;
     ctx -> cell_v1 = false;
     ctx -> inspect = false;
+    ctx -> inspect_perf = false;
 }
 
 rc_t vdco_init( dump_context **ctx ) {
@@ -539,6 +541,8 @@ static void vdco_evaluate_options( const Args *args, dump_context *ctx ) {
     vdco_set_view( ctx, vdco_get_str_option( args, OPTION_VIEW ) );
     ctx -> view_defined = ( ctx -> view != NULL );
     ctx -> inspect = vdco_get_bool_option( args, OPTION_INSPECT, false );
+    ctx -> inspect_perf = vdco_get_bool_option( args, OPTION_INSPECT_PERF, false );
+    ctx -> inspect_samples = ( uint32_t )vdco_get_size_t_option( args, OPTION_INSPECT_SAMPLES, DEF_OPTION_INSPECT_SAMPLES );
     vdco_set_columns( ctx, vdco_get_str_option( args, OPTION_COLUMNS ) );
     vdco_set_excluded_columns( ctx, vdco_get_str_option( args, OPTION_EXCLUDED_COLUMNS ) );
     vdco_set_row_range( ctx, vdco_get_str_option( args, OPTION_ROWS ) );
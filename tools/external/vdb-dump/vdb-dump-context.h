@@ -86,6 +86,8 @@ extern "C" {
 #define OPTION_APPEND            "append"
 #define OPTION_VIEW              "view"
 #define OPTION_INSPECT           "inspect"
+#define OPTION_INSPECT_PERF      "inspect-perf"
+#define OPTION_INSPECT_SAMPLES   "inspect-samples"
 #define OPTION_SLICE             "slice"
 
 #define OPTION_CELL_DEBUG        "cell-debug"
@@ -125,6 +127,7 @@ extern "C" {
 #define USE_PATHTYPE_TO_DETECT_DB_OR_TAB 1
 #define CURSOR_CACHE_SIZE 256*1024*1024
 #define DEF_OPTION_OUT_BUF_SIZE 1024*1024
+#define DEF_OPTION_INSPECT_SAMPLES 64
 
 typedef enum dump_format_t
 {
@@ -168,6 +171,7 @@ typedef struct dump_context
     uint16_t indented_line_len;
     uint32_t generic_idx;
     uint32_t slice_depth;
+    uint32_t inspect_samples;
     size_t cur_cache_size;
     size_t output_buffer_size;
     dump_format_t format;
@@ -211,6 +215,7 @@ typedef struct dump_context
     bool cell_debug;
     bool cell_v1;
     bool inspect;
+    bool inspect_perf;
 } dump_context;
 typedef dump_context* p_dump_context;
 
@@ -32,6 +32,12 @@
 #include <kdb/kdb-priv.h>
 #include <kdb/table.h>
 #include <kdb/database.h>
+#include <kdb/column.h>
+#include <vdb/cursor.h>
+#include <vdb/blob.h>
+#include <klib/time.h>
+
+#include <string.h>
 
 #ifndef _h_kfs_arc_
 #include <kfs/arc.h>
@@ -651,3 +657,291 @@ rc_t vdi_inspect( const KDirectory * dir, const VDBManager * mgr,
     }
     return rc;
 }
+
+/* -------------------------------------------------------------------------------------------------- */
+
+#define VDI_PERF_BUCKETS 64
+
+typedef struct VDI_PERF_HIST {
+    uint64_t buckets[ VDI_PERF_BUCKETS ];   /* bucket n counts values in [ 2^(n-1) ... 2^n ) */
+} VDI_PERF_HIST;
+
+typedef struct VDI_PERF_STAT {
+    uint64_t blobs;
+    uint64_t rows;
+    uint64_t bytes;
+    uint64_t min_rows;
+    uint64_t max_rows;
+    VDI_PERF_HIST rows_hist;
+    VDI_PERF_HIST bytes_hist;
+} VDI_PERF_STAT;
+
+typedef struct VDI_PERF {
+    const char * name;
+    int64_t first;
+    uint64_t count;
+    bool physical;          /* the column has a physical column of the same name */
+    VDI_PERF_STAT stored;   /* the kdb-blobs, as they are on disk */
+    VDI_PERF_STAT decoded;  /* the vdb-blobs, as they come out of the cursor */
+    uint64_t decode_ms;     /* time spent in VCursorGetBlob() for the sampled vdb-blobs */
+} VDI_PERF;
+
+static uint32_t vdi_perf_bucket( uint64_t value ) {
+    uint32_t res = 0;
+    while ( value > 0 && res < VDI_PERF_BUCKETS - 1 ) {
+        value >>= 1;
+        res++;
+    }
+    return res;
+}
+
+static void vdi_perf_add( VDI_PERF_STAT * self, uint64_t rows, uint64_t bytes ) {
+    if ( 0 == self -> blobs || rows < self -> min_rows ) { self -> min_rows = rows; }
+    if ( rows > self -> max_rows ) { self -> max_rows = rows; }
+    self -> blobs++;
+    self -> rows += rows;
+    self -> bytes += bytes;
+    self -> rows_hist . buckets[ vdi_perf_bucket( rows ) ]++;
+    self -> bytes_hist . buckets[ vdi_perf_bucket( bytes ) ]++;
+}
+
+static double vdi_perf_div( uint64_t value, uint64_t by ) {
+    if ( 0 == by ) { return 0.0; }
+    return ( double )value / by;
+}
+
+/* decoded bytes per row against stored bytes per row, the blobs of both sides do not have to line up */
+static double vdi_perf_compression( const VDI_PERF * self ) {
+    double stored = vdi_perf_div( self -> stored . bytes, self -> stored . rows );
+    if ( stored > 0.0 ) {
+        return vdi_perf_div( self -> decoded . bytes, self -> decoded . rows ) / stored;
+    }
+    return 0.0;
+}
+
+/* the physical blob that contains the row: its id-range and its size on disk */
+static rc_t vdi_perf_sample_kdb( const KColumn * kcol, int64_t row, VDI_PERF * perf, int64_t * next ) {
+    const KColumnBlob * blob;
+    rc_t rc = KColumnOpenBlobRead( kcol, &blob, row );
+    DISP_RC( rc, "KColumnOpenBlobRead() failed" );
+    if ( 0 == rc ) {
+        int64_t first;
+        uint32_t count;
+        rc = KColumnBlobIdRange( blob, &first, &count );
+        DISP_RC( rc, "KColumnBlobIdRange() failed" );
+        if ( 0 == rc ) {
+            char buffer[ 8 ];
+            size_t num_read, remaining;
+            rc = KColumnBlobRead( blob, 0, &buffer, 0, &num_read, &remaining );
+            DISP_RC( rc, "KColumnBlobRead() failed" );
+            if ( 0 == rc ) {
+                vdi_perf_add( &( perf -> stored ), count, num_read + remaining );
+                *next = first + count;
+            }
+        }
+        rc = vdh_kcolumnblob_release( rc, blob );
+    }
+    return rc;
+}
+
+/* the vdb-blob that contains the row: its id-range, its decoded size and the time to produce it */
+static rc_t vdi_perf_sample_vdb( const VCursor * curs, uint32_t idx, int64_t row, VDI_PERF * perf, int64_t * next ) {
+    rc_t rc = VCursorSetRowId( curs, row );
+    DISP_RC( rc, "VCursorSetRowId() failed" );
+    if ( 0 == rc ) {
+        rc = VCursorOpenRow( curs );
+        DISP_RC( rc, "VCursorOpenRow() failed" );
+        if ( 0 == rc ) {
+            const VBlob * blob;
+            KTimeMs_t start = KTimeMsStamp();
+            rc = VCursorGetBlob( curs, &blob, idx );
+            DISP_RC( rc, "VCursorGetBlob() failed" );
+            if ( 0 == rc ) {
+                int64_t first;
+                uint64_t count;
+                size_t bytes;
+                perf -> decode_ms += KTimeMsStamp() - start;
+                rc = VBlobIdRange( blob, &first, &count );
+                DISP_RC( rc, "VBlobIdRange() failed" );
+                if ( 0 == rc ) {
+                    rc = VBlobSize( blob, &bytes );
+                    DISP_RC( rc, "VBlobSize() failed" );
+                }
+                if ( 0 == rc ) {
+                    vdi_perf_add( &( perf -> decoded ), count, bytes );
+                    *next = first + ( count > 0 ? count : 1 );
+                }
+                VBlobRelease( blob );
+            }
+            {
+                rc_t rc2 = VCursorCloseRow( curs );
+                DISP_RC( rc2, "VCursorCloseRow() failed" );
+                rc = ( 0 == rc ) ? rc2 : rc;
+            }
+        }
+    }
+    return rc;
+}
+
+/* pick 'samples' rows spread evenly over the column, each one in a blob not sampled before */
+static rc_t vdi_perf_sample( const VTable * tbl, const KTable * ktbl, uint32_t samples, VDI_PERF * perf ) {
+    const KColumn * kcol = NULL;
+    const VCursor * curs;
+    /* no cursor-cache: every sampled blob has to be decoded */
+    rc_t rc = VTableCreateCursorRead( tbl, &curs );
+    DISP_RC( rc, "VTableCreateCursorRead() failed" );
+    if ( 0 == rc ) {
+        uint32_t idx;
+        rc = VCursorAddColumn( curs, &idx, "%s", perf -> name );
+        DISP_RC( rc, "VCursorAddColumn() failed" );
+        if ( 0 == rc ) {
+            rc = VCursorOpen( curs );
+            DISP_RC( rc, "VCursorOpen() failed" );
+        }
+        if ( 0 == rc ) {
+            rc = VCursorIdRange( curs, idx, &( perf -> first ), &( perf -> count ) );
+            DISP_RC( rc, "VCursorIdRange() failed" );
+        }
+        if ( 0 == rc && NULL != ktbl ) {
+            /* computed columns have no physical counterpart, they only get the decoded side */
+            perf -> physical = ( 0 == KTableOpenColumnRead( ktbl, &kcol, "%s", perf -> name ) );
+        }
+        if ( 0 == rc && perf -> count > 0 ) {
+            int64_t end = perf -> first + perf -> count;
+            int64_t next_vdb = perf -> first;
+            int64_t next_kdb = perf -> first;
+            uint32_t i;
+            if ( 0 == samples ) { samples = 1; }
+            for ( i = 0; 0 == rc && i < samples; ++i ) {
+                int64_t row = perf -> first + ( int64_t )( ( perf -> count * ( 2 * ( uint64_t )i + 1 ) ) / ( 2 * ( uint64_t )samples ) );
+                if ( row < next_vdb ) { row = next_vdb; }
+                if ( row >= end ) { break; }
+                rc = vdi_perf_sample_vdb( curs, idx, row, perf, &next_vdb );
+                if ( 0 == rc && NULL != kcol && row >= next_kdb ) {
+                    rc = vdi_perf_sample_kdb( kcol, row, perf, &next_kdb );
+                }
+            }
+        }
+        rc = vdh_kcolumn_release( rc, kcol );
+        rc = vdh_vcursor_release( rc, curs );
+    }
+    return rc;
+}
+
+/* -------------------------------------------------------------------------------------------------- */
+
+static void vdi_perf_print_hist_default( const char * title, const VDI_PERF_HIST * hist ) {
+    uint32_t i;
+    KOutMsg( "  %s:\n", title );
+    for ( i = 0; i < VDI_PERF_BUCKETS; ++i ) {
+        if ( hist -> buckets[ i ] > 0 ) {
+            uint64_t from = ( 0 == i ) ? 0 : ( ( uint64_t )1 << ( i - 1 ) );
+            uint64_t to = ( ( uint64_t )1 << i ) - 1;
+            KOutMsg( "    %,20lu ... %,20lu : %,lu\n", from, to, hist -> buckets[ i ] );
+        }
+    }
+}
+
+static void vdi_perf_print_default( const VDI_PERF * self ) {
+    const VDI_PERF_STAT * d = &( self -> decoded );
+    const VDI_PERF_STAT * s = &( self -> stored );
+    double decoded_per_row = vdi_perf_div( d -> bytes, d -> rows );
+    KOutMsg( "\nCOLUMN '%s':\n", self -> name );
+    KOutMsg( "  range           : %,ld ... %,ld\n", self -> first, self -> first + self -> count - 1 );
+    KOutMsg( "  sampled blobs   : %,lu ( %,lu rows )\n", d -> blobs, d -> rows );
+    KOutMsg( "  rows/blob       : min %,lu, avg %.1f, max %,lu\n",
+             d -> min_rows, vdi_perf_div( d -> rows, d -> blobs ), d -> max_rows );
+    KOutMsg( "  decoded         : %.1f bytes/blob, %.2f bytes/row\n",
+             vdi_perf_div( d -> bytes, d -> blobs ), decoded_per_row );
+    if ( self -> physical ) {
+        KOutMsg( "  stored          : %,lu blobs, %.1f bytes/blob, %.2f bytes/row\n",
+                 s -> blobs, vdi_perf_div( s -> bytes, s -> blobs ), vdi_perf_div( s -> bytes, s -> rows ) );
+        KOutMsg( "  compression     : %.3f ( decoded : stored )\n", vdi_perf_compression( self ) );
+    } else {
+        KOutMsg( "  stored          : not a physical column\n" );
+    }
+    KOutMsg( "  decode time     : %,lu ms, %.3f ms/blob, %.2f MB/s\n",
+             self -> decode_ms, vdi_perf_div( self -> decode_ms, d -> blobs ),
+             vdi_perf_div( d -> bytes, self -> decode_ms * 1000 ) );
+    vdi_perf_print_hist_default( "rows per blob", &( d -> rows_hist ) );
+    vdi_perf_print_hist_default( "decoded bytes per blob", &( d -> bytes_hist ) );
+    if ( self -> physical ) {
+        vdi_perf_print_hist_default( "stored bytes per blob", &( s -> bytes_hist ) );
+    }
+}
+
+static void vdi_perf_print_hist_json( const char * title, const VDI_PERF_HIST * hist ) {
+    uint32_t i;
+    bool first = true;
+    KOutMsg( ", \"%s\":[", title );
+    for ( i = 0; i < VDI_PERF_BUCKETS; ++i ) {
+        if ( hist -> buckets[ i ] > 0 ) {
+            uint64_t from = ( 0 == i ) ? 0 : ( ( uint64_t )1 << ( i - 1 ) );
+            uint64_t to = ( ( uint64_t )1 << i ) - 1;
+            KOutMsg( "%s{ \"from\":%lu, \"to\":%lu, \"count\":%lu }", first ? " " : ", ",
+                     from, to, hist -> buckets[ i ] );
+            first = false;
+        }
+    }
+    KOutMsg( " ]" );
+}
+
+static void vdi_perf_print_stat_json( const char * title, const VDI_PERF_STAT * stat ) {
+    KOutMsg( ", \"%s\":{ \"blobs\":%lu, \"rows\":%lu, \"bytes\":%lu, \"bytes_per_row\":%.4f",
+             title, stat -> blobs, stat -> rows, stat -> bytes, vdi_perf_div( stat -> bytes, stat -> rows ) );
+    vdi_perf_print_hist_json( "bytes_hist", &( stat -> bytes_hist ) );
+    KOutMsg( " }" );
+}
+
+static void vdi_perf_print_json( const VDI_PERF * self, bool first ) {
+    const VDI_PERF_STAT * d = &( self -> decoded );
+    KOutMsg( first ? "" : ",\n" );
+    KOutMsg( "{ \"%s\":{ \"first\":%ld, \"count\":%lu", self -> name, self -> first, self -> count );
+    KOutMsg( ", \"rows_per_blob\":{ \"min\":%lu, \"avg\":%.4f, \"max\":%lu",
+             d -> min_rows, vdi_perf_div( d -> rows, d -> blobs ), d -> max_rows );
+    vdi_perf_print_hist_json( "hist", &( d -> rows_hist ) );
+    KOutMsg( " }" );
+    vdi_perf_print_stat_json( "decoded", d );
+    if ( self -> physical ) {
+        vdi_perf_print_stat_json( "stored", &( self -> stored ) );
+        KOutMsg( ", \"compression\":%.4f", vdi_perf_compression( self ) );
+    }
+    KOutMsg( ", \"decode_ms\":%lu, \"ms_per_blob\":%.4f } }",
+             self -> decode_ms, vdi_perf_div( self -> decode_ms, d -> blobs ) );
+}
+
+static void vdi_perf_print_json_error( const char * name, rc_t rc, bool first ) {
+    KOutMsg( first ? "" : ",\n" );
+    KOutMsg( "{ \"%s\":{ \"error\":\"%R\" } }", name, rc );
+}
+
+void vdi_inspect_perf_begin( dump_format_t format ) {
+    if ( df_json == format ) {
+        KOutMsg( "{ \"columns\": [ \n" );
+    }
+}
+
+void vdi_inspect_perf_end( dump_format_t format ) {
+    if ( df_json == format ) {
+        KOutMsg( " ] }\n" );
+    }
+}
+
+rc_t vdi_inspect_perf_column( const VTable * tbl, const KTable * ktbl, const char * name,
+                              uint32_t samples, dump_format_t format, bool first ) {
+    VDI_PERF perf;
+    rc_t rc;
+    memset( &perf, 0, sizeof perf );
+    perf . name = name;
+    rc = vdi_perf_sample( tbl, ktbl, samples, &perf );
+    switch( format ) {
+        case df_json : if ( 0 == rc ) {
+                            vdi_perf_print_json( &perf, first );
+                        } else {
+                            vdi_perf_print_json_error( name, rc, first );
+                        }
+                        break;
+        default      : if ( 0 == rc ) { vdi_perf_print_default( &perf ); } break;
+    }
+    return rc;
+}
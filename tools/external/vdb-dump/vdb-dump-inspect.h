@@ -38,6 +38,14 @@ extern "C" {
 #ifndef _h_vdb_manager_
 #include <vdb/manager.h>
 #endif
+
+#ifndef _h_vdb_table_
+#include <vdb/table.h>
+#endif
+
+#ifndef _h_kdb_table_
+#include <kdb/table.h>
+#endif
     
 /*
 * the object can be:
@@ -60,6 +68,21 @@ extern "C" {
 rc_t vdi_inspect( const KDirectory * dir, const VDBManager *mgr,
                   const char * object, bool with_compression, dump_format_t format );
 
+/*
+* samples blobs of one column, spread evenly over its row-range:
+*    rows per blob, decoded bytes per blob and row, the time to decode them
+*    and, if there is a physical column of the same name ( ktbl not NULL ),
+*    the stored bytes per blob and row and the compression ratio
+* prints it as text or as json, if sampling fails the json-entry carries an "error"
+* instead of the statistics ( first: no separator in front of the json-entry )
+*/
+rc_t vdi_inspect_perf_column( const VTable * tbl, const KTable * ktbl, const char * name,
+                              uint32_t samples, dump_format_t format, bool first );
+
+/* open and close the json-array of the columns, nothing for the other formats */
+void vdi_inspect_perf_begin( dump_format_t format );
+void vdi_inspect_perf_end( dump_format_t format );
+
 #ifdef __cplusplus
 }
 #endif
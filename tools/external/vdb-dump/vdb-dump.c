@@ -113,6 +113,8 @@ static const char * append_usage[]              = { "append to output-file, if o
 static const char * ngc_usage[]                 = { "path to ngc file",                             NULL };
 static const char * view_usage[]                = { "view-name",                                    NULL };
 static const char * inspect_usage[]             = { "inspect data usage inside object",             NULL };
+static const char * inspect_perf_usage[]        = { "sample blobs per column: rows, sizes, compression, decode time", NULL };
+static const char * inspect_samples_usage[]     = { "blobs to sample per column with --inspect-perf (default 64)", NULL };
 
 /* from here on: not mentioned in help */
 static const char * len_spread_usage[]          = { "show spread of READ/REF_LEN values",           NULL };
@@ -172,7 +174,9 @@ OptDef DumpOptions[] =
     { OPTION_CELL_V1,               NULL,                     NULL, NULL,                    1, false,  false },
     { OPTION_NGC,                   NULL,                     NULL, ngc_usage,               1, true,   false },
     { OPTION_VIEW,                  NULL,                     NULL, view_usage,              1, true,   false },
-    { OPTION_INSPECT,               NULL,                     NULL, inspect_usage,           1, false,  false }
+    { OPTION_INSPECT,               NULL,                     NULL, inspect_usage,           1, false,  false },
+    { OPTION_INSPECT_PERF,          NULL,                     NULL, inspect_perf_usage,      1, false,  false },
+    { OPTION_INSPECT_SAMPLES,       NULL,                     NULL, inspect_samples_usage,   1, true,   false }
 };
 
 const char UsageDefaultName[] = "vdb-dump";
@@ -263,6 +267,8 @@ rc_t CC Usage ( const Args * args )
     HelpOptionLine ( NULL,                      OPTION_NGC,             "path",         ngc_usage);
     HelpOptionLine ( NULL,                      OPTION_VIEW,            "view",         view_usage );
     HelpOptionLine ( NULL,                      OPTION_INSPECT,         NULL,           inspect_usage );
+    HelpOptionLine ( NULL,                      OPTION_INSPECT_PERF,    NULL,           inspect_perf_usage );
+    HelpOptionLine ( NULL,                      OPTION_INSPECT_SAMPLES, "count",        inspect_samples_usage );
 
     HelpOptionsStandard ();
 
@@ -1306,6 +1312,31 @@ static rc_t vdm_enum_readable_columns( const VTable *tbl ) {
     return rc;
 }
 
+/*************************************************************************************
+    inspect_perf_columns:
+    * samples every column of the table, a column that fails does not stop the others:
+      the json-output gets an entry with the error and stays well formed
+    * returns the first error
+*************************************************************************************/
+static rc_t vdm_inspect_perf_columns( const p_dump_context ctx, const p_col_info_context ci_ctx,
+                                      const p_col_defs col_defs ) {
+    rc_t rc = 0;
+    uint32_t idx, printed = 0;
+    uint32_t count = VectorLength( &( col_defs -> cols ) );
+    vdi_inspect_perf_begin( ctx -> format );
+    for ( idx = 0; idx < count; ++idx ) {
+        const col_def *col = ( const col_def * )VectorGet( &( col_defs -> cols ), idx );
+        if ( NULL != col ) {
+            rc_t rc1 = vdi_inspect_perf_column( ci_ctx -> tbl, ci_ctx -> ktbl, col -> name,
+                                                ctx -> inspect_samples, ctx -> format, 0 == printed );
+            printed++;
+            if ( 0 == rc ) { rc = rc1; }
+        }
+    }
+    vdi_inspect_perf_end( ctx -> format );
+    return rc;
+}
+
 /*************************************************************************************
     enum_tab_columns:
     * called by "enum_db_columns()" and "dump_table()" as fkt-pointer
@@ -1340,6 +1371,11 @@ static rc_t vdm_enum_tab_columns( const p_dump_context ctx, const VTable *tbl )
                 extracted = vdm_extract_or_parse_phys_columns( ctx, tbl, col_defs, &invalid_columns );
                 rc = VTableOpenKTableRead( tbl, &( ci_ctx . ktbl ) );
                 DISP_RC( rc, "VTableOpenKTableRead() failed" );
+            } else if ( ctx -> inspect_perf ) {
+                /* the readable columns, the physical ones with the same name give the stored size */
+                extracted = vdm_extract_or_parse_columns( ctx, tbl, col_defs, &invalid_columns );
+                rc = VTableOpenKTableRead( tbl, &( ci_ctx . ktbl ) );
+                DISP_RC( rc, "VTableOpenKTableRead() failed" );
             } else if ( ctx -> enum_static ) {
                 extracted = vdm_extract_or_parse_static_columns( ctx, tbl, col_defs, &invalid_columns );
                 rc = VTableOpenKTableRead( tbl, &( ci_ctx . ktbl ) );
@@ -1352,13 +1388,17 @@ static rc_t vdm_enum_tab_columns( const p_dump_context ctx, const VTable *tbl )
                 rc = VTableOpenSchema( tbl, &( ci_ctx . schema ) );
                 DISP_RC( rc, "VTableOpenSchema() failed" );
                 if ( 0 == rc ) {
-                    uint32_t idx, count;
                     ctx -> generic_idx = 1;
-                    count = VectorLength( &( col_defs -> cols ) );
-                    for ( idx = 0; idx < count && 0 == rc; ++idx ) {
-                        col_def *col = ( col_def * )VectorGet( &( col_defs -> cols ), idx );
-                        if ( col != 0 ) {
-                            rc = vdm_print_column_info( col, &ci_ctx );
+                    if ( ctx -> inspect_perf ) {
+                        rc = vdm_inspect_perf_columns( ctx, &ci_ctx, col_defs );
+                    } else {
+                        uint32_t idx, count;
+                        count = VectorLength( &( col_defs -> cols ) );
+                        for ( idx = 0; idx < count && 0 == rc; ++idx ) {
+                            col_def *col = ( col_def * )VectorGet( &( col_defs -> cols ), idx );
+                            if ( col != 0 ) {
+                                rc = vdm_print_column_info( col, &ci_ctx );
+                            }
                         }
                     }
                     rc = vdh_vschema_release( rc, ci_ctx . schema );
@@ -1709,7 +1749,7 @@ static rc_t vdm_dump_tab_fkt( const p_dump_context ctx,
 
 static bool enum_col_request( const p_dump_context ctx ) {
     return ( ctx -> column_enum_requested || ctx -> column_enum_short ||
-             ctx -> show_kdb_blobs || ctx -> show_vdb_blobs ||
+             ctx -> show_kdb_blobs || ctx -> show_vdb_blobs || ctx -> inspect_perf ||
              ctx -> enum_phys || ctx -> enum_readable );
 }
 
@@ -28,6 +28,9 @@
 
 #include <stdio.h>
 #include <iostream>
+#include <algorithm>
+#include <map>
+#include <vector>
 
 #include <kapp/main.h>
 #include <klib/rc.h>
@@ -46,6 +49,7 @@ namespace AlignCache
         int64_t     id_spread_threshold;
         size_t      cursor_cache_size;
         size_t      min_cache_count;
+        size_t      thread_count;
 
         // Internal parameters
         bool cache_alignment_count;
@@ -62,6 +66,7 @@ namespace AlignCache
         1024UL << 20, // 1 GB
 #endif
         100000,
+        4,
         // Internal parameters
         true
     };
@@ -78,24 +83,16 @@ namespace AlignCache
     //char const ALIAS_MIN_CACHE_COUNT[]  = "";
     char const* USAGE_MIN_CACHE_COUNT[]  = { "if the number of primary alignment ids in the src db selected for caching is less than <min-cache-count>, the cache db will not be created at all", NULL };
 
+    char const OPTION_THREADS[] = "threads";
+    //char const ALIAS_THREADS[]  = "";
+    char const* USAGE_THREADS[]  = { "the number of threads scanning and reading the src db", NULL };
+
     ::OptDef Options[] =
     {
         { OPTION_ID_SPREAD_THRESHOLD, ALIAS_ID_SPREAD_THRESHOLD, NULL, USAGE_ID_SPREAD_THRESHOLD, 1, true, false },
         { OPTION_CURSOR_CACHE_SIZE, NULL, NULL, USAGE_CURSOR_CACHE_SIZE, 1, true, false },
         { OPTION_MIN_CACHE_COUNT, NULL, NULL, USAGE_MIN_CACHE_COUNT, 1, true, false },
-    };
-
-    struct PrimaryAlignmentData
-    {
-        uint64_t                    prev_key;
-        VDBObjects::CVCursor const* pCursorPA;
-        uint32_t const*             pColumnIndex;
-        uint32_t const*             pColumnIndexCache;
-        size_t const                column_count;
-        VDBObjects::CVCursor*       pCursorPACache;
-        //size_t                      count;
-        //size_t const                total_count;
-        KApp::CProgressBar*         pProgressBar;
+        { OPTION_THREADS, NULL, NULL, USAGE_THREADS, 1, true, false },
     };
 
     //size_t print_percent ( size_t count, size_t total_count )
@@ -121,147 +118,443 @@ namespace AlignCache
     //        return 0;
     //}
 
+    // Errors thrown in a worker thread are stored and re-thrown
+    // on the main thread after the worker is joined
+    struct ThreadError
+    {
+        bool failed;
+        rc_t rc;
+        char szDesc[256];
+
+        ThreadError () : failed (false), rc (0) { szDesc[0] = '\0'; }
+
+        // This function must be called inside catch block only
+        void Catch ()
+        {
+            failed = true;
+            try
+            {
+                throw;
+            }
+            catch (Utils::CErrorMsg const& e)
+            {
+                rc = e.getRC();
+                string_printf (szDesc, countof(szDesc), NULL, "%s", e.what());
+            }
+            catch (KProc::CKProcError const& e)
+            {
+                rc = e.getRC();
+                string_printf (szDesc, countof(szDesc), NULL, "%s", e.what());
+            }
+            catch (std::exception const& e)
+            {
+                string_printf (szDesc, countof(szDesc), NULL, "std::exception: %s", e.what());
+            }
+            catch (...)
+            {
+                string_printf (szDesc, countof(szDesc), NULL, "Unexpected exception occured");
+            }
+        }
+
+        void Rethrow () const
+        {
+            if ( failed )
+                throw Utils::CErrorMsg (rc, "%s", szDesc);
+        }
+    };
+
+    // One record of PRIMARY_ALIGNMENT to be cached
+    // the variable-length cells are kept in CacheBatch::strings
+    enum { STR_MATE_REF_NAME, STR_SAM_QUALITY, STR_SPOT_GROUP, STR_COUNT };
+
+    struct CacheRecord
+    {
+        int64_t  row_id;
+        int64_t  mate_align_id;
+        uint32_t sam_flags;
+        int32_t  template_len;
+        uint32_t mate_ref_pos;
+        uint8_t  rd_filter;
+        uint8_t  alignment_count;
+        size_t   str_offset [STR_COUNT];
+        uint32_t str_len [STR_COUNT];
+    };
+
+    struct CacheBatch
+    {
+        std::vector <CacheRecord> records;
+        std::vector <char>        strings;
+
+        void swap ( CacheBatch& x )
+        {
+            records.swap ( x.records );
+            strings.swap ( x.strings );
+        }
+    };
+
+    // Indices of the columns in DECLARE_PA_COLUMNS
+    enum
+    {
+        PA_MATE_ALIGN_ID,
+        PA_SAM_FLAGS,
+        PA_TEMPLATE_LEN,
+        PA_MATE_REF_NAME,
+        PA_MATE_REF_POS,
+        PA_SAM_QUALITY,
+        PA_RD_FILTER,
+        PA_SPOT_GROUP,
+        PA_ALIGNMENT_COUNT,
+        PA_COLUMN_COUNT
+    };
+
     template <typename T>
-    void copy_single_int_field (
-        VDBObjects::CVCursor const& curFrom,
-        VDBObjects::CVCursor& curTo,
-        int64_t row_id,
-        uint32_t column_index_from,
-        uint32_t column_index_to
-        )
+    T read_single_int_field ( VDBObjects::CVCursor const& cur, int64_t row_id, uint32_t column_index )
     {
-        T val;
-        curFrom.ReadItems ( row_id, column_index_from, & val, sizeof (T) );
-        curTo.Write ( column_index_to, & val, 1 );
+        T val = 0;
+        cur.ReadItems ( row_id, column_index, & val, 1 );
+        return val;
     }
 
-    void copy_str_field (
-        VDBObjects::CVCursor const& curFrom,
-        VDBObjects::CVCursor& curTo,
-        int64_t row_id,
-        uint32_t column_index_from,
-        uint32_t column_index_to
-        )
+    void read_str_field ( VDBObjects::CVCursor const& cur, int64_t row_id, uint32_t column_index,
+        CacheBatch& batch, CacheRecord& rec, size_t str_index )
     {
-        char val[4096];
-        uint32_t item_count = curFrom.ReadItems ( row_id, column_index_from, val, sizeof (val) );
-        curTo.Write ( column_index_to, val, item_count );
+        char const* data;
+        uint32_t len = cur.CellDataDirect ( row_id, column_index, & data );
+
+        rec.str_offset [str_index] = batch.strings.size ();
+        rec.str_len [str_index] = len;
+        batch.strings.insert ( batch.strings.end (), data, data + len );
     }
 
+    void ReadCacheRecord ( VDBObjects::CVCursor const& cur, uint32_t const* ColIndexPA, int64_t row_id, CacheBatch& batch )
+    {
+        CacheRecord rec;
+
+        rec.row_id          = row_id;
+        rec.mate_align_id   = read_single_int_field <int64_t>  ( cur, row_id, ColIndexPA[PA_MATE_ALIGN_ID] );
+        rec.sam_flags       = read_single_int_field <uint32_t> ( cur, row_id, ColIndexPA[PA_SAM_FLAGS] );
+        rec.template_len    = read_single_int_field <int32_t>  ( cur, row_id, ColIndexPA[PA_TEMPLATE_LEN] );
+        rec.mate_ref_pos    = read_single_int_field <uint32_t> ( cur, row_id, ColIndexPA[PA_MATE_REF_POS] );
+        rec.rd_filter       = read_single_int_field <uint8_t>  ( cur, row_id, ColIndexPA[PA_RD_FILTER] );
+        rec.alignment_count = g_Params.cache_alignment_count
+            ? read_single_int_field <uint8_t> ( cur, row_id, ColIndexPA[PA_ALIGNMENT_COUNT] )
+            : 0;
+
+        read_str_field ( cur, row_id, ColIndexPA[PA_MATE_REF_NAME], batch, rec, STR_MATE_REF_NAME );
+        read_str_field ( cur, row_id, ColIndexPA[PA_SAM_QUALITY], batch, rec, STR_SAM_QUALITY );
+        read_str_field ( cur, row_id, ColIndexPA[PA_SPOT_GROUP], batch, rec, STR_SPOT_GROUP );
+
+        batch.records.push_back ( rec );
+    }
+
+    void WriteCacheRecord ( VDBObjects::CVCursor& cur_cache, uint32_t const* ColIndexCache, CacheBatch const& batch, CacheRecord const& rec )
+    {
+        char const* strings = batch.strings.empty () ? "" : & batch.strings [0];
+
+        cur_cache.OpenRow ();
+
+        cur_cache.Write ( ColIndexCache[PA_MATE_ALIGN_ID], & rec.mate_align_id, 1 );
+        cur_cache.Write ( ColIndexCache[PA_SAM_FLAGS], & rec.sam_flags, 1 );
+        cur_cache.Write ( ColIndexCache[PA_TEMPLATE_LEN], & rec.template_len, 1 );
+        cur_cache.Write ( ColIndexCache[PA_MATE_REF_NAME], strings + rec.str_offset[STR_MATE_REF_NAME], rec.str_len[STR_MATE_REF_NAME] );
+        cur_cache.Write ( ColIndexCache[PA_MATE_REF_POS], & rec.mate_ref_pos, 1 );
+        cur_cache.Write ( ColIndexCache[PA_SAM_QUALITY], strings + rec.str_offset[STR_SAM_QUALITY], rec.str_len[STR_SAM_QUALITY] );
+        cur_cache.Write ( ColIndexCache[PA_RD_FILTER], & rec.rd_filter, 1 );
+        cur_cache.Write ( ColIndexCache[PA_SPOT_GROUP], strings + rec.str_offset[STR_SPOT_GROUP], rec.str_len[STR_SPOT_GROUP] );
+        if ( g_Params.cache_alignment_count )
+            cur_cache.Write ( ColIndexCache[PA_ALIGNMENT_COUNT], & rec.alignment_count, 1 );
+
+        cur_cache.CommitRow ();
+        cur_cache.CloseRow ();
+    }
 
-    rc_t KVectorCallbackPrimaryAlignment ( uint64_t key, bool value, void *user_data )
+    // The set of PRIMARY_ALIGNMENT row ids to be cached, one bit per row id.
+    // It is filled by the selection threads under the lock
+    // and only read once they are all done.
+    class AlignIDSet
     {
-        if ( ::Quitting() )
+    public:
+        AlignIDSet () : m_count (0) {}
+
+        void Add ( std::vector <int64_t> const& ids )
         {
-            LOGMSG ( klogWarn, "Interrupted" );
-            return 1;
+            KProc::CLockGuard <KProc::CKLock> guard ( m_lock );
+            for ( size_t i = 0; i < ids.size (); ++i )
+            {
+                int64_t const id = ids [i];
+                if ( id <= 0 )
+                {
+                    throw Utils::CErrorMsg ( RC ( rcExe, rcRow, rcReading, rcId, rcOutofrange ),
+                        "invalid PRIMARY_ALIGNMENT_ID: %ld", id );
+                }
+
+                size_t const word = (size_t)( (uint64_t)id / 64 );
+                uint64_t const bit = (uint64_t)1 << ( (uint64_t)id % 64 );
+                if ( word >= m_bits.size () )
+                    m_bits.resize ( word + 1, 0 );
+                if ( ( m_bits [word] & bit ) == 0 )
+                {
+                    m_bits [word] |= bit;
+                    ++ m_count;
+                }
+            }
         }
 
-        assert ( value );
-        PrimaryAlignmentData* p = (PrimaryAlignmentData*)user_data;
-        int64_t prev_row_id = (int64_t)p->prev_key;
-        int64_t row_id = (int64_t)key;
-        VDBObjects::CVCursor& cur_cache = *p->pCursorPACache;
-        
-        p->pProgressBar->Process ( 1, false );
+        // the number of distinct ids in the set
+        size_t Count () const { return m_count; }
 
-        //++p->count;
-        //print_percent (p->count, p->total_count);
+        // one past the largest id the set can hold
+        int64_t End () const { return (int64_t)m_bits.size () * 64; }
 
-        // Filling gaps between actually cached rows with zero-length records
-        if ( p->prev_key )
+        // the smallest id in the set that is not less than id, End() if there is none
+        int64_t Next ( int64_t id ) const
         {
-            if ( row_id - prev_row_id > 1)
+            int64_t const end = End ();
+            while ( id < end )
             {
-                cur_cache.OpenRow ();
-                cur_cache.CommitRow ();
-                if (row_id - prev_row_id > 2)
-                    cur_cache.RepeatRow ( row_id - prev_row_id - 2 ); // -2 due to the first zero-row has been written in the previous line
-                cur_cache.CloseRow ();
+                uint64_t const word = m_bits [ (size_t)( id / 64 ) ] >> ( id % 64 );
+                if ( word == 0 )
+                    id = ( id / 64 + 1 ) * 64;
+                else if ( word & 1 )
+                    return id;
+                else
+                    ++ id;
             }
+            return end;
         }
 
-        // Caching (copying) actual record from PRIMARY_ALIGNMENT table
-        {
-            // The very first visit - need to set starting row_id
-            if ( p->prev_key == 0 )
-                cur_cache.SetRowId ( row_id );
+    private:
+        std::vector <uint64_t> m_bits;
+        size_t m_count;
+        KProc::CKLock m_lock;
+    };
 
-            VDBObjects::CVCursor const& cur_pa = *p->pCursorPA;
-            uint32_t const* ColIndexPA = p->pColumnIndex;
-            uint32_t const* ColIndexCache = p->pColumnIndexCache;
+    // The set of row ids to be cached is cut into batches of about the same number of ids,
+    // the batches are read by several threads (each with its own cursor)
+    // and handed over to the single writer strictly in the order of row ids.
+    // Not more than max_in_flight batches are kept in memory.
+    struct CacheReadQueue
+    {
+        AlignIDSet const& ids;
+        std::vector <int64_t> const batch_start; // batch i is [batch_start[i], batch_start[i+1])
+        size_t const batch_count;
+        size_t const max_in_flight;
 
-            cur_cache.OpenRow ();
+        size_t next_to_read;
+        size_t next_to_write;
+        bool stop;
+        std::map <size_t, CacheBatch> done;
 
-            // MATE_ALIGN_ID
-            size_t column_index = 0;
-            copy_single_int_field <int64_t> (cur_pa, cur_cache, row_id, ColIndexPA[column_index], ColIndexCache[column_index] );
+        KProc::CKLock lock;
+        KProc::CKCondition cond_done;
+        KProc::CKCondition cond_space;
 
-            // SAM_FLAGS
-            ++ column_index;
-            copy_single_int_field <uint32_t> (cur_pa, cur_cache, row_id, ColIndexPA[column_index], ColIndexCache[column_index] );
+        static std::vector <int64_t> CutIntoBatches ( AlignIDSet const& ids, size_t batch_size )
+        {
+            std::vector <int64_t> starts;
+            size_t n = 0;
+            for ( int64_t id = ids.Next ( 0 ); id < ids.End (); id = ids.Next ( id + 1 ) )
+            {
+                if ( n++ % batch_size == 0 )
+                    starts.push_back ( id );
+            }
+            starts.push_back ( ids.End () );
+            return starts;
+        }
 
-            // TEMPLATE_LEN
-            ++ column_index;
-            copy_single_int_field <int32_t> (cur_pa, cur_cache, row_id, ColIndexPA[column_index], ColIndexCache[column_index] );
+        CacheReadQueue ( AlignIDSet const& row_ids, size_t batch_size, size_t in_flight )
+            : ids ( row_ids )
+            , batch_start ( CutIntoBatches ( row_ids, batch_size ) )
+            , batch_count ( batch_start.size () - 1 )
+            , max_in_flight ( in_flight )
+            , next_to_read ( 0 )
+            , next_to_write ( 0 )
+            , stop ( false )
+        {
+        }
 
-            // MATE_REF_NAME
-            ++ column_index;
-            copy_str_field (cur_pa, cur_cache, row_id, ColIndexPA[column_index], ColIndexCache[column_index] );
+        void Stop ()
+        {
+            KProc::CLockGuard <KProc::CKLock> guard ( lock );
+            stop = true;
+            cond_done.Broadcast ();
+            cond_space.Broadcast ();
+        }
 
-            // MATE_REF_POS
-            ++ column_index;
-            copy_single_int_field <uint32_t> (cur_pa, cur_cache, row_id, ColIndexPA[column_index], ColIndexCache[column_index] );
+        // returns false if there is nothing more to read
+        bool NextToRead ( size_t& batch_index )
+        {
+            KProc::CLockGuard <KProc::CKLock> guard ( lock );
+            while ( ! stop && next_to_read < batch_count && next_to_read >= next_to_write + max_in_flight )
+                cond_space.Wait ( lock );
+            if ( stop || next_to_read >= batch_count )
+                return false;
+            batch_index = next_to_read ++;
+            return true;
+        }
 
-            // SAM_QUALITY
-            ++ column_index;
-            copy_str_field (cur_pa, cur_cache, row_id, ColIndexPA[column_index], ColIndexCache[column_index] );
+        void Done ( size_t batch_index, CacheBatch& batch )
+        {
+            KProc::CLockGuard <KProc::CKLock> guard ( lock );
+            done [ batch_index ].swap ( batch );
+            cond_done.Broadcast ();
+        }
 
-            // RD_FILTER
-            ++ column_index;
-            copy_single_int_field <uint8_t> (cur_pa, cur_cache, row_id, ColIndexPA[column_index], ColIndexCache[column_index] );
+        // returns false if the queue was stopped before the batch arrived
+        bool NextToWrite ( size_t batch_index, CacheBatch& batch )
+        {
+            KProc::CLockGuard <KProc::CKLock> guard ( lock );
+            std::map <size_t, CacheBatch>::iterator it;
+            while ( ( it = done.find ( batch_index ) ) == done.end () )
+            {
+                if ( stop )
+                    return false;
+                cond_done.Wait ( lock );
+            }
+            batch.swap ( it->second );
+            done.erase ( it );
+            next_to_write = batch_index + 1;
+            cond_space.Broadcast ();
+            return true;
+        }
+    };
 
-            // SPOT_GROUP
-            ++ column_index;
-            copy_str_field (cur_pa, cur_cache, row_id, ColIndexPA[column_index], ColIndexCache[column_index] );
+    struct CacheReadJob
+    {
+        CacheReadQueue*      pQueue;
+        VDBObjects::CVCursor cursor;
+        uint32_t             ColumnIndex [ PA_COLUMN_COUNT ];
+        ThreadError          error;
+        KProc::CKThread      thread;
+    };
 
-            if ( g_Params.cache_alignment_count )
+    rc_t CacheReadThread ( void* data )
+    {
+        CacheReadJob& job = *static_cast <CacheReadJob*> (data);
+        CacheReadQueue& queue = *job.pQueue;
+        try
+        {
+            size_t batch_index;
+            while ( queue.NextToRead ( batch_index ) )
             {
-                // ALIGNMENT_COUNT
-                ++ column_index;
-                copy_single_int_field <uint8_t> (cur_pa, cur_cache, row_id, ColIndexPA[column_index], ColIndexCache[column_index] );
-            }
+                CacheBatch batch;
+                int64_t const last = queue.batch_start [batch_index + 1];
 
-            cur_cache.CommitRow ();
-            cur_cache.CloseRow ();
+                for ( int64_t id = queue.batch_start [batch_index]; id < last; id = queue.ids.Next ( id + 1 ) )
+                    ReadCacheRecord ( job.cursor, job.ColumnIndex, id, batch );
 
-            p->prev_key = key;
+                queue.Done ( batch_index, batch );
+            }
+        }
+        catch (...)
+        {
+            job.error.Catch ();
+            queue.Stop ();
         }
-
         return 0;
     }
 
-    bool ProcessSequenceRow ( int64_t idRow, VDBObjects::CVCursor const& cursor, KLib::CKVector& vect, uint32_t idxCol )
+    // Selection of the PRIMARY_ALIGNMENT rows to be cached:
+    // the row range of SEQUENCE is partitioned between several threads,
+    // each one scans PRIMARY_ALIGNMENT_ID on its own cursor a blob at a time
+    struct SelectionJob
     {
-        int64_t buf[3]; // TODO: find out the real type of this array
-        uint32_t items_read_count = cursor.ReadItems ( idRow, idxCol, buf, countof(buf) );
-        if ( items_read_count == 2 )
+        VDBObjects::CVCursor   cursor;
+        uint32_t               idxCol;
+        int64_t                idFirstRow;
+        uint64_t               nRowCount;
+        AlignIDSet*            pSelected;
+        std::vector <int64_t>  pending; // selected ids not yet added to pSelected
+        size_t                 count;
+        bool                   interrupted;
+        ThreadError            error;
+        KProc::CKThread        thread;
+    };
+
+    bool SelectAlignIDs ( int64_t const* ids, uint32_t id_count, std::vector <int64_t>& selected )
+    {
+        if ( id_count == 2 )
         {
-            int64_t id1 = buf[0];
-            int64_t id2 = buf[1];
+            int64_t id1 = ids[0];
+            int64_t id2 = ids[1];
             int64_t diff = id1 >= id2 ? id1 - id2 : id2 - id1;
 
             if (id1 && id2 && diff > g_Params.id_spread_threshold)
             {
-                vect.SetBool(id1, true);
-                vect.SetBool(id2, true);
+                selected.push_back ( id1 );
+                selected.push_back ( id2 );
                 return true;
             }
         }
         return false;
     }
 
-    size_t FillKVectorWithAlignIDs (VDBObjects::CVDatabase const& vdb, size_t cache_size, KLib::CKVector& vect )
+    // the selected ids are added to the shared set in chunks to keep the lock cold
+    size_t const SELECTION_FLUSH_COUNT = 65536;
+
+    void SelectRow ( SelectionJob& job, int64_t const* ids, uint32_t id_count )
+    {
+        if ( SelectAlignIDs ( ids, id_count, job.pending ) )
+        {
+            ++ job.count;
+            if ( job.pending.size () >= SELECTION_FLUSH_COUNT )
+            {
+                job.pSelected->Add ( job.pending );
+                job.pending.clear ();
+            }
+        }
+    }
+
+    rc_t SelectionThread ( void* data )
+    {
+        SelectionJob& job = *static_cast <SelectionJob*> (data);
+        try
+        {
+            int64_t idRow = job.idFirstRow;
+            int64_t const idEnd = job.idFirstRow + (int64_t)job.nRowCount;
+
+            while ( idRow < idEnd )
+            {
+                if ( ::Quitting() )
+                {
+                    job.interrupted = true;
+                    break;
+                }
+
+                VDBObjects::CVBlob blob = job.cursor.GetBlobDirect ( idRow, job.idxCol );
+                int64_t idBlobFirst = 0;
+                uint64_t nBlobCount = 0;
+                blob.GetIdRange ( idBlobFirst, nBlobCount );
+
+                int64_t idBlobEnd = std::min ( idBlobFirst + (int64_t)nBlobCount, idEnd );
+                if ( idRow < idBlobFirst || idBlobEnd <= idRow )
+                {
+                    // the blob does not cover the row - fall back to a single cell
+                    int64_t const* ids;
+                    uint32_t id_count = job.cursor.CellDataDirect ( idRow, job.idxCol, & ids );
+                    SelectRow ( job, ids, id_count );
+                    ++ idRow;
+                    continue;
+                }
+
+                for (; idRow < idBlobEnd; ++idRow )
+                {
+                    int64_t const* ids;
+                    uint32_t id_count = blob.CellData ( idRow, & ids );
+                    SelectRow ( job, ids, id_count );
+                }
+            }
+            job.pSelected->Add ( job.pending );
+            job.pending.clear ();
+        }
+        catch (...)
+        {
+            job.error.Catch ();
+        }
+        return 0;
+    }
+
+    size_t CollectAlignIDs (VDBObjects::CVDatabase const& vdb, size_t cache_size, size_t thread_count, AlignIDSet& ids )
     {
         char const* ColumnNamesSequence[] =
         {
@@ -271,32 +564,70 @@ namespace AlignCache
 
         VDBObjects::CVTable table = vdb.OpenTable("SEQUENCE");
 
-        VDBObjects::CVCursor cursor = table.CreateCursorRead ( cache_size );
-        cursor.InitColumnIndex (ColumnNamesSequence, ColumnIndexSequence, countof(ColumnNamesSequence), false);
-        cursor.Open();
-
-        int64_t idRow = 0;
+        int64_t idFirstRow = 0;
         uint64_t nRowCount = 0;
-        size_t count = 0;
+        {
+            VDBObjects::CVCursor cursor = table.CreateCursorRead ( cache_size );
+            cursor.InitColumnIndex (ColumnNamesSequence, ColumnIndexSequence, countof(ColumnNamesSequence), false);
+            cursor.Open();
+            cursor.GetIdRange (idFirstRow, nRowCount);
+        }
 
-        cursor.GetIdRange (idRow, nRowCount);
+        if ( (uint64_t)thread_count > nRowCount )
+            thread_count = nRowCount > 0 ? (size_t)nRowCount : 1;
 
-        for (; (uint64_t)idRow < nRowCount; ++idRow )
+        // the cursors are created on this thread, the workers only read from them
+        std::vector <SelectionJob> jobs ( thread_count );
+        uint64_t const nRowsPerJob = ( nRowCount + thread_count - 1 ) / thread_count;
+        for ( size_t i = 0; i < thread_count; ++i )
         {
-            if ( ::Quitting() )
-            {
-                LOGMSG ( klogWarn, "Interrupted" );
-                return 0;
-            }
+            SelectionJob& job = jobs [i];
+            job.cursor = table.CreateCursorRead ( cache_size / thread_count );
+            job.cursor.InitColumnIndex (ColumnNamesSequence, ColumnIndexSequence, countof(ColumnNamesSequence), false);
+            job.cursor.Open();
+            job.idxCol = ColumnIndexSequence[0];
+            job.idFirstRow = idFirstRow + (int64_t)(i * nRowsPerJob);
+            job.nRowCount = std::min ( nRowsPerJob, nRowCount - std::min ( nRowCount, i * nRowsPerJob ) );
+            job.pSelected = & ids;
+            job.count = 0;
+            job.interrupted = false;
+        }
 
-            if ( ProcessSequenceRow (idRow, cursor, vect, ColumnIndexSequence[0]) )
-                ++count;
+        size_t started = 0;
+        try
+        {
+            for ( ; started < thread_count; ++started )
+                jobs [started].thread.Make ( SelectionThread, & jobs [started] );
+        }
+        catch (...)
+        {
+            // the running threads use jobs, they must be finished before it goes away
+            for ( size_t i = 0; i < started; ++i )
+                jobs [i].thread.Wait ();
+            throw;
+        }
+
+        size_t count = 0;
+        bool interrupted = false;
+        for ( size_t i = 0; i < thread_count; ++i )
+        {
+            jobs [i].thread.Wait ();
+            count += jobs [i].count;
+            interrupted = interrupted || jobs [i].interrupted;
+        }
+        for ( size_t i = 0; i < thread_count; ++i )
+            jobs [i].error.Rethrow ();
+
+        if ( interrupted )
+        {
+            LOGMSG ( klogWarn, "Interrupted" );
+            return 0;
         }
 
         return count;
     }
 
-    void CachePrimaryAlignment (VDBObjects::CVDBManager& mgr, VDBObjects::CVDatabase const& vdb, size_t cache_size, KLib::CKVector const& vect, size_t vect_size, KApp::CProgressBar& progress_bar)
+    void CachePrimaryAlignment (VDBObjects::CVDBManager& mgr, VDBObjects::CVDatabase const& vdb, size_t cache_size, size_t thread_count, AlignIDSet const& ids, KApp::CProgressBar& progress_bar)
     {
         // Defining the set of columns to be copied from PRIMARY_ALIGNMENT table
         // to the new cache table
@@ -318,31 +649,52 @@ namespace AlignCache
         DECLARE_PA_COLUMNS (ColumnNamesPrimaryAlignmentCache, "_CACHE");
 #undef DECLARE_PA_COLUMNS
 
-        uint32_t ColumnIndexPrimaryAlignment [ countof (ColumnNamesPrimaryAlignment) ];
         uint32_t ColumnIndexPrimaryAlignmentCache [ countof (ColumnNamesPrimaryAlignmentCache) ];
 
-        // Openning cursor to iterate through PRIMARY_ALIGNMENT table
-        VDBObjects::CVTable tablePA = vdb.OpenTable("PRIMARY_ALIGNMENT");
-        VDBObjects::CVCursor cursorPA = tablePA.CreateCursorRead ( cache_size );
-        cursorPA.PermitPostOpenAdd();
-        cursorPA.InitColumnIndex ( ColumnNamesPrimaryAlignment, ColumnIndexPrimaryAlignment, countof(ColumnNamesPrimaryAlignment) - 1, false );
-        cursorPA.Open();
+        if ( thread_count == 0 )
+            thread_count = 1;
 
-        // Check if we can read ALIGNMENT_COUNT parameter
-        try
-        {
-            cursorPA.InitColumnIndex(
-                ColumnNamesPrimaryAlignment + countof(ColumnNamesPrimaryAlignment) - 1,
-                ColumnIndexPrimaryAlignment + countof(ColumnIndexPrimaryAlignment) - 1,
-                1, false
-            );
-        }
-        catch (Utils::CErrorMsg const& e)
+        // Openning one cursor per reading thread to fetch records from PRIMARY_ALIGNMENT table
+        VDBObjects::CVTable tablePA = vdb.OpenTable("PRIMARY_ALIGNMENT");
+        size_t const batch_size = 16384;
+        CacheReadQueue queue ( ids, batch_size, 4 * thread_count );
+        std::vector <CacheReadJob> jobs ( thread_count );
+        for ( size_t i = 0; i < thread_count; ++i )
         {
-            if (e.getRC() == RC ( rcVDB, rcCursor, rcUpdating, rcColumn, rcNotFound ) )
-                g_Params.cache_alignment_count = false;
-            else
-                throw;
+            CacheReadJob& job = jobs [i];
+            job.pQueue = & queue;
+            job.cursor = tablePA.CreateCursorRead ( cache_size / thread_count );
+            job.cursor.PermitPostOpenAdd();
+            job.cursor.InitColumnIndex ( ColumnNamesPrimaryAlignment, job.ColumnIndex, countof(ColumnNamesPrimaryAlignment) - 1, false );
+            job.cursor.Open();
+
+            if ( i == 0 )
+            {
+                // Check if we can read ALIGNMENT_COUNT parameter
+                try
+                {
+                    job.cursor.InitColumnIndex(
+                        ColumnNamesPrimaryAlignment + countof(ColumnNamesPrimaryAlignment) - 1,
+                        job.ColumnIndex + countof(job.ColumnIndex) - 1,
+                        1, false
+                    );
+                }
+                catch (Utils::CErrorMsg const& e)
+                {
+                    if (e.getRC() == RC ( rcVDB, rcCursor, rcUpdating, rcColumn, rcNotFound ) )
+                        g_Params.cache_alignment_count = false;
+                    else
+                        throw;
+                }
+            }
+            else if ( g_Params.cache_alignment_count )
+            {
+                job.cursor.InitColumnIndex(
+                    ColumnNamesPrimaryAlignment + countof(ColumnNamesPrimaryAlignment) - 1,
+                    job.ColumnIndex + countof(job.ColumnIndex) - 1,
+                    1, false
+                );
+            }
         }
 
         // Creating new cache table (with the same name - PRIMARY_ALIGNMENT but in the separate DB file)
@@ -359,21 +711,71 @@ namespace AlignCache
         cursorCache.InitColumnIndex ( ColumnNamesPrimaryAlignmentCache, ColumnIndexPrimaryAlignmentCache, countof (ColumnNamesPrimaryAlignmentCache) - (size_t) (!g_Params.cache_alignment_count), true );
         cursorCache.Open ();
 
-        //PrimaryAlignmentData data = { 0, &cursorPA, ColumnIndexPrimaryAlignment, ColumnIndexPrimaryAlignmentCache, countof (ColumnNamesPrimaryAlignment), &cursorCache, 0, vect_size };
-        progress_bar.Append (vect_size);
-        PrimaryAlignmentData data =
-        {
-            0,
-            &cursorPA,
-            ColumnIndexPrimaryAlignment,
-            ColumnIndexPrimaryAlignmentCache,
-            countof (ColumnNamesPrimaryAlignment),
-            &cursorCache,
-            &progress_bar
-        };
+        progress_bar.Append (ids.Count ());
+
+        size_t started = 0;
+        try
+        {
+            for ( ; started < thread_count; ++started )
+                jobs [started].thread.Make ( CacheReadThread, & jobs [started] );
+
+            int64_t prev_row_id = 0;
+            CacheBatch batch;
+            for ( size_t batch_index = 0; batch_index < queue.batch_count; ++batch_index )
+            {
+                if ( ::Quitting() )
+                {
+                    LOGMSG ( klogWarn, "Interrupted" );
+                    break;
+                }
+
+                if ( ! queue.NextToWrite ( batch_index, batch ) )
+                    break; // a reader failed, the error is re-thrown below
+
+                for ( size_t i = 0; i < batch.records.size (); ++i )
+                {
+                    CacheRecord const& rec = batch.records [i];
+                    int64_t row_id = rec.row_id;
+
+                    progress_bar.Process ( 1, false );
+
+                    // Filling gaps between actually cached rows with zero-length records
+                    if ( prev_row_id )
+                    {
+                        if ( row_id - prev_row_id > 1)
+                        {
+                            cursorCache.OpenRow ();
+                            cursorCache.CommitRow ();
+                            if (row_id - prev_row_id > 2)
+                                cursorCache.RepeatRow ( row_id - prev_row_id - 2 ); // -2 due to the first zero-row has been written in the previous line
+                            cursorCache.CloseRow ();
+                        }
+                    }
+                    else
+                    {
+                        // The very first visit - need to set starting row_id
+                        cursorCache.SetRowId ( row_id );
+                    }
+
+                    WriteCacheRecord ( cursorCache, ColumnIndexPrimaryAlignmentCache, batch, rec );
+                    prev_row_id = row_id;
+                }
+            }
+        }
+        catch (...)
+        {
+            queue.Stop ();
+            for ( size_t i = 0; i < started; ++i )
+                jobs [i].thread.Wait ();
+            throw;
+        }
+
+        queue.Stop ();
+        for ( size_t i = 0; i < thread_count; ++i )
+            jobs [i].thread.Wait ();
+        for ( size_t i = 0; i < thread_count; ++i )
+            jobs [i].error.Rethrow ();
 
-        // process each saved primary_alignment_id
-        vect.VisitBool ( KVectorCallbackPrimaryAlignment, & data );
         cursorCache.Commit ();
     }
 
@@ -389,13 +791,13 @@ namespace AlignCache
         VDBObjects::CVDatabase vdb = mgr.OpenDB (g_Params.dbPathSrc);
 
         // Scan SEQUENCE table to find mate_alignment_ids that have to be cached
-        KLib::CKVector vect;
-        size_t count = FillKVectorWithAlignIDs ( vdb, g_Params.cursor_cache_size, vect );
+        AlignIDSet ids;
+        size_t count = CollectAlignIDs ( vdb, g_Params.cursor_cache_size, g_Params.thread_count, ids );
 
         if ( count*2 >= g_Params.min_cache_count )
         {
-            // For each id in vect cache the PRIMARY_ALIGNMENT record
-            CachePrimaryAlignment ( mgr, vdb, g_Params.cursor_cache_size, vect, count*2, progress_bar );
+            // For each id in ids cache the PRIMARY_ALIGNMENT record
+            CachePrimaryAlignment ( mgr, vdb, g_Params.cursor_cache_size, g_Params.thread_count, ids, progress_bar );
         }
         else
         {
@@ -484,6 +886,11 @@ namespace AlignCache
             if (args.GetOptionCount (OPTION_MIN_CACHE_COUNT))
                 g_Params.min_cache_count = args.GetOptionValueUInt <size_t> ( OPTION_MIN_CACHE_COUNT, 0 );
 
+            if (args.GetOptionCount (OPTION_THREADS))
+                g_Params.thread_count = args.GetOptionValueUInt <size_t> ( OPTION_THREADS, 0 );
+            if ( g_Params.thread_count == 0 )
+                g_Params.thread_count = 1;
+
             return create_cache_db_impl_safe ();
         }
         catch (...) // here we handle only exceptions in CArgs or CXMLLogger
@@ -534,6 +941,7 @@ extern "C"
         HelpOptionLine (AlignCache::ALIAS_ID_SPREAD_THRESHOLD, AlignCache::OPTION_ID_SPREAD_THRESHOLD, "value", AlignCache::USAGE_ID_SPREAD_THRESHOLD);
         HelpOptionLine (NULL, AlignCache::OPTION_CURSOR_CACHE_SIZE, "value in MB", AlignCache::USAGE_CURSOR_CACHE_SIZE);
         HelpOptionLine (NULL, AlignCache::OPTION_MIN_CACHE_COUNT, "count", AlignCache::USAGE_MIN_CACHE_COUNT);
+        HelpOptionLine (NULL, AlignCache::OPTION_THREADS, "count", AlignCache::USAGE_THREADS);
         XMLLogger_Usage();
 
         printf ("\n");
@@ -342,6 +342,72 @@ namespace VDBObjects
             throw Utils::CErrorMsg(rc, "VCursorCommit");
     }
 
+    CVBlob CVCursor::GetBlobDirect (int64_t idRow, uint32_t idxCol) const
+    {
+        CVBlob obj;
+        rc_t rc = ::VCursorGetBlobDirect ( m_pSelf, & obj.m_pSelf, idRow, idxCol );
+        if (rc)
+            throw Utils::CErrorMsg(rc, "VCursorGetBlobDirect: row_id=%ld, idxCol=%u", idRow, idxCol);
+
+#if DEBUG_PRINT != 0
+        printf("Created VBlob %p\n", obj.m_pSelf);
+#endif
+        return obj;
+    }
+
+///////////////////////////////////////////////////////////////////////////////////
+
+    CVBlob::CVBlob() : m_pSelf(NULL)
+    {}
+
+    CVBlob::~CVBlob()
+    {
+        Release();
+    }
+
+    CVBlob::CVBlob(CVBlob const& x)
+    {
+        Clone(x);
+    }
+
+    CVBlob& CVBlob::operator=(CVBlob const& x)
+    {
+        if (m_pSelf)
+            Release();
+
+        Clone(x);
+        return *this;
+    }
+
+    void CVBlob::Release()
+    {
+        if (m_pSelf)
+        {
+#if DEBUG_PRINT != 0
+            printf("Releasing VBlob %p\n", m_pSelf);
+#endif
+            ::VBlobRelease(m_pSelf);
+            m_pSelf = NULL;
+        }
+    }
+
+    void CVBlob::Clone(CVBlob const& x)
+    {
+        m_pSelf = x.m_pSelf;
+        if ( m_pSelf != NULL )
+            ::VBlobAddRef ( m_pSelf );
+#if DEBUG_PRINT != 0
+        printf ("CLONING VBlob %p\n", m_pSelf);
+#endif
+    }
+
+    void CVBlob::GetIdRange(int64_t& idFirstRow, uint64_t& nRowCount) const
+    {
+        rc_t rc = ::VBlobIdRange(m_pSelf, &idFirstRow, &nRowCount);
+        if (rc)
+            throw Utils::CErrorMsg(rc, "VBlobIdRange");
+    }
+
 ///////////////////////////////////////////////////////////////////////////////////
 
     CVTable::CVTable() : m_pSelf(NULL)
@@ -854,6 +920,28 @@ namespace Utils
         return m_szDescr;
     }
 
+    static int64_t HandleErrorRC ( char const* what, rc_t rc, bool bSilent, char* pErrDesc, size_t sizeErrDesc )
+    {
+        char szBufErr[512];
+        if ( pErrDesc == NULL )
+        {
+            pErrDesc = szBufErr;
+            sizeErrDesc = countof(szBufErr);
+        }
+        rc_t res;
+        if (rc != 0)
+            res = string_printf(pErrDesc, sizeErrDesc, NULL, "%s failed with code 0x%08x (%u) [%R]", what, rc, rc, rc);
+        else
+            res = string_printf(pErrDesc, sizeErrDesc, NULL, "%s", what);
+        if (res == rcBuffer || res == rcInsufficient)
+            pErrDesc [sizeErrDesc - 1] = '\0';
+
+        if ( ! bSilent )
+            LOGMSG ( klogErr, pErrDesc );
+
+        return rc;
+    }
+
     int64_t HandleException ( bool bSilent, char* pErrDesc, size_t sizeErrDesc )
     {
         try
@@ -862,25 +950,11 @@ namespace Utils
         }
         catch (Utils::CErrorMsg const& e)
         {
-            char szBufErr[512];
-            if ( pErrDesc == NULL )
-            {
-                pErrDesc = szBufErr;
-                sizeErrDesc = countof(szBufErr);
-            }
-            size_t rc = e.getRC();
-            rc_t res;
-            if (rc != 0)
-                res = string_printf(pErrDesc, sizeErrDesc, NULL, "%s failed with code 0x%08x (%u) [%R]", e.what(), rc, rc, rc);
-            else
-                res = string_printf(pErrDesc, sizeErrDesc, NULL, "%s", e.what());
-            if (res == rcBuffer || res == rcInsufficient)
-                pErrDesc [sizeErrDesc - 1] = '\0';
-
-            if ( ! bSilent )
-                LOGMSG ( klogErr, pErrDesc );
-
-            return rc;
+            return HandleErrorRC ( e.what(), e.getRC(), bSilent, pErrDesc, sizeErrDesc );
+        }
+        catch (KProc::CKProcError const& e)
+        {
+            return HandleErrorRC ( e.what(), e.getRC(), bSilent, pErrDesc, sizeErrDesc );
         }
         catch (std::exception const& e)
         {
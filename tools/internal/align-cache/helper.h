@@ -35,13 +35,14 @@
 #include <vdb/database.h>
 #include <vdb/table.h>
 #include <vdb/cursor.h>
+#include <vdb/blob.h>
 #include <klib/printf.h>
 #include <klib/vector.h>
 #include <kapp/args.h>
 #include <kapp/log-xml.h>
 
 #include <loader/progressbar.h>
-
+#include <kproc.hpp>
 
 #ifndef countof
 #define countof(arr) (sizeof(arr)/sizeof(arr[0]))
@@ -161,6 +162,7 @@ namespace VDBObjects
     template<> inline void CPostReadAction<char>::operator()() const { m_pBuf[m_nCount] = '\0'; }
     template<> inline void CPostReadAction<unsigned char>::operator()() const { m_pBuf[m_nCount] = '\0'; }
 
+    class CVBlob;
     class CVCursor;
     class CVTable;
     class CVDatabase;
@@ -289,6 +291,24 @@ namespace VDBObjects
             return nItemsRead;
         }
 
+        // zero-copy access to a cell, pData is valid until the next read from this cursor
+        template <typename T> uint32_t CellDataDirect (int64_t idRow, uint32_t idxCol, T const** ppData) const
+        {
+            uint32_t elem_bits, bit_offset, row_len;
+            void const* base;
+
+            rc_t rc = ::VCursorCellDataDirect(m_pSelf, idRow, idxCol, &elem_bits, &base, &bit_offset, &row_len);
+            if (rc)
+                throw Utils::CErrorMsg(rc, "VCursorCellDataDirect: row_id=%ld, idxCol=%u", idRow, idxCol);
+            if (elem_bits != 8*sizeof(T) || bit_offset != 0)
+                throw Utils::CErrorMsg(0, "VCursorCellDataDirect: row_id=%ld, idxCol=%u - unexpected elem_bits=%u", idRow, idxCol, elem_bits);
+
+            *ppData = static_cast<T const*>(base);
+            return row_len;
+        }
+
+        CVBlob GetBlobDirect (int64_t idRow, uint32_t idxCol) const;
+
         template <typename T> void Write (uint32_t idxCol, T const* pBuf, uint64_t count)
         {
             rc_t rc = ::VCursorWrite ( m_pSelf, idxCol, 8 * sizeof(T), pBuf, 0, count );
@@ -308,6 +328,43 @@ namespace VDBObjects
         void Clone(CVCursor const& x);
         ::VCursor* m_pSelf;
     };
+
+////////////////////////////////////////////////////////////////////////////
+
+    class CVBlob
+    {
+    public:
+        friend CVBlob CVCursor::GetBlobDirect (int64_t idRow, uint32_t idxCol) const;
+
+        CVBlob();
+        ~CVBlob();
+        CVBlob(CVBlob const& x);
+        CVBlob& operator=(CVBlob const& x);
+
+        void Release();
+        bool IsEmpty() const { return m_pSelf == NULL; }
+        void GetIdRange(int64_t& idFirstRow, uint64_t& nRowCount) const;
+
+        // zero-copy access to a cell of the blob, pData is valid as long as the blob
+        template <typename T> uint32_t CellData (int64_t idRow, T const** ppData) const
+        {
+            uint32_t elem_bits, bit_offset, row_len;
+            void const* base;
+
+            rc_t rc = ::VBlobCellData(m_pSelf, idRow, &elem_bits, &base, &bit_offset, &row_len);
+            if (rc)
+                throw Utils::CErrorMsg(rc, "VBlobCellData: row_id=%ld", idRow);
+            if (elem_bits != 8*sizeof(T) || bit_offset != 0)
+                throw Utils::CErrorMsg(0, "VBlobCellData: row_id=%ld - unexpected elem_bits=%u", idRow, elem_bits);
+
+            *ppData = static_cast<T const*>(base);
+            return row_len;
+        }
+
+    private:
+        void Clone(CVBlob const& x);
+        ::VBlob const* m_pSelf;
+    };
 }
 
 ///////////////////////
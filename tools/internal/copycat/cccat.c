@@ -618,6 +618,20 @@ rc_t ccat_enc ( CCContainerNode **np, const KFile *sf, KTime_t mtime,
     return rc;
 }
 
+/* files of unknown size are streams and go through a pipe,
+   the others only when they are large enough to keep a thread busy */
+static
+bool ccat_use_pipe ( const KFile *f )
+{
+    uint64_t size;
+
+    if ( no_threads )
+        return false;
+    if ( KFileSize ( f, & size ) != 0 )
+        return true;
+    return size >= CCPIPE_MIN_SIZE;
+}
+
 static
 rc_t ccat_cmp ( CCContainerNode **np, const KFile *sf, KTime_t mtime,
                 enum CCType ntype, CCFileNode *node, const char *name, uint32_t type_id )
@@ -647,6 +661,15 @@ rc_t ccat_cmp ( CCContainerNode **np, const KFile *sf, KTime_t mtime,
         return 0;
     }
 
+    /* decompress on a thread of its own, ahead of the analysis */
+    if ( rc == 0 && ccat_use_pipe ( sf ) )
+    {
+        const KFile *ra;
+        rc = CCPipeFileMakeReadAhead ( & ra, zf );
+        KFileRelease ( zf );
+        zf = ra;
+    }
+
     if ( rc != 0 )
         PLOGERR ( klogInt,  (klogInt, rc, "failed to decompress file '$(path)'", "path=%s", name ));
     else
@@ -925,6 +948,46 @@ rc_t ccat_sz ( CCTree *tree, const KFile *sf, KTime_t mtime,
     return rc;
 }
 
+/* the MD5 is calculated on a thread of its own, behind the reads of the
+   rest of the chain: decompression, analysis and hashing of the nesting
+   levels of a submission run side by side */
+static
+rc_t ccat_md5_pipe ( CCTree *tree, const KFile *sf, KTime_t mtime,
+                     enum CCType ntype, CCFileNode *node, const char *name )
+{
+    const KFile *md5;
+    rc_t rc, orc;
+
+    rc = CCPipeFileMakeMD5Read ( & md5, sf );
+    if ( rc != 0 )
+        PLOGERR ( klogInt,  (klogInt, rc, "failed to create md5 wrapper for '$(path)'", "path=%s", name ));
+    else
+    {
+        /* continue on to obtaining file size */
+        rc = ccat_sz ( tree, md5, mtime, ntype, node, name );
+
+        /* waits for the hashing thread to finish the digest */
+        if ( rc == 0 )
+        {
+            rc = CCPipeFileMD5Digest ( md5, node -> _md5 );
+            if ( rc != 0 )
+                PLOGERR ( klogInt, (klogInt, rc, "failed to obtain md5 digest for '$(path)'", "path=%s", name ));
+        }
+
+        orc = KFileRelease ( md5 );
+        if (orc)
+        {
+            PLOGERR (klogInt,
+                     (klogInt, orc,
+                      "failure in release reference counting file for '$(path)'",
+                      "path=%s", name ));
+            if (rc == 0)
+                rc = orc;
+        }
+    }
+    return rc;
+}
+
 rc_t ccat_md5 ( CCTree *tree, const KFile *sf, KTime_t mtime,
                 enum CCType ntype, CCFileNode *node, const char *name )
 {
@@ -941,6 +1004,9 @@ rc_t ccat_md5 ( CCTree *tree, const KFile *sf, KTime_t mtime,
     if ( no_md5 )
         return ccat_sz ( tree, sf, mtime, ntype, node, name );
 
+    if ( ccat_use_pipe ( sf ) )
+        return ccat_md5_pipe ( tree, sf, mtime, ntype, node, name );
+
     /* normal md5 path */
     rc = KMD5SumFmtMakeUpdate ( & fmt, fnull );
     if ( rc != 0 )
@@ -1393,6 +1459,26 @@ rc_t copycat_add_md5 (const copycat_pb * ppb)
     return rc;
 }
 
+/* -----
+ * copycat_add_write_thread
+ *
+ * the CRC and the write of the copy run on a thread of their own, behind
+ * the read side; without the thread they stay on this one
+ */
+static
+void copycat_add_write_thread (copycat_pb * pb)
+{
+    KFile * df;
+
+    if (CCPipeFileMakeWriteBehind (&df, pb->df) == 0)
+    {
+        /* the pipe has its own reference to the file it writes */
+        KFileRelease (pb->df);
+        pb->df = df;
+    }
+}
+
+
 /* -----
  * copycat_add_crc
  *
@@ -1450,6 +1536,10 @@ rc_t copycat_add_crc (const  copycat_pb * ppb)
                 /* give the wrapper its own reference
                    rather than taking the one we gave it */
                 rc = KFileAddRef (ppb->df);
+                if (rc == 0 && ! no_threads &&
+                    (pb.node->expected == SIZE_UNKNOWN ||
+                     pb.node->expected >= CCPIPE_MIN_SIZE))
+                    copycat_add_write_thread (&pb);
                 if (rc)
                     PLOGERR (klogInt,
                              (klogInt, rc, 
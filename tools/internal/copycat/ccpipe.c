@@ -0,0 +1,677 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ */
+
+#include "copycat-priv.h"
+
+#include <klib/log.h>
+#include <klib/rc.h>
+#include <klib/checksum.h>
+#include <kfs/file.h>
+#include <kproc/thread.h>
+#include <kproc/lock.h>
+#include <kproc/cond.h>
+#include <sysalloc.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ======================================================================
+ * CCPipeFile
+ *  a KFile wrapper that hands one stage of the cataloging chain
+ *  to a thread of its own:
+ *
+ *  ccpMD5Read      - the reader passes through, the bytes it reads are
+ *                    copied into buffers and hashed by the thread
+ *  ccpReadAhead    - the thread reads the original sequentially into
+ *                    buffers ahead of the reader ( decompression )
+ *  ccpWriteBehind  - the writes are copied into buffers and written
+ *                    into the original by the thread ( CRC and copy )
+ */
+typedef struct CCPipeFile CCPipeFile;
+#define KFILE_IMPL struct CCPipeFile
+#include <kfs/impl.h>
+
+/* a few large buffers per stage keep both sides busy */
+#define CCPIPE_BUFFERS 4
+#define CCPIPE_BUFSIZE ( 256 * 1024 )
+
+typedef enum CCPipeMode
+{
+    ccpMD5Read,
+    ccpReadAhead,
+    ccpWriteBehind
+} CCPipeMode;
+
+typedef struct CCPipeBuf
+{
+    uint64_t pos;
+    size_t size;
+    rc_t rc;
+    char * data;
+} CCPipeBuf;
+
+struct CCPipeFile
+{
+    KFile dad;
+    KFile * original;
+    CCPipeMode mode;
+
+    KThread * thread;
+    KLock * lock;
+    KCondition * cond;
+
+    /* "count" filled buffers starting at "head",
+       "fill" is the one the producer is filling if not NULL */
+    CCPipeBuf ring [ CCPIPE_BUFFERS ];
+    CCPipeBuf * fill;
+    uint32_t head;
+    uint32_t count;
+
+    bool done;          /* the producer will not fill any more buffers */
+    bool stop;          /* the consumer does not want any more buffers */
+    rc_t rc;            /* first write error of the thread */
+
+    /* ccpMD5Read */
+    MD5State md5;
+    uint64_t hashed;    /* bytes handed to the thread so far */
+    uint8_t digest [ 16 ];
+    bool finished;      /* the thread is joined and "digest" is final */
+
+    /* ccpReadAhead */
+    uint64_t ahead;     /* the next position the thread reads */
+    bool direct;        /* the thread is gone, read the original */
+};
+
+
+/* ----------------------------------------------------------------------
+ * the ring of buffers
+ */
+/* producer: wait for an empty buffer, NULL if the consumer stopped */
+static
+CCPipeBuf * CCPipeFileGetEmpty (CCPipeFile *self)
+{
+    CCPipeBuf * buf = NULL;
+
+    KLockAcquire (self->lock);
+    while (self->count == CCPIPE_BUFFERS && ! self->stop)
+        KConditionWait (self->cond, self->lock);
+    if (! self->stop)
+        buf = &self->ring [(self->head + self->count) % CCPIPE_BUFFERS];
+    KLockUnlock (self->lock);
+    return buf;
+}
+
+static
+void CCPipeFilePutFilled (CCPipeFile *self)
+{
+    KLockAcquire (self->lock);
+    ++self->count;
+    KConditionBroadcast (self->cond);
+    KLockUnlock (self->lock);
+}
+
+/* consumer: wait for a filled buffer, NULL if there will be no more */
+static
+CCPipeBuf * CCPipeFileGetFilled (CCPipeFile *self)
+{
+    CCPipeBuf * buf = NULL;
+
+    KLockAcquire (self->lock);
+    while (self->count == 0 && ! self->done)
+        KConditionWait (self->cond, self->lock);
+    if (self->count != 0)
+        buf = &self->ring [self->head];
+    KLockUnlock (self->lock);
+    return buf;
+}
+
+static
+void CCPipeFilePutEmpty (CCPipeFile *self)
+{
+    KLockAcquire (self->lock);
+    self->head = (self->head + 1) % CCPIPE_BUFFERS;
+    --self->count;
+    KConditionBroadcast (self->cond);
+    KLockUnlock (self->lock);
+}
+
+static
+void CCPipeFileSetFlag (CCPipeFile *self, bool *flag)
+{
+    KLockAcquire (self->lock);
+    *flag = true;
+    KConditionBroadcast (self->cond);
+    KLockUnlock (self->lock);
+}
+
+/* producer: pass the partly filled buffer on */
+static
+void CCPipeFileFlush (CCPipeFile *self)
+{
+    if (self->fill != NULL)
+    {
+        if (self->fill->size > 0)
+            CCPipeFilePutFilled (self);
+        self->fill = NULL;
+    }
+}
+
+/* producer: copy bytes into the buffers, contiguous bytes share a buffer */
+static
+rc_t CCPipeFileSubmit (CCPipeFile *self, uint64_t pos, const void *data, size_t size)
+{
+    const char * p = data;
+
+    while (size > 0)
+    {
+        size_t n;
+
+        if (self->fill != NULL &&
+            (self->fill->pos + self->fill->size != pos || self->fill->size == CCPIPE_BUFSIZE))
+            CCPipeFileFlush (self);
+
+        if (self->fill == NULL)
+        {
+            self->fill = CCPipeFileGetEmpty (self);
+            if (self->fill == NULL)
+                return RC (rcExe, rcFile, rcWriting, rcTransfer, rcCanceled);
+            self->fill->pos = pos;
+            self->fill->size = 0;
+            self->fill->rc = 0;
+        }
+
+        n = CCPIPE_BUFSIZE - self->fill->size;
+        if (n > size)
+            n = size;
+        memmove (self->fill->data + self->fill->size, p, n);
+        self->fill->size += n;
+        p += n;
+        pos += n;
+        size -= n;
+    }
+    return 0;
+}
+
+
+/* ----------------------------------------------------------------------
+ * the threads
+ */
+/* ccpMD5Read and ccpWriteBehind: hash or write what the caller passed on */
+static
+rc_t CC CCPipeFileConsumer (const KThread *t, void *data)
+{
+    CCPipeFile * self = data;
+    CCPipeBuf * buf;
+
+    while ((buf = CCPipeFileGetFilled (self)) != NULL)
+    {
+        if (self->mode == ccpMD5Read)
+            MD5StateAppend (&self->md5, buf->data, buf->size);
+
+        /* after an error the remaining buffers are dropped */
+        else if (self->rc == 0)
+        {
+            size_t num_writ;
+            rc_t rc = KFileWriteAll (self->original, buf->pos, buf->data, buf->size, &num_writ);
+            if (rc == 0 && num_writ != buf->size)
+                rc = RC (rcExe, rcFile, rcWriting, rcTransfer, rcIncomplete);
+            if (rc != 0)
+            {
+                KLockAcquire (self->lock);
+                self->rc = rc;
+                KLockUnlock (self->lock);
+            }
+        }
+        CCPipeFilePutEmpty (self);
+    }
+    return 0;
+}
+
+/* ccpReadAhead: read the original from start to end */
+static
+rc_t CC CCPipeFileReader (const KThread *t, void *data)
+{
+    CCPipeFile * self = data;
+    CCPipeBuf * buf;
+    bool eof = false;
+
+    while (! eof && (buf = CCPipeFileGetEmpty (self)) != NULL)
+    {
+        buf->pos = self->ahead;
+        buf->rc = KFileReadAll (self->original, buf->pos, buf->data, CCPIPE_BUFSIZE, &buf->size);
+        if (buf->rc != 0)
+            buf->size = 0;
+        eof = (buf->rc != 0 || buf->size < CCPIPE_BUFSIZE);
+        self->ahead += buf->size;
+        CCPipeFilePutFilled (self);
+    }
+    CCPipeFileSetFlag (self, &self->done);
+    return 0;
+}
+
+static
+void CCPipeFileStopThread (CCPipeFile *self)
+{
+    if (self->thread != NULL)
+    {
+        if (self->mode == ccpReadAhead)
+            CCPipeFileSetFlag (self, &self->stop);
+        else
+        {
+            CCPipeFileFlush (self);
+            CCPipeFileSetFlag (self, &self->done);
+        }
+        KThreadWait (self->thread, NULL);
+        KThreadRelease (self->thread);
+        self->thread = NULL;
+    }
+    self->direct = true;
+}
+
+/* ccpWriteBehind: wait until everything handed over is written */
+static
+rc_t CCPipeFileDrain (CCPipeFile *self)
+{
+    rc_t rc;
+
+    CCPipeFileFlush (self);
+    KLockAcquire (self->lock);
+    while (self->count > 0)
+        KConditionWait (self->cond, self->lock);
+    rc = self->rc;
+    KLockUnlock (self->lock);
+    return rc;
+}
+
+
+/* ----------------------------------------------------------------------
+ * Destroy
+ */
+static
+rc_t CCPipeFileWhack (CCPipeFile *self)
+{
+    rc_t rc = 0;
+    uint32_t ix;
+
+    CCPipeFileStopThread (self);
+
+    if (self->mode == ccpWriteBehind)
+        rc = self->rc;
+
+    if (self->original != NULL)
+    {
+        rc_t orc = KFileRelease (self->original);
+        if (rc == 0)
+            rc = orc;
+    }
+    for (ix = 0; ix < CCPIPE_BUFFERS; ++ix)
+        free (self->ring [ix].data);
+    KConditionRelease (self->cond);
+    KLockRelease (self->lock);
+    free (self);
+    return rc;
+}
+
+static
+rc_t CC CCPipeFileDestroy (CCPipeFile *self)
+{
+    return CCPipeFileWhack (self);
+}
+
+/* ----------------------------------------------------------------------
+ * GetSysFile
+ *  the bytes have to go through the pipe, no memory mapping
+ */
+static
+struct KSysFile *CC CCPipeFileGetSysFile (const CCPipeFile *self, uint64_t *offset)
+{
+    *offset = 0;
+    return NULL;
+}
+
+/* ----------------------------------------------------------------------
+ * RandomAccess
+ *  a read-ahead is sequential
+ */
+static
+rc_t CC CCPipeFileRandomAccess (const CCPipeFile *self)
+{
+    if (self->mode == ccpReadAhead)
+        return RC (rcExe, rcFile, rcAccessing, rcFunction, rcUnsupported);
+    return KFileRandomAccess (self->original);
+}
+
+static
+uint32_t CC CCPipeFileType (const CCPipeFile *self)
+{
+    return KFileType (self->original);
+}
+
+/* ----------------------------------------------------------------------
+ * Size
+ *  the original is in use by the thread: a read-ahead knows its size
+ *  only after the end was reached, a write-behind has to be drained first
+ */
+static
+rc_t CC CCPipeFileSize (const CCPipeFile *cself, uint64_t *size)
+{
+    CCPipeFile * self = (CCPipeFile*)cself;
+    rc_t rc = 0;
+
+    switch (self->mode)
+    {
+    case ccpReadAhead:
+        if (! self->direct)
+        {
+            bool done;
+
+            KLockAcquire (self->lock);
+            done = self->done;
+            *size = self->ahead;
+            KLockUnlock (self->lock);
+            return done ? 0 : RC (rcExe, rcFile, rcAccessing, rcSize, rcUnknown);
+        }
+        break;
+    case ccpWriteBehind:
+        rc = CCPipeFileDrain (self);
+        break;
+    default:
+        break;
+    }
+    if (rc == 0)
+        rc = KFileSize (self->original, size);
+    return rc;
+}
+
+static
+rc_t CC CCPipeFileSetSize (CCPipeFile *self, uint64_t size)
+{
+    rc_t rc;
+
+    if (self->mode != ccpWriteBehind)
+        return RC (rcExe, rcFile, rcUpdating, rcFunction, rcUnsupported);
+
+    rc = CCPipeFileDrain (self);
+    if (rc == 0)
+        rc = KFileSetSize (self->original, size);
+    return rc;
+}
+
+/* ----------------------------------------------------------------------
+ * Read
+ */
+/* ccpMD5Read: a read beyond what was hashed hashes the gap first */
+static
+rc_t CCPipeFileCatchUp (CCPipeFile *self, uint64_t pos)
+{
+    rc_t rc = 0;
+    char gap [32 * 1024];
+
+    while (rc == 0 && self->hashed < pos)
+    {
+        size_t num_read;
+        size_t to_read = sizeof gap;
+
+        if (pos - self->hashed < to_read)
+            to_read = (size_t)(pos - self->hashed);
+
+        rc = KFileRead (self->original, self->hashed, gap, to_read, &num_read);
+        if (rc == 0)
+        {
+            if (num_read == 0)
+                break;
+            rc = CCPipeFileSubmit (self, self->hashed, gap, num_read);
+            if (rc == 0)
+                self->hashed += num_read;
+        }
+    }
+    return rc;
+}
+
+static
+rc_t CCPipeFileReadMD5 (CCPipeFile *self, uint64_t pos,
+                        void *buffer, size_t bsize, size_t *num_read)
+{
+    rc_t rc = 0;
+
+    /* the digest is final, nothing more is hashed */
+    if (self->finished)
+        return KFileRead (self->original, pos, buffer, bsize, num_read);
+
+    if (pos > self->hashed)
+        rc = CCPipeFileCatchUp (self, pos);
+    if (rc == 0)
+    {
+        rc = KFileRead (self->original, pos, buffer, bsize, num_read);
+
+        /* bytes before "hashed" were seen already */
+        if (rc == 0 && pos <= self->hashed && pos + *num_read > self->hashed)
+        {
+            size_t skip = (size_t)(self->hashed - pos);
+            size_t n = *num_read - skip;
+
+            rc = CCPipeFileSubmit (self, self->hashed, (const char*)buffer + skip, n);
+            if (rc == 0)
+                self->hashed += n;
+        }
+    }
+    return rc;
+}
+
+/* ccpReadAhead: serve from the buffers as long as the reads go forward */
+static
+rc_t CCPipeFileReadAhead (CCPipeFile *self, uint64_t pos,
+                          void *buffer, size_t bsize, size_t *num_read)
+{
+    *num_read = 0;
+
+    while (! self->direct)
+    {
+        CCPipeBuf * buf = CCPipeFileGetFilled (self);
+        if (buf == NULL)
+        {
+            /* the thread is done and everything was taken */
+            if (pos >= self->ahead)
+                return 0;
+            break;
+        }
+        if (pos < buf->pos)
+            break;
+        if (pos < buf->pos + buf->size)
+        {
+            size_t n = (size_t)(buf->pos + buf->size - pos);
+            if (n > bsize)
+                n = bsize;
+            memmove (buffer, buf->data + (pos - buf->pos), n);
+            *num_read = n;
+            return 0;
+        }
+        if (buf->rc != 0)
+            return buf->rc;
+        /* a short buffer is the last one */
+        if (buf->size < CCPIPE_BUFSIZE)
+            return 0;
+        CCPipeFilePutEmpty (self);
+    }
+
+    /* a read behind what is buffered: stop reading ahead,
+       the original is read directly from now on */
+    CCPipeFileStopThread (self);
+    return KFileRead (self->original, pos, buffer, bsize, num_read);
+}
+
+static
+rc_t CC CCPipeFileRead (const CCPipeFile *cself, uint64_t pos,
+                        void *buffer, size_t bsize, size_t *num_read)
+{
+    CCPipeFile * self = (CCPipeFile*)cself;
+
+    switch (self->mode)
+    {
+    case ccpMD5Read:
+        return CCPipeFileReadMD5 (self, pos, buffer, bsize, num_read);
+    case ccpReadAhead:
+        return CCPipeFileReadAhead (self, pos, buffer, bsize, num_read);
+    default:
+        return RC (rcExe, rcFile, rcReading, rcFunction, rcUnsupported);
+    }
+}
+
+/* ----------------------------------------------------------------------
+ * Write
+ *  an error of the thread shows up with a later write or the release
+ */
+static
+rc_t CC CCPipeFileWrite (CCPipeFile *self, uint64_t pos,
+                         const void *buffer, size_t bsize, size_t *num_writ)
+{
+    rc_t rc;
+
+    *num_writ = 0;
+    if (self->mode != ccpWriteBehind)
+        return RC (rcExe, rcFile, rcWriting, rcFunction, rcUnsupported);
+
+    KLockAcquire (self->lock);
+    rc = self->rc;
+    KLockUnlock (self->lock);
+
+    if (rc == 0)
+        rc = CCPipeFileSubmit (self, pos, buffer, bsize);
+    if (rc == 0)
+        *num_writ = bsize;
+    return rc;
+}
+
+static const KFile_vt_v1 vtCCPipeFile =
+{
+    /* version */
+    1, 1,
+
+    /* 1.0 */
+    CCPipeFileDestroy,
+    CCPipeFileGetSysFile,
+    CCPipeFileRandomAccess,
+    CCPipeFileSize,
+    CCPipeFileSetSize,
+    CCPipeFileRead,
+    CCPipeFileWrite,
+
+    /* 1.1 */
+    CCPipeFileType
+};
+
+/* ----------------------------------------------------------------------
+ * CCPipeFileMake
+ *  create a new file object and start its thread
+ */
+static
+rc_t CCPipeFileMake (CCPipeFile ** pself, KFile * original, CCPipeMode mode)
+{
+    CCPipeFile * self;
+    rc_t rc;
+    uint32_t ix;
+
+    assert (pself);
+    assert (original);
+
+    *pself = NULL;
+    self = calloc (1, sizeof *self);
+    if (self == NULL)
+        return RC (rcExe, rcFile, rcConstructing, rcMemory, rcExhausted);
+
+    rc = KFileInit (&self->dad,
+                    (const KFile_vt*)&vtCCPipeFile,
+                    "CCPipeFile", "no-name",
+                    mode != ccpWriteBehind,
+                    mode == ccpWriteBehind);
+    for (ix = 0; rc == 0 && ix < CCPIPE_BUFFERS; ++ix)
+    {
+        self->ring [ix].data = malloc (CCPIPE_BUFSIZE);
+        if (self->ring [ix].data == NULL)
+            rc = RC (rcExe, rcFile, rcConstructing, rcMemory, rcExhausted);
+    }
+    if (rc == 0)
+        rc = KLockMake (&self->lock);
+    if (rc == 0)
+        rc = KConditionMake (&self->cond);
+    if (rc == 0)
+    {
+        self->mode = mode;
+        MD5StateInit (&self->md5);
+        rc = KFileAddRef (original);
+        if (rc == 0)
+            self->original = original;
+    }
+    if (rc == 0)
+        rc = KThreadMake (&self->thread,
+                          mode == ccpReadAhead ? CCPipeFileReader : CCPipeFileConsumer,
+                          self);
+    if (rc == 0)
+    {
+        *pself = self;
+        return 0;
+    }
+    LOGERR (klogInt, rc, "failed to create pipe file");
+    CCPipeFileWhack (self);
+    return rc;
+}
+
+LIB_EXPORT rc_t CC CCPipeFileMakeMD5Read (const KFile ** self, const KFile * original)
+{
+    return CCPipeFileMake ((CCPipeFile **)self, (KFile*)original, ccpMD5Read);
+}
+
+LIB_EXPORT rc_t CC CCPipeFileMD5Digest (const KFile * self, uint8_t digest [16])
+{
+    CCPipeFile * pipe = (CCPipeFile*)self;
+
+    if (self == NULL || digest == NULL)
+        return RC (rcExe, rcFile, rcAccessing, rcParam, rcNull);
+    if (self->vt != (const KFile_vt*)&vtCCPipeFile || pipe->mode != ccpMD5Read)
+        return RC (rcExe, rcFile, rcAccessing, rcType, rcIncorrect);
+
+    if (! pipe->finished)
+    {
+        /* join the thread: everything handed over is hashed */
+        CCPipeFileStopThread (pipe);
+        MD5StateFinish (&pipe->md5, pipe->digest);
+        pipe->finished = true;
+    }
+    memmove (digest, pipe->digest, sizeof pipe->digest);
+    return 0;
+}
+
+LIB_EXPORT rc_t CC CCPipeFileMakeReadAhead (const KFile ** self, const KFile * original)
+{
+    return CCPipeFileMake ((CCPipeFile **)self, (KFile*)original, ccpReadAhead);
+}
+
+LIB_EXPORT rc_t CC CCPipeFileMakeWriteBehind (KFile ** self, KFile * original)
+{
+    return CCPipeFileMake ((CCPipeFile **)self, original, ccpWriteBehind);
+}
+
+/* end of file ccpipe.c */
@@ -63,6 +63,7 @@ extern bool xml_dir;            /* if set we will output XML to match our extrac
                                  * the original packed submission */
 extern bool no_bzip2;           /* if true, don't try to decompress bzipped files */
 extern bool no_md5;             /* if true, don't calculate md5 sums */
+extern bool no_threads;         /* if true, hash, decompress and write on the main thread */
 extern char epath [8192];       /* we build a path down through containes/archives */
 extern char * ehere;            /* the pointer to the next character in epath during descent */
 extern KCreateMode cm;          
@@ -230,6 +231,33 @@ rc_t CC CCFileMakeUpdate (struct KFile ** self,
 rc_t CC CCFileMakeWrite (struct KFile ** self,
                          struct KFile * original, rc_t * prc);
 
+/* CCPipeFile
+ *  wrappers that run a stage of the chain on a thread of their own
+ *
+ *  MakeMD5Read: hashes what is read behind the reader
+ *
+ *  MD5Digest: waits for the hashing thread to catch up with the reads
+ *  and returns the MD5 of everything read so far; the file is not hashed
+ *  any further after that
+ *
+ *  MakeReadAhead: reads "original" sequentially ahead of the reader,
+ *  a read behind the buffered data reads "original" directly from then on
+ *
+ *  MakeWriteBehind: writes "original" behind the writer,
+ *  a write error is returned by a later write or by the release
+ */
+rc_t CC CCPipeFileMakeMD5Read (const struct KFile ** self,
+                               const struct KFile * original);
+rc_t CC CCPipeFileMD5Digest (const struct KFile * self, uint8_t digest [16]);
+rc_t CC CCPipeFileMakeReadAhead (const struct KFile ** self,
+                                 const struct KFile * original);
+rc_t CC CCPipeFileMakeWriteBehind (struct KFile ** self,
+                                   struct KFile * original);
+
+/* a pipe costs a thread and its buffers,
+   files smaller than this are handled on the calling thread */
+#define CCPIPE_MIN_SIZE ( 4 * 1024 * 1024 )
+
 #ifdef __cplusplus
 }
 #endif
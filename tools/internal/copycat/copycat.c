@@ -78,6 +78,7 @@ bool xml_dir = false;
 bool extract_dir = false;
 bool no_bzip2 = false;
 bool no_md5 = false;
+bool no_threads = false;
 void * dump_out;
 const char * xml_base = NULL;
 
@@ -208,6 +209,7 @@ KCreateMode cm = kcmParents | kcmCreate;
 #define OPTION_OUTBLOCK "output-buffer"
 #define OPTION_NOBZIP2 "no-bzip2"
 #define OPTION_NOMD5   "no-md5"
+#define OPTION_NOTHREADS "no-threads"
 
 #define ALIAS_CACHE   "x"
 #define ALIAS_FORCE   "f"
@@ -222,6 +224,7 @@ KCreateMode cm = kcmParents | kcmCreate;
 #define ALIAS_OUTBLOCK ""
 #define ALIAS_NOBZIP2 ""
 #define ALIAS_NOMD5   ""
+#define ALIAS_NOTHREADS ""
 
 
 
@@ -257,6 +260,9 @@ const char * no_bzip2_usage[] =
 { "do not decompress files compressed with bzip2", NULL };
 const char * no_md5_usage[] = 
 { "do not calculate md5 hashes", NULL };
+static
+const char * no_threads_usage[] = 
+{ "hash, decompress and write on a single thread", NULL };
 
 
 const char UsageDefaultName [] = "copycat";
@@ -299,6 +305,7 @@ rc_t CC Usage (const Args * args)
     HelpOptionLine (ALIAS_OUTBLOCK,OPTION_OUTBLOCK, "size-in-KB", outblock_usage);
     HelpOptionLine (ALIAS_NOBZIP2,OPTION_NOBZIP2, NULL, no_bzip2_usage);
     HelpOptionLine (ALIAS_NOMD5,OPTION_NOMD5, NULL, no_md5_usage);
+    HelpOptionLine (ALIAS_NOTHREADS,OPTION_NOTHREADS, NULL, no_threads_usage);
     HelpOptionsStandard ();
 
 
@@ -411,7 +418,8 @@ OptDef Options[] =
     { OPTION_INBLOCK, ALIAS_OUTBLOCK,NULL, inblock_usage, 1, true,  false },
     { OPTION_OUTBLOCK,ALIAS_OUTBLOCK,NULL, outblock_usage,1, true,  false },
     { OPTION_NOBZIP2, ALIAS_NOBZIP2, NULL, no_bzip2_usage,0, false, false },
-    { OPTION_NOMD5,   ALIAS_NOMD5,   NULL, no_md5_usage,  0, false, false }
+    { OPTION_NOMD5,   ALIAS_NOMD5,   NULL, no_md5_usage,  0, false, false },
+    { OPTION_NOTHREADS, ALIAS_NOTHREADS, NULL, no_threads_usage, 0, false, false }
 };
 
 /* file2file
@@ -1081,6 +1089,12 @@ rc_t KMain ( int argc, char *argv [] )
                 no_md5 = true;
             }
 
+            rc = ArgsOptionCount ( args, OPTION_NOTHREADS, & pcount );
+            if ( pcount > 0 )
+            {
+                no_threads = true;
+            }
+
             /* all parameters plus the possible dest option parameter */
             rc = ArgsParamCount (args, &pcount);
             if (rc)
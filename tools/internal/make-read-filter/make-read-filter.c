@@ -38,6 +38,7 @@
 enum OPTIONS {
     OPT_OUTPUT,     /* temp path */
     OPT_CACHE,      /* vdbcache path */
+    OPT_THREADS,    /* number of worker threads */
     OPTIONS_COUNT
 };
 
@@ -56,73 +57,112 @@ typedef enum FilterReason {
     original_filter = 8,
 } FilterReason;
 
-/** @brief Apply the rules to determine if a read should be filtered
+/** @brief Count the quality values < 20
+ ** @note Works on eight values at a time
  **/
-static FilterReason shouldFilter(uint32_t const len, uint8_t const *const qual)
+static uint32_t countUnder(uint32_t const len, uint8_t const *const qual)
 {
+    uint64_t const ones = 0x0101010101010101ull;
+    uint64_t const highs = 0x8080808080808080ull;
     uint32_t under = 0;
-    uint32_t lastgood = len;
+    uint32_t i = 0;
+
+    for ( ; i + 8 <= len; i += 8) {
+        uint64_t x;
+        memcpy(&x, qual + i, 8);
+        {
+            /* high bit of each byte of t is set iff (byte & 0x7F) >= 20;
+             * no borrows can cross bytes since each byte is >= 0x80 */
+            uint64_t const t = (x | highs) - 20 * ones;
+            uint64_t const m = ~(t | x) & highs;
+            under += (uint32_t)(((m >> 7) * ones) >> 56);
+        }
+    }
+    for ( ; i < len; ++i)
+        under += qual[i] < 20 ? 1 : 0;
+    return under;
+}
+
+static bool allUnder(uint32_t const len, uint8_t const *const qual)
+{
     uint32_t i;
-    FilterReason reason = keep;
-    
     for (i = 0; i < len; ++i) {
-        int const qval = qual[i];
-        if (qval < 20)
-            ++under;
-        else
-            lastgood = i; /* last good value */
+        if (qual[i] >= 20)
+            return false;
     }
+    return true;
+}
+
+/** @brief Apply the rules to determine if a read should be filtered
+ **/
+static FilterReason shouldFilter(uint32_t const len, uint8_t const *const qual)
+{
+    uint32_t const under = countUnder(len, qual);
+    FilterReason reason = keep;
+
     if (under * 2 > len)
         reason |= low_quality_count;
     if (len <= 10) /* if length <= 10, then rest of rules can't apply */
         return reason;
-    
-    if (lastgood < len - 11)
+
+    /* last 11 values are < 20 and there is at least one good value */
+    if (under < len && allUnder(11, qual + len - 11))
         reason |= low_quality_back;
 
-    for (i = 0; i < len; ++i) {
-        int const qval = qual[i];
-        if (qval >= 20)
-            break;
-        if (i == 10) {
-            reason |= low_quality_front;
-            break;
-        }
-    }
+    /* first 11 values are < 20 */
+    if (allUnder(11, qual))
+        reason |= low_quality_front;
+
     return reason;
 }
 
+typedef struct Dispositions {
+    uint64_t count[6];
+    uint64_t bases[6];
+} Dispositions;
+
 uint64_t dispositionCount[6];
 uint64_t dispositionBaseCount[6];
-static void updateCounts(FilterReason const reason, uint32_t const length)
+static void updateCounts(Dispositions *const disp, FilterReason const reason, uint32_t const length)
 {
     if (reason == keep) {
-        dispositionCount[0] += 1;
-        dispositionBaseCount[0] += length;
+        disp->count[0] += 1;
+        disp->bases[0] += length;
     }
     else {
-        dispositionCount[1] += 1;
-        dispositionBaseCount[1] += length;
+        disp->count[1] += 1;
+        disp->bases[1] += length;
     }
     if ((reason & original_filter) != 0) {
-        dispositionCount[2] += 1;
-        dispositionBaseCount[2] += length;
+        disp->count[2] += 1;
+        disp->bases[2] += length;
     }
     if ((reason & low_quality_count) != 0) {
-        dispositionCount[3] += 1;
-        dispositionBaseCount[3] += length;
+        disp->count[3] += 1;
+        disp->bases[3] += length;
     }
     if ((reason & low_quality_front) != 0) {
-        dispositionCount[4] += 1;
-        dispositionBaseCount[4] += length;
+        disp->count[4] += 1;
+        disp->bases[4] += length;
     }
     if ((reason & low_quality_back) != 0) {
-        dispositionCount[5] += 1;
-        dispositionBaseCount[5] += length;
+        disp->count[5] += 1;
+        disp->bases[5] += length;
     }
 }
 
+static void mergeCounts(Dispositions *const disp)
+{
+    int i;
+    for (i = 0; i < 6; ++i) {
+        dispositionCount[i] += disp->count[i];
+        dispositionBaseCount[i] += disp->bases[i];
+    }
+    memset(disp, 0, sizeof(*disp));
+}
+
 static void computeReadFilter(uint8_t *const out_filter
+                             , Dispositions *const disp
                              , CellData const *const filterData
                              , CellData const *const typeData
                              , CellData const *const startData
@@ -159,7 +199,7 @@ static void computeReadFilter(uint8_t *const out_filter
                 if (reason != keep)
                     filt = SRA_READ_FILTER_REJECT;
             }
-            updateCounts(reason, len[i]);
+            updateCounts(disp, reason, len[i]);
         }
         out_filter[i] = filt;
     }
@@ -176,89 +216,295 @@ static bool didReadFilterChange(unsigned const n, uint8_t const *const out, uint
     return false;
 }
 
-int invalidated = -1;
-#include <fcntl.h>
-static void open_invalidated()
+/* MARK: changed rows */
+
+/* Set of PRIMARY_ALIGNMENT rows whose READ_FILTER changed.
+ * Row ids are split into pages of ROWS_PER_PAGE bits; pages are only
+ * allocated once a row in them is set, so sparse sets stay small.
+ */
+#define ROWS_PER_PAGE (1u << 16)
+#define WORDS_PER_PAGE (ROWS_PER_PAGE / 64)
+
+typedef struct RowBitmap {
+    uint64_t **page;
+    size_t pages;
+    uint64_t count;
+} RowBitmap;
+
+RowBitmap invalidated;
+
+static void rowBitmapSet(RowBitmap *const self, int64_t const row)
+{
+    uint64_t const bit = (uint64_t)row;
+    size_t const p = (size_t)(bit / ROWS_PER_PAGE);
+    uint32_t const i = (uint32_t)(bit % ROWS_PER_PAGE);
+    uint64_t *page;
+
+    assert(row >= 0);
+    if (p >= self->pages) {
+        size_t const pages = (p + 1) * 2;
+        void *const temp = realloc(self->page, pages * sizeof(self->page[0]));
+        if (temp == NULL)
+            OUT_OF_MEMORY();
+        self->page = temp;
+        memset(self->page + self->pages, 0, (pages - self->pages) * sizeof(self->page[0]));
+        self->pages = pages;
+    }
+    page = self->page[p];
+    if (page == NULL) {
+        page = self->page[p] = calloc(WORDS_PER_PAGE, sizeof(page[0]));
+        if (page == NULL)
+            OUT_OF_MEMORY();
+    }
+    if ((page[i / 64] & (1ull << (i % 64))) == 0) {
+        page[i / 64] |= 1ull << (i % 64);
+        self->count += 1;
+    }
+}
+
+static bool rowBitmapTest(RowBitmap const *const self, int64_t const row)
 {
-    invalidated = open("invalidedRows", O_RDWR | O_APPEND | O_CREAT | O_EXCL, 0700);
-    if (invalidated >= 0)
-        return;
-    LogMsg(klogFatal, "Can't create file for invalidated rows");
-    exit(EX_CANTCREAT);
+    uint64_t const bit = (uint64_t)row;
+    size_t const p = (size_t)(bit / ROWS_PER_PAGE);
+    uint32_t const i = (uint32_t)(bit % ROWS_PER_PAGE);
+
+    if (row < 0 || p >= self->pages || self->page[p] == NULL)
+        return false;
+    return (self->page[p][i / 64] & (1ull << (i % 64))) != 0;
 }
 
-static void invalidateRow(int64_t const row)
+static void rowBitmapWhack(RowBitmap *const self)
 {
-    if (invalidated >= 0) {
-        if (write(invalidated, &row, sizeof(row)) == sizeof(row))
-            return;
-        LogMsg(klogFatal, "Can't record invalidated rows");
-        exit(EX_IOERR);
+    size_t i;
+    for (i = 0; i < self->pages; ++i)
+        free(self->page[i]);
+    free(self->page);
+    memset(self, 0, sizeof(*self));
+}
+
+/* MARK: partitioned processing */
+
+/* Rows are processed in rounds; in each round every worker computes the
+ * new READ_FILTER for its own consecutive chunk of rows, while the main
+ * thread writes out the chunks of the previous round in row order.
+ */
+#define ROWS_PER_CHUNK (64 * 1024)
+#define DEFAULT_THREADS 4
+#define MAX_THREADS 64
+
+typedef struct Chunk {
+    int64_t first;
+    uint64_t count;
+    uint32_t *nreads;       /* per row */
+    uint8_t *filter;        /* all rows, concatenated */
+    size_t filter_count;
+    size_t filter_max;
+    int64_t *changed;       /* PRIMARY_ALIGNMENT_IDs of changed rows */
+    size_t changed_count;
+    size_t changed_max;
+    Dispositions disp;
+} Chunk;
+
+typedef struct Worker {
+    VCursor const *in;
+    uint32_t cid_pr_id;
+    uint32_t cid_read_filter;
+    uint32_t cid_readstart;
+    uint32_t cid_read_type;
+    uint32_t cid_readlen;
+    uint32_t cid_qual;
+    bool haveCache;
+    KThread *thread;
+    Chunk *current;
+    Chunk chunk[2];
+} Worker;
+
+static void *growBuffer(void *buffer, size_t *const max, size_t const needed, size_t const elem_size)
+{
+    if (*max < needed) {
+        size_t newMax = *max ? *max : 1024;
+        while (newMax < needed)
+            newMax *= 2;
+        buffer = realloc(buffer, newMax * elem_size);
+        if (buffer == NULL)
+            OUT_OF_MEMORY();
+        *max = newMax;
     }
-    open_invalidated();
-    invalidateRow(row);
+    return buffer;
 }
 
-static void processCursors(VCursor *const out, VCursor const *const in, bool const haveCache)
+static void processChunk(Worker const *const self, Chunk *const chunk)
 {
-    /* MARK: input columns */
-    uint32_t const cid_pr_id       = haveCache ? addColumn("PRIMARY_ALIGNMENT_ID", "I64" , in) : 0;
-    uint32_t const cid_read_filter = addColumn("READ_FILTER", "U8" , in);
-    uint32_t const cid_readstart   = addColumn("READ_START" , "I32", in);
-    uint32_t const cid_read_type   = addColumn("READ_TYPE"  , "U8" , in);
-    uint32_t const cid_readlen     = addColumn("READ_LEN"   , "U32", in);
-    uint32_t const cid_qual        = addColumn("QUALITY"    , "U8" , in);
+    uint64_t r;
+
+    chunk->filter_count = 0;
+    chunk->changed_count = 0;
+    for (r = 0; r < chunk->count; ++r) {
+        int64_t const row = chunk->first + r;
+        CellData const readfilter = cellData("READ_FILTER", self->cid_read_filter, row, self->in);
+        CellData const readstart  = cellData("READ_START" , self->cid_readstart  , row, self->in);
+        CellData const readtype   = cellData("READ_TYPE"  , self->cid_read_type  , row, self->in);
+        CellData const readlen    = cellData("READ_LEN"   , self->cid_readlen    , row, self->in);
+        CellData const quality    = cellData("QUALITY"    , self->cid_qual       , row, self->in);
+        uint8_t *out_filter;
+
+        chunk->filter = growBuffer(chunk->filter, &chunk->filter_max, chunk->filter_count + readfilter.count, sizeof(chunk->filter[0]));
+        out_filter = chunk->filter + chunk->filter_count;
+        chunk->filter_count += readfilter.count;
+        chunk->nreads[r] = readfilter.count;
+
+        computeReadFilter(out_filter, &chunk->disp, &readfilter, &readtype, &readstart, &readlen, &quality, row);
+        if (self->haveCache && didReadFilterChange(readfilter.count, out_filter, readfilter.data)) {
+            CellData const pridData = cellData("PRIMARY_ALIGNMENT_ID", self->cid_pr_id, row, self->in);
+
+            chunk->changed = growBuffer(chunk->changed, &chunk->changed_max, chunk->changed_count + pridData.count, sizeof(chunk->changed[0]));
+            memmove(chunk->changed + chunk->changed_count, pridData.data, pridData.count * sizeof(chunk->changed[0]));
+            chunk->changed_count += pridData.count;
+        }
+    }
+}
+
+static rc_t CC processChunkThread(KThread const *const self, void *const data)
+{
+    Worker const *const worker = data;
+    processChunk(worker, worker->current);
+    UNUSED(self);
+    return 0;
+}
+
+/** @brief Assign the next chunk of rows to each worker and start them
+ ** @return the number of workers started
+ **/
+static unsigned startRound(Worker *const worker, unsigned const threads, int const which, int64_t *const next, int64_t const end)
+{
+    unsigned i;
+
+    for (i = 0; i < threads && *next < end; ++i) {
+        Chunk *const chunk = &worker[i].chunk[which];
+
+        chunk->first = *next;
+        chunk->count = end - *next < ROWS_PER_CHUNK ? end - *next : ROWS_PER_CHUNK;
+        *next += chunk->count;
+        worker[i].current = chunk;
+        if (threads == 1)
+            processChunk(&worker[i], chunk);
+        else {
+            rc_t const rc = KThreadMake(&worker[i].thread, processChunkThread, &worker[i]);
+            if (rc) {
+                LogErr(klogFatal, rc, "Failed to start worker thread");
+                exit(EX_OSERR);
+            }
+        }
+    }
+    return i;
+}
+
+static void waitRound(Worker *const worker, unsigned const started)
+{
+    unsigned i;
+
+    for (i = 0; i < started; ++i) {
+        if (worker[i].thread) {
+            rc_t rc_thread = 0;
+            rc_t const rc = KThreadWait(worker[i].thread, &rc_thread);
+            KThreadRelease(worker[i].thread);
+            worker[i].thread = NULL;
+            if (rc || rc_thread) {
+                LogErr(klogFatal, rc ? rc : rc_thread, "Worker thread failed");
+                exit(EX_SOFTWARE);
+            }
+        }
+    }
+}
+
+static void writeChunk(Chunk *const chunk, uint32_t const cid, VCursor *const out)
+{
+    uint8_t const *out_filter = chunk->filter;
+    uint64_t r;
+    size_t i;
 
+    for (r = 0; r < chunk->count; ++r) {
+        int64_t const row = chunk->first + r;
+        uint32_t const nreads = chunk->nreads[r];
+
+        openRow(row, out);
+        writeRow(row, nreads, out_filter, cid, out);
+        commitRow(row, out);
+        closeRow(row, out);
+        out_filter += nreads;
+    }
+    for (i = 0; i < chunk->changed_count; ++i)
+        rowBitmapSet(&invalidated, chunk->changed[i]);
+    mergeCounts(&chunk->disp);
+}
+
+static void processCursors(VCursor *const out, unsigned const threads, VCursor const *const *const in, bool const haveCache)
+{
     /* MARK: output column */
     uint32_t const cid_rd_filter = addColumn("READ_FILTER", "U8", out);
 
+    Worker *const worker = calloc(threads, sizeof(worker[0]));
     int64_t first = 0;
     uint64_t count = 0;
+    int64_t next = 0;
+    int which = 0;
+    unsigned started = 0;
+    unsigned i;
 
-    uint64_t r = 0;
-    size_t out_filter_count = 0;
-    uint8_t *out_filter = NULL;
+    if (worker == NULL)
+        OUT_OF_MEMORY();
 
-    openCursor(in, "input");    
+    /* MARK: input columns */
+    for (i = 0; i < threads; ++i) {
+        Worker *const w = &worker[i];
+        int j;
+
+        w->in = in[i];
+        w->haveCache = haveCache;
+        w->cid_pr_id       = haveCache ? addColumn("PRIMARY_ALIGNMENT_ID", "I64" , w->in) : 0;
+        w->cid_read_filter = addColumn("READ_FILTER", "U8" , w->in);
+        w->cid_readstart   = addColumn("READ_START" , "I32", w->in);
+        w->cid_read_type   = addColumn("READ_TYPE"  , "U8" , w->in);
+        w->cid_readlen     = addColumn("READ_LEN"   , "U32", w->in);
+        w->cid_qual        = addColumn("QUALITY"    , "U8" , w->in);
+        openCursor(w->in, "input");
+        for (j = 0; j < 2; ++j) {
+            w->chunk[j].nreads = malloc(ROWS_PER_CHUNK * sizeof(w->chunk[j].nreads[0]));
+            if (w->chunk[j].nreads == NULL)
+                OUT_OF_MEMORY();
+        }
+    }
     openCursor(out, "output");
     
-    count = rowCount(in, &first, cid_qual);
+    count = rowCount(worker[0].in, &first, worker[0].cid_qual);
     assert(first == 1);
-    pLogMsg(klogInfo, "progress: about to process $(rows) rows", "rows=%lu", count);
+    pLogMsg(klogInfo, "progress: about to process $(rows) rows using $(threads) threads", "rows=%lu,threads=%u", count, threads);
 
     /* MARK: Main loop over the input */
-    for (r = 0; r < count; ++r) {
-        int64_t const row = 1 + r;
-        CellData const readfilter = cellData("READ_FILTER", cid_read_filter, row, in);
-        CellData const readstart  = cellData("READ_START" , cid_readstart  , row, in);
-        CellData const readtype   = cellData("READ_TYPE"  , cid_read_type  , row, in);
-        CellData const readlen    = cellData("READ_LEN"   , cid_readlen    , row, in);
-        CellData const quality    = cellData("QUALITY"    , cid_qual       , row, in);
-#if 0
-        if ((row & 0xFFFF) == 0) {
-            pLogMsg(klogInfo, "progress: $(row) rows", "row=%li", row);
-        }
-#endif
-        out_filter = growFilterBuffer(out_filter, &out_filter_count, readfilter.count);
-        computeReadFilter(out_filter, &readfilter, &readtype, &readstart, &readlen, &quality, row);
-        if (haveCache && didReadFilterChange(readfilter.count, out_filter, readfilter.data)) {
-            CellData const pridData = cellData("PRIMARY_ALIGNMENT_ID", cid_pr_id, row, in);
-            int64_t const *prid = pridData.data;
-            size_t i;
-            for (i = 0; i < pridData.count; ++i) {
-                invalidateRow(prid[i]);
-            }
-        }
-        openRow(row, out);
-        writeRow(row, readfilter.count, out_filter, cid_rd_filter, out);
-        commitRow(row, out);
-        closeRow(row, out);
+    next = first;
+    started = startRound(worker, threads, which, &next, first + count);
+    while (started > 0) {
+        unsigned const finished = started;
+
+        waitRound(worker, finished);
+        started = startRound(worker, threads, !which, &next, first + count);
+        for (i = 0; i < finished; ++i)
+            writeChunk(&worker[i].chunk[which], cid_rd_filter, out);
+        which = !which;
     }
     LogMsg(klogInfo, "progress: done");
     commitCursor(out);
-    free(out_filter);
+    for (i = 0; i < threads; ++i) {
+        int j;
+        for (j = 0; j < 2; ++j) {
+            free(worker[i].chunk[j].nreads);
+            free(worker[i].chunk[j].filter);
+            free(worker[i].chunk[j].changed);
+        }
+        VCursorRelease(worker[i].in);
+    }
+    free(worker);
     VCursorRelease(out);
-    VCursorRelease(in);
 }
 
 static void copyColumn(char const *const column, char const *const table, char const *const source, char const *const dest, VDBManager *const mgr)
@@ -331,88 +577,98 @@ static void saveCounts(char const *const table, char const *const dest, VDBManag
     VTableRelease(tbl);
 }
 
-static void updateCacheColumn1(  char const *const type
-                               , char const *const name
-                               , VCursor *const out
+typedef struct CacheColumn {
+    char const *type;
+    char const *name;
+    bool always;        /* take every non-empty row from the input */
+    uint32_t cid_gate;
+    uint32_t cid_out;
+    uint32_t cid_in;
+    uint64_t invalidate;
+} CacheColumn;
+
+/** @brief Rewrite all of the cache columns in one pass over the vdbcache
+ **/
+static void updateCacheCursors(  VCursor *const out
                                , VCursor const *const in
                                , VCursor const *const gate
-                               , size_t const changedCount
-                               , int64_t const *const changedRows)
+                               , unsigned const columns
+                               , CacheColumn *const column
+                               , RowBitmap const *const changed)
 {
-    uint32_t const cid_gate = addColumn(name, type, gate);
-    uint32_t const cid_out = addColumn(name, type, out);
-    uint32_t const cid_in = addColumn2(strlen(name) - 6, name, type, in);
-
     int64_t first = 0;
     uint64_t count = 0;
     uint64_t r;
-    size_t i = 0;
+    unsigned i;
 
     uint64_t not_empty = 0;
-    uint64_t invalidate = 0;
 
+    for (i = 0; i < columns; ++i) {
+        CacheColumn *const col = &column[i];
+        col->cid_gate = addColumn(col->name, col->type, gate);
+        col->cid_out = addColumn(col->name, col->type, out);
+        col->cid_in = addColumn2(strlen(col->name) - 6, col->name, col->type, in);
+    }
     openCursor(in, "input");
     openCursor(out, "output");
     openCursor(gate, "vdbcache");
 
-    count = rowCount(gate, &first, cid_gate);
-    pLogMsg(klogInfo, "progress: about to process $(rows) rows for $(col)", "rows=%lu,col=%s", count, name);
+    count = rowCount(gate, &first, column[0].cid_gate);
+    pLogMsg(klogInfo, "progress: about to process $(rows) rows", "rows=%lu", count);
 
     for (r = 0; r < count; ++r) {
         int64_t const row = first + r;
-        CellData const gated = cellData(name, cid_gate, row, gate);
-        CellData data = gated;
-        if (gated.count > 0) {
-            bool invalidated = true;
-            if (changedRows) {
-                while (i < changedCount && changedRows[i] < row) {
-                    ++i;
-                }
-                if (i < changedCount && changedRows[i] == row) {
-                    invalidated = true;
-                    ++i;
-                }
-                else
-                    invalidated = false;
-            }
-            if (invalidated) {
-                CellData const orig = cellData(name, cid_in, row, in);
+        bool const isChanged = rowBitmapTest(changed, row);
+        bool anyNotEmpty = false;
 
-                assert(gated.count == orig.count);
-                data = orig;
-                ++invalidate;
-            }
-            ++not_empty;
-        }
-#if 0
-        if ((row & 0xFFFF) == 0) {
-            pLogMsg(klogInfo, "progress: $(row) rows for $(col)", "row=%li,col=%s", row, name);
-        }
-#endif
         if (row == first)
             setRow(first, out);
 
         openRow(row, out);
-        writeCell(row, &data, cid_out, out);
+        for (i = 0; i < columns; ++i) {
+            CacheColumn *const col = &column[i];
+            CellData const gated = cellData(col->name, col->cid_gate, row, gate);
+            CellData data = gated;
+
+            if (gated.count > 0) {
+                if (col->always || isChanged) {
+                    CellData const orig = cellData(col->name, col->cid_in, row, in);
+
+                    assert(gated.count == orig.count);
+                    data = orig;
+                    ++col->invalidate;
+                }
+                anyNotEmpty = true;
+            }
+            writeCell(row, &data, col->cid_out, out);
+        }
         commitRow(row, out);
         closeRow(row, out);
+        if (anyNotEmpty)
+            ++not_empty;
     }
-    pLogMsg(klogInfo, "column $(name); rows: $(rows); non-empty rows: $(notempty); updated rows: $(updated);", "name=%s,rows=%lu,notempty=%lu,updated=%lu", name, count, not_empty, invalidate);
-    pLogMsg(klogInfo, "progress: done with $(col)", "col=%s", name);
+    for (i = 0; i < columns; ++i) {
+        pLogMsg(klogInfo, "column $(name); rows: $(rows); non-empty rows: $(notempty); updated rows: $(updated);", "name=%s,rows=%lu,notempty=%lu,updated=%lu", column[i].name, count, not_empty, column[i].invalidate);
+    }
+    LogMsg(klogInfo, "progress: done with vdbcache");
     commitCursor(out);
     VCursorRelease(in);
     VCursorRelease(out);
     VCursorRelease(gate);
 }
 
-static void updateCacheColumn(  char const *const type
-                              , char const *const name
-                              , VTable *const outT
-                              , VTable const *const inT
-                              , VTable const *const gateT
-                              , size_t const changedCount
-                              , int64_t const *const changedRows)
+static void updateCacheTable(  VTable *const outT
+                             , VTable const *const inT
+                             , VTable const *const gateT
+                             , RowBitmap const *const changed)
 {
+    CacheColumn column[] = {
+        { "I32", "TEMPLATE_LEN_CACHE", true },
+        { "U8", "RD_FILTER_CACHE", false },
+        { "U32", "SAM_FLAGS_CACHE", false },
+    };
+    /* the READ_FILTER dependent columns only need rewriting if something changed */
+    unsigned const columns = changed->count > 0 ? 3 : 1;
     VCursor *out = NULL;
     VCursor const *in = NULL;
     VCursor const *gate = NULL;
@@ -437,32 +693,10 @@ static void updateCacheColumn(  char const *const type
             exit(EX_NOINPUT);
         }
     }
-    updateCacheColumn1(type, name, out, in, gate, changedCount, changedRows);
-}
-
-static void updateCacheTable(  VTable *const out
-                             , VTable const *const in
-                             , VTable const *const gate
-                             , size_t const changedCount
-                             , int64_t const *const changedRows)
-{
-    if (changedCount > 0) {
-        static char const *columns[] = {
-            "U8", "RD_FILTER_CACHE",
-            "U32", "SAM_FLAGS_CACHE",
-            NULL
-        };
-        char const *const *col;
-        for (col = columns; *col; ) {
-            char const *const type = *col++;
-            char const *const name = *col++;
-            updateCacheColumn(type, name, out, in, gate, changedCount, changedRows);
-        }
-    }
-    updateCacheColumn("I32", "TEMPLATE_LEN_CACHE", out, in, gate, 0, NULL);
-    VTableRelease(out);
-    VTableRelease(in);
-    VTableRelease(gate);
+    updateCacheCursors(out, in, gate, columns, column, changed);
+    VTableRelease(outT);
+    VTableRelease(inT);
+    VTableRelease(gateT);
 }
 
 /** length of a common prefix
@@ -492,7 +726,7 @@ static bool checkForActiveCache(char const *const cachePath, char const *const i
     return strcmp(cachePath + prefixLength, ".vdbcache") == 0;
 }
 
-static void updateCache2(char const *const cachePath, char const *const inPath, size_t const changedCount, int64_t const *const changedRows, VDBManager *const mgr)
+static void updateCache2(char const *const cachePath, char const *const inPath, RowBitmap const *const changed, VDBManager *const mgr)
 {
     VTable const *const in = dbOpenTable(inPath, "PRIMARY_ALIGNMENT", mgr, NULL, NULL);
     VSchema *const schema = makeSchema(mgr); // this schema will get a copy of the input's schema
@@ -501,8 +735,8 @@ static void updateCache2(char const *const cachePath, char const *const inPath,
     VDatabase *db = NULL;
     VTable *tbl = NULL;
 
-    if (changedCount)
-        pLogMsg(klogInfo, "Updating READ_FILTER changed $(count) rows, updating vdbcache", "count=%zu", changedCount);
+    if (changed->count)
+        pLogMsg(klogInfo, "Updating READ_FILTER changed $(count) rows, updating vdbcache", "count=%lu", changed->count);
     else
         LogMsg(klogInfo, "Updating vdbcache");
     {
@@ -524,44 +758,14 @@ static void updateCache2(char const *const cachePath, char const *const inPath,
     free((void *)schemaType);
     VSchemaRelease(schema);
 
-    updateCacheTable(tbl, in, gate, changedCount, changedRows);
-    if (changedCount > 0) {
+    updateCacheTable(tbl, in, gate, changed);
+    if (changed->count > 0) {
         copyColumn("RD_FILTER_CACHE", "PRIMARY_ALIGNMENT", TEMP_CACHE_OBJECT_NAME, cachePath, mgr);
         copyColumn("SAM_FLAGS_CACHE", "PRIMARY_ALIGNMENT", TEMP_CACHE_OBJECT_NAME, cachePath, mgr);
     }
     copyColumn("TEMPLATE_LEN_CACHE", "PRIMARY_ALIGNMENT", TEMP_CACHE_OBJECT_NAME, cachePath, mgr);
 }
 
-static int cmp_int64_t(void const *A, void const *B)
-{
-    int64_t const a = *(int64_t const *)A;
-    int64_t const b = *(int64_t const *)B;
-    return a < b ? -1 : b < a ? 1 : 0;
-}
-
-static void updateCache(char const *const cachePath, char const *const inPath, VDBManager *const mgr)
-{
-    if (invalidated < 0)
-        updateCache2(cachePath, inPath, 0, NULL, mgr);
-    else {
-        off_t const fsize = invalidated < 0 ? 0 : lseek(invalidated, 0, SEEK_END);
-        if (fsize % sizeof(int64_t) == 0) {
-            void *const map = mmap(NULL, fsize, PROT_READ|PROT_WRITE, MAP_PRIVATE, invalidated, 0);
-            close(invalidated);
-            if (map) {
-                qsort(map, fsize / sizeof(int64_t), sizeof(int64_t), cmp_int64_t);
-                updateCache2(cachePath, inPath, fsize / sizeof(int64_t), map, mgr);
-                munmap(map, fsize);
-                return;
-            }
-            LogMsg(klogFatal, "failed to map invalidated rows file");
-            exit(EX_IOERR);
-        }
-        LogMsg(klogFatal, "size of invalidated rows file is not a whole number of row IDs");
-        exit(EX_SOFTWARE);
-    }
-}
-
 static char const *temporaryDirectory(Args *const args);
 static char const *absolutePath(char const *const path, char const *const wd);
 
@@ -585,14 +789,12 @@ void main_1(int argc, char *argv[])
         if (isActiveCache) {
             pLogMsg(klogWarn, "vdbcache should NOT be named $(inpath).vdbcache; rename it or put it in a different directory!!!", "inpath=%s", input);
         }
-        processTables(out, in, cachePath != NULL);
+        processTables(out, in, threadCount(args), cachePath != NULL);
         copyColumn("RD_FILTER", noDb ? NULL : "SEQUENCE", TEMP_MAIN_OBJECT_NAME, input, mgr);
         saveCounts(noDb ? NULL : "SEQUENCE", input, mgr);
-        if (cachePath) {
-            if (invalidated >= 0)
-                fsync(invalidated);
-            updateCache(cachePath, input, mgr);
-        }
+        if (cachePath)
+            updateCache2(cachePath, input, &invalidated, mgr);
+        rowBitmapWhack(&invalidated);
 
         VDBManagerRelease(mgr);
         ArgsWhack(args);
@@ -609,10 +811,11 @@ void main_1(int argc, char *argv[])
     exit(EX_TEMPFAIL);
 }
 
-static void processTables(VTable *const output, VTable const *const input, bool const haveCache)
+static void processTables(VTable *const output, VTable const *const input, unsigned const threads, bool const haveCache)
 {
     VCursor *out = NULL;
-    VCursor const *in = NULL;
+    VCursor const *in[MAX_THREADS];
+    unsigned i;
     {
         rc_t const rc = VTableCreateCursorWrite(output, &out, kcmInsert);
         if (rc != 0) {
@@ -620,15 +823,15 @@ static void processTables(VTable *const output, VTable const *const input, bool
             exit(EX_CANTCREAT);
         }
     }
-    {
-        rc_t const rc = VTableCreateCursorRead(input, &in);
+    for (i = 0; i < threads; ++i) {
+        rc_t const rc = VTableCreateCursorRead(input, &in[i]);
         if (rc != 0) {
             LogErr(klogFatal, rc, "Failed to create input cursor!");
             exit(EX_NOINPUT);
         }
     }
     VTableRelease(input);
-    processCursors(out, in, haveCache);
+    processCursors(out, threads, in, haveCache);
     VTableRelease(output);
 }
 
@@ -678,19 +881,6 @@ static VTable *createOutput(  Args *const args
     return out;
 }
 
-static uint8_t *growFilterBuffer(uint8_t *out_filter, size_t *const out_filter_count, size_t needed)
-{
-    if (*out_filter_count < needed) {
-        free(out_filter);
-        *out_filter_count = needed;
-        pLogMsg(klogInfo, "increasing max read count to $(max)", "max=%zu", needed);
-        out_filter = malloc(needed * sizeof(out_filter[0]));
-        if (out_filter == NULL)
-            OUT_OF_MEMORY();
-    }
-    return out_filter;
-}
-
 static void test(void)
 {
     uint8_t qual[30];
@@ -698,6 +888,15 @@ static void test(void)
     int j;
     
     assert(shouldFilter(0, NULL) == keep);
+
+    for (i = 0; i < 30; ++i)
+        qual[i] = (uint8_t)(i * 37 + 5);
+    for (i = 0; i <= 30; ++i) {
+        uint32_t expect = 0;
+        for (j = 0; j < i; ++j)
+            expect += qual[j] < 20 ? 1 : 0;
+        assert(countUnder(i, qual) == expect);
+    }
     
     for (i = 0; i < 30; ++i)
         qual[i] = 30;
@@ -748,11 +947,13 @@ static void test(void)
 
 static char const *temp_help[] = { "temp directory to use for scratch space, default: $TMPDIR or $TEMPDIR or $TEMP or $TMP or /tmp", NULL };
 static char const *vdbcache_help[] = { "location of .vdbcache to update", NULL };
+static char const *threads_help[] = { "number of worker threads, default: 4", NULL };
 
 /* MARK: Options array */
 static OptDef Options [] = {
     { "temp", "t", NULL, temp_help, 1, true, false },
-    { "vdbcache", "", NULL, vdbcache_help, 1, true, false }
+    { "vdbcache", "", NULL, vdbcache_help, 1, true, false },
+    { "threads", "", NULL, threads_help, 1, true, false }
 };
 
 /* MARK: Mostly boilerplate from here */
@@ -798,6 +999,7 @@ rc_t CC Usage ( const Args *args )
     KOutMsg ("Options:\n");
     HelpOptionLine(Options[0].aliases, Options[0].name, "path", Options[0].help);
     HelpOptionLine(Options[1].aliases, Options[1].name, "path", Options[1].help);
+    HelpOptionLine(Options[2].aliases, Options[2].name, "count", Options[2].help);
 
     KOutMsg ("Common options:\n");
     HelpOptionsStandard ();
@@ -846,6 +1048,21 @@ static char const *getOptArgValue(int opt, Args *const args)
     return NULL;
 }
 
+static unsigned threadCount(Args *const args)
+{
+    char const *const value = getOptArgValue(OPT_THREADS, args);
+    if (value) {
+        char *end = NULL;
+        unsigned long const count = strtoul(value, &end, 10);
+        if (end == value || *end != '\0' || count == 0) {
+            pLogMsg(klogFatal, "invalid thread count $(value)", "value=%s", value);
+            exit(EX_USAGE);
+        }
+        return count < MAX_THREADS ? (unsigned)count : MAX_THREADS;
+    }
+    return DEFAULT_THREADS;
+}
+
 static char const *absolutePath(char const *const path, char const *const wd)
 {
     if (path == NULL) return NULL;
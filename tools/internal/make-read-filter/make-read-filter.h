@@ -42,6 +42,7 @@
 #include <klib/data-buffer.h>
 #include <klib/printf.h>
 #include <klib/text.h>
+#include <kproc/thread.h>
 #include <sra/sradb.h>
 
 #include <stdarg.h>
@@ -67,7 +68,6 @@ static uint32_t addColumn( char const *const name
                          , char const *const type
                          , VCursor const *const curs);
 static void openCursor(VCursor const *const curs, char const *const name);
-static uint8_t *growFilterBuffer(uint8_t *const out_filter, size_t *const out_filter_count, size_t needed);
 static void openRow(int64_t const row, VCursor const *const out);
 static void writeRow(int64_t const row
                     , uint32_t const reads
@@ -96,7 +96,8 @@ static VTable const *dbOpenTable(char const *const name
 static void tblSchemaInfo(VTable const *tbl, char const **name, VSchema *schema);
 static void dbSchemaInfo(VDatabase const *db, char const **name, VSchema *schema);
 static VTable const *openInput(char const *input, VDBManager const *mgr, bool *noDb, char const **schemaType, VSchema *schema);
-static void processTables(VTable *const output, VTable const *const input, bool const haveCache);
+static void processTables(VTable *const output, VTable const *const input, unsigned const threads, bool const haveCache);
+static unsigned threadCount(Args *const args);
 static VTable *createOutput(Args *const args, VDBManager *const mgr, bool noDb, char const *schemaType, VSchema const *schema);
 static VSchema *makeSchema(VDBManager *mgr);
 
@@ -0,0 +1,256 @@
+/*===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+*/
+
+#include "blob_copy.h"
+
+#ifndef _h_definitions_
+#include "definitions.h"
+#endif
+
+#ifndef _h_copy_meta_
+#include "copy_meta.h"
+#endif
+
+#ifndef _h_klib_out_
+#include <klib/out.h>
+#endif
+
+#ifndef _h_kdb_table_
+#include <kdb/table.h>
+#endif
+
+#ifndef _h_kdb_namelist_
+#include <kdb/namelist.h>
+#endif
+
+#include <sysalloc.h>
+#include <stdlib.h>
+
+static uint32_t blob_copy_name_count( const KNamelist * names ) {
+    uint32_t count = 0;
+    if ( NULL != names ) {
+        if ( 0 != KNamelistCount( names, &count ) ) {
+            count = 0;
+        }
+    }
+    return count;
+}
+
+bool blob_copy_possible( const VTable * src_table ) {
+    bool res = false;
+    const KTable * ktab;
+    rc_t rc = VTableOpenKTableRead( src_table, &ktab );
+    DISP_RC( rc, "blob_copy_possible:VTableOpenKTableRead() failed" );
+    if ( 0 == rc ) {
+        KNamelist * cols = NULL;
+        KNamelist * idxs = NULL;
+        rc = KTableListCol( ktab, &cols );
+        if ( 0 == rc ) {
+            /* a table without indices has none to list: that is not an error */
+            KTableListIdx( ktab, &idxs );
+            res = ( blob_copy_name_count( cols ) > 0 && blob_copy_name_count( idxs ) == 0 );
+        }
+        KNamelistRelease( cols );
+        KNamelistRelease( idxs );
+        KTableRelease( ktab );
+    }
+    return res;
+}
+
+typedef struct blob_copy_buffer
+{
+    void * data;
+    size_t size;
+} blob_copy_buffer;
+
+static rc_t blob_copy_read_blob( const KColumnBlob * blob, blob_copy_buffer * buf, size_t * blob_size ) {
+    size_t num_read, remaining;
+    char dummy;
+    /* ask for the size first */
+    rc_t rc = KColumnBlobRead( blob, 0, &dummy, 0, &num_read, &remaining );
+    if ( 0 == rc && remaining > buf -> size ) {
+        void * p = realloc( buf -> data, remaining );
+        if ( NULL == p ) {
+            rc = RC( rcExe, rcBlob, rcReading, rcMemory, rcExhausted );
+        } else {
+            buf -> data = p;
+            buf -> size = remaining;
+        }
+    }
+    if ( 0 == rc ) {
+        size_t total = remaining;
+        size_t offset = 0;
+        while ( 0 == rc && offset < total ) {
+            rc = KColumnBlobRead( blob, offset, ( char * )buf -> data + offset, total - offset,
+                                  &num_read, &remaining );
+            if ( 0 == rc && 0 == num_read ) {
+                rc = RC( rcExe, rcBlob, rcReading, rcData, rcInsufficient );
+            }
+            offset += num_read;
+        }
+        *blob_size = total;
+    }
+    return rc;
+}
+
+static rc_t blob_copy_column_data( const KColumn * src_col, KColumn * dst_col,
+                                   const char * name, uint64_t * blobs ) {
+    int64_t first;
+    uint64_t count;
+    blob_copy_buffer buf = { NULL, 0 };
+    rc_t rc = KColumnIdRange( src_col, &first, &count );
+    DISP_RC( rc, "blob_copy_column_data:KColumnIdRange() failed" );
+    if ( 0 == rc ) {
+        int64_t row_id = first;
+        int64_t end = first + count;
+        while ( 0 == rc && row_id < end ) {
+            int64_t found;
+            const KColumnBlob * src_blob;
+
+            /* the id-range can have holes: continue with the next blob after them */
+            rc = KColumnFindFirstRowId( src_col, &found, row_id );
+            if ( 0 != rc ) {
+                if ( GetRCState( rc ) == rcNotFound ) {
+                    rc = 0;
+                }
+                break;
+            }
+            rc = KColumnOpenBlobRead( src_col, &src_blob, found );
+            if ( 0 != rc ) {
+                PLOGERR( klogInt, ( klogInt, rc,
+                         "KColumnOpenBlobRead( col:$(col_name) at row #$(row_nr) ) failed",
+                         "col_name=%s,row_nr=%ld", name, found ) );
+            } else {
+                int64_t blob_first;
+                uint32_t blob_count;
+                size_t blob_size = 0;
+                rc = KColumnBlobIdRange( src_blob, &blob_first, &blob_count );
+                DISP_RC( rc, "blob_copy_column_data:KColumnBlobIdRange() failed" );
+                if ( 0 == rc ) {
+                    rc = blob_copy_read_blob( src_blob, &buf, &blob_size );
+                }
+                if ( 0 == rc ) {
+                    KColumnBlob * dst_blob;
+                    rc = KColumnCreateBlob( dst_col, &dst_blob );
+                    DISP_RC( rc, "blob_copy_column_data:KColumnCreateBlob() failed" );
+                    if ( 0 == rc ) {
+                        rc = KColumnBlobAppend( dst_blob, buf . data, blob_size );
+                        if ( 0 == rc ) {
+                            rc = KColumnBlobAssignRange( dst_blob, blob_first, blob_count );
+                        }
+                        if ( 0 == rc ) {
+                            rc = KColumnBlobCommit( dst_blob );
+                        }
+                        if ( 0 != rc ) {
+                            PLOGERR( klogInt, ( klogInt, rc,
+                                     "writing blob( col:$(col_name) at row #$(row_nr) ) failed",
+                                     "col_name=%s,row_nr=%ld", name, blob_first ) );
+                        }
+                        KColumnBlobRelease( dst_blob );
+                    }
+                }
+                KColumnBlobRelease( src_blob );
+                if ( 0 == rc ) {
+                    ( *blobs )++;
+                    row_id = blob_first + blob_count;
+                    rc = Quitting();
+                }
+            }
+        }
+    }
+    free( buf . data );
+    return rc;
+}
+
+static rc_t blob_copy_column( const KTable * src_ktab, KTable * dst_ktab,
+                              const char * name, KCreateMode cmode, KChecksum cs_mode,
+                              const bool show_progress ) {
+    const KColumn * src_col;
+    rc_t rc = KTableOpenColumnRead( src_ktab, &src_col, "%s", name );
+    if ( 0 != rc ) {
+        PLOGERR( klogInt, ( klogInt, rc, "KTableOpenColumnRead( $(col_name) ) failed",
+                 "col_name=%s", name ) );
+    } else {
+        KColumn * dst_col;
+        rc = KTableCreateColumn( dst_ktab, &dst_col, cmode, cs_mode, 0, "%s", name );
+        if ( 0 != rc ) {
+            PLOGERR( klogInt, ( klogInt, rc, "KTableCreateColumn( $(col_name) ) failed",
+                     "col_name=%s", name ) );
+        } else {
+            uint64_t blobs = 0;
+            /* the column-metadata carries the physical encoding of the blobs */
+            rc = copy_column_meta( src_col, dst_col, false );
+            if ( 0 == rc ) {
+                rc = blob_copy_column_data( src_col, dst_col, name, &blobs );
+            }
+            if ( 0 == rc && show_progress ) {
+                KOutMsg( "blob-copy of >%s< : %lu blobs\n", name, blobs );
+            }
+            KColumnRelease( dst_col );
+        }
+        KColumnRelease( src_col );
+    }
+    return rc;
+}
+
+rc_t blob_copy_table( const VTable * src_table, VTable * dst_table,
+                      KCreateMode cmode, KChecksum cs_mode,
+                      const bool show_progress ) {
+    const KTable * src_ktab;
+    rc_t rc;
+
+    if ( NULL == src_table || NULL == dst_table ) {
+        return RC( rcExe, rcNoTarg, rcCopying, rcParam, rcNull );
+    }
+    rc = VTableOpenKTableRead( src_table, &src_ktab );
+    DISP_RC( rc, "blob_copy_table:VTableOpenKTableRead() failed" );
+    if ( 0 == rc ) {
+        KTable * dst_ktab;
+        rc = VTableOpenKTableUpdate( dst_table, &dst_ktab );
+        DISP_RC( rc, "blob_copy_table:VTableOpenKTableUpdate() failed" );
+        if ( 0 == rc ) {
+            KNamelist * names;
+            rc = KTableListCol( src_ktab, &names );
+            DISP_RC( rc, "blob_copy_table:KTableListCol() failed" );
+            if ( 0 == rc ) {
+                uint32_t idx, count = blob_copy_name_count( names );
+                for ( idx = 0; 0 == rc && idx < count; ++idx ) {
+                    const char * name;
+                    rc = KNamelistGet( names, idx, &name );
+                    DISP_RC( rc, "blob_copy_table:KNamelistGet() failed" );
+                    if ( 0 == rc ) {
+                        rc = blob_copy_column( src_ktab, dst_ktab, name, cmode, cs_mode,
+                                               show_progress );
+                    }
+                }
+                KNamelistRelease( names );
+            }
+            KTableRelease( dst_ktab );
+        }
+        KTableRelease( src_ktab );
+    }
+    return rc;
+}
@@ -0,0 +1,69 @@
+/*===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+*/
+
+#ifndef _h_blob_copy_
+#define _h_blob_copy_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef _h_klib_rc_
+#include <klib/rc.h>
+#endif
+
+#ifndef _h_vdb_table_
+#include <vdb/table.h>
+#endif
+
+#ifndef _h_kdb_manager_
+#include <kdb/manager.h>
+#endif
+
+#ifndef _h_kdb_column_
+#include <kdb/column.h>
+#endif
+
+/*
+ * true if the physical table can be copied blob by blob:
+ * it has columns and no indices ( they are not rebuilt by a blob-copy )
+*/
+bool blob_copy_possible( const VTable * src_table );
+
+/*
+ * copies every physical column of src_table into the empty dst_table
+ * without decoding: the encoded blobs are appended to new columns
+ * with the same row-ranges, the column-metadata is copied too
+*/
+rc_t blob_copy_table( const VTable * src_table, VTable * dst_table,
+                      KCreateMode cmode, KChecksum cs_mode,
+                      const bool show_progress );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
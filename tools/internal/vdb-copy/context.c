@@ -30,6 +30,8 @@
 #include "helper.h"
 #endif
 
+#include <stdlib.h>
+
 /*
  * helper-function to set a string inside the context
  * ( makes a copy ) with error detection
@@ -79,6 +81,9 @@ static void context_init_values( p_context ctx ) {
     ctx -> md5_mode = MD5_MODE_AUTO;
     ctx -> force_kcmInit = false;
     ctx -> force_unlock = false;
+    ctx -> blob_copy = false;
+    ctx -> threads = 1;
+    ctx -> rows_requested = false;
 
     ctx -> dont_remove_target = false;
     config_values_init( &( ctx -> config ) );
@@ -285,6 +290,22 @@ static rc_t context_set_blob_checksum( p_context ctx, const char *src ) {
     return 0;
 }
 
+static rc_t context_set_threads( p_context ctx, const char *src ) {
+    rc_t rc = 0;
+    if ( NULL != src ) {
+        char * end;
+        unsigned long value = strtoul( src, &end, 10 );
+        if ( end != src && 0 == *end && value > 0 && value <= 256 ) {
+            ctx -> threads = ( uint32_t )value;
+        } else {
+            rc = RC( rcExe, rcArgv, rcParsing, rcParam, rcInvalid );
+            PLOGERR( klogErr, ( klogErr, rc, "invalid value for --$(opt): '$(val)', expected 1 ... 256",
+                                "opt=%s,val=%s", OPTION_THREADS, src ) );
+        }
+    }
+    return rc;
+}
+
 static rc_t context_set_row_range( p_context ctx, const char *src ) {
     rc_t rc;
     if ( ( NULL == ctx )||( NULL == src ) ) {
@@ -371,7 +392,8 @@ uint32_t context_schema_count( p_context ctx ) {
     return res;
 }
 
-static void context_evaluate_options( const Args *my_args, p_context ctx ) {
+static rc_t context_evaluate_options( const Args *my_args, p_context ctx ) {
+    rc_t rc = 0;
     if ( ( NULL != my_args ) && ( NULL != ctx ) ) {
 
         ctx -> dont_check_accession = context_get_bool_option( my_args, OPTION_WITHOUT_ACCESSION, false );
@@ -385,6 +407,8 @@ static void context_evaluate_options( const Args *my_args, p_context ctx ) {
         ctx -> show_meta     = context_get_bool_option( my_args, OPTION_SHOW_META, false );
         ctx -> force_kcmInit = context_get_bool_option( my_args, OPTION_FORCE, false );
         ctx -> force_unlock  = context_get_bool_option( my_args, OPTION_UNLOCK, false );
+        ctx -> blob_copy     = context_get_bool_option( my_args, OPTION_BLOB_COPY, false );
+        rc = context_set_threads( ctx, context_get_str_option( my_args, OPTION_THREADS ) );
 
         context_set_md5_mode( ctx, context_get_str_option( my_args, OPTION_MD5_MODE ) );
         context_set_blob_checksum( ctx, context_get_str_option( my_args, OPTION_BLOB_CHECKSUM ) );
@@ -401,11 +425,13 @@ static void context_evaluate_options( const Args *my_args, p_context ctx ) {
 
         {
             const char * row_range = context_get_str_option( my_args, OPTION_ROWS );
+            ctx -> rows_requested = ( NULL != row_range );
             context_set_row_range( ctx, row_range );
         }
         nlt_make_VNamelist_from_string( &( ctx -> src_schema_list ), 
                                         context_get_str_option( my_args, OPTION_SCHEMA ) );
     }
+    return rc;
 }
 
 /*
@@ -416,7 +442,9 @@ rc_t context_capture_arguments_and_options( const Args * args, p_context ctx ) {
     rc_t rc = context_evaluate_arguments( args, ctx );
     DISP_RC( rc, "evaluate_arguments() failed" );
     if ( 0 == rc ) {
-        context_evaluate_options( args, ctx );
+        rc = context_evaluate_options( args, ctx );
+    }
+    if ( 0 == rc ) {
         context_check_if_usage_necessary( ctx );
 
         rc = ArgsHandleLogLevel( args );
@@ -82,6 +82,8 @@ extern "C" {
 #define OPTION_FORCE             "force"
 #define OPTION_UNLOCK            "unlock"
 #define OPTION_BLOB_CHECKSUM     "blob_checksum"
+#define OPTION_BLOB_COPY         "blob_copy"
+#define OPTION_THREADS           "threads"
 
 
 #define ALIAS_TABLE             "T"
@@ -107,6 +109,8 @@ extern "C" {
 #define ALIAS_FORCE             "f"
 #define ALIAS_UNLOCK            "u"
 #define ALIAS_BLOB_CHECKSUM     "b"
+#define ALIAS_BLOB_COPY         "B"
+#define ALIAS_THREADS           "j"
 
 
 /* *******************************************************************
@@ -123,6 +127,7 @@ typedef struct context
     const char *columns;
     const char *excluded_columns;
     struct num_gen * row_generator;
+    bool rows_requested;
     bool usage_requested;
     bool dont_check_accession;
     uint64_t platform_id;
@@ -138,6 +143,8 @@ typedef struct context
     uint8_t blob_checksum;
     bool force_kcmInit;
     bool force_unlock;
+    bool blob_copy;
+    uint32_t threads;
 
     /* set by application */
     bool dont_remove_target;
@@ -448,3 +448,27 @@ rc_t copy_database_meta ( const VDatabase *src_db, VDatabase *dst_db,
     }
     return rc;
 }
+
+
+rc_t copy_column_meta ( const KColumn *src_col, KColumn *dst_col,
+                        const bool show_meta ) {
+    const KMetadata *src_meta;
+    rc_t rc;
+
+    if ( NULL == src_col || NULL == dst_col ) {
+        return RC( rcExe, rcNoTarg, rcCopying, rcParam, rcNull );
+    }
+    rc = KColumnOpenMetadataRead ( src_col, & src_meta );
+    DISP_RC( rc, "copy_column_meta:KColumnOpenMetadataRead() failed" );
+    if ( 0 == rc ) {
+        KMetadata *dst_meta;
+        rc = KColumnOpenMetadataUpdate ( dst_col, & dst_meta );
+        DISP_RC( rc, "copy_column_meta:KColumnOpenMetadataUpdate() failed" );
+        if ( 0 == rc ) {
+            rc = copy_stray_metadata ( src_meta, dst_meta, NULL, show_meta );
+            KMetadataRelease ( dst_meta );
+        }
+        KMetadataRelease ( src_meta );
+    }
+    return rc;
+}
@@ -42,6 +42,10 @@ extern "C" {
 #ifndef _h_vdb_database_
 #include <vdb/database.h>
 #endif
+
+#ifndef _h_kdb_column_
+#include <kdb/column.h>
+#endif
     
 rc_t copy_table_meta ( const VTable *src_table, VTable *dst_table,
                        const char * excluded_nodes,
@@ -51,6 +55,9 @@ rc_t copy_database_meta ( const VDatabase *src_db, VDatabase *dst_db,
                           const char * excluded_nodes,
                           const bool show_meta );
 
+rc_t copy_column_meta ( const KColumn *src_col, KColumn *dst_col,
+                        const bool show_meta );
+
 #ifdef __cplusplus
 }
 #endif
@@ -349,6 +349,33 @@ rc_t helper_read_vdb_int( const VCursor* src_cursor,
     return rc;
 }
 
+rc_t helper_read_vdb_blob_int( const VBlob* blob,
+                               const int64_t row_id,
+                               uint64_t * dst ) {
+    const void *base;
+    uint32_t offset_in_bits;
+    uint32_t element_bits;
+    uint32_t element_count;
+    rc_t rc;
+
+    if ( NULL == blob || NULL == dst ) {
+        return RC( rcExe, rcNoTarg, rcConstructing, rcParam, rcNull );
+    }
+    *dst = 0;
+    rc = VBlobCellData( blob, row_id, &element_bits, &base, &offset_in_bits, &element_count );
+    DISP_RC( rc, "helper_read_vdb_blob_int:VBlobCellData() failed" );
+    if ( 0 == rc && element_count > 0 ) {
+        uint64_t value = 0;
+        if ( 0 == ( offset_in_bits & 7 ) ) {
+            memmove( &value, ( const char * )base + ( offset_in_bits >> 3 ), bitlength_2_bytes( element_bits ) );
+        } else {
+            bitcpy ( &value, 0, base, offset_in_bits, element_bits );
+        }
+        *dst = value;
+    }
+    return rc;
+}
+
 /*
  * reads a string out of a KConfig-object:
  * needs a cfg-object, and the full name of the key(node)
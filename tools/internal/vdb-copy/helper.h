@@ -51,6 +51,10 @@ extern "C" {
 #include <vdb/cursor.h>
 #endif
 
+#ifndef _h_vdb_blob_
+#include <vdb/blob.h>
+#endif
+
 #ifndef _h_kfg_config_
 #include <kfg/config.h>
 #endif
@@ -128,6 +132,16 @@ rc_t helper_read_vdb_int( const VCursor* src_cursor,
                           uint64_t * dst );
 
 
+/*
+ * reads a int64 out of a blob of a vdb-column:
+ * the row has to be in the blob's id-range,
+ * no cursor-row is opened / an empty row reads as 0
+*/
+rc_t helper_read_vdb_blob_int( const VBlob* blob,
+                               const int64_t row_id,
+                               uint64_t * dst );
+
+
 /*
  * reads a string out of a KConfig-object:
  * needs a cfg-object, and the full name of the key(node)
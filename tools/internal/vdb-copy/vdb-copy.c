@@ -64,6 +64,14 @@
 #include "copy_meta.h"
 #endif
 
+#ifndef _h_blob_copy_
+#include "blob_copy.h"
+#endif
+
+#include <kproc/thread.h>
+#include <kproc/lock.h>
+#include <kproc/cond.h>
+
 static const char * table_usage[] = { "table-name", NULL };
 static const char * rows_usage[] = { "set of rows to be copied(default = all)", NULL };
 #if ALLOW_COLUMN_SPEC
@@ -87,6 +95,8 @@ static const char * md5mode_usage[] = { "MD5-mode def.: auto, '1'...forced ON, '
 static const char * blcmode_usage[] = { "Blob-checksum def.: auto, '1'...CRC32, 'M'...MD5, '0'...OFF)", NULL };
 static const char * force_usage[] = { "forces an existing target to be overwritten", NULL };
 static const char * unlock_usage[] = { "forces a locked target to be unlocked", NULL };
+static const char * blob_copy_usage[] = { "copy untouched tables blob by blob, without decoding", NULL };
+static const char * threads_usage[] = { "number of threads reading the source (def.: 1)", NULL };
 
 OptDef MyOptions[] = {
     { OPTION_TABLE, ALIAS_TABLE, NULL, table_usage, 1, true, false },
@@ -111,7 +121,9 @@ OptDef MyOptions[] = {
     { OPTION_MD5_MODE, ALIAS_MD5_MODE, NULL, md5mode_usage, 1, true, false },
     { OPTION_BLOB_CHECKSUM, ALIAS_BLOB_CHECKSUM, NULL, blcmode_usage, 1, true, false },
     { OPTION_FORCE, ALIAS_FORCE, NULL, force_usage, 1, false, false },
-    { OPTION_UNLOCK, ALIAS_UNLOCK, NULL, unlock_usage, 1, false, false }
+    { OPTION_UNLOCK, ALIAS_UNLOCK, NULL, unlock_usage, 1, false, false },
+    { OPTION_BLOB_COPY, ALIAS_BLOB_COPY, NULL, blob_copy_usage, 1, false, false },
+    { OPTION_THREADS, ALIAS_THREADS, NULL, threads_usage, 1, true, false }
 };
 
 const char UsageDefaultName[] = "vdb-copy";
@@ -164,6 +176,8 @@ rc_t CC Usage ( const Args * args ) {
     HelpOptionLine ( ALIAS_UNLOCK, OPTION_UNLOCK, NULL, unlock_usage );
     HelpOptionLine ( ALIAS_MD5_MODE, OPTION_MD5_MODE, NULL, md5mode_usage );
     HelpOptionLine ( ALIAS_BLOB_CHECKSUM, OPTION_BLOB_CHECKSUM, NULL, blcmode_usage );
+    HelpOptionLine ( ALIAS_BLOB_COPY, OPTION_BLOB_COPY, NULL, blob_copy_usage );
+    HelpOptionLine ( ALIAS_THREADS, OPTION_THREADS, "count", threads_usage );
 
     HelpOptionsStandard();
 
@@ -338,6 +352,521 @@ static rc_t vdb_copy_read_row_flags( const p_context ctx,
     return rc;
 }
 
+/* --------------------------------------------------------------------
+ * the multi-threaded row-loop:
+ * worker-threads read ( and redact ) chunks of rows on their own
+ * src-cursors, the calling thread writes the chunks strictly in
+ * row-order into the one dst-cursor
+ * -------------------------------------------------------------------- */
+#define MT_CHUNK_ROWS 1024
+#define MT_WINDOW_PER_THREAD 2
+
+typedef struct mt_cell
+{
+    uint32_t elem_bits;
+    uint32_t offset_in_bits;
+    uint32_t n_elements;
+    size_t data_offset;
+} mt_cell;
+
+typedef struct mt_chunk
+{
+    uint32_t n_rows;
+    int64_t row_ids[ MT_CHUNK_ROWS ];
+    bool pass[ MT_CHUNK_ROWS ];
+    mt_cell * cells;        /* n_rows * n_cols */
+    char * data;
+    size_t data_size;
+    size_t data_max;
+    rc_t rc;                /* rows up to n_rows are good, then this happened */
+} mt_chunk;
+
+typedef struct mt_shared
+{
+    p_context ctx;
+    p_col_def * cols;       /* the columns to copy, in the order of the col-defs */
+    uint32_t * col_vidx;    /* their index in the col-defs */
+    uint32_t n_cols;
+
+    const struct num_gen_iter * iter;
+    rc_t iter_rc;
+    bool iter_done;
+    bool cancel;
+    uint32_t running;
+
+    KLock * lock;
+    KCondition * cond;
+    uint64_t next_seq;      /* next chunk to be read */
+    uint64_t write_seq;     /* next chunk to be written */
+    uint64_t window;
+    mt_chunk ** slots;      /* window slots, by seq % window */
+} mt_shared;
+
+typedef struct mt_worker
+{
+    mt_shared * shared;
+    const VCursor * cursor;
+    uint32_t * idx;         /* per column to copy: index in this cursor */
+    uint32_t filter_idx;
+    bool has_filter;
+    redact_buffer rbuf;
+    KThread * thread;
+} mt_worker;
+
+static void mt_chunk_free( mt_chunk * chunk ) {
+    if ( NULL != chunk ) {
+        free( chunk -> cells );
+        free( chunk -> data );
+        free( chunk );
+    }
+}
+
+static char * mt_chunk_reserve( mt_chunk * chunk, size_t size ) {
+    if ( chunk -> data_size + size > chunk -> data_max ) {
+        size_t new_max = chunk -> data_max > 0 ? chunk -> data_max * 2 : 64 * 1024;
+        char * p;
+        while ( new_max < chunk -> data_size + size ) {
+            new_max *= 2;
+        }
+        p = realloc( chunk -> data, new_max );
+        if ( NULL == p ) {
+            return NULL;
+        }
+        chunk -> data = p;
+        chunk -> data_max = new_max;
+    }
+    return chunk -> data + chunk -> data_size;
+}
+
+static rc_t mt_read_cell( mt_worker * w, mt_chunk * chunk, uint32_t row, uint32_t c,
+                          bool redact ) {
+    const p_col_def col = w -> shared -> cols[ c ];
+    mt_cell * cell = &( chunk -> cells[ row * w -> shared -> n_cols + c ] );
+    const void * buffer;
+    uint32_t offset_in_bits;
+    size_t size;
+    char * dst;
+
+    rc_t rc = VCursorCellData( w -> cursor, w -> idx[ c ], &( cell -> elem_bits ),
+                               &buffer, &offset_in_bits, &( cell -> n_elements ) );
+    if ( 0 != rc ) {
+        PLOGERR( klogInt,
+                 ( klogInt,
+                 rc,
+                 "VCursorCellData( col:$(col_name) at row #$(row_nr) ) failed",
+                 "col_name=%s,row_nr=%lu",
+                  col -> name, chunk -> row_ids[ row ] ) );
+        return rc;
+    }
+    if ( redact && col -> redactable ) {
+        /* same as vdb_copy_redact_cell(), but into the chunk */
+        size = ( ( cell -> elem_bits * cell -> n_elements ) + 8 ) >> 3;
+        rc = redact_buf_resize( &( w -> rbuf ), size );
+        DISP_RC( rc, "mt_read_cell:redact_buf_resize() failed" );
+        if ( 0 != rc ) return rc;
+        if ( col -> r_val != NULL ) {
+            redact_val_fill_buffer( col -> r_val, &( w -> rbuf ), size );
+        } else {
+            memset( w -> rbuf . buffer, 0, size );
+        }
+        buffer = w -> rbuf . buffer;
+        cell -> offset_in_bits = 0;
+    } else {
+        buffer = ( const char * )buffer + ( offset_in_bits >> 3 );
+        cell -> offset_in_bits = offset_in_bits & 7;
+        size = ( cell -> offset_in_bits + ( ( uint64_t )cell -> elem_bits * cell -> n_elements ) + 7 ) >> 3;
+    }
+    dst = mt_chunk_reserve( chunk, size );
+    if ( NULL == dst ) {
+        rc = RC( rcExe, rcBuffer, rcAllocating, rcMemory, rcExhausted );
+        LOGERR( klogErr, rc, "mt_read_cell: out of memory" );
+        return rc;
+    }
+    if ( size > 0 ) {
+        memmove( dst, buffer, size );
+    }
+    cell -> data_offset = chunk -> data_size;
+    chunk -> data_size += size;
+    return rc;
+}
+
+static rc_t mt_read_row( mt_worker * w, mt_chunk * chunk, uint32_t row ) {
+    int64_t row_id = chunk -> row_ids[ row ];
+    rc_t rc = VCursorSetRowId( w -> cursor, row_id );
+    if ( 0 != rc ) {
+        PLOGERR( klogInt, (klogInt, rc,
+                 "VCursorSetRowId(src) row #$(row_nr) failed",
+                 "row_nr=%lu", row_id ));
+        return rc;
+    }
+    rc = VCursorOpenRow( w -> cursor );
+    if ( 0 != rc ) {
+        PLOGERR( klogInt, (klogInt, rc,
+                 "VCursorOpenRow(src) row #$(row_nr) failed",
+                 "row_nr=%lu", row_id ));
+    } else {
+        bool pass_flag = true;
+        bool redact_flag = false;
+        uint32_t c;
+
+        if ( w -> has_filter ) {
+            vdb_copy_read_row_flags( w -> shared -> ctx, w -> cursor,
+                                     w -> filter_idx, &pass_flag, &redact_flag );
+        }
+        chunk -> pass[ row ] = pass_flag;
+        for ( c = 0; pass_flag && 0 == rc && c < w -> shared -> n_cols; ++c ) {
+            rc = mt_read_cell( w, chunk, row, c, redact_flag );
+        }
+        if ( 0 == rc ) {
+            rc = VCursorCloseRow( w -> cursor );
+            if ( 0 != rc ) {
+                PLOGERR( klogInt, ( klogInt, rc,
+                         "VCursorCloseRow(src) row #$(row_nr) failed",
+                         "row_nr=%lu", row_id ) );
+            }
+        }
+    }
+    return rc;
+}
+
+/* takes the next chunk of row-ids from the number-generator, under the lock */
+static mt_chunk * mt_next_chunk( mt_shared * sh, uint64_t * seq ) {
+    mt_chunk * chunk = NULL;
+    KLockAcquire( sh -> lock );
+    while ( !sh -> cancel && !sh -> iter_done &&
+            sh -> next_seq >= sh -> write_seq + sh -> window ) {
+        KConditionWait( sh -> cond, sh -> lock );
+    }
+    if ( !sh -> cancel && !sh -> iter_done ) {
+        chunk = calloc( 1, sizeof *chunk );
+        if ( NULL != chunk ) {
+            chunk -> cells = malloc( MT_CHUNK_ROWS * ( sh -> n_cols + 1 ) * sizeof( mt_cell ) );
+        }
+        if ( NULL == chunk || NULL == chunk -> cells ) {
+            sh -> iter_rc = RC( rcExe, rcBuffer, rcAllocating, rcMemory, rcExhausted );
+            sh -> iter_done = true;
+            mt_chunk_free( chunk );
+            chunk = NULL;
+        } else {
+            while ( chunk -> n_rows < MT_CHUNK_ROWS ) {
+                int64_t row_id;
+                rc_t rc = 0;
+                if ( !num_gen_iterator_next( sh -> iter, &row_id, &rc ) ) {
+                    sh -> iter_rc = rc;
+                    sh -> iter_done = true;
+                    break;
+                }
+                chunk -> row_ids[ chunk -> n_rows++ ] = row_id;
+            }
+            if ( 0 == chunk -> n_rows ) {
+                mt_chunk_free( chunk );
+                chunk = NULL;
+            } else {
+                *seq = sh -> next_seq++;
+            }
+        }
+    }
+    KLockUnlock( sh -> lock );
+    return chunk;
+}
+
+static rc_t CC mt_worker_thread( const KThread * self, void * data ) {
+    mt_worker * w = data;
+    mt_shared * sh = w -> shared;
+    bool failed = false;
+
+    while ( !failed ) {
+        uint64_t seq = 0;
+        uint32_t row;
+        mt_chunk * chunk = mt_next_chunk( sh, &seq );
+        if ( NULL == chunk ) break;
+
+        for ( row = 0; row < chunk -> n_rows; ++row ) {
+            chunk -> rc = mt_read_row( w, chunk, row );
+            if ( 0 == chunk -> rc ) {
+                chunk -> rc = Quitting();
+            }
+            if ( 0 != chunk -> rc ) {
+                /* the rows before this one are still to be written */
+                chunk -> n_rows = row;
+                failed = true;
+            }
+        }
+        KLockAcquire( sh -> lock );
+        sh -> slots[ seq % sh -> window ] = chunk;
+        KConditionBroadcast( sh -> cond );
+        KLockUnlock( sh -> lock );
+    }
+    KLockAcquire( sh -> lock );
+    sh -> running--;
+    KConditionBroadcast( sh -> cond );
+    KLockUnlock( sh -> lock );
+    return 0;
+}
+
+static rc_t mt_write_row( VCursor * dst_cursor, const mt_shared * sh,
+                          const mt_chunk * chunk, uint32_t row ) {
+    int64_t row_id = chunk -> row_ids[ row ];
+    uint32_t c;
+    rc_t rc = VCursorOpenRow( dst_cursor );
+    if ( 0 != rc ) {
+        PLOGERR( klogInt,
+                 (klogInt,
+                 rc,
+                 "VCursorOpenRow(dst) row #$(row_nr) failed",
+                 "row_nr=%lu",
+                 row_id ));
+        return rc;
+    }
+    for ( c = 0; 0 == rc && c < sh -> n_cols; ++c ) {
+        const mt_cell * cell = &( chunk -> cells[ row * sh -> n_cols + c ] );
+        rc = VCursorWrite( dst_cursor, sh -> cols[ c ] -> dst_idx, cell -> elem_bits,
+                           chunk -> data + cell -> data_offset, cell -> offset_in_bits,
+                           cell -> n_elements );
+        if ( 0 != rc ) {
+            PLOGERR( klogInt,
+                     (klogInt,
+                     rc,
+                     "VCursorWrite( col:$(col_name) at row #$(row_nr) ) failed",
+                     "col_name=%s,row_nr=%lu",
+                      sh -> cols[ c ] -> name, row_id ));
+        }
+    }
+    if ( 0 == rc ) {
+        rc = VCursorCommitRow( dst_cursor );
+        if ( 0 != rc ) {
+            PLOGERR( klogInt,
+                     (klogInt,
+                     rc,
+                     "VCursorCommitRow(dst) row #$(row_nr) failed",
+                     "row_nr=%lu",
+                     row_id ));
+        }
+
+        rc = VCursorCloseRow( dst_cursor );
+        if ( 0 != rc ) {
+            PLOGERR( klogInt,
+                     (klogInt,
+                     rc,
+                     "VCursorCloseRow(dst) row #$(row_nr) failed",
+                     "row_nr=%lu",
+                     row_id ));
+        }
+    }
+    return rc;
+}
+
+/* a cursor per worker, with the same columns as the src-cursor */
+static rc_t mt_worker_open( mt_worker * w, const VTable * src_table,
+                            col_defs * columns, uint32_t * vidx_map ) {
+    uint32_t idx, len = VectorLength( &( columns -> cols ) );
+    rc_t rc = VTableCreateCursorRead( src_table, &( w -> cursor ) );
+    DISP_RC( rc, "mt_worker_open:VTableCreateCursorRead() failed" );
+    for ( idx = 0; 0 == rc && idx < len; ++idx ) {
+        p_col_def col = ( p_col_def ) VectorGet ( &( columns -> cols ), idx );
+        if ( NULL != col && NULL != col -> src_cast ) {
+            rc = VCursorAddColumn( w -> cursor, &( vidx_map[ idx ] ), "%s", col -> src_cast );
+            DISP_RC( rc, "mt_worker_open:VCursorAddColumn() failed" );
+        }
+    }
+    if ( 0 == rc ) {
+        rc = VCursorOpen( w -> cursor );
+        DISP_RC( rc, "mt_worker_open:VCursorOpen() failed" );
+    }
+    if ( 0 == rc ) {
+        uint32_t c;
+        for ( c = 0; c < w -> shared -> n_cols; ++c ) {
+            w -> idx[ c ] = vidx_map[ w -> shared -> col_vidx[ c ] ];
+        }
+        w -> has_filter = ( -1 != columns -> filter_idx );
+        if ( w -> has_filter ) {
+            w -> filter_idx = vidx_map[ columns -> filter_idx ];
+        }
+    }
+    return rc;
+}
+
+static rc_t vdb_copy_row_loop_mt( const p_context ctx,
+                                  const VCursor * src_cursor,
+                                  VCursor * dst_cursor,
+                                  col_defs * columns,
+                                  redact_vals * rvals ) {
+    rc_t rc;
+    mt_shared sh;
+    mt_worker * workers = NULL;
+    uint32_t * vidx_map = NULL;
+    const VTable * src_table = NULL;
+    uint32_t idx, len, n_workers = 0;
+    uint64_t count = 0;
+    uint32_t percent;
+    struct progressbar * progress = NULL;
+
+    memset( &sh, 0, sizeof sh );
+    sh . ctx = ctx;
+    sh . window = ( uint64_t )ctx -> threads * MT_WINDOW_PER_THREAD;
+
+    col_defs_find_redact_vals( columns, rvals );
+    len = VectorLength( &( columns -> cols ) );
+    sh . cols = calloc( len + 1, sizeof *sh . cols );
+    sh . col_vidx = calloc( len + 1, sizeof *sh . col_vidx );
+    sh . slots = calloc( sh . window, sizeof *sh . slots );
+    vidx_map = calloc( len + 1, sizeof *vidx_map );
+    workers = calloc( ctx -> threads, sizeof *workers );
+    if ( NULL == sh . cols || NULL == sh . col_vidx || NULL == sh . slots ||
+         NULL == vidx_map || NULL == workers ) {
+        rc = RC( rcExe, rcThread, rcCreating, rcMemory, rcExhausted );
+    } else {
+        for ( idx = 0; idx < len; ++idx ) {
+            p_col_def col = ( p_col_def ) VectorGet ( &( columns -> cols ), idx );
+            if ( NULL != col && col -> to_copy ) {
+                sh . cols[ sh . n_cols ] = col;
+                sh . col_vidx[ sh . n_cols++ ] = idx;
+            }
+        }
+        rc = num_gen_iterator_make( ctx -> row_generator, &( sh . iter ) );
+    }
+    if ( 0 == rc ) {
+        rc = KLockMake( &( sh . lock ) );
+        if ( 0 == rc ) {
+            rc = KConditionMake( &( sh . cond ) );
+        }
+    }
+    if ( 0 == rc ) {
+        rc = VCursorOpenParentRead( src_cursor, &src_table );
+        DISP_RC( rc, "vdb_copy_row_loop_mt:VCursorOpenParentRead() failed" );
+    }
+    if ( 0 == rc ) {
+        rc = make_progressbar( &progress, 2 );
+        DISP_RC( rc, "vdb_copy_row_loop_mt:make_progressbar() failed" );
+    }
+    /* the cursors are made here, the threads only use them */
+    for ( idx = 0; 0 == rc && idx < ctx -> threads; ++idx ) {
+        mt_worker * w = &workers[ idx ];
+        w -> shared = &sh;
+        redact_buf_init( &( w -> rbuf ) );
+        n_workers++;
+        w -> idx = calloc( sh . n_cols + 1, sizeof *w -> idx );
+        if ( NULL == w -> idx ) {
+            rc = RC( rcExe, rcThread, rcCreating, rcMemory, rcExhausted );
+        } else {
+            rc = mt_worker_open( w, src_table, columns, vidx_map );
+        }
+    }
+    for ( idx = 0; 0 == rc && idx < n_workers; ++idx ) {
+        KLockAcquire( sh . lock );
+        sh . running++;
+        KLockUnlock( sh . lock );
+        rc = KThreadMake( &( workers[ idx ] . thread ), mt_worker_thread, &workers[ idx ] );
+        if ( 0 != rc ) {
+            LOGERR( klogErr, rc, "vdb_copy_row_loop_mt:KThreadMake() failed" );
+            KLockAcquire( sh . lock );
+            sh . running--;
+            KLockUnlock( sh . lock );
+        }
+    }
+
+    /* the writer: takes the chunks in the order of their row-ids */
+    while ( 0 == rc ) {
+        mt_chunk * chunk = NULL;
+        uint64_t seq = sh . write_seq;
+        uint32_t row;
+
+        KLockAcquire( sh . lock );
+        for ( ; ; ) {
+            chunk = sh . slots[ seq % sh . window ];
+            if ( NULL != chunk ) {
+                sh . slots[ seq % sh . window ] = NULL;
+                sh . write_seq = seq + 1;
+                KConditionBroadcast( sh . cond );
+                break;
+            }
+            if ( seq >= sh . next_seq && ( sh . iter_done || 0 == sh . running ) ) {
+                break;
+            }
+            KConditionWait( sh . cond, sh . lock );
+        }
+        if ( ctx -> show_progress && NULL != chunk ) {
+            if ( num_gen_iterator_percent( sh . iter, 2, &percent ) == 0 ) {
+                update_progressbar( progress, percent );
+            }
+        }
+        KLockUnlock( sh . lock );
+        if ( NULL == chunk ) {
+            rc = sh . iter_rc;
+            break;
+        }
+
+        for ( row = 0; 0 == rc && row < chunk -> n_rows; ++row ) {
+            if ( chunk -> pass[ row ] ) {
+                rc = mt_write_row( dst_cursor, &sh, chunk, row );
+            }
+            if ( 0 == rc ) {
+                count++;
+            }
+        }
+        if ( 0 == rc ) {
+            rc = chunk -> rc;
+        }
+        mt_chunk_free( chunk );
+    }
+
+    /* stop the workers, drop what they have read ahead */
+    if ( NULL != sh . lock ) {
+        KLockAcquire( sh . lock );
+        sh . cancel = true;
+        KConditionBroadcast( sh . cond );
+        KLockUnlock( sh . lock );
+    }
+    for ( idx = 0; idx < n_workers; ++idx ) {
+        mt_worker * w = &workers[ idx ];
+        if ( NULL != w -> thread ) {
+            KThreadWait( w -> thread, NULL );
+            KThreadRelease( w -> thread );
+        }
+        VCursorRelease( w -> cursor );
+        redact_buf_free( &( w -> rbuf ) );
+        free( w -> idx );
+    }
+    for ( idx = 0; NULL != sh . slots && idx < sh . window; ++idx ) {
+        mt_chunk_free( sh . slots[ idx ] );
+    }
+
+    /* set rc to zero for num_gen_iterator_next() reached last id */
+    if ( GetRCModule( rc ) == rcVDB && 
+         GetRCTarget( rc ) == rcNoTarg && 
+         GetRCContext( rc ) == rcReading &&
+         GetRCObject( rc ) == rcId &&
+         GetRCState( rc ) == rcInvalid ) {
+        rc = 0;
+    }
+
+    if ( ctx -> show_progress ) {
+        KOutMsg( "\n" );
+    }
+    destroy_progressbar( progress );
+
+    PLOGMSG( klogInfo, ( klogInfo, "\n $(row_cnt) rows copied", "row_cnt=%lu", count ));
+
+    if ( 0 == rc ) {
+        rc = VCursorCommit( dst_cursor );
+        if ( 0 != rc ) {
+            LOGERR( klogInt, rc, "VCursorCommit( dst ) after processing all rows failed" );
+        }
+    }
+    if ( NULL != sh . iter ) {
+        num_gen_iterator_destroy( sh . iter );
+    }
+    VTableRelease( src_table );
+    KConditionRelease( sh . cond );
+    KLockRelease( sh . lock );
+    free( workers );
+    free( vidx_map );
+    free( sh . slots );
+    free( sh . col_vidx );
+    free( sh . cols );
+    return rc;
+}
+
 static rc_t vdb_copy_row_loop( const p_context ctx,
                                const VCursor * src_cursor,
                                VCursor * dst_cursor,
@@ -352,6 +881,11 @@ static rc_t vdb_copy_row_loop( const p_context ctx,
     redact_buffer rbuf;
     struct progressbar * progress = NULL;
 
+    /* the redaction-report is written in row-order by the single-threaded loop only */
+    if ( ctx -> threads > 1 && !ctx -> show_redact ) {
+        return vdb_copy_row_loop_mt( ctx, src_cursor, dst_cursor, columns, rvals );
+    }
+
     if ( -1 != columns -> filter_idx ) {
         filter_col_def = col_defs_get( columns, columns -> filter_idx );
     }
@@ -764,6 +1298,106 @@ static rc_t vdb_copy_open_source_table( const p_context ctx,
     return vdb_copy_check_range( ctx, src_cursor );
 }
 
+/* true if a row of the blob, starting at row_id, would be dropped or redacted by the row-loop */
+static bool vdb_copy_blob_needs_action( const p_context ctx, const VBlob * blob,
+                                        int64_t row_id, int64_t end ) {
+    bool res = false;
+    for ( ; !res && row_id < end; ++row_id ) {
+        uint64_t filter;
+        rc_t rc = helper_read_vdb_blob_int( blob, row_id, &filter );
+        if ( 0 != rc ) {
+            res = true;
+        } else if ( SRA_READ_FILTER_REJECT == filter ) {
+            res = !ctx -> ignore_reject;
+        } else if ( SRA_READ_FILTER_REDACTED == filter ) {
+            res = !ctx -> ignore_redact;
+        }
+    }
+    return res;
+}
+
+/* true if the filter-column has rows the row-loop would drop or redact,
+   the filter-column is read blob by blob, without opening a cursor-row per row */
+static bool vdb_copy_filter_needs_action( const p_context ctx,
+                                          const VCursor * src_cursor,
+                                          col_defs * columns ) {
+    bool res = false;
+    col_defs_detect_filter_col( columns, ctx -> config.filter_col_name );
+    if ( -1 != columns -> filter_idx && !( ctx -> ignore_reject && ctx -> ignore_redact ) ) {
+        p_col_def filter_col_def = col_defs_get( columns, columns -> filter_idx );
+        int64_t first, row_id;
+        uint64_t count;
+        rc_t rc = VCursorIdRange( src_cursor, filter_col_def -> src_idx, &first, &count );
+        DISP_RC( rc, "vdb_copy_filter_needs_action:VCursorIdRange() failed" );
+        res = ( 0 != rc );
+        row_id = first;
+        while ( !res && row_id < first + ( int64_t )count ) {
+            const VBlob * blob;
+            rc = VCursorGetBlobDirect( src_cursor, &blob, row_id, filter_col_def -> src_idx );
+            DISP_RC( rc, "vdb_copy_filter_needs_action:VCursorGetBlobDirect() failed" );
+            if ( 0 != rc ) {
+                res = true;
+            } else {
+                int64_t blob_first;
+                uint64_t blob_count;
+                rc = VBlobIdRange( blob, &blob_first, &blob_count );
+                DISP_RC( rc, "vdb_copy_filter_needs_action:VBlobIdRange() failed" );
+                if ( 0 != rc || blob_first + ( int64_t )blob_count <= row_id ) {
+                    res = true;
+                } else {
+                    int64_t end = blob_first + ( int64_t )blob_count;
+                    if ( end > first + ( int64_t )count ) {
+                        end = first + ( int64_t )count;
+                    }
+                    res = vdb_copy_blob_needs_action( ctx, blob, row_id, end );
+                    row_id = end;
+                }
+                VBlobRelease( blob );
+            }
+        }
+    }
+    return res;
+}
+
+/* the blob-copy takes the whole table as it is: no row-ranges, no column-selection,
+   no schema-change and no filtered or redacted rows */
+static bool vdb_copy_blob_copy_usable( const p_context ctx,
+                                       const VTable * src_table,
+                                       const VCursor * src_cursor,
+                                       col_defs * columns,
+                                       bool is_legacy ) {
+    if ( !ctx -> blob_copy || is_legacy || ctx -> rows_requested ) {
+        return false;
+    }
+    if ( NULL != ctx -> columns && 0 != nlt_strcmp( ctx -> columns, "*" ) ) {
+        return false;
+    }
+    if ( NULL != ctx -> excluded_columns || !blob_copy_possible( src_table ) ) {
+        return false;
+    }
+    return !vdb_copy_filter_needs_action( ctx, src_cursor, columns );
+}
+
+static rc_t vdb_copy_table_blobs( const p_context ctx,
+                                  const VTable * src_table,
+                                  VTable * dst_table,
+                                  KCreateMode cmode,
+                                  bool is_legacy ) {
+    rc_t rc = copy_table_meta( src_table, dst_table,
+                          ctx -> config.meta_ignore_nodes,
+                          ctx -> show_meta, is_legacy );
+    if ( 0 == rc ) {
+        rc = blob_copy_table( src_table, dst_table, cmode,
+                              helper_assemble_ChecksumMode( ctx -> blob_checksum ),
+                              ctx -> show_progress );
+    }
+    if ( 0 == rc && ctx -> reindex ) {
+        rc = VTableReindex( dst_table );
+        DISP_RC( rc, "vdb_copy_table_blobs:VTableReindex() failed" );
+    }
+    return rc;
+}
+
 static rc_t vdb_copy_table2( const p_context ctx,
                              VDBManager * vdb_mgr,
                              const VTable * src_table,
@@ -781,26 +1415,30 @@ static rc_t vdb_copy_table2( const p_context ctx,
                                      src_table, src_cursor, cmode, &dst_table, columns,
                                      &is_legacy, type_matcher );
     if ( 0 == rc ) {
-        VCursor * dst_cursor;
-        rc = vdb_copy_open_dest_table( ctx, src_table, dst_table, &dst_cursor, columns, 
-                                       is_legacy );
-        if ( 0 == rc ) {
-            /* this function does not fail, because it is ok to not find
-               filter-column, redactable types and excluded columns */
-            vdb_copy_find_filter_and_redact_columns( src_schema,
-                                   columns, &(ctx->config), type_matcher );
+        if ( vdb_copy_blob_copy_usable( ctx, src_table, src_cursor, columns, is_legacy ) ) {
+            rc = vdb_copy_table_blobs( ctx, src_table, dst_table, cmode, is_legacy );
+        } else {
+            VCursor * dst_cursor;
+            rc = vdb_copy_open_dest_table( ctx, src_table, dst_table, &dst_cursor, columns, 
+                                           is_legacy );
+            if ( 0 == rc ) {
+                /* this function does not fail, because it is ok to not find
+                   filter-column, redactable types and excluded columns */
+                vdb_copy_find_filter_and_redact_columns( src_schema,
+                                       columns, &(ctx->config), type_matcher );
 
-            rc = vdb_copy_row_loop( ctx, src_cursor, dst_cursor,
-                                    columns, ctx->rvals );
+                rc = vdb_copy_row_loop( ctx, src_cursor, dst_cursor,
+                                        columns, ctx->rvals );
 
-            {
-                rc_t rc1 = VCursorRelease( dst_cursor );
-                DISP_RC( rc1, "vdb_copy_table2:VCursorRelease() failed" );
-            }
-            if ( 0 == rc && ctx -> reindex ) {
-                /* releasing the cursor is necessary for reindex */
-                rc = VTableReindex( dst_table );
-                DISP_RC( rc, "vdb_copy_table2:VTableReindex() failed" );
+                {
+                    rc_t rc1 = VCursorRelease( dst_cursor );
+                    DISP_RC( rc1, "vdb_copy_table2:VCursorRelease() failed" );
+                }
+                if ( 0 == rc && ctx -> reindex ) {
+                    /* releasing the cursor is necessary for reindex */
+                    rc = VTableReindex( dst_table );
+                    DISP_RC( rc, "vdb_copy_table2:VTableReindex() failed" );
+                }
             }
         }
         {
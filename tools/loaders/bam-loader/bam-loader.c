@@ -281,6 +281,7 @@ static
 char const * cache_size_usage[] =
 {
     "Set the cache size in MB for the temporary indices",
+    "5/8 of it is kept in memory for fragments waiting for their mates, older fragments are moved to a temp file in tmpfs",
     NULL
 };
 
@@ -132,17 +132,83 @@ namespace hashing {
     }
 }
 
+/**
+ * @brief Spot name hashes computed ahead of the filter lookup
+ *
+ * The hashes depend only on the name, so they can be computed on any thread.
+ * kind records the filter they were computed for,
+ * a filter of another kind recomputes them.
+ */
+struct spot_name_hash
+{
+    enum kind_t { e_none = 0, e_fnv_murmur, e_sha1, e_sha224, e_sha256 };
+
+    kind_t kind{e_none};            ///< Filter kind the digest was computed for
+    uint64_t name_hash{0};          ///< fnv1a of the name, used by the spot maps
+    array<uint32_t, 8> digest{};    ///< murmur (2 words) or SHA digest
+
+    static void compute(kind_t kind, const char* value, size_t sz, spot_name_hash& h)
+    {
+        h.kind = kind;
+        h.name_hash = hashing::fnv1a(value, sz);
+        switch (kind) {
+        case e_fnv_murmur: {
+            auto const murmur_hash = hashing::MurmurHash(value, sz);
+            h.digest[0] = (uint32_t)murmur_hash;
+            h.digest[1] = (uint32_t)(murmur_hash >> 32);
+            break;
+        }
+        case e_sha1:
+            hashing::SHA1((const unsigned char*)value, sz, (unsigned char*)h.digest.data());
+            break;
+        case e_sha224:
+            hashing::SHA224((const unsigned char*)value, sz, (unsigned char*)h.digest.data());
+            break;
+        case e_sha256:
+            hashing::SHA256((const unsigned char*)value, sz, (unsigned char*)h.digest.data());
+            break;
+        default:
+            break;
+        }
+    }
+};
+
 class spot_name_filter
 {
 public:
     spot_name_filter() = default;
     virtual ~spot_name_filter() = default;
 
-    virtual bool seen_before(const char* value, size_t sz) = 0;
+    bool seen_before(const char* value, size_t sz)
+    {
+        spot_name_hash h;
+        spot_name_hash::compute(kind(), value, sz, h);
+        return lookup(h);
+    }
+    /**
+     * @brief seen_before() with the hashes computed in advance
+     *
+     * Falls back to hashing the name if hash was computed for another kind of filter
+     */
+    bool seen_before(const char* value, size_t sz, const spot_name_hash& hash)
+    {
+        if (hash.kind != kind())
+            return seen_before(value, sz);
+        return lookup(hash);
+    }
+    virtual spot_name_hash::kind_t kind() const = 0;
     virtual size_t memory_used() const = 0;
     uint64_t get_name_hash() const { return m_name_hash; }
 
 protected:
+    virtual bool test_and_set(const spot_name_hash& hash) = 0;
+
+    bool lookup(const spot_name_hash& hash)
+    {
+        m_name_hash = hash.name_hash;
+        return test_and_set(hash);
+    }
+
     uint64_t m_name_hash = 0;
 };
 
@@ -155,21 +221,7 @@ public:
             hb.init();
         }
     }
-    virtual bool seen_before(const char* value, size_t sz) override
-    {
-        bool hits[4];
-        m_name_hash = hashing::fnv1a(value, sz);
-        auto murmur_hash = hashing::MurmurHash(value, sz);
-        uint32_t hash32 = m_name_hash;
-        hits[0] = (hash32 == bm::id_max || !hash_buckets[0].set_bit_conditional(hash32, true, false));
-        hash32 = (m_name_hash >> 32);
-        hits[1] = (hash32 == bm::id_max || !hash_buckets[1].set_bit_conditional(hash32, true, false));
-        hash32 = murmur_hash;
-        hits[2] = (hash32 == bm::id_max || !hash_buckets[2].set_bit_conditional(hash32, true, false));
-        hash32 = (murmur_hash >> 32);
-        hits[3] = (hash32 == bm::id_max || !hash_buckets[3].set_bit_conditional(hash32, true, false));
-        return hits[0] && hits[1] && hits[2] && hits[3];
-    }
+    spot_name_hash::kind_t kind() const override { return spot_name_hash::e_fnv_murmur; }
     size_t memory_used() const override {
         size_t memory_used = 0;
         for (const auto& hb : hash_buckets) {
@@ -180,46 +232,61 @@ public:
         return memory_used;
     }
 
+protected:
+    bool test_and_set(const spot_name_hash& hash) override
+    {
+        bool hits[4];
+        uint32_t hash32 = hash.name_hash;
+        hits[0] = (hash32 == bm::id_max || !hash_buckets[0].set_bit_conditional(hash32, true, false));
+        hash32 = (hash.name_hash >> 32);
+        hits[1] = (hash32 == bm::id_max || !hash_buckets[1].set_bit_conditional(hash32, true, false));
+        hash32 = hash.digest[0];
+        hits[2] = (hash32 == bm::id_max || !hash_buckets[2].set_bit_conditional(hash32, true, false));
+        hash32 = hash.digest[1];
+        hits[3] = (hash32 == bm::id_max || !hash_buckets[3].set_bit_conditional(hash32, true, false));
+        return hits[0] && hits[1] && hits[2] && hits[3];
+    }
+
 private:
 
     array<hashing::bvector_type, 4> hash_buckets;
 
 };
 
-template<unsigned char* ShaFunc(const unsigned char *data, size_t count, unsigned char *md_buf), int NUM_BUCKETS>
+template<spot_name_hash::kind_t KIND, int NUM_BUCKETS>
 class sha_filter : public spot_name_filter
 {
 public:
-    virtual bool seen_before(const char* value, size_t sz) override
+    spot_name_hash::kind_t kind() const override { return KIND; }
+    size_t memory_used() const override {
+        return (4294967296/8) * NUM_BUCKETS;
+    };
+
+protected:
+    bool test_and_set(const spot_name_hash& hash) override
     {
-        m_name_hash = hashing::fnv1a(value, sz);
-        ShaFunc((const unsigned char*)value, sz, (unsigned char*)m_md_buf.data());
         uint8_t hits = 0;
         for (int i = 0; i < NUM_BUCKETS; ++i) {
-            m_hits[i] = hash_buckets[i].test(m_md_buf[i]);
-            m_hits[i] ? ++hits : hash_buckets[i].set(m_md_buf[i]);
+            m_hits[i] = hash_buckets[i].test(hash.digest[i]);
+            m_hits[i] ? ++hits : hash_buckets[i].set(hash.digest[i]);
         }
         return hits == NUM_BUCKETS;
     }
-    size_t memory_used() const override {
-        return (4294967296/8) * NUM_BUCKETS;
-    };
 
 private:
-    array<uint32_t, NUM_BUCKETS> m_md_buf;
     array<bool, NUM_BUCKETS> m_hits;
     array<std::bitset<4294967296>, NUM_BUCKETS> hash_buckets;
 };
 
-class sha1_filter : public sha_filter<hashing::SHA1, 5>
+class sha1_filter : public sha_filter<spot_name_hash::e_sha1, 5>
 {
 };
 
-class sha224_filter : public sha_filter<hashing::SHA224, 7>
+class sha224_filter : public sha_filter<spot_name_hash::e_sha224, 7>
 {
 };
 
-class sha256_filter : public sha_filter<hashing::SHA256, 8>
+class sha256_filter : public sha_filter<spot_name_hash::e_sha256, 8>
 {
 };
 
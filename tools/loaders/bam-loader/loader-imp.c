@@ -238,6 +238,25 @@ struct FragmentInfo {
 
 
 
+/**
+ * @brief Per record results of the decode stage
+ *
+ * Everything here depends only on the record itself, so it is computed
+ * on the executor's workers while the bamread thread assigns the keys
+ * of the previous batch in file order
+ */
+struct decoded_rec_t
+{
+    size_t namelen{0};              ///< Read name length after GetFixedNameLength
+    string key;                     ///< Single group mode: spot key if it is not the read name
+    spot_name_hash hash;            ///< Hashes of the spot key for the name filter
+    bool has_seq{false};            ///< seq and qual are set (not a CG record)
+    bool qual_from_oq{false};       ///< Qualities are from OQ, offset already removed
+    rc_t qual_rc{0};                ///< BAM_AlignmentGetQuality2 result
+    vector<char> seq;               ///< Bases as returned by BAM_AlignmentGetSequence
+    vector<uint8_t> qual;           ///< Qualities
+};
+
 /**
  * @brief Data returned by bam_read threads
  *
@@ -247,6 +266,7 @@ struct queue_rec_t
     BAM_Alignment* alignment{nullptr};  ///< BAM Alignment
     metadata_t* metadata{nullptr};      ///< Pointer to metadata
     uint32_t row_id{0};                 ///< Corresponding metadata row
+    unique_ptr<decoded_rec_t> decoded;  ///< Decode stage results (null if not decoded)
 };
 
 struct context_t {
@@ -637,8 +657,17 @@ static rc_t GetKeyIDOld(context_t *const ctx,
     assert(!ctx->m_read_groups.empty());
     auto& rs = *ctx->m_read_groups[ctx->m_emptyGroupIndex];
     BAM_Alignment& rec = *queue_rec.alignment;
+    decoded_rec_t const *const decoded = queue_rec.decoded.get();
 
-    if (memcmp(key, name, keylen) == 0) {
+    if (decoded) {
+        // key and its hashes were computed by DecodeRecord
+        auto& r = decoded->key.empty() ? rs.find(name, namelen, &decoded->hash)
+                                       : rs.find(decoded->key.data(), decoded->key.size(), &decoded->hash);
+        rec.keyId = r.pos;
+        rec.wasInserted = r.wasInserted;
+        queue_rec.metadata = r.metadata;
+        queue_rec.row_id = r.row_id;
+    } else if (memcmp(key, name, keylen) == 0) {
         // qname starts with read group; no append
         auto& r = rs.find(name, namelen);
         rec.keyId = r.pos;
@@ -749,8 +778,9 @@ rc_t GetKeyID(context_t *const ctx,
     static size_t last_spot_count = 0;
     static int mem_prediction_err_count = 0;
     BAM_Alignment& rec = *queue_rec.alignment;
+    decoded_rec_t const *const decoded = queue_rec.decoded.get();
     size_t group_id = ctx->m_read_groups.size();
-    size_t const namelen = GetFixedNameLength(name, o_namelen);
+    size_t const namelen = decoded ? decoded->namelen : GetFixedNameLength(name, o_namelen);
     if (ctx->m_isSingleGroup) {
         GetKeyIDOld(ctx, queue_rec, key, name, namelen);
         if (++key_count % 10000000 == 0) {
@@ -771,7 +801,7 @@ rc_t GetKeyID(context_t *const ctx,
             ctx->add_read_group().m_platform = GetINSDCPlatform(bam, key);
         }
         auto& spot_assembly = *ctx->m_read_groups[group_id];
-        auto& r = spot_assembly.find(name, namelen);
+        auto& r = spot_assembly.find(name, namelen, decoded ? &decoded->hash : nullptr);
         rec.wasInserted = r.wasInserted;
         queue_rec.metadata = r.metadata;
         queue_rec.row_id = r.row_id;
@@ -949,6 +979,21 @@ static rc_t SetupContext(context_t *ctx, unsigned numfiles)
 
 static void ContextReleaseMemBank(context_t *ctx)
 {
+    if (ctx->frags) {
+        MemBankStats st;
+
+        MemBankGetStats(ctx->frags, &st);
+        spdlog::info("Fragment store: peak resident {:L}, arena {:L}, spilled {:L} in {:L} evictions, spill file {:L}, lookups {:L} ({:L} from spill file)",
+                     st.resident_peak, st.arena_bytes, st.spill_total, st.evictions, st.spill_file_bytes, st.lookups, st.spill_reads);
+        json& j = ctx->mTelemetry["fragment-store"];
+        j["resident-peak-kb"] = st.resident_peak/1024;
+        j["arena-kb"] = st.arena_bytes/1024;
+        j["spill-kb"] = st.spill_total/1024;
+        j["spill-file-kb"] = st.spill_file_bytes/1024;
+        j["evictions"] = st.evictions;
+        j["lookups"] = st.lookups;
+        j["spill-reads"] = st.spill_reads;
+    }
     MemBankRelease(ctx->frags);
     ctx->frags = NULL;
 }
@@ -1633,12 +1678,121 @@ static rc_t BAM_FileReadDetached(BAM_File const *self, BAM_Alignment **rec)
     return rc;
 }
 
-static rc_t run_bamread_thread(const KThread *self, void *const file)
+/**
+ * @brief Computes everything in queue_rec_t::decoded that depends on the record only
+ *
+ * Runs on the executor's workers, must not touch the context's mutable state
+ *
+ * @param queue_rec - record to decode
+ * @param isSingleGroup - spot keys are prefixed with the read group (see GetKeyIDOld)
+ * @param kind - kind of name filter to compute the hashes for
+ */
+static void DecodeRecord(queue_rec_t& queue_rec, bool isSingleGroup, spot_name_hash::kind_t kind)
+{
+    static char const dummy[] = "";
+    BAM_Alignment const *const rec = queue_rec.alignment;
+    auto decoded = make_unique<decoded_rec_t>();
+    char const *spotGroup;
+    char const *name;
+    size_t namelen;
+    uint32_t readlen;
+
+    BAM_AlignmentGetReadName2(rec, &name, &namelen);
+    BAM_AlignmentGetReadGroupName(rec, &spotGroup);
+    decoded->namelen = GetFixedNameLength(name, namelen);
+    if (isSingleGroup) {
+        char const *const key = spotGroup ? spotGroup : dummy;
+        size_t const keylen = strlen(key);
+
+        if (memcmp(key, name, keylen) != 0) {
+            decoded->key.reserve(keylen + 1 + decoded->namelen);
+            decoded->key.append(key, keylen).append(1, '\t').append(name, decoded->namelen);
+        }
+    }
+    if (decoded->key.empty())
+        spot_name_hash::compute(kind, name, decoded->namelen, decoded->hash);
+    else
+        spot_name_hash::compute(kind, decoded->key.data(), decoded->key.size(), decoded->hash);
+
+    if (BAM_AlignmentCGReadLength(rec, &readlen) != 0) {
+        /* CG records are left to ProcessBAM */
+        BAM_AlignmentGetReadLength(rec, &readlen);
+        decoded->seq.resize(readlen);
+        decoded->qual.resize(readlen);
+        BAM_AlignmentGetSequence(rec, decoded->seq.data());
+        if (G.useQUAL) {
+            uint8_t const *squal;
+
+            BAM_AlignmentGetQuality(rec, &squal);
+            memmove(decoded->qual.data(), squal, readlen);
+        }
+        else {
+            uint8_t const *squal;
+            uint8_t qoffset = 0;
+
+            decoded->qual_rc = BAM_AlignmentGetQuality2(rec, &squal, &qoffset);
+            if (decoded->qual_rc == 0) {
+                if (qoffset) {
+                    for (uint32_t i = 0; i != readlen; ++i)
+                        decoded->qual[i] = squal[i] - qoffset;
+                    decoded->qual_from_oq = true;
+                }
+                else
+                    memmove(decoded->qual.data(), squal, readlen);
+            }
+        }
+        decoded->has_seq = true;
+    }
+    queue_rec.decoded = std::move(decoded);
+}
+
+/**
+ * @brief Records read ahead by the bamread thread
+ *
+ * A batch is decoded on the executor while the bamread thread
+ * assigns the keys of the previous one
+ */
+struct decode_batch_t
+{
+    vector<queue_rec_t> recs;   ///< Records in file order
+    tf::Taskflow taskflow;      ///< Decode tasks
+    tf::Future<void> done;      ///< Set while the decode is running
+
+    void decode(context_t& ctx) {
+        auto const isSingleGroup = ctx.m_isSingleGroup;
+        auto const kind = ctx.m_key_filter->kind();
+
+        taskflow.clear();
+        taskflow.for_each_index(size_t(0), recs.size(), size_t(1), [this, isSingleGroup, kind](size_t i) {
+            DecodeRecord(recs[i], isSingleGroup, kind);
+        });
+        done = ctx.m_executor->run(taskflow);
+    }
+    void wait() {
+        if (done.valid())
+            done.wait();
+        done = tf::Future<void>();
+    }
+    void release() {
+        wait();
+        for (auto& r : recs)
+            BAM_AlignmentRelease(r.alignment);
+        recs.clear();
+    }
+};
+
+#define DECODE_BATCH_SIZE 1024
+
+/**
+ * @brief Reads up to DECODE_BATCH_SIZE records
+ *
+ * @param eof - set when the end of file is reached
+ * @return rc_t - rc of the failed read, the records read before it stay in the batch
+ */
+static rc_t ReadBatch(BAM_File const *bam, decode_batch_t& batch, size_t& NR, bool& eof)
 {
     rc_t rc = 0;
-    size_t NR = 0;
-    auto bam = (const BAM_File*)file;
-    while (rc == 0) {
+    while (rc == 0 && batch.recs.size() < DECODE_BATCH_SIZE) {
         if (rw_done)
             break;
         BAM_Alignment *rec = NULL;
@@ -1652,52 +1806,111 @@ static rc_t run_bamread_thread(const KThread *self, void *const file)
             /* EOF */
             rc = 0;
             --NR;
+            eof = true;
             break;
         }
         if (rc) break;
-#if defined(NEW_QUEUE)
-        queue_rec_t queue_rec;
-#else
-        queue_rec_t* queue_rec = new queue_rec_t;
-#endif
+        batch.recs.emplace_back();
+        batch.recs.back().alignment = rec;
+    }
+    return rc;
+}
+
+/**
+ * @brief Assigns the keys of a decoded batch in file order and queues the records
+ *
+ */
+static rc_t QueueBatch(BAM_File const *bam, decode_batch_t& batch)
+{
+    rc_t rc = 0;
+    size_t i = 0;
 
+    batch.wait();
+    for ( ; rc == 0 && i < batch.recs.size(); ++i) {
+        auto& rec = batch.recs[i];
         {
             static char const dummy[] = "";
             char const *spotGroup;
             char const *name;
             size_t namelen;
 
-            BAM_AlignmentGetReadName2(rec, &name, &namelen);
-            BAM_AlignmentGetReadGroupName(rec, &spotGroup);
-#if defined(NEW_QUEUE)
-            queue_rec.alignment = rec;
-            queue_rec.metadata = nullptr;
-            rc = GetKeyID(&GlobalContext, bam, queue_rec, spotGroup ? spotGroup : dummy, name, namelen);
-#else
-            queue_rec->alignment = rec;
-            queue_rec->metadata = nullptr;
-            rc = GetKeyID(&GlobalContext, bam, *queue_rec, spotGroup ? spotGroup : dummy, name, namelen);
-#endif
+            BAM_AlignmentGetReadName2(rec.alignment, &name, &namelen);
+            BAM_AlignmentGetReadGroupName(rec.alignment, &spotGroup);
+            rec.metadata = nullptr;
+            rc = GetKeyID(&GlobalContext, bam, rec, spotGroup ? spotGroup : dummy, name, namelen);
             if (rc) break;
         }
 
         for ( ; ; ) {
 #ifdef NEW_QUEUE
-            if (rw_queue.try_enqueue(std::move(queue_rec))) {
+            if (rw_queue.try_enqueue(std::move(rec))) {
+                rec.alignment = nullptr;
                 break;
             }
             if (rw_done)
                 break;
-            std::this_thread::yield();    
+            std::this_thread::yield();
 #else
-            timeout_t tm;
-            TimeoutInit(&tm, 1000);
-            rc = KQueuePush(bamq, queue_rec, &tm);
-            if (rc == 0 || (int)GetRCObject(rc) != rcTimeout)
-                break;
+            queue_rec_t* const queue_rec = new queue_rec_t(std::move(rec));
+            rec.alignment = nullptr;
+            for ( ; ; ) {
+                timeout_t tm;
+                TimeoutInit(&tm, 1000);
+                rc = KQueuePush(bamq, queue_rec, &tm);
+                if (rc == 0 || (int)GetRCObject(rc) != rcTimeout)
+                    break;
+            }
+            break;
 #endif
         }
+        if (rec.alignment != nullptr)
+            break;
+    }
+    /* records not queued on error or when the consumer has stopped */
+    for ( ; i < batch.recs.size(); ++i) {
+        if (batch.recs[i].alignment)
+            BAM_AlignmentRelease(batch.recs[i].alignment);
+    }
+    batch.recs.clear();
+    return rc;
+}
+
+/**
+ * @brief Reads, decodes and queues the records for ProcessBAM
+ *
+ * The pipeline is: read batch N on this thread, decode it on the executor,
+ * meanwhile assign the keys of batch N-1 in file order and queue it.
+ * Key assignment and everything after it stays in file order.
+ */
+static rc_t run_bamread_thread(const KThread *self, void *const file)
+{
+    rc_t rc = 0;
+    size_t NR = 0;
+    auto bam = (const BAM_File*)file;
+    rc_t read_rc = 0;
+    decode_batch_t batches[2];
+    unsigned cur = 0;
+    bool eof = false;
+
+    for ( ; ; ) {
+        auto& batch = batches[cur];
+        auto& prev = batches[1 - cur];
+
+        /* after a read error the records read before it are still queued */
+        if (!eof && read_rc == 0)
+            read_rc = ReadBatch(bam, batch, NR, eof);
+        if (!batch.recs.empty())
+            batch.decode(GlobalContext);
+        if (!prev.recs.empty())
+            rc = QueueBatch(bam, prev);
+        if (rc != 0 || rw_done || batch.recs.empty())
+            break;
+        cur = 1 - cur;
     }
+    if (rc == 0)
+        rc = read_rc;
+    batches[0].release();
+    batches[1].release();
 
 #ifndef NEW_QUEUE
     KQueueSeal(bamq);
@@ -1715,7 +1928,7 @@ static rc_t run_bamread_thread(const KThread *self, void *const file)
 
 /* call on main thread only */
 #ifdef NEW_QUEUE
-static queue_rec_t const getNextRecord(BAM_File const *const bam, rc_t *const rc)
+static queue_rec_t getNextRecord(BAM_File const *const bam, rc_t *const rc)
 #else
 static queue_rec_t* const getNextRecord(BAM_File const *const bam, rc_t *const rc)
 #endif
@@ -2008,7 +2221,13 @@ static rc_t ProcessBAM(char const bamFile[], context_t *ctx, VDatabase *db,
         bool wasPromoted = false;
         char const *barCode = NULL;
         char const *linkageGroup;
+        decoded_rec_t const *decoded;
 
+#if defined(NEW_QUEUE)
+        decoded = queue_rec.decoded.get();
+#else
+        decoded = queue_rec->decoded.get();
+#endif
         keyId = rec->keyId;
         wasInserted = rec->wasInserted;
         if (wasInserted)
@@ -2347,31 +2566,47 @@ MIXED_BASE_AND_COLOR:
             memset(seqDNA, 'N', (readlen | csSeqLen) + lpad + rpad);
             memset(qual, 0, (readlen | csSeqLen) + lpad + rpad);
 
-            BAM_AlignmentGetSequence(rec, seqDNA + lpad);
-            if (G.useQUAL) {
-                uint8_t const *squal;
-
-                BAM_AlignmentGetQuality(rec, &squal);
-                memmove(qual + lpad, squal, readlen);
-            }
-            else {
-                uint8_t const *squal;
-                uint8_t qoffset = 0;
-                unsigned i;
-
-                rc = BAM_AlignmentGetQuality2(rec, &squal, &qoffset);
+            if (decoded != nullptr && decoded->has_seq) {
+                /* decoded by the bamread thread's workers */
+                assert(decoded->seq.size() == readlen);
+                rc = decoded->qual_rc;
                 if (rc) {
                     // FATAL ERROR; DATA INCONSISTENT
                     (void)PLOGERR(klogErr, (klogErr, rc, "Spot '$(name)': length of original quality does not match sequence", "name=%s", name));
                     goto LOOP_END;
                 }
-                if (qoffset) {
-                    for (i = 0; i != readlen; ++i)
-                        qual[i + lpad] = squal[i] - qoffset;
+                memmove(seqDNA + lpad, decoded->seq.data(), readlen);
+                memmove(qual + lpad, decoded->qual.data(), readlen);
+                if (decoded->qual_from_oq)
                     QUAL_CHANGED_OQ;
-                }
-                else
+            }
+            else {
+                BAM_AlignmentGetSequence(rec, seqDNA + lpad);
+                if (G.useQUAL) {
+                    uint8_t const *squal;
+
+                    BAM_AlignmentGetQuality(rec, &squal);
                     memmove(qual + lpad, squal, readlen);
+                }
+                else {
+                    uint8_t const *squal;
+                    uint8_t qoffset = 0;
+                    unsigned i;
+
+                    rc = BAM_AlignmentGetQuality2(rec, &squal, &qoffset);
+                    if (rc) {
+                        // FATAL ERROR; DATA INCONSISTENT
+                        (void)PLOGERR(klogErr, (klogErr, rc, "Spot '$(name)': length of original quality does not match sequence", "name=%s", name));
+                        goto LOOP_END;
+                    }
+                    if (qoffset) {
+                        for (i = 0; i != readlen; ++i)
+                            qual[i + lpad] = squal[i] - qoffset;
+                        QUAL_CHANGED_OQ;
+                    }
+                    else
+                        memmove(qual + lpad, squal, readlen);
+                }
             }
             readlen = readlen + lpad + rpad;
             data.data.align_group.elements = 0;
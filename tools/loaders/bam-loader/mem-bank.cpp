@@ -161,142 +161,415 @@ rc_t MemBank_Free(MemBank *const self, uint32_t const id)
     return KMemBankFree(mbank, myId);
 }
 
+void MemBank_GetStats(MemBank const *const self, MemBankStats *const stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
 #else
 
-#include <map>
-#include <set>
+#include <kfs/file.h>
+#include <kfs/directory.h>
+#include <klib/printf.h>
+
 #include <vector>
+#include <deque>
+#include <map>
 #include <iostream>
 #include <stdexcept>
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
 
-class pmem
+/*
+ * Fragment store
+ *
+ * Fragments of spots waiting for their mates are kept in an append-only arena
+ * of 2MB chunks (huge page sized and aligned); each chunk is cut into slots
+ * of one size class, freed slots go on the free list of their class.
+ * Fragments too large for the biggest class get their own allocation.
+ *
+ * When the resident bytes go over the budget the oldest fragments are
+ * written to an unlinked temp file and their slots are released;
+ * spilled fragments are read back from the file, they are not reloaded.
+ * In the file a fragment takes the size of its class, so the ranges of
+ * freed fragments are kept per class and reused before the file grows.
+ */
+class frag_store
 {
-    struct allocation {
-        void *memory;
-        size_t size;
-        
-        allocation(int = 0) : memory(0), size(0) {}
-    };
-    typedef std::map<uint32_t, struct allocation> my_map_t;
-    typedef std::set<uint32_t> my_set_t;
-    my_map_t in_use;
-    my_set_t no_use;
-    my_map_t::size_type max_in_use;
-    my_set_t::size_type max_no_use;
-    my_map_t::size_type total_allocs;
-    my_map_t::size_type total_frees;
-    
-    void *get(uint32_t const id) const
+    static size_t const CHUNK_SIZE = 2 * 1024 * 1024;
+    static unsigned const NUM_CLASSES = 20;
+    static uint8_t const LARGE_CLASS = 0xFF;
+    static size_t const SPILL_BUFFER_SIZE = 4 * 1024 * 1024;
+
+    /* 64, 96, 128, 192, ... 32K, 48K: at most a third of a slot is wasted */
+    static size_t class_size(unsigned const cls)
     {
-        my_map_t::const_iterator const i = in_use.find(id);
-        
-        if (i == in_use.end())
-            throw std::runtime_error("attempt to access invalid id");
-        
-        return i->second.memory;
+        return (size_t)((cls & 1) ? 3 : 2) << (5 + cls / 2);
     }
-public:
-    pmem(int = 0)
-    : max_in_use(0)
-    , max_no_use(0)
-    , total_allocs(0)
-    , total_frees(0)
-    {}
-    ~pmem() {
-        my_map_t::iterator i;
-        
-        for (i = in_use.begin(); i != in_use.end(); ++i) {
-            free(i->second.memory);
-            ++total_frees;
+    static uint8_t size_class(size_t const size)
+    {
+        for (unsigned cls = 0; cls < NUM_CLASSES; ++cls) {
+            if (size <= class_size(cls))
+                return (uint8_t)cls;
+        }
+        return LARGE_CLASS;
+    }
+
+    enum state_t : uint8_t { e_free = 0, e_resident, e_spilled };
+
+    struct entry {
+        union {
+            char *memory;           ///< e_resident
+            uint64_t spill_pos;     ///< e_spilled
+        };
+        uint32_t size;
+        uint32_t generation;        ///< tells stale entries of the eviction queue apart
+        uint8_t cls;
+        state_t state;
+
+        entry() : memory(nullptr), size(0), generation(0), cls(0), state(e_free) {}
+    };
+
+    struct slab_class {
+        std::vector<char *> chunks;
+        char *next_free;            ///< intrusive list of freed slots
+        char *cur;                  ///< unused tail of the last chunk
+        char *end;
+
+        slab_class() : next_free(nullptr), cur(nullptr), end(nullptr) {}
+    };
+
+    std::vector<entry> entries;     ///< by id, 0 is not used
+    std::vector<uint32_t> free_ids;
+    std::deque<std::pair<uint32_t, uint32_t>> age;  ///< (id, generation) in allocation order
+    slab_class classes[NUM_CLASSES];
+
+    KDirectory *dir;
+    int pid;
+    KFile *spill;
+    uint64_t spill_eof;
+    std::vector<char> spill_buffer;
+    std::vector<uint64_t> spill_free[NUM_CLASSES];      ///< freed ranges of the spill file by class
+    std::multimap<uint64_t, uint64_t> spill_free_large; ///< (size, position) of freed large ranges
+
+    size_t const budget;
+    MemBankStats stats;
+
+    char *slot_alloc(uint8_t const cls)
+    {
+        if (cls == LARGE_CLASS)
+            return nullptr;
+
+        slab_class &sc = classes[cls];
+        size_t const size = class_size(cls);
+
+        if (sc.next_free) {
+            char *const slot = sc.next_free;
+            memmove(&sc.next_free, slot, sizeof(char *));
+            return slot;
         }
-#if 0
-        std::cerr << "max. used: " << max_in_use << std::endl;
-        std::cerr << "max. free: " << max_no_use << std::endl;
-        std::cerr << "num alloc: " << total_allocs << std::endl;
-        std::cerr << "num frees: " << total_frees << std::endl;
+        if (sc.cur == nullptr || sc.cur + size > sc.end) {
+            void *chunk = nullptr;
+            if (posix_memalign(&chunk, CHUNK_SIZE, CHUNK_SIZE) != 0)
+                throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+            madvise(chunk, CHUNK_SIZE, MADV_HUGEPAGE);
 #endif
+            sc.chunks.push_back(reinterpret_cast<char *>(chunk));
+            sc.cur = sc.chunks.back();
+            sc.end = sc.cur + CHUNK_SIZE;
+            stats.arena_bytes += CHUNK_SIZE;
+        }
+        char *const slot = sc.cur;
+        sc.cur += size;
+        return slot;
     }
-    
-    void Write(uint32_t id, size_t const offset, size_t const size, void const *const data) const
+    void slot_free(uint8_t const cls, char *const slot)
+    {
+        slab_class &sc = classes[cls];
+
+        memmove(slot, &sc.next_free, sizeof(char *));
+        sc.next_free = slot;
+    }
+    size_t footprint(entry const &e) const
+    {
+        return e.cls == LARGE_CLASS ? e.size : class_size(e.cls);
+    }
+    /* take a freed range of the spill file that can hold e, false if there is none */
+    bool spill_reuse(entry const &e, uint64_t *const pos)
+    {
+        if (e.cls != LARGE_CLASS) {
+            std::vector<uint64_t> &ranges = spill_free[e.cls];
+
+            if (ranges.empty())
+                return false;
+            *pos = ranges.back();
+            ranges.pop_back();
+            return true;
+        }
+        auto const i = spill_free_large.lower_bound(e.size);
+        if (i == spill_free_large.end())
+            return false;
+
+        uint64_t const size = i->first;
+        *pos = i->second;
+        spill_free_large.erase(i);
+        if (size > e.size)
+            spill_free_large.emplace(size - e.size, *pos + e.size);
+        return true;
+    }
+    void spill_release(entry const &e)
+    {
+        if (e.cls != LARGE_CLASS)
+            spill_free[e.cls].push_back(e.spill_pos);
+        else
+            spill_free_large.emplace(e.size, e.spill_pos);
+        stats.spill_bytes -= e.size;
+    }
+    void release_memory(entry &e)
+    {
+        stats.resident_bytes -= footprint(e);
+        if (e.cls == LARGE_CLASS)
+            free(e.memory);
+        else
+            slot_free(e.cls, e.memory);
+        e.memory = nullptr;
+    }
+
+    entry &get(uint32_t const id)
     {
-        if (offset + size <= this->Size(id)) {
-            char *dst = reinterpret_cast<char *>(get(id)) + offset;
-            char const *src = reinterpret_cast<char const *>(data);
-            
-            std::copy(src, src + size, dst);
+        if (id == 0 || id >= entries.size() || entries[id].state == e_free)
+            throw std::runtime_error("attempt to access invalid or freed id");
+        return entries[id];
+    }
+    entry const &get(uint32_t const id) const
+    {
+        return const_cast<frag_store *>(this)->get(id);
+    }
+
+    rc_t open_spill_file()
+    {
+        char fname[4096];
+        rc_t rc = string_printf(fname, sizeof(fname), NULL, "frag_data.%u", pid);
+
+        if (rc == 0)
+            rc = KDirectoryCreateFile(dir, &spill, true, 0600, kcmInit, "%s", fname);
+        if (rc == 0)
+            KDirectoryRemove(dir, false, "%s", fname);
+        return rc;
+    }
+    rc_t flush_spill_buffer()
+    {
+        size_t num_writ = 0;
+        rc_t const rc = KFileWriteAll(spill, spill_eof, spill_buffer.data(), spill_buffer.size(), &num_writ);
+
+        if (rc == 0 && num_writ != spill_buffer.size())
+            return RC(rcApp, rcFile, rcWriting, rcTransfer, rcIncomplete);
+        spill_eof += num_writ;
+        stats.spill_file_bytes = spill_eof;
+        spill_buffer.clear();
+        return rc;
+    }
+    /* move the oldest fragments to the spill file until resident bytes are below the low mark */
+    rc_t evict()
+    {
+        if (dir == nullptr)
+            return 0;
+
+        size_t const low_mark = budget - budget / 8;
+        rc_t rc = 0;
+
+        if (spill == nullptr && (rc = open_spill_file()) != 0)
+            return rc;
+
+        while (rc == 0 && stats.resident_bytes > low_mark && !age.empty()) {
+            auto const oldest = age.front();
+            entry &e = entries[oldest.first];
+
+            age.pop_front();
+            if (e.state != e_resident || e.generation != oldest.second)
+                continue;
+
+            uint64_t pos = 0;
+            if (spill_reuse(e, &pos)) {
+                size_t num_writ = 0;
+
+                rc = KFileWriteAll(spill, pos, e.memory, e.size, &num_writ);
+                if (rc == 0 && num_writ != e.size)
+                    rc = RC(rcApp, rcFile, rcWriting, rcTransfer, rcIncomplete);
+            }
+            else {
+                size_t const extent = footprint(e);
+
+                if (spill_buffer.size() + extent > SPILL_BUFFER_SIZE && !spill_buffer.empty())
+                    rc = flush_spill_buffer();
+                if (rc == 0) {
+                    pos = spill_eof + spill_buffer.size();
+                    spill_buffer.insert(spill_buffer.end(), e.memory, e.memory + e.size);
+                    spill_buffer.resize(spill_buffer.size() + extent - e.size);
+                }
+            }
+            if (rc == 0) {
+                release_memory(e);
+                e.spill_pos = pos;
+                e.state = e_spilled;
+                stats.spill_bytes += e.size;
+                stats.spill_total += e.size;
+                ++stats.evictions;
+            }
+        }
+        if (rc == 0 && !spill_buffer.empty())
+            rc = flush_spill_buffer();
+        return rc;
+    }
+    /* stale entries are skipped by evict(), drop them if they take over the queue */
+    void compact_age()
+    {
+        if (age.size() < 1024 || age.size() < 2 * (entries.size() - free_ids.size()))
             return;
+        std::deque<std::pair<uint32_t, uint32_t>> live;
+        for (auto const &a : age) {
+            entry const &e = entries[a.first];
+            if (e.state == e_resident && e.generation == a.second)
+                live.push_back(a);
         }
-        throw std::runtime_error("attempt to write more than was allocated");
+        age.swap(live);
     }
-    uint32_t Alloc(size_t const size, bool const clear = true)
+
+public:
+    frag_store(KDirectory *a_dir, int a_pid, size_t a_budget)
+    : dir(a_dir)
+    , pid(a_pid)
+    , spill(nullptr)
+    , spill_eof(0)
+    , budget(a_budget)
     {
-        my_map_t::key_type new_key;
-        
-        if (no_use.begin() == no_use.end()) {
-            my_map_t::size_type const new_id = in_use.size() + 1;
-
-            if (max_in_use < new_id)
-                max_in_use = new_id;
-            
-            new_key = (my_map_t::key_type)new_id;
-            if (new_key < new_id)
-                throw std::runtime_error("pmem overflow");
+        memset(&stats, 0, sizeof(stats));
+        entries.resize(1);
+        if (dir)
+            KDirectoryAddRef(dir);
+    }
+    ~frag_store()
+    {
+        for (auto &e : entries) {
+            if (e.state == e_resident && e.cls == LARGE_CLASS)
+                free(e.memory);
         }
-        else {
-            my_set_t::const_iterator const j = no_use.begin();
-            
-            new_key = *j;
-            no_use.erase(j);
+        for (auto &sc : classes) {
+            for (auto chunk : sc.chunks)
+                free(chunk);
         }
-        my_map_t::iterator const i = in_use.insert(my_map_t::value_type(new_key, 0)).first;
-        
-        void *const alloc = calloc(1, size);
-        if (alloc) {
-            i->second.memory = alloc;
-            i->second.size = size;
-            
-            ++total_allocs;
-            return i->first;
+        KFileRelease(spill);
+        KDirectoryRelease(dir);
+    }
+
+    rc_t Alloc(uint32_t *const id, size_t const size, bool const clear)
+    {
+        rc_t rc = 0;
+
+        if (size > UINT32_MAX)
+            return RC(rcApp, rcFile, rcAllocating, rcParam, rcExcessive);
+        if (stats.resident_bytes + size > budget && (rc = evict()) != 0)
+            return rc;
+
+        uint8_t const cls = size_class(size);
+        char *const memory = cls == LARGE_CLASS ? reinterpret_cast<char *>(malloc(size)) : slot_alloc(cls);
+        if (memory == nullptr)
+            throw std::bad_alloc();
+        if (clear)
+            memset(memory, 0, size);
+
+        uint32_t new_id;
+        if (free_ids.empty()) {
+            if (entries.size() > UINT32_MAX)
+                throw std::runtime_error("fragment store id space overflow");
+            new_id = (uint32_t)entries.size();
+            entries.emplace_back();
+        }
+        else {
+            new_id = free_ids.back();
+            free_ids.pop_back();
         }
-        throw std::bad_alloc();
+        entry &e = entries[new_id];
+        e.memory = memory;
+        e.size = (uint32_t)size;
+        e.cls = cls;
+        e.state = e_resident;
+        ++e.generation;
+        age.emplace_back(new_id, e.generation);
+        compact_age();
+
+        stats.resident_bytes += footprint(e);
+        stats.resident_peak = std::max(stats.resident_peak, stats.resident_bytes);
+        ++stats.allocs;
+        *id = new_id;
+        return 0;
     }
-    void Free(uint32_t const id)
+    rc_t Write(uint32_t const id, uint64_t const pos, void const *const buffer, size_t const bsize, size_t *const num_writ)
     {
-        my_map_t::iterator const i = in_use.find(id);
-        
-        if (i == in_use.end())
-            throw std::runtime_error("attempt to free invalid id");
-        
-        void *const alloc = i->second.memory;
+        entry &e = get(id);
 
-        no_use.insert(id);
-        if (max_no_use < no_use.size())
-            max_no_use = no_use.size();
+        *num_writ = 0;
+        if (pos >= e.size)
+            return 0;
 
-        in_use.erase(i);
-        free(alloc);
-        ++total_frees;
+        size_t const actsize = std::min<size_t>(bsize, e.size - pos);
+        if (e.state == e_resident) {
+            memmove(e.memory + pos, buffer, actsize);
+            *num_writ = actsize;
+            return 0;
+        }
+        return KFileWriteAll(spill, e.spill_pos + pos, buffer, actsize, num_writ);
     }
-    size_t Size(uint32_t const id) const
+    size_t Size(uint32_t const id)
     {
-        my_map_t::const_iterator const i = in_use.find(id);
-        
-        if (i == in_use.end())
-            throw std::runtime_error("attempt to access invalid or freed id");
-        
-        return i->second.size;
+        ++stats.lookups;
+        return get(id).size;
     }
-    void const *Read(uint32_t const id) const
+    rc_t Read(uint32_t const id, uint64_t const pos, void *const buffer, size_t const bsize, size_t *const num_read)
     {
-        return get(id);
+        entry const &e = get(id);
+
+        ++stats.lookups;
+        *num_read = 0;
+        if (pos >= e.size)
+            return 0;
+
+        size_t const actsize = std::min<size_t>(bsize, e.size - pos);
+        if (e.state == e_resident) {
+            memmove(buffer, e.memory + pos, actsize);
+            *num_read = actsize;
+            return 0;
+        }
+        ++stats.spill_reads;
+        return KFileReadAll(spill, e.spill_pos + pos, buffer, actsize, num_read);
+    }
+    void Free(uint32_t const id)
+    {
+        entry &e = get(id);
+
+        if (e.state == e_resident)
+            release_memory(e);
+        else
+            spill_release(e);
+        e.state = e_free;
+        e.size = 0;
+        free_ids.push_back(id);
+        ++stats.frees;
+    }
+    void GetStats(MemBankStats *const rslt) const
+    {
+        *rslt = stats;
     }
 };
 
-rc_t MemBank_Make(MemBank **bank, struct KDirectory * = 0, int = 0, size_t const * = 0)
+rc_t MemBank_Make(MemBank **bank, struct KDirectory *dir = 0, int pid = 0, size_t const *climits = 0)
 {
     try {
-        pmem *const rslt = new pmem;
+        size_t const budget = climits ? climits[0] + climits[1] : SIZE_MAX;
+        frag_store *const rslt = new frag_store(dir, pid, budget);
         
         *bank = reinterpret_cast<MemBank *>(rslt);
         return 0;
@@ -316,16 +589,15 @@ rc_t MemBank_Make(MemBank **bank, struct KDirectory * = 0, int = 0, size_t const
 
 void MemBank_Release(MemBank *const self)
 {
-    delete reinterpret_cast<pmem *>(self);
+    delete reinterpret_cast<frag_store *>(self);
 }
 
 rc_t MemBank_Alloc(MemBank *const Self, uint32_t *const id, size_t const bytes, bool const clear, bool const longlived)
 {
     try {
-        pmem *const self = reinterpret_cast<pmem *>(Self);
+        frag_store *const self = reinterpret_cast<frag_store *>(Self);
         
-        *id = self->Alloc(bytes, clear);
-        return 0;
+        return self->Alloc(id, bytes, clear);
     }
     catch (std::bad_alloc const &e) {
         return RC(rcApp, rcFile, rcAllocating, rcMemory, rcExhausted);
@@ -343,21 +615,9 @@ rc_t MemBank_Alloc(MemBank *const Self, uint32_t *const id, size_t const bytes,
 rc_t MemBank_Write(MemBank *const Self, uint32_t const id, uint64_t const pos, void const *const buffer, size_t const bsize, size_t *const num_writ)
 {
     try {
-        pmem *const self = reinterpret_cast<pmem *>(Self);
-        
-        *num_writ = 0;
-
-        size_t const size = self->Size((uint32_t)id);
-        
-        if (pos >= size)
-            return 0;
-        
-        size_t const actsize = (bsize + pos > size) ? (size - pos) : size;
-        
-        *num_writ = actsize;
-        self->Write(id, pos, actsize, buffer);
+        frag_store *const self = reinterpret_cast<frag_store *>(Self);
         
-        return 0;
+        return self->Write(id, pos, buffer, bsize, num_writ);
     }
     catch (std::exception const &e) {
         std::cerr << e.what() << std::endl;
@@ -372,7 +632,8 @@ rc_t MemBank_Write(MemBank *const Self, uint32_t const id, uint64_t const pos, v
 rc_t MemBank_Size(MemBank const *const Self, uint32_t const id, size_t *const size)
 {
     try {
-        pmem const *const self = reinterpret_cast<pmem const *>(Self);
+        /* lookups are counted */
+        frag_store *const self = reinterpret_cast<frag_store *>(const_cast<MemBank *>(Self));
         
         *size = self->Size(id);
         return 0;
@@ -390,24 +651,9 @@ rc_t MemBank_Size(MemBank const *const Self, uint32_t const id, size_t *const si
 rc_t MemBank_Read(MemBank const *const Self, uint32_t const id, uint64_t const pos, void *const buffer, size_t const bsize, size_t *const num_read)
 {
     try {
-        pmem const *const self = reinterpret_cast<pmem const *>(Self);
-        
-        *num_read = 0;
-        
-        size_t const size = self->Size(id);
-        char const *data = reinterpret_cast<char const *>(self->Read(id)) + pos;
-        
-        if (pos >= size)
-            return 0;
-        
-        size_t const actsize = (bsize + pos > size) ? (size - pos) : size;
-        
-        *num_read = actsize;
+        frag_store *const self = reinterpret_cast<frag_store *>(const_cast<MemBank *>(Self));
         
-        char *dst = reinterpret_cast<char *>(buffer);
-        std::copy(data, data + actsize, dst);
-        
-        return 0;
+        return self->Read(id, pos, buffer, bsize, num_read);
     }
     catch (std::exception const &e) {
         std::cerr << e.what() << std::endl;
@@ -422,7 +668,7 @@ rc_t MemBank_Read(MemBank const *const Self, uint32_t const id, uint64_t const p
 rc_t MemBank_Free(MemBank *const Self, uint32_t const id)
 {
     try {
-        pmem *const self = reinterpret_cast<pmem *>(Self);
+        frag_store *const self = reinterpret_cast<frag_store *>(Self);
         
         self->Free(id);
         return 0;
@@ -436,6 +682,11 @@ rc_t MemBank_Free(MemBank *const Self, uint32_t const id)
         abort();
     }
 }
+
+void MemBank_GetStats(MemBank const *const Self, MemBankStats *const stats)
+{
+    reinterpret_cast<frag_store const *>(Self)->GetStats(stats);
+}
 #endif
 
 extern "C" {
@@ -473,5 +724,10 @@ extern "C" {
     {
         return MemBank_Free(Self, id);
     }
+
+    void MemBankGetStats(MemBank const *const Self, MemBankStats *const stats)
+    {
+        MemBank_GetStats(Self, stats);
+    }
 }
 
@@ -26,6 +26,9 @@
 
 typedef struct MemBank MemBank;
 
+/* climits: fragments kept in memory are limited to climits[0] + climits[1] bytes,
+ * older fragments are spilled to a temp file in dir */
+
 rc_t MemBankMake(MemBank **rslt, struct KDirectory *dir, int pid, size_t const climits[2]);
 
 void MemBankRelease(MemBank *self);
@@ -39,3 +42,19 @@ rc_t MemBankSize(MemBank const *self, uint32_t id, size_t *rslt);
 rc_t MemBankRead(MemBank const *self, uint32_t id, uint64_t pos, void *buffer, size_t bsize, size_t *num_read);
 
 rc_t MemBankFree(MemBank *self, uint32_t id);
+
+typedef struct MemBankStats {
+    uint64_t resident_bytes;    /* memory held by fragments */
+    uint64_t resident_peak;
+    uint64_t arena_bytes;       /* memory reserved for fragment slots */
+    uint64_t spill_bytes;       /* bytes of fragments in the spill file */
+    uint64_t spill_total;       /* bytes ever written to the spill file */
+    uint64_t spill_file_bytes;  /* size of the spill file, freed ranges are reused */
+    uint64_t evictions;
+    uint64_t allocs;
+    uint64_t frees;
+    uint64_t lookups;           /* MemBankSize and MemBankRead calls */
+    uint64_t spill_reads;       /* MemBankRead calls served from the spill file */
+} MemBankStats;
+
+void MemBankGetStats(MemBank const *self, MemBankStats *stats);
@@ -278,9 +278,10 @@ struct spot_assembly
      * 
      * @param name 
      * @param namelen 
+     * @param hash - name hashes computed in advance (optional)
      * @return const spot_rec_t& 
      */
-    const spot_rec_t& find(const char* name, int namelen);
+    const spot_rec_t& find(const char* name, int namelen, const spot_name_hash* hash = nullptr);
 
     /**
      * @brief Applies F to all metadata in the group
@@ -500,7 +501,7 @@ spot_assembly::~spot_assembly()
     });
 }
 
-const spot_assembly::spot_rec_t& spot_assembly::find(const char* name, int namelen) 
+const spot_assembly::spot_rec_t& spot_assembly::find(const char* name, int namelen, const spot_name_hash* hash) 
 {
 #if defined (COLLECT_STATS)    
     static size_t count = 0;
@@ -510,7 +511,8 @@ const spot_assembly::spot_rec_t& spot_assembly::find(const char* name, int namel
     static size_t batch_found = 0;
 #endif    
     m_rec.wasInserted = true;
-    if (m_key_filter->seen_before(name, namelen)) {
+    bool const seen = hash ? m_key_filter->seen_before(name, namelen, *hash) : m_key_filter->seen_before(name, namelen);
+    if (seen) {
         auto it = m_spot_map->find_ks(name, namelen, m_key_filter->get_name_hash());
 
         if (it != m_spot_map->end()) {
@@ -42,6 +42,11 @@
 #include <klib/printf.h> /* string_printf */
 #include <klib/status.h> /* STSMSG */
 
+#include <kproc/lock.h> /* KLock */
+#include <kproc/queue.h> /* KQueue */
+#include <kproc/thread.h> /* KThread */
+#include <kproc/timeout.h> /* TimeoutInit */
+
 #include <vdb/schema.h> /* VDBManagerMakeSchema */
 
 #include <loader/loader-meta.h> /* KLoaderMeta_Write */
@@ -80,6 +85,7 @@ typedef struct SParam_struct
     uint32_t single_mate;
     uint32_t cluster_size;
     uint32_t load_other_evidence;
+    uint32_t parse_threads;
 
     uint32_t read_len;
 } SParam;
@@ -343,6 +349,8 @@ typedef struct FGroupMAP_struct {
     const CGLoaderFile* seq;
     const CGLoaderFile* align;
     const CGLoaderFile* tagLfr;
+    /* SEQUENCE row of the group's first spot, set by the writer */
+    int64_t start_rowid;
 } FGroupMAP;
 
 static
@@ -413,10 +421,9 @@ bool CC FGroupMAP_FindRowId( BSTNode *node, void *data )
     FGroupMAP_FindData* d = (FGroupMAP_FindData*)data;
     const FGroupMAP* n = (const FGroupMAP*)node;
 
-    if( FGroupMAP_Cmp(&d->key, node) == 0 ) {
-        if( CGLoaderFile_GetStartRow(n->seq, &d->rowid) == 0 ) {
-            return true;
-        }
+    if( FGroupMAP_Cmp(&d->key, node) == 0 && n->start_rowid != 0 ) {
+        d->rowid = n->start_rowid;
+        return true;
     }
     return false;
 }
@@ -626,57 +633,84 @@ typedef enum {
     eCtxLfr,
     eCtxMapping
 } TCtx;
-static bool _FGroupMAPDone(FGroupMAP *self, TCtx ctx, FGroupMAP_LoadData* d) {
+static bool _FGroupMAPDone(FGroupMAP *self, TCtx ctx, rc_t* rc) {
     /* (rcData rcDone) is always set on reads file EOF */
     bool eofLfr = true;
     bool eofMapping = true;
-    assert(self && d);
-    if (d->rc == 0 ||
-        GetRCState(d->rc) != rcDone || GetRCObject(d->rc) != (enum RCObject)rcData)
+    assert(self && rc);
+    if (*rc == 0 ||
+        GetRCState(*rc) != rcDone || GetRCObject(*rc) != (enum RCObject)rcData)
     {
         return false;
     }
-    d->rc = 0;
-    if (d->rc == 0 && self->tagLfr != NULL) {
-        d->rc = CGLoaderFile_IsEof(self->tagLfr, &eofLfr);
+    *rc = 0;
+    if (*rc == 0 && self->tagLfr != NULL) {
+        *rc = CGLoaderFile_IsEof(self->tagLfr, &eofLfr);
     }
-    if (d->rc == 0 && self->align != NULL) {
-        d->rc = CGLoaderFile_IsEof(self->align, &eofMapping);
+    if (*rc == 0 && self->align != NULL) {
+        *rc = CGLoaderFile_IsEof(self->align, &eofMapping);
     }
-    if (d->rc == 0) {
+    if (*rc == 0) {
         switch (ctx) {
             case eCtxRead:
                 if (!eofLfr) {
                     /* not EOF */
-                    d->rc = RC(rcExe, rcFile, rcReading, rcData, rcUnexpected);
-                    CGLoaderFile_LOG(self->align, klogErr, d->rc,
+                    *rc = RC(rcExe, rcFile, rcReading, rcData, rcUnexpected);
+                    CGLoaderFile_LOG(self->align, klogErr, *rc,
                         "extra tag LFRs, possible that corresponding "
                         "reads file is truncated", NULL);
                 }
                 else if (!eofMapping) {
                     /* not EOF */
-                    d->rc = RC(rcExe, rcFile, rcReading, rcData, rcUnexpected);
-                    CGLoaderFile_LOG(self->align, klogErr, d->rc,
+                    *rc = RC(rcExe, rcFile, rcReading, rcData, rcUnexpected);
+                    CGLoaderFile_LOG(self->align, klogErr, *rc,
                         "extra mappings, possible that corresponding "
                         "reads file is truncated", NULL);
                 }
                 break;
             case eCtxLfr:
             case eCtxMapping:
-                d->rc = RC(rcExe, rcFile, rcReading, rcCondition, rcInvalid);
+                *rc = RC(rcExe, rcFile, rcReading, rcCondition, rcInvalid);
                 break;
             default:
                 assert(0);
                 break;
         }
     }
-    if (d->rc == 0) {
+    if (*rc == 0) {
         /* mappings and lfr file EOF detected ok */
         DEBUG_MSG(5, (" done\n", FGroupKey_Validate(&self->key)));
     }
     return true;
 }
 
+/* parses the next spot of the group into reads and mappings */
+static rc_t FGroupMAP_GetSpot(FGroupMAP* n, TReadsData* reads, TMappingsData* mappings, TCtx* ctx)
+{
+    rc_t rc;
+
+    *ctx = eCtxRead;
+    rc = CGLoaderFile_GetRead(n->seq, reads);
+    if (rc == 0 && n->tagLfr != NULL) {
+        *ctx = eCtxLfr;
+        rc = CGLoaderFile_GetTagLfr(n->tagLfr, reads);
+    }
+    if (rc == 0) {
+        if ((reads->flags
+               & (cg_eLeftHalfDnbNoMatches | cg_eLeftHalfDnbMapOverflow))
+            &&
+            (reads->flags
+               & (cg_eRightHalfDnbNoMatches | cg_eRightHalfDnbMapOverflow)))
+        {
+            mappings->map_qty = 0;
+        } else {
+            *ctx = eCtxMapping;
+            rc = CGLoaderFile_GetMapping(n->align, mappings);
+        }
+    }
+    return rc;
+}
+
 bool CC FGroupMAP_LoadReads( BSTNode *node, void *data )
 {
     TCtx ctx = eCtxRead;
@@ -686,33 +720,16 @@ bool CC FGroupMAP_LoadReads( BSTNode *node, void *data )
     bool done = false;
 
     DEBUG_MSG(5, (" started\n", FGroupKey_Validate(&n->key)));
+    n->start_rowid = d->db.reads->rowid;
     while (!done && d->rc == 0) {
-        ctx = eCtxRead;
-        d->rc = CGLoaderFile_GetRead(n->seq, d->db.reads);
-        if (d->rc == 0 && n->tagLfr != NULL) {
-            ctx = eCtxLfr;
-            d->rc = CGLoaderFile_GetTagLfr(n->tagLfr, d->db.reads);
-        }
-        if (d->rc == 0) {
-            if ((d->db.reads->flags
-                   & (cg_eLeftHalfDnbNoMatches | cg_eLeftHalfDnbMapOverflow))
-                &&
-                (d->db.reads->flags
-                   & (cg_eRightHalfDnbNoMatches | cg_eRightHalfDnbMapOverflow)))
-            {
-                d->db.mappings->map_qty = 0;
-            } else {
-                ctx = eCtxMapping;
-                d->rc = CGLoaderFile_GetMapping(n->align, d->db.mappings);
-            }
+        d->rc = FGroupMAP_GetSpot(n, d->db.reads, d->db.mappings, &ctx);
 /* alignment written 1st than sequence -> primary_alignment_id must be set!! */
-            if (d->rc == 0 &&
-                (d->rc = CGWriterAlgn_Write(d->db.walgn, d->db.reads)) == 0)
-            {
-                d->rc = CGWriterSeq_Write(d->db.wseq);
-            }
+        if (d->rc == 0 &&
+            (d->rc = CGWriterAlgn_Write(d->db.walgn, d->db.reads)) == 0)
+        {
+            d->rc = CGWriterSeq_Write(d->db.wseq);
         }
-        done = _FGroupMAPDone(n, ctx, d);
+        done = _FGroupMAPDone(n, ctx, &d->rc);
         d->rc = d->rc ? d->rc : Quitting();
     }
     if( d->rc != 0 ) {
@@ -724,6 +741,405 @@ bool CC FGroupMAP_LoadReads( BSTNode *node, void *data )
     return d->rc != 0;
 }
 
+/*--------------------------------------------------------------------------
+ * ReadsParser
+ *  parses whole MAP file groups on a pool of threads, ahead of the writer;
+ *  each group gets its own bounded queue of spot batches, the writer (the
+ *  calling thread) drains the queues strictly in tree order, so SEQUENCE and
+ *  alignment row ids come out as with the sequential load
+ */
+#define PARSE_BATCH_SPOTS ( 4 * 1024 )
+#define PARSE_QUEUE_CAPACITY ( 4 )
+
+typedef struct ParsedSpot_struct {
+    uint32_t reads_format;
+    uint16_t flags;
+    uint16_t map_qty;
+    uint32_t map_first;
+    uint32_t spot_len;
+    uint32_t sequence_len;
+    uint32_t quality_len;
+    uint32_t spot_group;
+    uint32_t spot_group_len;
+    char read[CG_READS15_SPOT_LEN + 1];
+    char qual[CG_READS15_SPOT_LEN + 1];
+} ParsedSpot;
+
+typedef struct ParsedBatch_struct {
+    rc_t rc;
+    bool last; /* the group is done, rc is its final status */
+    uint32_t qty;
+    ParsedSpot spot[PARSE_BATCH_SPOTS];
+
+    TMappingsData_map* map;
+    uint32_t map_qty;
+    uint32_t map_max;
+
+    char* spot_groups;
+    uint32_t spot_groups_size;
+    uint32_t spot_groups_max;
+} ParsedBatch;
+
+static
+void ParsedBatch_Whack(ParsedBatch* self)
+{
+    if( self != NULL ) {
+        free(self->map);
+        free(self->spot_groups);
+        free(self);
+    }
+}
+
+static
+rc_t ParsedBatch_Add(ParsedBatch* self, const TReadsData* reads, const TMappingsData* mappings)
+{
+    ParsedSpot* s = &self->spot[self->qty];
+    const char* sg = reads->seq.spot_group.buffer;
+    uint32_t sg_len = sg != NULL ? (uint32_t)reads->seq.spot_group.elements : 0;
+
+    if( self->map_qty + mappings->map_qty > self->map_max ) {
+        uint32_t max = self->map_max ? self->map_max * 2 : PARSE_BATCH_SPOTS;
+        void* p;
+        while( max < self->map_qty + mappings->map_qty ) {
+            max *= 2;
+        }
+        if( (p = realloc(self->map, max * sizeof(*self->map))) == NULL ) {
+            return RC(rcExe, rcBuffer, rcAllocating, rcMemory, rcExhausted);
+        }
+        self->map = p;
+        self->map_max = max;
+    }
+    /* the spot group only changes between files or with the LFR well */
+    if( self->qty == 0 || sg_len != s[-1].spot_group_len ||
+        memcmp(&self->spot_groups[s[-1].spot_group], sg, sg_len) != 0 )
+    {
+        if( self->spot_groups_size + sg_len > self->spot_groups_max ) {
+            uint32_t max = self->spot_groups_max ? self->spot_groups_max * 2 : 1024;
+            void* p;
+            while( max < self->spot_groups_size + sg_len ) {
+                max *= 2;
+            }
+            if( (p = realloc(self->spot_groups, max)) == NULL ) {
+                return RC(rcExe, rcBuffer, rcAllocating, rcMemory, rcExhausted);
+            }
+            self->spot_groups = p;
+            self->spot_groups_max = max;
+        }
+        if( sg_len > 0 ) {
+            memmove(&self->spot_groups[self->spot_groups_size], sg, sg_len);
+        }
+        s->spot_group = self->spot_groups_size;
+        self->spot_groups_size += sg_len;
+    } else {
+        s->spot_group = s[-1].spot_group;
+    }
+    s->spot_group_len = sg_len;
+
+    s->reads_format = reads->reads_format;
+    s->flags = reads->flags;
+    s->spot_len = (uint32_t)reads->seq.spot_len;
+    s->sequence_len = (uint32_t)reads->seq.sequence.elements;
+    s->quality_len = (uint32_t)reads->seq.quality.elements;
+    memmove(s->read, reads->read, sizeof(s->read));
+    memmove(s->qual, reads->qual, sizeof(s->qual));
+
+    s->map_qty = mappings->map_qty;
+    s->map_first = self->map_qty;
+    if( mappings->map_qty > 0 ) {
+        memmove(&self->map[self->map_qty], mappings->map, mappings->map_qty * sizeof(*self->map));
+        self->map_qty += mappings->map_qty;
+    }
+
+    self->qty++;
+    return 0;
+}
+
+/* puts the i-th spot of the batch where the writers expect it */
+static
+void ParsedBatch_Get(const ParsedBatch* self, uint32_t i, TReadsData* reads, TMappingsData* mappings)
+{
+    const ParsedSpot* s = &self->spot[i];
+
+    reads->reads_format = s->reads_format;
+    reads->flags = s->flags;
+    reads->seq.spot_len = s->spot_len;
+    reads->seq.sequence.elements = s->sequence_len;
+    reads->seq.quality.elements = s->quality_len;
+    memmove(reads->read, s->read, sizeof(reads->read));
+    memmove(reads->qual, s->qual, sizeof(reads->qual));
+    /* clear cache, set in alignment writer */
+    reads->reverse[0] = '\0';
+    reads->reverse[s->spot_len / 2] = '\0';
+    reads->seq.spot_group.buffer = &self->spot_groups[s->spot_group];
+    reads->seq.spot_group.elements = s->spot_group_len;
+
+    mappings->map_qty = s->map_qty;
+    if( s->map_qty > 0 ) {
+        memmove(mappings->map, &self->map[s->map_first], s->map_qty * sizeof(*self->map));
+    }
+}
+
+typedef struct ReadsParser_struct {
+    FGroupMAP** group; /* in tree order */
+    KQueue** que;      /* one per group */
+    uint32_t qty;
+    uint32_t next;     /* next group to be parsed */
+    bool cancel;
+    KLock* lock;
+    KThread** th;
+    uint32_t threads;
+} ReadsParser;
+
+static
+void CC FGroupMAP_Count( BSTNode *node, void *data )
+{
+    ++*(uint32_t*)data;
+}
+
+static
+void CC ReadsParser_Collect( BSTNode *node, void *data )
+{
+    ReadsParser* self = (ReadsParser*)data;
+    self->group[self->qty++] = (FGroupMAP*)node;
+}
+
+static
+rc_t ReadsParser_Push(KQueue* que, ParsedBatch* b)
+{
+    rc_t rc;
+    for( ; ; ) {
+        timeout_t tm;
+        TimeoutInit(&tm, 10000);
+        rc = KQueuePush(que, b, &tm);
+        if( rc == 0 || (int)GetRCObject(rc) != rcTimeout || Quitting() != 0 ) {
+            break;
+        }
+    }
+    return rc;
+}
+
+/* parses one group into its queue; returns non-zero only if the writer went away */
+static
+rc_t ReadsParser_ParseGroup(ReadsParser* self, uint32_t g, TReadsData* reads, TMappingsData* mappings)
+{
+    FGroupMAP* n = self->group[g];
+    KQueue* que = self->que[g];
+    ParsedBatch* b = NULL;
+    rc_t rc = 0, prc = 0;
+    bool done = false;
+    TCtx ctx = eCtxRead;
+
+    DEBUG_MSG(5, (" parsing\n", FGroupKey_Validate(&n->key)));
+    while( !done && rc == 0 && prc == 0 ) {
+        if( b == NULL && (b = calloc(1, sizeof(*b))) == NULL ) {
+            rc = RC(rcExe, rcBuffer, rcAllocating, rcMemory, rcExhausted);
+            break;
+        }
+        rc = FGroupMAP_GetSpot(n, reads, mappings, &ctx);
+        if( rc == 0 ) {
+            rc = ParsedBatch_Add(b, reads, mappings);
+        }
+        done = _FGroupMAPDone(n, ctx, &rc);
+        rc = rc ? rc : Quitting();
+        if( rc == 0 && !done && b->qty == PARSE_BATCH_SPOTS ) {
+            if( (prc = ReadsParser_Push(que, b)) == 0 ) {
+                b = NULL;
+            }
+        }
+    }
+    if( rc != 0 ) {
+        CGLoaderFile_LOG(n->seq, klogErr, rc, NULL, NULL);
+        CGLoaderFile_LOG(n->align, klogErr, rc, NULL, NULL);
+    }
+    if( prc == 0 && b != NULL ) {
+        b->rc = rc;
+        b->last = true;
+        if( (prc = ReadsParser_Push(que, b)) == 0 ) {
+            b = NULL;
+        }
+    }
+    ParsedBatch_Whack(b);
+    KQueueSeal(que);
+    FGroupMAP_CloseFiles(n);
+    return prc;
+}
+
+static
+rc_t CC ReadsParser_Thread(const KThread* th, void* data)
+{
+    ReadsParser* self = (ReadsParser*)data;
+    TReadsData* reads = calloc(1, sizeof(*reads));
+    TMappingsData* mappings = calloc(1, sizeof(*mappings));
+    rc_t rc = 0;
+
+    if( reads == NULL || mappings == NULL ) {
+        rc = RC(rcExe, rcThread, rcExecuting, rcMemory, rcExhausted);
+        LOGERR(klogErr, rc, "failed to allocate parser buffers");
+    }
+    while( rc == 0 ) {
+        uint32_t g;
+        bool cancel;
+
+        if( (rc = KLockAcquire(self->lock)) != 0 ) {
+            break;
+        }
+        g = self->next++;
+        cancel = self->cancel;
+        KLockUnlock(self->lock);
+        if( cancel || g >= self->qty ) {
+            break;
+        }
+        if( ReadsParser_ParseGroup(self, g, reads, mappings) != 0 ) {
+            /* writer stopped */
+            break;
+        }
+    }
+    free(reads);
+    free(mappings);
+    return rc;
+}
+
+static
+rc_t ReadsParser_Make(ReadsParser* self, const BSTree* reads, uint32_t threads)
+{
+    rc_t rc = 0;
+    uint32_t qty = 0, i;
+
+    memset(self, 0, sizeof(*self));
+    BSTreeForEach(reads, false, FGroupMAP_Count, &qty);
+    if( threads > qty ) {
+        threads = qty;
+    }
+    self->group = calloc(qty + 1, sizeof(*self->group));
+    self->que = calloc(qty + 1, sizeof(*self->que));
+    self->th = calloc(threads + 1, sizeof(*self->th));
+    if( self->group == NULL || self->que == NULL || self->th == NULL ) {
+        return RC(rcExe, rcThread, rcCreating, rcMemory, rcExhausted);
+    }
+    BSTreeForEach(reads, false, ReadsParser_Collect, self);
+    for( i = 0; rc == 0 && i < qty; i++ ) {
+        rc = KQueueMake(&self->que[i], PARSE_QUEUE_CAPACITY);
+    }
+    if( rc == 0 ) {
+        rc = KLockMake(&self->lock);
+    }
+    for( i = 0; rc == 0 && i < threads; i++ ) {
+        if( (rc = KThreadMake(&self->th[i], ReadsParser_Thread, self)) == 0 ) {
+            self->threads++;
+        }
+    }
+    if( rc != 0 ) {
+        LOGERR(klogErr, rc, "failed to start MAP parser threads");
+    }
+    return rc;
+}
+
+/* stops the parsers, drops whatever they parsed ahead */
+static
+void ReadsParser_Whack(ReadsParser* self)
+{
+    uint32_t i;
+
+    if( self->lock != NULL && KLockAcquire(self->lock) == 0 ) {
+        self->cancel = true;
+        KLockUnlock(self->lock);
+    }
+    for( i = 0; i < self->qty; i++ ) {
+        if( self->que[i] != NULL ) {
+            KQueueSeal(self->que[i]);
+        }
+    }
+    for( i = 0; i < self->qty; i++ ) {
+        void* b = NULL;
+        timeout_t tm;
+
+        TimeoutInit(&tm, 0);
+        while( self->que[i] != NULL && KQueuePop(self->que[i], &b, &tm) == 0 ) {
+            ParsedBatch_Whack(b);
+        }
+    }
+    for( i = 0; i < self->threads; i++ ) {
+        KThreadWait(self->th[i], NULL);
+        KThreadRelease(self->th[i]);
+    }
+    for( i = 0; i < self->qty; i++ ) {
+        void* b = NULL;
+        timeout_t tm;
+
+        TimeoutInit(&tm, 0);
+        while( self->que[i] != NULL && KQueuePop(self->que[i], &b, &tm) == 0 ) {
+            ParsedBatch_Whack(b);
+        }
+        KQueueRelease(self->que[i]);
+    }
+    KLockRelease(self->lock);
+    free(self->group);
+    free(self->que);
+    free(self->th);
+}
+
+static
+rc_t ReadsParser_Pop(KQueue* que, ParsedBatch** b)
+{
+    rc_t rc;
+    for( ; ; ) {
+        timeout_t tm;
+        TimeoutInit(&tm, 10000);
+        rc = KQueuePop(que, (void**)b, &tm);
+        if( rc == 0 || (int)GetRCObject(rc) != rcTimeout || Quitting() != 0 ) {
+            break;
+        }
+    }
+    return rc;
+}
+
+/* the single writer: takes the parsed groups in tree order */
+static
+rc_t FGroupMAP_LoadReadsParallel( const BSTree* reads, FGroupMAP_LoadData* d )
+{
+    ReadsParser p;
+    uint32_t g;
+
+    d->rc = ReadsParser_Make(&p, reads, d->param->parse_threads);
+    for( g = 0; d->rc == 0 && g < p.qty; g++ ) {
+        FGroupMAP* n = p.group[g];
+        bool last = false;
+
+        DEBUG_MSG(5, (" started\n", FGroupKey_Validate(&n->key)));
+        n->start_rowid = d->db.reads->rowid;
+        while( d->rc == 0 && !last ) {
+            ParsedBatch* b = NULL;
+            uint32_t i;
+
+            if( (d->rc = ReadsParser_Pop(p.que[g], &b)) != 0 ) {
+                if( GetRCState(d->rc) == rcDone && GetRCObject(d->rc) == (enum RCObject)rcData ) {
+                    /* sealed without a last batch: the parser failed and told so */
+                    d->rc = RC(rcExe, rcFile, rcReading, rcData, rcIncomplete);
+                }
+                break;
+            }
+            for( i = 0; d->rc == 0 && i < b->qty; i++ ) {
+                ParsedBatch_Get(b, i, d->db.reads, d->db.mappings);
+/* alignment written 1st than sequence -> primary_alignment_id must be set!! */
+                if( (d->rc = CGWriterAlgn_Write(d->db.walgn, d->db.reads)) == 0 ) {
+                    d->rc = CGWriterSeq_Write(d->db.wseq);
+                }
+                if( d->rc != 0 ) {
+                    CGLoaderFile_LOG(n->seq, klogErr, d->rc, NULL, NULL);
+                    CGLoaderFile_LOG(n->align, klogErr, d->rc, NULL, NULL);
+                }
+            }
+            if( d->rc == 0 ) {
+                last = b->last;
+                d->rc = last ? b->rc : Quitting();
+            }
+            ParsedBatch_Whack(b);
+        }
+    }
+    ReadsParser_Whack(&p);
+    return d->rc;
+}
+
 bool CC FGroupMAP_LoadEvidence( BSTNode *node, void *data )
 {
     FGroupMAP* n = (FGroupMAP*)node;
@@ -893,7 +1309,10 @@ static rc_t Load( SParam* param )
                     rc = DB_Init( param, &data.db );
                     if ( rc == 0 )
                     {
-                        BSTreeDoUntil( &slides, false, FGroupMAP_LoadReads, &data );
+                        if ( param->parse_threads > 0 )
+                            FGroupMAP_LoadReadsParallel( &slides, &data );
+                        else
+                            BSTreeDoUntil( &slides, false, FGroupMAP_LoadReads, &data );
                         rc = data.rc;
                         if ( rc == 0 )
                         {
@@ -967,6 +1386,7 @@ const char* single_mate_usage[] = {"if secondary mates have duplicates preserve
 const char* cluster_size_usage[] = {"defines cluster window on the reference, records only 1 placement from given cluster size; default is zero which means ignore", NULL};
 const char* no_read_ahead_usage[] = {"disable input files threaded caching", NULL};
 const char* library_usage[] = {"copy extra file/directory into output", NULL};
+const char* parse_threads_usage[] = {"number of threads parsing MAP file groups ahead of the writer, 0 parses on the writer thread; default is 4", NULL};
 
 /* this enum must have same order as MainArgs array below */
 enum OptDefIndex {
@@ -989,7 +1409,8 @@ enum OptDefIndex {
     eopt_SingleMate,
     eopt_ClusterSize,
     eopt_noReadAhead,
-    eopt_Library
+    eopt_Library,
+    eopt_ParseThreads
 };
 
 OptDef MainArgs[] =
@@ -1015,7 +1436,8 @@ OptDef MainArgs[] =
     { "single-mate",      NULL, NULL, single_mate_usage,    1, false, false },
     { "cluster-size",     NULL, NULL, cluster_size_usage,   1, true,  false },
     { "input-no-threads", "t",  NULL, no_read_ahead_usage,  1, false, false },
-    { "library",          "l",  NULL, library_usage,        1, true,  false }
+    { "library",          "l",  NULL, library_usage,        1, true,  false },
+    { "parse-threads",    NULL, NULL, parse_threads_usage,  1, true,  false }
 };
 const size_t MainArgsQty = sizeof(MainArgs) / sizeof(MainArgs[0]);
 
@@ -1070,11 +1492,12 @@ rc_t CC KMain( int argc, char* argv[] )
 {
     rc_t rc = 0;
     Args* args = NULL;
-    const char* errmsg = NULL, *refseq_chunk = NULL, *min_mapq = NULL, *cluster_size = NULL;
+    const char* errmsg = NULL, *refseq_chunk = NULL, *min_mapq = NULL, *cluster_size = NULL, *parse_threads = NULL;
     const XMLLogger* xml_logger = NULL;
     SParam params;
     memset(&params, 0, sizeof(params));
     params.schema = "align/align.vschema";
+    params.parse_threads = 4;
 
     params.argv0 = argv[0];
     
@@ -1176,6 +1599,11 @@ rc_t CC KMain( int argc, char* argv[] )
             errmsg = MainArgs[eopt_ClusterSize].name;
         } else if( (rc = ArgsOptionCount(args, MainArgs[eopt_SingleMate].name, &params.single_mate)) != 0 ) {
             errmsg = MainArgs[eopt_SingleMate].name;
+        } else if( (rc = ArgsOptionCount(args, MainArgs[eopt_ParseThreads].name, &count)) != 0 || count > 1 ) {
+            rc = rc ? rc : RC(rcExe, rcArgv, rcParsing, rcParam, rcExcessive);
+            errmsg = MainArgs[eopt_ParseThreads].name;
+        } else if( count > 0 && (rc = ArgsOptionValue(args, MainArgs[eopt_ParseThreads].name, 0, (const void **)&parse_threads)) != 0 ) {
+            errmsg = MainArgs[eopt_ParseThreads].name;
 
         } else {
             do {
@@ -1217,6 +1645,16 @@ rc_t CC KMain( int argc, char* argv[] )
                     params.min_mapq = val;
                 }
 
+                if( parse_threads != NULL ) {
+                    errno = 0;
+                    val = strtol(parse_threads, &end, 10);
+                    if( errno != 0 || parse_threads == end || *end != '\0' || val < 0 || val > 256 ) {
+                        rc = RC(rcExe, rcArgv, rcReading, rcParam, rcInvalid);
+                        break;
+                    }
+                    params.parse_threads = val;
+                }
+
                 if ( cluster_size )
                     params.cluster_size = atoi( cluster_size );
                 else
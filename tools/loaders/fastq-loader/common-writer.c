@@ -330,7 +330,7 @@ static char const kGetKeyID[] = "GetKeyID";
 static char const kSequenceGetRead[] = "SequenceGetRead";
 static char const kQuitting[] = "Quitting";
 
-static void readSequence(CommonWriterSettings *const G, SpotAssembler *const ctx, Sequence const *const sequence, struct ReadResult *const rslt)
+static void readSequence(CommonWriterSettings *const G, Sequence const *const sequence, struct ReadResult *const rslt)
 {
     char *seqDNA = NULL;
     uint8_t *qual = NULL;
@@ -342,8 +342,6 @@ static void readSequence(CommonWriterSettings *const G, SpotAssembler *const ctx
     int orientation = 0;
     int colorspace = 0;
     char cskey[2];
-    uint64_t keyId = 0;
-    bool wasInserted = 0;
     bool bad = 0;
     rc_t rc = 0;
 
@@ -427,17 +425,6 @@ static void readSequence(CommonWriterSettings *const G, SpotAssembler *const ctx
     if (!mated)
         readNo = 1;
 
-    rc = SpotAssemblerGetKeyID(ctx,
-                               &keyId,
-                               &wasInserted,
-                               spotGroup,
-                               name,
-                               strlen(name));
-    if (rc != 0) {
-        rslt->type = rr_error;
-        rslt->u.error.rc = rc;
-        rslt->u.error.message = kGetKeyID;
-    }
 CLEANUP:
     if (rslt->type == rr_error) {
         free(seqDNA);
@@ -451,13 +438,11 @@ CLEANUP:
         rslt->u.sequence.spotGroup = spotGroup;
         rslt->u.sequence.seqDNA = seqDNA;
         rslt->u.sequence.quality = qual;
-        rslt->u.sequence.id = keyId;
         rslt->u.sequence.readLen = readLen;
         rslt->u.sequence.readNo = readNo;
         rslt->u.sequence.mated = mated;
         rslt->u.sequence.orientation = orientation;
         rslt->u.sequence.bad = bad;
-        rslt->u.sequence.inserted = wasInserted;
         rslt->u.sequence.colorspace = colorspace;
         rslt->u.sequence.cskey = cskey[0];
     }
@@ -499,7 +484,7 @@ static void freeReadResultRejected(struct ReadResult const *const rslt)
     free(rslt->u.reject.message);
 }
 
-static void readRecord(CommonWriterSettings *const G, SpotAssembler *const ctx, Record const *const record, struct ReadResult *const rslt)
+static void readRecord(CommonWriterSettings *const G, Record const *const record, struct ReadResult *const rslt)
 {
     rc_t rc = 0;
     Rejected const *rej = NULL;
@@ -510,7 +495,7 @@ static void readRecord(CommonWriterSettings *const G, SpotAssembler *const ctx,
         rc = RecordGetSequence(record, &sequence);
         if (rc == 0) {
             assert(sequence != NULL);
-            readSequence(G, ctx, sequence, rslt);
+            readSequence(G, sequence, rslt);
             SequenceRelease(sequence);
             return;
         }
@@ -530,11 +515,22 @@ static void readRecord(CommonWriterSettings *const G, SpotAssembler *const ctx,
     RejectedRelease(rej);
 }
 
-static struct ReadResult *threadGetNextRecord(
-    CommonWriterSettings *const G,
-    SpotAssembler *const ctx,
-    struct ReaderFile const *reader,
-    uint64_t *reccount)
+static void freeReadResultError(struct ReadResult const *const rslt)
+{
+    (void)0;
+}
+
+static void freeReadResult(struct ReadResult const *const rslt)
+{
+    if (rslt->type == rr_sequence)
+        freeReadResultSequence(rslt);
+    else if (rslt->type == rr_rejected)
+        freeReadResultRejected(rslt);
+    else if (rslt->type == rr_error)
+        freeReadResultError(rslt);
+}
+
+static struct ReadResult *parseNextRecord(CommonWriterSettings *const G, struct ReaderFile const *reader)
 {
     rc_t rc = 0;
     Record const *record = NULL;
@@ -544,12 +540,6 @@ static struct ReadResult *threadGetNextRecord(
     if (rslt != NULL)
     {
         rslt->progress = ReaderFileGetProportionalPosition(reader);
-        rslt->recordNo = ++*reccount;
-        if (G->maxAlignCount > 0 && rslt->recordNo > G->maxAlignCount) {
-            (void)PLOGMSG(klogDebug, (klogDebug, "reached limit of $(max) records read", "max=%u", (unsigned)G->maxAlignCount));
-            rslt->type = rr_fileDone;
-            return rslt;
-        }
         rc = ReaderFileGetRecord(reader, &record);
         if (rc != 0) {
             rslt->type = rr_error;
@@ -558,7 +548,7 @@ static struct ReadResult *threadGetNextRecord(
             return rslt;
         }
         if (record != NULL) {
-            readRecord(G, ctx, record, rslt);
+            readRecord(G, record, rslt);
             RecordRelease(record);
             return rslt;
         }
@@ -570,19 +560,189 @@ static struct ReadResult *threadGetNextRecord(
     abort();
 }
 
-static void freeReadResultError(struct ReadResult const *const rslt)
+/* the key ids decide the order of the spots, so this runs on one thread, in input order */
+static void keyReadResult(SpotAssembler *const ctx, struct ReadResult *const rslt)
 {
-    (void)0;
+    if (rslt->type == rr_sequence) {
+        uint64_t keyId = 0;
+        bool wasInserted = 0;
+        rc_t const rc = SpotAssemblerGetKeyID(ctx,
+                                              &keyId,
+                                              &wasInserted,
+                                              rslt->u.sequence.spotGroup,
+                                              rslt->u.sequence.name,
+                                              strlen(rslt->u.sequence.name));
+        if (rc == 0) {
+            rslt->u.sequence.id = keyId;
+            rslt->u.sequence.inserted = wasInserted;
+        }
+        else {
+            freeReadResultSequence(rslt);
+            rslt->type = rr_error;
+            rslt->u.error.rc = rc;
+            rslt->u.error.message = kGetKeyID;
+        }
+    }
 }
 
-static void freeReadResult(struct ReadResult const *const rslt)
+static bool reachedRecordLimit(CommonWriterSettings const *const G, uint64_t const recordNo)
 {
-    if (rslt->type == rr_sequence)
-        freeReadResultSequence(rslt);
-    else if (rslt->type == rr_rejected)
-        freeReadResultRejected(rslt);
-    else if (rslt->type == rr_error)
-        freeReadResultError(rslt);
+    if (G->maxAlignCount > 0 && recordNo > G->maxAlignCount) {
+        (void)PLOGMSG(klogDebug, (klogDebug, "reached limit of $(max) records read", "max=%u", (unsigned)G->maxAlignCount));
+        return true;
+    }
+    return false;
+}
+
+#if ! USE_READER_THREAD
+static struct ReadResult *threadGetNextRecord(
+    CommonWriterSettings *const G,
+    SpotAssembler *const ctx,
+    struct ReaderFile const *reader,
+    uint64_t *reccount)
+{
+    uint64_t const recordNo = ++*reccount;
+    struct ReadResult *rslt = NULL;
+
+    if (reachedRecordLimit(G, recordNo)) {
+        rslt = calloc(1, sizeof(*rslt));
+        if (rslt == NULL)
+            abort();
+        rslt->progress = ReaderFileGetProportionalPosition(reader);
+        rslt->type = rr_fileDone;
+    }
+    else {
+        rslt = parseNextRecord(G, reader);
+        keyReadResult(ctx, rslt);
+    }
+    rslt->recordNo = recordNo;
+    return rslt;
+}
+#endif
+
+/*--------------------------------------------------------------------------
+ * ParseThread
+ *  one per input file: parses ahead of the spot assembler into a bounded queue,
+ *  so that paired files (and the next file to be loaded) are parsed concurrently
+ */
+#define PARSE_QUEUE_CAPACITY ( 4 * 1024 )
+
+struct ParseThread {
+    KThread *th;
+    KQueue *que;
+    CommonWriterSettings *settings;
+    ReaderFile const *reader;
+};
+
+static rc_t parseThread(KThread const *const th, void *const data)
+{
+    struct ParseThread *const self = data;
+    rc_t rc = 0;
+
+    while (rc == 0 && Quitting() == 0)
+    {
+        struct ReadResult *const rr = parseNextRecord(self->settings, self->reader);
+        bool const fileDone = rr->type == rr_fileDone;
+
+        for ( ; ; )
+        {
+            timeout_t tm;
+            TimeoutInit(&tm, 10000);
+            rc = KQueuePush(self->que, rr, &tm);
+            if (rc == 0 || (int)GetRCObject(rc) != rcTimeout || Quitting() != 0)
+                break;
+        }
+        if (rc != 0)
+        {
+            freeReadResult(rr);
+            free(rr);
+            if (((int)GetRCState(rc) == rcReadonly && (int)GetRCObject(rc) == rcQueue) || Quitting() != 0)
+            {
+                (void)LOGMSG(klogDebug, "parseThread: consumer closed queue");
+                rc = 0;
+            }
+            else
+                (void)LOGERR(klogErr, rc, "parseThread: failed to push next record into queue");
+            break;
+        }
+        if (fileDone)
+            break;
+    }
+    KQueueSeal(self->que);
+    return rc;
+}
+
+static rc_t ParseThreadMake(struct ParseThread **const pself, CommonWriterSettings *const G, ReaderFile const *const reader)
+{
+    rc_t rc;
+    struct ParseThread *const self = calloc(1, sizeof(*self));
+
+    if (self == NULL)
+        return RC(rcExe, rcThread, rcCreating, rcMemory, rcExhausted);
+
+    self->settings = G;
+    self->reader = reader;
+    rc = KQueueMake(&self->que, PARSE_QUEUE_CAPACITY);
+    if (rc == 0)
+    {
+        rc = KThreadMake(&self->th, parseThread, (void *)self);
+        if (rc == 0)
+        {
+            *pself = self;
+            return 0;
+        }
+        KQueueRelease(self->que);
+    }
+    free(self);
+    return rc;
+}
+
+/* the consumer is done with the file: unblock the parser, join it and drop what it parsed ahead */
+static void ParseThreadRelease(struct ParseThread *const self)
+{
+    if (self == NULL)
+        return;
+
+    KQueueSeal(self->que);
+    for ( ; ; ) {
+        timeout_t tm;
+        void *rr = NULL;
+
+        TimeoutInit(&tm, 1000);
+        if (KQueuePop(self->que, &rr, &tm) != 0)
+            break;
+        freeReadResult(rr);
+        free(rr);
+    }
+    KThreadWait(self->th, NULL);
+    KThreadRelease(self->th);
+    KQueueRelease(self->que);
+    free(self);
+}
+
+static struct ReadResult *ParseThreadNextRecord(struct ParseThread *const self)
+{
+    for ( ; ; ) {
+        timeout_t tm;
+        void *rr = NULL;
+        rc_t rc;
+
+        TimeoutInit(&tm, 10000);
+        rc = KQueuePop(self->que, &rr, &tm);
+        if (rc == 0)
+            return rr;
+        if ((int)GetRCObject(rc) == rcTimeout && Quitting() == 0)
+            continue;
+        {   /* the parser went away without reaching the end of its file */
+            struct ReadResult *const rslt = calloc(1, sizeof(*rslt));
+            if (rslt == NULL)
+                abort();
+            if (Quitting() == 0 && ((int)GetRCObject(rc) != rcData || (int)GetRCState(rc) != rcDone))
+                (void)LOGERR(klogErr, rc, "KQueuePop failed");
+            rslt->type = rr_fileDone;
+            return rslt;
+        }
+    }
 }
 
 struct ReadThreadContext {
@@ -592,46 +752,52 @@ struct ReadThreadContext {
     SpotAssembler *ctx;
     ReaderFile const *reader1;
     ReaderFile const *reader2;
-    ReaderFile const *cur_reader;
+    struct ParseThread *parser1;
+    struct ParseThread *parser2;
+    struct ParseThread *cur_parser;
     bool reader1_active;
     bool reader2_active;
     uint64_t reccount;
 };
 
+/* takes the parsed records from the file parsers, alternating between the files of a pair,
+   assigns the spot keys and hands them on to ArchiveFile */
 static rc_t readThread(KThread const *const th, void *const ctx)
 {
     struct ReadThreadContext *const self = ctx;
     rc_t rc = 0;
 
-    self->reader1_active = self -> reader1 != NULL;
-    self->reader2_active = self -> reader2 != NULL;
+    self->reader1_active = self -> parser1 != NULL;
+    self->reader2_active = self -> parser2 != NULL;
 
     if ( self -> reader1_active )
     {
-        self->cur_reader = self -> reader1;
+        self->cur_parser = self -> parser1;
     }
     else
     {
-        self->cur_reader = self -> reader2;
+        self->cur_parser = self -> parser2;
     }
-    assert( self->cur_reader != NULL );
+    assert( self->cur_parser != NULL );
 
     while ( rc == 0 && Quitting() == 0 )
     {
-        (void)LOGMSG(klogDebug, "threadGetNextRecord from ");
-
         (void)PLOGMSG(klogDebug, (klogDebug, "threadGetNextRecord($(r))", "r=%s",
-                                self->cur_reader == self -> reader1 ? "1" : "2" ) );
+                                self->cur_parser == self -> parser1 ? "1" : "2" ) );
 
-        struct ReadResult *const rr =
-            threadGetNextRecord(
-                self->settings,
-                self->ctx,
-                self->cur_reader,
-                &self->reccount
-            );
+        struct ReadResult *const rr = ParseThreadNextRecord(self->cur_parser);
+        bool fileDone = false;
 
-        while ( Quitting() == 0  && rr->type != rr_fileDone )
+        rr->recordNo = ++self->reccount;
+        if (rr->type != rr_fileDone && reachedRecordLimit(self->settings, rr->recordNo))
+        {
+            freeReadResult(rr);
+            rr->type = rr_fileDone;
+        }
+        keyReadResult(self->ctx, rr);
+        fileDone = rr->type == rr_fileDone;
+
+        while ( Quitting() == 0 && ! fileDone )
         {
             timeout_t tm;
             TimeoutInit(&tm, 10000);
@@ -648,6 +814,7 @@ static rc_t readThread(KThread const *const th, void *const ctx)
         }
         if ( rc != 0 )
         {   // KQueuePush failed
+            freeReadResult(rr);
             free(rr);
             if ((int)GetRCState(rc) == rcReadonly && (int)GetRCObject(rc) == rcQueue)
             {
@@ -657,52 +824,48 @@ static rc_t readThread(KThread const *const th, void *const ctx)
             else
             {
                 (void)LOGERR(klogErr, rc, "readThread: failed to push next record into queue");
-                break;
             }
+            break;
         }
-        else if (rr->type == rr_fileDone)
+        else if (fileDone)
         {
             /* normal exit from an end of file */
             (void)LOGMSG(klogDebug, "readThread: end of file");
+            free(rr);
             /* do not use this reader anymore */
-            if ( self->cur_reader == self -> reader1 )
+            if ( self->cur_parser == self -> parser1 )
             {
                 self->reader1_active = false;
             }
             else
             {
-                assert( self->cur_reader == self -> reader2 );
+                assert( self->cur_parser == self -> parser2 );
                 self->reader2_active = false;
             }
         }
 
         // switch to the other reader if necessary
-        if ( self->cur_reader == self -> reader1 )
+        if ( self->cur_parser == self -> parser1 )
         {
             if ( self->reader2_active )
             {
-                self->cur_reader = self -> reader2;
+                self->cur_parser = self -> parser2;
             }
         }
         else
         {
             if ( self->reader1_active )
             {
-                self->cur_reader = self -> reader1;
+                self->cur_parser = self -> parser1;
             }
         }
 
-        if ( rr->type == rr_fileDone )
+        if ( fileDone )
         {   // if no more readers left, signal to the caller that we are done
             if ( ! self->reader1_active && ! self->reader2_active )
             {
-                rr->type = rr_done;
                 break;
             }
-            else
-            {   // proceed with the remaining reader
-                continue;
-            }
         }
     }
     KQueueSeal(self->que);
@@ -1108,7 +1271,8 @@ rc_t ArchiveFile(const struct ReaderFile *const reader1,
                  struct SequenceWriter *const seq,
                  bool *const had_sequences,
                  bool *const isColorSpace,
-                 const struct KLoadProgressbar *progress_bar)
+                 const struct KLoadProgressbar *progress_bar,
+                 struct ParseThread *const prefetched)
 {
     KDataBuffer fragBuf;
     rc_t rc;
@@ -1131,9 +1295,21 @@ rc_t ArchiveFile(const struct ReaderFile *const reader1,
     threadCtx.reader1 = reader1;
     threadCtx.reader2 = reader2;
 
+    if (prefetched != NULL) {
+        assert(prefetched->reader == reader1);
+        threadCtx.parser1 = prefetched;
+    }
     rc = KDataBufferMake(&fragBuf, 8, 4096);
-    if (rc)
+    if (rc == 0 && reader1 != NULL && threadCtx.parser1 == NULL)
+        rc = ParseThreadMake(&threadCtx.parser1, G, reader1);
+    if (rc == 0 && reader2 != NULL)
+        rc = ParseThreadMake(&threadCtx.parser2, G, reader2);
+    if (rc) {
+        ParseThreadRelease(threadCtx.parser1);
+        ParseThreadRelease(threadCtx.parser2);
+        KDataBufferWhack(&fragBuf);
         return rc;
+    }
 
     if (rc == 0) {
         (void)PLOGMSG(klogInfo, (klogInfo, "Loading '$(file)'", "file=%s", fileName));
@@ -1212,8 +1388,10 @@ rc_t ArchiveFile(const struct ReaderFile *const reader1,
 
             TimeoutInit(&tm, 1000);
             rc = KQueuePop(threadCtx.que, &rr, &tm);
-            if (rc == 0)
+            if (rc == 0) {
+                freeReadResult(rr);
                 free(rr);
+            }
             else
                 break;
         }
@@ -1221,6 +1399,8 @@ rc_t ArchiveFile(const struct ReaderFile *const reader1,
     }
     KThreadRelease(threadCtx.th);
     KQueueRelease(threadCtx.que);
+    ParseThreadRelease(threadCtx.parser1);
+    ParseThreadRelease(threadCtx.parser2);
 
     if (filterFlagConflictRecords > 0) {
         (void)PLOGMSG(klogWarn, (klogWarn, "$(cnt1) out of $(cnt2) records contained warning : both 'duplicate' and 'lowQuality' flag bits set, only 'duplicate' will be saved", "cnt1=%lu,cnt2=%lu", filterFlagConflictRecords,recordsProcessed));
@@ -1292,14 +1472,28 @@ rc_t CommonWriterInit(CommonWriter* self, struct VDBManager *mgr, struct VDataba
     return rc;
 }
 
+rc_t CommonWriterPrefetch(CommonWriter *const self, const struct ReaderFile *const reader)
+{
+    assert(self);
+    assert(reader);
+    if (self->prefetch != NULL)
+        return RC(rcExe, rcThread, rcCreating, rcThread, rcBusy);
+    return ParseThreadMake(&self->prefetch, &self->settings, reader);
+}
+
 rc_t CommonWriterArchive(CommonWriter *const self,
                          const struct ReaderFile *const reader1,
                          const struct ReaderFile *const reader2)
 {
     rc_t rc;
     bool has_sequences = false;
+    struct ParseThread *prefetched = NULL;
 
     assert(self);
+    if (self->prefetch != NULL && self->prefetch->reader == reader1) {
+        prefetched = self->prefetch;
+        self->prefetch = NULL;
+    }
     rc = ArchiveFile(reader1,
                      reader2,
                      &self->settings,
@@ -1307,7 +1501,8 @@ rc_t CommonWriterArchive(CommonWriter *const self,
                      self->seq,
                      &has_sequences,
                      &self->isColorSpace,
-                     self->progress);
+                     self->progress,
+                     prefetched);
     if (rc)
         self->commit = false;
     else
@@ -1320,6 +1515,11 @@ rc_t CommonWriterArchive(CommonWriter *const self,
 rc_t CommonWriterComplete(CommonWriter* self, bool quitting, uint64_t maxDistance)
 {
     rc_t rc=0;
+
+    /* a file that was prefetched but never archived */
+    ParseThreadRelease(self->prefetch);
+    self->prefetch = NULL;
+
     if (self->had_sequences)
     {
         if (!quitting)
@@ -1355,6 +1555,9 @@ rc_t CommonWriterWhack(CommonWriter* self)
     rc_t rc = 0;
     assert(self);
 
+    ParseThreadRelease(self->prefetch);
+    self->prefetch = NULL;
+
     SpotAssemblerRelease(self->ctx);
 
     KLoadProgressbar_Release(self->progress, true);
@@ -41,6 +41,7 @@ struct SequenceWriter;
 struct AlignmentWriter;
 struct Reference;
 struct SpotAssembler;
+struct ParseThread;
 
 /*--------------------------------------------------------------------------
  * CommonWriterSettings
@@ -113,6 +114,7 @@ typedef struct CommonWriter {
     struct SpotAssembler * ctx;
     struct SequenceWriter * seq;
     const struct KLoadProgressbar * progress;
+    struct ParseThread * prefetch;
 
     bool had_sequences;
     unsigned err_count;
@@ -122,6 +124,10 @@ typedef struct CommonWriter {
 
 rc_t CommonWriterInit(CommonWriter* self, struct VDBManager *mgr, struct VDatabase *db, const CommonWriterSettings* settings);
 
+/* start parsing a file that will be passed to CommonWriterArchive() next, while the current one is being archived;
+   the reader has to stay alive until it has been archived or CommonWriterComplete() is called */
+rc_t CommonWriterPrefetch( CommonWriter* self, const struct ReaderFile * reader );
+
 rc_t CommonWriterArchive( CommonWriter* self, const struct ReaderFile * reader1, const struct ReaderFile * reader2_opt );
 rc_t CommonWriterComplete(CommonWriter* self, bool quitting, uint64_t maxDistance);
 
@@ -146,6 +146,8 @@ extern void FASTQScan_yylex_destroy(FASTQParseBlock* context);
 extern void FASTQScan_inline_sequence(FASTQParseBlock* pb);
 extern void FASTQScan_inline_quality(FASTQParseBlock* pb);
 extern void FASTQScan_skip_to_eol(FASTQParseBlock* pb); /*the next token will be EOL or EOF*/
+extern void FASTQScan_reset(FASTQParseBlock* pb, size_t line_no); /* drop buffered input, restart in the initial state */
+extern bool FASTQScan_clean(const FASTQParseBlock* pb); /* the lexer is not in the middle of anything */
 
 extern void FASTQ_set_lineno (int line_number, void* scanner);
 
@@ -162,6 +164,18 @@ extern void FASTQ_ParseBlockInit(FASTQParseBlock* pb);
 
 extern void FASTQ_error(FASTQParseBlock* pb, const char* msg);
 
+/* direct record scanner (fastq-scan.c), bypasses the lexer/parser for the common record layouts */
+enum
+{
+    FASTQ_SCAN_RECORD,  /* a record was recognized: pb->record->source, pb offsets and pb->length are set */
+    FASTQ_SCAN_END,     /* no more input */
+    FASTQ_SCAN_MORE,    /* the record may continue past the end of the buffer, call again with more data */
+    FASTQ_SCAN_GRAMMAR  /* not recognized, use FASTQ_parse on this record; pb is unchanged */
+};
+
+/* buf starts at the beginning of a record; eof = there is no input beyond buf+size */
+extern int FASTQ_scan(FASTQParseBlock* pb, const char* buf, size_t size, bool eof);
+
 #ifdef __cplusplus
 }
 #endif
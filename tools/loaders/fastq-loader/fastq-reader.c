@@ -48,6 +48,9 @@ typedef struct FastqSequence    FastqSequence;
 
 static rc_t FastqSequenceInit(FastqSequence* self);
 
+/* maximum number of bytes handed to the lexer at a time when records are also taken by FASTQ_scan */
+#define LEXER_CHUNK_SIZE ( 64 * 1024 )
+
 /*--------------------------------------------------------------------------
  * FastqRecord
  */
@@ -489,6 +492,10 @@ struct FastqReaderFile
     size_t curPos;           /* current tokenization position relative to recordStart */
     bool lastEol;
     bool eolInserted;
+
+    size_t lineNo;           /* line number of recordStart */
+    bool lexerInSync;        /* false if records were taken by FASTQ_scan since the lexer's last read */
+    bool grammarOnly;        /* do not use FASTQ_scan */
 };
 
 rc_t FastqReaderFileWhack( FastqReaderFile* f )
@@ -520,10 +527,57 @@ void FASTQ_ParseBlockInit ( FASTQParseBlock* pb )
     pb->qualityLength = 0;
 }
 
+static size_t CountLines ( const char* text, size_t size )
+{
+    size_t count = 0;
+    const char* end = text + size;
+    while ( text < end )
+    {
+        text = memchr ( text, '\n', end - text );
+        if ( text == NULL )
+            break;
+        ++count;
+        ++text;
+    }
+    return count;
+}
+
+/* Try to take the next record directly off the input buffer.
+   The buffer view is extended until the scanner sees the whole record; returns FASTQ_SCAN_xxx */
+static int FastqReaderFileScan ( FastqReaderFile* self )
+{
+    size_t need = 0;
+    for (;;)
+    {
+        const void* buf;
+        size_t length;
+        bool eof;
+        int res;
+        rc_t rc = KLoaderFile_Read( self->reader, 0, need, & buf, & length );
+        if ( rc != 0 )  /* includes a record not fitting into the buffer: let the parser deal with it */
+            return FASTQ_SCAN_GRAMMAR;
+        eof = ( buf == NULL || length < need );
+        if ( need > 0 && ! eof )
+        {   /* the buffer was refilled, look at all of it */
+            rc = KLoaderFile_Read( self->reader, 0, 0, & buf, & length );
+            if ( rc != 0 )
+                return FASTQ_SCAN_GRAMMAR;
+        }
+        if ( buf != NULL )
+            self->recordStart = buf; /* a refill may have moved the data */
+
+        res = FASTQ_scan( & self->pb, buf, length, eof );
+        if ( res != FASTQ_SCAN_MORE )
+            return res;
+        need = length + 1;
+    }
+}
+
 rc_t FastqReaderFileGetRecord ( const FastqReaderFile *f, const Record** result )
 {
     rc_t rc;
     FastqReaderFile* self = (FastqReaderFile*) f;
+    int scanned = FASTQ_SCAN_GRAMMAR;
 
     if (self->pb.fatalError)
         return 0;
@@ -540,11 +594,40 @@ rc_t FastqReaderFileGetRecord ( const FastqReaderFile *f, const Record** result
 
     FASTQ_ParseBlockInit( & self->pb );
 
-    if ( FASTQ_parse( & self->pb ) == 0 && self->pb.record->rej == 0 )
-    {   /* normal end of input */
-        RecordRelease((const Record*)self->pb.record);
-        *result = 0;
-        return 0;
+    /* a record the grammar could not make sense of may leave the lexer in a state affecting the next record */
+    if ( ! self->grammarOnly && self->reader != 0 && ( ! self->lexerInSync || FASTQScan_clean( & self->pb ) ) )
+    {
+        scanned = FastqReaderFileScan( self );
+        if ( scanned == FASTQ_SCAN_END )
+        {
+            RecordRelease((const Record*)self->pb.record);
+            *result = 0;
+            return 0;
+        }
+    }
+
+    if ( scanned == FASTQ_SCAN_RECORD )
+    {   /* the lexer's buffer does not cover this record any more */
+        self->lexerInSync = false;
+        self->curPos = 0;
+    }
+    else
+    {
+        if ( ! self->lexerInSync )
+        {   /* restart the lexer at the current record */
+            FASTQScan_reset( & self->pb, self->lineNo );
+            self->curPos = 0;
+            self->lastEol = false;
+            self->eolInserted = false;
+            self->lexerInSync = true;
+        }
+
+        if ( FASTQ_parse( & self->pb ) == 0 && self->pb.record->rej == 0 )
+        {   /* normal end of input */
+            RecordRelease((const Record*)self->pb.record);
+            *result = 0;
+            return 0;
+        }
     }
 
     /*TODO: remove? compensate for an artificially inserted trailing \n */
@@ -564,10 +647,12 @@ rc_t FastqReaderFileGetRecord ( const FastqReaderFile *f, const Record** result
     {
         /* advance the record start pointer beyond the last token */
         size_t length;
+        self->lineNo += CountLines( self->recordStart, self->pb.length );
         rc = KLoaderFile_Read( self->reader, self->pb.length, 0, (const void**)& self->recordStart, & length);
         if (rc != 0)
             LogErr(klogErr, rc, "FastqReaderFileGetRecord failed");
-        self->curPos -= self->pb.length;
+        if ( scanned != FASTQ_SCAN_RECORD )
+            self->curPos -= self->pb.length;
     }
 
     StringInit( & self->pb.record->seq.spotname,    (const char*)self->pb.record->source.base + self->pb.spotNameOffset,    self->pb.spotNameLength, (uint32_t)self->pb.spotNameLength);
@@ -603,8 +688,13 @@ size_t CC FASTQ_input(FASTQParseBlock* pb, char* buf, size_t max_size)
 {
     FastqReaderFile* self = (FastqReaderFile*)pb->self;
     size_t length;
+    rc_t rc;
+
+    /* the lexer is restarted whenever it has to take over from FASTQ_scan, keep it from copying ahead too much */
+    if ( ! self->grammarOnly && max_size > LEXER_CHUNK_SIZE )
+        max_size = LEXER_CHUNK_SIZE;
 
-    rc_t rc = KLoaderFile_Read( self->reader, 0, self->curPos + max_size, (const void**)& self->recordStart, & length);
+    rc = KLoaderFile_Read( self->reader, 0, self->curPos + max_size, (const void**)& self->recordStart, & length);
 
     if ( rc != 0 )
     {
@@ -678,6 +768,11 @@ rc_t CC FastqReaderFileMake( const ReaderFile **reader,
             self->pb.secondaryReadNumber = 0;
             self->pb.ignoreSpotGroups = ignoreSpotGroups;
 
+            self->lineNo = 1;
+            self->lexerInSync = true;
+            /* token traces are only available from the lexer; PACBIO spot names are assembled by the grammar */
+            self->grammarOnly = debugLex || defaultReadNumber == -1;
+
             rc = FASTQScan_yylex_init(& self->pb, debugLex);
             if (rc == 0)
             {
@@ -711,4 +806,9 @@ rc_t FastqReaderFileGetReferenceInfo ( const READERFILE_IMPL *self, const Refere
     return 0;
 }
 
-
+void CC FastqReaderFileUseGrammarOnly ( const ReaderFile* f, bool grammarOnly )
+{
+    FastqReaderFile* self = (FastqReaderFile*) f;
+    if ( self != NULL )
+        self->grammarOnly = grammarOnly;
+}
@@ -51,6 +51,9 @@ rc_t CC FastqReaderFileMake( const struct ReaderFile **self,
                              bool ignoreSpotGroups,
                              bool debugLex );
 
+/* parse every record with the lexer/parser instead of the direct scanner (for testing) */
+void CC FastqReaderFileUseGrammarOnly ( const struct ReaderFile* self, bool grammarOnly );
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,628 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ */
+
+/*
+ * Direct record scanner for FASTQ/FASTA input.
+ *
+ * Works on the reader's input buffer line by line (memchr), without going through
+ * flex tokens. It only accepts records whose shape it can attribute with certainty
+ * to a production of fastq-grammar.y, and extracts exactly the fields the grammar's
+ * actions would (spot name, spot group, read number, low quality flag, read, quality).
+ * Everything else - syntax errors, rare tag line variations, PACBIO, inline reads,
+ * CR/LF line ends - is declined and handed to the grammar, which remains authoritative.
+ */
+
+#include "fastq-parse.h"
+
+#include <sysalloc.h>
+#include <string.h>
+
+#include <klib/data-buffer.h>
+
+/* tag line tokens, classified the same way as by the <TAG_LINE> rules in fastq-lex.l */
+enum
+{
+    tokCOORDS = 256,
+    tokRUNDOTSPOT,
+    tokSPOTGROUP,
+    tokNUMBER,
+    tokALPHANUM,
+    tokWS,
+    tokEOL
+};
+
+#define MAX_TAG_TOKENS 64
+
+typedef struct ScanToken
+{
+    int type;       /* one of the tok* values or a single character */
+    size_t start;   /* offset from the start of the record */
+    size_t length;
+} ScanToken;
+
+/* what the grammar's tag line actions would have produced */
+typedef struct ScanTag
+{
+    size_t spotNameOffset;
+    size_t spotNameLength;
+    size_t spotGroupOffset;
+    size_t spotGroupLength;
+    size_t readNumberOffset;
+    size_t readNumberLength;     /* 0 if none */
+    bool lowQuality;
+} ScanTag;
+
+static bool IsDigit ( char ch ) { return ch >= '0' && ch <= '9'; }
+
+static bool IsAlphanum ( char ch )
+{
+    return IsDigit ( ch ) || ( ch >= 'A' && ch <= 'Z' ) || ( ch >= 'a' && ch <= 'z' ) || ch == '-';
+}
+
+static bool IsSpotGroupChar ( char ch ) { return IsAlphanum ( ch ) || ch == '_'; }
+
+static bool IsBase ( char ch )
+{
+    switch ( ch )
+    {
+    case 'A': case 'C': case 'G': case 'T': case 'N':
+    case 'a': case 'c': case 'g': case 't': case 'n':
+    case '.':
+        return true;
+    default:
+        return false;
+    }
+}
+
+static size_t SpanDigits ( const char* p, const char* end )
+{
+    const char* start = p;
+    while ( p < end && IsDigit ( *p ) ) ++p;
+    return p - start;
+}
+
+static size_t SpanAlphanum ( const char* p, const char* end )
+{
+    const char* start = p;
+    while ( p < end && IsAlphanum ( *p ) ) ++p;
+    return p - start;
+}
+
+/* :{digits}:{digits}:{digits}:{digits} */
+static size_t MatchCoords ( const char* p, const char* end )
+{
+    const char* start = p;
+    int i;
+    for ( i = 0; i < 4; ++i )
+    {
+        size_t d;
+        if ( p >= end || *p != ':' )
+            return 0;
+        d = SpanDigits ( p + 1, end );
+        if ( d == 0 )
+            return 0;
+        p += 1 + d;
+    }
+    return p - start;
+}
+
+/* [SDE]RR{digits}\.{digits} */
+static size_t MatchRunDotSpot ( const char* p, const char* end )
+{
+    const char* start = p;
+    size_t d;
+    if ( end - p < 6 || ( p[0] != 'S' && p[0] != 'D' && p[0] != 'E' ) || p[1] != 'R' || p[2] != 'R' )
+        return 0;
+    p += 3;
+    d = SpanDigits ( p, end );
+    if ( d == 0 )
+        return 0;
+    p += d;
+    if ( p >= end || *p != '.' )
+        return 0;
+    d = SpanDigits ( p + 1, end );
+    if ( d == 0 )
+        return 0;
+    return p + 1 + d - start;
+}
+
+/* Split a tag line ( the text between '@'/'>' and the end of line ) into tokens.
+   Longest match wins, ties go to the rule listed first in fastq-lex.l */
+static int Tokenize ( const char* rec, size_t from, size_t to, ScanToken* tok )
+{
+    const char* end = rec + to;
+    const char* p = rec + from;
+    int n = 0;
+    while ( p < end )
+    {
+        size_t len = 0;
+        int type;
+        if ( n == MAX_TAG_TOKENS - 1 )
+            return -1;
+
+        if ( *p == ':' && ( len = MatchCoords ( p, end ) ) > 0 )
+            type = tokCOORDS;
+        else if ( ( len = MatchRunDotSpot ( p, end ) ) > 0 )
+            type = tokRUNDOTSPOT;
+        else if ( *p == '#' )
+        {
+            const char* q = p + 1;
+            while ( q < end && IsSpotGroupChar ( *q ) ) ++q;
+            len = q - p;
+            type = tokSPOTGROUP;
+        }
+        else if ( IsAlphanum ( *p ) )
+        {
+            size_t d = SpanDigits ( p, end );
+            len = SpanAlphanum ( p, end );
+            type = ( d == len ) ? tokNUMBER : tokALPHANUM;
+        }
+        else if ( *p == ' ' || *p == '\t' )
+        {
+            const char* q = p;
+            while ( q < end && ( *q == ' ' || *q == '\t' ) ) ++q;
+            len = q - p;
+            /* [ \t]*{eol} is a single end-of-line token */
+            type = ( q == end ) ? tokEOL : tokWS;
+        }
+        else if ( ( unsigned char ) *p < ' ' || ( unsigned char ) *p > '~' )
+            return -1; /* control characters, CR, NUL, non-ASCII: leave to the grammar */
+        else
+        {
+            len = 1;
+            type = *p;
+        }
+
+        tok[n].type = type;
+        tok[n].start = p - rec;
+        tok[n].length = len;
+        ++n;
+        p += len;
+    }
+    if ( n == 0 || tok[n-1].type != tokEOL )
+    {
+        tok[n].type = tokEOL;
+        tok[n].start = to;
+        tok[n].length = 0;
+        ++n;
+    }
+    return n;
+}
+
+/* name : ( ALPHANUM | NUMBER ) { '_' | '-' | '.' | ':' | ALPHANUM | NUMBER } */
+static int SkipName ( const ScanToken* tok, int i )
+{
+    if ( tok[i].type != tokALPHANUM && tok[i].type != tokNUMBER )
+        return i;
+    ++i;
+    for (;;)
+    {
+        switch ( tok[i].type )
+        {
+        case tokALPHANUM: case tokNUMBER: case '_': case '-': case '.': case ':':
+            ++i;
+            break;
+        default:
+            return i;
+        }
+    }
+}
+
+static void ReadNumberToken ( ScanTag* tag, const ScanToken* token )
+{
+    tag->readNumberOffset = token->start;
+    tag->readNumberLength = token->length;
+}
+
+static void SpotGroup ( const FASTQParseBlock* pb, const char* rec, size_t offset, size_t length, ScanTag* tag )
+{   /* same as SetSpotGroup() in fastq-grammar.y */
+    if ( ! pb->ignoreSpotGroups )
+    {
+        size_t nameStart = ( rec[offset] == '#' ) ? 1 : 0;
+        if ( length != 1 + nameStart || rec[offset + nameStart] != '0' )
+        {
+            tag->spotGroupOffset = offset + nameStart;
+            tag->spotGroupLength = length - nameStart;
+        }
+    }
+}
+
+/* Recognize the common tag line shapes, return false for anything else.
+   Each accepted shape is annotated with the grammar production that handles it. */
+static bool ScanTagLine ( const FASTQParseBlock* pb, const char* rec, size_t eol, ScanTag* tag )
+{
+    ScanToken tok[MAX_TAG_TOKENS];
+    int n = Tokenize ( rec, 1, eol, tok );
+    int i;
+
+    memset ( tag, 0, sizeof * tag );
+    if ( n < 0 || tok[0].type == tokWS )
+        return false;
+
+    if ( tok[0].type == tokRUNDOTSPOT )
+    {   /* tagLine: runSpotRead opt_fqWS */
+        tag->spotNameOffset = tok[0].start;
+        tag->spotNameLength = tok[0].length;
+        switch ( tok[1].type )
+        {
+        case tokEOL:
+            /* the grammar skips to EOL with the end-of-line already in the lookahead,
+               which goes wrong if it started with white space */
+            return tok[1].length == 0;
+        case tokWS:
+            return true;
+        case '.':
+        case '/':
+            if ( tok[2].type != tokNUMBER )
+                return false;
+            ReadNumberToken ( tag, & tok[2] );
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    i = SkipName ( tok, 0 );
+    if ( i == 0 )
+        return false;
+    tag->spotNameOffset = tok[0].start;
+    tag->spotNameLength = tok[i].start - tok[0].start;
+
+    switch ( tok[i].type )
+    {
+    case tokEOL:
+        /* tagLine: name */
+        return true;
+
+    case '/':
+        /* tagLine: name readNumber [ fqWS ] */
+        if ( tok[i+1].type != tokNUMBER )
+            return false;
+        ReadNumberToken ( tag, & tok[i+1] );
+        return tok[i+2].type == tokEOL || tok[i+2].type == tokWS;
+
+    case tokSPOTGROUP:
+        /* nameSpotGroup: name fqSPOTGROUP, optionally followed by readNumber */
+        SpotGroup ( pb, rec, tok[i].start, tok[i].length, tag );
+        ++i;
+        if ( tok[i].type == '/' && tok[i+1].type == tokNUMBER )
+        {
+            ReadNumberToken ( tag, & tok[i+1] );
+            i += 2;
+        }
+        return tok[i].type == tokEOL;
+
+    case tokWS:
+        /* nameSpotGroup: nameWS fqALPHANUM '=' (e.g. 454 "length=..."), the spot name reverts to 'name' */
+        return tok[i+1].type == tokALPHANUM && tok[i+2].type == '=';
+
+    case tokCOORDS:
+        /* nameWithCoords: name fqCOORDS */
+        tag->spotNameLength += tok[i].length;
+        ++i;
+        if ( tok[i].type == tokSPOTGROUP )
+        {
+            SpotGroup ( pb, rec, tok[i].start, tok[i].length, tag );
+            ++i;
+        }
+        if ( tok[i].type == '/' && tok[i+1].type == tokNUMBER )
+        {   /* nameSpotGroup readNumber */
+            ReadNumberToken ( tag, & tok[i+1] );
+            i += 2;
+            return tok[i].type == tokEOL;
+        }
+        if ( tok[i].type == tokEOL )
+            return true;
+        if ( tok[i].type == tokWS && tok[i-1].type == tokCOORDS )
+        {   /* nameSpotGroup fqWS casava1_8: NUMBER ':' ALPHANUM ':' NUMBER [ ':' index ] */
+            if ( tok[i+1].type != tokNUMBER || tok[i+2].type != ':' ||
+                 tok[i+3].type != tokALPHANUM || tok[i+4].type != ':' ||
+                 tok[i+5].type != tokNUMBER )
+                return false;
+            ReadNumberToken ( tag, & tok[i+1] );
+            tag->lowQuality = ( tok[i+3].length == 1 && rec[tok[i+3].start] == 'Y' );
+            i += 6;
+            if ( tok[i].type == tokEOL )
+                return tok[i].length == 0;
+            if ( tok[i].type != ':' )
+                return false;
+            {   /* the index is scanned in INLINE_SEQUENCE mode: {basePlus}+ or {digits}, up to a bare EOL */
+                size_t from = tok[i].start + 1;
+                size_t j;
+                bool bases = true;
+                bool digits = true;
+                for ( j = from; j < eol; ++j )
+                {
+                    bases = bases && ( IsBase ( rec[j] ) || rec[j] == '+' );
+                    digits = digits && IsDigit ( rec[j] );
+                }
+                if ( from < eol )
+                {
+                    if ( ! bases && ! digits )
+                        return false;
+                    SpotGroup ( pb, rec, from, eol - from, tag );
+                }
+            }
+            return true;
+        }
+        return false;
+
+    default:
+        return false;
+    }
+}
+
+/* same as SetReadNumber() in fastq-grammar.y; false if the grammar would report an error */
+static bool ReadNumber ( const FASTQParseBlock* pb, const char* rec, const ScanTag* tag, uint8_t* readnumber, uint8_t* secondary )
+{
+    if ( tag->readNumberLength == 0 )
+        return true;
+    if ( tag->readNumberLength == 1 )
+    {
+        char ch = rec[tag->readNumberOffset];
+        if ( ch == '1' )
+            *readnumber = 1;
+        else if ( ch == '0' )
+            *readnumber = pb->defaultReadNumber;
+        else
+        {
+            uint8_t readNum = ch - '0';
+            if ( *secondary == 0 )
+                *secondary = readNum;
+            else if ( *secondary != readNum )
+                return false;
+            *readnumber = 2;
+        }
+    }
+    else
+        *readnumber = pb->defaultReadNumber;
+    return true;
+}
+
+typedef struct ScanLine
+{
+    size_t start;
+    size_t end;  /* position of the end-of-line or end of input */
+    size_t next; /* start of the following line */
+} ScanLine;
+
+/* 0 - line found, 1 - need more input */
+static int NextLine ( const char* buf, size_t size, bool eof, size_t from, ScanLine* line )
+{
+    const char* nl = memchr ( buf + from, '\n', size - from );
+    line->start = from;
+    if ( nl != NULL )
+    {
+        line->end = nl - buf;
+        line->next = line->end + 1;
+        return 0;
+    }
+    if ( ! eof )
+        return 1;
+    line->end = size;
+    line->next = size;
+    return 0;
+}
+
+static bool AllBases ( const char* p, size_t len )
+{
+    size_t i;
+    for ( i = 0; i < len; ++i )
+    {
+        if ( ! IsBase ( p[i] ) )
+            return false;
+    }
+    return true;
+}
+
+static bool ColorSpace ( const char* p, size_t len )
+{   /* {cskey}{color}+ */
+    size_t i;
+    if ( len < 2 )
+        return false;
+    switch ( p[0] )
+    {
+    case 'A': case 'C': case 'G': case 'T':
+    case 'a': case 'c': case 'g': case 't':
+        break;
+    default:
+        return false;
+    }
+    for ( i = 1; i < len; ++i )
+    {
+        if ( ( p[i] < '0' || p[i] > '3' ) && p[i] != '.' )
+            return false;
+    }
+    return true;
+}
+
+static bool QualityRange ( const FASTQParseBlock* pb, uint8_t* floor, uint8_t* ceiling, uint8_t* offset )
+{   /* same ranges as CheckQualities() in fastq-grammar.y */
+    switch ( pb->qualityFormat )
+    {
+    case FASTQphred33: *floor = 33; *ceiling = 126; *offset = 33; return true;
+    case FASTQphred64: *floor = 64; *ceiling = 127; *offset = 64; return true;
+    case FASTQlogodds: *floor = 59; *ceiling = 126; *offset = 64; return true;
+    default: return false;
+    }
+}
+
+static bool ValidQuality ( const char* p, size_t len, uint8_t floor, uint8_t ceiling )
+{
+    size_t i;
+    for ( i = 0; i < len; ++i )
+    {
+        uint8_t ch = ( uint8_t ) p[i];
+        if ( ch < floor || ch > ceiling )
+            return false;
+    }
+    return true;
+}
+
+#define MAX_SCAN_LINES 64
+
+int FASTQ_scan ( FASTQParseBlock* pb, const char* buf, size_t size, bool eof )
+{
+    ScanTag tag;
+    ScanLine hdr;
+    ScanLine seq[MAX_SCAN_LINES];
+    ScanLine qual[MAX_SCAN_LINES];
+    size_t seqLines = 0;
+    size_t qualLines = 0;
+    size_t pos;
+    bool colorspace = false;
+    uint8_t readnumber = 0;
+    uint8_t secondary = pb->secondaryReadNumber;
+    uint8_t qualOffset = pb->qualityAsciiOffset;
+
+    if ( size == 0 )
+        return eof ? FASTQ_SCAN_END : FASTQ_SCAN_MORE;
+    if ( ( buf[0] != '@' && buf[0] != '>' ) || pb->defaultReadNumber == -1 )
+        return FASTQ_SCAN_GRAMMAR;
+
+    /* tag line */
+    if ( NextLine ( buf, size, eof, 0, & hdr ) != 0 )
+        return FASTQ_SCAN_MORE;
+    if ( ! ScanTagLine ( pb, buf, hdr.end, & tag ) ||
+         ! ReadNumber ( pb, buf, & tag, & readnumber, & secondary ) )
+        return FASTQ_SCAN_GRAMMAR;
+
+    /* read: one or more lines of bases, or a single colorspace line */
+    pos = hdr.next;
+    for (;;)
+    {
+        ScanLine* line = & seq[seqLines];
+        size_t len;
+        if ( seqLines == MAX_SCAN_LINES || pos == size )
+            return eof ? FASTQ_SCAN_GRAMMAR : FASTQ_SCAN_MORE;
+        if ( NextLine ( buf, size, eof, pos, line ) != 0 )
+            return FASTQ_SCAN_MORE;
+        len = line->end - line->start;
+        if ( len == 0 )
+            return FASTQ_SCAN_GRAMMAR;
+        if ( ! AllBases ( buf + line->start, len ) )
+        {
+            if ( seqLines > 0 || ! ColorSpace ( buf + line->start, len ) )
+                return FASTQ_SCAN_GRAMMAR;
+            colorspace = true;
+        }
+        ++seqLines;
+        pos = line->next;
+        if ( pos == size )
+        {
+            if ( ! eof )
+                return FASTQ_SCAN_MORE;
+            break;
+        }
+        if ( buf[pos] == '+' || buf[pos] == '@' || buf[pos] == '>' )
+            break;
+        if ( colorspace )
+            return FASTQ_SCAN_GRAMMAR;
+    }
+
+    /* optional quality: '+' line, then as many lines as the read had */
+    if ( pos < size && buf[pos] == '+' )
+    {
+        ScanLine plus;
+        uint8_t floor, ceiling;
+        if ( ! QualityRange ( pb, & floor, & ceiling, & qualOffset ) )
+            return FASTQ_SCAN_GRAMMAR;
+        if ( NextLine ( buf, size, eof, pos, & plus ) != 0 )
+            return FASTQ_SCAN_MORE;
+        if ( memchr ( buf + plus.start, '\r', plus.end - plus.start ) != NULL ||
+             memchr ( buf + plus.start, 0, plus.end - plus.start ) != NULL )
+            return FASTQ_SCAN_GRAMMAR;
+        pos = plus.next;
+        for ( qualLines = 0; qualLines < seqLines; ++qualLines )
+        {
+            ScanLine* line = & qual[qualLines];
+            if ( pos == size )
+                return eof ? FASTQ_SCAN_GRAMMAR : FASTQ_SCAN_MORE;
+            if ( NextLine ( buf, size, eof, pos, line ) != 0 )
+                return FASTQ_SCAN_MORE;
+            if ( line->end == line->start ||
+                 ! ValidQuality ( buf + line->start, line->end - line->start, floor, ceiling ) )
+                return FASTQ_SCAN_GRAMMAR;
+            pos = line->next;
+        }
+    }
+
+    /* the next record has to start right here */
+    if ( pos == size )
+    {
+        if ( ! eof )
+            return FASTQ_SCAN_MORE;
+    }
+    else if ( buf[pos] != '@' && buf[pos] != '>' )
+        return FASTQ_SCAN_GRAMMAR;
+
+    /* accepted: copy the raw record once, then join multi-line reads/qualities in place
+       the same way ExpandRead()/ExpandQuality() do */
+    {
+        struct FastqRecord* rec = pb->record;
+        char* src;
+        size_t i;
+        if ( KDataBufferResize ( & rec->source, pos ) != 0 )
+            return FASTQ_SCAN_GRAMMAR;
+        src = ( char* ) rec->source.base;
+        memmove ( src, buf, pos );
+
+        pb->length = pos;
+        pb->spotNameOffset = tag.spotNameOffset;
+        pb->spotNameLength = tag.spotNameLength;
+        pb->spotGroupOffset = tag.spotGroupOffset;
+        pb->spotGroupLength = tag.spotGroupLength;
+        pb->secondaryReadNumber = secondary;
+        rec->seq.readnumber = readnumber;
+        rec->seq.lowQuality = tag.lowQuality;
+        rec->seq.is_colorspace = colorspace;
+
+        pb->readOffset = seq[0].start;
+        pb->readLength = seq[0].end - seq[0].start;
+        for ( i = 1; i < seqLines; ++i )
+        {
+            size_t len = seq[i].end - seq[i].start;
+            memmove ( src + pb->readOffset + pb->readLength, src + seq[i].start, len );
+            pb->readLength += len;
+        }
+        /* where the lexer would have left it */
+        pb->expectedQualityLines = ( qualLines > 0 ) ? 1 : seqLines;
+
+        if ( qualLines > 0 )
+        {
+            pb->qualityAsciiOffset = qualOffset;
+            pb->qualityOffset = qual[0].start;
+            pb->qualityLength = qual[0].end - qual[0].start;
+            for ( i = 1; i < qualLines; ++i )
+            {
+                size_t len = qual[i].end - qual[i].start;
+                memmove ( src + pb->qualityOffset + pb->qualityLength, src + qual[i].start, len );
+                pb->qualityLength += len;
+            }
+        }
+    }
+    return FASTQ_SCAN_RECORD;
+}
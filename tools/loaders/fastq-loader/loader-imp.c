@@ -54,6 +54,44 @@
 
 #include "fastq-reader.h"
 
+/* opens the next of seqFile[] starting at *i that is not one of the interleaved pair; NULL if there are no more */
+static
+rc_t OpenNextFile( const ReaderFile **reader,
+                   unsigned *i,
+                   const KDirectory *dir,
+                   unsigned seqFiles,
+                   char const *seqFile[],
+                   INSDC_SRA_platform_id platform,
+                   enum FASTQQualityFormat qualityFormat,
+                   bool ignoreSpotGroups,
+                   const char* read1file,
+                   const char* read2file )
+{
+    *reader = NULL;
+    for ( ; *i < seqFiles; ++ *i )
+    {
+        int8_t defaultReadNumber = 0;
+        char const *const file = seqFile[ *i ];
+        size_t maxSize = string_size( file );
+        if ( read1file != NULL && string_cmp( read1file, string_size( read1file ), file, maxSize, maxSize) == 0 )
+        {
+            continue; // already processed
+        }
+        else if ( read2file != NULL && string_cmp( read2file, string_size( read2file ), file, maxSize, maxSize) == 0 )
+        {
+            continue; // already processed
+        }
+        else if (platform == SRA_PLATFORM_PACBIO_SMRT)
+        {
+            defaultReadNumber = -1;
+        }
+
+        ++ *i;
+        return FastqReaderFileMake(reader, dir, file, qualityFormat, defaultReadNumber, ignoreSpotGroups, false);
+    }
+    return 0;
+}
+
 rc_t ArchiveFASTQ(CommonWriterSettings* G,
                 VDBManager *mgr,
                 VDatabase *db,
@@ -67,6 +105,7 @@ rc_t ArchiveFASTQ(CommonWriterSettings* G,
     rc_t rc = 0;
     unsigned i;
     CommonWriter cw;
+    const ReaderFile *next = NULL;
 
     KDirectory *dir;
     rc = KDirectoryNativeDir(&dir);
@@ -112,35 +151,32 @@ rc_t ArchiveFASTQ(CommonWriterSettings* G,
         }
     }
 
-    // go through non-interleaved input files, skipping the ones just interleaved
-    for (i = 0; i < seqFiles; ++i) {
-        int8_t defaultReadNumber = 0;
-        size_t maxSize = string_size( seqFile[ i ] );
-        if ( read1file != NULL && string_cmp( read1file, string_size( read1file ), seqFile[ i ], maxSize, maxSize) == 0 )
-        {
-            continue; // already processed
-        }
-        else if ( read2file != NULL && string_cmp( read2file, string_size( read2file ), seqFile[ i ], maxSize, maxSize) == 0 )
+    // go through non-interleaved input files, skipping the ones just interleaved;
+    // the file after the one being archived is opened and parsed ahead
+    i = 0;
+    if (rc == 0)
+    {
+        rc = OpenNextFile( &next, &i, dir, seqFiles, seqFile, G->platform, qualityFormat, ignoreSpotGroups, read1file, read2file );
+    }
+    while ( rc == 0 && next != NULL )
+    {
+        const ReaderFile *reader = next;
+        next = NULL;
+
+        rc = OpenNextFile( &next, &i, dir, seqFiles, seqFile, G->platform, qualityFormat, ignoreSpotGroups, read1file, read2file );
+        if ( rc == 0 && next != NULL )
         {
-            continue; // already processed
+            rc = CommonWriterPrefetch( &cw, next );
         }
-        else if (G->platform == SRA_PLATFORM_PACBIO_SMRT)
+        if ( rc == 0 )
         {
-            defaultReadNumber = -1;
+            rc = CommonWriterArchive( &cw, reader, NULL );
         }
-
-        const ReaderFile *reader;
-        rc = FastqReaderFileMake(&reader, dir, seqFile[i], qualityFormat, defaultReadNumber, ignoreSpotGroups, false);
-        if (rc == 0)
         {
-            rc = CommonWriterArchive( &cw, reader, NULL );
-            if (rc != 0)
-                ReaderFileRelease(reader);
-            else
-                rc = ReaderFileRelease(reader);
+            rc_t rc2 = ReaderFileRelease(reader);
+            if (rc == 0)
+                rc = rc2;
         }
-        if (rc != 0)
-            break;
     }
     if (rc == 0)
     {
@@ -150,6 +186,11 @@ rc_t ArchiveFASTQ(CommonWriterSettings* G,
     else
         CommonWriterComplete( &cw, true, 0 );
 
+    if ( next != NULL )
+    {   /* only after CommonWriterComplete() has stopped parsing it */
+        ReaderFileRelease( next );
+    }
+
     G->errCount = cw.err_count;
 
     {
@@ -2867,6 +2867,41 @@ void CC FASTQScan_skip_to_eol(FASTQParseBlock* pb)
     }
 }
 
+void CC FASTQScan_reset(FASTQParseBlock* pb, size_t line_no)
+{   /* forget the buffered input, the next token will be read at the current input position */
+    struct yyguts_t* yyg = (struct yyguts_t*)pb->scanner;
+    if ( ! YY_CURRENT_BUFFER )
+    {
+        yyensure_buffer_stack(pb->scanner);
+        YY_CURRENT_BUFFER_LVALUE = yy_create_buffer(yyin, YY_BUF_SIZE, pb->scanner);
+    }
+    yy_flush_buffer(YY_CURRENT_BUFFER, pb->scanner);
+
+    yyg->yy_start_stack_ptr = 0;
+    BEGIN INITIAL;
+    yy_push_state(INITIAL, pb->scanner);
+
+    yylineno = (int)line_no;
+    pb->column = 1;
+}
+
+bool CC FASTQScan_clean(const FASTQParseBlock* pb)
+{   /* true if the lexer would start the next record the same way as from scratch:
+       at the beginning of a line, or past a tag line start that has been pushed back */
+    struct yyguts_t* yyg = (struct yyguts_t*)pb->scanner;
+    if ( ! YY_CURRENT_BUFFER )
+        return true;
+    switch ( YY_START )
+    {
+    case INITIAL:
+        return YY_AT_BOL();
+    case TAG_LINE:
+        return yyg->yy_hold_char == '@' || yyg->yy_hold_char == '>';
+    default:
+        return false;
+    }
+}
+
 void CC FASTQ_unlex(FASTQParseBlock* pb, FASTQToken* token)
 {
     size_t i;
@@ -63,6 +63,7 @@ GeneralLoader :: DatabaseLoader :: DatabaseLoader ( const std::string&  p_progra
     m_schema ( 0 ),
     m_databaseNameOverridden ( ! m_databaseName.empty() )
 {
+    atomic32_set ( & m_writerFailed, 0 );
     m_databases . insert ( Databases :: value_type ( 0, (VDatabase*)0 ) ); // reserve root database
 }
 
@@ -71,6 +72,8 @@ GeneralLoader :: DatabaseLoader :: ~DatabaseLoader ()
     m_tables . clear();
     m_columns . clear ();
 
+    StopWriters ();
+
     for ( Cursors::iterator it = m_cursors . begin(); it != m_cursors . end(); ++it )
     {
         VCursorRelease ( *it );
@@ -449,6 +452,27 @@ GeneralLoader :: DatabaseLoader :: DBMetadataNode ( uint32_t p_objId, const stri
               "n=%s,v=%s,i=%u",
               p_metadata_node . c_str(), p_value.c_str(), p_objId );
 
+    if ( m_databases . find ( p_objId ) == m_databases . end() )
+    {
+        return RC ( rcExe, rcFile, rcReading, rcDatabase, rcNotFound );
+    }
+
+    if ( ! m_writers . empty () )
+    {   // the writer threads are updating the same databases; write it after they stop
+        DBMetadata md;
+        md . objId = p_objId;
+        md . node  = p_metadata_node;
+        md . value = p_value;
+        m_dbMetadata . push_back ( md );
+        return 0;
+    }
+
+    return WriteDBMetadata ( p_objId, p_metadata_node, p_value );
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: WriteDBMetadata ( uint32_t p_objId, const string& p_metadata_node, const string& p_value )
+{
     rc_t rc = 0;
     Databases::iterator it = m_databases . find ( p_objId );
     if ( it != m_databases . end() )
@@ -487,6 +511,14 @@ GeneralLoader :: DatabaseLoader :: TblMetadataNode ( uint32_t p_objId, const str
     {
         struct VTable* tbl;
         assert ( m_cursors [ it -> second . cursorIdx ] );
+        if ( ! m_writers . empty () )
+        {   // the writer thread may be using the cursor
+            rc = m_writers [ it -> second . cursorIdx ] -> Drain ();
+            if ( rc != 0 )
+            {
+                return rc;
+            }
+        }
         rc = VCursorOpenParentUpdate ( m_cursors [ it -> second . cursorIdx ], &tbl );
         if ( rc == 0 )
         {
@@ -637,7 +669,14 @@ GeneralLoader :: DatabaseLoader :: CellData ( uint32_t p_columnId, const void* p
                   "database-loader: columnIdx = $(i), elem size=$(s) bits, elem count=$(c)",
                   "i=%u,s=%u,c=%u",
                   col . columnIdx, col . elemBits, p_elemCount );
-        rc = CursorWrite ( col, p_data, p_elemCount );
+        if ( m_writers . empty () )
+        {
+            rc = CursorWrite ( col, p_data, p_elemCount );
+        }
+        else
+        {
+            rc = m_writers [ col . cursorIdx ] -> CellData ( col, p_data, p_elemCount );
+        }
     }
     else
     {
@@ -658,7 +697,14 @@ GeneralLoader :: DatabaseLoader :: CellDefault ( uint32_t p_columnId, const void
                   "database-loader: columnIdx = $(i), elem size=$(s) bits, elem count=$(c)",
                   "i=%u,s=%u,c=%u",
                   col . columnIdx, col . elemBits, p_elemCount );
-        rc = CursorDefault ( col, p_data, p_elemCount );
+        if ( m_writers . empty () )
+        {
+            rc = CursorDefault ( col, p_data, p_elemCount );
+        }
+        else
+        {
+            rc = m_writers [ col . cursorIdx ] -> CellDefault ( col, p_data, p_elemCount );
+        }
     }
     else
     {
@@ -741,15 +787,68 @@ GeneralLoader :: DatabaseLoader :: OpenStream ()
             }
         }
     }
+    if ( rc == 0 )
+    {   // from here on, each table is written on a thread of its own
+        for ( Cursors::iterator it = m_cursors . begin(); it != m_cursors . end(); ++it )
+        {
+            TableWriter * writer = new TableWriter ( *it, & m_writerFailed );
+            m_writers . push_back ( writer );
+            rc = writer -> Start ();
+            if ( rc != 0 )
+            {
+                StopWriters ();
+                break;
+            }
+        }
+    }
     return rc;
 }
 
 rc_t
-GeneralLoader :: DatabaseLoader :: CloseStream ()
+GeneralLoader :: DatabaseLoader :: StopWriters ()
 {
     rc_t rc = 0;
-    rc_t rc2 = 0;
+    for ( Writers::iterator it = m_writers . begin(); it != m_writers . end(); ++it )
+    {
+        rc_t rc2 = ( *it ) -> Stop ();
+        if ( rc == 0 )
+        {
+            rc = rc2;
+        }
+        delete *it;
+    }
+    m_writers . clear ();
+    return rc;
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: WriterFailure () const
+{
+    if ( atomic32_read ( & m_writerFailed ) == 0 )
+    {
+        return 0;
+    }
+    for ( Writers::const_iterator it = m_writers . begin(); it != m_writers . end(); ++it )
+    {
+        rc_t rc = ( *it ) -> Failure ();
+        if ( rc != 0 )
+        {
+            return rc;
+        }
+    }
+    return 0;
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: CloseStream ()
+{
+    rc_t rc = StopWriters ();
+    if ( rc != 0 )
+    {   // cursors and databases are released by the destructor
+        return rc;
+    }
 
+    rc_t rc2 = 0;
     for ( Cursors::iterator it = m_cursors . begin(); it != m_cursors . end(); ++it )
     {
         rc = VCursorCloseRow ( *it );
@@ -794,6 +893,19 @@ GeneralLoader :: DatabaseLoader :: CloseStream ()
         }
     }
 
+    if ( rc == 0 )
+    {   // save database-level metadata that arrived while the writers were running
+        for ( DBMetadataQueue::const_iterator it = m_dbMetadata . begin(); it != m_dbMetadata . end(); ++it )
+        {
+            rc = WriteDBMetadata ( it -> objId, it -> node, it -> value );
+            if ( rc != 0 )
+            {
+                break;
+            }
+        }
+    }
+    m_dbMetadata . clear ();
+
     for ( Databases::iterator it = m_databases . begin(); it != m_databases . end(); ++it )
     {
         VDatabaseRelease ( it -> second );
@@ -808,7 +920,11 @@ GeneralLoader :: DatabaseLoader :: NextRow ( uint32_t p_tableId )
 {
     rc_t rc = 0;
     Tables::const_iterator table = m_tables . find ( p_tableId );
-    if ( table != m_tables . end() )
+    if ( table != m_tables . end() && ! m_writers . empty () )
+    {
+        rc = m_writers [ table -> second . cursorIdx ] -> NextRow ();
+    }
+    else if ( table != m_tables . end() )
     {
         VCursor * cursor = m_cursors [ table -> second . cursorIdx ];
         rc = VCursorCommitRow ( cursor );
@@ -833,7 +949,11 @@ GeneralLoader :: DatabaseLoader :: MoveAhead ( uint32_t p_tableId, uint64_t p_co
 {
     rc_t rc = 0;
     Tables::const_iterator table = m_tables . find ( p_tableId );
-    if ( table != m_tables . end() )
+    if ( table != m_tables . end() && ! m_writers . empty () )
+    {
+        rc = m_writers [ table -> second . cursorIdx ] -> MoveAhead ( p_count );
+    }
+    else if ( table != m_tables . end() )
     {
         VCursor * cursor = m_cursors [ table -> second . cursorIdx ];
         for ( uint64_t i = 0; i < p_count; ++i )
@@ -862,6 +982,70 @@ GeneralLoader :: DatabaseLoader :: MoveAhead ( uint32_t p_tableId, uint64_t p_co
     return rc;
 }
 
+rc_t
+GeneralLoader :: DatabaseLoader :: CellRows ( uint32_t p_columnId, const void* p_data, size_t p_elemCount, const uint32_t* p_rowLengths, uint32_t p_rowCount )
+{
+    rc_t rc = 0;
+    Columns::const_iterator curIt = m_columns . find ( p_columnId );
+    if ( curIt != m_columns . end () )
+    {
+        const Column& col = curIt -> second;
+        pLogMsg ( klogDebug,
+                  "database-loader: columnIdx = $(i), elem size=$(s) bits, row count=$(r)",
+                  "i=%u,s=%u,r=%u",
+                  col . columnIdx, col . elemBits, p_rowCount );
+
+        uint64_t total = 0;
+        for ( uint32_t i = 0; i < p_rowCount; ++i )
+        {
+            total += p_rowLengths [ i ];
+        }
+        // the packed protocol sends whole bytes, so compare the sizes in bytes:
+        // the same as comparing element counts unless the elements are bits
+        if ( ( total * col . elemBits + 7 ) / 8 != ( ( uint64_t ) p_elemCount * col . elemBits + 7 ) / 8 )
+        {
+            pLogMsg ( klogErr,
+                      "database-loader: rows of column $(i) have $(n) elements, event has $(c)",
+                      "i=%u,n=%lu,c=%lu",
+                      p_columnId, ( unsigned long ) total, ( unsigned long ) p_elemCount );
+            rc = RC ( rcExe, rcFile, rcReading, rcData, total > p_elemCount ? rcInsufficient : rcExcessive );
+        }
+        else if ( m_writers . empty () )
+        {   // the rows are kept by the table writers until they are committed
+            rc = RC ( rcExe, rcCursor, rcWriting, rcCursor, rcNotOpen );
+        }
+        else
+        {
+            rc = m_writers [ col . cursorIdx ] -> CellRows ( col, p_data, p_rowLengths, p_rowCount );
+        }
+    }
+    else
+    {
+        rc = RC ( rcExe, rcFile, rcReading, rcColumn, rcNotFound );
+    }
+    return rc;
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: NextRows ( uint32_t p_tableId, uint64_t p_count )
+{
+    rc_t rc = 0;
+    Tables::const_iterator table = m_tables . find ( p_tableId );
+    if ( table != m_tables . end() && ! m_writers . empty () )
+    {
+        rc = m_writers [ table -> second . cursorIdx ] -> NextRows ( p_count );
+    }
+    else if ( table != m_tables . end() )
+    {   // without a writer there can be no rows waiting, same as moving ahead
+        rc = MoveAhead ( p_tableId, p_count );
+    }
+    else
+    {
+        rc = RC ( rcExe, rcFile, rcReading, rcTable, rcNotFound );
+    }
+    return rc;
+}
+
 rc_t
 GeneralLoader :: DatabaseLoader :: ErrorMessage ( const string & p_text )
 {
@@ -28,12 +28,17 @@
 #define _sra_tools_hpp_general_loader_
 
 #include <klib/defs.h>
+#include <atomic32.h>
 
 #include <string>
 #include <vector>
+#include <deque>
 #include <map>
 
 struct KStream;
+struct KThread;
+struct KLock;
+struct KCondition;
 struct VCursor;
 struct VDatabase;
 struct VDBManager;
@@ -138,18 +143,118 @@ private:
         rc_t CellDefault ( uint32_t p_columnId, const void* p_data, size_t p_elemCount );
         rc_t NextRow ( uint32_t p_tableId );
         rc_t MoveAhead ( uint32_t p_tableId, uint64_t p_count );
+        // p_data holds p_rowCount cells back to back, p_elemCount elements in all
+        rc_t CellRows ( uint32_t p_columnId, const void* p_data, size_t p_elemCount, const uint32_t* p_rowLengths, uint32_t p_rowCount );
+        rc_t NextRows ( uint32_t p_tableId, uint64_t p_count );
         rc_t ErrorMessage ( const std :: string& p_text );
         rc_t LogMessage ( const std :: string& p_text );
         rc_t ProgressMessage ( const std :: string& p_name, uint32_t p_pid, uint32_t p_timestamp, uint32_t p_version, uint32_t p_percent );
         rc_t OpenStream ();
         rc_t CloseStream ();
+
+        // the first error of any table writer thread; the parser checks it after every event
+        rc_t WriterFailure () const;
         
         const std :: string& GetDatabaseName() const { return m_databaseName; }
         const Column* GetColumn ( uint32_t p_columnId ) const; 
         
     private:
+        // Writes the cell and row events of one table on a thread of its own.
+        // Events are collected into batches which are handed to the thread
+        // through a bounded queue, so the order of events within the table is preserved.
+        // Errors from the cursor are reported by the next call after they happen.
+        class TableWriter
+        {
+        public:
+            static const size_t MaxBatchBytes = 1024 * 1024;
+            static const size_t MaxBatchEvents = 64 * 1024;
+            static const size_t MaxQueuedBatches = 4;
+
+        public:
+            // p_failed is shared by all the writers of the loader, and set by the first one to fail
+            TableWriter ( struct VCursor * p_cursor, atomic32_t * p_failed );
+            ~TableWriter ();
+
+            rc_t Start ();
+
+            rc_t CellData    ( const Column& p_col, const void* p_data, size_t p_elemCount );
+            rc_t CellDefault ( const Column& p_col, const void* p_data, size_t p_elemCount );
+            rc_t NextRow ();
+            rc_t MoveAhead ( uint64_t p_count );
+
+            // the cells of one column for several rows, kept until NextRows commits the rows;
+            // all columns sending rows before the same NextRows have to send the same number of rows,
+            // each of them once
+            rc_t CellRows ( const Column& p_col, const void* p_data, const uint32_t* p_rowLengths, uint32_t p_rowCount );
+            rc_t NextRows ( uint64_t p_count );
+
+            // wait until everything queued so far has been written to the cursor,
+            // except rows still waiting for their NextRows
+            rc_t Drain ();
+            // drain and stop the thread
+            rc_t Stop ();
+
+            // the first error from the cursor, 0 if none so far
+            rc_t Failure () const;
+
+        private:
+            enum EventType { etCellData, etCellDefault, etNextRow, etMoveAhead, etCellRows, etNextRows };
+
+            struct Event
+            {
+                EventType   type;
+                uint32_t    columnIdx;
+                uint32_t    elemBits;
+                size_t      offset;     // into Batch::data; for etCellRows the row lengths, then the cells
+                uint64_t    count;      // elements, or rows for etMoveAhead, etCellRows, etNextRows
+                bool        hasData;
+            };
+
+            struct Batch
+            {
+                std :: vector < Event >     events;
+                std :: vector < uint8_t >   data;
+            };
+
+        private:
+            TableWriter ( const TableWriter& );
+            TableWriter& operator = ( const TableWriter& );
+
+            rc_t AddEvent ( EventType p_type, const Column* p_col, const void* p_data, uint64_t p_count );
+            rc_t Added ();
+            rc_t Flush ();
+            rc_t Apply ( const Batch& p_batch );
+            rc_t CommitRow ();
+            rc_t CommitRows ( const Batch& p_batch, const std :: vector < const Event* >& p_rows, uint64_t p_count );
+            rc_t Run ();
+
+            static rc_t CC ThreadFn ( const struct KThread* p_self, void* p_data );
+
+        private:
+            struct VCursor*         m_cursor;
+            struct KThread*         m_thread;
+            struct KLock*           m_lock;
+            struct KCondition*      m_dataReady;    // a batch was queued, or stopping
+            struct KCondition*      m_spaceReady;   // a batch was written
+
+            Batch*                  m_current;      // being filled by the parser
+            std :: deque < Batch* > m_queue;        // waiting to be written
+            std :: vector < Batch* > m_free;        // written, ready for reuse
+
+            uint64_t                m_pendingRows;  // sent by CellRows, not yet committed by NextRows
+            std :: vector < uint32_t > m_pendingColumns; // the columns that sent them
+
+            bool                    m_busy;         // the thread is writing a batch
+            bool                    m_stopping;
+            rc_t                    m_rc;           // first error from the cursor
+            atomic32_t*             m_failed;       // set along with m_rc
+        };
+
         // Active Cursors
         typedef std::vector < struct VCursor * > Cursors;
+
+        // Writers of the active cursors, by cursor index; only while the stream is open
+        typedef std::vector < TableWriter * > Writers;
         
         // from TableId to Table
         typedef std::map < uint32_t, Table > Tables; 
@@ -162,12 +267,24 @@ private:
         
         // From database id to parent database id 
         typedef std::map < uint32_t, uint32_t > DatabaseToParent; 
+
+        // database-level metadata received while the writers are running,
+        // written to the databases once the writers have stopped
+        struct DBMetadata
+        {
+            uint32_t        objId;
+            std :: string   node;
+            std :: string   value;
+        };
+        typedef std::vector < DBMetadata > DBMetadataQueue;
         
     private:
         rc_t MakeDatabase ( uint32_t p_id );
         rc_t CursorWrite   ( const Column& p_col, const void* p_data, size_t p_size );
         rc_t CursorDefault ( const Column& p_col, const void* p_data, size_t p_size );
         rc_t SaveColumnMetadata ( const Column& p_col );
+        rc_t StopWriters ();
+        rc_t WriteDBMetadata ( uint32_t p_objId, const std :: string& p_metadata_node, const std :: string& p_value );
 
     private:
         Paths                   m_includePaths;
@@ -181,6 +298,9 @@ private:
         ver_t                   m_softwareVersion;
     
         Cursors                 m_cursors;
+        Writers                 m_writers;
+        atomic32_t              m_writerFailed; // set by the first writer to fail
+        DBMetadataQueue         m_dbMetadata;
         Tables                  m_tables;
         Columns                 m_columns;
         Databases               m_databases;    
@@ -213,11 +333,15 @@ private:
         virtual rc_t ParseEvents ( Reader&, DatabaseLoader& );
         
     private:
-        // read p_dataSize bytes and use one of the decoder functions in utf8-like-int-codec.h to unpack a sequence of integer values, 
+        // decode p_dataSize bytes at p_data with one of the decoder functions in utf8-like-int-codec.h to unpack a sequence of integer values, 
         // stored in m_unpackingBuf as a collection of bytes
-        template < typename T_uintXX > rc_t UncompressInt ( Reader& p_reader, uint32_t p_dataSize, int ( * p_decode ) ( uint8_t const* buf_start, uint8_t const* buf_xend, T_uintXX* ret_decoded ) );
+        template < typename T_uintXX > rc_t UncompressInt ( const void* p_data, uint32_t p_dataSize, int ( * p_decode ) ( uint8_t const* buf_start, uint8_t const* buf_xend, T_uintXX* ret_decoded ) );
+        
+        // unpack p_dataSize bytes of an integer-packed column into m_unpackingBuf
+        rc_t Uncompress ( const DatabaseLoader :: Column& p_col, const void* p_data, uint32_t p_dataSize );
         
         rc_t ParseData ( Reader& p_reader, DatabaseLoader& p_dbLoader, uint32_t p_columnId, uint32_t p_dataSize );
+        rc_t ParseRows ( Reader& p_reader, DatabaseLoader& p_dbLoader, uint32_t p_columnId, uint32_t p_rowCount, uint32_t p_dataSize );
         
         std::vector<uint8_t>    m_unpackingBuf;
     };
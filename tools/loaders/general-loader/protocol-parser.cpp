@@ -379,6 +379,53 @@ GeneralLoader :: UnpackedProtocolParser :: ParseEvents ( Reader& p_reader, Datab
             }
             break;
 
+        case evt_cell_rows:
+            {
+                uint32_t columnId = ncbi :: id ( evt_header );
+                pLogMsg ( klogDebug, "protocol-parser event: Cell-Rows, id=$(i)", "i=%u", columnId );
+
+                gw_rows_evt_v1 evt;
+                rc = ReadEvent ( p_reader, evt );
+                if ( rc == 0 )
+                {
+                    const DatabaseLoader :: Column* col = p_dbLoader . GetColumn ( columnId );
+                    if ( col != 0 )
+                    {
+                        size_t rowCount = ncbi :: row_count ( evt );
+                        size_t elemCount = ncbi :: elem_count ( evt );
+                        size_t lengthsSize = sizeof ( uint32_t ) * rowCount;
+                        rc = p_reader . Read ( lengthsSize + ( col -> elemBits * elemCount + 7 ) / 8 );
+                        if ( rc == 0 )
+                        {
+                            rc = p_dbLoader . CellRows ( columnId,
+                                                         static_cast < const uint8_t* > ( p_reader . GetBuffer () ) + lengthsSize,
+                                                         elemCount,
+                                                         static_cast < const uint32_t* > ( p_reader . GetBuffer () ),
+                                                         ( uint32_t ) rowCount );
+                        }
+                    }
+                    else
+                    {
+                        rc = RC ( rcExe, rcFile, rcReading, rcColumn, rcNotFound );
+                    }
+                }
+            }
+            break;
+
+        case evt_next_rows:
+            {
+                uint32_t tableId = ncbi :: id ( evt_header );
+                pLogMsg ( klogDebug, "protocol-parser event: Next-Rows, id=$(i)", "i=%u", tableId );
+
+                gw_move_ahead_evt_v1 evt;
+                rc = ReadEvent ( p_reader, evt );
+                if ( rc == 0 )
+                {
+                    rc = p_dbLoader . NextRows ( tableId, ncbi :: get_nrows ( evt ) );
+                }
+            }
+            break;
+
         case evt_errmsg:
             {
                 LogMsg ( klogDebug, "protocol-parser event: Error-Message" );
@@ -450,6 +497,11 @@ GeneralLoader :: UnpackedProtocolParser :: ParseEvents ( Reader& p_reader, Datab
             rc = RC ( rcExe, rcFile, rcReading, rcData, rcUnexpected );
             break;
         }
+
+        if ( rc == 0 )
+        {   // stop on the first failure of any table's writer thread
+            rc = p_dbLoader . WriterFailure ();
+        }
     }
     while ( rc == 0 );
 
@@ -460,13 +512,13 @@ GeneralLoader :: UnpackedProtocolParser :: ParseEvents ( Reader& p_reader, Datab
 
 template < typename T_uintXX >
 rc_t
-GeneralLoader :: PackedProtocolParser :: UncompressInt (  Reader& p_reader, uint32_t p_dataSize, int (*p_decode) ( uint8_t const* buf_start, uint8_t const* buf_xend, T_uintXX* ret_decoded )  )
+GeneralLoader :: PackedProtocolParser :: UncompressInt (  const void* p_data, uint32_t p_dataSize, int (*p_decode) ( uint8_t const* buf_start, uint8_t const* buf_xend, T_uintXX* ret_decoded )  )
 {
     m_unpackingBuf . clear();
     // reserve enough for the best-packed case, when each element is represented with 1 byte
     m_unpackingBuf . reserve ( sizeof ( T_uintXX ) * p_dataSize );
 
-    const uint8_t* buf_begin = reinterpret_cast<const uint8_t*> ( p_reader . GetBuffer() );
+    const uint8_t* buf_begin = reinterpret_cast<const uint8_t*> ( p_data );
     const uint8_t* buf_end   = buf_begin + p_dataSize;
     while ( buf_begin < buf_end )
     {
@@ -489,6 +541,23 @@ GeneralLoader :: PackedProtocolParser :: UncompressInt (  Reader& p_reader, uint
     return 0;
 }
 
+rc_t
+GeneralLoader :: PackedProtocolParser :: Uncompress ( const DatabaseLoader :: Column& p_col, const void* p_data, uint32_t p_dataSize )
+{
+    switch ( p_col . elemBits )
+    {
+    case 16:
+        return UncompressInt ( p_data, p_dataSize, decode_uint16 );
+    case 32:
+        return UncompressInt ( p_data, p_dataSize, decode_uint32 );
+    case 64:
+        return UncompressInt ( p_data, p_dataSize, decode_uint64 );
+    default:
+        LogMsg ( klogErr, "protocol-parser: bad element size for packed integer" );
+        return RC ( rcExe, rcFile, rcReading, rcData, rcInvalid );
+    }
+}
+
 rc_t
 GeneralLoader :: PackedProtocolParser :: ParseData ( Reader& p_reader, DatabaseLoader& p_dbLoader, uint32_t p_columnId, uint32_t p_dataSize )
 {
@@ -501,22 +570,7 @@ GeneralLoader :: PackedProtocolParser :: ParseData ( Reader& p_reader, DatabaseL
         {
             if ( col -> IsCompressed () )
             {
-                switch ( col -> elemBits )
-                {
-                case 16:
-                    rc = UncompressInt ( p_reader, p_dataSize, decode_uint16 );
-                    break;
-                case 32:
-                    rc = UncompressInt ( p_reader, p_dataSize, decode_uint32 );
-                    break;
-                case 64:
-                    rc = UncompressInt ( p_reader, p_dataSize, decode_uint64 );
-                    break;
-                default:
-                    LogMsg ( klogErr, "protocol-parser: bad element size for packed integer" );
-                    rc = RC ( rcExe, rcFile, rcReading, rcData, rcInvalid );
-                    break;
-                }
+                rc = Uncompress ( * col, p_reader . GetBuffer (), p_dataSize );
                 if ( rc == 0 )
                 {
                     rc = p_dbLoader . CellData ( p_columnId, m_unpackingBuf . data(), m_unpackingBuf . size() * 8 / col -> elemBits );
@@ -535,6 +589,40 @@ GeneralLoader :: PackedProtocolParser :: ParseData ( Reader& p_reader, DatabaseL
     return rc;
 }
 
+rc_t
+GeneralLoader :: PackedProtocolParser :: ParseRows ( Reader& p_reader, DatabaseLoader& p_dbLoader, uint32_t p_columnId, uint32_t p_rowCount, uint32_t p_dataSize )
+{
+    rc_t rc = 0;
+    const DatabaseLoader :: Column* col = p_dbLoader . GetColumn ( p_columnId );
+    if ( col != 0 )
+    {   // row lengths and cells in one read, so that both stay in the reader's buffer
+        size_t const lengthsSize = sizeof ( uint32_t ) * ( size_t ) p_rowCount;
+        rc = p_reader . Read ( lengthsSize + p_dataSize );
+        if ( rc == 0 )
+        {
+            const uint32_t* rowLengths = static_cast < const uint32_t* > ( p_reader . GetBuffer () );
+            const uint8_t* data = static_cast < const uint8_t* > ( p_reader . GetBuffer () ) + lengthsSize;
+            if ( col -> IsCompressed () && p_dataSize != 0 )
+            {
+                rc = Uncompress ( * col, data, p_dataSize );
+                if ( rc == 0 )
+                {
+                    rc = p_dbLoader . CellRows ( p_columnId, m_unpackingBuf . data(), m_unpackingBuf . size() * 8 / col -> elemBits, rowLengths, p_rowCount );
+                }
+            }
+            else
+            {
+                rc = p_dbLoader . CellRows ( p_columnId, data, ( size_t ) p_dataSize * 8 / col -> elemBits, rowLengths, p_rowCount );
+            }
+        }
+    }
+    else
+    {
+        rc = RC ( rcExe, rcFile, rcReading, rcColumn, rcNotFound );
+    }
+    return rc;
+}
+
 rc_t
 GeneralLoader :: PackedProtocolParser :: ParseEvents( Reader& p_reader, DatabaseLoader& p_dbLoader )
 {
@@ -951,6 +1039,34 @@ GeneralLoader :: PackedProtocolParser :: ParseEvents( Reader& p_reader, Database
             }
             break;
 
+        case evt_cell_rows:
+            {
+                uint32_t columnId = ncbi :: id ( evt_header );
+                pLogMsg ( klogDebug, "protocol-parser event: Cell-Rows (packed), id=$(i)", "i=%u", columnId );
+
+                gwp_rows_evt_v1 evt;
+                rc = ReadEvent ( p_reader, evt );
+                if ( rc == 0 )
+                {
+                    rc = ParseRows ( p_reader, p_dbLoader, columnId, ncbi :: row_count ( evt ), ncbi :: size ( evt ) );
+                }
+            }
+            break;
+
+        case evt_next_rows:
+            {
+                uint32_t tableId = ncbi :: id ( evt_header );
+                pLogMsg ( klogDebug, "protocol-parser event: Next-Rows (packed), id=$(i)", "i=%u", tableId );
+
+                gwp_move_ahead_evt_v1 evt;
+                rc = ReadEvent ( p_reader, evt );
+                if ( rc == 0 )
+                {
+                    rc = p_dbLoader . NextRows ( tableId, ncbi :: get_nrows ( evt ) );
+                }
+            }
+            break;
+
         case evt_errmsg:
             {
                 LogMsg ( klogDebug, "protocol-parser event: Error-Message (packed)" );
@@ -1040,6 +1156,11 @@ GeneralLoader :: PackedProtocolParser :: ParseEvents( Reader& p_reader, Database
             rc = RC ( rcExe, rcFile, rcReading, rcData, rcUnexpected );
             break;
         }
+
+        if ( rc == 0 )
+        {   // stop on the first failure of any table's writer thread
+            rc = p_dbLoader . WriterFailure ();
+        }
     }
     while ( rc == 0 );
 
@@ -0,0 +1,456 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ */
+
+
+#include "general-loader.hpp"
+
+#include <klib/rc.h>
+#include <klib/log.h>
+
+#include <kproc/thread.h>
+#include <kproc/lock.h>
+#include <kproc/cond.h>
+
+#include <vdb/cursor.h>
+
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+///////////// GeneralLoader::DatabaseLoader::TableWriter
+
+GeneralLoader :: DatabaseLoader :: TableWriter :: TableWriter ( VCursor * p_cursor, atomic32_t * p_failed )
+:   m_cursor ( p_cursor ),
+    m_thread ( 0 ),
+    m_lock ( 0 ),
+    m_dataReady ( 0 ),
+    m_spaceReady ( 0 ),
+    m_current ( new Batch () ),
+    m_pendingRows ( 0 ),
+    m_busy ( false ),
+    m_stopping ( false ),
+    m_rc ( 0 ),
+    m_failed ( p_failed )
+{
+}
+
+GeneralLoader :: DatabaseLoader :: TableWriter :: ~TableWriter ()
+{
+    if ( m_thread != 0 )
+    {
+        Stop ();
+    }
+
+    delete m_current;
+    for ( deque < Batch* > :: iterator it = m_queue . begin (); it != m_queue . end (); ++it )
+    {
+        delete * it;
+    }
+    for ( vector < Batch* > :: iterator it = m_free . begin (); it != m_free . end (); ++it )
+    {
+        delete * it;
+    }
+
+    KConditionRelease ( m_spaceReady );
+    KConditionRelease ( m_dataReady );
+    KLockRelease ( m_lock );
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: TableWriter :: Start ()
+{
+    rc_t rc = KLockMake ( & m_lock );
+    if ( rc == 0 )
+    {
+        rc = KConditionMake ( & m_dataReady );
+        if ( rc == 0 )
+        {
+            rc = KConditionMake ( & m_spaceReady );
+            if ( rc == 0 )
+            {
+                rc = KThreadMake ( & m_thread, ThreadFn, this );
+            }
+        }
+    }
+    return rc;
+}
+
+rc_t CC
+GeneralLoader :: DatabaseLoader :: TableWriter :: ThreadFn ( const KThread* p_self, void* p_data )
+{
+    return static_cast < TableWriter* > ( p_data ) -> Run ();
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: TableWriter :: Run ()
+{
+    KLockAcquire ( m_lock );
+    while ( true )
+    {
+        while ( m_queue . empty () && ! m_stopping )
+        {
+            KConditionWait ( m_dataReady, m_lock );
+        }
+        if ( m_queue . empty () )
+        {   // stopping, and nothing left to write
+            break;
+        }
+
+        Batch* batch = m_queue . front ();
+        m_queue . pop_front ();
+        m_busy = true;
+        bool const failed = m_rc != 0;
+        KLockUnlock ( m_lock );
+
+        // after a failure, keep draining the queue so that the parser never blocks
+        rc_t rc = failed ? 0 : Apply ( * batch );
+
+        KLockAcquire ( m_lock );
+        if ( rc != 0 && m_rc == 0 )
+        {
+            m_rc = rc;
+            atomic32_set ( m_failed, 1 );
+        }
+        m_busy = false;
+        batch -> events . clear ();
+        batch -> data . clear ();
+        m_free . push_back ( batch );
+        KConditionBroadcast ( m_spaceReady );
+    }
+    KLockUnlock ( m_lock );
+    return 0;
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: TableWriter :: CommitRow ()
+{
+    rc_t rc = VCursorCommitRow ( m_cursor );
+    if ( rc == 0 )
+    {
+        rc = VCursorCloseRow ( m_cursor );
+        if ( rc == 0 )
+        {
+            rc = VCursorOpenRow ( m_cursor );
+        }
+    }
+    return rc;
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: TableWriter :: CommitRows ( const Batch& p_batch, const vector < const Event* >& p_rows, uint64_t p_count )
+{   // write row by row, taking the next cell of every column that sent rows
+    vector < const uint8_t* > lengths;
+    vector < const uint8_t* > cells;
+    vector < bitsz_t > offsets;
+    for ( vector < const Event* > :: const_iterator it = p_rows . begin (); it != p_rows . end (); ++it )
+    {
+        const uint8_t* base = & p_batch . data [ ( * it ) -> offset ];
+        lengths . push_back ( base );
+        cells . push_back ( base + sizeof ( uint32_t ) * ( * it ) -> count );
+        offsets . push_back ( 0 );
+    }
+
+    rc_t rc = 0;
+    for ( uint64_t row = 0; rc == 0 && row < p_count; ++row )
+    {
+        for ( size_t i = 0; rc == 0 && i < p_rows . size (); ++i )
+        {
+            uint32_t len;   // the batch data is not aligned
+            memmove ( & len, lengths [ i ] + sizeof len * row, sizeof len );
+            uint32_t const elemBits = p_rows [ i ] -> elemBits;
+            rc = VCursorWrite ( m_cursor, p_rows [ i ] -> columnIdx, elemBits, cells [ i ], offsets [ i ], len );
+            offsets [ i ] += ( bitsz_t ) elemBits * len;
+        }
+        if ( rc == 0 )
+        {
+            rc = CommitRow ();
+        }
+    }
+    return rc;
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: TableWriter :: Apply ( const Batch& p_batch )
+{
+    rc_t rc = 0;
+    vector < const Event* > rows; // etCellRows waiting for their etNextRows
+    for ( vector < Event > :: const_iterator it = p_batch . events . begin (); rc == 0 && it != p_batch . events . end (); ++it )
+    {
+        static const uint8_t empty = 0;
+        const void* data = ! it -> hasData ? 0 : it -> offset < p_batch . data . size () ? & p_batch . data [ it -> offset ] : & empty;
+        switch ( it -> type )
+        {
+        case etCellData:
+            rc = VCursorWrite ( m_cursor, it -> columnIdx, it -> elemBits, data, 0, it -> count );
+            break;
+
+        case etCellDefault:
+            rc = VCursorDefault ( m_cursor, it -> columnIdx, it -> elemBits, data, 0, it -> count );
+            break;
+
+        case etNextRow:
+            rc = CommitRow ();
+            break;
+
+        case etMoveAhead:
+            for ( uint64_t i = 0; rc == 0 && i < it -> count; ++i )
+            {   // for now, simulate proper handling (this will commit the current row and insert count-1 empty rows)
+                rc = CommitRow ();
+            }
+            break;
+
+        case etCellRows:
+            rows . push_back ( & * it );
+            break;
+
+        case etNextRows:
+            rc = CommitRows ( p_batch, rows, it -> count );
+            rows . clear ();
+            break;
+        }
+    }
+    return rc;
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: TableWriter :: AddEvent ( EventType p_type, const Column* p_col, const void* p_data, uint64_t p_count )
+{
+    if ( m_pendingRows != 0 && p_type != etCellDefault )
+    {   // single cells and rows cannot go between CellRows and the NextRows committing them
+        LogMsg ( klogErr, "table-writer: rows sent with Cell-Rows have not been committed by Next-Rows" );
+        return RC ( rcExe, rcCursor, rcWriting, rcRow, rcIncomplete );
+    }
+
+    Event evt;
+    evt . type      = p_type;
+    evt . columnIdx = p_col == 0 ? 0 : p_col -> columnIdx;
+    evt . elemBits  = p_col == 0 ? 0 : p_col -> elemBits;
+    evt . offset    = m_current -> data . size ();
+    evt . count     = p_count;
+    evt . hasData   = p_data != 0;
+
+    if ( p_col != 0 && p_data != 0 )
+    {
+        size_t const bytes = ( evt . elemBits * p_count + 7 ) / 8;
+        m_current -> data . resize ( evt . offset + bytes );
+        if ( bytes != 0 )
+        {
+            memmove ( & m_current -> data [ evt . offset ], p_data, bytes );
+        }
+    }
+    m_current -> events . push_back ( evt );
+
+    return Added ();
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: TableWriter :: Added ()
+{   // rows waiting for their commit stay in one batch with it
+    if ( m_pendingRows == 0 &&
+         ( m_current -> data . size () >= MaxBatchBytes || m_current -> events . size () >= MaxBatchEvents ) )
+    {
+        return Flush ();
+    }
+
+    // report an earlier failure of the thread as soon as possible
+    KLockAcquire ( m_lock );
+    rc_t rc = m_rc;
+    KLockUnlock ( m_lock );
+    return rc;
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: TableWriter :: Flush ()
+{
+    KLockAcquire ( m_lock );
+    if ( ! m_current -> events . empty () )
+    {
+        while ( m_queue . size () >= MaxQueuedBatches )
+        {
+            KConditionWait ( m_spaceReady, m_lock );
+        }
+        m_queue . push_back ( m_current );
+        KConditionSignal ( m_dataReady );
+
+        if ( m_free . empty () )
+        {
+            m_current = new Batch ();
+        }
+        else
+        {
+            m_current = m_free . back ();
+            m_free . pop_back ();
+        }
+    }
+    rc_t rc = m_rc;
+    KLockUnlock ( m_lock );
+    return rc;
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: TableWriter :: CellData ( const Column& p_col, const void* p_data, size_t p_elemCount )
+{
+    return AddEvent ( etCellData, & p_col, p_data, p_elemCount );
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: TableWriter :: CellDefault ( const Column& p_col, const void* p_data, size_t p_elemCount )
+{
+    return AddEvent ( etCellDefault, & p_col, p_data, p_elemCount );
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: TableWriter :: NextRow ()
+{
+    return AddEvent ( etNextRow, 0, 0, 0 );
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: TableWriter :: MoveAhead ( uint64_t p_count )
+{
+    return AddEvent ( etMoveAhead, 0, 0, p_count );
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: TableWriter :: CellRows ( const Column& p_col, const void* p_data, const uint32_t* p_rowLengths, uint32_t p_rowCount )
+{
+    if ( m_pendingRows != 0 && m_pendingRows != p_rowCount )
+    {
+        pLogMsg ( klogErr,
+                  "table-writer: Cell-Rows for $(n) rows, expected $(p)",
+                  "n=%u,p=%lu",
+                  p_rowCount, ( unsigned long ) m_pendingRows );
+        return RC ( rcExe, rcCursor, rcWriting, rcRow, rcInconsistent );
+    }
+    if ( p_rowCount == 0 )
+    {
+        return 0;
+    }
+    if ( find ( m_pendingColumns . begin (), m_pendingColumns . end (), p_col . columnIdx ) != m_pendingColumns . end () )
+    {
+        pLogMsg ( klogErr,
+                  "table-writer: second Cell-Rows for column '$(c)' before Next-Rows",
+                  "c=%s",
+                  p_col . name . c_str () );
+        return RC ( rcExe, rcCursor, rcWriting, rcColumn, rcExists );
+    }
+
+    uint64_t elemCount = 0;
+    for ( uint32_t i = 0; i < p_rowCount; ++i )
+    {
+        elemCount += p_rowLengths [ i ];
+    }
+
+    Event evt;
+    evt . type      = etCellRows;
+    evt . columnIdx = p_col . columnIdx;
+    evt . elemBits  = p_col . elemBits;
+    evt . offset    = m_current -> data . size ();
+    evt . count     = p_rowCount;
+    evt . hasData   = true;
+
+    size_t const lengthsSize = sizeof ( uint32_t ) * p_rowCount;
+    size_t const bytes = ( evt . elemBits * elemCount + 7 ) / 8;
+    m_current -> data . resize ( evt . offset + lengthsSize + bytes );
+    memmove ( & m_current -> data [ evt . offset ], p_rowLengths, lengthsSize );
+    if ( bytes != 0 )
+    {
+        memmove ( & m_current -> data [ evt . offset + lengthsSize ], p_data, bytes );
+    }
+    m_current -> events . push_back ( evt );
+    m_pendingRows = p_rowCount;
+    m_pendingColumns . push_back ( p_col . columnIdx );
+
+    return Added ();
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: TableWriter :: NextRows ( uint64_t p_count )
+{
+    if ( m_pendingRows != 0 && m_pendingRows != p_count )
+    {
+        pLogMsg ( klogErr,
+                  "table-writer: Next-Rows for $(n) rows, Cell-Rows sent $(p)",
+                  "n=%lu,p=%lu",
+                  ( unsigned long ) p_count, ( unsigned long ) m_pendingRows );
+        return RC ( rcExe, rcCursor, rcWriting, rcRow, rcInconsistent );
+    }
+    m_pendingRows = 0;
+    m_pendingColumns . clear ();
+    return AddEvent ( etNextRows, 0, 0, p_count );
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: TableWriter :: Drain ()
+{
+    if ( m_pendingRows == 0 )
+    {   // otherwise the current batch stays with the parser until the rows are committed
+        Flush ();
+    }
+
+    KLockAcquire ( m_lock );
+    while ( ! m_queue . empty () || m_busy )
+    {
+        KConditionWait ( m_spaceReady, m_lock );
+    }
+    rc_t rc = m_rc;
+    KLockUnlock ( m_lock );
+    return rc;
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: TableWriter :: Failure () const
+{
+    KLockAcquire ( m_lock );
+    rc_t rc = m_rc;
+    KLockUnlock ( m_lock );
+    return rc;
+}
+
+rc_t
+GeneralLoader :: DatabaseLoader :: TableWriter :: Stop ()
+{
+    m_pendingRows = 0; // rows never committed are dropped, same as uncommitted cells
+    m_pendingColumns . clear ();
+    rc_t rc = Drain ();
+
+    KLockAcquire ( m_lock );
+    m_stopping = true;
+    KConditionSignal ( m_dataReady );
+    KLockUnlock ( m_lock );
+
+    rc_t rc_thread = 0;
+    rc_t rc2 = KThreadWait ( m_thread, & rc_thread );
+    KThreadRelease ( m_thread );
+    m_thread = 0;
+
+    if ( rc == 0 )
+    {
+        rc = rc2 != 0 ? rc2 : rc_thread;
+    }
+    return rc;
+}
@@ -1416,6 +1416,220 @@ FIXTURE_TEST_CASE ( MultipleTables_Multiple_Columns_MultipleRows, GeneralLoaderF
     REQUIRE_EQ ( t2c2v2,    GetValue<uint8_t>   ( Table2, U8Column, 2 ) );
 }
 
+FIXTURE_TEST_CASE ( MultipleTables_ManyRows, GeneralLoaderFixture )
+{   // enough rows to fill several batches of each table's writer
+    SetUpStream ( GetName() );
+
+    m_source . NewTableEvent ( 100, DefaultTable );
+    m_source . NewColumnEvent ( 1, 100, U32Column, 32 );
+
+    m_source . NewTableEvent ( 200, Table2 );
+    m_source . NewColumnEvent ( 2, 200, I64Column, 64 );
+
+    m_source . OpenStreamEvent();
+
+    const uint32_t RowCount = 100000;
+    for ( uint32_t i = 1; i <= RowCount; ++i )
+    {
+        m_source . CellDataEvent( 1, i );
+        m_source . NextRowEvent ( 100 );
+
+        int64_t v = - ( int64_t ) i;
+        m_source . CellDataEvent( 2, v );
+        m_source . NextRowEvent ( 200 );
+    }
+
+    m_source . CloseStreamEvent();
+
+    REQUIRE ( Run ( m_source . MakeSource (), 0 ) );
+
+    REQUIRE_EQ ( ( uint32_t ) 1,            GetValue<uint32_t>  ( DefaultTable, U32Column, 1 ) );
+    REQUIRE_EQ ( RowCount / 2,              GetValue<uint32_t>  ( DefaultTable, U32Column, RowCount / 2 ) );
+    REQUIRE_EQ ( RowCount,                  GetValue<uint32_t>  ( DefaultTable, U32Column, RowCount ) );
+    REQUIRE_EQ ( ( int64_t ) -1,            GetValue<int64_t>   ( Table2, I64Column, 1 ) );
+    REQUIRE_EQ ( - ( int64_t ) RowCount,    GetValue<int64_t>   ( Table2, I64Column, RowCount ) );
+}
+
+// several rows of a column in one event
+
+FIXTURE_TEST_CASE ( CellRows_OneColumn, GeneralLoaderFixture )
+{
+    OpenStream_OneTableOneColumn ( GetName() );
+
+    vector < uint32_t > lengths;
+    lengths . push_back ( 3 );
+    lengths . push_back ( 0 );
+    lengths . push_back ( 2 );
+    string cells = "abcde";
+    m_source . CellRowsEventRaw ( DefaultColumnId, lengths, cells . data (), ( uint32_t ) cells . size () );
+    m_source . NextRowsEvent ( DefaultTableId, 3 );
+    m_source . CloseStreamEvent();
+
+    REQUIRE ( Run ( m_source . MakeSource (), 0 ) );
+
+    REQUIRE_EQ ( string ( "abc" ), GetValue<string> ( DefaultTable, DefaultColumn, 1 ) );
+    REQUIRE_EQ ( string (),        GetValue<string> ( DefaultTable, DefaultColumn, 2 ) );
+    REQUIRE_EQ ( string ( "de" ),  GetValue<string> ( DefaultTable, DefaultColumn, 3 ) );
+    REQUIRE_THROW ( GetValue<string> ( DefaultTable, DefaultColumn, 4 ) );
+}
+
+FIXTURE_TEST_CASE ( CellRows_TwoColumns_MixedWithSingleRows, GeneralLoaderFixture )
+{
+    SetUpStream_OneTable ( GetName() );
+
+    m_source . NewColumnEvent ( 1, DefaultTableId, DefaultColumn, 8 );
+    m_source . NewColumnEvent ( 2, DefaultTableId, U32Column, 32 );
+    m_source . OpenStreamEvent();
+
+    string value1 = "first";
+    m_source . CellDataEvent( 1, value1 );
+    uint32_t value2 = 1;
+    m_source . CellDataEvent( 2, value2 );
+    m_source . NextRowEvent ( DefaultTableId  );
+
+    vector < uint32_t > lengths;
+    lengths . push_back ( 2 );
+    lengths . push_back ( 3 );
+    string strings = "r2row3";
+    m_source . CellRowsEventRaw ( 1, lengths, strings . data (), ( uint32_t ) strings . size () );
+    vector < uint32_t > ones ( 2, 1 );
+    uint32_t ints [] = { 2, 3 };
+    m_source . CellRowsEventRaw ( 2, ones, ints, sizeof ints );
+    m_source . NextRowsEvent ( DefaultTableId, 2 );
+
+    string value3 = "last";
+    m_source . CellDataEvent( 1, value3 );
+    uint32_t value4 = 4;
+    m_source . CellDataEvent( 2, value4 );
+    m_source . NextRowEvent ( DefaultTableId  );
+
+    m_source . CloseStreamEvent();
+    REQUIRE ( Run ( m_source . MakeSource (), 0 ) );
+
+    REQUIRE_EQ ( value1,            GetValue<string>    ( DefaultTable, DefaultColumn, 1 ) );
+    REQUIRE_EQ ( value2,            GetValue<uint32_t>  ( DefaultTable, U32Column, 1 ) );
+    REQUIRE_EQ ( string ( "r2" ),   GetValue<string>    ( DefaultTable, DefaultColumn, 2 ) );
+    REQUIRE_EQ ( ints [ 0 ],        GetValue<uint32_t>  ( DefaultTable, U32Column, 2 ) );
+    REQUIRE_EQ ( string ( "row3" ), GetValue<string>    ( DefaultTable, DefaultColumn, 3 ) );
+    REQUIRE_EQ ( ints [ 1 ],        GetValue<uint32_t>  ( DefaultTable, U32Column, 3 ) );
+    REQUIRE_EQ ( value3,            GetValue<string>    ( DefaultTable, DefaultColumn, 4 ) );
+    REQUIRE_EQ ( value4,            GetValue<uint32_t>  ( DefaultTable, U32Column, 4 ) );
+}
+
+FIXTURE_TEST_CASE ( CellRows_RowCountMismatch, GeneralLoaderFixture )
+{
+    SetUpStream_OneTable ( GetName() );
+
+    m_source . NewColumnEvent ( 1, DefaultTableId, DefaultColumn, 8 );
+    m_source . NewColumnEvent ( 2, DefaultTableId, U32Column, 32 );
+    m_source . OpenStreamEvent();
+
+    vector < uint32_t > lengths ( 2, 1 );
+    m_source . CellRowsEventRaw ( 1, lengths, "ab", 2 );
+    vector < uint32_t > ones ( 3, 1 );
+    uint32_t ints [] = { 1, 2, 3 };
+    m_source . CellRowsEventRaw ( 2, ones, ints, sizeof ints );
+    m_source . NextRowsEvent ( DefaultTableId, 2 );
+    m_source . CloseStreamEvent();
+
+    REQUIRE ( Run ( m_source . MakeSource (), SILENT_RC ( rcExe, rcCursor, rcWriting, rcRow, rcInconsistent ) ) );
+}
+
+FIXTURE_TEST_CASE ( CellRows_NextRowBeforeNextRows, GeneralLoaderFixture )
+{
+    OpenStream_OneTableOneColumn ( GetName() );
+
+    vector < uint32_t > lengths ( 2, 1 );
+    m_source . CellRowsEventRaw ( DefaultColumnId, lengths, "ab", 2 );
+    m_source . NextRowEvent ( DefaultTableId );
+    m_source . CloseStreamEvent();
+
+    REQUIRE ( Run ( m_source . MakeSource (), SILENT_RC ( rcExe, rcCursor, rcWriting, rcRow, rcIncomplete ) ) );
+}
+
+FIXTURE_TEST_CASE ( CellRows_ShortRowLengths, GeneralLoaderFixture )
+{   // the row lengths cover only part of the cells
+    OpenStream_OneTableOneColumn ( GetName() );
+
+    vector < uint32_t > lengths ( 2, 1 );
+    m_source . CellRowsEventRaw ( DefaultColumnId, lengths, 3, "abc", 3 );
+    m_source . NextRowsEvent ( DefaultTableId, 2 );
+    m_source . CloseStreamEvent();
+
+    REQUIRE ( Run ( m_source . MakeSource (), SILENT_RC ( rcExe, rcFile, rcReading, rcData, rcExcessive ) ) );
+}
+
+FIXTURE_TEST_CASE ( CellRows_LongRowLengths, GeneralLoaderFixture )
+{   // the row lengths need more cells than the event has
+    OpenStream_OneTableOneColumn ( GetName() );
+
+    vector < uint32_t > lengths ( 2, 2 );
+    m_source . CellRowsEventRaw ( DefaultColumnId, lengths, 3, "abc", 3 );
+    m_source . NextRowsEvent ( DefaultTableId, 2 );
+    m_source . CloseStreamEvent();
+
+    REQUIRE ( Run ( m_source . MakeSource (), SILENT_RC ( rcExe, rcFile, rcReading, rcData, rcInsufficient ) ) );
+}
+
+FIXTURE_TEST_CASE ( CellRows_SameColumnTwice, GeneralLoaderFixture )
+{
+    OpenStream_OneTableOneColumn ( GetName() );
+
+    vector < uint32_t > lengths ( 2, 1 );
+    m_source . CellRowsEventRaw ( DefaultColumnId, lengths, "ab", 2 );
+    m_source . CellRowsEventRaw ( DefaultColumnId, lengths, "cd", 2 );
+    m_source . NextRowsEvent ( DefaultTableId, 2 );
+    m_source . CloseStreamEvent();
+
+    REQUIRE ( Run ( m_source . MakeSource (), SILENT_RC ( rcExe, rcCursor, rcWriting, rcColumn, rcExists ) ) );
+}
+
+FIXTURE_TEST_CASE ( CellRows_IntegerCompression, GeneralLoaderFixture )
+{
+    if ( ! SetUpForIntegerCompression ( GetName() ) )
+        return;
+
+    m_source . OpenStreamEvent();
+
+    vector < uint32_t > lengths;
+    lengths . push_back ( 1 );
+    lengths . push_back ( 2 );
+
+    uint8_t buf[128];
+    const uint64_t values [] = { 1, 0x3456, 0x7F };
+    int bytesTotal;
+
+    bytesTotal = 0;
+    for ( size_t i = 0; i < 3; ++i )
+        bytesTotal += encode_uint16 ( ( uint16_t ) values [ i ], buf + bytesTotal, buf + sizeof buf );
+    m_source . CellRowsEventRaw ( Column16Id, lengths, buf, bytesTotal );
+
+    bytesTotal = 0;
+    for ( size_t i = 0; i < 3; ++i )
+        bytesTotal += encode_uint32 ( ( uint32_t ) values [ i ], buf + bytesTotal, buf + sizeof buf );
+    m_source . CellRowsEventRaw ( Column32Id, lengths, buf, bytesTotal );
+
+    bytesTotal = 0;
+    for ( size_t i = 0; i < 3; ++i )
+        bytesTotal += encode_uint64 ( values [ i ], buf + bytesTotal, buf + sizeof buf );
+    m_source . CellRowsEventRaw ( Column64Id, lengths, buf, bytesTotal );
+
+    m_source . NextRowsEvent ( DefaultTableId, 2 );
+    m_source . CloseStreamEvent();
+
+    {
+        GeneralLoader* gl = MakeLoader ( m_source . MakeSource () );
+        REQUIRE ( RunLoader ( *gl, 0 ) );
+        delete gl;
+    } // make sure loader is destroyed (= db closed) before we reopen the database for verification
+
+    REQUIRE_EQ ( ( uint16_t ) values [ 0 ], GetValue<uint16_t> ( "TABLE1", "column16", 1 ) );
+    REQUIRE_EQ ( ( uint16_t ) values [ 1 ], GetValueWithIndex<uint16_t> ( "TABLE1", "column16", 2, 2, 0 ) );
+    REQUIRE_EQ ( ( uint16_t ) values [ 2 ], GetValueWithIndex<uint16_t> ( "TABLE1", "column16", 2, 2, 1 ) );
+    REQUIRE_EQ ( ( uint32_t ) values [ 1 ], GetValueWithIndex<uint32_t> ( "TABLE1", "column32", 2, 2, 0 ) );
+    REQUIRE_EQ ( values [ 2 ],              GetValueWithIndex<uint64_t> ( "TABLE1", "column64", 2, 2, 1 ) );
+}
+
 FIXTURE_TEST_CASE ( AdditionalSchemaIncludePaths_Single, GeneralLoaderFixture )
 {
     string schemaPath = "schema";
@@ -219,6 +219,7 @@ TestSource::Buffer::WriteUnpacked ( const TestSource::Event& p_event )
         break;
         
     case evt_move_ahead:
+    case evt_next_rows:
         {
             gw_move_ahead_evt_v1 hdr;
             init ( hdr, p_event . m_id1, p_event . m_event );
@@ -226,6 +227,19 @@ TestSource::Buffer::WriteUnpacked ( const TestSource::Event& p_event )
             Write ( & hdr, sizeof hdr );
         }
         break;
+
+    case evt_cell_rows:
+        {
+            gw_rows_evt_v1 hdr;
+            init ( hdr, p_event . m_id1, p_event . m_event );
+            set_row_count ( hdr, ( uint32_t ) p_event . m_rowLengths . size () );
+            set_elem_count ( hdr, p_event . m_uint32 );
+
+            Write ( & hdr, sizeof hdr );
+            Write ( p_event . m_rowLengths . data(), sizeof ( uint32_t ) * p_event . m_rowLengths . size() );
+            Write ( p_event . m_val . data(), p_event . m_val . size() );
+        }
+        break;
         
     default:
         throw logic_error ( "TestSource::Buffer::WriteUnpacked: event not implemented" );
@@ -433,6 +447,7 @@ TestSource::Buffer::WritePacked ( const TestSource::Event& p_event )
         break;
         
     case evt_move_ahead:
+    case evt_next_rows:
         {
             gwp_move_ahead_evt_v1 hdr;
             init ( hdr, p_event . m_id1, p_event . m_event );
@@ -440,6 +455,20 @@ TestSource::Buffer::WritePacked ( const TestSource::Event& p_event )
             Write ( & hdr, sizeof hdr );
         }
         break;
+
+    case evt_cell_rows:
+        {
+            gwp_rows_evt_v1 hdr;
+            init ( hdr, p_event . m_id1, p_event . m_event );
+            set_row_count ( hdr, ( uint32_t ) p_event . m_rowLengths . size () );
+            // in the packed message, we specify the number of bytes in the cells
+            set_size ( hdr, p_event . m_val . size() );
+
+            Write ( & hdr, sizeof hdr );
+            Write ( p_event . m_rowLengths . data(), sizeof ( uint32_t ) * p_event . m_rowLengths . size() );
+            Write ( p_event . m_val . data(), p_event . m_val . size() );
+        }
+        break;
         
     default:
         throw logic_error ( "TestSource::Buffer::WritePacked: event not implemented" );
@@ -558,6 +587,31 @@ TestSource::MoveAheadEvent ( TableId p_id, uint64_t p_count )
     m_buffer -> Write ( Event ( evt_move_ahead, p_id, p_count ) );
 }
 
+void 
+TestSource::NextRowsEvent ( TableId p_id, uint64_t p_count )
+{
+    m_buffer -> Write ( Event ( evt_next_rows, p_id, p_count ) );
+}
+
+void 
+TestSource::CellRowsEventRaw ( ColumnId p_columnId, const vector < uint32_t >& p_rowLengths, const void* p_value, uint32_t p_size )
+{
+    uint32_t elemCount = 0;
+    for ( size_t i = 0; i != p_rowLengths . size (); ++i )
+    {
+        elemCount += p_rowLengths [ i ];
+    }
+    CellRowsEventRaw ( p_columnId, p_rowLengths, elemCount, p_value, p_size );
+}
+
+void 
+TestSource::CellRowsEventRaw ( ColumnId p_columnId, const vector < uint32_t >& p_rowLengths, uint32_t p_elemCount, const void* p_value, uint32_t p_size )
+{
+    Event evt ( evt_cell_rows, p_columnId, p_elemCount, p_size, p_value );
+    evt . m_rowLengths = p_rowLengths;
+    m_buffer -> Write ( evt );
+}
+
 template<> void TestSource::CellDataEvent ( ColumnId p_columnId, string p_value )
 {
     m_buffer -> Write ( Event ( evt_cell_data, p_columnId, ( uint32_t ) p_value . size(), ( uint32_t ) p_value . size(), p_value . c_str() ) );
@@ -86,6 +86,7 @@ public:
     void CloseStreamEvent ();
     void NextRowEvent ( TableId p_id );
     void MoveAheadEvent ( TableId p_id, uint64_t p_count );
+    void NextRowsEvent ( TableId p_id, uint64_t p_count );
     void CellDefaultEvent ( ColumnId p_columnId, const std :: string& p_value );
     void CellDefaultEvent ( ColumnId p_columnId, uint32_t p_value );
     void CellDefaultEvent ( ColumnId p_columnId, bool p_value );
@@ -108,6 +109,12 @@ public:
         m_buffer -> Write ( Event ( evt_cell_data, p_columnId, p_elemCount, p_size, p_value ) );
     }
 
+    // p_size bytes of cells for p_rowLengths . size() rows, back to back
+    void CellRowsEventRaw ( ColumnId p_columnId, const std :: vector < uint32_t >& p_rowLengths, const void* p_value, uint32_t p_size );
+    // the same with the element count given explicitly, it does not have to match the row lengths
+    // (the packed protocol has no element count, only p_size)
+    void CellRowsEventRaw ( ColumnId p_columnId, const std :: vector < uint32_t >& p_rowLengths, uint32_t p_elemCount, const void* p_value, uint32_t p_size );
+
 private:
     struct Event
     {
@@ -139,6 +146,7 @@ private:
         std :: string           m_str1;
         std :: string           m_str2;
         std :: vector < char >  m_val;
+        std :: vector < uint32_t > m_rowLengths;
     };
 
     class Buffer
@@ -55,6 +55,7 @@
 
 #include "kar+.h"
 #include "kar+args.h"
+#include "kar-pool.h"
 
 
 /*******************************************************************************
@@ -413,7 +414,7 @@ rc_t kar_scan_directory ( const KDirectory *dir, KARDir *kar_dir, const char *pa
 /********** md5  */
 
 static
-rc_t kar_md5 ( KDirectory *wd, KFile **archive, const char *path, KCreateMode mode )
+rc_t kar_md5 ( KDirectory *wd, KMD5SumFmt **fmt, const char *path, KCreateMode mode )
 {
     rc_t rc = 0;
     KFile *md5_f;
@@ -424,46 +425,36 @@ rc_t kar_md5 ( KDirectory *wd, KFile **archive, const char *path, KCreateMode mo
         PLOGERR (klogFatal, (klogFatal, rc, "unable to create md5 file [$(A).md5]", PLOG_S(A), path));
     else
     {
-        KMD5SumFmt *fmt;
-
-        /* create md5 formatter to write to md5_f */
-        rc = KMD5SumFmtMakeUpdate ( &fmt, md5_f );
+        /* create md5 formatter to write to md5_f
+           the digest itself is calculated by a KARHasher while the archive is written */
+        rc = KMD5SumFmtMakeUpdate ( fmt, md5_f );
         if ( rc )
-            LOGERR (klogErr, rc, "failed to make KMD5SumFmt");
-        else
         {
-            KMD5File *kmd5_f;
-
-            size_t size = string_size ( path );
-            const char *fname = string_rchr ( path, size, '/' );
-            if ( fname ++ == NULL )
-                fname = path;
-
-            /* KMD5SumFmtMakeUpdate() took over ownership of "md5_f" */
-            md5_f = NULL;
-
-            /* create a file that knows how to calculate md5 as data
-                       are written-through to archive, and then write digest
-                       result to fmt, using "fname" as description. */
-            rc = KMD5FileMakeWrite ( &kmd5_f, * archive, fmt, fname );
-            KMD5SumFmtRelease ( fmt );
-            if ( rc )
-                LOGERR (klogErr, rc, "failed to make KMD5File");
-            else
-            {
-                /* success */
-                *archive = KMD5FileToKFile ( kmd5_f );
-                return 0;
-            }
+            LOGERR (klogErr, rc, "failed to make KMD5SumFmt");
+            KFileRelease ( md5_f );
         }
-
-        /* error cleanup */
-        KFileRelease ( md5_f );
     }
 
     return rc;
 }
 
+static
+rc_t kar_md5_update ( KMD5SumFmt *fmt, const char *path, const uint8_t digest [ 16 ] )
+{
+    rc_t rc;
+
+    size_t size = string_size ( path );
+    const char *fname = string_rchr ( path, size, '/' );
+    if ( fname ++ == NULL )
+        fname = path;
+
+    rc = KMD5SumFmtUpdate ( fmt, fname, digest, true );
+    if ( rc )
+        LOGERR (klogErr, rc, "failed to write md5 digest");
+
+    return rc;
+}
+
 /********** write to toc and archive  */
 
 static
@@ -1070,14 +1061,14 @@ rc_t kar_prepare_toc ( KARDir *kar_dir, KARWek ** Wek, const Params * params )
 }
 
 static
-void kar_write_file ( KARArchiveFile *af, const KDirectory *wd, const KARFile *file, const char * root_dir )
+rc_t kar_write_file ( const KARArchiveFile *af, const KDirectory *wd, const KARFile *file, const char * root_dir,
+                      bool pad, char *buffer, size_t bsize, KARHasher *hasher )
 {
     rc_t rc;
-    char *buffer;
     size_t num_read, align_size;
     uint64_t pos = 0;
+    uint64_t apos = af -> starting_pos + file -> byte_offset;
     char align_buffer [ 4 ] = "0000";
-    size_t bsize = 128 * 1024 * 1024;
 
     const KFile *f;
 
@@ -1085,10 +1076,7 @@ void kar_write_file ( KARArchiveFile *af, const KDirectory *wd, const KARFile *f
     size_t path_size;
 
     if ( file -> byte_size == 0 )
-        return;
-
-    if ( bsize > file -> byte_size )
-        bsize = file -> byte_size;
+        return 0;
 
     STATUS ( STAT_QA, "writing file '%s'", file -> dad . name );
 
@@ -1098,7 +1086,7 @@ void kar_write_file ( KARArchiveFile *af, const KDirectory *wd, const KARFile *f
         /* path name was somehow too long */
         rc = RC ( rcExe, rcFile, rcWriting, rcMemory, rcExhausted );
         LogErr ( klogInt, rc, "File path was too long" );
-        exit (5);
+        return rc;
     }
 
     STATUS ( STAT_QA, "opening: full path is '%s'", filename );
@@ -1106,25 +1094,10 @@ void kar_write_file ( KARArchiveFile *af, const KDirectory *wd, const KARFile *f
     if ( rc != 0 )
     {
         pLogErr ( klogInt, rc, "Failed to open file $(fname)", "fname=%s", file -> dad . name );
-        exit (6);
-    }
-
-    STATUS ( STAT_QA, "allocating buffer of %,zu bytes", bsize );
-    buffer = malloc ( bsize );
-    if ( buffer == NULL )
-    {
-        rc = RC ( rcExe, rcFile, rcWriting, rcMemory, rcExhausted );
-        pLogErr ( klogInt, rc, "Failed to open file $(fname)", "fname=%s", file -> dad . name );
-        exit ( 7 );
+        return rc;
     }
 
-    /* establish current position */
-    align_size = align_offset ( af -> pos, 4 ) - af -> pos;
-    if ( align_size != 0  )
-        rc = KFileWriteAll ( af -> archive, af -> pos, align_buffer, align_size, NULL );
-
-    af -> pos = af -> starting_pos + file -> byte_offset;
-
+    /* every file lands at its own offset, so files can be written in any order */
     while ( rc == 0 && pos < file -> byte_size )
     {
         size_t num_writ, to_read = bsize;
@@ -1134,39 +1107,71 @@ void kar_write_file ( KARArchiveFile *af, const KDirectory *wd, const KARFile *f
 
         STATUS ( STAT_QA, "about to read at offset %lu from input file '%s'", pos, filename );
         rc = KFileReadAll ( f, pos, buffer, to_read, & num_read );
-        if ( rc != 0 || num_read == 0 )
+        if ( rc == 0 && num_read == 0 )
+            rc = RC ( rcExe, rcFile, rcReading, rcTransfer, rcIncomplete );
+        if ( rc != 0 )
             break;
 
         STATUS ( STAT_QA, "about to write %zu bytes to archive", num_read );
-        rc = KFileWriteAll ( af -> archive, af -> pos, buffer, num_read, & num_writ );
-        if ( rc != 0 || num_writ != num_read )
-        {
-            /* error */
-            break;
-        }
+        rc = KFileWriteAll ( af -> archive, apos + pos, buffer, num_read, & num_writ );
+        if ( rc == 0 && num_writ != num_read )
+            rc = RC ( rcExe, rcFile, rcWriting, rcTransfer, rcIncomplete );
 
-        af -> pos += num_writ;
         pos += num_read;
     }
 
-    STATUS ( STAT_PRG, "freeing memory" );
-    free ( buffer );
+    /* pad up to the next file */
+    align_size = pad ? align_offset ( apos + pos, 4 ) - ( apos + pos ) : 0;
+    if ( rc == 0 && align_size != 0 )
+        rc = KFileWriteAll ( af -> archive, apos + pos, align_buffer, align_size, NULL );
+
+    if ( rc != 0 )
+        pLogErr ( klogInt, rc, "Failed to write file $(fname) to archive", "fname=%s", file -> dad . name );
+    else
+        rc = kar_hasher_done ( hasher, apos, pos + align_size );
 
     STATUS ( STAT_QA, "closing '%s'", filename );
     KFileRelease ( f );
+
+    return rc;
+}
+
+typedef struct kar_write_block kar_write_block;
+struct kar_write_block
+{
+    const KARArchiveFile *af;
+    const KDirectory *wd;
+    KARWek *files;
+    const char *root_dir;
+    KARHasher *hasher;
+};
+
+static
+rc_t CC kar_write_file_job ( void *data, uint64_t idx, char *buffer, size_t bsize )
+{
+    const kar_write_block *wb = data;
+    const KARFile *file = ( const KARFile * ) kar_wek_get ( wb -> files, idx );
+
+    STATUS ( STAT_QA, "writing file %lu: '%s'", idx, file -> dad . name );
+    return kar_write_file ( wb -> af, wb -> wd, file, wb -> root_dir,
+                            idx + 1 < kar_wek_size ( wb -> files ), buffer, bsize, wb -> hasher );
 }
 
 static
-rc_t kar_make ( const KDirectory * wd, KFile *archive, KARDir *kar_dir, const char * root_dir, const Params * params )
+rc_t kar_make ( const KDirectory * wd, KFile *archive, KARDir *kar_dir, const char * root_dir, const Params * params,
+                uint8_t digest [ 16 ] )
 {
     rc_t rc = 0;
+
     KARWek * Files = 0;
 
     rc = kar_prepare_toc ( kar_dir, & Files, params );
     if ( rc == 0 )
     {
-        uint64_t i, toc_size;
+        uint64_t toc_size, archive_size;
         KARArchiveFile af;
+        KARHasher *hasher = NULL;
+
         /* evaluate toc size */
         toc_size = kar_eval_toc_size ( kar_dir );
 
@@ -1180,13 +1185,43 @@ rc_t kar_make ( const KDirectory * wd, KFile *archive, KARDir *kar_dir, const ch
         /* write toc */
         kar_write_toc ( & af, kar_dir );
 
-        /* write each of the files in order */
-        STATUS ( STAT_QA, "about to write %u files", kar_wek_size ( Files ) );
-        for ( i = 0; i < kar_wek_size ( Files ); ++ i )
+        /* size the archive up front so that files can be written concurrently */
+        archive_size = af . starting_pos;
+        if ( kar_wek_size ( Files ) != 0 )
         {
-            KARFile * File = ( KARFile * ) kar_wek_get ( Files, i );
-            STATUS ( STAT_QA, "writing file %u: '%s'", i, File -> dad . name );
-            kar_write_file ( & af, wd, File, root_dir );
+            const KARFile *last = ( const KARFile * ) kar_wek_get ( Files, kar_wek_size ( Files ) - 1 );
+            archive_size += last -> byte_offset + last -> byte_size;
+        }
+        rc = KFileSetSize ( archive, archive_size );
+        if ( rc != 0 )
+            LogErr ( klogInt, rc, "Failed to set archive size" );
+
+        if ( rc == 0 && digest != NULL )
+        {
+            rc = kar_hasher_make ( & hasher, archive, archive_size );
+            if ( rc == 0 )
+                rc = kar_hasher_done ( hasher, 0, af . starting_pos );
+        }
+
+        if ( rc == 0 )
+        {
+            kar_write_block wb;
+            wb . af = & af;
+            wb . wd = wd;
+            wb . files = Files;
+            wb . root_dir = root_dir;
+            wb . hasher = hasher;
+
+            /* write the files, each at its own offset */
+            STATUS ( STAT_QA, "about to write %u files", kar_wek_size ( Files ) );
+            rc = kar_pool_run ( params -> threads, kar_wek_size ( Files ), kar_write_file_job, & wb );
+        }
+
+        if ( hasher != NULL )
+        {
+            rc_t rc2 = kar_hasher_finish ( hasher, digest );
+            if ( rc == 0 )
+                rc = rc2;
         }
 
         kar_wek_dispose ( Files );
@@ -1212,8 +1247,10 @@ rc_t kar_create ( const Params *p )
     else
     {
         KFile *archive;
+        KMD5SumFmt *md5 = NULL;
         KCreateMode mode = ( p -> force ? kcmInit : kcmCreate ) | kcmParents;
-        rc = KDirectoryCreateFile ( wd, &archive, false, 0666, mode,
+        /* the md5 is calculated by reading the archive back, so it needs to be readable */
+        rc = KDirectoryCreateFile ( wd, &archive, p -> md5sum, 0666, mode,
                                     "%s", p -> archive_path );
         if ( rc != 0 )
         {
@@ -1223,7 +1260,7 @@ rc_t kar_create ( const Params *p )
         else
         {
             if ( p -> md5sum )
-                rc = kar_md5 ( wd, &archive, p -> archive_path, mode );
+                rc = kar_md5 ( wd, &md5, p -> archive_path, mode );
 
             if ( rc == 0 )
             {
@@ -1240,15 +1277,21 @@ rc_t kar_create ( const Params *p )
                     rc = kar_scan_directory ( wd, & the_dir, p -> directory_path );
                     if ( rc == 0 )
                     {
-                        rc = kar_make ( wd, archive, & the_dir, p -> directory_path, p );
+                        uint8_t digest [ 16 ];
+                        rc = kar_make ( wd, archive, & the_dir, p -> directory_path, p,
+                                        md5 != NULL ? digest : NULL );
                         if ( rc != 0 )
                             LogErr ( klogInt, rc, "Failed to build archive" );
+                        else if ( md5 != NULL )
+                            rc = kar_md5_update ( md5, p -> archive_path, digest );
                     }
                 }
 
                 BSTreeWhack ( & ( the_dir . contents ), kar_entry_whack, NULL );
             }
 
+            if ( md5 != NULL )
+                KMD5SumFmtRelease ( md5 );
             KFileRelease ( archive );
         }
 
@@ -1796,6 +1839,8 @@ struct extract_block
 
     KARWek * wek;
 
+    uint32_t threads;
+
     rc_t rc;
 
 };
@@ -1817,30 +1862,22 @@ rc_t extract_file ( const KARFile *src, const extract_block *eb )
 }
 
 static
-rc_t store_extracted_file ( stored_file * sf, const extract_block * eb )
+rc_t store_extracted_file ( stored_file * sf, const extract_block * eb, char *buffer, size_t bsize )
 {
     KFile *dst;
-    char *buffer;
     size_t num_writ = 0, num_read = 0, total = 0;
-    size_t bsize = 256 * 1024 *1024;
 
     rc_t rc = KDirectoryCreateFile ( sf -> cdir, &dst, false, 0200,
                                  kcmCreate, "%s", SF_SE(sf,name) );
     if ( rc != 0 )
     {
         pLogErr (klogErr, rc, "failed extract to file '$(fname)'", "fname=%s", SF_SE(sf,name) );
-        exit ( 4 );
-    }
-
-
-    buffer = malloc ( bsize );
-    if ( buffer == NULL )
-    {
-        rc = RC ( rcExe, rcFile, rcAllocating, rcMemory, rcExhausted );
-        pLogErr (klogErr, rc, "failed to allocate '$(mem)'", "mem=%zu", bsize );
-        exit ( 4 );
+        return rc;
     }
 
+        /*  runs on a worker of the pool: errors are returned,
+         *  the pool stops at the first one and the caller reports it
+         */
     for ( total = 0; total < SF_SF(sf,byte_size); total += num_read )
     {
         size_t to_read =  SF_SF(sf,byte_size) - total;
@@ -1852,35 +1889,34 @@ rc_t store_extracted_file ( stored_file * sf, const extract_block * eb )
         if ( rc != 0 )
         {
             pLogErr (klogErr, rc, "failed to read from archive '$(fname)'", "fname=%s", SF_SE(sf,name) );
-            exit ( 4 );
+            break;
         }
 
         if ( num_read == 0 && to_read != 0 ) {
             /*  we reached end of file, and we still need more data
              */
+            rc = RC ( rcExe, rcFile, rcReading, rcTransfer, rcIncomplete );
             pLogErr (klogErr, rc, "end of file reached while reading from archive '$(fname)'", "fname=%s", SF_SE(sf,name) );
-            exit ( 4 );
+            break;
         }
 
         rc = KFileWriteAll ( dst, total, buffer, num_read, &num_writ );
         if ( rc != 0 )
         {
             pLogErr (klogErr, rc, "failed to write to file '$(fname)'", "fname=%s", SF_SE(sf,name) );
-            exit ( 4 );
+            break;
         }
 
         if ( num_writ < num_read )
         {
             rc = RC ( rcExe, rcFile, rcWriting, rcTransfer, rcIncomplete );
             pLogErr (klogErr, rc, "failed to write to file '$(fname)'", "fname=%s", SF_SE(sf,name) );
-            exit ( 4 );
+            break;
         }
     }
 
     KFileRelease ( dst );
 
-    free ( buffer );
-
     return rc;
 }   /* store_extracted_file () */
 
@@ -1897,6 +1933,19 @@ store_extracted_files_comparator (
     return SF_SF(sl,byte_offset) - SF_SF(sr,byte_offset);
 }   /* store_extracted_files_comparator () */
 
+static
+rc_t CC store_extracted_file_job ( void * data, uint64_t idx, char * buffer, size_t bsize )
+{
+    const extract_block * eb = ( const extract_block * ) data;
+
+        /*  files are independent of each other, so they are stored
+         *  concurrently, every worker with its own buffer
+         */
+    stored_file * sf = ( stored_file * ) kar_wek_get ( eb -> wek, idx );
+
+    return store_extracted_file ( sf, eb, buffer, bsize );
+}   /* store_extracted_file_job () */
+
 static
 rc_t store_extracted_files ( const extract_block * eb )
 {
@@ -1912,13 +1961,10 @@ rc_t store_extracted_files ( const extract_block * eb )
             NULL
             );
 
-    for ( size_t llp = 0; llp < kar_wek_size ( wek ); llp ++ ) {
-        stored_file * sf = ( stored_file * ) kar_wek_get ( wek, llp );
-        rc = store_extracted_file ( sf, eb );
-        if ( rc != 0 ) {
-            pLogErr (klogErr, rc, "failed to store extracted files", "" );
-            exit ( 4 );
-        }
+    rc = kar_pool_run ( eb -> threads, kar_wek_size ( wek ), store_extracted_file_job, ( void * ) eb );
+    if ( rc != 0 ) {
+        pLogErr (klogErr, rc, "failed to store extracted files", "" );
+        exit ( 4 );
     }
 
     return rc;
@@ -2114,6 +2160,7 @@ rc_t kar_test_extract ( const Params *p )
                     eb . archive = archive;
                     eb . extract_pos = file_offset;
                     eb . rc = 0;
+                    eb . threads = p -> threads;
 
                     rc = kar_wek_make (
                                 & ( eb . wek ),
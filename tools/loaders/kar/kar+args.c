@@ -34,6 +34,8 @@
 
 #include <kapp/main.h>
 
+#include <stdlib.h>
+
 
 static const char * create_usage[] = { "Create a new archive.", NULL };
 static const char * test_usage[] = { "Check the structural validity of an archive", NULL };
@@ -71,6 +73,9 @@ static const char * kdfile_usage[] =
   NULL };
 static const char * stdout_usage[] = { "Direct output to stdout", NULL }; 
 static const char * md5_usage[] = { "create md5sum-compatible checksum file", NULL }; 
+static const char * threads_usage[] =
+{ "number of files to write or extract",
+  "concurrently, default is 4", NULL };
 
 
 OptDef Options [] = 
@@ -85,7 +90,8 @@ OptDef Options [] =
     { OPTION_MD5,       NULL,            NULL, md5_usage, 1, false,  false },
     { OPTION_KEEP,      NULL,            NULL, keep_usage, 0, true,  false },
     { OPTION_DROP,      NULL,            NULL, drop_usage, 0, true,  false },
-    { OPTION_KDFILE,    NULL,            NULL, kdfile_usage, 1, true,  false }
+    { OPTION_KDFILE,    NULL,            NULL, kdfile_usage, 1, true,  false },
+    { OPTION_THREADS,   NULL,            NULL, threads_usage, 1, true,  false }
 };
 
 const char UsageDefaultName[] = "kar";
@@ -155,6 +161,7 @@ rc_t CC Usage (const Args * args)
 
     HelpOptionLine (ALIAS_STDOUT, OPTION_STDOUT, NULL, stdout_usage);
     HelpOptionLine ( NULL, OPTION_MD5, NULL, md5_usage);
+    HelpOptionLine ( NULL, OPTION_THREADS, "count", threads_usage);
 
     HelpOptionLine ( NULL, OPTION_KEEP, NULL, keep_usage);
     HelpOptionLine ( NULL, OPTION_DROP, NULL, drop_usage);
@@ -324,6 +331,19 @@ rc_t parse_params_int ( Params *p, const Args *args )
     if ( rc == 0 && count != 0 )
         p -> md5sum = true;    
 
+    rc = ArgsOptionCount ( args, OPTION_THREADS, &count );
+    if ( rc == 0 && count != 0 )
+    {
+        const char *value;
+        rc = ArgsOptionValue ( args, OPTION_THREADS, 0, ( const void ** ) &value );
+        if ( rc != 0 )
+        {
+            LogErr ( klogFatal, rc, "Failed to access 'threads' option value" );
+            return rc;
+        }
+        p -> threads = ( uint32_t ) strtoul ( value, NULL, 10 );
+    }
+
     /* Options */
     rc = ArgsOptionCount ( args, OPTION_CREATE, & p -> c_count );
     if ( rc != 0 )
@@ -440,6 +460,7 @@ rc_t parse_params ( Params *p, struct Args ** args, int argc, char * argv [] )
     p -> long_list = false;
     p -> force = false;
     p -> my_stdout = false;
+    p -> threads = 0;
     p -> keep = NULL;
     p -> drop = NULL;
     p -> kdfile = NULL;
@@ -38,6 +38,7 @@
 #define OPTION_DIRECTORY "directory"
 #define OPTION_STDOUT    "stdout"
 #define OPTION_MD5       "md5"
+#define OPTION_THREADS   "threads"
 #define OPTION_KEEP      "keep"
 #define OPTION_DROP      "drop"
 #define OPTION_KDFILE    "kdfile"
@@ -93,6 +94,9 @@ struct Params
     /*modifier to create mode to create an md5sum compatible auxilary file*/
     bool md5sum;
 
+    /* number of files written or extracted concurrently, 0 for the default */
+    uint32_t threads;
+
     /* transformation: we may drop or keep files */
     struct VNamelist * keep;
     struct VNamelist * drop;
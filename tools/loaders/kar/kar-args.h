@@ -40,6 +40,7 @@
 #define OPTION_DIRECTORY "directory"
 #define OPTION_STDOUT    "stdout"
 #define OPTION_MD5       "md5"
+#define OPTION_THREADS   "threads"
 /*TBD - add alignment option */
 
 
@@ -89,6 +90,9 @@ struct Params
     
     /*modifier to create mode to create an md5sum compatible auxilary file*/
     bool md5sum;
+
+    /* number of files written or extracted concurrently, 0 for the default */
+    uint32_t threads;
 };
 
 
@@ -0,0 +1,390 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ */
+
+#include "kar-pool.h"
+
+#include <klib/rc.h>
+#include <klib/log.h>
+#include <klib/checksum.h>
+#include <kfs/file.h>
+#include <kproc/thread.h>
+#include <kproc/lock.h>
+#include <kproc/cond.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+ * Thread pool
+ */
+
+typedef struct kar_pool kar_pool;
+struct kar_pool
+{
+    KLock * lock;
+    kar_pool_job job;
+    void * data;
+
+    uint64_t next;
+    uint64_t count;
+
+    rc_t rc;
+};
+
+static
+rc_t CC kar_pool_thread ( const KThread * self, void * data )
+{
+    kar_pool * pool = data;
+    rc_t rc = 0;
+
+    char * buffer = malloc ( KAR_POOL_BUFFER_SIZE );
+    if ( buffer == NULL )
+        rc = RC ( rcExe, rcThread, rcExecuting, rcMemory, rcExhausted );
+
+    while ( rc == 0 )
+    {
+        uint64_t idx;
+
+        KLockAcquire ( pool -> lock );
+        if ( pool -> rc != 0 || pool -> next >= pool -> count )
+        {
+            KLockUnlock ( pool -> lock );
+            break;
+        }
+        idx = pool -> next ++;
+        KLockUnlock ( pool -> lock );
+
+        rc = pool -> job ( pool -> data, idx, buffer, KAR_POOL_BUFFER_SIZE );
+    }
+
+    if ( rc != 0 )
+    {
+        KLockAcquire ( pool -> lock );
+        if ( pool -> rc == 0 )
+            pool -> rc = rc;
+        KLockUnlock ( pool -> lock );
+    }
+
+    free ( buffer );
+    return rc;
+}
+
+rc_t kar_pool_run ( uint32_t threads, uint64_t count, kar_pool_job job, void * data )
+{
+    rc_t rc;
+    kar_pool pool;
+    KThread ** t;
+    uint32_t i, started;
+
+    if ( job == NULL )
+        return RC ( rcExe, rcThread, rcExecuting, rcParam, rcNull );
+
+    if ( threads == 0 )
+        threads = KAR_POOL_DEFAULT_THREADS;
+    if ( threads > count )
+        threads = ( uint32_t ) count;
+    if ( threads == 0 )
+        return 0;
+
+    memset ( & pool, 0, sizeof pool );
+    pool . job = job;
+    pool . data = data;
+    pool . count = count;
+
+    rc = KLockMake ( & pool . lock );
+    if ( rc != 0 )
+        return rc;
+
+    t = calloc ( threads, sizeof * t );
+    if ( t == NULL )
+    {
+        KLockRelease ( pool . lock );
+        return RC ( rcExe, rcThread, rcCreating, rcMemory, rcExhausted );
+    }
+
+    for ( started = 0; started < threads; ++ started )
+    {
+        rc = KThreadMake ( & t [ started ], kar_pool_thread, & pool );
+        if ( rc != 0 )
+        {
+            LOGERR ( klogErr, rc, "failed to start worker thread" );
+
+            /* stop the ones already running */
+            KLockAcquire ( pool . lock );
+            if ( pool . rc == 0 )
+                pool . rc = rc;
+            KLockUnlock ( pool . lock );
+            break;
+        }
+    }
+
+    for ( i = 0; i < started; ++ i )
+    {
+        KThreadWait ( t [ i ], NULL );
+        KThreadRelease ( t [ i ] );
+    }
+
+    free ( t );
+    KLockRelease ( pool . lock );
+
+    return pool . rc;
+}
+
+/*******************************************************************************
+ * Hasher
+ */
+
+#define KAR_HASH_CHUNK ( 4 * 1024 * 1024 )
+
+typedef struct kar_region kar_region;
+struct kar_region
+{
+    uint64_t pos;
+    uint64_t end;
+};
+
+struct KARHasher
+{
+    const KFile * archive;
+    KThread * thread;
+    KLock * lock;
+    KCondition * cond;
+
+    /* completed regions not yet merged into the hashed prefix, unsorted */
+    kar_region * regions;
+    size_t num_regions;
+    size_t max_regions;
+
+    uint64_t ready;         /* [ 0, ready ) is written */
+    uint64_t archive_size;
+
+    MD5State md5;
+    rc_t rc;
+};
+
+/* extend the written prefix with any regions that now touch it
+   caller holds the lock */
+static
+void kar_hasher_merge ( KARHasher * self )
+{
+    bool merged = true;
+    while ( merged )
+    {
+        size_t i;
+        merged = false;
+        for ( i = 0; i < self -> num_regions; ++ i )
+        {
+            if ( self -> regions [ i ] . pos <= self -> ready )
+            {
+                if ( self -> regions [ i ] . end > self -> ready )
+                    self -> ready = self -> regions [ i ] . end;
+                self -> regions [ i ] = self -> regions [ -- self -> num_regions ];
+                merged = true;
+                break;
+            }
+        }
+    }
+}
+
+static
+rc_t CC kar_hasher_thread ( const KThread * t, void * data )
+{
+    KARHasher * self = data;
+    uint64_t hashed = 0;
+    rc_t rc = 0;
+
+    char * buffer = malloc ( KAR_HASH_CHUNK );
+    if ( buffer == NULL )
+        rc = RC ( rcExe, rcThread, rcExecuting, rcMemory, rcExhausted );
+
+    while ( rc == 0 && hashed < self -> archive_size )
+    {
+        uint64_t ready;
+
+        KLockAcquire ( self -> lock );
+        while ( self -> ready == hashed && self -> rc == 0 )
+            KConditionWait ( self -> cond, self -> lock );
+        ready = self -> ready;
+        rc = self -> rc;
+        KLockUnlock ( self -> lock );
+
+        while ( rc == 0 && hashed < ready )
+        {
+            size_t num_read;
+            size_t to_read = KAR_HASH_CHUNK;
+            if ( hashed + to_read > ready )
+                to_read = ( size_t ) ( ready - hashed );
+
+            rc = KFileReadAll ( self -> archive, hashed, buffer, to_read, & num_read );
+            if ( rc == 0 && num_read != to_read )
+                rc = RC ( rcExe, rcFile, rcReading, rcTransfer, rcIncomplete );
+            if ( rc == 0 )
+            {
+                MD5StateAppend ( & self -> md5, buffer, num_read );
+                hashed += num_read;
+            }
+        }
+    }
+
+    if ( rc != 0 )
+    {
+        KLockAcquire ( self -> lock );
+        if ( self -> rc == 0 )
+            self -> rc = rc;
+        KLockUnlock ( self -> lock );
+    }
+
+    free ( buffer );
+    return rc;
+}
+
+static
+void kar_hasher_whack ( KARHasher * self )
+{
+    KConditionRelease ( self -> cond );
+    KLockRelease ( self -> lock );
+    KFileRelease ( self -> archive );
+    free ( self -> regions );
+    free ( self );
+}
+
+rc_t kar_hasher_make ( KARHasher ** hasher, const KFile * archive, uint64_t archive_size )
+{
+    rc_t rc;
+    KARHasher * self;
+
+    if ( hasher == NULL || archive == NULL )
+        return RC ( rcExe, rcFile, rcConstructing, rcParam, rcNull );
+
+    * hasher = NULL;
+
+    self = calloc ( 1, sizeof * self );
+    if ( self == NULL )
+        return RC ( rcExe, rcFile, rcConstructing, rcMemory, rcExhausted );
+
+    self -> archive_size = archive_size;
+    MD5StateInit ( & self -> md5 );
+
+    rc = KFileAddRef ( archive );
+    if ( rc == 0 )
+    {
+        self -> archive = archive;
+        rc = KLockMake ( & self -> lock );
+        if ( rc == 0 )
+        {
+            rc = KConditionMake ( & self -> cond );
+            if ( rc == 0 )
+            {
+                rc = KThreadMake ( & self -> thread, kar_hasher_thread, self );
+                if ( rc == 0 )
+                {
+                    * hasher = self;
+                    return 0;
+                }
+            }
+        }
+    }
+
+    LOGERR ( klogErr, rc, "failed to start md5 thread" );
+    kar_hasher_whack ( self );
+    return rc;
+}
+
+rc_t kar_hasher_done ( KARHasher * self, uint64_t pos, uint64_t size )
+{
+    rc_t rc = 0;
+
+    if ( self == NULL || size == 0 )
+        return 0;
+
+    KLockAcquire ( self -> lock );
+    if ( pos <= self -> ready )
+    {
+        if ( pos + size > self -> ready )
+        {
+            self -> ready = pos + size;
+            kar_hasher_merge ( self );
+            KConditionSignal ( self -> cond );
+        }
+    }
+    else
+    {
+        if ( self -> num_regions == self -> max_regions )
+        {
+            size_t max_regions = self -> max_regions == 0 ? 256 : self -> max_regions * 2;
+            kar_region * regions = realloc ( self -> regions, max_regions * sizeof * regions );
+            if ( regions == NULL )
+                rc = RC ( rcExe, rcFile, rcWriting, rcMemory, rcExhausted );
+            else
+            {
+                self -> regions = regions;
+                self -> max_regions = max_regions;
+            }
+        }
+        if ( rc == 0 )
+        {
+            self -> regions [ self -> num_regions ] . pos = pos;
+            self -> regions [ self -> num_regions ] . end = pos + size;
+            ++ self -> num_regions;
+        }
+    }
+    if ( rc != 0 && self -> rc == 0 )
+    {
+        self -> rc = rc;
+        KConditionSignal ( self -> cond );
+    }
+    KLockUnlock ( self -> lock );
+
+    return rc;
+}
+
+rc_t kar_hasher_finish ( KARHasher * self, uint8_t digest [ 16 ] )
+{
+    rc_t rc, rc_thread = 0;
+
+    if ( self == NULL )
+        return RC ( rcExe, rcFile, rcClosing, rcSelf, rcNull );
+
+    KLockAcquire ( self -> lock );
+    if ( self -> ready < self -> archive_size && self -> rc == 0 )
+    {
+        /* some part of the archive was never reported */
+        self -> rc = RC ( rcExe, rcFile, rcClosing, rcTransfer, rcIncomplete );
+        KConditionSignal ( self -> cond );
+    }
+    KLockUnlock ( self -> lock );
+
+    rc = KThreadWait ( self -> thread, & rc_thread );
+    KThreadRelease ( self -> thread );
+    if ( rc == 0 )
+        rc = rc_thread != 0 ? rc_thread : self -> rc;
+
+    if ( rc == 0 )
+        MD5StateFinish ( & self -> md5, digest );
+
+    kar_hasher_whack ( self );
+    return rc;
+}
@@ -0,0 +1,82 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ */
+#ifndef _h_kar_pool_
+#define _h_kar_pool_
+
+#ifndef _h_klib_defs_
+#include <klib/defs.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct KFile;
+
+/* number of threads used when none was given on the command line */
+#define KAR_POOL_DEFAULT_THREADS 4
+
+/* size of the copy buffer owned by every thread of the pool */
+#define KAR_POOL_BUFFER_SIZE ( 32 * 1024 * 1024 )
+
+
+/* kar_pool_job
+ *  processes item "idx" using the calling thread's "buffer"
+ */
+typedef rc_t ( CC * kar_pool_job ) ( void * data, uint64_t idx, char * buffer, size_t bsize );
+
+/* kar_pool_run
+ *  runs "job" for every item in [ 0, count ) on up to "threads" threads
+ *  items are handed out in increasing order; the first failure stops the pool
+ *  and is returned
+ *
+ *  "threads" == 0 means KAR_POOL_DEFAULT_THREADS
+ */
+rc_t kar_pool_run ( uint32_t threads, uint64_t count, kar_pool_job job, void * data );
+
+
+/* KARHasher
+ *  computes the MD5 of an archive that is being written out of order
+ *
+ *  writers report every region of the archive as it is completed;
+ *  a background thread reads back and hashes the archive up to the end
+ *  of the longest completed prefix, so that hashing overlaps with writing
+ */
+typedef struct KARHasher KARHasher;
+
+rc_t kar_hasher_make ( KARHasher ** hasher, const struct KFile * archive, uint64_t archive_size );
+
+/* report [ pos, pos + size ) of the archive as written */
+rc_t kar_hasher_done ( KARHasher * self, uint64_t pos, uint64_t size );
+
+/* waits until the whole archive is hashed, returns its digest and releases the hasher */
+rc_t kar_hasher_finish ( KARHasher * self, uint8_t digest [ 16 ] );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _h_kar_pool_ */
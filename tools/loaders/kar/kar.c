@@ -25,6 +25,7 @@
  */
 
 #include "kar-args.h"
+#include "kar-pool.h"
 
 #include <klib/rc.h>
 #include <klib/namelist.h>
@@ -726,7 +727,7 @@ rc_t kar_scan_path ( const KDirectory *dir, BSTree *tree, const char *path )
 /********** md5  */
 
 static
-rc_t kar_md5 ( KDirectory *wd, KFile **archive, const char *path, KCreateMode mode )
+rc_t kar_md5 ( KDirectory *wd, KMD5SumFmt **fmt, const char *path, KCreateMode mode )
 {
     rc_t rc = 0;
     KFile *md5_f;
@@ -737,46 +738,36 @@ rc_t kar_md5 ( KDirectory *wd, KFile **archive, const char *path, KCreateMode mo
         PLOGERR (klogFatal, (klogFatal, rc, "unable to create md5 file [$(A).md5]", PLOG_S(A), path));
     else
     {
-        KMD5SumFmt *fmt;
-
-        /* create md5 formatter to write to md5_f */
-        rc = KMD5SumFmtMakeUpdate ( &fmt, md5_f );
+        /* create md5 formatter to write to md5_f
+           the digest itself is calculated by a KARHasher while the archive is written */
+        rc = KMD5SumFmtMakeUpdate ( fmt, md5_f );
         if ( rc )
-            LOGERR (klogErr, rc, "failed to make KMD5SumFmt");
-        else
         {
-            KMD5File *kmd5_f;
-
-            size_t size = string_size ( path );
-            const char *fname = string_rchr ( path, size, '/' );
-            if ( fname ++ == NULL )
-                fname = path;
-
-            /* KMD5SumFmtMakeUpdate() took over ownership of "md5_f" */
-            md5_f = NULL;
-
-            /* create a file that knows how to calculate md5 as data
-                       are written-through to archive, and then write digest
-                       result to fmt, using "fname" as description. */
-            rc = KMD5FileMakeWrite ( &kmd5_f, * archive, fmt, fname );
-            KMD5SumFmtRelease ( fmt );
-            if ( rc )
-                LOGERR (klogErr, rc, "failed to make KMD5File");
-            else
-            {
-                /* success */
-                *archive = KMD5FileToKFile ( kmd5_f );
-                return 0;
-            }
+            LOGERR (klogErr, rc, "failed to make KMD5SumFmt");
+            KFileRelease ( md5_f );
         }
-
-        /* error cleanup */
-        KFileRelease ( md5_f );
     }
 
     return rc;
 }
 
+static
+rc_t kar_md5_update ( KMD5SumFmt *fmt, const char *path, const uint8_t digest [ 16 ] )
+{
+    rc_t rc;
+
+    size_t size = string_size ( path );
+    const char *fname = string_rchr ( path, size, '/' );
+    if ( fname ++ == NULL )
+        fname = path;
+
+    rc = KMD5SumFmtUpdate ( fmt, fname, digest, true );
+    if ( rc )
+        LOGERR (klogErr, rc, "failed to write md5 digest");
+
+    return rc;
+}
+
 /********** write to toc and archive  */
 
 static
@@ -1190,14 +1181,14 @@ size_t kar_entry_full_path ( const KAREntry * entry, const char * root_dir, char
 }
 
 static
-void kar_write_file ( KARArchiveFile *af, const KDirectory *wd, const KARFile *file, const char * root_dir )
+rc_t kar_write_file ( const KARArchiveFile *af, const KDirectory *wd, const KARFile *file, const char * root_dir,
+                      bool pad, char *buffer, size_t bsize, KARHasher *hasher )
 {
     rc_t rc;
-    char *buffer;
     size_t num_read, align_size;
     uint64_t pos = 0;
+    uint64_t apos = af -> starting_pos + file -> byte_offset;
     char align_buffer [ 4 ] = "0000";
-    size_t bsize = 128 * 1024 * 1024;
 
     const KFile *f;
 
@@ -1205,10 +1196,7 @@ void kar_write_file ( KARArchiveFile *af, const KDirectory *wd, const KARFile *f
     size_t path_size;
 
     if ( file -> byte_size == 0 )
-        return;
-
-    if ( bsize > file -> byte_size )
-        bsize = file -> byte_size;
+        return 0;
 
     STATUS ( STAT_QA, "writing file '%s'", file -> dad . name );
 
@@ -1218,7 +1206,7 @@ void kar_write_file ( KARArchiveFile *af, const KDirectory *wd, const KARFile *f
         /* path name was somehow too long */
         rc = RC ( rcExe, rcFile, rcWriting, rcMemory, rcExhausted );
         LogErr ( klogInt, rc, "File path was too long" );
-        exit (5);
+        return rc;
     }
 
     STATUS ( STAT_QA, "opening: full path is '%s'", filename );
@@ -1226,25 +1214,10 @@ void kar_write_file ( KARArchiveFile *af, const KDirectory *wd, const KARFile *f
     if ( rc != 0 )
     {
         pLogErr ( klogInt, rc, "Failed to open file $(fname)", "fname=%s", file -> dad . name );
-        exit (6);
-    }
-
-    STATUS ( STAT_QA, "allocating buffer of %,zu bytes", bsize );
-    buffer = malloc ( bsize );
-    if ( buffer == NULL )
-    {
-        rc = RC ( rcExe, rcFile, rcWriting, rcMemory, rcExhausted );
-        pLogErr ( klogInt, rc, "Failed to open file $(fname)", "fname=%s", file -> dad . name );
-        exit ( 7 );
+        return rc;
     }
 
-    /* establish current position */
-    align_size = align_offset ( af -> pos, 4 ) - af -> pos;
-    if ( align_size != 0  )
-        rc = KFileWriteAll ( af -> archive, af -> pos, align_buffer, align_size, NULL );
-
-    af -> pos = af -> starting_pos + file -> byte_offset;
-
+    /* every file lands at its own offset, so files can be written in any order */
     while ( rc == 0 && pos < file -> byte_size )
     {
         size_t num_writ, to_read = bsize;
@@ -1254,30 +1227,60 @@ void kar_write_file ( KARArchiveFile *af, const KDirectory *wd, const KARFile *f
 
         STATUS ( STAT_QA, "about to read at offset %lu from input file '%s'", pos, filename );
         rc = KFileReadAll ( f, pos, buffer, to_read, & num_read );
-        if ( rc != 0 || num_read == 0 )
+        if ( rc == 0 && num_read == 0 )
+            rc = RC ( rcExe, rcFile, rcReading, rcTransfer, rcIncomplete );
+        if ( rc != 0 )
             break;
 
         STATUS ( STAT_QA, "about to write %zu bytes to archive", num_read );
-        rc = KFileWriteAll ( af -> archive, af -> pos, buffer, num_read, & num_writ );
-        if ( rc != 0 || num_writ != num_read )
-        {
-            /* error */
-            break;
-        }
+        rc = KFileWriteAll ( af -> archive, apos + pos, buffer, num_read, & num_writ );
+        if ( rc == 0 && num_writ != num_read )
+            rc = RC ( rcExe, rcFile, rcWriting, rcTransfer, rcIncomplete );
 
-        af -> pos += num_writ;
         pos += num_read;
     }
 
-    STATUS ( STAT_PRG, "freeing memory" );
-    free ( buffer );
+    /* pad up to the next file */
+    align_size = pad ? align_offset ( apos + pos, 4 ) - ( apos + pos ) : 0;
+    if ( rc == 0 && align_size != 0 )
+        rc = KFileWriteAll ( af -> archive, apos + pos, align_buffer, align_size, NULL );
+
+    if ( rc != 0 )
+        pLogErr ( klogInt, rc, "Failed to write file $(fname) to archive", "fname=%s", file -> dad . name );
+    else
+        rc = kar_hasher_done ( hasher, apos, pos + align_size );
 
     STATUS ( STAT_QA, "closing '%s'", filename );
     KFileRelease ( f );
+
+    return rc;
+}
+
+typedef struct kar_write_block kar_write_block;
+struct kar_write_block
+{
+    const KARArchiveFile *af;
+    const KDirectory *wd;
+    KARFilePtrArray files;
+    uint64_t num_files;
+    const char *root_dir;
+    KARHasher *hasher;
+};
+
+static
+rc_t CC kar_write_file_job ( void *data, uint64_t idx, char *buffer, size_t bsize )
+{
+    const kar_write_block *wb = data;
+    const KARFile *file = wb -> files [ idx ];
+
+    STATUS ( STAT_QA, "writing file %lu: '%s'", idx, file -> dad . name );
+    return kar_write_file ( wb -> af, wb -> wd, file, wb -> root_dir,
+                            idx + 1 < wb -> num_files, buffer, bsize, wb -> hasher );
 }
 
 static
-rc_t kar_make ( const KDirectory * wd, KFile *archive, const BSTree *tree, const char * root_dir )
+rc_t kar_make ( const KDirectory * wd, KFile *archive, const BSTree *tree, const char * root_dir,
+                uint32_t threads, uint8_t digest [ 16 ] )
 {
     rc_t rc = 0;
 
@@ -1286,8 +1289,10 @@ rc_t kar_make ( const KDirectory * wd, KFile *archive, const BSTree *tree, const
     rc = kar_prepare_toc ( tree, &file_array );
     if ( rc == 0 )
     {
-        uint64_t i, toc_size;
+        uint64_t toc_size, archive_size;
         KARArchiveFile af;
+        KARHasher *hasher = NULL;
+
         /* evaluate toc size */
         toc_size = kar_eval_toc_size ( tree );
 
@@ -1301,12 +1306,44 @@ rc_t kar_make ( const KDirectory * wd, KFile *archive, const BSTree *tree, const
         /* write toc */
         kar_write_toc ( & af, tree );
 
-        /* write each of the files in order */
-        STATUS ( STAT_QA, "about to write %u files", num_files );
-        for ( i = 0; i < num_files; ++ i )
+        /* size the archive up front so that files can be written concurrently */
+        archive_size = af . starting_pos;
+        if ( num_files != 0 )
         {
-            STATUS ( STAT_QA, "writing file %u: '%s'", i, file_array [ i ] -> dad . name );
-            kar_write_file ( & af, wd, file_array [ i ], root_dir );
+            const KARFile *last = file_array [ num_files - 1 ];
+            archive_size += last -> byte_offset + last -> byte_size;
+        }
+        rc = KFileSetSize ( archive, archive_size );
+        if ( rc != 0 )
+            LogErr ( klogInt, rc, "Failed to set archive size" );
+
+        if ( rc == 0 && digest != NULL )
+        {
+            rc = kar_hasher_make ( & hasher, archive, archive_size );
+            if ( rc == 0 )
+                rc = kar_hasher_done ( hasher, 0, af . starting_pos );
+        }
+
+        if ( rc == 0 )
+        {
+            kar_write_block wb;
+            wb . af = & af;
+            wb . wd = wd;
+            wb . files = file_array;
+            wb . num_files = num_files;
+            wb . root_dir = root_dir;
+            wb . hasher = hasher;
+
+            /* write the files, each at its own offset */
+            STATUS ( STAT_QA, "about to write %u files", num_files );
+            rc = kar_pool_run ( threads, num_files, kar_write_file_job, & wb );
+        }
+
+        if ( hasher != NULL )
+        {
+            rc_t rc2 = kar_hasher_finish ( hasher, digest );
+            if ( rc == 0 )
+                rc = rc2;
         }
 
         free ( file_array );
@@ -1332,8 +1369,10 @@ rc_t kar_create ( const Params *p )
     else
     {
         KFile *archive;
+        KMD5SumFmt *md5 = NULL;
         KCreateMode mode = ( p -> force ? kcmInit : kcmCreate ) | kcmParents;
-        rc = KDirectoryCreateFile ( wd, &archive, false, 0666, mode,
+        /* the md5 is calculated by reading the archive back, so it needs to be readable */
+        rc = KDirectoryCreateFile ( wd, &archive, p -> md5sum, 0666, mode,
                                     "%s", p -> archive_path );
         if ( rc != 0 )
         {
@@ -1343,7 +1382,7 @@ rc_t kar_create ( const Params *p )
         else
         {
             if ( p -> md5sum )
-                rc = kar_md5 ( wd, &archive, p -> archive_path, mode );
+                rc = kar_md5 ( wd, &md5, p -> archive_path, mode );
 
             if ( rc == 0 )
             {
@@ -1365,9 +1404,13 @@ rc_t kar_create ( const Params *p )
                         {
                             BSTreeForEach ( &tree, false, kar_entry_link_parent_dir, NULL );
 
-                            rc = kar_make ( wd, archive, &tree, p -> directory_path );
+                            uint8_t digest [ 16 ];
+                            rc = kar_make ( wd, archive, &tree, p -> directory_path,
+                                            p -> threads, md5 != NULL ? digest : NULL );
                             if ( rc != 0 )
                                 LogErr ( klogInt, rc, "Failed to build archive" );
+                            else if ( md5 != NULL )
+                                rc = kar_md5_update ( md5, p -> archive_path, digest );
                         }
                     }
                 }
@@ -1375,6 +1418,8 @@ rc_t kar_create ( const Params *p )
                 BSTreeWhack ( & tree, kar_entry_whack, NULL );
             }
 
+            if ( md5 != NULL )
+                KMD5SumFmtRelease ( md5 );
             KFileRelease ( archive );
         }
 
@@ -2027,6 +2072,8 @@ struct extract_block
 
     file_depot * depot;
 
+    uint32_t threads;
+
     rc_t rc;
 
 };
@@ -2048,30 +2095,22 @@ rc_t extract_file ( const KARFile *src, const extract_block *eb )
 }
 
 static
-rc_t store_extracted_file ( stored_file * sf, const extract_block * eb )
+rc_t store_extracted_file ( stored_file * sf, const extract_block * eb, char *buffer, size_t bsize )
 {
     KFile *dst;
-    char *buffer;
     size_t num_writ = 0, num_read = 0, total = 0;
-    size_t bsize = 256 * 1024 *1024;
 
     rc_t rc = KDirectoryCreateFile ( sf -> cdir, &dst, false, 0200,
                                  kcmCreate, "%s", SF_SE(sf,name) );
     if ( rc != 0 )
     {
         pLogErr (klogErr, rc, "failed extract to file '$(fname)'", "fname=%s", SF_SE(sf,name) );
-        exit ( 4 );
-    }
-
-
-    buffer = malloc ( bsize );
-    if ( buffer == NULL )
-    {
-        rc = RC ( rcExe, rcFile, rcAllocating, rcMemory, rcExhausted );
-        pLogErr (klogErr, rc, "failed to allocate '$(mem)'", "mem=%zu", bsize );
-        exit ( 4 );
+        return rc;
     }
 
+        /*  runs on a worker of the pool: errors are returned,
+         *  the pool stops at the first one and the caller reports it
+         */
     for ( total = 0; total < SF_SF(sf,byte_size); total += num_read )
     {
         size_t to_read =  SF_SF(sf,byte_size) - total;
@@ -2083,35 +2122,34 @@ rc_t store_extracted_file ( stored_file * sf, const extract_block * eb )
         if ( rc != 0 )
         {
             pLogErr (klogErr, rc, "failed to read from archive '$(fname)'", "fname=%s", SF_SE(sf,name) );
-            exit ( 4 );
+            break;
         }
 
         if ( num_read == 0 && to_read != 0 ) {
             /*  we reached end of file, and we still need more data
              */
+            rc = RC ( rcExe, rcFile, rcReading, rcTransfer, rcIncomplete );
             pLogErr (klogErr, rc, "end of file reached while reading from archive '$(fname)'", "fname=%s", SF_SE(sf,name) );
-            exit ( 4 );
+            break;
         }
 
         rc = KFileWriteAll ( dst, total, buffer, num_read, &num_writ );
         if ( rc != 0 )
         {
             pLogErr (klogErr, rc, "failed to write to file '$(fname)'", "fname=%s", SF_SE(sf,name) );
-            exit ( 4 );
+            break;
         }
 
         if ( num_writ < num_read )
         {
             rc = RC ( rcExe, rcFile, rcWriting, rcTransfer, rcIncomplete );
             pLogErr (klogErr, rc, "failed to write to file '$(fname)'", "fname=%s", SF_SE(sf,name) );
-            exit ( 4 );
+            break;
         }
     }
 
     KFileRelease ( dst );
 
-    free ( buffer );
-
     return rc;
 }   /* store_extracted_file () */
 
@@ -2128,6 +2166,17 @@ store_extracted_files_comparator (
     return SF_SF(sl,byte_offset) - SF_SF(sr,byte_offset);
 }   /* store_extracted_files_comparator () */
 
+static
+rc_t CC store_extracted_file_job ( void * data, uint64_t idx, char * buffer, size_t bsize )
+{
+    const extract_block * eb = ( const extract_block * ) data;
+
+        /*  files are independent of each other, so they are stored
+         *  concurrently, every worker with its own buffer
+         */
+    return store_extracted_file ( eb -> depot -> depot + idx, eb, buffer, bsize );
+}   /* store_extracted_file_job () */
+
 static
 rc_t store_extracted_files ( const extract_block * eb )
 {
@@ -2143,13 +2192,10 @@ rc_t store_extracted_files ( const extract_block * eb )
             NULL
             );
 
-    for ( size_t llp = 0; llp < fb -> qty; llp ++ ) {
-        stored_file * sf = fb -> depot + llp;
-        rc = store_extracted_file ( sf, eb );
-        if ( rc != 0 ) {
-            pLogErr (klogErr, rc, "failed to store extracted files", "" );
-            exit ( 4 );
-        }
+    rc = kar_pool_run ( eb -> threads, fb -> qty, store_extracted_file_job, ( void * ) eb );
+    if ( rc != 0 ) {
+        pLogErr (klogErr, rc, "failed to store extracted files", "" );
+        exit ( 4 );
     }
 
     return rc;
@@ -2356,6 +2402,7 @@ rc_t kar_test_extract ( const Params *p )
                     eb . archive = archive;
                     eb . extract_pos = file_offset;
                     eb . rc = 0;
+                    eb . threads = p -> threads;
 
                     rc = file_depot_make ( & eb . depot, 256 );
                     if ( rc == 0 )
@@ -58,6 +58,8 @@
 
 #include <kfs/arrayfile.h>
 
+#include <kproc/thread.h>
+
 #include <loader/loader-meta.h>
 
 #include <sysalloc.h>
@@ -260,33 +262,146 @@ static rc_t pacbio_prepare( VDatabase * database, seq_con_pas_met * dst, KDirect
 }
 
 
+/* every sub-table is loaded by its own thread into its own cursor */
+typedef rc_t ( * pl_src_loader )( seq_con_pas_met * dst, KDirectory * src );
+
+typedef struct pl_job
+{
+    KThread * thread;
+    seq_con_pas_met * dst;
+    KDirectory * src;
+    pl_src_loader loader;
+    rc_t rc;
+    bool started;
+    bool required; /* if it fails, the other tables are cancelled */
+} pl_job;
+
+
+static rc_t load_seq_job( seq_con_pas_met * dst, KDirectory * src )
+{
+    return load_seq_src( &dst->sequence, src ); /* pl-sequence.c */
+}
+
+
+static rc_t load_consensus_job( seq_con_pas_met * dst, KDirectory * src )
+{
+    return load_consensus_src( &dst->consensus, src ); /* pl-consensus.c */
+}
+
+
+static rc_t load_passes_job( seq_con_pas_met * dst, KDirectory * src )
+{
+    return load_passes_src( &dst->passes, src ); /* pl-passes.c */
+}
+
+
+static rc_t load_metrics_job( seq_con_pas_met * dst, KDirectory * src )
+{
+    return load_metrics_src( &dst->metrics, src ); /* pl-metrics.c */
+}
+
+
+static rc_t pl_job_run( pl_job * job )
+{
+    job->rc = job->loader( job->dst, job->src );
+    if ( job->rc != 0 && job->required )
+        pl_cancel_tables( true );
+    return job->rc;
+}
+
+
+static rc_t CC pl_job_thread( const KThread *self, void *data )
+{
+    return pl_job_run( data );
+}
+
+
+static void pl_job_start( pl_job * job, seq_con_pas_met * dst, KDirectory * src,
+                          pl_src_loader loader, bool required )
+{
+    job->dst = dst;
+    job->src = src;
+    job->loader = loader;
+    job->rc = 0;
+    job->started = true;
+    job->required = required;
+    if ( KThreadMake ( &job->thread, pl_job_thread, job ) != 0 )
+    {
+        /* no thread available: do the job on the calling thread */
+        job->thread = NULL;
+        pl_job_run( job );
+    }
+}
+
+
+static rc_t pl_job_wait( pl_job * job )
+{
+    if ( job->thread != NULL )
+    {
+        rc_t status;
+        rc_t rc = KThreadWait ( job->thread, &status );
+        if ( rc == 0 )
+            rc = status;
+        if ( job->rc == 0 )
+            job->rc = rc;
+        KThreadRelease ( job->thread );
+        job->thread = NULL;
+    }
+    return job->rc;
+}
+
+
+/* the sequence-table and the consensus-group are loaded side by side,
+   passes and metrics depend on the consensus-group: they are started only
+   after it has been loaded without error ( or was loaded from an earlier source ).
+   A failing sequence-table cancels all the others, its error is the one returned. */
 static rc_t pacbio_load_src( context *ctx, seq_con_pas_met * dst, KDirectory * src, bool * consensus_present )
 {
     rc_t rc1, rc = 0;
+    pl_job seq, con, pas, met;
+
+    memset( &seq, 0, sizeof seq );
+    memset( &con, 0, sizeof con );
+    memset( &pas, 0, sizeof pas );
+    memset( &met, 0, sizeof met );
+    pl_cancel_tables( false );
 
     if ( ctx_ld_sequence( ctx ) )
-        rc = load_seq_src( &dst->sequence, src ); /* pl-sequence.c */
+        pl_job_start( &seq, dst, src, load_seq_job, true );
+    if ( ctx_ld_consensus( ctx ) && !pl_tables_cancelled() )
+        pl_job_start( &con, dst, src, load_consensus_job, false );
 
-    if ( rc == 0 && ctx_ld_consensus( ctx ) )
+    if ( con.started )
     {
-        rc1 = load_consensus_src( &dst->consensus, src ); /* pl-consensus.c */
+        rc1 = pl_job_wait( &con );
         if ( rc1 == 0 )
             *consensus_present = true;
-        else
+        else if ( !pl_tables_cancelled() )
             LOGMSG( klogWarn, "the consensus-group is missing" );
     }
 
-    if ( rc == 0 && ctx_ld_passes( ctx ) && *consensus_present )
+    if ( *consensus_present && !pl_tables_cancelled() )
     {
-        rc1 = load_passes_src( &dst->passes, src ); /* pl-passes.c */
-        if ( rc1 != 0 )
+        if ( ctx_ld_passes( ctx ) )
+            pl_job_start( &pas, dst, src, load_passes_job, false );
+        if ( ctx_ld_metrics( ctx ) )
+            pl_job_start( &met, dst, src, load_metrics_job, false );
+    }
+
+    if ( seq.started )
+        rc = pl_job_wait( &seq );
+
+    if ( pas.started )
+    {
+        rc1 = pl_job_wait( &pas );
+        if ( rc1 != 0 && rc == 0 )
             LOGMSG( klogWarn, "the passes-table is missing" );
     }
 
-    if ( rc == 0 && ctx_ld_metrics( ctx ) && *consensus_present )
+    if ( met.started )
     {
-        rc1 = load_metrics_src( &dst->metrics, src ); /* pl-metrics.c */
-        if ( rc1 != 0 )
+        rc1 = pl_job_wait( &met );
+        if ( rc1 != 0 && rc == 0 )
             LOGMSG( klogWarn, "the metrics-table is missing" );
     }
     return rc;
@@ -372,9 +487,27 @@ static rc_t pacbio_load_multipart( context * ctx, KDirectory * wd, VDatabase * d
                                    ld_context * lctx, uint32_t count )
 {
     seq_con_pas_met dst;
+    ld_context table_lctx[ 4 ];
     uint32_t idx = 0;
     /* the loop is complicated, because pacbio_prepare needs the first hdf5-src opened ! */
     rc_t rc = pacbio_prepare( database, &dst, *hdf5_src, lctx );
+
+    /* the tables are loaded concurrently: each one gets its own progressbar,
+       only the sequence-table prints its progress to the terminal */
+    for ( idx = 0; idx < 4; ++idx )
+    {
+        table_lctx[ idx ] = *lctx;
+        table_lctx[ idx ].xml_progress = NULL;
+        table_lctx[ idx ].total_seq_bases = 0;
+        table_lctx[ idx ].total_seq_spots = 0;
+        table_lctx[ idx ].with_progress = ( idx == 0 ) && lctx->with_progress;
+    }
+    dst.sequence.lctx = &table_lctx[ 0 ];
+    dst.consensus.lctx = &table_lctx[ 1 ];
+    dst.passes.lctx = &table_lctx[ 2 ];
+    dst.metrics.lctx = &table_lctx[ 3 ];
+
+    idx = 0;
     while ( idx < count && rc == 0 )
     {
         rc = pacbio_load_src( ctx, &dst, *hdf5_src, consensus_present );
@@ -387,6 +520,14 @@ static rc_t pacbio_load_multipart( context * ctx, KDirectory * wd, VDatabase * d
     }
     pacbio_finish( &dst );
     KDirectoryRelease ( *hdf5_src );
+
+    lctx->total_seq_bases += table_lctx[ 0 ].total_seq_bases;
+    lctx->total_seq_spots += table_lctx[ 0 ].total_seq_spots;
+    for ( idx = 0; idx < 4; ++idx )
+    {
+        if ( table_lctx[ idx ].xml_progress != NULL )
+            KLoadProgressbar_Release( table_lctx[ idx ].xml_progress, false );
+    }
     return rc;
 }
 
@@ -627,16 +768,16 @@ rc_t CC KMain ( int argc, char *argv [] )
                     {
                         lctx.with_progress = ctx.with_progress;
                         lctx.dst_path = ctx.dst_path;
-                        lctx.cache_content = false;
+                        lctx.cache_content = true; /* read through bounded, prefetched windows */
                         lctx.check_src_obj = false;
 
-                        rc = KLoadProgressbar_Make( &lctx.xml_progress, 0 );
-                        if ( rc != 0 )
+                        rc = pl_locks_make(); /* pl-tools.c */
+                        if ( rc == 0 )
                         {
-                            LOGERR( klogErr, rc, "cannot create LoadProgressBar" );
-                        }
-                        else
+                            /* every table makes its own LoadProgressBar ( progress_chunk ) */
                             rc = pacbio_load( &ctx, wd, &lctx, argv[ 0 ] );
+                        }
+                        pl_locks_release();
 
                     }
                     ctx_free( &ctx );
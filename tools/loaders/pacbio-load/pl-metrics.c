@@ -640,7 +640,7 @@ static rc_t metrics_load_loop( ld_context *lctx, VCursor * cursor, Metrics_src *
             uint32_t i;
             for ( i = 0; i < block.n_read && rc == 0; ++i )
             {
-                rc = Quitting();
+                rc = pl_quitting();
                 if ( rc == 0 )
                 {
                     /* to be replaced with progressbar action... */
@@ -291,7 +291,7 @@ static rc_t passes_load_loop( ld_context *lctx, VCursor * cursor, Passes_src *ta
             uint32_t i;
             for ( i = 0; i < block.n_read && rc == 0; ++i )
             {
-                rc = Quitting();
+                rc = pl_quitting();
                 if ( rc == 0 )
                 {
                     rc = passes_load_pass( cursor, &block, i, col_idx );
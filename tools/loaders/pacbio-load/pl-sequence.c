@@ -658,7 +658,7 @@ static rc_t seq_loader( ld_context *lctx, KDirectory * hdf5_src, VCursor * curso
                 const KNamelist *region_types;
                 /* read the meta-data-entry "RegionTypes" of the hdf5-regions-table
                    into a KNamelist */
-                rc = KArrayFileGetMeta ( BaseCallsTab.rgn.hdf5_regions.af, "RegionTypes", &region_types );
+                rc = array_file_get_meta( &BaseCallsTab.rgn.hdf5_regions, "RegionTypes", &region_types );
                 if ( rc != 0 )
                 {
                     LOGERR( klogErr, rc, "cannot read Regions.RegionTypes" );
@@ -865,7 +865,7 @@ rc_t load_seq_src( seq_ctx * sctx, KDirectory * hdf5_src )
                 const KNamelist *region_types;
                 /* read the meta-data-entry "RegionTypes" of the hdf5-regions-table
                    into a KNamelist */
-                rc = KArrayFileGetMeta ( sctx->BaseCallsTab.rgn.hdf5_regions.af, "RegionTypes", &region_types );
+                rc = array_file_get_meta( &sctx->BaseCallsTab.rgn.hdf5_regions, "RegionTypes", &region_types );
                 if ( rc != 0 )
                 {
                     LOGERR( klogErr, rc, "cannot read Regions.RegionTypes" );
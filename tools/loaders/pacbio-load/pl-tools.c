@@ -34,6 +34,9 @@
 #include <kdb/database.h>
 #include <vdb/database.h>
 #include <vdb/vdb-priv.h>
+#include <kfs/kfs-priv.h>       /* access to getmeta of KArrayfile*/
+#include <kproc/lock.h>
+#include <atomic32.h>
 
 void lctx_init( ld_context * lctx )
 {
@@ -63,6 +66,78 @@ void lctx_free( ld_context * lctx )
 }
 
 
+static KLock * hdf5_lock = NULL;
+static KLock * progress_lock = NULL;
+
+
+rc_t pl_locks_make( void )
+{
+    rc_t rc = KLockMake ( &hdf5_lock );
+    if ( rc != 0 )
+        LOGERR( klogErr, rc, "cannot create hdf5-lock" );
+    else
+    {
+        rc = KLockMake ( &progress_lock );
+        if ( rc != 0 )
+            LOGERR( klogErr, rc, "cannot create progress-lock" );
+    }
+    return rc;
+}
+
+
+void pl_locks_release( void )
+{
+    if ( hdf5_lock != NULL )
+    {
+        KLockRelease ( hdf5_lock );
+        hdf5_lock = NULL;
+    }
+    if ( progress_lock != NULL )
+    {
+        KLockRelease ( progress_lock );
+        progress_lock = NULL;
+    }
+}
+
+
+static atomic32_t tables_cancelled;
+
+
+void pl_cancel_tables( bool cancel )
+{
+    atomic32_set( &tables_cancelled, cancel ? 1 : 0 );
+}
+
+
+bool pl_tables_cancelled( void )
+{
+    return atomic32_read( &tables_cancelled ) != 0;
+}
+
+
+rc_t pl_quitting( void )
+{
+    rc_t rc = Quitting();
+    if ( rc == 0 && pl_tables_cancelled() )
+        rc = RC( rcExe, rcTable, rcWriting, rcTable, rcCanceled );
+    return rc;
+}
+
+
+static void pl_lock( KLock * lock )
+{
+    if ( lock != NULL )
+        KLockAcquire ( lock );
+}
+
+
+static void pl_unlock( KLock * lock )
+{
+    if ( lock != NULL )
+        KLockUnlock ( lock );
+}
+
+
 rc_t check_src_objects( const KDirectory *hdf5_dir,
                         const char ** groups, 
                         const char **tables,
@@ -72,6 +147,8 @@ rc_t check_src_objects( const KDirectory *hdf5_dir,
     uint16_t idx = 0;
     uint32_t pt;
 
+    pl_lock( hdf5_lock );
+
     if ( groups != NULL )
     {
         while ( groups[ idx ] != NULL && rc == 0 )
@@ -113,6 +190,7 @@ rc_t check_src_objects( const KDirectory *hdf5_dir,
         }
     }
 
+    pl_unlock( hdf5_lock );
     return rc;
 }
 
@@ -123,12 +201,37 @@ void init_array_file( af_data * af )
     af->af = NULL;
     af->extents = NULL;
     af->rc = -1;
-    af->content = NULL;
+    af->windowed = false;
+    af->row_bytes = 0;
+    af->window_rows = 0;
+    memset( af->window, 0, sizeof af->window );
+    af->current = 0;
+    af->prefetch_start = 0;
+    af->prefetch = NULL;
 }
 
 
-void free_array_file( af_data * af )
+/* waits for a running prefetch, returns the rc of the prefetch-thread */
+static rc_t wait_for_prefetch( af_data * af )
 {
+    rc_t rc = 0;
+    if ( af->prefetch != NULL )
+    {
+        rc_t status = 0;
+        rc = KThreadWait ( af->prefetch, &status );
+        if ( rc == 0 )
+            rc = status;
+        KThreadRelease ( af->prefetch );
+        af->prefetch = NULL;
+    }
+    return rc;
+}
+
+
+/* the caller has to hold the hdf5-lock, no prefetch can be running */
+static void release_array_file( af_data * af )
+{
+    uint32_t idx;
     if ( af->af != NULL )
     {
         KArrayFileRelease( af->af );
@@ -144,58 +247,171 @@ void free_array_file( af_data * af )
         free( af->extents );
         af->extents = NULL;
     }
-    if ( af->content != NULL )
+    for ( idx = 0; idx < 2; ++idx )
     {
-        free( af->content );
-        af->content = NULL;
+        if ( af->window[ idx ].data != NULL )
+        {
+            free( af->window[ idx ].data );
+            af->window[ idx ].data = NULL;
+        }
+        af->window[ idx ].allocated = 0;
+        af->window[ idx ].count = 0;
     }
 }
 
 
-static rc_t read_cache_content( af_data * af )
+void free_array_file( af_data * af )
+{
+    wait_for_prefetch( af );
+    pl_lock( hdf5_lock );
+    release_array_file( af );
+    pl_unlock( hdf5_lock );
+}
+
+
+/* reads count rows ( of ext2 columns ) starting at row pos */
+static rc_t read_rows( af_data * af, const uint64_t pos, void *dst,
+                       const uint64_t count, const uint64_t ext2,
+                       uint64_t *n_read )
+{
+    rc_t rc;
+    uint64_t pos2[ 2 ];
+    uint64_t read2[ 2 ];
+    uint64_t count2[ 2 ];
+
+    pos2[ 0 ] = pos;
+    pos2[ 1 ] = 0;
+    count2[ 0 ] = count;
+    count2[ 1 ] = ext2;
+    read2[ 0 ] = 0;
+
+    pl_lock( hdf5_lock );
+    rc = KArrayFileRead ( af->af, af->dimensionality, pos2, dst, count2, read2 );
+    pl_unlock( hdf5_lock );
+    *n_read = read2[ 0 ];
+    return rc;
+}
+
+
+/* fills the window with at least min_rows rows, starting at row pos */
+static rc_t fill_window( af_data * af, af_window * w, const uint64_t pos,
+                         const uint64_t min_rows )
 {
     rc_t rc = 0;
-    uint64_t filesize = ( af->element_bits >> 3 ) * ( af->extents[ 0 ] );
-    if ( af->dimensionality == 2 )
-        filesize *= af->extents[ 1 ];
-    af->content = malloc( filesize );
-    if ( af->content == NULL )
-        rc = RC ( rcApp, rcArgv, rcAccessing, rcMemory, rcExhausted );
-    else
+    uint64_t n_read = 0;
+    uint64_t rows = ( min_rows > af->window_rows ) ? min_rows : af->window_rows;
+    size_t needed;
+
+    if ( pos + rows > af->extents[ 0 ] )
+        rows = af->extents[ 0 ] - pos;
+    needed = rows * af->row_bytes;
+    w->count = 0;
+    if ( needed > w->allocated )
     {
-        uint64_t pos2[ 2 ];
-        uint64_t read2[ 2 ];
-        uint64_t count2[ 2 ];
-        rc_t rc;
+        char * tmp = realloc( w->data, needed );
+        if ( tmp == NULL )
+            rc = RC ( rcExe, rcNoTarg, rcReading, rcMemory, rcExhausted );
+        else
+        {
+            w->data = tmp;
+            w->allocated = needed;
+        }
+    }
+    if ( rc == 0 )
+        rc = read_rows( af, pos, w->data, rows,
+                        ( af->dimensionality == 2 ) ? af->extents[ 1 ] : 0, &n_read );
+    if ( rc == 0 )
+    {
+        w->start = pos;
+        w->count = n_read;
+    }
+    return rc;
+}
 
-        pos2[ 0 ] = 0;
-        pos2[ 1 ] = 0;
-        count2[ 0 ] = af->extents[ 0 ];
-        if ( af->dimensionality == 2 )
-            count2[ 1 ] = af->extents[ 1 ];
+
+static rc_t CC prefetch_thread( const KThread *self, void *data )
+{
+    af_data * af = data;
+    return fill_window( af, &af->window[ 1 - af->current ], af->prefetch_start, 0 );
+}
+
+
+/* starts reading the window that follows the current one in the background,
+   if no thread can be made, the next access just reads synchronously */
+static void start_prefetch( af_data * af )
+{
+    af_window * w = &af->window[ af->current ];
+    uint64_t next = w->start + w->count;
+    af->window[ 1 - af->current ].count = 0;
+    if ( next < af->extents[ 0 ] )
+    {
+        af->prefetch_start = next;
+        if ( KThreadMake ( &af->prefetch, prefetch_thread, af ) != 0 )
+            af->prefetch = NULL;
+    }
+}
+
+
+static bool window_has( const af_window * w, const uint64_t pos, const uint64_t count )
+{
+    return ( w->count > 0 && pos >= w->start && ( pos + count ) <= ( w->start + w->count ) );
+}
+
+
+/* serves the request out of the current window, swaps in the prefetched
+   window if the request moved past the current one, and falls back to
+   a synchronous read for random access or requests bigger than a window */
+static rc_t read_from_window( af_data * af, const uint64_t pos,
+                              void *dst, const uint64_t count,
+                              uint64_t *n_read )
+{
+    rc_t rc = 0;
+    af_window * w;
+
+    if ( ( pos + count ) > af->extents[ 0 ] )
+        return RC ( rcExe, rcNoTarg, rcLoading, rcData, rcInconsistent );
+
+    w = &af->window[ af->current ];
+    if ( !window_has( w, pos, count ) )
+    {
+        if ( wait_for_prefetch( af ) == 0 &&
+             window_has( &af->window[ 1 - af->current ], pos, count ) )
+        {
+            af->current = 1 - af->current;
+        }
         else
-            count2[ 1 ] = 0;
+            rc = fill_window( af, w, pos, count );
 
-        rc = KArrayFileRead ( af->af, af->dimensionality, pos2, 
-                              af->content, count2, read2 );
-        if ( rc != 0 )
-            LOGERR( klogErr, rc, "error reading arrayfile-data int cache" );
+        if ( rc == 0 )
+        {
+            w = &af->window[ af->current ];
+            if ( window_has( w, pos, count ) )
+                start_prefetch( af );
+            else
+                rc = RC ( rcExe, rcNoTarg, rcLoading, rcData, rcInsufficient );
+        }
+    }
+    if ( rc == 0 )
+    {
+        memmove( dst, w->data + ( pos - w->start ) * af->row_bytes, count * af->row_bytes );
+        *n_read = count;
     }
     return rc;
 }
 
 
-rc_t open_array_file( const KDirectory *dir,
-                      const char *name,
-                      af_data * af,
-                      const uint64_t expected_element_bits,
-                      const uint64_t expected_cols,
-                      bool disp_wrong_bitsize,
-                      bool cache_content,
-                      bool supress_err_msg )
+static rc_t open_array_file_locked( const KDirectory *dir,
+                                    const char *name,
+                                    af_data * af,
+                                    const uint64_t expected_element_bits,
+                                    const uint64_t expected_cols,
+                                    bool disp_wrong_bitsize,
+                                    bool cache_content,
+                                    bool supress_err_msg )
 {
     rc_t rc;
 
+
     init_array_file( af );
     /* open the requested "File" (actually a hdf5-table) as KFile 
        the works because the given KDirectory is a HDF5-Directory */
@@ -215,7 +431,7 @@ rc_t open_array_file( const KDirectory *dir,
     {
         PLOGERR( klogErr, ( klogErr, rc, "cannot open hdf5-arrayfile '$(name)'",
                             "name=%s", name ) );
-        free_array_file( af );
+        release_array_file( af );
         return rc;
     }
     /* detect the dimensionality of the array-file */
@@ -224,7 +440,7 @@ rc_t open_array_file( const KDirectory *dir,
     {
         PLOGERR( klogErr, ( klogErr, rc, "cannot retrieve dimensionality on '$(name)'",
                             "name=%s", name ) );
-        free_array_file( af );
+        release_array_file( af );
         return rc;
     }
     /* make a array to hold the extent in every dimension */
@@ -234,7 +450,7 @@ rc_t open_array_file( const KDirectory *dir,
         rc = RC ( rcApp, rcArgv, rcAccessing, rcMemory, rcExhausted );
         PLOGERR( klogErr, ( klogErr, rc, "cannot allocate enough memory for extents of '$(name)'",
                             "name=%s", name ) );
-        free_array_file( af );
+        release_array_file( af );
         return rc;
     }
     /* read the actuall extents into the created array */
@@ -243,7 +459,7 @@ rc_t open_array_file( const KDirectory *dir,
     {
         PLOGERR( klogErr, ( klogErr, rc, "cannot retrieve extents of '$(name)'",
                             "name=%s", name ) );
-        free_array_file( af );
+        release_array_file( af );
         return rc;
     }
     /* request the size of the element in bits */
@@ -252,7 +468,7 @@ rc_t open_array_file( const KDirectory *dir,
     {
         PLOGERR( klogErr, ( klogErr, rc, "cannot retrieve element-size of '$(name)'",
                             "name=%s", name ) );
-        free_array_file( af );
+        release_array_file( af );
         return rc;
     }
     /* compare the discovered bit-size with the expected one */
@@ -267,7 +483,7 @@ rc_t open_array_file( const KDirectory *dir,
             PLOGERR( klogErr, ( klogErr, rc, "unexpected element-bits of $(bsize) in '$(name)'",
                      "bsize=%lu,name=%s", af->element_bits, name ) );
 
-        free_array_file( af );
+        release_array_file( af );
         return rc;
     }
 
@@ -280,7 +496,7 @@ rc_t open_array_file( const KDirectory *dir,
             rc = RC ( rcExe, rcNoTarg, rcLoading, rcData, rcInconsistent );
             PLOGERR( klogErr, ( klogErr, rc, "unexpected dimensionality of $(dim) in '$(name)'",
                                 "dim=%lu,name=%s", af->dimensionality, name ) );
-            free_array_file( af );
+            release_array_file( af );
             return rc;
         }
     }
@@ -292,7 +508,7 @@ rc_t open_array_file( const KDirectory *dir,
             rc = RC ( rcExe, rcNoTarg, rcLoading, rcData, rcInconsistent );
             PLOGERR( klogErr, ( klogErr, rc, "unexpected dimensionality of $(dim) in '$(name)'",
                                 "dim=%lu,name=%s", af->dimensionality, name ) );
-            free_array_file( af );
+            release_array_file( af );
             return rc;
         }
         else
@@ -302,19 +518,48 @@ rc_t open_array_file( const KDirectory *dir,
                 rc = RC ( rcExe, rcNoTarg, rcLoading, rcData, rcInconsistent );
                 PLOGERR( klogErr, ( klogErr, rc, "unexpected extent[1] of $(ext) in '$(name)'",
                                     "ext=%lu,name=%s", af->extents[ 1 ], name ) );
-                free_array_file( af );
+                release_array_file( af );
                 return rc;
             }
         }
     }
     if ( rc == 0 && cache_content )
     {
-        rc = read_cache_content( af );
+        /* instead of reading the whole content into memory, we read it
+           through a bounded window, the next window is prefetched */
+        af->row_bytes = ( af->element_bits >> 3 );
+        if ( af->dimensionality == 2 )
+            af->row_bytes *= af->extents[ 1 ];
+        if ( af->row_bytes > 0 )
+        {
+            af->window_rows = AF_WINDOW_BYTES / af->row_bytes;
+            if ( af->window_rows == 0 )
+                af->window_rows = 1;
+            af->windowed = true;
+        }
     }
     return rc;
 }
 
 
+rc_t open_array_file( const KDirectory *dir,
+                      const char *name,
+                      af_data * af,
+                      const uint64_t expected_element_bits,
+                      const uint64_t expected_cols,
+                      bool disp_wrong_bitsize,
+                      bool cache_content,
+                      bool supress_err_msg )
+{
+    rc_t rc;
+    pl_lock( hdf5_lock );
+    rc = open_array_file_locked( dir, name, af, expected_element_bits, expected_cols,
+                                 disp_wrong_bitsize, cache_content, supress_err_msg );
+    pl_unlock( hdf5_lock );
+    return rc;
+}
+
+
 /* assembles the 'absolute' path to the requested array-file before opening it */
 rc_t open_element( const KDirectory *hdf5_dir, 
                    af_data *element, 
@@ -348,65 +593,41 @@ rc_t array_file_read_dim1( af_data * af, const uint64_t pos,
                            void *dst, const uint64_t count,
                            uint64_t *n_read )
 {
-    rc_t rc = 0;
-    if ( af->content == NULL )
-        rc = KArrayFileRead ( af->af, 1, &pos, dst, &count, n_read );
+    rc_t rc;
+    if ( af->windowed )
+        rc = read_from_window( af, pos, dst, count, n_read );
     else
-    {
-        if ( ( pos + count ) > af->extents[ 0 ] )
-            rc = RC ( rcExe, rcNoTarg, rcLoading, rcData, rcInconsistent );
-        else
-        {
-            uint64_t buf_idx = ( af->element_bits >> 3 ) * pos;
-            size_t num = ( af->element_bits >> 3 ) * count;
-            char * src = af->content;
-            src+=buf_idx;
-            memmove( dst, src, num );
-            *n_read = count;
-        }
-    }
+        rc = read_rows( af, pos, dst, count, 0, n_read );
     if ( rc != 0 )
         LOGERR( klogErr, rc, "error reading arrayfile-data (1 dim)" );
     return rc;
 }
 
 
-/* we are reading values in 2 dimensions from the array-file */
+/* we are reading values in 2 dimensions from the array-file,
+   n_read is the number of rows read */
 rc_t array_file_read_dim2( af_data * af, const uint64_t pos,
                            void *dst, const uint64_t count,
                            const uint64_t ext2, uint64_t *n_read )
 {
-    rc_t rc = 0;
-    if ( af->content == NULL )
-    {
-        uint64_t pos2[ 2 ];
-        uint64_t read2[ 2 ];
-        uint64_t count2[ 2 ];
-        rc_t rc;
-
-        pos2[ 0 ] = pos;
-        pos2[ 1 ] = 0;
-        count2[ 0 ] = count;
-        count2[ 1 ] = ext2;
-        rc = KArrayFileRead ( af->af, 2, pos2, dst, count2, read2 );
-        if ( rc != 0 )
-            LOGERR( klogErr, rc, "error reading arrayfile-data (2 dim)" );
-        *n_read = read2[ 0 ];
-    }
+    rc_t rc;
+    if ( af->windowed && ext2 == af->extents[ 1 ] )
+        rc = read_from_window( af, pos, dst, count, n_read );
     else
-    {
-        if ( ( pos + count ) > af->extents[ 0 ] )
-            rc = RC ( rcExe, rcNoTarg, rcLoading, rcData, rcInconsistent );
-        else
-        {
-            uint64_t buf_idx = ( af->element_bits >> 3 ) * pos * af->extents[ 1 ];
-            size_t num = ( af->element_bits >> 3 ) * count * af->extents[ 1 ];
-            char * src = af->content;
-            src+=buf_idx;
-            memmove( dst, src, num );
-            *n_read = count * af->extents[ 1 ];
-        }
-    }
+        rc = read_rows( af, pos, dst, count, ext2, n_read );
+    if ( rc != 0 )
+        LOGERR( klogErr, rc, "error reading arrayfile-data (2 dim)" );
+    return rc;
+}
+
+
+rc_t array_file_get_meta( af_data * af, const char * key,
+                          const KNamelist ** names )
+{
+    rc_t rc;
+    pl_lock( hdf5_lock );
+    rc = KArrayFileGetMeta ( af->af, key, names );
+    pl_unlock( hdf5_lock );
     return rc;
 }
 
@@ -573,6 +794,7 @@ rc_t load_table( VDatabase * database, KDirectory * hdf5_src, ld_context *lctx,
 rc_t progress_chunk( const KLoadProgressbar ** xml_progress, const uint64_t chunk )
 {
     rc_t rc;
+    pl_lock( progress_lock );
     /* release the old progressbar... */
     if ( *xml_progress != NULL )
     {
@@ -584,17 +806,21 @@ rc_t progress_chunk( const KLoadProgressbar ** xml_progress, const uint64_t chun
         rc = KLoadProgressbar_Append( *xml_progress, chunk );
     else
         LOGERR( klogErr, rc, "cannot make KLoadProgressbar" );
-
+    pl_unlock( progress_lock );
     return rc;
 }
 
 
 rc_t progress_step( const KLoadProgressbar * xml_progress )
 {
+    rc_t rc = 0;
     if ( xml_progress != NULL )
-       return KLoadProgressbar_Process( xml_progress, 1, false );
-    else
-        return 0;
+    {
+        pl_lock( progress_lock );
+        rc = KLoadProgressbar_Process( xml_progress, 1, false );
+        pl_unlock( progress_lock );
+    }
+    return rc;
 }
 
 
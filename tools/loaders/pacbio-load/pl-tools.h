@@ -35,6 +35,7 @@ extern "C" {
 #include <klib/rc.h>
 #include <klib/text.h>
 #include <klib/log.h>
+#include <klib/namelist.h>
 #include <vdb/manager.h>
 #include <vdb/schema.h>
 #include <vdb/database.h>
@@ -42,6 +43,7 @@ extern "C" {
 #include <vdb/cursor.h>
 #include <kfs/file.h>
 #include <kfs/arrayfile.h>
+#include <kproc/thread.h>
 #include <hdf5/kdf5.h>
 #include <kapp/log-xml.h>
 #include <loader/progressbar.h>
@@ -173,6 +175,10 @@ extern "C" {
 #define PASS_START_BASE_BITSIZE 32
 #define PASS_START_BASE_COLS 1
 
+/* upper bound of bytes held per window of a cached array-file,
+   every cached array-file holds 2 of them ( current + prefetched ) */
+#define AF_WINDOW_BYTES ( 4 * 1024 * 1024 )
+
 typedef struct ld_context
 {
     const XMLLogger* xml_logger;
@@ -196,6 +202,15 @@ rc_t check_src_objects( const KDirectory *hdf5_dir,
                         const char **tables,
                         bool show_not_found );
 
+typedef struct af_window
+{
+    char * data;                /* the rows of the window */
+    size_t allocated;           /* how many bytes are allocated in data */
+    uint64_t start;             /* the first row in the window */
+    uint64_t count;             /* how many rows are in the window */
+} af_window;
+
+
 typedef struct af_data
 {
     struct KFile const *f;      /* the fake "file" from a HDF5-dir */
@@ -204,7 +219,15 @@ typedef struct af_data
     uint8_t dimensionality;     /* how many dimensions the HDF5-dataset has */
     uint64_t * extents;         /* the extension in every dimension */
     uint64_t element_bits;      /* how big in bits is the element */
-    void * content;             /* read the whole thing into memory */
+
+    /* sliding window over the content ( if cache_content was requested ) */
+    bool windowed;
+    uint64_t row_bytes;         /* bytes per row ( element * extents[ 1 ] ) */
+    uint64_t window_rows;       /* how many rows fit into AF_WINDOW_BYTES */
+    af_window window[ 2 ];      /* the current and the prefetched window */
+    uint32_t current;           /* index of the current window */
+    uint64_t prefetch_start;    /* where the prefetch-thread starts reading */
+    KThread * prefetch;         /* fills window[ 1 - current ] in the background */
 } af_data;
 
 
@@ -238,6 +261,9 @@ rc_t array_file_read_dim2( af_data * af, const uint64_t pos,
                            void *dst, const uint64_t count,
                            const uint64_t ext2, uint64_t *n_read );
 
+rc_t array_file_get_meta( af_data * af, const char * key,
+                          const KNamelist ** names );
+
 rc_t add_columns( VCursor * cursor, uint32_t count, int32_t exclude_this,
                   uint32_t * idx_vector, const char ** names );
 
@@ -276,6 +302,17 @@ rc_t load_table( VDatabase * database, KDirectory * hdf5_src, ld_context *lctx,
                  const char * template_name, const char * table_name,
                  loader_func func );
 
+/* the hdf5-library and the progressbar are not thread-safe,
+   all access to them is serialized by these locks */
+rc_t pl_locks_make( void );
+void pl_locks_release( void );
+
+/* the tables of one source are loaded concurrently, if one of them fails
+   the others are cancelled: pl_quitting() is Quitting() plus that */
+void pl_cancel_tables( bool cancel );
+bool pl_tables_cancelled( void );
+rc_t pl_quitting( void );
+
 rc_t progress_chunk( const KLoadProgressbar ** xml_progress, const uint64_t chunk );
 rc_t progress_step( const KLoadProgressbar * xml_progress );
 
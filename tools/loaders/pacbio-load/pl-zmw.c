@@ -187,7 +187,7 @@ rc_t zmw_for_each( zmw_tab *tab, const KLoadProgressbar ** xml_progress, VCursor
             uint32_t i;
             for ( i = 0; i < block.n_read && rc == 0; ++i )
             {
-                rc = Quitting();
+                rc = pl_quitting();
                 if ( rc == 0 )
                 {
                     zmw_block_row( &block, &row, i );
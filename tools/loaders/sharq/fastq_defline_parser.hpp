@@ -14,6 +14,8 @@
 #include "fastq_error.hpp"
 #include <spdlog/spdlog.h>
 #include <set>
+#include <memory>
+#include <algorithm>
 
 using namespace std;
 class CDefLineParser
@@ -96,10 +98,27 @@ public:
     const set<string>& AllDeflineTypes() const { return mDeflineTypes;}
     const deflinematchers_t& GetDeflineMatchers() const { return mDefLineMatchers; }
 private:
+    /**
+     * @brief Compile patterns of all registered matchers into a single classifier
+     *
+     */
+    void xBuildClassifier();
+
+    /**
+     * @brief Find the first registered matcher that recognizes defline
+     *
+     * @param[in] defline defline string_view to classify
+     * @return size_t matcher index or mDefLineMatchers.size() if nothing matches
+     */
+    size_t xClassify(const string_view& defline);
+
     deflinematchers_t mDefLineMatchers; ///< Vector of all registered Defline matchers
     size_t mIndexLastSuccessfulMatch = 0; ///< Index of the last sucessfull matcher
     size_t mAllMatchIndex = -1;           ///< Index of Match everything matcher
     std::set<string> mDeflineTypes;       ///< Set of deflines types processed by this reader
+    unique_ptr<CRegExprSet> mClassifier;  ///< Patterns of all matchers compiled into one automaton
+    vector<size_t> mClassifierIndex;      ///< Classifier pattern index to matcher index
+    vector<int> mClassifierMatches;       ///< Classifier output, reused between calls
 };
 
 
@@ -139,6 +158,7 @@ CDefLineParser::CDefLineParser()
     mDefLineMatchers.emplace_back(new CDefLineMatcherNanopore3_1);
     mDefLineMatchers.emplace_back(new CDefLineMatcherNanopore5); // before Nanopore4, to match fastq-load.py
     mDefLineMatchers.emplace_back(new CDefLineMatcherNanopore4);
+    xBuildClassifier();
 }
 
 CDefLineParser::~CDefLineParser()
@@ -150,6 +170,44 @@ void CDefLineParser::SetMatchAll()
 {
     mDefLineMatchers.emplace_back(new CDefLineMatcher_AllMatch);
     mAllMatchIndex = mDefLineMatchers.size() - 1;
+    xBuildClassifier();
+}
+
+
+void CDefLineParser::xBuildClassifier()
+{
+    // RE2::Set cannot be extended after compilation, rebuild it from scratch
+    mClassifier.reset(new CRegExprSet);
+    mClassifierIndex.clear();
+    for (size_t i = 0; i < mDefLineMatchers.size(); ++i) {
+        // NoMatch overrides Matches() and never matches
+        if (i == 0)
+            continue;
+        mClassifier->Add(mDefLineMatchers[i]->GetPattern());
+        mClassifierIndex.push_back(i);
+    }
+    mClassifier->Compile();
+}
+
+
+size_t CDefLineParser::xClassify(const string_view& defline)
+{
+    const size_t count = mDefLineMatchers.size();
+    if (mClassifier->Match(defline, mClassifierMatches)) {
+        // the set reports every matching pattern, the first registered matcher wins
+        size_t index = count;
+        for (auto i : mClassifierMatches)
+            index = min(index, mClassifierIndex[i]);
+        // the set does not capture groups, run the winner alone to get them
+        if (index == count || mDefLineMatchers[index]->Matches(defline))
+            return index;
+    }
+    // RE2 ran out of memory, probe the matchers one by one
+    for (size_t i = 0; i < count; ++i) {
+        if (i != mIndexLastSuccessfulMatch && mDefLineMatchers[i]->Matches(defline))
+            return i;
+    }
+    return count;
 }
 
 
@@ -163,21 +221,15 @@ bool CDefLineParser::Match(const string_view& defline, bool strict)
     if (mDefLineMatchers[mIndexLastSuccessfulMatch]->Matches(defline)) {
         return true;
     }
-    for (size_t i = 0; i < mDefLineMatchers.size(); ++i) {
-        if (i == mIndexLastSuccessfulMatch) {
-            continue;
-        }
-        if (!mDefLineMatchers[i]->Matches(defline)) {
-            continue;
-        }
-        if (strict && i == mAllMatchIndex)
-            return false;
-        mIndexLastSuccessfulMatch = i;
-        mDeflineTypes.insert(mDefLineMatchers[mIndexLastSuccessfulMatch]->Defline());
-        //spdlog::info("Current pattern: {}", mDefLineMatchers[mIndexLastSuccessfulMatch]->Defline());
-        return true;
-    }
-    return false;
+    size_t i = xClassify(defline);
+    if (i == mDefLineMatchers.size())
+        return false;
+    if (strict && i == mAllMatchIndex)
+        return false;
+    mIndexLastSuccessfulMatch = i;
+    mDeflineTypes.insert(mDefLineMatchers[mIndexLastSuccessfulMatch]->Defline());
+    //spdlog::info("Current pattern: {}", mDefLineMatchers[mIndexLastSuccessfulMatch]->Defline());
+    return true;
 }
 
 bool CDefLineParser::MatchLast(const string_view& defline)
@@ -61,6 +61,7 @@ SHARQ_ERR_CODES = {
     {230 ,{ "Internal QC failure", "Internal QC failure."}},
     {240 ,{ "Invalid platfrom code", "Invalid platfrom code."}},
     {250 ,{ "SRAE-70: Estimated number of spots exceeds the limit for this mode. Re-run with --spot-assembly parameter", "SRAE-70: Estimated number of spots excceds the limit for this mode. Re-run with --spot-assembly parameter."}},
+    {260 ,{ "VDB failure: {}", "Failure to write VDB database."}},
 
 };
 
@@ -44,6 +44,7 @@
 #include "fastq_error.hpp"
 #include "fastq_parser.hpp"
 #include "fastq_writer.hpp"
+#include "fastq_writer_direct.hpp"
 
 #include <json.hpp>
 #include <algorithm>
@@ -128,6 +129,8 @@ private:
     string mSpotFile;                   ///< Spot_name file, optional request to serialize  all spot names
     string mNameColumn;                 ///< NAME column's name, ('NONE', 'NAME', 'RAW_NAME')
     string mOutputFile;                 ///< Outut file name - not currently used
+    bool mDirect{false};                ///< Write VDB database in-process instead of general-writer stream
+    string mIncludePaths;               ///< Schema include paths for the in-process writer
     json mExperimentSpecs;              ///< Json from Experiment file
     ostream* mpOutStr{nullptr};         ///< Output stream pointer  = not currently used
     shared_ptr<fastq_writer> m_writer;  ///< FASTQ writer
@@ -135,6 +138,9 @@ private:
     uint32_t mMaxErrCount{100};         ///< Maximum numbers of errors allowed when parsing reads
     atomic<uint32_t> mErrorCount{0};            ///< Global error counter
     size_t mHotReadsThreshold{10000000};      ///< Threshold for hot reads
+    size_t mMaxMemory{0};               ///< Spot assembly memory limit in MB, 0 - no limit
+    unsigned int mInflateThreads{0};    ///< Number of gzip/bzip2 decompression threads, 0 - decompress on the reading thread
+    string mTempDir;                    ///< Directory for spot assembly temporary files
     uint8_t m_platform_code{0};         ///< Platform code set from the parameters
     set<int> mErrorSet = { 100, 110, 111, 120, 130, 140, 160, 190}; ///< Error codes that will be allowed up to mMaxErrCount
     size_t mMaxSpotsInLinearMode = 1200000000; ///< Max spot number for linear (non-spot assembly) mode
@@ -191,6 +197,8 @@ int CFastqParseApp::AppMain(int argc, const char* argv[])
 
 
         app.add_option("--output", mDestination, "Output archive path");
+        app.add_flag("--direct", mDirect, "Write output archive in-process instead of general-loader stream");
+        app.add_option("--include", mIncludePaths, "Schema include paths for --direct, separated by ':'");
 
         string platform;
         app.add_option("--platform", platform, "Optional platform");
@@ -254,6 +262,10 @@ int CFastqParseApp::AppMain(int argc, const char* argv[])
             ->check(CLI::IsMember({"trace", "debug", "info", "warning", "error"}));
 
         app.add_option("--hot-reads-threshold", mHotReadsThreshold, "Hot reads threshold");
+        app.add_option("--max-memory", mMaxMemory, "Spot assembly memory limit in MB, cold data past the limit is moved to --temp-dir");
+        app.add_option("--temp-dir", mTempDir, "Directory for spot assembly temporary files (default: $TMPDIR or /tmp)");
+        app.add_option("--inflate-threads", mInflateThreads, "Decompress gzip/bzip2 input on this many threads, shared by the files read together (default: 0, off)")
+            ->check(CLI::Range(0, 256));
 
         string experiment_file;
         app.add_option("--experiment", experiment_file, "Read structure description");
@@ -616,7 +628,11 @@ void CFastqParseApp::xCreateWriterFromDigest(json& data)
         m_writer = make_shared<fastq_writer_debug>();
     } else {
         if (platform_code == SRA_PLATFORM_454 && s_has_split_read_spec(mExperimentSpecs) && xIsSingleFileInput()) {
+            if (mDirect)
+                spdlog::warn("--direct is not supported for split read specs, writing general-loader stream");
             m_writer = make_shared<fastq_writer_exp>(mExperimentSpecs, *mpOutStr);
+        } else if (mDirect) {
+            m_writer = make_shared<fastq_writer_vdb_direct>();
         } else {
             m_writer = make_shared<fastq_writer_vdb>(*mpOutStr);
         }
@@ -624,6 +640,7 @@ void CFastqParseApp::xCreateWriterFromDigest(json& data)
 
     m_writer->set_attr("name_column", mNameColumn);
     m_writer->set_attr("destination", mDestination);
+    m_writer->set_attr("include_paths", mIncludePaths);
     m_writer->set_attr("version", SHARQ_VERSION);
     m_writer->set_attr("readTypes", string(mReadTypes.begin(), mReadTypes.end()));
 
@@ -665,6 +682,7 @@ int CFastqParseApp::xRun()
         if (!mDebug)
             parser.set_spot_file(mSpotFile);
         parser.set_allow_early_end(mAllowEarlyFileEnd);
+        parser.set_inflate_threads(mInflateThreads);
         m_writer->open();
         auto err_checker = [this](fastq_error& e) -> void { CFastqParseApp::xCheckErrorLimits(e);};
         for (auto& group : data["groups"]) {
@@ -715,45 +733,58 @@ void CFastqParseApp::xParseWithAssembly(json& group, parser_t& parser)
     bool is_nanopore = platform == SRA_PLATFORM_OXFORD_NANOPORE;
     mErrorCount = 0;
     parser.set_readers(group, false);
-    spdlog::stopwatch sw;
-    str_sv_type read_names;
-    parser.template first_pass<ScoreValidator>(read_names, err_checker);
-    if (mNoTimeStamp == false)
-        mReport["timing"]["first_pass"] =  ceil(sw.elapsed().count() * 100.0) / 100.0;
-    sw.reset();        
+    auto assemble = [&](auto& read_names) {
+        spdlog::stopwatch sw;
+        parser.template first_pass<ScoreValidator>(read_names, err_checker);
+        if (mNoTimeStamp == false)
+            mReport["timing"]["first_pass"] =  ceil(sw.elapsed().count() * 100.0) / 100.0;
+        sw.reset();        
 
-    //Reset readers
-    mErrorCount = 0;
-    parser.set_readers(group);
+        //Reset readers
+        mErrorCount = 0;
+        parser.set_readers(group);
 
-    size_t num_rows = read_names.size();
-    if (num_rows > numeric_limits<uint32_t>::max()) {
-        spdlog::info("Using 64-bit spot ids");
-        vector<uint64_t> read_index(num_rows);
-        parser.assign_spot_id(read_names, read_index);
-        read_names.clear();
+        size_t num_rows = read_names.size();
+        if (num_rows > numeric_limits<uint32_t>::max()) {
+            spdlog::info("Using 64-bit spot ids");
+            vector<uint64_t> read_index(num_rows);
+            parser.assign_spot_id(read_names, read_index);
+            read_names.clear();
 
 
-        if (is_nanopore)
-            parser.template second_pass<ScoreValidator, true>(err_checker, read_index);
-        else
-            parser.template second_pass<ScoreValidator, false>(err_checker, read_index);
+            if (is_nanopore)
+                parser.template second_pass<ScoreValidator, true>(err_checker, read_index);
+            else
+                parser.template second_pass<ScoreValidator, false>(err_checker, read_index);
 
-    } else {
-        spdlog::info("Using 32-bit spot ids");
-        vector<uint32_t> read_index(num_rows);
-        parser.assign_spot_id(read_names, read_index);
-        read_names.clear();
+        } else {
+            spdlog::info("Using 32-bit spot ids");
+            vector<uint32_t> read_index(num_rows);
+            parser.assign_spot_id(read_names, read_index);
+            read_names.clear();
+
+            if (is_nanopore)
+                parser.template second_pass<ScoreValidator, true>(err_checker, read_index);
+            else
+                parser.template second_pass<ScoreValidator, false>(err_checker, read_index);
+        }
 
-        if (is_nanopore)
-            parser.template second_pass<ScoreValidator, true>(err_checker, read_index);
-        else
-            parser.template second_pass<ScoreValidator, false>(err_checker, read_index);
+        if (mNoTimeStamp == false)
+            mReport["timing"]["second_pass"] =  ceil(sw.elapsed().count() * 100.0) / 100.0;
+    };
+
+    size_t estimated_reads = group["estimated_spots"].get<size_t>() * group["files"].size();
+    if (parser.needs_external_sort(estimated_reads)) {
+        spdlog::info("Using external sort for {:L} estimated reads", estimated_reads);
+        mReport["is_external_sort"] = 1;
+        name_hash_sorter_t read_names;
+        parser.init_name_sorter(read_names);
+        assemble(read_names);
+    } else {
+        str_sv_type read_names;
+        assemble(read_names);
     }
 
-    if (mNoTimeStamp == false)
-        mReport["timing"]["second_pass"] =  ceil(sw.elapsed().count() * 100.0) / 100.0;
-
     parser.template update_readers_telemetry<ScoreValidator>();
 
 }
@@ -775,7 +806,15 @@ int CFastqParseApp::xRunSpotAssembly()
         if (!mDebug)
             parser.set_spot_file(mSpotFile);
         parser.set_allow_early_end(mAllowEarlyFileEnd);
+        parser.set_inflate_threads(mInflateThreads);
         parser.set_hot_reads_threshold(mHotReadsThreshold);
+        if (mMaxMemory > 0) {
+            if (mTempDir.empty()) {
+                const char* tmp_dir = getenv("TMPDIR");
+                mTempDir = tmp_dir && *tmp_dir ? tmp_dir : "/tmp";
+            }
+            parser.set_memory_limit(mMaxMemory * 1024 * 1024, mTempDir);
+        }
 
         //auto err_checker = [this](fastq_error& e) { CFastqParseApp::xCheckErrorLimits(e);};
         for (auto& group : data["groups"]) {
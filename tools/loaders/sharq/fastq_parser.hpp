@@ -48,6 +48,7 @@
 #include "hashing.hpp"
 // input streams
 #include "bxzstr/bxzstr.hpp"
+#include "parallel_inflate.hpp"
 #include <bm/bm64.h>
 #include <bm/bmdbg.h>
 #include <bm/bmtimer.h>
@@ -387,6 +388,8 @@ public:
      *
      */
     bool is_compressed() const {
+        if (dynamic_cast<sharq::parallel_ifstream*>(&*m_stream))
+            return true;
         auto fstream = dynamic_cast<bxz::ifstream*>(&*m_stream);
         return fstream ? fstream->compression() != bxz::plaintext : false;
     }
@@ -397,6 +400,9 @@ public:
      * @return size_t
      */
     size_t tellg() const {
+        auto pstream = dynamic_cast<sharq::parallel_ifstream*>(&*m_stream);
+        if (pstream)
+            return pstream->compressed_tellg();
         auto fstream = dynamic_cast<bxz::ifstream*>(&*m_stream);
         return fstream ? fstream->compressed_tellg() : m_stream->tellg();
     }
@@ -463,9 +469,17 @@ private:
 };
 
 //  ----------------------------------------------------------------------------
+/**
+ * @brief Open input stream
+ *
+ * gzip and bzip2 files are decompressed on inflate_threads threads if inflate_threads > 0
+ *
+ */
 static
-shared_ptr<istream> s_OpenStream(const string& filename, size_t buffer_size)
+shared_ptr<istream> s_OpenStream(const string& filename, size_t buffer_size, size_t inflate_threads = 0)
 {
+    if (inflate_threads > 0 && filename != "-" && sharq::parallel_inflate_streambuf::detect(filename) != sharq::parallel_inflate_streambuf::eUnknown)
+        return make_shared<sharq::parallel_ifstream>(filename, inflate_threads, buffer_size);
     shared_ptr<istream> is = (filename != "-") ? shared_ptr<istream>(new bxz::ifstream(filename, ios::in, buffer_size)) : shared_ptr<istream>(new bxz::istream(std::cin));
     if (!is->good())
         throw runtime_error("Failure to open '" + filename + "'");
@@ -526,6 +540,15 @@ public:
      */
     void set_allow_early_end(bool allow_early_end = true) { m_allow_early_end = allow_early_end; }
 
+    /**
+     * @brief Set number of decompression threads
+     *
+     * The threads are split between gzip/bzip2 input files, 0 turns off parallel decompression
+     *
+     * @param[in]  threads
+     */
+    void set_inflate_threads(size_t threads) { m_inflate_threads = threads; }
+
     /**
      * @brief Set the spot_file name
      *
@@ -572,8 +595,15 @@ public:
     template<typename ScoreValidator, typename ErrorChecker>
     void first_pass(str_sv_type& read_names, ErrorChecker&& error_checker);
 
-    template<typename T>
-    void assign_spot_id(str_sv_type& read_names, vector<T>& read_index);    
+    /**
+     * @brief first step of spot-assembly mode with external sort 
+     * collect hashes of all read names, sorted runs are stored in the temp directory
+    */
+    template<typename ScoreValidator, typename ErrorChecker>
+    void first_pass(name_hash_sorter_t& read_names, ErrorChecker&& error_checker);
+
+    template<typename TNames, typename T>
+    void assign_spot_id(TNames& read_names, vector<T>& read_index);    
 
     /**
      * @brief second step of spot-assembly mode
@@ -681,6 +711,29 @@ public:
         m_spot_assembly.m_hot_reads_threshold = threshold; 
     }
 
+    /**
+     * @brief Set memory limit for spot assembly
+     * past the limit cold storage pages are spilled to temp_dir 
+     * @param memory_limit limit in bytes, 0 - no limit
+    */
+    void set_memory_limit(size_t memory_limit, const string& temp_dir) { 
+        m_spot_assembly.set_memory_limit(memory_limit, temp_dir); 
+    }
+
+    /**
+     * @brief Returns true if spot ids for estimated_reads should be assigned by external sort
+    */
+    bool needs_external_sort(size_t estimated_reads) const { 
+        return m_spot_assembly.needs_external_sort(estimated_reads); 
+    }
+
+    /**
+     * @brief Initialize external name sorter for first_pass
+    */
+    void init_name_sorter(name_hash_sorter_t& read_names) const { 
+        m_spot_assembly.init_name_sorter(read_names); 
+    }
+
 private:
 
     /**
@@ -744,6 +797,7 @@ private:
     bool                 m_IsIllumina10x{false};       ///< Parsing Illumina 10x data
     str_sv_type          m_spot_names;                 ///< Run-time collected spot name dictionary
     bool                 m_allow_early_end{false};     ///< Allow early file end flag
+    size_t               m_inflate_threads{0};         ///< Number of decompression threads
     string               m_spot_file;                  ///< Optional file name for spot_name dictionary
     bool                 m_sort_by_readnum{false};          ///< sort reads based on number of readers and existence of read numbers
     str_sv_type::back_insert_iterator m_spot_names_bi; ///< Internal back_inserter for spot_names collection
@@ -1882,13 +1936,15 @@ void fastq_parser<TWriter>::set_readers(json& group, bool update_telemetry)
         return;
     uint8_t files_with_read_numbers = 0;        
     vector<char> read_types;
+    const size_t num_files = group["files"].size();
+    size_t inflate_threads = m_inflate_threads > 0 && num_files > 0 ? max<size_t>(1, m_inflate_threads / num_files) : 0;
     for (auto& data : group["files"]) {
         const string& name = data["file_path"];
         if (data.contains("readType"))
             read_types = data["readType"];
         else
             read_types.clear();  
-        m_readers.emplace_back(name, s_OpenStream(name, (1024 * 1024) * 10), read_types, data["platform_code"].front());
+        m_readers.emplace_back(name, s_OpenStream(name, (1024 * 1024) * 10, inflate_threads), read_types, data["platform_code"].front());
         if (!data["readNums"].empty())
             ++files_with_read_numbers;
     }
@@ -2235,8 +2291,21 @@ void fastq_parser<TWriter>::first_pass(str_sv_type& read_names, ErrorChecker&& e
 }
 
 template<typename TWriter>
-template<typename T>
-void fastq_parser<TWriter>::assign_spot_id(str_sv_type& read_names, vector<T>& read_index)
+template<typename ScoreValidator, typename ErrorChecker>
+void fastq_parser<TWriter>::first_pass(name_hash_sorter_t& read_names, ErrorChecker&& error_checker)
+{
+    spdlog::stopwatch sw;
+    spdlog::info("Parsing from {} files", m_readers.size());
+    for_each_read<ScoreValidator, ErrorChecker>(error_checker, [&](size_t row_id, CFastqRead& read) {
+        read_names.add(read.Spot());
+    });
+    read_names.flush();
+    spdlog::info("reading took: {}, {:L} reads", sw, read_names.size());
+}
+
+template<typename TWriter>
+template<typename TNames, typename T>
+void fastq_parser<TWriter>::assign_spot_id(TNames& read_names, vector<T>& read_index)
 {
     spdlog::stopwatch sw;
     m_spot_assembly.assign_spot_id(read_names, read_index);
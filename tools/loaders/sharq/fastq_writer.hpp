@@ -273,6 +273,49 @@ public:
 };
 
 
+/**
+ * @brief Get VDB schema file and database type for the platform
+ *
+ * @param[in] platform platform code
+ * @param[in] has_name_column true if the spot names go to the standard NAME column
+ * @param[out] schema schema file name
+ * @param[out] db database type
+ */
+static
+void s_get_vdb_schema(uint8_t platform, bool has_name_column, string& schema, string& db)
+{
+    static const string cGENERIC_SCHEMA = "sra/generic-fastq.vschema";
+    static const string c454_SCHEMA = "sra/454.vschema";
+    static const string cION_TORRENT_SCHEMA = "sra/ion-torrent.vschema";
+
+    static const string cGENERIC_DB = "NCBI:SRA:GenericFastq:db";
+    static const string cILLUMINA_DB = "NCBI:SRA:Illumina:db";
+    static const string cNANOPORE_DB = "NCBI:SRA:GenericFastqNanopore:db";
+    static const string c454_DB = "NCBI:SRA:_454_:db";
+    static const string cION_TORRENT_DB = "NCBI:SRA:IonTorrent:db";
+    db = cGENERIC_DB;
+    schema = cGENERIC_SCHEMA;
+    switch (platform)
+    {
+    case SRA_PLATFORM_ILLUMINA:
+        // use Illumina DB for illumina with standard NAME column
+        if (has_name_column)
+            db = cILLUMINA_DB;
+        break;
+    case SRA_PLATFORM_OXFORD_NANOPORE:
+        db = cNANOPORE_DB;
+        break;
+    case SRA_PLATFORM_454: 
+        schema = c454_SCHEMA;
+        db = c454_DB;
+        break;
+    case SRA_PLATFORM_ION_TORRENT:
+        schema = cION_TORRENT_SCHEMA;
+        db = cION_TORRENT_DB;
+        break;
+    }
+}
+
 /**
  * @brief VDB Writer implementation
  *
@@ -390,36 +433,9 @@ void fastq_writer_vdb::open()
     get_attr("version", version);
     m_writer->info("sharq", version);
 
-    static const string cGENERIC_SCHEMA = "sra/generic-fastq.vschema";
-    static const string c454_SCHEMA = "sra/454.vschema";
-    static const string cION_TORRENT_SCHEMA = "sra/ion-torrent.vschema";
-
-    static const string cGENERIC_DB = "NCBI:SRA:GenericFastq:db";
-    static const string cILLUMINA_DB = "NCBI:SRA:Illumina:db";
-    static const string cNANOPORE_DB = "NCBI:SRA:GenericFastqNanopore:db";
-    static const string c454_DB = "NCBI:SRA:_454_:db";
-    static const string cION_TORRENT_DB = "NCBI:SRA:IonTorrent:db";
-    string db = cGENERIC_DB;
-    string schema = cGENERIC_SCHEMA;
-    switch (m_platform)
-    {
-    case SRA_PLATFORM_ILLUMINA:
-        // use Illumina DB for illumina with standard NAME column
-        if (has_name_column)
-            db = cILLUMINA_DB;
-        break;
-    case SRA_PLATFORM_OXFORD_NANOPORE:
-        db = cNANOPORE_DB;
-        break;
-    case SRA_PLATFORM_454: 
-        schema = c454_SCHEMA;
-        db = c454_DB;
-        break;
-    case SRA_PLATFORM_ION_TORRENT:
-        schema = cION_TORRENT_SCHEMA;
-        db = cION_TORRENT_DB;
-        break;
-    }
+    string db;
+    string schema;
+    s_get_vdb_schema(m_platform, has_name_column, schema, db);
     //m_writer->set_attr("schema", schema);
     //m_writer->set_attr("db", db);
 
@@ -0,0 +1,489 @@
+#ifndef __FASTQ_WRITER_DIRECT_HPP__
+#define __FASTQ_WRITER_DIRECT_HPP__
+
+/**
+ * @file fastq_writer_direct.hpp
+ * @brief In-process VDB Writer
+ *
+ */
+
+/*
+* ===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+* File Description: FASTQ Writer creating VDB database in-process
+*
+* ===========================================================================
+*/
+
+#include "fastq_writer.hpp"
+#include "fastq_utils.hpp"
+#include "version.h"
+
+#include <klib/rc.h>
+#include <klib/printf.h>
+#include <kdb/manager.h>
+#include <kdb/meta.h>
+#include <vdb/manager.h>
+#include <vdb/schema.h>
+#include <vdb/database.h>
+#include <vdb/table.h>
+#include <vdb/cursor.h>
+#include <loader/loader-meta.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief VDB Writer creating the database in-process
+ *
+ * Produces the same SEQUENCE table as fastq_writer_vdb + general-loader
+ * without encoding the spots into general-writer stream.
+ * Spots are accumulated column by column in batches, a separate commit thread
+ * replays the batches row by row into the VDB cursor.
+ * PLATFORM is the same for every spot and is set once as the column default.
+ *
+ */
+class fastq_writer_vdb_direct : public fastq_writer
+{
+public:
+    fastq_writer_vdb_direct() {};
+    ~fastq_writer_vdb_direct();
+
+    void open() override;
+    void close() override;
+    void write_spot(const string& spot_name, const vector<CFastqRead>& reads) override;
+
+private:
+    enum column_id_t {
+        eNAME,
+        eSPOT_GROUP,
+        ePLATFORM,
+        eREAD,
+        eQUALITY,
+        eREAD_START,
+        eREAD_LEN,
+        eREAD_TYPE,
+        eREAD_FILTER,
+        eCHANNEL,
+        eREAD_NUMBER,
+        eNUM_COLUMNS
+    };
+
+    struct column_t
+    /// SEQUENCE column opened in the cursor
+    {
+        uint32_t idx = 0;           ///< Cursor column index
+        uint32_t elem_size = 0;     ///< Element size in bytes
+        bool active = false;        ///< Column is written
+    };
+
+    struct batch_t
+    /// Column-major batch of rows
+    {
+        size_t rows = 0;                                ///< Number of rows
+        size_t bytes = 0;                               ///< Data size
+        vector<char> data[eNUM_COLUMNS];                ///< Concatenated cell data
+        vector<uint32_t> counts[eNUM_COLUMNS];          ///< Element count per row
+        void clear()
+        {
+            rows = bytes = 0;
+            for (auto& d : data) d.clear();
+            for (auto& c : counts) c.clear();
+        }
+    };
+
+    static constexpr size_t kBatchRows = 64 * 1024;             ///< Max rows per batch
+    static constexpr size_t kBatchBytes = 16 * 1024 * 1024;     ///< Max data per batch
+    static constexpr size_t kMaxQueuedBatches = 4;              ///< Max batches waiting for the commit thread
+
+    void x_check_rc(rc_t rc, const char* what) const;
+    ver_t x_loader_version();
+    void x_add_column(column_id_t id, const string& expr, uint32_t elem_size);
+
+    template<typename T>
+    void x_add_cell(column_id_t id, const T* data, size_t count)
+    {
+        if (!m_columns[id].active)
+            return;
+        auto& col = m_current->data[id];
+        auto sz = sizeof(T) * count;
+        col.insert(col.end(), reinterpret_cast<const char*>(data), reinterpret_cast<const char*>(data) + sz);
+        m_current->counts[id].push_back(count);
+        m_current->bytes += sz;
+    }
+
+    void x_flush();
+    void x_commit_thread();
+    rc_t x_write_batch(const batch_t& batch);
+    void x_release();
+
+    struct VDBManager* m_mgr{nullptr};          ///< VDB manager
+    struct VSchema* m_schema{nullptr};          ///< Schema
+    struct VDatabase* m_db{nullptr};            ///< Output database
+    struct VTable* m_table{nullptr};            ///< SEQUENCE table
+    struct VCursor* m_cursor{nullptr};          ///< SEQUENCE write cursor
+    column_t m_columns[eNUM_COLUMNS];           ///< SEQUENCE columns
+
+    uint8_t m_platform{0};
+    bool m_is_writing{false};                   ///< Flag to indicate if writing was initiated
+    string m_tmp_sequence;                      ///< temp string for sequences
+    string m_tmp_spot;                          ///< temp string for spots
+    vector<uint8_t> m_qual_scores;              ///< temp vector for scores
+
+    unique_ptr<batch_t> m_current;              ///< Batch being filled by write_spot
+    deque<unique_ptr<batch_t>> m_queue;         ///< Batches waiting for the commit thread
+    vector<unique_ptr<batch_t>> m_free;         ///< Written batches ready for reuse
+    mutex m_mutex;                              ///< Guards the queue, the free list and m_rc
+    condition_variable m_data_ready;            ///< Queue is not empty
+    condition_variable m_space_ready;           ///< Queue has space
+    thread m_commit_thread;                     ///< Thread writing batches into the cursor
+    bool m_stopping{false};                     ///< No more batches will be queued
+    rc_t m_rc{0};                               ///< First commit thread failure
+};
+
+//  -----------------------------------------------------------------------------
+fastq_writer_vdb_direct::~fastq_writer_vdb_direct()
+{
+    if (m_is_writing) {
+        try {
+            close();
+        } catch (exception& e) {
+            spdlog::error(e.what());
+        }
+    }
+    x_release();
+}
+
+//  -----------------------------------------------------------------------------
+void fastq_writer_vdb_direct::x_check_rc(rc_t rc, const char* what) const
+{
+    if (rc == 0)
+        return;
+    char buf[1024];
+    size_t num_writ = 0;
+    if (string_printf(buf, sizeof(buf), &num_writ, "%s: %R", what, rc) != 0)
+        num_writ = 0;
+    throw fastq_error(260, "VDB failure: {}", string(buf, num_writ));
+}
+
+//  -----------------------------------------------------------------------------
+ver_t fastq_writer_vdb_direct::x_loader_version()
+{
+    // "major[.minor[.release]]", the same as general-loader accepts from the stream
+    string version;
+    get_attr("version", version);
+    if (version.empty())
+        return TOOLKIT_VERS;
+    vector<string> parts;
+    sharq::split(version, parts, '.');
+    static const unsigned long max_part[] = { 255, 255, 0xffff };
+    static const unsigned shift[] = { 24, 16, 0 };
+    ver_t rslt = 0;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        const auto& part = parts[i];
+        if (i >= 3 || part.empty() || part.size() > 5 || part.find_first_not_of("0123456789") != string::npos)
+            throw fastq_error(260, "VDB failure: invalid loader version '{}'", version);
+        auto value = stoul(part);
+        if (value > max_part[i])
+            throw fastq_error(260, "VDB failure: invalid loader version '{}'", version);
+        rslt |= ver_t(value) << shift[i];
+    }
+    return rslt;
+}
+
+//  -----------------------------------------------------------------------------
+void fastq_writer_vdb_direct::x_add_column(column_id_t id, const string& expr, uint32_t elem_size)
+{
+    // same as Writer2: NONE means the column is not written
+    if (expr == "NONE")
+        return;
+    auto& col = m_columns[id];
+    x_check_rc(VCursorAddColumn(m_cursor, &col.idx, "%s", expr.c_str()), expr.c_str());
+    col.elem_size = elem_size;
+    col.active = true;
+}
+
+//  -----------------------------------------------------------------------------
+void fastq_writer_vdb_direct::open()
+{
+    string name_column_expression = "RAW_NAME";
+    get_attr("name_column", name_column_expression);
+    bool has_name_column{false};
+    if (name_column_expression == "NAME") {
+        has_name_column = true;
+        name_column_expression = "(ascii)NAME";
+    }
+
+    string quality_expression = "(INSDC:quality:text:phred_33)QUALITY";
+    get_attr("quality_expression", quality_expression);
+
+    string platform;
+    get_attr("platform", platform);
+    if (!platform.empty())
+        m_platform = stoi(platform);
+
+    string destination{"sra.out"};
+    get_attr("destination", destination);
+
+    string include_paths;
+    get_attr("include_paths", include_paths);
+
+    auto loader_version = x_loader_version();
+
+    string db;
+    string schema;
+    s_get_vdb_schema(m_platform, has_name_column, schema, db);
+
+    x_check_rc(VDBManagerMakeUpdate(&m_mgr, nullptr), "VDBManagerMakeUpdate");
+    if (!include_paths.empty()) {
+        vector<string> paths;
+        sharq::split(include_paths, paths, ':');
+        for (const auto& path : paths) {
+            rc_t rc = VDBManagerAddSchemaIncludePath(m_mgr, "%s", path.c_str());
+            if (rc != 0 && GetRCObject(rc) == (RCObject)rcPath)
+                spdlog::warn("Schema include path not found: '{}'", path);
+            else
+                x_check_rc(rc, path.c_str());
+        }
+    }
+    x_check_rc(VDBManagerMakeSchema(m_mgr, &m_schema), "VDBManagerMakeSchema");
+    x_check_rc(VSchemaParseFile(m_schema, "%s", schema.c_str()), schema.c_str());
+    x_check_rc(VDBManagerCreateDB(m_mgr, &m_db, m_schema, db.c_str(), kcmInit + kcmMD5, "%s", destination.c_str()), destination.c_str());
+
+    {   // loader metadata, the same as general-loader writes
+        KMetadata* meta = nullptr;
+        x_check_rc(VDatabaseOpenMetadataUpdate(m_db, &meta), "VDatabaseOpenMetadataUpdate");
+        KMDataNode* node = nullptr;
+        rc_t rc = KMetadataOpenNodeUpdate(meta, &node, "/");
+        if (rc == 0) {
+            rc = KLoaderMeta_WriteWithVersion(node, "sharq", __DATE__, TOOLKIT_VERS, "sharq", loader_version);
+            KMDataNodeRelease(node);
+        }
+        rc_t rc2 = KMetadataRelease(meta);
+        x_check_rc(rc != 0 ? rc : rc2, "Loader metadata");
+    }
+
+    x_check_rc(VDatabaseCreateTable(m_db, &m_table, "SEQUENCE", kcmCreate | kcmMD5, "SEQUENCE"), "SEQUENCE");
+    x_check_rc(VTableCreateCursorWrite(m_table, &m_cursor, kcmInsert), "VTableCreateCursorWrite");
+
+    x_add_column(eREAD, "READ", sizeof(char));
+    x_add_column(eREAD_START, "READ_START", sizeof(int32_t));
+    x_add_column(eREAD_LEN, "READ_LEN", sizeof(int32_t));
+    x_add_column(eREAD_TYPE, "READ_TYPE", sizeof(char));
+    x_add_column(eREAD_FILTER, "READ_FILTER", sizeof(char));
+    x_add_column(eQUALITY, quality_expression, sizeof(char));
+    x_add_column(eNAME, name_column_expression, sizeof(char));
+    x_add_column(eSPOT_GROUP, "SPOT_GROUP", sizeof(char));
+    x_add_column(ePLATFORM, "PLATFORM", sizeof(char));
+    if (m_platform == SRA_PLATFORM_OXFORD_NANOPORE) {
+        x_add_column(eCHANNEL, "CHANNEL", sizeof(uint32_t));
+        x_add_column(eREAD_NUMBER, "READ_NUMBER", sizeof(uint32_t));
+    }
+    x_check_rc(VCursorOpen(m_cursor), "VCursorOpen");
+    if (m_columns[ePLATFORM].active)
+        x_check_rc(VCursorDefault(m_cursor, m_columns[ePLATFORM].idx, 8, &m_platform, 0, 1), "PLATFORM");
+
+    m_current.reset(new batch_t);
+    m_stopping = false;
+    m_rc = 0;
+    m_commit_thread = thread(&fastq_writer_vdb_direct::x_commit_thread, this);
+    m_is_writing = true;
+}
+
+//  -----------------------------------------------------------------------------
+void fastq_writer_vdb_direct::close()
+{
+    if (!m_is_writing)
+        return;
+    m_is_writing = false;
+    write_messages();
+
+    x_flush();
+    {
+        unique_lock<mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_data_ready.notify_one();
+    m_commit_thread.join();
+    x_check_rc(m_rc, "Commit thread");
+
+    x_check_rc(VCursorCommit(m_cursor), "VCursorCommit");
+    rc_t rc = VCursorRelease(m_cursor);
+    m_cursor = nullptr;
+    x_check_rc(rc, "VCursorRelease");
+    x_check_rc(VTableReindex(m_table), "VTableReindex");
+    x_release();
+}
+
+//  -----------------------------------------------------------------------------
+void fastq_writer_vdb_direct::x_release()
+{
+    if (m_commit_thread.joinable()) {
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_data_ready.notify_one();
+        m_commit_thread.join();
+    }
+    VCursorRelease(m_cursor);
+    m_cursor = nullptr;
+    VTableRelease(m_table);
+    m_table = nullptr;
+    VDatabaseRelease(m_db);
+    m_db = nullptr;
+    VSchemaRelease(m_schema);
+    m_schema = nullptr;
+    VDBManagerRelease(m_mgr);
+    m_mgr = nullptr;
+}
+
+//  -----------------------------------------------------------------------------
+void fastq_writer_vdb_direct::write_spot(const string& spot_name, const vector<CFastqRead>& reads)
+{
+    if (reads.empty())
+        return;
+    assert(m_is_writing);
+    const auto& first_read = reads.front();
+    m_tmp_spot = spot_name;
+    m_tmp_spot += first_read.Suffix();
+    x_add_cell(eNAME, m_tmp_spot.data(), m_tmp_spot.size());
+    const auto& spot_group = first_read.SpotGroup();
+    x_add_cell(eSPOT_GROUP, spot_group.data(), spot_group.size());
+
+    auto read_num = reads.size();
+    int32_t read_start[read_num];
+    int32_t read_len[read_num];
+    char read_type[read_num];
+    char read_filter[read_num];
+    uint32_t channel[read_num];
+    uint32_t read_no[read_num];
+    m_tmp_sequence.clear();
+    m_qual_scores.clear();
+    size_t start = 0;
+    read_num = 0;
+    for (const auto& read : reads) {
+        m_tmp_sequence += read.Sequence();
+        read.GetQualScores(m_qual_scores);
+        read_start[read_num] = start;
+        auto sz = read.Sequence().size();
+        start += sz;
+        read_len[read_num] = sz;
+        read_type[read_num] = read.Type();
+        read_filter[read_num] = (char)read.ReadFilter();
+        if (m_platform == SRA_PLATFORM_OXFORD_NANOPORE) {
+            channel[read_num] = stoul(read.Channel());
+            read_no[read_num] = stoul(read.NanoporeReadNo());
+        }
+        ++read_num;
+    }
+    x_add_cell(eREAD, m_tmp_sequence.data(), m_tmp_sequence.size());
+    x_add_cell(eQUALITY, m_qual_scores.data(), m_qual_scores.size());
+    x_add_cell(eREAD_START, read_start, read_num);
+    x_add_cell(eREAD_LEN, read_len, read_num);
+    x_add_cell(eREAD_TYPE, read_type, read_num);
+    x_add_cell(eREAD_FILTER, read_filter, read_num);
+    if (m_platform == SRA_PLATFORM_OXFORD_NANOPORE) {
+        x_add_cell(eCHANNEL, channel, read_num);
+        x_add_cell(eREAD_NUMBER, read_no, read_num);
+    }
+    ++m_current->rows;
+    if (m_current->rows >= kBatchRows || m_current->bytes >= kBatchBytes)
+        x_flush();
+}
+
+//  -----------------------------------------------------------------------------
+void fastq_writer_vdb_direct::x_flush()
+{
+    unique_lock<mutex> lock(m_mutex);
+    if (m_current->rows > 0) {
+        m_space_ready.wait(lock, [this] { return m_queue.size() < kMaxQueuedBatches; });
+        m_queue.push_back(move(m_current));
+        m_data_ready.notify_one();
+        if (m_free.empty()) {
+            m_current.reset(new batch_t);
+        } else {
+            m_current = move(m_free.back());
+            m_free.pop_back();
+        }
+    }
+    // report commit thread failure as soon as possible
+    x_check_rc(m_rc, "Commit thread");
+}
+
+//  -----------------------------------------------------------------------------
+void fastq_writer_vdb_direct::x_commit_thread()
+{
+    unique_lock<mutex> lock(m_mutex);
+    while (true) {
+        m_data_ready.wait(lock, [this] { return !m_queue.empty() || m_stopping; });
+        if (m_queue.empty())
+            break;
+        auto batch = move(m_queue.front());
+        m_queue.pop_front();
+        bool failed = m_rc != 0;
+        lock.unlock();
+
+        // after a failure keep draining the queue so that the parser never blocks
+        rc_t rc = failed ? 0 : x_write_batch(*batch);
+        batch->clear();
+
+        lock.lock();
+        if (rc != 0 && m_rc == 0)
+            m_rc = rc;
+        m_free.push_back(move(batch));
+        m_space_ready.notify_one();
+    }
+}
+
+//  -----------------------------------------------------------------------------
+rc_t fastq_writer_vdb_direct::x_write_batch(const batch_t& batch)
+{
+    size_t offsets[eNUM_COLUMNS] = {0};
+    rc_t rc = 0;
+    for (size_t row = 0; rc == 0 && row < batch.rows; ++row) {
+        rc = VCursorOpenRow(m_cursor);
+        for (int i = 0; rc == 0 && i < eNUM_COLUMNS; ++i) {
+            // inactive and platform specific columns have no cells
+            if (batch.counts[i].empty())
+                continue;
+            static const char empty = 0;
+            const auto& col = m_columns[i];
+            auto count = batch.counts[i][row];
+            const void* data = count > 0 ? &batch.data[i][offsets[i]] : &empty;
+            rc = VCursorWrite(m_cursor, col.idx, col.elem_size * 8, data, 0, count);
+            offsets[i] += size_t(count) * col.elem_size;
+        }
+        if (rc == 0)
+            rc = VCursorCommitRow(m_cursor);
+        if (rc == 0)
+            rc = VCursorCloseRow(m_cursor);
+    }
+    return rc;
+}
+
+#endif
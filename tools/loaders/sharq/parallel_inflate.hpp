@@ -0,0 +1,673 @@
+#ifndef __PARALLEL_INFLATE_HPP__
+#define __PARALLEL_INFLATE_HPP__
+
+/**
+ * @file parallel_inflate.hpp
+ * @brief Multi-threaded decompression of gzip and bzip2 input
+ *
+ * BGZF blocks and bzip2 streams are independent of each other,
+ * so they are inflated on a pool of worker threads.
+ * Anything else (plain gzip, single stream bzip2) is inflated sequentially
+ * on a dedicated thread running ahead of the reader.
+ * The reader gets decompressed data from a bounded ring of buffers in the original order.
+ */
+
+#include <zlib.h>
+#include <bzlib.h>
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bxzstr/bxzstr.hpp"
+
+namespace sharq {
+
+class parallel_inflate_streambuf : public std::streambuf
+/// Input stream buffer decompressing gzip or bzip2 file on several threads
+{
+public:
+    enum format_t { eUnknown, eGzip, eBzip2 };
+
+    /**
+     * @brief Detect compression format by the file's magic bytes
+     *
+     * @param[in] file_name file to check
+     * @return format_t eUnknown for plain text, xz or unreadable files
+     */
+    static format_t detect(const std::string& file_name)
+    {
+        std::ifstream in(file_name, std::ios::binary);
+        unsigned char magic[4] = {0};
+        in.read(reinterpret_cast<char*>(magic), sizeof(magic));
+        if (in.gcount() < 3)
+            return eUnknown;
+        if (magic[0] == 0x1f && magic[1] == 0x8b && magic[2] == 8)
+            return eGzip;
+        if (magic[0] == 'B' && magic[1] == 'Z' && magic[2] == 'h' && in.gcount() == 4 && magic[3] >= '1' && magic[3] <= '9')
+            return eBzip2;
+        return eUnknown;
+    }
+
+    static constexpr size_t kJobSize = 4 * 1024 * 1024;         ///< Default compressed bytes per parallel job
+
+    /**
+     * @brief Construct a new parallel_inflate_streambuf object and start decompression
+     *
+     * @param[in] file_name gzip or bzip2 file
+     * @param[in] threads number of worker threads for independent blocks
+     * @param[in] buffer_size size of decompressed buffers in sequential mode
+     * @param[in] job_size compressed bytes per parallel job
+     *
+     * @throws runtime_error if file format is not supported
+     */
+    parallel_inflate_streambuf(const std::string& file_name, size_t threads, size_t buffer_size = 4 * 1024 * 1024, size_t job_size = kJobSize)
+        : m_file_name(file_name)
+        , m_format(detect(file_name))
+        , m_threads(std::max<size_t>(1, threads))
+        , m_buffer_size(std::max<size_t>(64 * 1024, buffer_size))
+        , m_job_size(std::max<size_t>(1, job_size))
+        , m_max_jobs(m_threads * 2 + 2)
+    {
+        if (m_format == eUnknown)
+            throw std::runtime_error("Failure to decompress '" + file_name + "': unsupported format");
+        setg(nullptr, nullptr, nullptr);
+        xStart(0, false);
+    }
+
+    ~parallel_inflate_streambuf() override
+    {
+        xStop();
+    }
+
+    parallel_inflate_streambuf(const parallel_inflate_streambuf&) = delete;
+    parallel_inflate_streambuf& operator=(const parallel_inflate_streambuf&) = delete;
+
+    /**
+     * @brief return compression type in bxzstr terms
+     *
+     */
+    bxz::Compression compression() const { return m_format == eGzip ? bxz::z : bxz::bz2; }
+
+    /**
+     * @brief return position in the compressed file of the data being read
+     *
+     */
+    size_t compressed_tellg() const { return m_compressed_pos; }
+
+protected:
+    int_type underflow() override
+    {
+        if (gptr() < egptr())
+            return traits_type::to_int_type(*gptr());
+
+        std::unique_lock<std::mutex> lk(m_mutex);
+        if (m_current) {
+            // done with the current buffer
+            m_ring.pop_front();
+            m_current.reset();
+            setg(nullptr, nullptr, nullptr);
+            m_space_cv.notify_one();
+        }
+        while (true) {
+            m_done_cv.wait(lk, [this] { return (!m_ring.empty() && m_ring.front()->done) || (m_ring.empty() && m_reader_done); });
+            if (m_ring.empty())
+                return traits_type::eof();
+            auto job = m_ring.front();
+            if (job->error)
+                std::rethrow_exception(job->error);
+            if (job->failed) {
+                // block boundaries were wrong or data is damaged:
+                // start over sequentially from this point, it will report errors if any
+                size_t pos = job->in_pos;
+                lk.unlock();
+                xStop();
+                xStart(pos, true);
+                lk.lock();
+                continue;
+            }
+            if (job->out.empty()) {
+                m_ring.pop_front();
+                m_space_cv.notify_one();
+                continue;
+            }
+            m_current = job;
+            m_compressed_pos = job->in_end;
+            setg(job->out.data(), job->out.data(), job->out.data() + job->out.size());
+            return traits_type::to_int_type(*gptr());
+        }
+    }
+
+private:
+    struct job_t
+    /// Piece of compressed input and its decompressed data
+    {
+        size_t in_pos = 0;          ///< Offset of the compressed data in the file
+        size_t in_end = 0;          ///< Offset past the compressed data
+        std::vector<char> in;       ///< Compressed data (parallel jobs only)
+        std::vector<char> out;      ///< Decompressed data
+        bool done = false;          ///< Decompressed data is ready
+        bool failed = false;        ///< Parallel job failed, input has to be decompressed sequentially from in_pos
+        std::exception_ptr error;   ///< Sequential decompression error
+    };
+    typedef std::shared_ptr<job_t> job_ptr;
+
+    static constexpr size_t kMaxJobSize = 64 * 1024 * 1024;     ///< Give up on bzip2 stream splitting after this many bytes without a stream start
+    static constexpr size_t kReadSize = 1024 * 1024;            ///< Compressed bytes per read
+    static constexpr size_t kBgzfHeaderSize = 18;               ///< gzip header with BC extra field
+
+    void xStart(size_t pos, bool sequential)
+    {
+        m_reader = std::thread(&parallel_inflate_streambuf::xReadThread, this, pos, sequential);
+        if (!sequential) {
+            for (size_t i = 0; i < m_threads; ++i)
+                m_workers.emplace_back(&parallel_inflate_streambuf::xWorkerThread, this);
+        }
+    }
+
+    void xStop()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_cancelled = true;
+        }
+        m_space_cv.notify_all();
+        m_work_cv.notify_all();
+        if (m_reader.joinable())
+            m_reader.join();
+        for (auto& t : m_workers)
+            t.join();
+        m_workers.clear();
+
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_ring.clear();
+        m_work.clear();
+        m_current.reset();
+        setg(nullptr, nullptr, nullptr);
+        m_cancelled = false;
+        m_reader_done = false;
+    }
+
+    /**
+     * @brief Put job into the ring, waits for free space
+     *
+     * @param[in] job
+     * @param[in] to_workers job has to be decompressed by workers, otherwise it's ready
+     * @return false if decompression was cancelled
+     */
+    bool xSubmit(job_ptr job, bool to_workers)
+    {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        m_space_cv.wait(lk, [this] { return m_cancelled || m_ring.size() < m_max_jobs; });
+        if (m_cancelled)
+            return false;
+        m_ring.push_back(job);
+        if (to_workers) {
+            m_work.push_back(job);
+            m_work_cv.notify_one();
+        } else {
+            job->done = true;
+            m_done_cv.notify_all();
+        }
+        return true;
+    }
+
+    void xReadThread(size_t pos, bool sequential)
+    {
+        try {
+            std::ifstream in(m_file_name, std::ios::binary);
+            if (!in)
+                throw std::runtime_error("Failure to open '" + m_file_name + "'");
+            in.seekg(pos);
+            if (sequential)
+                xInflateSequential(in, pos);
+            else if (m_format == eGzip)
+                xReadBgzf(in, pos);
+            else
+                xReadBzip2(in, pos);
+        } catch (...) {
+            auto job = std::make_shared<job_t>();
+            job->error = std::current_exception();
+            xSubmit(job, false);
+        }
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_reader_done = true;
+        }
+        m_done_cv.notify_all();
+        m_work_cv.notify_all();
+    }
+
+    void xWorkerThread()
+    {
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        bool zs_ready = m_format == eGzip && inflateInit2(&zs, 15 + 16) == Z_OK;
+        while (true) {
+            job_ptr job;
+            {
+                std::unique_lock<std::mutex> lk(m_mutex);
+                m_work_cv.wait(lk, [this] { return m_cancelled || !m_work.empty() || m_reader_done; });
+                if (m_cancelled || m_work.empty())
+                    break;
+                job = m_work.front();
+                m_work.pop_front();
+            }
+            bool ok = m_format == eGzip ? (zs_ready && s_inflate_bgzf(zs, *job)) : s_inflate_bzip2(*job);
+            std::vector<char>().swap(job->in);
+            {
+                std::lock_guard<std::mutex> lk(m_mutex);
+                job->failed = !ok;
+                job->done = true;
+            }
+            m_done_cv.notify_all();
+        }
+        if (zs_ready)
+            inflateEnd(&zs);
+    }
+
+    /**
+     * @brief Returns size of BGZF block or 0 if the header is not a BGZF one
+     *
+     */
+    static size_t s_bgzf_block_size(const unsigned char* h)
+    {
+        if (h[0] != 0x1f || h[1] != 0x8b || h[2] != 8 || (h[3] & 4) == 0)
+            return 0;
+        // XLEN 6, single BC subfield with 2 byte BSIZE
+        if (h[10] != 6 || h[11] != 0 || h[12] != 'B' || h[13] != 'C' || h[14] != 2 || h[15] != 0)
+            return 0;
+        return (size_t(h[16]) | (size_t(h[17]) << 8)) + 1;
+    }
+
+    /**
+     * @brief Batch BGZF blocks into jobs, switches to sequential mode at the first non-BGZF member
+     *
+     */
+    void xReadBgzf(std::ifstream& in, size_t pos)
+    {
+        job_ptr job;
+        unsigned char header[kBgzfHeaderSize];
+        while (true) {
+            in.read(reinterpret_cast<char*>(header), kBgzfHeaderSize);
+            size_t n = in.gcount();
+            if (n == 0)
+                break;
+            size_t bsize = n == kBgzfHeaderSize ? s_bgzf_block_size(header) : 0;
+            if (bsize > kBgzfHeaderSize) {
+                if (!job) {
+                    job = std::make_shared<job_t>();
+                    job->in_pos = pos;
+                }
+                size_t off = job->in.size();
+                job->in.resize(off + bsize);
+                memcpy(&job->in[off], header, kBgzfHeaderSize);
+                in.read(&job->in[off + kBgzfHeaderSize], bsize - kBgzfHeaderSize);
+                if (size_t(in.gcount()) == bsize - kBgzfHeaderSize) {
+                    pos += bsize;
+                    job->in_end = pos;
+                    if (job->in.size() >= m_job_size) {
+                        if (!xSubmit(job, true))
+                            return;
+                        job.reset();
+                    }
+                    continue;
+                }
+                job->in.resize(off);
+            }
+            // not a BGZF block (or a truncated one): the rest is inflated sequentially
+            if (job && !job->in.empty() && !xSubmit(job, true))
+                return;
+            in.clear();
+            in.seekg(pos);
+            xInflateSequential(in, pos);
+            return;
+        }
+        if (job && !job->in.empty())
+            xSubmit(job, true);
+    }
+
+    /**
+     * @brief Returns offset of the first bzip2 stream header at or after from, or npos
+     *
+     */
+    static size_t s_find_bzip2_stream(const std::vector<char>& data, size_t from)
+    {
+        // "BZh" + level + block magic 0x314159265359
+        static const char magic[] = "1AY&SY";
+        const size_t sz = data.size();
+        for (size_t i = from; i + 10 <= sz; ++i) {
+            const char* p = static_cast<const char*>(memchr(&data[i], 'B', sz - i - 9));
+            if (p == nullptr)
+                break;
+            i = p - data.data();
+            if (p[1] == 'Z' && p[2] == 'h' && p[3] >= '1' && p[3] <= '9' && memcmp(p + 4, magic, 6) == 0)
+                return i;
+        }
+        return std::string::npos;
+    }
+
+    /**
+     * @brief Split bzip2 input into jobs at stream boundaries
+     *
+     * Concatenated streams (pbzip2, multi-stream bzip2) are found by their header magic.
+     * A false positive makes one of the jobs fail, and the input is decompressed sequentially from there.
+     */
+    void xReadBzip2(std::ifstream& in, size_t pos)
+    {
+        std::vector<char> data;
+        size_t scan = m_job_size;
+        bool eof = false;
+        while (true) {
+            size_t cut = std::string::npos;
+            while (!eof) {
+                if (data.size() > scan) {
+                    cut = s_find_bzip2_stream(data, scan);
+                    if (cut != std::string::npos)
+                        break;
+                    scan = data.size() - std::min<size_t>(data.size(), 9);
+                    scan = std::max(scan, m_job_size);
+                }
+                if (data.size() >= kMaxJobSize) {
+                    // single stream file, nothing to split
+                    in.clear();
+                    in.seekg(pos);
+                    xInflateSequential(in, pos);
+                    return;
+                }
+                size_t sz = data.size();
+                data.resize(sz + kReadSize);
+                in.read(&data[sz], kReadSize);
+                data.resize(sz + in.gcount());
+                eof = in.gcount() == 0;
+            }
+            if (cut == std::string::npos && data.size() > scan)
+                cut = s_find_bzip2_stream(data, scan);
+
+            auto job = std::make_shared<job_t>();
+            job->in_pos = pos;
+            if (cut == std::string::npos) {
+                if (data.empty())
+                    return;
+                job->in.swap(data);
+                job->in_end = pos + job->in.size();
+                xSubmit(job, true);
+                return;
+            }
+            job->in.assign(data.begin(), data.begin() + cut);
+            job->in_end = pos + cut;
+            if (!xSubmit(job, true))
+                return;
+            data.erase(data.begin(), data.begin() + cut);
+            pos += cut;
+            scan = m_job_size;
+        }
+    }
+
+    static bool s_inflate_bgzf(z_stream& zs, job_t& job)
+    {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(job.in.data());
+        const unsigned char* end = p + job.in.size();
+        size_t total = 0;
+        // every block has its decompressed size in the trailer
+        for (const unsigned char* b = p; b < end; b += s_bgzf_block_size(b)) {
+            size_t bsize = s_bgzf_block_size(b);
+            const unsigned char* t = b + bsize - 4;
+            total += size_t(t[0]) | (size_t(t[1]) << 8) | (size_t(t[2]) << 16) | (size_t(t[3]) << 24);
+        }
+        job.out.resize(total);
+        size_t out_pos = 0;
+        while (p < end) {
+            size_t bsize = s_bgzf_block_size(p);
+            const unsigned char* t = p + bsize - 4;
+            size_t isize = size_t(t[0]) | (size_t(t[1]) << 8) | (size_t(t[2]) << 16) | (size_t(t[3]) << 24);
+            if (inflateReset(&zs) != Z_OK)
+                return false;
+            // an empty block (BGZF EOF marker) has no room to write to,
+            // zlib still wants a valid output pointer
+            Bytef empty;
+            zs.next_in = const_cast<Bytef*>(p);
+            zs.avail_in = bsize;
+            zs.next_out = isize > 0 ? reinterpret_cast<Bytef*>(job.out.data() + out_pos) : &empty;
+            zs.avail_out = isize > 0 ? isize : 1;
+            if (inflate(&zs, Z_FINISH) != Z_STREAM_END || zs.avail_out != (isize > 0 ? 0u : 1u) || zs.avail_in != 0)
+                return false;
+            out_pos += isize;
+            p += bsize;
+        }
+        return true;
+    }
+
+    static bool s_inflate_bzip2(job_t& job)
+    {
+        char* next = job.in.data();
+        size_t avail = job.in.size();
+        size_t used = 0;
+        job.out.resize(job.in.size() * 4 + kReadSize);
+        while (avail > 0) {
+            bz_stream bz;
+            memset(&bz, 0, sizeof(bz));
+            if (BZ2_bzDecompressInit(&bz, 0, 0) != BZ_OK)
+                return false;
+            bz.next_in = next;
+            bz.avail_in = avail;
+            int ret = BZ_OK;
+            while (ret == BZ_OK) {
+                if (used == job.out.size())
+                    job.out.resize(job.out.size() * 2);
+                bz.next_out = job.out.data() + used;
+                bz.avail_out = job.out.size() - used;
+                ret = BZ2_bzDecompress(&bz);
+                used = job.out.size() - bz.avail_out;
+                // input ended in the middle of the stream
+                if (ret == BZ_OK && bz.avail_in == 0 && bz.avail_out != 0)
+                    ret = BZ_UNEXPECTED_EOF;
+            }
+            next = bz.next_in;
+            avail = bz.avail_in;
+            BZ2_bzDecompressEnd(&bz);
+            if (ret != BZ_STREAM_END)
+                return false;
+        }
+        job.out.resize(used);
+        return true;
+    }
+
+    /**
+     * @brief Decompress the input from pos to the end on this thread
+     *
+     * @throws runtime_error on decompression errors
+     */
+    void xInflateSequential(std::ifstream& in, size_t pos)
+    {
+        if (m_format == eGzip)
+            xInflateSequentialGzip(in, pos);
+        else
+            xInflateSequentialBzip2(in, pos);
+    }
+
+    void xInflateSequentialGzip(std::ifstream& in, size_t pos)
+    {
+        std::vector<char> in_buf(kReadSize);
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        if (inflateInit2(&zs, 15 + 16) != Z_OK)
+            throw std::runtime_error("Failure to decompress '" + m_file_name + "': zlib init failed");
+        std::unique_ptr<z_stream, int(*)(z_stream*)> guard(&zs, inflateEnd);
+        auto job = std::make_shared<job_t>();
+        job->in_pos = pos;
+        job->out.resize(m_buffer_size);
+        size_t used = 0;
+        bool in_member = false;
+        while (true) {
+            if (zs.avail_in == 0) {
+                in.read(in_buf.data(), in_buf.size());
+                zs.next_in = reinterpret_cast<Bytef*>(in_buf.data());
+                zs.avail_in = in.gcount();
+                if (zs.avail_in == 0)
+                    break;
+            }
+            zs.next_out = reinterpret_cast<Bytef*>(job->out.data() + used);
+            zs.avail_out = job->out.size() - used;
+            in_member = true;
+            int ret = inflate(&zs, Z_NO_FLUSH);
+            used = job->out.size() - zs.avail_out;
+            if (ret == Z_STREAM_END) {
+                // next member, if any
+                in_member = false;
+                if (inflateReset(&zs) != Z_OK)
+                    throw std::runtime_error("Failure to decompress '" + m_file_name + "': zlib reset failed");
+            } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                throw std::runtime_error("Failure to decompress '" + m_file_name + "': " + (zs.msg ? zs.msg : "zlib error"));
+            }
+            if (used == job->out.size()) {
+                job->in_end = xInputPos(in, zs.avail_in);
+                job->out.resize(used);
+                if (!xSubmit(job, false))
+                    return;
+                job = std::make_shared<job_t>();
+                job->in_pos = job->in_end;
+                job->out.resize(m_buffer_size);
+                used = 0;
+            }
+        }
+        if (in_member)
+            throw std::runtime_error("Failure to decompress '" + m_file_name + "': unexpected end of file");
+        job->in_end = xInputPos(in, 0);
+        job->out.resize(used);
+        xSubmit(job, false);
+    }
+
+    void xInflateSequentialBzip2(std::ifstream& in, size_t pos)
+    {
+        std::vector<char> in_buf(kReadSize);
+        bz_stream bz;
+        memset(&bz, 0, sizeof(bz));
+        bool active = false;
+        auto job = std::make_shared<job_t>();
+        job->in_pos = pos;
+        job->out.resize(m_buffer_size);
+        size_t used = 0;
+        try {
+            while (true) {
+                if (bz.avail_in == 0) {
+                    in.read(in_buf.data(), in_buf.size());
+                    bz.next_in = in_buf.data();
+                    bz.avail_in = in.gcount();
+                    if (bz.avail_in == 0)
+                        break;
+                }
+                if (!active) {
+                    // next stream
+                    char* next_in = bz.next_in;
+                    unsigned avail_in = bz.avail_in;
+                    if (BZ2_bzDecompressInit(&bz, 0, 0) != BZ_OK)
+                        throw std::runtime_error("Failure to decompress '" + m_file_name + "': bzip2 init failed");
+                    bz.next_in = next_in;
+                    bz.avail_in = avail_in;
+                    active = true;
+                }
+                bz.next_out = job->out.data() + used;
+                bz.avail_out = job->out.size() - used;
+                int ret = BZ2_bzDecompress(&bz);
+                used = job->out.size() - bz.avail_out;
+                if (ret == BZ_STREAM_END) {
+                    BZ2_bzDecompressEnd(&bz);
+                    active = false;
+                } else if (ret != BZ_OK) {
+                    throw std::runtime_error("Failure to decompress '" + m_file_name + "': bzip2 error " + std::to_string(ret));
+                }
+                if (used == job->out.size()) {
+                    job->in_end = xInputPos(in, bz.avail_in);
+                    job->out.resize(used);
+                    if (!xSubmit(job, false)) {
+                        if (active)
+                            BZ2_bzDecompressEnd(&bz);
+                        return;
+                    }
+                    job = std::make_shared<job_t>();
+                    job->in_pos = job->in_end;
+                    job->out.resize(m_buffer_size);
+                    used = 0;
+                }
+            }
+            if (active) {
+                BZ2_bzDecompressEnd(&bz);
+                throw std::runtime_error("Failure to decompress '" + m_file_name + "': unexpected end of file");
+            }
+        } catch (...) {
+            if (active)
+                BZ2_bzDecompressEnd(&bz);
+            throw;
+        }
+        job->in_end = xInputPos(in, 0);
+        job->out.resize(used);
+        xSubmit(job, false);
+    }
+
+    /**
+     * @brief Position in the file of the first byte of compressed data not consumed yet
+     *
+     */
+    static size_t xInputPos(std::ifstream& in, size_t unconsumed)
+    {
+        if (in.eof()) {
+            in.clear();
+            in.seekg(0, std::ios::end);
+        }
+        return size_t(in.tellg()) - unconsumed;
+    }
+
+    std::string m_file_name;                ///< Input file name
+    format_t m_format;                      ///< Input compression format
+    size_t m_threads;                       ///< Number of worker threads
+    size_t m_buffer_size;                   ///< Decompressed buffer size in sequential mode
+    size_t m_job_size;                      ///< Compressed bytes per parallel job
+    size_t m_max_jobs;                      ///< Ring capacity
+    size_t m_compressed_pos = 0;            ///< Compressed position of the buffer being read
+
+    std::mutex m_mutex;                     ///< Guards everything below
+    std::condition_variable m_space_cv;     ///< Ring has free space
+    std::condition_variable m_work_cv;      ///< Work queue is not empty
+    std::condition_variable m_done_cv;      ///< Front job is done
+    std::deque<job_ptr> m_ring;             ///< Jobs in the input order
+    std::deque<job_ptr> m_work;             ///< Jobs waiting for workers
+    job_ptr m_current;                      ///< Job being read, front of the ring
+    bool m_cancelled = false;               ///< Stop all threads
+    bool m_reader_done = false;             ///< No more jobs will be submitted
+
+    std::thread m_reader;                   ///< Thread reading compressed input
+    std::vector<std::thread> m_workers;     ///< Worker threads
+};
+
+
+class parallel_ifstream : public std::istream
+/// Input file stream decompressing gzip or bzip2 file on several threads
+{
+public:
+    parallel_ifstream(const std::string& file_name, size_t threads, size_t buffer_size = 4 * 1024 * 1024, size_t job_size = parallel_inflate_streambuf::kJobSize)
+        : std::istream(nullptr)
+        , m_buf(file_name, threads, buffer_size, job_size)
+    {
+        rdbuf(&m_buf);
+    }
+
+    bxz::Compression compression() const { return m_buf.compression(); }
+    size_t compressed_tellg() const { return m_buf.compressed_tellg(); }
+
+private:
+    parallel_inflate_streambuf m_buf;
+};
+
+} // namespace sharq
+
+#endif
@@ -9,8 +9,10 @@
 
 #include <memory>
 #include <iostream>
+#include <vector>
 
 #include <re2/re2.h>
+#include <re2/set.h>
 
 class CRegExprMatcher
 /// Encapsulation for RE2 regexpr matcher
@@ -58,7 +60,7 @@ public:
 */        
     bool Matches(const re2::StringPiece& input)
     {
-        mLastInput = input.as_string();
+        mLastInput.assign(input.data(), input.size());
         return re2::RE2::PartialMatchN(input, *re, args.empty() ? nullptr : &args[0], (int)args.size());
     }
 
@@ -109,4 +111,74 @@ protected:
     MatchResult match;                  ///< captured matched groups
 };
 
+class CRegExprSet
+/// Encapsulation for RE2::Set, matches a list of patterns in a single pass
+{
+public:
+    /**
+     * @brief Construct a new empty CRegExprSet object
+     *
+     */
+    CRegExprSet()
+        : set(xOptions(), re2::RE2::UNANCHORED)
+    {
+    }
+
+    /**
+     * @brief Add pattern to the set
+     *
+     * @param pattern regex pattern
+     * @return int pattern index in the set
+     *
+     * @throws runtime error on invalid pattern
+     */
+    int Add(const std::string& pattern)
+    {
+        std::string error;
+        int index = set.Add(pattern, &error);
+        if (index < 0)
+            throw std::runtime_error("Invalid regex '" + pattern + "': " + error);
+        return index;
+    }
+
+    /**
+     * @brief Compile the set, no patterns can be added afterwards
+     *
+     * @throws runtime error if compilation fails
+     */
+    void Compile()
+    {
+        if (!set.Compile())
+            throw std::runtime_error("Failed to compile regex set");
+    }
+
+    /**
+     * @brief Find all patterns matching the input
+     *
+     * @param[in] input string to check
+     * @param[out] matches indices of matched patterns, in no particular order
+     * @return true if the set was evaluated, false if RE2 ran out of memory
+     *         and the caller has to fall back to matching the patterns one by one
+     */
+    bool Match(const re2::StringPiece& input, std::vector<int>& matches) const
+    {
+        re2::RE2::Set::ErrorInfo info;
+        matches.clear();
+        if (set.Match(input, &matches, &info))
+            return true;
+        return info.kind == re2::RE2::Set::kNoError;
+    }
+
+protected:
+    static re2::RE2::Options xOptions()
+    {
+        // the combined automaton of many patterns needs more room than a single regex
+        re2::RE2::Options options;
+        options.set_max_mem(64 << 20);
+        return options;
+    }
+
+    re2::RE2::Set set;      ///< RE2 set
+};
+
 #endif
@@ -9,6 +9,10 @@
 #include "fastq_read.hpp"
 #include <string>
 #include <map>
+#include <queue>
+#include <fstream>
+#include <cstdio>
+#include <unistd.h>
 #include <spdlog/spdlog.h>
 #include <spdlog/stopwatch.h>
 #include <spdlog/fmt/fmt.h>
@@ -18,12 +22,16 @@
 #include "taskflow/taskflow.hpp"
 #include "taskflow/algorithm/sort.hpp"
 #include "taskflow/algorithm/for_each.hpp"
+#include "hashing.hpp"
 
 
 using namespace std;
 
 static constexpr int MAX_ROW_TO_CLEAR = 5000000;
 static constexpr int MAX_ROWS_TO_OPTIMIZE = 10000000; 
+static constexpr size_t COLD_PAGE_SIZE = size_t(1) << 26;  ///< number of values in one page of cold storage 
+static constexpr size_t MAX_RELOADED_PAGES = 16;           ///< max number of pages reloaded from disk kept in memory 
+static constexpr size_t NAME_SORT_BYTES_PER_READ = 32;     ///< estimated memory per read for in-memory spot id assignment
 
 static_assert(bm::id_max == bm::id_max48, "BitMagic should be compiled in 64-bit mode");
 
@@ -112,6 +120,450 @@ public:
 };
 
 
+// --------------------------------------------------------------------------
+// cold_store_t - paged cold storage for sequence or quality data
+// Each page covers COLD_PAGE_SIZE consecutive offsets.
+// When spill file prefix is set, pages that are no longer written
+// can be serialized to disk and are reloaded on demand
+
+template<typename SV>
+class cold_store_t
+{
+public:
+    typedef typename SV::value_type value_type;
+
+    cold_store_t() = default;
+    cold_store_t(cold_store_t&&) = default;
+    cold_store_t& operator=(cold_store_t&&) = default;
+    ~cold_store_t() { clear(); }
+
+    // sets spill file prefix, spilling is disabled if prefix is empty
+    void set_spill_prefix(const string& prefix) { m_prefix = prefix; }
+
+    // removes all pages and spill files
+    void clear();
+
+    // stores sz values starting at offset
+    void import(const value_type* buf, size_t sz, size_t offset);
+
+    // retrieves len values starting at offset, reloads spilled pages if needed
+    void decode(value_type* buf, size_t offset, size_t len);
+
+    // clears value ranges, each range is compound offset (16 bit len + 48 bit offset) 
+    void clear_ranges(const uint64_t* offsets, size_t num_offsets);
+
+    // optimizes pages in memory, returns memory used by them
+    size_t optimize();
+
+    // serializes least recently used pages until at least bytes_to_free bytes are released
+    // returns the number of bytes released
+    size_t spill(size_t bytes_to_free);
+
+    size_t memory_used() const { return m_memory_used; } ///< memory used by pages in memory as of last optimization
+    size_t spilled_pages() const { return m_spilled_pages; } ///< number of pages currently on disk 
+
+private:
+    struct page_t {
+        unique_ptr<SV> data;         ///< page data, null if page is on disk or dropped
+        bvector_type pending_clear;  ///< ranges cleared while the page was on disk
+        size_t live = 0;             ///< number of values not cleared yet
+        size_t mem = 0;              ///< memory used as of last optimization
+        size_t last_used = 0;        ///< access clock for LRU eviction
+        bool dirty = true;           ///< page changed since it was last written to disk
+        bool on_disk = false;        ///< page has spill file 
+    };
+
+    SV& x_get_page(size_t page_idx);
+    void x_spill_page(size_t page_idx);
+    void x_drop_page(size_t page_idx);
+    string x_file_name(size_t page_idx) const { return fmt::format("{}.{}", m_prefix, page_idx); }
+
+    vector<page_t> m_pages;        
+    string m_prefix;                ///< spill file prefix
+    size_t m_clock = 0;             ///< page access counter
+    size_t m_memory_used = 0;       ///< memory used by pages in memory
+    size_t m_spilled_pages = 0;     ///< number of pages on disk, not in memory
+    deque<size_t> m_reloaded;       ///< pages reloaded from disk, oldest first
+};
+
+template<typename SV>
+void cold_store_t<SV>::clear()
+{
+    for (auto& page : m_pages) {
+        if (page.on_disk)
+            std::remove(x_file_name(&page - &m_pages[0]).c_str());
+    }
+    m_pages.clear();
+    m_reloaded.clear();
+    m_memory_used = 0;
+    m_spilled_pages = 0;
+}
+
+template<typename SV>
+SV& cold_store_t<SV>::x_get_page(size_t page_idx)
+{
+    if (page_idx >= m_pages.size()) 
+        m_pages.resize(page_idx + 1);
+    auto& page = m_pages[page_idx];
+    page.last_used = ++m_clock;
+    if (page.data) 
+        return *page.data;
+    page.data.reset(new SV);
+    if (!page.on_disk) 
+        return *page.data;
+
+    ifstream is(x_file_name(page_idx), ios::in | ios::binary | ios::ate);
+    vector<char> buffer(is ? size_t(is.tellg()) : 0);
+    is.seekg(0);
+    if (!is.read(buffer.data(), buffer.size()) || buffer.empty())
+        throw runtime_error(fmt::format("Failed to read cold storage page '{}'", x_file_name(page_idx)));
+    bm::sparse_vector_deserializer<SV> deserializer;
+    deserializer.deserialize(*page.data, (const unsigned char*)&buffer[0]);
+    page.dirty = page.pending_clear.any();
+    if (page.dirty) {
+        page.data->clear(page.pending_clear);
+        page.pending_clear.clear(true);
+    }
+    typename SV::statistics st;
+    page.data->calc_stat(&st);
+    page.mem = st.memory_used;
+    m_memory_used += page.mem;
+    --m_spilled_pages;
+
+    m_reloaded.push_back(page_idx);
+    while (m_reloaded.size() > MAX_RELOADED_PAGES) 
+        x_spill_page(m_reloaded.front());
+    return *page.data;
+}
+
+template<typename SV>
+void cold_store_t<SV>::x_spill_page(size_t page_idx)
+{
+    auto& page = m_pages[page_idx];
+    auto it = find(m_reloaded.begin(), m_reloaded.end(), page_idx);
+    if (it != m_reloaded.end()) 
+        m_reloaded.erase(it);
+    if (!page.data)
+        return;
+    if (page.dirty || !page.on_disk) {
+        bm::sparse_vector_serializer<SV> serializer;
+        bm::sparse_vector_serial_layout<SV> sv_lay;
+        serializer.serialize(*page.data, sv_lay);
+        auto file_name = x_file_name(page_idx);
+        ofstream ofs(file_name, ofstream::out | ofstream::binary | ofstream::trunc);
+        ofs.write((const char*)sv_lay.data(), sv_lay.size());
+        ofs.close();
+        if (!ofs)
+            throw runtime_error(fmt::format("Failed to write cold storage page '{}'", file_name));
+        page.on_disk = true;
+        page.dirty = false;
+    }
+    page.data.reset();
+    m_memory_used -= min(m_memory_used, page.mem);
+    page.mem = 0;
+    ++m_spilled_pages;
+}
+
+template<typename SV>
+void cold_store_t<SV>::x_drop_page(size_t page_idx)
+{
+    auto& page = m_pages[page_idx];
+    auto it = find(m_reloaded.begin(), m_reloaded.end(), page_idx);
+    if (it != m_reloaded.end()) 
+        m_reloaded.erase(it);
+    if (page.data) {
+        page.data.reset();
+        m_memory_used -= min(m_memory_used, page.mem);
+    } else if (page.on_disk) {
+        --m_spilled_pages;
+    }
+    if (page.on_disk) 
+        std::remove(x_file_name(page_idx).c_str());
+    page.on_disk = false;
+    page.pending_clear.clear(true);
+    page.mem = 0;
+}
+
+template<typename SV>
+void cold_store_t<SV>::import(const value_type* buf, size_t sz, size_t offset)
+{
+    while (sz > 0) {
+        size_t page_idx = offset / COLD_PAGE_SIZE;
+        size_t page_offset = offset % COLD_PAGE_SIZE;
+        size_t n = min(sz, COLD_PAGE_SIZE - page_offset);
+        x_get_page(page_idx).import(buf, n, page_offset);
+        auto& page = m_pages[page_idx];
+        page.live += n;
+        page.dirty = true;
+        buf += n;
+        offset += n;
+        sz -= n;
+    }
+}
+
+template<typename SV>
+void cold_store_t<SV>::decode(value_type* buf, size_t offset, size_t len)
+{
+    while (len > 0) {
+        size_t page_idx = offset / COLD_PAGE_SIZE;
+        size_t page_offset = offset % COLD_PAGE_SIZE;
+        size_t n = min(len, COLD_PAGE_SIZE - page_offset);
+        if (page_idx >= m_pages.size() || (!m_pages[page_idx].data && !m_pages[page_idx].on_disk))
+            throw runtime_error(fmt::format("Cold storage page {} is not available", page_idx));
+        x_get_page(page_idx).decode(buf, page_offset, n);
+        buf += n;
+        offset += n;
+        len -= n;
+    }
+}
+
+template<typename SV>
+void cold_store_t<SV>::clear_ranges(const uint64_t* offsets, size_t num_offsets)
+{
+    map<size_t, pair<bvector_type, size_t>> page_ranges; // page -> (cleared ranges, number of cleared values) 
+    for (size_t i = 0; i < num_offsets; ++i) {
+        size_t len = offsets[i] >> 48;
+        size_t offset = offsets[i] & 0x0000FFFFFFFFFFFF;
+        while (len > 0) {
+            size_t page_idx = offset / COLD_PAGE_SIZE;
+            size_t page_offset = offset % COLD_PAGE_SIZE;
+            size_t n = min(len, COLD_PAGE_SIZE - page_offset);
+            auto& r = page_ranges[page_idx];
+            r.first.set_range(page_offset, page_offset + (n - 1));
+            r.second += n;
+            offset += n;
+            len -= n;
+        }
+    }
+    size_t last_page = m_pages.empty() ? 0 : m_pages.size() - 1;
+    for (auto& it : page_ranges) {
+        size_t page_idx = it.first;
+        if (page_idx >= m_pages.size())
+            continue;
+        auto& page = m_pages[page_idx];
+        page.live -= min(page.live, it.second.second);
+        if (page.live == 0 && page_idx < last_page) {
+            // all values of the page were consumed and the page won't be written again
+            x_drop_page(page_idx);
+            continue;
+        }
+        if (page.data) {
+            page.data->clear(it.second.first);
+            page.dirty = true;
+        } else if (page.on_disk) {
+            page.pending_clear.merge(it.second.first);
+        }
+    }
+}
+
+template<typename SV>
+size_t cold_store_t<SV>::optimize()
+{
+    typename SV::statistics st;
+    for (auto& page : m_pages) {
+        if (!page.data) 
+            continue;
+        page.data->optimize(TB1, bm::bvector<>::opt_compress, &st);
+        m_memory_used -= min(m_memory_used, page.mem);
+        page.mem = st.memory_used;
+        m_memory_used += page.mem;
+    }
+    return m_memory_used;
+}
+
+template<typename SV>
+size_t cold_store_t<SV>::spill(size_t bytes_to_free)
+{
+    if (m_prefix.empty() || m_pages.size() < 2)
+        return 0;
+    // the last page is still being written and stays in memory
+    vector<size_t> candidates;
+    for (size_t i = 0; i < m_pages.size() - 1; ++i) {
+        if (m_pages[i].data)
+            candidates.push_back(i);
+    }
+    sort(candidates.begin(), candidates.end(), [this](size_t l, size_t r) {
+        return m_pages[l].last_used < m_pages[r].last_used;
+    });
+    size_t freed = 0;
+    for (auto page_idx : candidates) {
+        if (freed >= bytes_to_free)
+            break;
+        freed += m_pages[page_idx].mem;
+        x_spill_page(page_idx);
+    }
+    return freed;
+}
+
+// --------------------------------------------------------------------------
+// name_hash_sorter_t - sorts read names by 128-bit hash using sorted runs on disk
+// Used for spot id assignment when read names do not fit into the memory limit.
+// Reads with the same hash are treated as reads of the same spot
+
+class name_hash_sorter_t
+{
+public:
+    struct record_t {
+        uint64_t h1;
+        uint64_t h2;
+        uint64_t row;
+        bool operator<(const record_t& r) const {
+            if (h1 != r.h1) return h1 < r.h1;
+            if (h2 != r.h2) return h2 < r.h2;
+            return row < r.row;
+        }
+        bool same_name(const record_t& r) const { return h1 == r.h1 && h2 == r.h2; }
+    };
+
+    ~name_hash_sorter_t() { clear(); }
+
+    // prefix - run file name prefix, max_records - max number of records sorted in memory
+    void init(const string& prefix, size_t max_records);
+
+    // removes collected records and run files
+    void clear();
+
+    // adds name of the next row
+    void add(const string& name);
+
+    // completes collection, must be called before for_each_spot
+    void flush();
+
+    // number of collected rows
+    size_t size() const { return m_size; }
+
+    // calls func(rows) for each group of rows with the same name hash, rows are sorted
+    template<typename F>
+    void for_each_spot(F&& func);
+
+private:
+    void x_write_run();
+
+    string m_prefix;                ///< run file prefix
+    size_t m_max_records = 0;       ///< max number of records in memory
+    size_t m_size = 0;              ///< number of rows added 
+    vector<record_t> m_buffer;      ///< current run
+    vector<string> m_runs;          ///< sorted run files
+};
+
+void name_hash_sorter_t::init(const string& prefix, size_t max_records) 
+{
+    clear();
+    m_prefix = prefix;
+    m_max_records = max<size_t>(max_records, 1);
+    m_buffer.reserve(min<size_t>(m_max_records, 1 << 20));
+}
+
+void name_hash_sorter_t::clear()
+{
+    for (const auto& f : m_runs)
+        std::remove(f.c_str());
+    m_runs.clear();
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+    m_size = 0;
+}
+
+void name_hash_sorter_t::add(const string& name)
+{
+    auto& r = m_buffer.emplace_back();
+    r.h1 = hashing::MurmurHash(name.data(), name.size());
+    r.h2 = hashing::fnv_1a(name.data(), name.size());
+    r.row = m_size++;
+    if (m_buffer.size() >= m_max_records)
+        x_write_run();
+}
+
+void name_hash_sorter_t::x_write_run()
+{
+    tf::Executor executor(min<int>(24, std::thread::hardware_concurrency()));
+    tf::Taskflow taskflow;
+    taskflow.sort(m_buffer.begin(), m_buffer.end());
+    executor.run(taskflow).wait();
+
+    auto file_name = fmt::format("{}.{}", m_prefix, m_runs.size());
+    ofstream ofs(file_name, ofstream::out | ofstream::binary | ofstream::trunc);
+    ofs.write((const char*)m_buffer.data(), m_buffer.size() * sizeof(record_t));
+    ofs.close();
+    if (!ofs)
+        throw runtime_error(fmt::format("Failed to write sort run '{}'", file_name));
+    m_runs.push_back(file_name);
+    m_buffer.clear();
+}
+
+void name_hash_sorter_t::flush()
+{
+    if (m_runs.empty()) {
+        // everything fits into memory, no merge is needed
+        tf::Executor executor(min<int>(24, std::thread::hardware_concurrency()));
+        tf::Taskflow taskflow;
+        taskflow.sort(m_buffer.begin(), m_buffer.end());
+        executor.run(taskflow).wait();
+    } else if (!m_buffer.empty()) {
+        x_write_run();
+    }
+    spdlog::info("Name hash sort: {:L} rows, {} runs", m_size, m_runs.size());
+}
+
+template<typename F>
+void name_hash_sorter_t::for_each_spot(F&& func)
+{
+    vector<uint64_t> rows;
+    record_t curr{};
+    auto on_record = [&](const record_t& r) {
+        if (!rows.empty() && !curr.same_name(r)) {
+            func(rows);
+            rows.clear();
+        }
+        curr = r;
+        rows.push_back(r.row);
+    };
+
+    if (m_runs.empty()) {
+        for (const auto& r : m_buffer)
+            on_record(r);
+    } else {
+        struct run_reader_t {
+            ifstream is;
+            vector<record_t> buf;
+            size_t pos = 0;
+            bool next() {
+                if (++pos < buf.size())
+                    return true;
+                buf.resize(buf.capacity());
+                is.read((char*)buf.data(), buf.size() * sizeof(record_t));
+                buf.resize(is.gcount() / sizeof(record_t));
+                pos = 0;
+                return !buf.empty();
+            }
+            const record_t& top() const { return buf[pos]; }
+        };
+        size_t buf_records = max<size_t>(1024, min<size_t>(65536, m_max_records / m_runs.size()));
+        vector<run_reader_t> readers(m_runs.size());
+        auto greater = [&readers](size_t l, size_t r) { return readers[r].top() < readers[l].top(); };
+        priority_queue<size_t, vector<size_t>, decltype(greater)> heap(greater);
+        for (size_t i = 0; i < m_runs.size(); ++i) {
+            auto& reader = readers[i];
+            reader.is.open(m_runs[i], ios::in | ios::binary);
+            if (!reader.is)
+                throw runtime_error(fmt::format("Failed to open sort run '{}'", m_runs[i]));
+            reader.buf.reserve(buf_records);
+            reader.pos = size_t(-1);
+            if (reader.next())
+                heap.push(i);
+        }
+        while (!heap.empty()) {
+            size_t i = heap.top();
+            heap.pop();
+            on_record(readers[i].top());
+            if (readers[i].next())
+                heap.push(i);
+        }
+    }
+    if (!rows.empty())
+        func(rows);
+}
+
 // temproary buffers for multi-threaded processing
 static thread_local vector<svector_u32::value_type> tmp_buffer;
 static thread_local string tmp_str;
@@ -134,12 +586,31 @@ struct spot_assembly_t {
     template<typename T>
     void assign_spot_id(str_sv_type& read_names, vector<T>& read_index);
 
+    // assign spot_ids for read names collected by external hash sort
+    template<typename T>
+    void assign_spot_id(name_hash_sorter_t& read_names, vector<T>& read_index);
+
     template<typename T>
     void x_assign_spot_id(tf::Executor& executor, str_sv_type& read_names, vector<T>& sort_index, vector<T>& read_index);
 
     // optimize/compress cold storage data
+    // spills cold storage pages to disk if memory limit is exceeded
     void optimize();
 
+    // sets memory limit in bytes (0 - no limit) and directory for temporary files
+    void set_memory_limit(size_t memory_limit, const string& temp_dir);
+
+    // returns true if in-memory spot id assignment for num_reads reads exceeds the memory limit
+    bool needs_external_sort(size_t num_reads) const {
+        return m_memory_limit > 0 && num_reads * NAME_SORT_BYTES_PER_READ > m_memory_limit;
+    }
+
+    // initializes external name sorter within memory limit
+    void init_name_sorter(name_hash_sorter_t& read_names) const;
+
+    // initializes cold storage after spot ids are assigned
+    void x_init_storage();
+
     // returns true if spot is last in the file
     bool is_last_spot(size_t row_id);
 
@@ -184,14 +655,17 @@ struct spot_assembly_t {
     // classes for cold storage 
     svector_u8 m_spot_index;             ///< spot index - num reads per spot 
     vector<metadata_t> m_reads_metadata; ///< reads metadata from defline - readNum,  spotGroup, sequence and quality offset 
-    vector<svector_u32> m_sequences;     ///< sequence data
+    vector<cold_store_t<svector_u32>> m_sequences; ///< sequence data
     vector<size_t> m_seq_offset;         ///< last sequence offset per read
 
-    vector<svector_int> m_qualities;     ///< quality data
+    vector<cold_store_t<svector_int>> m_qualities; ///< quality data
     vector<size_t> m_qual_offset;        ///< last quality offset per read
 
     size_t m_hot_reads_threshold = 10000000;  ///< threshold for hot reads, if read is far from the last read in the spot, it is saved in cold storage
 
+    size_t m_memory_limit = 0;           ///< memory limit in bytes for cold storage, 0 - no limit
+    string m_temp_dir;                   ///< directory for spilled cold storage pages and sort runs
+
 };
 
 void spot_assembly_t::init(size_t num_rows) 
@@ -220,6 +694,19 @@ void spot_assembly_t::init(size_t num_rows)
     m_total_spots = 0;
 } 
 
+void spot_assembly_t::set_memory_limit(size_t memory_limit, const string& temp_dir)
+{
+    m_memory_limit = memory_limit;
+    m_temp_dir = temp_dir.empty() ? "." : temp_dir;
+}
+
+void spot_assembly_t::init_name_sorter(name_hash_sorter_t& read_names) const
+{
+    // keep a half of the budget for the run being sorted
+    size_t max_records = m_memory_limit / 2 / sizeof(name_hash_sorter_t::record_t);
+    read_names.init(fmt::format("{}/sharq.{}.names", m_temp_dir, getpid()), max<size_t>(max_records, 1000000));
+}
+
 static bool file_exists(const string& name) 
 {
     struct stat stat_buffer;   
@@ -493,6 +980,33 @@ void spot_assembly_t::assign_spot_id(str_sv_type& read_names, vector<T>& read_in
     assert(spot_id_cnt1 == spot_id_cnt2);
     assert(spot_id_cnt1 == spot_tested2.count());
     */
+    x_init_storage();
+}
+
+template<typename T>
+void spot_assembly_t::assign_spot_id(name_hash_sorter_t& read_names, vector<T>& read_index) 
+{
+    size_t num_rows = read_names.size();
+    read_index.resize(num_rows);
+    init(num_rows);
+    spdlog::stopwatch sw;
+    size_t spot_id = 0;
+    read_names.for_each_spot([&](const vector<uint64_t>& rows) {
+        ++spot_id;
+        for (auto row : rows)
+            read_index[row] = spot_id;
+        m_last_index.set_bit_no_check(rows.back());
+        if (rows.back() - rows.front() < m_hot_reads_threshold)
+            m_hot_spot_ids.set_bit_no_check(spot_id);
+        ++m_total_spots;
+        ++m_reads_counts[rows.size()];
+    });
+    spdlog::info("Merging sorted names took {:.3}", sw);
+    x_init_storage();
+}
+
+void spot_assembly_t::x_init_storage()
+{
     m_last_index.optimize(TB1);
     m_last_index.freeze();
 
@@ -512,6 +1026,13 @@ void spot_assembly_t::assign_spot_id(str_sv_type& read_names, vector<T>& read_in
     m_qualities.resize(max_reads);
     m_qual_offset.resize(max_reads);
     fill(m_qual_offset.begin(), m_qual_offset.end(), 0);
+
+    if (m_memory_limit > 0) {
+        for (int read_idx = 0; read_idx < max_reads; ++read_idx) {
+            m_sequences[read_idx].set_spill_prefix(fmt::format("{}/sharq.{}.seq{}", m_temp_dir, getpid(), read_idx));
+            m_qualities[read_idx].set_spill_prefix(fmt::format("{}/sharq.{}.qual{}", m_temp_dir, getpid(), read_idx));
+        }
+    }
 }
 
 // saves read to hot or cold storage
@@ -728,26 +1249,43 @@ void spot_assembly_t::optimize()
             md_mem += metadata.Optimize();
         }
     }
-    svector_u32::statistics st1;
     size_t seq_mem = 0;
     {
         lock_guard<mutex> lock(m_mutex);
-        for (auto& seq : m_sequences) {
-            seq.optimize(TB1, bm::bvector<>::opt_compress, &st1);
-            seq_mem += st1.memory_used;
-        }
+        for (auto& seq : m_sequences) 
+            seq_mem += seq.optimize();
     }
-    svector_int::statistics st2;
     size_t qual_mem = 0;
     lock_guard<mutex> lock(m_mutex);
     {
-        for (auto& qual : m_qualities) {
-            qual.optimize(TB1, bm::bvector<>::opt_compress, &st2);
-            qual_mem += st2.memory_used;
-        }
+        for (auto& qual : m_qualities) 
+            qual_mem += qual.optimize();
     }
     auto logger = spdlog::get("parser_logger"); // send log to stderr        
     if (logger) logger->info("optimize took: {}, seq_mem: {:L}, qual_mem: {:L}, md_mem: {:L}", sw, seq_mem, qual_mem, md_mem);
+
+    size_t total_mem = seq_mem + qual_mem + md_mem;
+    if (m_memory_limit == 0 || total_mem <= m_memory_limit)
+        return;
+    // spill cold pages down to 80% of the limit, metadata and hot spots stay in memory
+    sw.reset();
+    size_t to_free = total_mem - m_memory_limit / 10 * 8;
+    size_t freed = 0, spilled_pages = 0;
+    for (auto& seq : m_sequences) {
+        if (freed < to_free)
+            freed += seq.spill((to_free - freed) * seq_mem / (seq_mem + qual_mem + 1) + 1);
+    }
+    for (auto& qual : m_qualities) {
+        if (freed < to_free)
+            freed += qual.spill(to_free - freed);
+    }
+    for (auto& seq : m_sequences)
+        spilled_pages += seq.spilled_pages();
+    for (auto& qual : m_qualities)
+        spilled_pages += qual.spilled_pages();
+    if (freed < to_free)
+        spdlog::warn("Memory limit {:L} exceeded: {:L} used, {:L} spilled", m_memory_limit, total_mem, freed);
+    if (logger) logger->info("spill took: {}, freed: {:L}, pages on disk: {:L}", sw, freed, spilled_pages);
 }
 
 // returns true if spot is last in the file
@@ -930,7 +1468,6 @@ void spot_assembly_t::clear_spot_mt(size_t row_id)
             ++c;
         }                
         vector<svector_u64::value_type> offsets(row_ids.size());
-        bvector_type clear_bv;
 
         assert(c == m_num_rows_to_clear);
         {
@@ -959,30 +1496,12 @@ void spot_assembly_t::clear_spot_mt(size_t row_id)
                 }
                 metadata.get<bit_t>(metadata_t::e_ReadFilterId).bit_sub(m_rows_to_clear);
 
-                clear_bv.clear();
                 auto sz = metadata.get<u64_t>(metadata_t::e_SeqOffsetId).gather(offsets.data(), row_ids.data(), offsets.size(), bm::BM_UNSORTED);
-                for (size_t i = 0; i < sz; ++i) {
-                    auto offset = offsets[i];
-                    size_t len = offset >> 48;
-                    if (len > 0) {
-                        offset &= 0x0000FFFFFFFFFFFF;
-                        clear_bv.set_range(offset, offset + (len - 1));
-                    }
-                }
-                m_sequences[read_idx].clear(clear_bv);
+                m_sequences[read_idx].clear_ranges(offsets.data(), sz);
                 metadata.get<u64_t>(metadata_t::e_SeqOffsetId).clear(m_rows_to_clear);
 
-                clear_bv.clear();
                 sz = metadata.get<u64_t>(metadata_t::e_QualOffsetId).gather(offsets.data(), row_ids.data(), offsets.size(), bm::BM_UNSORTED);
-                for (size_t i = 0; i < sz; ++i) {
-                    auto offset = offsets[i];
-                    size_t len = offset >> 48;
-                    if (len > 0) {
-                        offset &= 0x0000FFFFFFFFFFFF;
-                        clear_bv.set_range(offset, offset + (len - 1));
-                    }
-                }
-                m_qualities[read_idx].clear(clear_bv);
+                m_qualities[read_idx].clear_ranges(offsets.data(), sz);
                 metadata.get<u64_t>(metadata_t::e_QualOffsetId).clear(m_rows_to_clear);
             }
             m_rows_to_clear.clear();
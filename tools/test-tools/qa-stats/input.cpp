@@ -46,6 +46,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <exception>
+#include <stdexcept>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/stat.h>
@@ -232,7 +233,7 @@ struct RawReadType {
     }
 };
 
-static void cleanUpSegments(std::string &sequence, std::vector<int> const &lengths, std::vector<int> const &starts, std::vector<uint64_t> const &aligned)
+void Input::restoreAligned(std::string &sequence, std::vector<int> const &lengths, std::vector<uint64_t> const &aligned)
 {
     std::string::size_type totalReadLen = 0;
     std::string::size_type cmpReadLen = 0;
@@ -315,6 +316,11 @@ int Input::getGroup(std::string const &named) {
     if (found >= 0)
         return found;
     return lock.writer([&]{
+        // another thread may have added it since we looked
+        for (unsigned i = 0; i < groups.size(); ++i) {
+            if (groups[i] == named)
+                return (int)i;
+        }
         auto i = (int)groups.size();
         groups.push_back(named);
         return i;
@@ -333,6 +339,11 @@ int Input::getReference(std::string const &named) {
     if (found >= 0)
         return found;
     return lock.writer([&]{
+        // another thread may have added it since we looked
+        for (unsigned i = 0; i < references.size(); ++i) {
+            if (references[i] == named)
+                return (int)i;
+        }
         auto i = (int)references.size();
         references.push_back(named);
         return i;
@@ -631,7 +642,7 @@ struct BasicSource: public Input::Source {
             }
             else {
                 // assume sequence is from CMP_READ and add missing reads
-                cleanUpSegments(result.sequence, lengths, starts, aligned);
+                Input::restoreAligned(result.sequence, lengths, aligned);
             }
             // All read fields have the same count and have been initialized
             // with either their parsed values or their default values.
@@ -1018,6 +1029,14 @@ std::unique_ptr<Input::Source> Input::newSource(Input::Source::Type const &src,
         return ::newSource(src);
 }
 
+#if !QA_STATS_NATIVE
+bool Input::nativeAvailable() { return false; }
+
+Input::Renumbering Input::readNative(std::string const &path, unsigned threads, Consumer const &consume) {
+    throw std::logic_error("VDB input is not available");
+}
+#endif
+
 static void Delimited_test() {
     auto strm = std::string_view("sequence \t 123, 456\t\n");
     auto raw = Delimited(strm, '\t');
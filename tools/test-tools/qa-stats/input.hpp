@@ -34,6 +34,7 @@
 #include <vector>
 #include <memory>
 #include <variant>
+#include <functional>
 
 struct CIGAR {
     struct OP {
@@ -152,6 +153,29 @@ struct Input {
     };
     static std::unique_ptr<Source> newSource(Source::Type const &source = Source::StdInType{}, bool multithreaded = true);
 
+    /// Called from the worker threads of readNative; `worker` is in [0, threads).
+    using Consumer = std::function<void(unsigned worker, Input const &record)>;
+
+    /// True if this build can read VDB runs directly.
+    static bool nativeAvailable();
+
+    /// Maps the ids handed out while reading to their final ids, indexed by the old id.
+    struct Renumbering {
+        std::vector<int> references;
+        std::vector<int> groups;
+    };
+
+    /// Read the same records that make-input.sh would produce, straight from a VDB run.
+    /// Each of `threads` workers reads its own row ranges with its own cursors.
+    /// The workers get reference and group ids in whatever order they race to them;
+    /// afterwards the new names are put in the order they first appear in the run,
+    /// the same order the text input would give them, and the returned renumbering
+    /// has to be applied to anything the consumer recorded by id.
+    static Renumbering readNative(std::string const &path, unsigned threads, Consumer const &consume);
+
+    /// Replace aligned reads missing from a CMP_READ sequence with placeholders.
+    static void restoreAligned(std::string &sequence, std::vector<int> const &lengths, std::vector<uint64_t> const &aligned);
+
     struct Reset {
         ~Reset() {
             Input::references.clear();
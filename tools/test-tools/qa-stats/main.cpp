@@ -37,6 +37,8 @@
 #include <chrono>
 #include <tuple>
 #include <cmath>
+#include <atomic>
+#include <thread>
 #include "parameters.hpp"
 #include "input.hpp"
 #include "hashing.hpp"
@@ -117,6 +119,11 @@ struct BaseStats {
     uint64_t operator [](Index const &i) const {
         return counts[i.index];
     }
+    BaseStats &operator +=(BaseStats const &addend) {
+        for (auto i = decltype(counts)::size_type(0); i < counts.size(); ++i)
+            counts[i] += addend.counts[i];
+        return *this;
+    }
     static void print(JSON_ostream &out, char const *base, uint64_t bio, uint64_t tech) {
         if (bio || tech) {
             out << '{' << JSON_Member{"base"} << base;
@@ -166,6 +173,13 @@ struct DistanceStats {
         unsigned operator[](Index index) const {
             return index < counts.size() ? counts[index] : 0;
         }
+        DistanceStat &operator +=(DistanceStat const &addend) {
+            if (counts.size() < addend.counts.size())
+                counts.resize(addend.counts.size(), 0);
+            for (auto i = Index(0); i < addend.counts.size(); ++i)
+                counts[i] += addend.counts[i];
+            return *this;
+        }
         /// Used for already binned stats, like K-M and S-W.
         static void print(JSON_ostream &out, DistanceStat const &self) {
             auto const n = self.counts.size();
@@ -226,6 +240,16 @@ struct DistanceStats {
     operator bool() const {
         return A || C || G || T || SW || KM;
     }
+    DistanceStats &operator +=(DistanceStats const &addend) {
+        A += addend.A;
+        C += addend.C;
+        G += addend.G;
+        T += addend.T;
+        SW += addend.SW;
+        KM += addend.KM;
+        maxpos = std::max(maxpos, addend.maxpos);
+        return *this;
+    }
     void reset() {
         A.reset();
         C.reset();
@@ -288,17 +312,30 @@ struct DistanceStats {
     }
 };
 
+/// The first element of each reference holds the hashes:
+/// `total` is the product of positions modulo `hashModulus`,
+/// `biological` and `technical` are XORs of sequence and CIGAR hashes.
+/// All of them are independent of the record order, so partial stats can be merged.
 struct ReferenceStats : public std::vector<std::vector<CountFR>> {
     static constexpr unsigned chunkSize = (1u << 14);
+    static constexpr uint64_t hashModulus = 0x1000001b3ull;
+    static constexpr uint64_t hashBasis = 0xcbf29ce484222325ull % hashModulus;
 
-    void record(unsigned refId, unsigned position, unsigned strand, std::string const &sequence, CIGAR const &cigar) {
-        auto const ps = (uint64_t(position) << 1) | (strand & 1);
-
-        while (refId >= size()) {
+    static uint64_t mulmod(uint64_t a, uint64_t b) {
+        return uint64_t((unsigned __int128)a * b % hashModulus);
+    }
+    void grow(size_t n) {
+        while (n > size()) {
             auto value = std::vector<CountFR>();
             value.push_back(CountFR());
+            value[0].total = 1;
             push_back(value);
         }
+    }
+    void record(unsigned refId, unsigned position, unsigned strand, std::string const &sequence, CIGAR const &cigar) {
+        auto const ps = (uint64_t(position) << 1) | (strand & 1);
+
+        grow(refId + 1);
         auto &reference = (*this)[refId];
         if (position >= 0) {
             auto const chunk = 1 + position / chunkSize;
@@ -308,19 +345,46 @@ struct ReferenceStats : public std::vector<std::vector<CountFR>> {
 
             reference[chunk].addStrand(strand != 0);
 
-            if (reference[0].total == 0)
-                reference[0].total = 0xcbf29ce484222325ull % 0x1000001b3ull;
-            reference[0].total = (reference[0].total * ps) % 0x1000001b3ull;
+            if (ps % hashModulus != 0) // a zero would wipe out the product
+                reference[0].total = mulmod(reference[0].total, ps);
             reference[0].biological ^= SeqHash::hash(sequence.size(), sequence.data());
             reference[0].technical ^= cigar.hashValue();
         }
     }
+    /// Move each reference to `newId[refId]`.
+    void renumber(std::vector<int> const &newId) {
+        auto old = ReferenceStats();
+        swap(old);
+        for (auto i = size_t(0); i < old.size(); ++i) {
+            auto const j = (size_t)newId[i];
+            grow(j + 1);
+            (*this)[j] = std::move(old[i]);
+        }
+    }
+    ReferenceStats &operator +=(ReferenceStats const &addend) {
+        grow(addend.size());
+        for (auto &other : addend) {
+            auto &reference = (*this)[&other - &addend[0]];
+
+            if (reference.size() < other.size())
+                reference.resize(other.size(), CountFR{});
+            for (auto &counter : other) {
+                auto const chunk = &counter - &other[0];
+                if (chunk == 0) continue;
+                reference[chunk] += counter;
+            }
+            reference[0].total = mulmod(reference[0].total, other[0].total);
+            reference[0].biological ^= other[0].biological;
+            reference[0].technical ^= other[0].technical;
+        }
+        return *this;
+    }
     friend JSON_ostream &operator <<(JSON_ostream &out, ReferenceStats const &self) {
         for (auto &reference : self) {
             auto const refId = &reference - &self[0];
             auto const refName = Input::references[refId];
             CountFR total;
-            auto const &posHash = reference[0].total;
+            auto const posHash = mulmod(hashBasis, reference[0].total);
             auto const &seqHash = reference[0].biological;
             auto const &cigHash = reference[0].technical;
 
@@ -398,6 +462,11 @@ struct SpotLayouts {
         index[key] = i;
         return count[i];
     }
+    SpotLayouts &operator +=(SpotLayouts const &addend) {
+        for (auto const &[key, i] : addend.index)
+            (*this)[key] += addend.count[i];
+        return *this;
+    }
     friend JSON_ostream &operator <<(JSON_ostream &out, SpotLayouts const &value) {
         for (auto i = value.index.begin(); i != value.index.end(); ++i) {
             auto const &desc = i->first;
@@ -423,6 +492,14 @@ struct CountBTN {
         tech += 1;
         return *this;
     }
+    CountBTN &operator +=(CountBTN const &addend) {
+        total += addend.total;
+        biological += addend.biological;
+        technical += addend.technical;
+        nobiological += addend.nobiological;
+        notechnical += addend.notechnical;
+        return *this;
+    }
     friend JSON_ostream &operator <<(JSON_ostream &out, CountBTN const &value) {
         return out
             << JSON_Member{"total"} << value.total
@@ -434,6 +511,11 @@ struct CountBTN {
 };
 
 struct SpotStats : public std::map<unsigned, CountBTN> {
+    SpotStats &operator +=(SpotStats const &addend) {
+        for (auto &[k, v] : addend)
+            (*this)[k] += v;
+        return *this;
+    }
     friend JSON_ostream &operator <<(JSON_ostream &out, SpotStats const &stats) {
         for (auto &[k, v] : stats) {
             out << '{'
@@ -453,6 +535,15 @@ struct Stats {
     DistanceStats spectra;
     ReferenceStats references;
 
+    Stats &operator +=(Stats const &addend) {
+        reads += addend.reads;
+        spots += addend.spots;
+        bases += addend.bases;
+        layouts += addend.layouts;
+        spectra += addend.spectra;
+        references += addend.references;
+        return *this;
+    }
     void record(SpotLayout const &desc, Stats *group = nullptr) {
         reads.biological += desc.biological;
         reads.technical += desc.technical;
@@ -552,6 +643,8 @@ struct App {
         { "progress", "p", "60" },
         { "multithreaded", "t", "1" },
         { "mmap", "m", "1" },
+        { "native", "n", nullptr },
+        { "threads", "j", nullptr, true },
         { "output", "o", nullptr, true }
     })
     , nextInput(arguments.begin())
@@ -570,6 +663,18 @@ struct App {
                 use_mmap = std::stoi(value.value()) != 0;
                 continue;
             }
+            if (param == "native") {
+                native = true;
+                continue;
+            }
+            if (param == "threads") {
+                if (value) {
+                    threads = std::stoi(value.value());
+                    continue;
+                }
+                std::cerr << "error: threads parameter needs a number" << std::endl;
+                exit(1);
+            }
             if (param == "output") {
                 if (value) {
                     output = value;
@@ -580,11 +685,20 @@ struct App {
             }
             if (param == "help") {
                 std::cout << "usage: " << arguments.program << " [-p|--progress <seconds:=60>] [-t|--multithreaded] [-m|--mmap] [-o|--output <path>] [<path> ...]" << std::endl;
+                std::cout << "       " << arguments.program << " -n|--native [-j|--threads <count>] [-o|--output <path>] <path or accession> ..." << std::endl;
                 exit(0);
             }
             std::cerr << "error: Unrecognized parameter " << param << std::endl;
             exit(1);
         }
+        if (native && !Input::nativeAvailable()) {
+            std::cerr << "error: this build of " << arguments.program << " can not read VDB runs" << std::endl;
+            exit(1);
+        }
+        if (native && arguments.empty()) {
+            std::cerr << "error: native mode needs a path or an accession" << std::endl;
+            exit(1);
+        }
     }
     int run() {
         while (processNextInput())
@@ -604,7 +718,10 @@ struct App {
     }
 private:
     bool processNextInput() {
-        gather();
+        if (native)
+            gatherNative();
+        else
+            gather();
         return !(arguments.empty() || nextInput == arguments.end());
     }
     void print(std::ostream &strm) {
@@ -629,40 +746,44 @@ private:
         std::cout << std::endl;
         reporter.report(processed);
     }
+    static void record(Input const &spot, Stats &stats, std::vector<Stats> &spotGroup) {
+        unsigned naligned = 0;
+
+        if (spot.group >= 0 && spotGroup.size() <= (size_t)spot.group)
+            spotGroup.resize(spot.group + 1, Stats{});
+
+        auto const group = spot.group >= 0 ? &spotGroup[spot.group] : nullptr;
+
+        for (auto const &read : spot.reads) {
+            if (read.type == Input::ReadType::aligned && !read.cigar) {
+                // This is the sequence record for an aligned read.
+                // The sequence and alignment details have/will be handled
+                // by the alignment record.
+                continue;
+            }
+            auto const seq = spot.sequence.substr(read.start, read.length);
+
+            stats.record(seq, read.type, group);
+            if (read.type == Input::ReadType::aligned) {
+                assert(read.reference >= 0);
+                assert(read.position >= 0);
+                unsigned const strand = read.orientation == Input::ReadOrientation::reverse ? 1 : 0;
+                stats.record(read.reference, read.position, strand, seq, read.cigar, group);
+                ++naligned;
+            }
+        }
+        if (spot.reads.size() > 0 && spot.reads.size() != naligned) {
+            auto const &layout = SpotLayout(spot);
+            stats.record(layout, group);
+        }
+    }
     void gather() {
         auto source = Input::newSource(inputStream(), multithreaded);
         while (*source) {
             try {
                 auto const spot = source->get();
-                unsigned naligned = 0;
-
-                if (spotGroup.size() < Input::groups.size())
-                    spotGroup.resize(Input::groups.size(), Stats{});
-
-                auto const group = spot.group >= 0 ? &spotGroup[spot.group] : nullptr;
-
-                for (auto const &read : spot.reads) {
-                    if (read.type == Input::ReadType::aligned && !read.cigar) {
-                        // This is the sequence record for an aligned read.
-                        // The sequence and alignment details have/will be handled
-                        // by the alignment record.
-                        continue;
-                    }
-                    auto const seq = spot.sequence.substr(read.start, read.length);
-
-                    stats.record(seq, read.type, group);
-                    if (read.type == Input::ReadType::aligned) {
-                        assert(read.reference >= 0);
-                        assert(read.position >= 0);
-                        unsigned const strand = read.orientation == Input::ReadOrientation::reverse ? 1 : 0;
-                        stats.record(read.reference, read.position, strand, seq, read.cigar, group);
-                        ++naligned;
-                    }
-                }
-                if (spot.reads.size() > 0 && spot.reads.size() != naligned) {
-                    auto const &layout = SpotLayout(spot);
-                    stats.record(layout, group);
-                }
+
+                record(spot, stats, spotGroup);
                 reporter.update(++processed);
             }
             catch (std::ios_base::failure const &e) {
@@ -672,6 +793,41 @@ private:
             }
         }
     }
+    /// Each worker thread accumulates its own stats, they are merged at the end.
+    void gatherNative() {
+        auto const nthreads = threads > 0 ? (unsigned)threads : std::max(1u, std::thread::hardware_concurrency());
+        auto workerStats = std::vector<Stats>(nthreads);
+        auto workerGroups = std::vector<std::vector<Stats>>(nthreads);
+        std::atomic<uint64_t> records{0};
+
+        currentInput = nextInput++;
+        auto const renumbering = Input::readNative(*currentInput, nthreads, [&](unsigned worker, Input const &spot) {
+            record(spot, workerStats[worker], workerGroups[worker]);
+            auto const n = ++records;
+            if (worker == 0)
+                reporter.update(processed + n);
+        });
+        for (auto i = 0u; i < nthreads; ++i) {
+            auto groups = std::vector<Stats>();
+
+            workerStats[i].references.renumber(renumbering.references);
+            for (auto &group : workerGroups[i]) {
+                auto const j = (size_t)renumbering.groups[&group - &workerGroups[i][0]];
+
+                group.references.renumber(renumbering.references);
+                if (groups.size() <= j)
+                    groups.resize(j + 1, Stats{});
+                groups[j] = std::move(group);
+            }
+
+            stats += workerStats[i];
+            if (spotGroup.size() < groups.size())
+                spotGroup.resize(groups.size(), Stats{});
+            for (auto const &group : groups)
+                spotGroup[&group - &groups[0]] += group;
+        }
+        processed += records;
+    }
     Input::Source::Type inputStream() {
         if (arguments.empty())
             return Input::Source::StdInType();
@@ -681,7 +837,9 @@ private:
     }
     uint64_t processed = 0;
     int multithreaded = 0;
+    int threads = 0;
     bool use_mmap = false;
+    bool native = false;
     std::optional<std::string> output;
 
     Stats stats;
@@ -0,0 +1,302 @@
+/* ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Project:
+ *  Loader QA Stats
+ *
+ * Purpose:
+ *  Read inputs directly from VDB.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <cstdint>
+
+#include <vdb.hpp>
+
+#include "input.hpp"
+
+namespace {
+
+using Cursor = VDB::Cursor;
+using RowID = Cursor::RowID;
+
+/// Hands out chunks of a table's rows to the worker threads.
+struct RowRanges {
+    std::atomic<RowID> next;
+    RowID const end;
+    RowID const chunk;
+
+    RowRanges(std::pair<RowID, RowID> const &range, unsigned threads)
+    : next(range.first)
+    , end(range.second)
+    , chunk(std::max<RowID>(1024, (range.second - range.first) / (RowID(threads) * 16)))
+    {}
+    bool get(RowID &first, RowID &last) {
+        first = next.fetch_add(chunk);
+        if (first >= end)
+            return false;
+        last = std::min(first + chunk, end);
+        return true;
+    }
+    void stop() {
+        next = end;
+    }
+};
+
+/// Run `f(worker, cursor, row)` for every row of the table, each worker has its own cursor.
+template <typename F>
+void forEachRow(VDB::Table const &table, std::vector<char const *> const &columns, unsigned threads, F &&f)
+{
+    auto ranges = RowRanges(table.read((unsigned)columns.size(), columns.data()).rowRange(), threads);
+    auto workers = std::vector<std::thread>();
+    std::exception_ptr error;
+    std::mutex mut;
+
+    for (auto i = 0u; i < threads; ++i) {
+        workers.emplace_back([&, i]() {
+            try {
+                auto const curs = table.read((unsigned)columns.size(), columns.data());
+                RowID first = 0, last = 0;
+
+                while (ranges.get(first, last)) {
+                    for (auto row = first; row < last; ++row)
+                        f(i, curs, row);
+                }
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> guard(mut);
+                if (!error)
+                    error = std::current_exception();
+                ranges.stop();
+            }
+        });
+    }
+    for (auto &th : workers)
+        th.join();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+/// READ, REF_NAME, REF_POS, REF_ORIENTATION, CIGAR_SHORT, SEQ_SPOT_GROUP
+bool alignmentRecord(Cursor const &curs, RowID row, Input &result) {
+    Input::Read read{};
+
+    result = Input{curs.read(row, 0).asString()};
+    read.start = 0;
+    read.length = (int)result.sequence.length();
+    read.type = Input::ReadType::aligned;
+    read.position = curs.read(row, 2).value<int32_t>();
+    read.orientation = curs.read(row, 3).value<uint8_t>() ? Input::ReadOrientation::reverse : Input::ReadOrientation::forward;
+    try {
+        auto iss = std::istringstream(curs.read(row, 4).asString());
+        iss >> read.cigar;
+    }
+    catch (std::ios_base::failure const &e) {
+        ((void)e);
+        return false;
+    }
+    if (read.length != read.cigar.sequenceLength())
+        return false;
+
+    read.reference = Input::getReference(curs.read(row, 1).asString());
+    auto const group = curs.read(row, 5).asString();
+    if (!group.empty())
+        result.group = Input::getGroup(group);
+    result.reads.emplace_back(std::move(read));
+    return true;
+}
+
+/// READ or CMP_READ, READ_LEN, READ_START, READ_TYPE, and PRIMARY_ALIGNMENT_ID if `compressed`.
+/// Like the text input, these records are not assigned to a spot group.
+bool sequenceRecord(Cursor const &curs, RowID row, bool compressed, Input &result) {
+    result = Input{curs.read(row, 0).asString()};
+
+    auto const len = curs.read(row, 1).asVector<uint32_t>();
+    auto const start = curs.read(row, 2).asVector<int32_t>();
+    auto const type = curs.read(row, 3).asVector<uint8_t>();
+    auto const nreads = len.size();
+    if (nreads == 0 || start.size() != nreads || type.size() != nreads)
+        return false;
+
+    auto const lengths = std::vector<int>(len.begin(), len.end());
+    auto aligned = std::vector<uint64_t>(nreads, 0);
+    if (compressed) {
+        auto const ids = curs.read(row, 4).asVector<int64_t>();
+        if (ids.size() != nreads)
+            return false;
+        std::copy(ids.begin(), ids.end(), aligned.begin());
+        Input::restoreAligned(result.sequence, lengths, aligned);
+    }
+
+    auto const seqlen = (int)result.sequence.size();
+    result.reads.reserve(nreads);
+    for (auto i = decltype(nreads)(0); i < nreads; ++i) {
+        if (lengths[i] < 0 || lengths[i] > seqlen || start[i] < 0 || start[i] + lengths[i] > seqlen)
+            return false;
+
+        auto const bio = (type[i] & 1) != 0; // SRA_READ_TYPE_BIOLOGICAL
+        auto const rev = (type[i] & 4) != 0; // SRA_READ_TYPE_REVERSE
+        result.reads.emplace_back(Input::Read{start[i], lengths[i], -1, -1
+            , aligned[i] ? Input::ReadType::aligned : bio ? Input::ReadType::biological : Input::ReadType::technical
+            , rev ? Input::ReadOrientation::reverse : Input::ReadOrientation::forward});
+    }
+    return true;
+}
+
+/// Where, in the order the text input would list them, a worker first saw each id.
+/// The key is the table's ordinal in the upper bits and the row in the lower.
+struct FirstSeen {
+    std::vector<uint64_t> references;
+    std::vector<uint64_t> groups;
+
+    static uint64_t key(unsigned table, RowID row) {
+        return (uint64_t(table) << 56) | (uint64_t(row) & ((uint64_t(1) << 56) - 1));
+    }
+    static void note(std::vector<uint64_t> &seen, int id, uint64_t key) {
+        if (id < 0)
+            return;
+        if (seen.size() <= (size_t)id)
+            seen.resize(id + 1, UINT64_MAX);
+        seen[id] = std::min(seen[id], key);
+    }
+};
+
+/// Put the names added since `base` in the order they were first seen,
+/// and return the old to new mapping of every id.
+std::vector<int> renumber(std::vector<std::string> &names, size_t base, std::vector<FirstSeen> const &workers, std::vector<uint64_t> FirstSeen::*which)
+{
+    auto seen = std::vector<uint64_t>(names.size(), UINT64_MAX);
+    for (auto const &worker : workers) {
+        auto const &mine = worker.*which;
+        for (auto i = base; i < mine.size() && i < seen.size(); ++i)
+            seen[i] = std::min(seen[i], mine[i]);
+    }
+
+    auto order = std::vector<int>();
+    for (auto i = base; i < names.size(); ++i)
+        order.push_back((int)i);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return seen[a] < seen[b]; });
+
+    auto mapping = std::vector<int>(names.size());
+    auto reordered = std::vector<std::string>();
+    reordered.reserve(names.size());
+    for (auto i = size_t(0); i < base; ++i) {
+        mapping[i] = (int)i;
+        reordered.emplace_back(std::move(names[i]));
+    }
+    for (auto const i : order) {
+        mapping[i] = (int)reordered.size();
+        reordered.emplace_back(std::move(names[i]));
+    }
+    names.swap(reordered);
+    return mapping;
+}
+
+bool hasColumn(VDB::Table const &table, char const *name) {
+    auto const columns = table.readableColumns();
+    return std::find(columns.begin(), columns.end(), name) != columns.end();
+}
+
+} // namespace
+
+bool Input::nativeAvailable() { return true; }
+
+Input::Renumbering Input::readNative(std::string const &path, unsigned threads, Consumer const &consume)
+{
+    std::atomic<uint64_t> skipped{0};
+    auto const referencesBase = references.size();
+    auto const groupsBase = groups.size();
+    auto firstSeen = std::vector<FirstSeen>(threads);
+    auto tableOrdinal = 0u;
+    auto const mgr = VDB::Manager();
+    auto const alignments = [&](VDB::Table const &table) {
+        auto const ordinal = tableOrdinal++;
+        forEachRow(table, {"READ", "REF_NAME", "REF_POS", "REF_ORIENTATION", "CIGAR_SHORT", "SEQ_SPOT_GROUP"}, threads
+                   , [&](unsigned worker, Cursor const &curs, RowID row) {
+            Input record;
+            if (alignmentRecord(curs, row, record)) {
+                auto &seen = firstSeen[worker];
+                auto const key = FirstSeen::key(ordinal, row);
+                FirstSeen::note(seen.references, record.reads[0].reference, key);
+                FirstSeen::note(seen.groups, record.group, key);
+                consume(worker, record);
+            }
+            else
+                ++skipped;
+        });
+    };
+    auto const sequences = [&](VDB::Table const &table, bool compressed) {
+        auto const columns = compressed
+                           ? std::vector<char const *>{"CMP_READ", "READ_LEN", "READ_START", "READ_TYPE", "PRIMARY_ALIGNMENT_ID"}
+                           : std::vector<char const *>{"READ", "READ_LEN", "READ_START", "READ_TYPE"};
+        forEachRow(table, columns, threads, [&](unsigned worker, Cursor const &curs, RowID row) {
+            Input record;
+            if (sequenceRecord(curs, row, compressed, record))
+                consume(worker, record);
+            else
+                ++skipped;
+        });
+    };
+
+    if (mgr.pathType(path) == VDB::Manager::ptDatabase) {
+        auto const db = mgr.openDatabase(path);
+
+        if (db.hasTable("PRIMARY_ALIGNMENT")) {
+            std::cerr << "# PRIMARY_ALIGNMENT" << std::endl;
+            alignments(db["PRIMARY_ALIGNMENT"]);
+        }
+        if (db.hasTable("SECONDARY_ALIGNMENT")) {
+            std::cerr << "# SECONDARY_ALIGNMENT" << std::endl;
+            alignments(db["SECONDARY_ALIGNMENT"]);
+        }
+        auto const seq = db["SEQUENCE"];
+        if (hasColumn(seq, "CMP_READ") && hasColumn(seq, "PRIMARY_ALIGNMENT_ID")) {
+            std::cerr << "# SEQUENCE" << std::endl;
+            sequences(seq, true);
+        }
+        else {
+            std::cerr << "# UNALIGNED" << std::endl;
+            sequences(seq, false);
+        }
+    }
+    else {
+        std::cerr << "# UNALIGNED" << std::endl;
+        sequences(mgr.openTable(path), false);
+    }
+    if (skipped > 0)
+        std::cerr << "warning: " << skipped << " unparsable records" << std::endl;
+
+    auto result = Renumbering{};
+    result.references = renumber(references, referencesBase, firstSeen, &FirstSeen::references);
+    result.groups = renumber(groups, groupsBase, firstSeen, &FirstSeen::groups);
+    return result;
+}
@@ -66,6 +66,22 @@ class prep_stm_t {
             return status;
         }
 
+        // columns with their bit set in 'num_mask' are bound as integers from 'nums'
+        int16_t bind_mixed( const str_vec& data, const std::vector< int64_t >& nums, uint32_t num_mask ) {
+            if ( ok_or_done( status ) ) {
+                for ( size_t i = 0; ok_or_done( status ) && i < data.size(); ++i ) {
+                    if ( ( num_mask & ( 1u << i ) ) != 0 ) {
+                        status = sqlite3_bind_int64( stmt, i + 1, nums[ i ] );
+                    } else {
+                        status = sqlite3_bind_text( stmt, i + 1,
+                                                    data[ i ].c_str(), data[ i ].length(),
+                                                    SQLITE_STATIC );
+                    }
+                }
+            }
+            return status;
+        }
+
         int16_t bind_str( const std::string& data ) {
             if ( ok_or_done( status ) && !data.empty() ) {
                 status = sqlite3_bind_text( stmt, 1, data.c_str(), data.length(), SQLITE_STATIC );
@@ -80,6 +96,14 @@ class prep_stm_t {
             return status;
         }
 
+        int16_t bind_mixed_and_step( const str_vec& data, const std::vector< int64_t >& nums,
+                                     uint32_t num_mask ) {
+            bind_mixed( data, nums, num_mask );
+            step();
+            reset();
+            return status;
+        }
+
         std::string read_string( uint32_t idx = 0 ) {
             const unsigned char * txt = sqlite3_column_text( stmt, idx );
             if ( nullptr != txt ) {
@@ -181,7 +205,20 @@ class database_t {
                 return exec_pragma( "synchronous=OFF" );
             }
         }
-        
+
+        // settings for a one-shot bulk-load: a crash in the middle leaves an unusable db-file
+        int16_t bulk_load( uint32_t cache_mb ) {
+            int16_t res = synchronous( false );
+            if ( ok_or_done( res ) ) { res = exec_pragma( "journal_mode=OFF" ); }
+            if ( ok_or_done( res ) ) { res = exec_pragma( "locking_mode=EXCLUSIVE" ); }
+            if ( ok_or_done( res ) ) { res = exec_pragma( "temp_store=MEMORY" ); }
+            if ( ok_or_done( res ) && cache_mb > 0 ) {
+                // a negative cache-size is in KiB instead of pages
+                res = exec_pragma( "cache_size=-" + std::to_string( (uint64_t)cache_mb * 1024 ) );
+            }
+            return res;
+        }
+
 };
 
 }; /* namespace mt_database */
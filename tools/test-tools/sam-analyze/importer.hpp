@@ -1,23 +1,49 @@
 #ifndef IMPORTER_H
 #define IMPORTER_H
 
+#include <thread>
+#include <memory>
 #include "line_split.hpp"
+#include "pipeline.hpp"
 #include "params.hpp"
 #include "result.hpp"
 #include "sam_db.hpp"
 
-class importer_t {
+/* ----------------------------------------------------------------------------
+ * one SAM-line, split into the columns of the table it goes into
+ * ---------------------------------------------------------------------------- */
+struct sam_row_t {
+    typedef enum ROW_KIND{ ROW_INVALID, ROW_REF, ROW_HDR, ROW_ALIG } ROW_KIND;
+
+    ROW_KIND kind;
+    mt_database::prep_stm_t::str_vec data;
+    std::vector< int64_t > nums;    // pre-converted INT-columns of ALIG
+    uint32_t num_mask;              // bit N set: nums[ N ] is valid
+
+    sam_row_t() : kind( ROW_INVALID ), num_mask( 0 ) {}
+};
+
+/* ----------------------------------------------------------------------------
+ * a block of lines handed from the reader to a parser and then to the inserter
+ * ---------------------------------------------------------------------------- */
+struct import_batch_t {
+    uint64_t seq;
+    std::vector< std::string > lines;
+    std::vector< sam_row_t > rows;
+
+    import_batch_t( uint64_t a_seq ) : seq( a_seq ) {}
+};
+
+typedef std::unique_ptr< import_batch_t > import_batch_ptr_t;
+
+/* ----------------------------------------------------------------------------
+ * turns lines into rows, each parser-thread has its own instance
+ * ---------------------------------------------------------------------------- */
+class sam_line_parser_t {
     private :
-        const import_params_t& params;
-        import_result_t result;
-        file_reader_t reader;
         string_parts_t line_parts;
         string_parts_t hdr_parts;
-        sam_database_t &db;
-        mt_database::prep_stm_t::str_vec data;
 
-        importer_t( const importer_t& ) = delete;
-        
         static bool StartsWith( const std::string& s, const char * p ) {
             bool res = false;
             if ( !s.empty() ) {
@@ -29,8 +55,7 @@ class importer_t {
             return res;
         }
 
-        bool hdr_ref_line( void ) {
-            bool res = false;
+        void hdr_ref_line( sam_row_t& row ) {
             std::string name, length, part;
             std::ostringstream ss;
             unsigned int ss_nr = 0;
@@ -53,48 +78,19 @@ class importer_t {
                 }
             }
             if ( !name.empty() && !length.empty() ) {
-                data . clear();
-                data . push_back( name );
-                data . push_back( length );
-                data . push_back( ss . str() );
-                int status = db . add_ref( data );
-                res = db . ok_or_done( status );
+                row . kind = sam_row_t::ROW_REF;
+                row . data . push_back( name );
+                row . data . push_back( length );
+                row . data . push_back( ss . str() );
             }
-            return res;
         }
 
-        bool header_line( const std::string& a_line ) {
-            bool res = true;
-            if ( ( result . header_lines % params . cmn . transaction_size ) == 0 ) {
-                db . commit_transaction();
-                db . begin_transaction();
-                if ( params . cmn . progress ) { std::cerr << '.'; }
-            }
-            if ( StartsWith( a_line, "@SQ" ) ) {
-                line_parts . split( a_line );
-                res = hdr_ref_line();
-            } else {
-                data . clear();
-                data . push_back( a_line );
-                res = db . ok_or_done( db . add_hdr( data ) );
-            }
-            if ( res ) { result . header_lines += 1; }
-            return res;
-        }
-
-        bool alignment_line( const std::string& a_line ) {
-            if ( ( result . alignment_lines % params . cmn . transaction_size ) == 0 ) {
-                db.commit_transaction();
-                db.begin_transaction();
-                if ( params . cmn . progress ) { std::cerr << '.'; }
-            }
-            line_parts . split( a_line );
-            data . clear();
+        void alignment_line( sam_row_t& row ) {
             // copy the fields QNAME ... QUAL ( 11 of them ) + collect TAGS into one
             std::string tags;
             for ( size_t i = 0; i < line_parts.size(); ++i ) {
                 if ( i < 11 ) { 
-                    data . push_back( line_parts . get( i ) );
+                    row . data . push_back( line_parts . get( i ) );
                 } else {
                     if ( tags . empty() ) {
                         tags = line_parts . get( i );
@@ -104,56 +100,232 @@ class importer_t {
                     }
                 }
             }
-            data . push_back( tags );
-            int status = db . add_alig( data );
-            bool res = db . ok_or_done( status );
-            if ( res ) { result . alignment_lines += 1; }
-            return res;
+            // short lines: bind empty values instead of leftovers from the previous row
+            row . data . resize( 11 );
+            row . data . push_back( tags );
+            row . kind = sam_row_t::ROW_ALIG;
+            // FLAG, RPOS, MAPQ, MRPOS, TLEN: convert here, not inside of sqlite in the inserter
+            row . nums . resize( 11 );
+            for ( size_t i : { 1, 3, 4, 7, 8 } ) {
+                if ( to_int( row . data[ i ], row . nums[ i ] ) ) {
+                    row . num_mask |= ( 1u << i );
+                }
+            }
         }
 
-        bool synchronous( bool on ) {
-            return db . ok_or_done( db . synchronous( on ) );
+        /* only canonical decimals ( what sqlite's INT-affinity would turn into
+           the very same integer ), everything else is left to sqlite as text */
+        static bool to_int( const std::string& s, int64_t& value ) {
+            size_t i = 0;
+            bool neg = ( !s . empty() && s[ 0 ] == '-' );
+            if ( neg ) { i++; }
+            size_t digits = s . size() - i;
+            if ( digits == 0 || digits > 18 ) { return false; }
+            if ( s[ i ] == '0' && ( digits > 1 || neg ) ) { return false; }
+            int64_t v = 0;
+            for ( ; i < s . size(); ++i ) {
+                char c = s[ i ];
+                if ( c < '0' || c > '9' ) { return false; }
+                v = v * 10 + ( c - '0' );
+            }
+            value = neg ? -v : v;
+            return true;
         }
 
-        bool import_lines( void ) {
+    public :
+        sam_line_parser_t() : line_parts( '\t' ), hdr_parts( ':' ) {}
+
+        void parse( const std::string& line, sam_row_t& row ) {
+            row . kind = sam_row_t::ROW_INVALID;
+            row . data . clear();
+            row . num_mask = 0;
+            if ( StartsWith( line, "@" ) ) {
+                if ( StartsWith( line, "@SQ" ) ) {
+                    line_parts . split( line );
+                    hdr_ref_line( row );
+                } else {
+                    row . kind = sam_row_t::ROW_HDR;
+                    row . data . push_back( line );
+                }
+            } else {
+                line_parts . split( line );
+                alignment_line( row );
+            }
+        }
+};
+
+/* ----------------------------------------------------------------------------
+ * reader-thread --> N parser-threads --> reorder-buffer --> this thread ( inserter )
+ * only the inserter touches the database, the rows keep the order of the file
+ * ---------------------------------------------------------------------------- */
+class importer_t {
+    private :
+        static const size_t BATCH_LINES = 4096;
+
+        const import_params_t& params;
+        import_result_t result;
+        file_reader_t reader;
+        sam_database_t &db;
+        uint32_t thread_count;
+        batch_queue_t< import_batch_ptr_t > to_parse;
+        reorder_buffer_t< import_batch_ptr_t > to_insert;
+        std::mutex timer_mtx;
+        phase_timer_t read_timer;
+        phase_timer_t parse_timer;
+        phase_timer_t insert_timer;
+        phase_timer_t index_timer;
+        phase_timer_t total_timer;
+        uint64_t rows_in_transaction;
+
+        importer_t( const importer_t& ) = delete;
+
+        void read_lines( void ) {
+            uint64_t seq = 0;
+            bool more = true;
+            while ( more && to_insert . admit( seq ) ) {
+                import_batch_ptr_t batch( new import_batch_t( seq++ ) );
+                batch -> lines . reserve( BATCH_LINES );
+                read_timer . start();
+                while ( more && batch -> lines . size() < BATCH_LINES ) {
+                    batch -> lines . emplace_back();
+                    more = reader . next( batch -> lines . back() );
+                    if ( !more ) { batch -> lines . pop_back(); }
+                }
+                read_timer . stop( batch -> lines . size() );
+                if ( !to_parse . put( std::move( batch ) ) ) { more = false; }
+            }
+            to_parse . close();
+        }
+
+        void parse_lines( void ) {
+            sam_line_parser_t parser;
+            phase_timer_t timer;
+            import_batch_ptr_t batch;
+            while ( to_parse . get( batch ) ) {
+                timer . start();
+                batch -> rows . resize( batch -> lines . size() );
+                for ( size_t i = 0; i < batch -> lines . size(); ++i ) {
+                    parser . parse( batch -> lines[ i ], batch -> rows[ i ] );
+                }
+                timer . stop( batch -> rows . size() );
+                uint64_t seq = batch -> seq;
+                to_insert . put( seq, std::move( batch ) );
+            }
+            to_insert . producer_done();
+            std::unique_lock< std::mutex > lock( timer_mtx );
+            parse_timer . merge( timer );
+        }
+
+        bool insert_row( const sam_row_t& row ) {
+            int status = SQLITE_ERROR;
+            switch( row . kind ) {
+                case sam_row_t::ROW_REF  : status = db . add_ref( row . data ); break;
+                case sam_row_t::ROW_HDR  : status = db . add_hdr( row . data ); break;
+                case sam_row_t::ROW_ALIG : status = db . add_alig( row . data, row . nums, row . num_mask ); break;
+                default : break;
+            }
+            bool res = db . ok_or_done( status );
+            if ( res ) {
+                if ( sam_row_t::ROW_ALIG == row . kind ) {
+                    result . alignment_lines += 1;
+                } else {
+                    result . header_lines += 1;
+                }
+                if ( ++rows_in_transaction >= params . cmn . transaction_size ) {
+                    db . commit_transaction();
+                    db . begin_transaction();
+                    rows_in_transaction = 0;
+                    if ( params . cmn . progress ) { std::cerr << '.'; }
+                }
+            }
+            return res;
+        }
+
+        bool insert_rows( void ) {
             bool ok = ( SQLITE_OK == db . begin_transaction() );
+            bool done = false;
             bool has_align_limit = params . align_limit > 0;
-            std::string line;
-            while ( ok && reader . next( line ) ) {
-                if ( StartsWith( line, "@" ) ) {
-                    ok = header_line( line );
-                } else {
-                    if ( has_align_limit ) {
-                        if ( result . alignment_lines >= params . align_limit ) break;
+            import_batch_ptr_t batch;
+            while ( ok && !done && to_insert . get( batch ) ) {
+                uint64_t inserted = 0;
+                insert_timer . start();
+                for ( auto it = batch -> rows . begin(); ok && it != batch -> rows . end(); ++it ) {
+                    result . total_lines += 1;
+                    if ( has_align_limit && sam_row_t::ROW_ALIG == it -> kind ) {
+                        if ( result . alignment_lines >= params . align_limit ) {
+                            done = true;
+                            break;
+                        }
                     }
-                    ok = alignment_line( line );
+                    ok = insert_row( *it );
+                    if ( ok ) { inserted++; }
                 }
+                insert_timer . stop( inserted );
             }
             if ( params . cmn . progress ) { std::cerr << std::endl; }
             if ( ok ) { ok = db . ok_or_done( db . commit_transaction() ); }
             return ok;
         }
 
+        bool import_lines( void ) {
+            std::vector< std::thread > threads;
+            threads . emplace_back( &importer_t::read_lines, this );
+            for ( uint32_t i = 0; i < thread_count; ++i ) {
+                threads . emplace_back( &importer_t::parse_lines, this );
+            }
+            bool ok = insert_rows();
+            // stop the reader/parsers if we quit early ( error or alignment-limit )
+            to_insert . close();
+            to_parse . close();
+            for ( auto& t : threads ) { t . join(); }
+            return ok;
+        }
+
+        static void report_phase( const char * name, const phase_timer_t& timer ) {
+            std::cerr << "\t" << name << " : " << base_result_t::with_ths( timer . get_rows() )
+                      << " rows in " << timer . seconds() << " s = "
+                      << base_result_t::with_ths( (uint64_t)timer . rows_per_sec() )
+                      << " rows/s" << std::endl;
+        }
+
+        void report_bench( void ) {
+            std::cerr << "BENCHMARK:" << std::endl;
+            report_phase( "read  ", read_timer );
+            report_phase( "parse ", parse_timer );
+            std::cerr << "\t         ( busy-time summed over " << thread_count << " parser-threads )" << std::endl;
+            report_phase( "insert", insert_timer );
+            report_phase( "index ", index_timer );
+            report_phase( "total ", total_timer );
+        }
+
     public :
         importer_t( sam_database_t& a_db, const import_params_t& a_params )
             : params( a_params ),
               reader( a_params . import_filename ),
-              line_parts( '\t' ),
-              hdr_parts( ':' ),
-              db( a_db ) {
+              db( a_db ),
+              thread_count( a_params . parse_threads > 0 ? a_params . parse_threads : 1 ),
+              to_parse( 2 * thread_count ),
+              to_insert( thread_count, 4 * thread_count ),
+              rows_in_transaction( 0 ) {
             db . drop_all();
         }
               
         bool run( void ) {
             if ( params . cmn . report ) { std::cerr << "IMPORT:" << std::endl;  }
-            bool ok = synchronous( false );
+            total_timer . start();
+            bool ok = db . ok_or_done( db . bulk_load( params . cache_mb ) );
             // this takes a while
             if ( ok ) { ok = import_lines(); }
-            // create the name-index on the ALIG table
-            if ( ok ) { ok = db . ok_or_done( db . create_alig_tbl_idx() ); }
-            result . total_lines = reader . get_line_nr();
+            // create the indices on the ALIG table after all rows are in
+            if ( ok ) {
+                index_timer . start();
+                ok = db . ok_or_done( db . create_alig_tbl_idx() );
+                index_timer . stop( result . alignment_lines );
+            }
+            total_timer . stop( result . header_lines + result . alignment_lines );
             result . success =  ok;
             if ( params . cmn . report ) { result . report(); }
+            if ( params . bench ) { report_bench(); }
             return result . success;
         }
 };
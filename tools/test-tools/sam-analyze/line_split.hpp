@@ -78,12 +78,18 @@ class string_parts_t {
     public:
         string_parts_t( char a_delim ) : delim( a_delim ) {}
 
+        // same result as getline() in a loop, without the stringstream
         int split( const std::string& s ) {
-            std::stringstream ss( s );
-            std::string item;
             v . clear();
-            while( getline( ss, item, delim ) ) {
-                v . push_back( item );
+            size_t start = 0;
+            while ( start < s . size() ) {
+                size_t pos = s . find( delim, start );
+                if ( pos == std::string::npos ) {
+                    v . emplace_back( s, start );
+                    break;
+                }
+                v . emplace_back( s, start, pos - start );
+                start = pos + 1;
             }
             return v.size();
         }
@@ -91,7 +97,7 @@ class string_parts_t {
         size_t size( void ) const { return v . size(); }
         
         std::string& get( uint16_t idx ) {
-            if ( idx > v . size() ) { return empty; }
+            if ( idx >= v . size() ) { return empty; }
             return v[ idx ];
         }
 };
@@ -55,7 +55,7 @@ struct cmn_params_t {
 
     cmn_params_t( const args_t& args ) :
         db_filename( args . get_str( "-d", "--db", "sam.db" ) ),
-        transaction_size( args . get_int<uint32_t>( "-t", "--trans", 50000 ) ),
+        transaction_size( args . get_int<uint32_t>( "-t", "--trans", 500000 ) ),
         help( args . has( "-h", "--help" ) ),
         report( args . has( "-r", "--report" ) ),
         progress( args . has( "-p", "--progress" ) ) { 
@@ -78,7 +78,7 @@ struct cmn_params_t {
         std::cout << "\t-h --help ... show this help-text" << std::endl;
         std::cout <<  std::endl;
         std::cout << "\t-d=file --db=file ....... sqlite3-database for storage ( can be ':memory:' ), dflf:none" << std::endl;        
-        std::cout << "\t-t=count --trans=count .. transaction size for writing to sqlite3-db ( dflt: 50,000 )" << std::endl;
+        std::cout << "\t-t=count --trans=count .. transaction size for writing to sqlite3-db ( dflt: 500,000 )" << std::endl;
         std::cout << "\t-r --report ............. produce report about import/analysis/export on stderr" << std::endl;
         std::cout << "\t-p --progress ........... show progress of import/export on stderr" << std::endl;
     }
@@ -88,11 +88,17 @@ struct import_params_t {
     const cmn_params_t &cmn;
     const std::string import_filename;
     const uint64_t align_limit;
+    const uint32_t parse_threads;
+    const uint32_t cache_mb;
+    const bool bench;
 
     import_params_t( const args_t& args, const cmn_params_t& a_cmn ) :
         cmn( a_cmn ),
         import_filename( args . get_str( "-i", "--import" ) ),
-        align_limit( args . get_int< uint64_t >( "-l", "--import-alig" ) ) { 
+        align_limit( args . get_int< uint64_t >( "-l", "--import-alig" ) ),
+        parse_threads( args . get_int< uint32_t >( "-j", "--threads", 2 ) ),
+        cache_mb( args . get_int< uint32_t >( "-C", "--cache", 1024 ) ),
+        bench( args . has( "-b", "--bench" ) ) {
     }
 
     static void populate_hints( args_t::str_vec_t& hints ) {
@@ -100,6 +106,10 @@ struct import_params_t {
         hints . push_back( "--import" );        
         hints . push_back( "-l" );
         hints . push_back( "--import-alig" );        
+        hints . push_back( "-j" );
+        hints . push_back( "--threads" );
+        hints . push_back( "-C" );
+        hints . push_back( "--cache" );
     }
 
     void show_report( void ) const {
@@ -107,6 +117,9 @@ struct import_params_t {
         if ( align_limit > 0 ) {
             std::cerr << "align-limit   : " << align_limit << std::endl;
         }
+        std::cerr << "parse-threads : " << parse_threads << std::endl;
+        std::cerr << "cache-size    : " << cache_mb << " MB" << std::endl;
+        std::cerr << "benchmark     : " << base_params_t::yes_no( bench ) << std::endl;
     }
 
     bool requested( void ) const { return ! import_filename . empty (); }
@@ -125,6 +138,9 @@ struct import_params_t {
     void show_help( void ) const {
         std::cout << "\t-i=file --import=file ... import from this SAM-file ( can be 'stdin' )" << std::endl;
         std::cout << "\t-l=count --import-alig=count ... limit number of alignments to import" << std::endl;        
+        std::cout << "\t-j=count --threads=count ....... number of SAM-parser threads ( dflt: 2 )" << std::endl;
+        std::cout << "\t-C=MB --cache=MB ............... sqlite3 page-cache during import ( dflt: 1024 )" << std::endl;
+        std::cout << "\t-b --bench ..................... report rows/s for each import-phase on stderr" << std::endl;
     }
 };
 
@@ -0,0 +1,151 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <chrono>
+
+/* ----------------------------------------------------------------------------
+ * bounded FIFO between the pipeline-stages:
+ * put() blocks if the queue is full, get() blocks if the queue is empty
+ * after close() get() drains what is left and then returns false
+ * ---------------------------------------------------------------------------- */
+template < typename T > class batch_queue_t {
+    private :
+        std::mutex mtx;
+        std::condition_variable not_empty;
+        std::condition_variable not_full;
+        std::deque< T > items;
+        size_t capacity;
+        bool closed;
+
+        batch_queue_t( const batch_queue_t& ) = delete;
+
+    public :
+        batch_queue_t( size_t a_capacity ) : capacity( a_capacity ), closed( false ) {}
+
+        bool put( T&& item ) {
+            std::unique_lock< std::mutex > lock( mtx );
+            not_full . wait( lock, [ this ]{ return closed || items . size() < capacity; } );
+            if ( closed ) { return false; }
+            items . push_back( std::move( item ) );
+            not_empty . notify_one();
+            return true;
+        }
+
+        bool get( T& item ) {
+            std::unique_lock< std::mutex > lock( mtx );
+            not_empty . wait( lock, [ this ]{ return closed || !items . empty(); } );
+            if ( items . empty() ) { return false; }
+            item = std::move( items . front() );
+            items . pop_front();
+            not_full . notify_one();
+            return true;
+        }
+
+        void close( void ) {
+            std::unique_lock< std::mutex > lock( mtx );
+            closed = true;
+            not_empty . notify_all();
+            not_full . notify_all();
+        }
+};
+
+/* ----------------------------------------------------------------------------
+ * the parser-threads finish their batches in any order,
+ * the single consumer takes them out strictly by sequence-number
+ * admit() keeps the producer from running more than 'window' batches ahead
+ * ---------------------------------------------------------------------------- */
+template < typename T > class reorder_buffer_t {
+    private :
+        std::mutex mtx;
+        std::condition_variable changed;
+        std::map< uint64_t, T > items;
+        uint64_t next_seq;
+        uint64_t window;
+        uint64_t producers;
+        bool closed;
+
+        reorder_buffer_t( const reorder_buffer_t& ) = delete;
+
+    public :
+        reorder_buffer_t( uint64_t a_producers, uint64_t a_window )
+            : next_seq( 0 ), window( a_window ), producers( a_producers ), closed( false ) {}
+
+        bool admit( uint64_t seq ) {
+            std::unique_lock< std::mutex > lock( mtx );
+            changed . wait( lock, [ this, seq ]{ return closed || seq < next_seq + window; } );
+            return !closed;
+        }
+
+        void put( uint64_t seq, T&& item ) {
+            std::unique_lock< std::mutex > lock( mtx );
+            if ( closed ) { return; }
+            items . emplace( seq, std::move( item ) );
+            if ( seq == next_seq ) { changed . notify_all(); }
+        }
+
+        // a producer is done, if all of them are done get() returns false when empty
+        void producer_done( void ) {
+            std::unique_lock< std::mutex > lock( mtx );
+            if ( producers > 0 ) { producers--; }
+            changed . notify_all();
+        }
+
+        bool get( T& item ) {
+            std::unique_lock< std::mutex > lock( mtx );
+            changed . wait( lock, [ this ]{
+                return closed || producers == 0 || items . find( next_seq ) != items . end(); } );
+            auto found = items . find( next_seq );
+            if ( closed || found == items . end() ) { return false; }
+            item = std::move( found -> second );
+            items . erase( found );
+            next_seq++;
+            changed . notify_all();
+            return true;
+        }
+
+        // the consumer gives up: wake everybody, drop what is pending
+        void close( void ) {
+            std::unique_lock< std::mutex > lock( mtx );
+            closed = true;
+            items . clear();
+            changed . notify_all();
+        }
+};
+
+/* ----------------------------------------------------------------------------
+ * accumulates the busy-time and the rows processed by one phase of the import
+ * ---------------------------------------------------------------------------- */
+class phase_timer_t {
+    private :
+        typedef std::chrono::steady_clock clock_t;
+        clock_t::time_point started;
+        std::chrono::nanoseconds elapsed;
+        uint64_t rows;
+
+    public :
+        phase_timer_t() : elapsed( 0 ), rows( 0 ) {}
+
+        void start( void ) { started = clock_t::now(); }
+        void stop( uint64_t a_rows = 0 ) {
+            elapsed += std::chrono::duration_cast< std::chrono::nanoseconds >( clock_t::now() - started );
+            rows += a_rows;
+        }
+
+        void merge( const phase_timer_t& other ) {
+            elapsed += other . elapsed;
+            rows += other . rows;
+        }
+
+        uint64_t get_rows( void ) const { return rows; }
+        double seconds( void ) const { return elapsed . count() / 1e9; }
+        double rows_per_sec( void ) const {
+            double s = seconds();
+            return s > 0.0 ? rows / s : 0.0;
+        }
+};
+
+#endif
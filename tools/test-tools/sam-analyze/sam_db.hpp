@@ -128,6 +128,14 @@ class sam_database_t : public mt_database::database_t {
             return status;
         }
 
+        int16_t add_alig( const mt_database::prep_stm_t::str_vec& data,
+                          const std::vector< int64_t >& nums, uint32_t num_mask ) {
+            if ( ok_or_done( status ) ) {
+                status = ins_alig_stm -> bind_mixed_and_step( data, nums, num_mask );
+            }
+            return status;
+        }
+
         uint64_t alig_count( void ) {
             return select_number( "SELECT count(*) FROM ALIG;" );            
         }
@@ -32,6 +32,9 @@
 #include <fstream>
 #include <utility>
 #include <map>
+#include <vector>
+#include <thread>
+#include <exception>
 
 namespace VDB {
     namespace C {
@@ -39,6 +42,7 @@ namespace VDB {
 #include <vdb/database.h>
 #include <vdb/table.h>
 #include <vdb/cursor.h>
+#include <vdb/blob.h>
 #include <vdb/schema.h>
     }
     class Manager;
@@ -87,13 +91,49 @@ namespace VDB {
             return strm;
         }
     };
+    /* non-owning view of the elements of a cell
+       valid as long as the cell it came from: until the next read on the same cursor,
+       or until the callback of foreachBlob()/parallel_foreach() returns */
+    template <typename T> class Span {
+        T const *first;
+        size_t count;
+    public:
+        Span() : first(nullptr), count(0) {}
+        Span(T const *data, size_t size) : first(data), count(size) {}
+        
+        T const *data() const { return first; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        T const *begin() const { return first; }
+        T const *end() const { return first + count; }
+        T const &operator [](size_t i) const { return first[i]; }
+    };
     class Cursor {
         friend class Table;
         C::VCursor *const o;
     protected:
         unsigned const N;
+        std::vector<std::string> names; ///< empty if the cursor can not be cloned
         
         Cursor(C::VCursor *const o_, unsigned columns_) :o(o_), N(columns_) {}
+        Cursor(C::VCursor *const o_, std::vector<std::string> const &names_) :o(o_), N(unsigned(names_.size())), names(names_) {}
+        
+        static Cursor open(C::VTable const *tbl, std::vector<std::string> const &fields)
+        {
+            C::VCursor const *curs = 0;
+            auto rc = C::VTableCreateCursorRead(tbl, &curs);
+            if (rc) throw Error(rc, __FILE__, __LINE__);
+            
+            for (auto && field : fields) {
+                uint32_t cid = 0;
+                
+                rc = C::VCursorAddColumn(curs, &cid, "%s", field.c_str());
+                if (rc) throw Error(rc, __FILE__, __LINE__);
+            }
+            rc = C::VCursorOpen(curs);
+            if (rc) throw Error(rc, __FILE__, __LINE__);
+            return Cursor(const_cast<C::VCursor *>(curs), fields);
+        }
     public:
         using RowID = int64_t;
         struct Data {
@@ -176,6 +216,12 @@ namespace VDB {
                 else
                     throw std::logic_error("bad cast");
             }
+            template <typename T> Span<T> span() const {
+                if (elem_bits == sizeof(T) * 8)
+                    return Span<T>((T const *)data, elements);
+                else
+                    throw std::logic_error("bad cast");
+            }
             template <typename T> T value() const {
                 if (elem_bits == sizeof(T) * 8 && elements == 1)
                     return *(T *)data;
@@ -183,7 +229,7 @@ namespace VDB {
                     throw std::logic_error("bad cast");
             }
         };
-        Cursor(Cursor const &other) :o(other.o), N(other.N) { C::VCursorAddRef(o); }
+        Cursor(Cursor const &other) :o(other.o), N(other.N), names(other.names) { C::VCursorAddRef(o); }
         ~Cursor() { C::VCursorRelease(o); }
         unsigned columns() const { return N; }
         
@@ -254,6 +300,138 @@ namespace VDB {
             }
             return rows;
         }
+        
+        /// a new cursor on the same table and columns, e.g. for another thread
+        Cursor clone() const
+        {
+            if (names.size() != N)
+                throw std::logic_error("cursor was not made by Table::read, can not clone");
+            
+            C::VTable const *tbl = 0;
+            auto const rc = C::VCursorOpenParentRead(o, &tbl);
+            if (rc) throw Error(rc, __FILE__, __LINE__);
+            try {
+                auto curs = open(tbl, names);
+                C::VTableRelease(tbl);
+                return curs;
+            }
+            catch (...) {
+                C::VTableRelease(tbl);
+                throw;
+            }
+        }
+        
+        /// rows [first, last) a blob at a time: each column's blob is looked up once
+        /// and the cells are taken out of it instead of going through the cursor per row.
+        /// the values handed to f point into the blobs and are valid until f returns.
+        /// unlike foreach a failed read throws
+        template <typename F>
+        uint64_t foreachBlob(RowID const first, RowID const last, F f) const {
+            struct Blobs {
+                std::vector<C::VBlob const *> blob;
+                std::vector<RowID> end;
+                
+                Blobs(unsigned n) : blob(n, nullptr), end(n, 0) {}
+                ~Blobs() { for (auto && b : blob) C::VBlobRelease(b); }
+            } blobs(N);
+            auto data = std::vector<RawData>(N);
+            uint64_t rows = 0;
+            
+            for (auto i = first; i < last; ++i) {
+                for (unsigned j = 0; j < N; ++j) {
+                    if (blobs.blob[j] == nullptr || i >= blobs.end[j]) {
+                        C::VBlobRelease(blobs.blob[j]);
+                        blobs.blob[j] = nullptr;
+                        
+                        int64_t blobFirst = 0;
+                        uint64_t blobCount = 0;
+                        auto rc = C::VCursorGetBlobDirect(o, &blobs.blob[j], i, j + 1);
+                        if (rc == 0)
+                            rc = C::VBlobIdRange(blobs.blob[j], &blobFirst, &blobCount);
+                        if (rc) throw Error(rc, __FILE__, __LINE__);
+                        blobs.end[j] = blobFirst + RowID(blobCount);
+                    }
+                    
+                    void const *base = 0;
+                    uint32_t count = 0;
+                    uint32_t boff = 0;
+                    uint32_t elem_bits = 0;
+                    auto const rc = C::VBlobCellData(blobs.blob[j], i, &elem_bits, &base, &boff, &count);
+                    if (rc) throw Error(rc, __FILE__, __LINE__);
+                    
+                    data[j].data = base;
+                    data[j].elem_bits = elem_bits;
+                    data[j].elements = count;
+                }
+                f(i, data);
+                ++rows;
+            }
+            return rows;
+        }
+        template <typename F>
+        uint64_t foreachBlob(F f) const {
+            auto const range = rowRange();
+            return foreachBlob(range.first, range.second, f);
+        }
+        
+        /// splits the row range into 'threads' consecutive parts (0 = one per core)
+        /// and reads each part on its own thread with its own cursor, a blob at a time.
+        /// f(ACC &, RowID, std::vector<RawData> const &) accumulates into the part's ACC,
+        /// reduce(ACC &total, ACC const &part) merges the parts in row order.
+        /// the first exception thrown on any of the threads is rethrown here
+        template <typename ACC, typename F, typename R>
+        ACC parallel_foreach(unsigned threads, F f, R reduce) const {
+            auto const range = rowRange();
+            uint64_t const count = range.second - range.first;
+            
+            if (threads == 0)
+                threads = std::thread::hardware_concurrency();
+            if (threads == 0)
+                threads = 1;
+            if (count < threads)
+                threads = count == 0 ? 1 : unsigned(count);
+            
+            auto parts = std::vector<ACC>(threads);
+            auto errors = std::vector<std::exception_ptr>(threads);
+            auto run = [&](unsigned part, Cursor const *curs) {
+                try {
+                    auto const first = range.first + RowID(count * part / threads);
+                    auto const last = range.first + RowID(count * (part + 1) / threads);
+                    ACC &acc = parts[part];
+                    curs->foreachBlob(first, last, [&](RowID row, std::vector<RawData> const &values) {
+                        f(acc, row, values);
+                    });
+                }
+                catch (...) {
+                    errors[part] = std::current_exception();
+                }
+            };
+            
+            if (threads == 1) {
+                run(0, this);
+            }
+            else {
+                auto cursors = std::vector<Cursor>();
+                cursors.reserve(threads - 1);
+                for (unsigned i = 1; i < threads; ++i)
+                    cursors.push_back(clone());
+                
+                auto workers = std::vector<std::thread>();
+                for (unsigned i = 1; i < threads; ++i)
+                    workers.emplace_back(run, i, &cursors[i - 1]);
+                run(0, this);
+                for (auto && w : workers)
+                    w.join();
+            }
+            for (auto && e : errors) {
+                if (e) std::rethrow_exception(e);
+            }
+            
+            ACC total = std::move(parts[0]);
+            for (unsigned i = 1; i < threads; ++i)
+                reduce(total, parts[i]);
+            return total;
+        }
         void *save(RowID const row, void *const dst, void const *const end) const {
             auto out = dst;
             for (auto i = 0; i < N; ++i) {
@@ -501,40 +679,12 @@ namespace VDB {
         
         Cursor read(unsigned const N, char const *const fields[]) const
         {
-            unsigned n = 0;
-            C::VCursor const *curs = 0;
-            auto rc = C::VTableCreateCursorRead(o, &curs);
-            if (rc) throw Error(rc, __FILE__, __LINE__);
-            
-            for (unsigned i = 0; i < N; ++i) {
-                uint32_t cid = 0;
-                
-                rc = C::VCursorAddColumn(curs, &cid, "%s", fields[i]);
-                if (rc) throw Error(rc, __FILE__, __LINE__);
-                ++n;
-            }
-            rc = C::VCursorOpen(curs);
-            if (rc) throw Error(rc, __FILE__, __LINE__);
-            return Cursor(const_cast<C::VCursor *>(curs), n);
+            return Cursor::open(o, std::vector<std::string>(fields, fields + N));
         }
         
         Cursor read(std::initializer_list<char const *> const &fields) const
         {
-            unsigned n = 0;
-            C::VCursor const *curs = 0;
-            auto rc = C::VTableCreateCursorRead(o, &curs);
-            if (rc) throw Error(rc, __FILE__, __LINE__);
-            
-            for (auto && field : fields) {
-                uint32_t cid = 0;
-                
-                rc = C::VCursorAddColumn(curs, &cid, "%s", field);
-                if (rc) throw Error(rc, __FILE__, __LINE__);
-                ++n;
-            }
-            rc = C::VCursorOpen(curs);
-            if (rc) throw Error(rc, __FILE__, __LINE__);
-            return Cursor(const_cast<C::VCursor *>(curs), n);
+            return Cursor::open(o, std::vector<std::string>(fields.begin(), fields.end()));
         }
     };
     class Database {
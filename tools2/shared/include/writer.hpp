@@ -38,6 +38,15 @@
 
 namespace VDB {
     class Writer {
+    public:
+        /// the version stamped on the stream header;
+        /// only rowsProtocol streams may use values() and closeRows(),
+        /// which general-loaders older than version 3 cannot read
+        enum Protocol {
+            defaultProtocol = 2,
+            rowsProtocol = 3
+        };
+    private:
         enum EventCode {
             badEvent = 0,
             errMessage,
@@ -75,9 +84,13 @@ namespace VDB {
             addMbrTbl, // ???
 
             logMesg,
-            progressMesg
+            progressMesg,
+
+            cellRows,
+            nextRows
         };
         FILE *stream;
+        Protocol protocol;
 
         class Version {
             int major = 0;
@@ -99,6 +112,8 @@ namespace VDB {
         
         class StreamHeader {
             friend Writer;
+            uint32_t version;
+
             bool write(FILE *const stream) const
             {
                 struct h {
@@ -107,11 +122,11 @@ namespace VDB {
                     uint32_t version;
                     uint32_t size;
                     uint32_t packing;
-                } const h = { { 'N', 'C', 'B', 'I', 'g', 'n', 'l', 'd' }, 1, 2, sizeof(struct h), 0 };
+                } const h = { { 'N', 'C', 'B', 'I', 'g', 'n', 'l', 'd' }, 1, version, sizeof(struct h), 0 };
                 return fwrite(&h, sizeof(h), 1, stream) == 1;
             }
         public:
-            StreamHeader() {};
+            StreamHeader(uint32_t const version_) : version(version_) {};
         };
         
         class SimpleEvent {
@@ -281,11 +296,31 @@ namespace VDB {
         {
             return write(code, cid, (uint32_t)data.size(), (uint32_t)sizeof(std::string::value_type), data.data());
         }
+        bool writeRows(unsigned const cid, uint32_t const rows, uint32_t const *lengths, uint32_t const elsize, void const *data) const
+        {
+            uint32_t const eid = (cellRows << 24) + cid;
+            uint32_t const zero = 0;
+            uint64_t total = 0;
+            for (uint32_t i = 0; i < rows; ++i)
+                total += lengths[i];
+            if (total > UINT32_MAX)
+                return false;
+            auto const count = uint32_t(total);
+            auto const size = uint64_t(elsize) * count;
+            auto const padding = (4 - (size & 3)) & 3;
+            return fwrite(&eid, sizeof(eid), 1, stream) == 1
+                && fwrite(&rows, sizeof(rows), 1, stream) == 1
+                && fwrite(&count, sizeof(count), 1, stream) == 1
+                && fwrite(lengths, sizeof(lengths[0]), rows, stream) == rows
+                && fwrite(data, elsize, count, stream) == count
+                && fwrite(&zero, 1, padding, stream) == padding;
+        }
     public:
-        Writer(FILE *const stream_)
+        Writer(FILE *const stream_, Protocol const protocol_ = defaultProtocol)
         : stream(stream_)
+        , protocol(protocol_)
         {
-            StreamHeader().write(stream);
+            StreamHeader(protocol).write(stream);
         }
 
         bool logMessage(std::string const &message) const
@@ -373,6 +408,22 @@ namespace VDB {
         {
             return SimpleEvent(nextRow, tid).write(stream);
         }
+
+        /// the cells of 'rows' consecutive rows of one column, see closeRows
+        bool values(unsigned const cid, uint32_t const rows, uint32_t const *lengths, uint32_t const elsize, void const *data) const
+        {
+            return protocol == rowsProtocol && (rows == 0 || writeRows(cid, rows, lengths, elsize, data));
+        }
+
+        /// commits the rows sent by values() for each column of the table
+        bool closeRows(unsigned const tid, uint64_t const rows) const
+        {
+            uint32_t const eid = (nextRows << 24) + tid;
+            return protocol == rowsProtocol
+                && (rows == 0
+                 || (fwrite(&eid, sizeof(eid), 1, stream) == 1
+                  && fwrite(&rows, sizeof(rows), 1, stream) == 1));
+        }
         
         enum MetaNodeRoot {
             database, table, column
@@ -409,11 +460,15 @@ private:
     ColumnID nextColumn;
     Tables tables;
 public:
+    using VDB::Writer::Protocol;
+    using VDB::Writer::defaultProtocol;
+    using VDB::Writer::rowsProtocol;
     using VDB::Writer::destination;
     using VDB::Writer::schema;
     using VDB::Writer::info;
     using VDB::Writer::beginWriting;
     using VDB::Writer::closeRow;
+    using VDB::Writer::closeRows;
     using VDB::Writer::setMetadata;
     using VDB::Writer::endWriting;
     using VDB::Writer::flush;
@@ -454,6 +509,9 @@ public:
         bool closeRow() const {
             return parent.closeRow(table);
         }
+        bool closeRows(uint64_t rows) const {
+            return parent.closeRows(table, rows);
+        }
         bool setMetadata(std::string const &name, std::string const &value) const {
             return parent.setMetadata(VDB::Writer::table, table, name, value);
         }
@@ -488,6 +546,13 @@ public:
             return parent.value(columnNumber, 0, "");
         }
         template <typename T>
+        bool setValues(unsigned rows, uint32_t const *lengths, T const *data) const {
+            return parent.values(columnNumber, uint32_t(rows), lengths, uint32_t(sizeof(T)), data);
+        }
+        bool setValues(unsigned rows, uint32_t const *lengths, unsigned elsize, void const *data) const {
+            return parent.values(columnNumber, uint32_t(rows), lengths, uint32_t(elsize), data);
+        }
+        template <typename T>
         bool setDefault(T const &data) const {
             return parent.defaultValue(columnNumber, data);
         }
@@ -513,8 +578,8 @@ public:
         return Table(*this, t);
     }
     
-    Writer2(FILE *const stream)
-    : VDB::Writer(stream)
+    Writer2(FILE *const stream, Protocol const protocol = defaultProtocol)
+    : VDB::Writer(stream, protocol)
     , nextTable(0)
     , nextColumn(0)
     {
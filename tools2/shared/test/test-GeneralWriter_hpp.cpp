@@ -1,9 +1,10 @@
 #include "../include/writer.hpp"
 #include <cstdio>
 #include <iostream>
+#include <vector>
 
 void test(FILE *const output) {
-    auto writer = Writer2(output);
+    auto writer = Writer2(output, Writer2::rowsProtocol);
 
     writer.destination("dummy.file.vdb");
     writer.schema("dummy.schema.text", "dummy:db");
@@ -49,7 +50,29 @@ void test(FILE *const output) {
         readStart.setValue(2, rs);
         readLength.setValue(2, rl);
         table.closeRow();
-        writer.progressMessage(i * 10);
+        writer.progressMessage(i * 5);
+    }
+    {
+        /* the same rows again, ten at a time */
+        std::string names, sequences;
+        std::vector<uint32_t> nameLengths, sequenceLengths, pairs(10, 2);
+        std::vector<int32_t> rs, rl;
+
+        for (auto i = 11; i <= 20; ++i) {
+            auto const spot = std::string("SPOT_") + std::to_string(i);
+            names += spot;
+            nameLengths.push_back(uint32_t(spot.size()));
+            sequences += std::string(50, 'N');
+            sequenceLengths.push_back(50);
+            rs.push_back(0); rs.push_back(25);
+            rl.push_back(25); rl.push_back(25);
+        }
+        name.setValues(10, nameLengths.data(), names.data());
+        sequence.setValues(10, sequenceLengths.data(), sequences.data());
+        readStart.setValues(10, pairs.data(), rs.data());
+        readLength.setValues(10, pairs.data(), rl.data());
+        table.closeRows(10);
+        writer.progressMessage(100);
     }
 
     writer.logMessage("Done");